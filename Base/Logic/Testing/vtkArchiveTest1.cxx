@@ -21,6 +21,9 @@
 
 
 // STD includes
+#include <fstream>
+#include <iterator>
+#include <sstream>
 
 #include "vtkMRMLCoreTestingMacros.h"
 
@@ -102,6 +105,17 @@ int vtkArchiveTest1(int argc, char * argv[] )
   vtksys::SystemTools::ChangeDirectory("..");
 
 
+  //
+  // Add an already compressed file, it is expected to be stored as is
+  //
+  std::string compressedContent = "NRRD0004\ntype: short\ndimension: 1\n"
+                                  "sizes: 4\nencoding: gzip\n\n";
+  compressedContent += std::string("\x1f\x8b\x08\x00\x00\x00\x00\x00", 8);
+    {
+    std::ofstream compressedFile("archiveTest/compressed.nrrd", std::ios::out | std::ios::binary);
+    compressedFile << compressedContent;
+    }
+
   //
   // Create a new zip file of the archive
   //
@@ -127,6 +141,77 @@ int vtkArchiveTest1(int argc, char * argv[] )
     return EXIT_FAILURE;
     }
 
+  //
+  // Files are stored, they can be memory mapped directly from the zip file
+  //
+  vtkArchiveMappedMember mappedMember;
+  if (!map_stored_zip_member(zipFilePath.c_str(), "archiveTest/compressed.nrrd", &mappedMember))
+    {
+    std::cerr << "failed to map stored member of archive" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string mappedContent(mappedMember.Data, static_cast<size_t>(mappedMember.Size));
+  unmap_zip_member(&mappedMember);
+  if (mappedContent != compressedContent || mappedMember.Data != 0)
+    {
+    std::cerr << "unexpected content of mapped member" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (map_stored_zip_member(zipFilePath.c_str(), "archiveTest/invalid.nrrd", &mappedMember))
+    {
+    std::cerr << "mapped a member that is not in the archive" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Members can be read without extracting the archive
+  //
+  std::string volContent;
+    {
+    std::ifstream volFile("archiveTest/vol.mrml", std::ios::in | std::ios::binary);
+    volContent.assign(std::istreambuf_iterator<char>(volFile), std::istreambuf_iterator<char>());
+    }
+  std::ostringstream memberStream;
+  if (!unzip_member(zipFilePath.c_str(), "archiveTest/vol.mrml", memberStream)
+    || memberStream.str() != volContent)
+    {
+    std::cerr << "unexpected content of unzipped member" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::ostringstream invalidMemberStream;
+  if (unzip_member(zipFilePath.c_str(), "archiveTest/invalid.nrrd", invalidMemberStream))
+    {
+    std::cerr << "unzipped a member that is not in the archive" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Compressed zip file, already compressed files are still stored
+  //
+  std::string compressedZipFilePath = vtksys::SystemTools::GetCurrentWorkingDirectory() +
+                                                    std::string("/archiveTestCompressed.zip");
+  if (!zip(compressedZipFilePath.c_str(), zipDirPath.c_str(), true))
+    {
+    std::cerr << "failed to create new compressed archive" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkTypeInt64 memberOffset = 0;
+  vtkTypeInt64 memberSize = 0;
+  if (!find_stored_zip_member(compressedZipFilePath.c_str(), "archiveTest/compressed.nrrd",
+                              memberOffset, memberSize)
+    || memberSize != static_cast<vtkTypeInt64>(compressedContent.size()))
+    {
+    std::cerr << "already compressed file was not stored in the compressed archive" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::ostringstream compressedMemberStream;
+  if (!unzip_member(compressedZipFilePath.c_str(), "archiveTest/vol.mrml", compressedMemberStream)
+    || compressedMemberStream.str() != volContent)
+    {
+    std::cerr << "unexpected content of unzipped member of the compressed archive" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   // make fresh output directory
   std::cout << "creating extractedArchiveTest" << std::endl;
   if ( vtksys::SystemTools::FileExists("extractedArchiveTest") )
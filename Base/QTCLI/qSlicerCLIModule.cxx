@@ -106,6 +106,10 @@ vtkMRMLAbstractLogic* qSlicerCLIModule::createLogic()
     {
     logic->SetAllowInMemoryTransfer(0);
     }
+  if (d->Desc.GetParameterValue("AllowMemoryMappedTransfer") == "true")
+    {
+    logic->SetAllowMemoryMappedTransfer(1);
+    }
 
   return logic;
 }
@@ -38,6 +38,7 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
+#include <vtksys/Directory.hxx>
 #include <vtksys/SystemTools.hxx>
 
 // ITKSYS includes
@@ -78,6 +79,12 @@ struct DigitsToCharacters
     }
 };
 
+//----------------------------------------------------------------------------
+// Extension of the files read and written by itk::MemoryMappedImageIO, which is
+// registered in all executables built with the Slicer execution model
+// (see itkFactoryRegistration).
+static const char* MemoryMappedImageFileExtension = ".mmi";
+
 typedef std::pair<vtkSlicerCLIModuleLogic *, vtkMRMLCommandLineModuleNode *> LogicNodePair;
 class MRMLIDMap : public std::map<std::string, std::string> {};
 
@@ -198,6 +205,7 @@ public:
   ModuleDescription DefaultModuleDescription;
   int DeleteTemporaryFiles;
   int AllowInMemoryTransfer;
+  int AllowMemoryMappedTransfer;
 
   int RedirectModuleStreams;
 
@@ -281,6 +289,73 @@ public:
       }
   }
 
+  /// Return the directory where memory-mapped images are placed.
+  /// Shared memory is used if it is available, otherwise the files
+  /// are placed in \a temporaryDirectory.
+  std::string GetMemoryMappedImageDirectory(const std::string& temporaryDirectory)
+  {
+#ifdef __linux__
+    if (vtksys::SystemTools::FileIsDirectory("/dev/shm"))
+      {
+      if (!this->StaleMemoryMappedImagesRemoved)
+        {
+        this->RemoveStaleMemoryMappedImages("/dev/shm");
+        this->StaleMemoryMappedImagesRemoved = true;
+        }
+      return "/dev/shm";
+      }
+#endif
+    return temporaryDirectory;
+  }
+
+  /// Remove the memory-mapped images left in \a directory by Slicer
+  /// processes that are not running anymore (e.g. after a crash), as
+  /// shared memory is not freed until the files are removed.
+  /// File names start with the encoded id of the process that wrote them
+  /// (see ConstructTemporaryFileName()).
+  void RemoveStaleMemoryMappedImages(const std::string& directory)
+  {
+#ifdef __linux__
+    vtksys::Directory dir;
+    if (!dir.Load(directory.c_str()))
+      {
+      return;
+      }
+    for (unsigned long fileIndex = 0; fileIndex < dir.GetNumberOfFiles(); ++fileIndex)
+      {
+      std::string fileName = dir.GetFile(fileIndex);
+      if (vtksys::SystemTools::GetFilenameLastExtension(fileName) != MemoryMappedImageFileExtension)
+        {
+        continue;
+        }
+      std::string::size_type separator = fileName.find('_');
+      if (separator == std::string::npos || separator == 0)
+        {
+        continue;
+        }
+      std::string pid = fileName.substr(0, separator);
+      bool encodedPid = true;
+      for (std::string::iterator it = pid.begin(); it != pid.end(); ++it)
+        {
+        encodedPid = encodedPid && *it >= 'A' && *it <= 'J';
+        *it = *it - 17;
+        }
+      if (!encodedPid
+        || vtksys::SystemTools::FileIsDirectory(std::string("/proc/") + pid))
+        {
+        // not written by Slicer or the process is still running
+        continue;
+        }
+      vtksys::SystemTools::RemoveFile(directory + "/" + fileName);
+      }
+#else
+    (void)directory;
+#endif
+  }
+
+  /// Set once RemoveStaleMemoryMappedImages() has been called
+  bool StaleMemoryMappedImagesRemoved;
+
   /// List of read data/scene requests of the CLI nodes
   /// being executed with their.
   RequestType LastRequests;
@@ -300,6 +375,8 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
   this->Internal->ProcessesKillLock = itk::MutexLock::New();
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->AllowInMemoryTransfer = 1;
+  this->Internal->AllowMemoryMappedTransfer = 0;
+  this->Internal->StaleMemoryMappedImagesRemoved = false;
   this->Internal->RedirectModuleStreams = 1;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
@@ -403,6 +480,22 @@ int vtkSlicerCLIModuleLogic::GetAllowInMemoryTransfer() const
   return this->Internal->AllowInMemoryTransfer;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetAllowMemoryMappedTransfer(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting AllowMemoryMappedTransfer to " << value);
+  if (this->Internal->AllowMemoryMappedTransfer != value)
+    {
+    this->Internal->AllowMemoryMappedTransfer = value;
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetAllowMemoryMappedTransfer() const
+{
+  return this->Internal->AllowMemoryMappedTransfer;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerCLIModuleLogic::RedirectModuleStreamsOn()
 {
@@ -564,6 +657,13 @@ vtkSlicerCLIModuleLogic
         {
         ext = extensions[0];
         }
+      if (ext == MemoryMappedImageFileExtension)
+        {
+        // Memory-mapped images are placed in shared memory if possible
+        // to avoid writing them to disk
+        fname = this->Internal->GetMemoryMappedImageDirectory(temporaryDirectory)
+          + "/" + vtksys::SystemTools::GetFilenameName(fname);
+        }
       fname = fname + ext;
       }
     else
@@ -923,6 +1023,22 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     = node0->GetModuleDescription().GetParameterGroups().end();
   std::vector<ModuleParameterGroup>::iterator pgit;
 
+  // Executables that read their images with the ITK factories registered
+  // by itkFactoryRegistration() can exchange images through memory-mapped
+  // files (see itk::MemoryMappedImageIO) instead of NRRD files. Modules
+  // must opt in, as executables may use other readers or be built against
+  // an older ITKFactoryRegistration. Modules that are run by an interpreter
+  // (Location is different from Target) are always given regular files.
+  bool memoryMappedTransferPossible = (commandType == CommandLineModule
+    && this->GetAllowInMemoryTransfer() != 0
+    && this->GetAllowMemoryMappedTransfer() != 0
+    && (node0->GetModuleDescription().GetLocation().empty()
+      || node0->GetModuleDescription().GetLocation() == node0->GetModuleDescription().GetTarget()));
+  std::set<std::string> MemoryMappedTransferPossible;
+  MemoryMappedTransferPossible.insert("vtkMRMLScalarVolumeNode");
+  MemoryMappedTransferPossible.insert("vtkMRMLLabelMapVolumeNode");
+  MemoryMappedTransferPossible.insert("vtkMRMLVectorVolumeNode");
+
   // Make a pass over the parameters and establish which parameters
   // have images or geometry or transforms or tables or point files that need to be written
   // before execution or loaded upon completion.
@@ -953,16 +1069,27 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
           }
 
         // only keep track of objects associated with real nodes
-        if (!this->GetMRMLScene()->GetNodeByID(id.c_str()) || id == "None")
+        vtkMRMLNode* parameterNode = this->GetMRMLScene()->GetNodeByID(id.c_str());
+        if (!parameterNode || id == "None")
           {
           continue;
           }
 
+        // Images are passed in memory-mapped files if the module
+        // does not require a specific file format
+        std::vector<std::string> fileExtensions = (*pit).GetFileExtensions();
+        if (memoryMappedTransferPossible && (*pit).GetTag() == "image"
+          && (*pit).GetType() != "dynamic-contrast-enhanced" && fileExtensions.empty()
+          && MemoryMappedTransferPossible.find(parameterNode->GetClassName()) != MemoryMappedTransferPossible.end())
+          {
+          fileExtensions.push_back(MemoryMappedImageFileExtension);
+          }
+
         std::string fname
           = this->ConstructTemporaryFileName((*pit).GetTag(),
                                              (*pit).GetType(),
                                              id,
-                                             (*pit).GetFileExtensions(),
+                                             fileExtensions,
                                              commandType);
 
         filesToDelete.insert(fname);
@@ -77,9 +77,17 @@ public:
   int GetDeleteTemporaryFiles() const;
 
   // Control use of in-memory data transfer by this specific CLI.
+  // Shared object modules access the MRML scene directly.
   void SetAllowInMemoryTransfer(int value);
   int GetAllowInMemoryTransfer() const;
 
+  // Control whether this specific executable CLI exchanges its images
+  // through memory-mapped files (see itk::MemoryMappedImageIO) when
+  // in-memory transfer is allowed. Off by default, the executable must
+  // read and write images with the ITK factories of itkFactoryRegistration().
+  void SetAllowMemoryMappedTransfer(int value);
+  int GetAllowMemoryMappedTransfer() const;
+
   /// For debugging, control redirection of cout and cerr
   virtual void RedirectModuleStreamsOn();
   virtual void RedirectModuleStreamsOff();
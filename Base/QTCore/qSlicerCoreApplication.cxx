@@ -97,6 +97,9 @@
 #endif
 #include <vtkMRMLScene.h>
 
+// vtkITK includes
+#include <vtkITKArchetypeImageSeriesReader.h>
+
 // CTKLauncherLib includes
 #include <ctkAppLauncherEnvironment.h>
 #include <ctkAppLauncherSettings.h>
@@ -427,6 +430,11 @@ void qSlicerCoreApplicationPrivate::initDataIO()
     QFileInfo(q->temporaryPath(), "RemoteIO").
     absoluteFilePath().toLatin1());
 
+  // Parsed DICOM headers are kept so that reloading a series does not require
+  // parsing all the headers again.
+  vtkITKArchetypeImageSeriesReader::SetHeaderIndexCacheDirectory(
+    QFileInfo(q->temporaryPath(), "HeaderIndex").absoluteFilePath().toStdString());
+
   this->DataIOManagerLogic = vtkSmartPointer<vtkDataIOManagerLogic>::New();
   this->DataIOManagerLogic->SetMRMLApplicationLogic(this->AppLogic);
   this->DataIOManagerLogic->SetAndObserveDataIOManager(
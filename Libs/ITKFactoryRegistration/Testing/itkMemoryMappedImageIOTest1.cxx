@@ -0,0 +1,163 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// ITKFactoryRegistration includes
+#include "itkFactoryRegistration.h"
+#include "itkMemoryMappedImageIO.h"
+
+// ITK includes
+#include <itkImage.h>
+#include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+#include <itkImageIOFactory.h>
+#include <itkVectorImage.h>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+template <class TImage>
+typename TImage::Pointer CreateImage(unsigned int numberOfComponents)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::SizeType size;
+  size[0] = 17;
+  size[1] = 9;
+  size[2] = 5;
+  typename TImage::RegionType region(size);
+  image->SetRegions(region);
+  image->SetNumberOfComponentsPerPixel(numberOfComponents);
+  image->Allocate();
+
+  typename TImage::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.25;
+  spacing[2] = 3.0;
+  image->SetSpacing(spacing);
+  typename TImage::PointType origin;
+  origin[0] = -10.0;
+  origin[1] = 20.5;
+  origin[2] = 3.0;
+  image->SetOrigin(origin);
+  typename TImage::DirectionType direction;
+  direction.Fill(0.0);
+  direction[0][1] = 1.0;
+  direction[1][0] = -1.0;
+  direction[2][2] = 1.0;
+  image->SetDirection(direction);
+
+  typename TImage::InternalPixelType* buffer = image->GetBufferPointer();
+  size_t numberOfValues = region.GetNumberOfPixels() * numberOfComponents;
+  for (size_t i = 0; i < numberOfValues; ++i)
+    {
+    buffer[i] = static_cast<typename TImage::InternalPixelType>(i % 251) - 100;
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+template <class TImage>
+bool TestRoundTrip(const std::string& fileName, unsigned int numberOfComponents)
+{
+  typename TImage::Pointer image = CreateImage<TImage>(numberOfComponents);
+
+  typedef itk::ImageFileWriter<TImage> WriterType;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName(fileName);
+  writer->SetInput(image);
+  typedef itk::ImageFileReader<TImage> ReaderType;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  try
+    {
+    writer->Update();
+    reader->Update();
+    }
+  catch (itk::ExceptionObject& exception)
+    {
+    std::cerr << "Failed to write or read " << fileName << ": " << exception << std::endl;
+    return false;
+    }
+
+  if (dynamic_cast<itk::MemoryMappedImageIO*>(reader->GetImageIO()) == ITK_NULLPTR)
+    {
+    std::cerr << fileName << " was not read by MemoryMappedImageIO" << std::endl;
+    return false;
+    }
+
+  TImage* output = reader->GetOutput();
+  if (output->GetLargestPossibleRegion() != image->GetLargestPossibleRegion()
+    || output->GetNumberOfComponentsPerPixel() != numberOfComponents
+    || output->GetSpacing() != image->GetSpacing()
+    || output->GetOrigin() != image->GetOrigin()
+    || output->GetDirection() != image->GetDirection())
+    {
+    std::cerr << "Geometry read from " << fileName << " is different from the written image" << std::endl;
+    return false;
+    }
+  size_t numberOfValues = image->GetLargestPossibleRegion().GetNumberOfPixels() * numberOfComponents;
+  if (!std::equal(image->GetBufferPointer(), image->GetBufferPointer() + numberOfValues,
+                  output->GetBufferPointer()))
+    {
+    std::cerr << "Pixels read from " << fileName << " are different from the written image" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int itkMemoryMappedImageIOTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  itk::itkFactoryRegistration();
+
+  std::string fileName = tempDir + "/itkMemoryMappedImageIOTest1.mmi";
+  itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO(
+    fileName.c_str(), itk::ImageIOFactory::WriteMode);
+  if (dynamic_cast<itk::MemoryMappedImageIO*>(imageIO.GetPointer()) == ITK_NULLPTR)
+    {
+    std::cerr << "MemoryMappedImageIO is not registered for " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!TestRoundTrip<itk::Image<short, 3> >(fileName, 1)
+    || !TestRoundTrip<itk::Image<double, 3> >(fileName, 1)
+    || !TestRoundTrip<itk::VectorImage<float, 3> >(fileName, 3))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // other files must be left to the other image IOs
+  itk::MemoryMappedImageIO::Pointer memoryMappedImageIO = itk::MemoryMappedImageIO::New();
+  if (memoryMappedImageIO->CanWriteFile((tempDir + "/itkMemoryMappedImageIOTest1.nrrd").c_str())
+    || memoryMappedImageIO->CanReadFile((tempDir + "/itkMemoryMappedImageIOTest1.nrrd").c_str()))
+    {
+    std::cerr << "MemoryMappedImageIO must only handle .mmi files" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itksys::SystemTools::RemoveFile(fileName.c_str());
+  std::cout << "MemoryMappedImageIO test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
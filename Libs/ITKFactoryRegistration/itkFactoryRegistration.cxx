@@ -1,5 +1,6 @@
 
 #include "itkFactoryRegistration.h"
+#include "itkMemoryMappedImageIOFactory.h"
 
 // ITK includes
 #include <itkImageFileReader.h>
@@ -8,7 +9,13 @@
 // The following code is required to ensure that the
 // mechanism allowing the ITK factory to be registered is not
 // optimized out by the compiler.
+// Factories that are not part of ITK are registered explicitly.
 void itk::itkFactoryRegistration(void)
 {
-  return;
+  static bool slicerFactoriesRegistered = false;
+  if (!slicerFactoriesRegistered)
+    {
+    itk::MemoryMappedImageIOFactory::RegisterOneFactory();
+    slicerFactoriesRegistered = true;
+    }
 }
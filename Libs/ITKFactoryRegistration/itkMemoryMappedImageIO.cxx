@@ -0,0 +1,361 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "itkMemoryMappedImageIO.h"
+
+// ITK includes
+#include <itkIntTypes.h>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+
+const char MemoryMappedImageMagic[8] = { 'S', 'L', 'I', 'C', 'E', 'R', 'M', 'M' };
+const itk::uint32_t MemoryMappedImageVersion = 1;
+const unsigned int MemoryMappedImageMaximumDimension = 4;
+
+/// Pixel data starts at a page boundary
+const itk::uint64_t MemoryMappedImageDataOffset = 4096;
+
+//----------------------------------------------------------------------------
+/// Header stored at the beginning of the file.
+/// Component and pixel types are the itk::ImageIOBase enum values.
+struct MemoryMappedImageHeader
+{
+  char Magic[8];
+  itk::uint32_t Version;
+  itk::uint32_t NumberOfDimensions;
+  itk::uint32_t ComponentType;
+  itk::uint32_t PixelType;
+  itk::uint32_t NumberOfComponents;
+  itk::uint32_t Reserved;
+  itk::uint64_t Dimensions[MemoryMappedImageMaximumDimension];
+  double Spacing[MemoryMappedImageMaximumDimension];
+  double Origin[MemoryMappedImageMaximumDimension];
+  /// Direction of axis i is stored in Direction[i * MemoryMappedImageMaximumDimension + ...]
+  double Direction[MemoryMappedImageMaximumDimension * MemoryMappedImageMaximumDimension];
+};
+
+//----------------------------------------------------------------------------
+bool ReadHeader(const std::string& fileName, MemoryMappedImageHeader& header)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+    return false;
+    }
+  return memcmp(header.Magic, MemoryMappedImageMagic, sizeof(MemoryMappedImageMagic)) == 0
+    && header.Version == MemoryMappedImageVersion
+    && header.NumberOfDimensions >= 1
+    && header.NumberOfDimensions <= MemoryMappedImageMaximumDimension;
+}
+
+//----------------------------------------------------------------------------
+bool HasMemoryMappedImageExtension(const char* fileName)
+{
+  if (fileName == ITK_NULLPTR)
+    {
+    return false;
+    }
+  std::string extension = itksys::SystemTools::LowerCase(
+    itksys::SystemTools::GetFilenameLastExtension(fileName));
+  return extension == itk::MemoryMappedImageIO::GetFileExtension();
+}
+
+//----------------------------------------------------------------------------
+/// Mapping of an entire file into the address space of the process
+class MappedFile
+{
+public:
+  MappedFile()
+    : Data(ITK_NULLPTR)
+    , Size(0)
+#ifdef _WIN32
+    , File(INVALID_HANDLE_VALUE)
+    , Mapping(ITK_NULLPTR)
+#endif
+  {
+  }
+  ~MappedFile()
+  {
+    this->Close();
+  }
+
+  /// Map an existing file for reading
+  bool OpenForReading(const std::string& fileName)
+  {
+    this->Close();
+#ifdef _WIN32
+    this->File = CreateFileA(fileName.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, ITK_NULLPTR,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, ITK_NULLPTR);
+    LARGE_INTEGER fileSize;
+    if (this->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->File, &fileSize) || fileSize.QuadPart <= 0)
+      {
+      this->Close();
+      return false;
+      }
+    this->Mapping = CreateFileMappingA(this->File, ITK_NULLPTR, PAGE_READONLY, 0, 0, ITK_NULLPTR);
+    if (this->Mapping)
+      {
+      this->Data = static_cast<char*>(MapViewOfFile(this->Mapping, FILE_MAP_READ, 0, 0, 0));
+      }
+    this->Size = static_cast<itk::uint64_t>(fileSize.QuadPart);
+#else
+    int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+      {
+      return false;
+      }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+      {
+      void* data = mmap(ITK_NULLPTR, fileStatus.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+      if (data != MAP_FAILED)
+        {
+        this->Data = static_cast<char*>(data);
+        this->Size = static_cast<itk::uint64_t>(fileStatus.st_size);
+        }
+      }
+    // the mapping remains valid after the file is closed
+    close(fileDescriptor);
+#endif
+    if (this->Data == ITK_NULLPTR)
+      {
+      this->Close();
+      return false;
+      }
+    return true;
+  }
+
+  /// Create a file of the requested size (replacing existing file) and map it for writing
+  bool OpenForWriting(const std::string& fileName, itk::uint64_t size)
+  {
+    this->Close();
+#ifdef _WIN32
+    // Temporary attribute keeps the content in the file system cache if possible
+    this->File = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, ITK_NULLPTR,
+      CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, ITK_NULLPTR);
+    if (this->File == INVALID_HANDLE_VALUE)
+      {
+      return false;
+      }
+    // Creating the mapping extends the file to the requested size
+    this->Mapping = CreateFileMappingA(this->File, ITK_NULLPTR, PAGE_READWRITE,
+      static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), ITK_NULLPTR);
+    if (this->Mapping)
+      {
+      this->Data = static_cast<char*>(MapViewOfFile(this->Mapping, FILE_MAP_WRITE, 0, 0, 0));
+      }
+#else
+    int fileDescriptor = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fileDescriptor < 0)
+      {
+      return false;
+      }
+    if (ftruncate(fileDescriptor, static_cast<off_t>(size)) == 0)
+      {
+      void* data = mmap(ITK_NULLPTR, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+      if (data != MAP_FAILED)
+        {
+        this->Data = static_cast<char*>(data);
+        }
+      }
+    close(fileDescriptor);
+#endif
+    if (this->Data == ITK_NULLPTR)
+      {
+      this->Close();
+      return false;
+      }
+    this->Size = size;
+    return true;
+  }
+
+  void Close()
+  {
+#ifdef _WIN32
+    if (this->Data)
+      {
+      UnmapViewOfFile(this->Data);
+      }
+    if (this->Mapping)
+      {
+      CloseHandle(this->Mapping);
+      this->Mapping = ITK_NULLPTR;
+      }
+    if (this->File != INVALID_HANDLE_VALUE)
+      {
+      CloseHandle(this->File);
+      this->File = INVALID_HANDLE_VALUE;
+      }
+#else
+    if (this->Data)
+      {
+      munmap(this->Data, this->Size);
+      }
+#endif
+    this->Data = ITK_NULLPTR;
+    this->Size = 0;
+  }
+
+  char* GetData() const { return this->Data; }
+  itk::uint64_t GetSize() const { return this->Size; }
+
+private:
+  MappedFile(const MappedFile&); //purposely not implemented
+  void operator=(const MappedFile&); //purposely not implemented
+
+  char* Data;
+  itk::uint64_t Size;
+#ifdef _WIN32
+  HANDLE File;
+  HANDLE Mapping;
+#endif
+};
+
+} // end of anonymous namespace
+
+namespace itk
+{
+
+//----------------------------------------------------------------------------
+MemoryMappedImageIO::MemoryMappedImageIO()
+{
+  this->SetNumberOfDimensions(3);
+  this->AddSupportedReadExtension(GetFileExtension());
+  this->AddSupportedWriteExtension(GetFileExtension());
+}
+
+//----------------------------------------------------------------------------
+MemoryMappedImageIO::~MemoryMappedImageIO()
+{
+}
+
+//----------------------------------------------------------------------------
+void MemoryMappedImageIO::PrintSelf(std::ostream& os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+}
+
+//----------------------------------------------------------------------------
+bool MemoryMappedImageIO::CanReadFile(const char* fileName)
+{
+  if (!HasMemoryMappedImageExtension(fileName))
+    {
+    return false;
+    }
+  MemoryMappedImageHeader header;
+  return ReadHeader(fileName, header);
+}
+
+//----------------------------------------------------------------------------
+void MemoryMappedImageIO::ReadImageInformation()
+{
+  MemoryMappedImageHeader header;
+  if (!ReadHeader(m_FileName, header))
+    {
+    itkExceptionMacro("ReadImageInformation: " << m_FileName << " is not a valid memory-mapped image file");
+    }
+
+  this->SetNumberOfDimensions(header.NumberOfDimensions);
+  for (unsigned int axis = 0; axis < header.NumberOfDimensions; ++axis)
+    {
+    m_Dimensions[axis] = static_cast<SizeValueType>(header.Dimensions[axis]);
+    m_Spacing[axis] = header.Spacing[axis];
+    m_Origin[axis] = header.Origin[axis];
+    std::vector<double> direction(header.NumberOfDimensions);
+    for (unsigned int component = 0; component < header.NumberOfDimensions; ++component)
+      {
+      direction[component] = header.Direction[axis * MemoryMappedImageMaximumDimension + component];
+      }
+    this->SetDirection(axis, direction);
+    }
+  this->SetComponentType(static_cast<IOComponentType>(header.ComponentType));
+  this->SetPixelType(static_cast<IOPixelType>(header.PixelType));
+  this->SetNumberOfComponents(header.NumberOfComponents);
+}
+
+//----------------------------------------------------------------------------
+void MemoryMappedImageIO::Read(void* buffer)
+{
+  MappedFile file;
+  if (!file.OpenForReading(m_FileName))
+    {
+    itkExceptionMacro("Read: failed to map file " << m_FileName);
+    }
+  const uint64_t dataSize = static_cast<uint64_t>(this->GetImageSizeInBytes());
+  if (file.GetSize() < MemoryMappedImageDataOffset + dataSize)
+    {
+    itkExceptionMacro("Read: file " << m_FileName << " is truncated, expected "
+      << MemoryMappedImageDataOffset + dataSize << " bytes, found " << file.GetSize());
+    }
+  memcpy(buffer, file.GetData() + MemoryMappedImageDataOffset, dataSize);
+}
+
+//----------------------------------------------------------------------------
+bool MemoryMappedImageIO::CanWriteFile(const char* fileName)
+{
+  return HasMemoryMappedImageExtension(fileName);
+}
+
+//----------------------------------------------------------------------------
+void MemoryMappedImageIO::Write(const void* buffer)
+{
+  const unsigned int numberOfDimensions = this->GetNumberOfDimensions();
+  if (numberOfDimensions < 1 || numberOfDimensions > MemoryMappedImageMaximumDimension)
+    {
+    itkExceptionMacro("Write: images with " << numberOfDimensions << " dimensions are not supported");
+    }
+
+  MemoryMappedImageHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.Magic, MemoryMappedImageMagic, sizeof(MemoryMappedImageMagic));
+  header.Version = MemoryMappedImageVersion;
+  header.NumberOfDimensions = numberOfDimensions;
+  header.ComponentType = static_cast<uint32_t>(this->GetComponentType());
+  header.PixelType = static_cast<uint32_t>(this->GetPixelType());
+  header.NumberOfComponents = this->GetNumberOfComponents();
+  for (unsigned int axis = 0; axis < numberOfDimensions; ++axis)
+    {
+    header.Dimensions[axis] = m_Dimensions[axis];
+    header.Spacing[axis] = m_Spacing[axis];
+    header.Origin[axis] = m_Origin[axis];
+    std::vector<double> direction = this->GetDirection(axis);
+    for (unsigned int component = 0; component < numberOfDimensions; ++component)
+      {
+      header.Direction[axis * MemoryMappedImageMaximumDimension + component] = direction[component];
+      }
+    }
+
+  const uint64_t dataSize = static_cast<uint64_t>(this->GetImageSizeInBytes());
+  MappedFile file;
+  if (!file.OpenForWriting(m_FileName, MemoryMappedImageDataOffset + dataSize))
+    {
+    itkExceptionMacro("Write: failed to create mapped file " << m_FileName);
+    }
+  memcpy(file.GetData(), &header, sizeof(header));
+  memcpy(file.GetData() + MemoryMappedImageDataOffset, buffer, dataSize);
+}
+
+} // end namespace itk
@@ -0,0 +1,87 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef itkMemoryMappedImageIO_h
+#define itkMemoryMappedImageIO_h
+
+#include "itkFactoryRegistrationConfigure.h"
+
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+/** \class MemoryMappedImageIO
+ * \brief ImageIO object for exchanging images through memory-mapped files.
+ *
+ * MemoryMappedImageIO stores an image as a small fixed-size header
+ * followed by the uncompressed pixel buffer. The file is accessed
+ * through a memory mapping, therefore if it is placed in shared memory
+ * (for example in /dev/shm on Linux) then the image is passed between
+ * processes without any disk access or encoding.
+ *
+ * It is used by Slicer to transfer images to and from command line
+ * module executables. The format is not intended for long-term storage:
+ * the file is only readable on the same platform by an ITK build with the
+ * same pixel component enumeration.
+ *
+ * Files are recognized by the ".mmi" extension.
+ */
+class ITKFactoryRegistration_EXPORT MemoryMappedImageIO : public ImageIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryMappedImageIO Self;
+  typedef ImageIOBase         Superclass;
+  typedef SmartPointer<Self>  Pointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MemoryMappedImageIO, ImageIOBase);
+
+  /** Extension of files handled by this ImageIO. */
+  static const char* GetFileExtension() { return ".mmi"; }
+
+  /** Determine the file type. Returns true if this ImageIO can read the
+   * file specified. */
+  virtual bool CanReadFile(const char*) ITK_OVERRIDE;
+
+  /** Set the spacing and dimension information for the set filename. */
+  virtual void ReadImageInformation() ITK_OVERRIDE;
+
+  /** Copies the data from the mapped file into the memory buffer provided. */
+  virtual void Read(void* buffer) ITK_OVERRIDE;
+
+  /*-------- This part of the interfaces deals with writing data. ----- */
+
+  /** Determine the file type. Returns true if this ImageIO can write the
+   * file specified. */
+  virtual bool CanWriteFile(const char*) ITK_OVERRIDE;
+
+  /** Header is written along with the data in Write(). */
+  virtual void WriteImageInformation() ITK_OVERRIDE {}
+
+  /** Creates the mapped file and copies the memory buffer provided into it.
+   * The entire image must be written at once. */
+  virtual void Write(const void* buffer) ITK_OVERRIDE;
+
+protected:
+  MemoryMappedImageIO();
+  ~MemoryMappedImageIO();
+  void PrintSelf(std::ostream& os, Indent indent) const ITK_OVERRIDE;
+
+private:
+  MemoryMappedImageIO(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+} // end namespace itk
+
+#endif
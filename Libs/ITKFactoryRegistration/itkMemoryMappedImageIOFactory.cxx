@@ -0,0 +1,41 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "itkMemoryMappedImageIOFactory.h"
+#include "itkMemoryMappedImageIO.h"
+#include "itkVersion.h"
+
+namespace itk
+{
+MemoryMappedImageIOFactory::MemoryMappedImageIOFactory()
+{
+  this->RegisterOverride("itkImageIOBase",
+                         "itkMemoryMappedImageIO",
+                         "ImageIO to exchange images through memory-mapped files.",
+                         1,
+                         CreateObjectFunction<MemoryMappedImageIO>::New());
+}
+
+MemoryMappedImageIOFactory::~MemoryMappedImageIOFactory()
+{
+}
+
+const char*
+MemoryMappedImageIOFactory::GetITKSourceVersion(void) const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char*
+MemoryMappedImageIOFactory::GetDescription() const
+{
+  return "ImageIOFactory that imports/exports data through memory-mapped files.";
+}
+
+} // end namespace itk
@@ -0,0 +1,61 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef itkMemoryMappedImageIOFactory_h
+#define itkMemoryMappedImageIOFactory_h
+
+#include "itkFactoryRegistrationConfigure.h"
+
+#include "itkObjectFactoryBase.h"
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+/** \class MemoryMappedImageIOFactory
+ * \brief Create instances of MemoryMappedImageIO objects using an object factory.
+ */
+class ITKFactoryRegistration_EXPORT MemoryMappedImageIOFactory : public ObjectFactoryBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryMappedImageIOFactory Self;
+  typedef ObjectFactoryBase          Superclass;
+  typedef SmartPointer<Self>         Pointer;
+  typedef SmartPointer<const Self>   ConstPointer;
+
+  /** Class methods used to interface with the registered factories. */
+  virtual const char* GetITKSourceVersion(void) const ITK_OVERRIDE;
+  virtual const char* GetDescription(void) const ITK_OVERRIDE;
+
+  /** Method for class instantiation. */
+  itkFactorylessNewMacro(Self);
+  static MemoryMappedImageIOFactory* FactoryNew() { return new MemoryMappedImageIOFactory;}
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MemoryMappedImageIOFactory, ObjectFactoryBase);
+
+  /** Register one factory of this type  */
+  static void RegisterOneFactory(void)
+  {
+    MemoryMappedImageIOFactory::Pointer factory = MemoryMappedImageIOFactory::New();
+    ObjectFactoryBase::RegisterFactory(factory);
+  }
+
+protected:
+  MemoryMappedImageIOFactory();
+  ~MemoryMappedImageIOFactory();
+
+private:
+  MemoryMappedImageIOFactory(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,143 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CountCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                   void* clientData, void* vtkNotUsed(callData))
+{
+  int* count = reinterpret_cast<int*>(clientData);
+  ++(*count);
+}
+
+//----------------------------------------------------------------------------
+int TestCoalescing(vtkEventBroker* broker)
+{
+  vtkNew<vtkObject> subject;
+  vtkNew<vtkObject> observer;
+  int count = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountCallback);
+  callback->SetClientData(&count);
+
+  // same callback observing the same event twice
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+
+  // without coalescing, each observation is invoked once
+  broker->SetEventModeToAsynchronous();
+  subject->Modified();
+  subject->Modified();
+  subject->Modified();
+  CHECK_INT(count, 0);
+  broker->ProcessEventQueue();
+  CHECK_INT(count, 2);
+  CHECK_INT(broker->GetNumberOfCoalescedEvents(), 0);
+
+  // with coalescing, the callback is invoked once
+  count = 0;
+  broker->CoalesceEventsOn();
+  subject->Modified();
+  subject->Modified();
+  subject->Modified();
+  broker->ProcessEventQueue();
+  CHECK_INT(count, 1);
+  CHECK_INT(broker->GetNumberOfCoalescedEvents(), 5);
+
+  // events are queued again once processed
+  count = 0;
+  subject->Modified();
+  broker->ProcessEventQueue();
+  CHECK_INT(count, 1);
+
+  // events with call data are never coalesced
+  count = 0;
+  int callData = 0;
+  subject->InvokeEvent(vtkCommand::ModifiedEvent, &callData);
+  broker->ProcessEventQueue();
+  CHECK_INT(count, 2);
+
+  // removed observations do not swallow events
+  count = 0;
+  subject->Modified();
+  broker->RemoveObservation(broker->GetNthQueuedObservation(0));
+  subject->Modified();
+  broker->ProcessEventQueue();
+  CHECK_INT(count, 1);
+
+  broker->CoalesceEventsOff();
+  broker->SetEventModeToSynchronous();
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestEventStatistics(vtkEventBroker* broker)
+{
+  vtkNew<vtkObject> subject;
+  vtkNew<vtkObject> observer;
+  int count = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountCallback);
+  callback->SetClientData(&count);
+  vtkObservation* observation = broker->AddObservation(subject.GetPointer(),
+    vtkCommand::ModifiedEvent, observer.GetPointer(), callback.GetPointer());
+
+  broker->ResetEventStatistics();
+  CHECK_INT(observation->GetInvocationCount(), 0);
+  subject->Modified();
+  subject->Modified();
+  CHECK_INT(count, 2);
+  CHECK_INT(observation->GetInvocationCount(), 2);
+  CHECK_BOOL(observation->GetMaxElapsedTime() <= observation->GetTotalElapsedTime(), true);
+
+  std::string report = broker->GetEventStatisticsReport();
+  std::cout << report << std::endl;
+  CHECK_BOOL(report.find("vtkObject") != std::string::npos, true);
+  CHECK_BOOL(report.find("[ModifiedEvent]") != std::string::npos, true);
+
+  broker->ResetEventStatistics();
+  CHECK_INT(observation->GetInvocationCount(), 0);
+  CHECK_BOOL(observation->GetTotalElapsedTime() == 0.0, true);
+  report = broker->GetEventStatisticsReport();
+  CHECK_BOOL(report.find("[ModifiedEvent]") == std::string::npos, true);
+
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerTest1(int , char * [] )
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  CHECK_EXIT_SUCCESS(TestCoalescing(broker));
+  CHECK_EXIT_SUCCESS(TestEventStatistics(broker));
+  return EXIT_SUCCESS;
+}
@@ -15,17 +15,59 @@
 #include "vtkMRMLModelNode.h"
 #include "vtkMRMLScene.h"
 
+#include <vtkCallbackCommand.h>
 #include <vtkCylinderSource.h>
 #include <vtkGeometryFilter.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkTriangleFilter.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkVoxel.h>
 
+// vtkAddon includes
+#include <vtkTestingOutputWindow.h>
+
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <sstream>
+
 //---------------------------------------------------------------------------
 int TestReadWriteData(vtkMRMLScene* scene, const char* extension, vtkPointSet*mesh);
+int TestImportReadDataDetached(const char* tempDir, vtkPointSet* mesh);
+int TestReadDataDetachedError(const char* tempDir);
 void CreateVoxelMeshes(vtkUnstructuredGrid* ug, vtkPolyData* poly);
 
+namespace
+{
+
+//---------------------------------------------------------------------------
+struct ImportProgress
+{
+  ImportProgress() : NumberOfEvents(0), NumberOfReadFiles(0), CalledFromOtherThread(false) {}
+  int NumberOfEvents;
+  int NumberOfReadFiles;
+  bool CalledFromOtherThread;
+  vtkMultiThreaderIDType MainThreadID;
+};
+
+//---------------------------------------------------------------------------
+void ImportProgressCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                            void* clientData, void* callData)
+{
+  ImportProgress* progress = reinterpret_cast<ImportProgress*>(clientData);
+  ++progress->NumberOfEvents;
+  progress->NumberOfReadFiles = static_cast<int>(reinterpret_cast<size_t>(callData));
+  if (!vtkMultiThreader::ThreadsEqual(progress->MainThreadID, vtkMultiThreader::GetCurrentThreadID()))
+    {
+    progress->CalledFromOtherThread = true;
+    }
+}
+
+} // end of anonymous namespace
+
 //---------------------------------------------------------------------------
 int vtkMRMLModelStorageNodeTest1(int argc, char * argv[] )
 {
@@ -52,6 +94,8 @@ int vtkMRMLModelStorageNodeTest1(int argc, char * argv[] )
   CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".stl", poly.GetPointer()));
   CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".ply", poly.GetPointer()));
   CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".obj", poly.GetPointer()));
+  CHECK_EXIT_SUCCESS(TestImportReadDataDetached(tempDir, poly.GetPointer()));
+  CHECK_EXIT_SUCCESS(TestReadDataDetachedError(tempDir));
 
   return EXIT_SUCCESS;
 }
@@ -96,5 +140,100 @@ int TestReadWriteData(vtkMRMLScene* scene, const char *extension, vtkPointSet *m
   CHECK_NOT_NULL(mesh2);
   CHECK_INT(mesh2->GetNumberOfPoints(), numberOfPoints);
 
+  // Test reading from another thread then attaching the data
+  modelNode->SetAndObservePolyData(NULL);
+  CHECK_BOOL(storageNode->CanReadDataDetached(modelNode.GetPointer()), true);
+  CHECK_INT(storageNode->ReadDataDetached(modelNode.GetPointer()), 1);
+  CHECK_BOOL(storageNode->HasDetachedData(), true);
+  CHECK_NULL(modelNode->GetMesh());
+  CHECK_BOOL(storageNode->ReadData(modelNode.GetPointer()), true);
+  CHECK_BOOL(storageNode->HasDetachedData(), false);
+  CHECK_NOT_NULL(modelNode->GetMesh());
+  CHECK_INT(modelNode->GetMesh()->GetNumberOfPoints(), numberOfPoints);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestImportReadDataDetached(const char* tempDir, vtkPointSet* mesh)
+{
+  const int numberOfModels = 6;
+  std::string sceneFileName = std::string(tempDir) + "/vtkMRMLModelStorageNodeTest1.mrml";
+  {
+    vtkNew<vtkMRMLScene> scene;
+    scene->SetRootDirectory(tempDir);
+    scene->SetURL(sceneFileName.c_str());
+    for (int i = 0; i < numberOfModels; ++i)
+      {
+      vtkNew<vtkMRMLModelNode> modelNode;
+      modelNode->SetAndObserveMesh(mesh);
+      scene->AddNode(modelNode.GetPointer());
+      modelNode->AddDefaultStorageNode();
+      std::stringstream fileName;
+      fileName << tempDir << "/vtkMRMLModelStorageNodeTest1_" << i << ".vtp";
+      modelNode->GetStorageNode()->SetFileName(fileName.str().c_str());
+      CHECK_BOOL(modelNode->GetStorageNode()->WriteData(modelNode.GetPointer()), true);
+      }
+    CHECK_BOOL(scene->Commit() != 0, true);
+  }
+
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetMaximumNumberOfReadThreads(4);
+  CHECK_INT(scene->GetMaximumNumberOfReadThreads(), 4);
+  // files read concurrently are reported as import progress
+  ImportProgress progress;
+  progress.MainThreadID = vtkMultiThreader::GetCurrentThreadID();
+  vtkNew<vtkCallbackCommand> progressCallback;
+  progressCallback->SetCallback(ImportProgressCallback);
+  progressCallback->SetClientData(&progress);
+  scene->AddObserver(vtkMRMLScene::StateEvent | vtkMRMLScene::ProgressEvent | vtkMRMLScene::ImportState,
+                     progressCallback.GetPointer());
+  scene->SetURL(sceneFileName.c_str());
+  CHECK_BOOL(scene->Connect() != 0, true);
+  CHECK_BOOL(progress.NumberOfEvents > 0, true);
+  CHECK_INT(progress.NumberOfReadFiles, numberOfModels);
+  CHECK_BOOL(progress.CalledFromOtherThread, false);
+  std::vector<vtkMRMLNode*> modelNodes;
+  scene->GetNodesByClass("vtkMRMLModelNode", modelNodes);
+  CHECK_INT(static_cast<int>(modelNodes.size()), numberOfModels);
+  for (std::vector<vtkMRMLNode*>::iterator it = modelNodes.begin(); it != modelNodes.end(); ++it)
+    {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(*it);
+    CHECK_NOT_NULL(modelNode->GetMesh());
+    CHECK_INT(modelNode->GetMesh()->GetNumberOfPoints(), mesh->GetNumberOfPoints());
+    CHECK_BOOL(modelNode->GetStorageNode()->HasDetachedData(), false);
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestReadDataDetachedError(const char* tempDir)
+{
+  std::string fileName = std::string(tempDir) + "/vtkMRMLModelStorageNodeTest1_invalid.vtk";
+  {
+    std::ofstream file(fileName.c_str());
+    file << "# vtk DataFile Version 3.0\nnot a mesh\nASCII\nDATASET STRUCTURED_POINTS\n";
+  }
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLModelNode> modelNode;
+  scene->AddNode(modelNode.GetPointer());
+  vtkNew<vtkMRMLModelStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(fileName.c_str());
+
+  // the error is kept by the storage node and reported once by ReadData()
+  TESTING_OUTPUT_INIT();
+  TESTING_OUTPUT_RESET();
+  CHECK_BOOL(storageNode->CanReadDataDetached(modelNode.GetPointer()), true);
+  CHECK_INT(storageNode->ReadDataDetached(modelNode.GetPointer()), 0);
+  TESTING_OUTPUT_ASSERT_ERRORS(0);
+  CHECK_BOOL(storageNode->HasDetachedData(), true);
+  CHECK_INT(storageNode->ReadData(modelNode.GetPointer()), 0);
+  TESTING_OUTPUT_ASSERT_ERRORS(1);
+  TESTING_OUTPUT_RESET();
+  CHECK_BOOL(storageNode->HasDetachedData(), false);
+  CHECK_NULL(modelNode->GetMesh());
+
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,232 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+std::string nodeName(int index)
+{
+  std::stringstream ss;
+  ss << "Node_" << index;
+  return ss.str();
+}
+
+//---------------------------------------------------------------------------
+void populateScene(vtkMRMLScene* scene, int numberOfNodes)
+{
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkSmartPointer<vtkMRMLNode> node;
+    switch (i % 3)
+      {
+      case 0: node = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New(); break;
+      case 1: node = vtkSmartPointer<vtkMRMLModelNode>::New(); break;
+      default: node = vtkSmartPointer<vtkMRMLLinearTransformNode>::New(); break;
+      }
+    node->SetName(nodeName(i).c_str());
+    scene->AddNode(node);
+    }
+}
+
+//---------------------------------------------------------------------------
+// Reference implementation: walk the whole node collection.
+std::vector<vtkMRMLNode*> linearGetNodesByClass(vtkMRMLScene* scene, const char* className)
+{
+  std::vector<vtkMRMLNode*> nodes;
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (scene->GetNodes()->InitTraversal(it);
+       (node = (vtkMRMLNode*)scene->GetNodes()->GetNextItemAsObject(it)) ;)
+    {
+    if (node->IsA(className))
+      {
+      nodes.push_back(node);
+      }
+    }
+  return nodes;
+}
+
+//---------------------------------------------------------------------------
+// Reference implementation: walk the whole node collection.
+vtkMRMLNode* linearGetFirstNodeByName(vtkMRMLScene* scene, const char* name)
+{
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (scene->GetNodes()->InitTraversal(it);
+       (node = (vtkMRMLNode*)scene->GetNodes()->GetNextItemAsObject(it)) ;)
+    {
+    if (node->GetName() != 0 && !strcmp(node->GetName(), name))
+      {
+      return node;
+      }
+    }
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+int checkIndices(vtkMRMLScene* scene)
+{
+  const char* classNames[] = {"vtkMRMLNode", "vtkMRMLVolumeNode",
+    "vtkMRMLScalarVolumeNode", "vtkMRMLModelNode", "vtkMRMLTransformNode",
+    "vtkMRMLSliceNode"};
+  for (unsigned int i = 0; i < sizeof(classNames) / sizeof(classNames[0]); ++i)
+    {
+    std::vector<vtkMRMLNode*> expectedNodes = linearGetNodesByClass(scene, classNames[i]);
+    std::vector<vtkMRMLNode*> nodes;
+    CHECK_INT(scene->GetNodesByClass(classNames[i], nodes), static_cast<int>(expectedNodes.size()));
+    CHECK_INT(scene->GetNumberOfNodesByClass(classNames[i]), static_cast<int>(expectedNodes.size()));
+    CHECK_BOOL(nodes == expectedNodes, true);
+    for (int n = 0; n < static_cast<int>(expectedNodes.size()); n += 3)
+      {
+      CHECK_POINTER(scene->GetNthNodeByClass(n, classNames[i]), expectedNodes[n]);
+      }
+    CHECK_NULL(scene->GetNthNodeByClass(static_cast<int>(expectedNodes.size()), classNames[i]));
+    }
+  for (int i = 0; i < scene->GetNumberOfNodes(); i += 7)
+    {
+    vtkMRMLNode* node = scene->GetNthNode(i);
+    CHECK_POINTER(scene->GetFirstNodeByName(node->GetName()),
+                  linearGetFirstNodeByName(scene, node->GetName()));
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int testIndexConsistency()
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer(), 100);
+  CHECK_EXIT_SUCCESS(checkIndices(scene.GetPointer()));
+
+  // Rename
+  vtkMRMLNode* renamedNode = scene->GetNthNode(10);
+  renamedNode->SetName("Renamed");
+  CHECK_NULL(scene->GetFirstNodeByName(nodeName(10).c_str()));
+  CHECK_POINTER(scene->GetFirstNodeByName("Renamed"), renamedNode);
+  vtkSmartPointer<vtkCollection> renamedNodes =
+    vtkSmartPointer<vtkCollection>::Take(scene->GetNodesByClassByName(renamedNode->GetClassName(), "Renamed"));
+  CHECK_INT(renamedNodes->GetNumberOfItems(), 1);
+
+  // Duplicate name, nodes must be returned in scene order
+  scene->GetNthNode(5)->SetName("Renamed");
+  CHECK_POINTER(scene->GetFirstNodeByName("Renamed"), scene->GetNthNode(5));
+  vtkSmartPointer<vtkCollection> sameNameNodes =
+    vtkSmartPointer<vtkCollection>::Take(scene->GetNodesByName("Renamed"));
+  CHECK_INT(sameNameNodes->GetNumberOfItems(), 2);
+  CHECK_POINTER(sameNameNodes->GetItemAsObject(1), renamedNode);
+
+  // Remove
+  scene->RemoveNode(scene->GetNthNode(5));
+  CHECK_POINTER(scene->GetFirstNodeByName("Renamed"), renamedNode);
+  CHECK_EXIT_SUCCESS(checkIndices(scene.GetPointer()));
+
+  // Insert in the middle of the scene
+  vtkNew<vtkMRMLModelNode> insertedNode;
+  insertedNode->SetName("Inserted");
+  scene->InsertBeforeNode(scene->GetNthNode(0), insertedNode.GetPointer());
+  CHECK_POINTER(scene->GetFirstNodeByClass("vtkMRMLModelNode"), insertedNode.GetPointer());
+  CHECK_POINTER(scene->GetFirstNodeByName("Inserted"), insertedNode.GetPointer());
+  CHECK_EXIT_SUCCESS(checkIndices(scene.GetPointer()));
+
+  // Direct modification of the node collection must not be masked by
+  // the indices being updated for a node added afterward
+  vtkSmartPointer<vtkMRMLNode> removedNode = scene->GetNthNode(3);
+  scene->GetNodes()->RemoveItem(removedNode);
+  vtkNew<vtkMRMLModelNode> appendedNode;
+  scene->AddNode(appendedNode.GetPointer());
+  CHECK_EXIT_SUCCESS(checkIndices(scene.GetPointer()));
+  scene->GetNodes()->AddItem(removedNode);
+  scene->RemoveNode(appendedNode.GetPointer());
+  CHECK_EXIT_SUCCESS(checkIndices(scene.GetPointer()));
+
+  // Clear
+  scene->Clear(1);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 0);
+  CHECK_NULL(scene->GetFirstNodeByName("Inserted"));
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int testLookupPerformance(int numberOfNodes)
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer(), numberOfNodes);
+  CHECK_EXIT_SUCCESS(checkIndices(scene.GetPointer()));
+
+  const int numberOfQueries = 100;
+  vtkNew<vtkTimerLog> timer;
+
+  timer->StartTimer();
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    linearGetNodesByClass(scene.GetPointer(), "vtkMRMLVolumeNode");
+    linearGetFirstNodeByName(scene.GetPointer(), nodeName(numberOfNodes - 1 - i).c_str());
+    }
+  timer->StopTimer();
+  double linearTime = timer->GetElapsedTime();
+
+  timer->StartTimer();
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    std::vector<vtkMRMLNode*> nodes;
+    scene->GetNodesByClass("vtkMRMLVolumeNode", nodes);
+    scene->GetFirstNodeByName(nodeName(numberOfNodes - 1 - i).c_str());
+    }
+  timer->StopTimer();
+  double indexedTime = timer->GetElapsedTime();
+
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-LinearLookup-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << linearTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-IndexedLookup-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << indexedTime << "</DartMeasurement>" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodeIndexPerformanceTest(int argc, char * argv[])
+{
+  if (argc > 1)
+    {
+    // benchmark with the given number of nodes
+    CHECK_EXIT_SUCCESS(testLookupPerformance(atoi(argv[1])));
+    return EXIT_SUCCESS;
+    }
+  CHECK_EXIT_SUCCESS(testIndexConsistency());
+  CHECK_EXIT_SUCCESS(testLookupPerformance(1000));
+  CHECK_EXIT_SUCCESS(testLookupPerformance(10000));
+  return EXIT_SUCCESS;
+}
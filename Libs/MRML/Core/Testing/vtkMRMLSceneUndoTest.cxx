@@ -0,0 +1,169 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int testUndoRedo()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkNew<vtkMRMLModelNode> modelNode;
+  modelNode->SetName("Model");
+  scene->AddNode(modelNode.GetPointer());
+
+  // Modify a node
+  scene->SaveStateForUndo(modelNode.GetPointer());
+  modelNode->SetAttribute("Key", "Value1");
+  scene->SaveStateForUndo(modelNode.GetPointer());
+  modelNode->SetAttribute("Key", "Value2");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+
+  scene->Undo();
+  CHECK_STRING(modelNode->GetAttribute("Key"), "Value1");
+  scene->Undo();
+  CHECK_NULL(modelNode->GetAttribute("Key"));
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 2);
+
+  scene->Redo();
+  CHECK_STRING(modelNode->GetAttribute("Key"), "Value1");
+  scene->Redo();
+  CHECK_STRING(modelNode->GetAttribute("Key"), "Value2");
+
+  // Add a node: undo removes it, redo adds it back
+  scene->SaveStateForUndo();
+  vtkNew<vtkMRMLModelNode> addedNode;
+  scene->AddNode(addedNode.GetPointer());
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 2);
+  scene->Undo();
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 1);
+  scene->Redo();
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 2);
+
+  // Remove a node: undo adds the same node back with its saved state
+  scene->SaveStateForUndo();
+  modelNode->SetAttribute("Key", "Value3");
+  scene->RemoveNode(modelNode.GetPointer());
+  scene->Undo();
+  CHECK_POINTER(scene->GetFirstNodeByName("Model"), modelNode.GetPointer());
+  CHECK_STRING(modelNode->GetAttribute("Key"), "Value2");
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int testUndoLimits()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  for (int i = 0; i < 100; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> modelNode;
+    scene->AddNode(modelNode.GetPointer());
+    }
+
+  // Unmodified nodes share their saved state between undo levels
+  scene->SaveStateForUndo();
+  double memorySizeOneLevel = scene->GetUndoStackMemorySizeInMiB();
+  CHECK_BOOL(memorySizeOneLevel > 0, true);
+  scene->SaveStateForUndo();
+  double memorySizeTwoLevels = scene->GetUndoStackMemorySizeInMiB();
+  CHECK_BOOL(memorySizeTwoLevels < 1.1 * memorySizeOneLevel, true);
+
+  // Maximum number of levels
+  scene->SetMaximumNumberOfUndoLevels(5);
+  for (int i = 0; i < 10; ++i)
+    {
+    scene->GetNthNode(0)->SetAttribute("Index", i % 2 ? "odd" : "even");
+    scene->SaveStateForUndo();
+    }
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 5);
+
+  // Memory limit: the most recent level is always kept
+  scene->SetMaximumUndoMemorySizeInMiB(1e-6);
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 1);
+
+  scene->ClearUndoStack();
+  CHECK_DOUBLE(scene->GetUndoStackMemorySizeInMiB(), 0.0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+void SetModelPolyData(vtkMRMLModelNode* modelNode)
+{
+  // about 1.1 MiB of point coordinates
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(100000);
+  vtkNew<vtkPolyData> polyData;
+  polyData->SetPoints(points.GetPointer());
+  modelNode->SetAndObservePolyData(polyData.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+int testUndoDataMemorySize()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  vtkNew<vtkMRMLModelNode> modelNode;
+  scene->AddNode(modelNode.GetPointer());
+  SetModelPolyData(modelNode.GetPointer());
+
+  // Data referenced by the saved state is counted once
+  scene->SaveStateForUndo();
+  double memorySizeOneLevel = scene->GetUndoStackMemorySizeInMiB();
+  CHECK_BOOL(memorySizeOneLevel > 1.0, true);
+  scene->SaveStateForUndo();
+  CHECK_BOOL(scene->GetUndoStackMemorySizeInMiB() < 1.1 * memorySizeOneLevel, true);
+
+  // Replaced data is kept in memory by the undo stack
+  SetModelPolyData(modelNode.GetPointer());
+  scene->SaveStateForUndo();
+  double memorySizeReplacedData = scene->GetUndoStackMemorySizeInMiB();
+  CHECK_BOOL(memorySizeReplacedData > 1.9 * memorySizeOneLevel, true);
+
+  // Memory size is updated when states are removed
+  scene->Undo();
+  CHECK_BOOL(scene->GetUndoStackMemorySizeInMiB() < 1.1 * memorySizeOneLevel, true);
+  CHECK_BOOL(scene->GetRedoStackMemorySizeInMiB() > 1.0, true);
+  scene->Redo();
+  CHECK_DOUBLE(scene->GetRedoStackMemorySizeInMiB(), 0.0);
+  scene->ClearUndoStack();
+  CHECK_DOUBLE(scene->GetUndoStackMemorySizeInMiB(), 0.0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(testUndoRedo());
+  CHECK_EXIT_SUCCESS(testUndoLimits());
+  CHECK_EXIT_SUCCESS(testUndoDataMemorySize());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSubjectHierarchyNode.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+struct EventCounter
+{
+  EventCounter() : LastNumberOfItems(0) { }
+  std::map<unsigned long, int> Counts;
+  int LastNumberOfItems;
+};
+
+//---------------------------------------------------------------------------
+void countEvent(vtkObject* vtkNotUsed(caller), unsigned long eid, void* clientData, void* callData)
+{
+  EventCounter* counter = reinterpret_cast<EventCounter*>(clientData);
+  counter->Counts[eid]++;
+  if (eid == vtkMRMLSubjectHierarchyNode::SubjectHierarchyEndItemBatchModifyEvent)
+    {
+    vtkIdList* itemIDs = reinterpret_cast<vtkIdList*>(callData);
+    counter->LastNumberOfItems = (itemIDs ? itemIDs->GetNumberOfIds() : -1);
+    }
+}
+
+//---------------------------------------------------------------------------
+/// Add study with series items for new model nodes
+void addStudy(vtkMRMLScene* scene, vtkMRMLSubjectHierarchyNode* shNode, int numberOfSeries,
+  std::vector<vtkMRMLNode*>& seriesNodes, std::vector<vtkIdType>& seriesItemIDs)
+{
+  vtkIdType studyItemID = shNode->CreateStudyItem(shNode->GetSceneItemID(), "Study");
+  for (int i = 0; i < numberOfSeries; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> node;
+    std::stringstream ss;
+    ss << "Series_" << i;
+    node->SetName(ss.str().c_str());
+    scene->AddNode(node.GetPointer());
+    seriesNodes.push_back(node.GetPointer());
+    seriesItemIDs.push_back(shNode->CreateItem(studyItemID, node.GetPointer()));
+    }
+}
+
+//---------------------------------------------------------------------------
+int testIndexConsistency()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  CHECK_NOT_NULL(shNode);
+
+  std::vector<vtkMRMLNode*> nodes;
+  std::vector<vtkIdType> itemIDs;
+  addStudy(scene.GetPointer(), shNode, 50, nodes, itemIDs);
+  vtkIdType studyItemID = shNode->GetItemParent(itemIDs[0]);
+  for (int i = 0; i < 50; ++i)
+    {
+    CHECK_INT(shNode->GetItemByDataNode(nodes[i]), itemIDs[i]);
+    CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[i]), i);
+    CHECK_INT(shNode->GetItemByPositionUnderParent(studyItemID, i), itemIDs[i]);
+    }
+
+  // Move item to the front, positions of the other items change
+  CHECK_BOOL(shNode->MoveItem(itemIDs[30], itemIDs[0]), true);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[30]), 0);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[0]), 1);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[29]), 30);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[31]), 31);
+
+  // Reparent item, data node lookup is still valid
+  vtkIdType folderItemID = shNode->CreateFolderItem(shNode->GetSceneItemID(), "Folder");
+  shNode->SetItemParent(itemIDs[10], folderItemID);
+  CHECK_INT(shNode->GetItemByDataNode(nodes[10]), itemIDs[10]);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[10]), 0);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[11]), 11);
+
+  // Removed item is not found by data node
+  CHECK_BOOL(shNode->RemoveItem(itemIDs[20], false), true);
+  CHECK_INT(shNode->GetItemByDataNode(nodes[20]), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[21]), 20);
+
+  // Creating item for a node that already has an item returns the existing item
+  CHECK_INT(shNode->CreateItem(studyItemID, nodes[5]), itemIDs[5]);
+
+  // New item for the node of the removed item
+  vtkIdType newItemID = shNode->CreateItem(studyItemID, nodes[20]);
+  CHECK_BOOL(newItemID != vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID, true);
+  CHECK_INT(shNode->GetItemByDataNode(nodes[20]), newItemID);
+
+  // Removing the data node from the scene does not leave stale entries
+  shNode->RemoveItem(itemIDs[40], true);
+  CHECK_INT(shNode->GetNumberOfItemChildren(studyItemID), 48);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int testBatchEvents()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  CHECK_NOT_NULL(shNode);
+
+  EventCounter counter;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetClientData(&counter);
+  callback->SetCallback(countEvent);
+  shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemAddedEvent, callback.GetPointer());
+  shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent, callback.GetPointer());
+  shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyStartItemBatchModifyEvent, callback.GetPointer());
+  shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyEndItemBatchModifyEvent, callback.GetPointer());
+
+  std::vector<vtkMRMLNode*> nodes;
+  std::vector<vtkIdType> itemIDs;
+  CHECK_BOOL(shNode->IsItemBatchModifyInProgress(), false);
+  shNode->StartItemBatchModify();
+  shNode->StartItemBatchModify(); // nested
+  addStudy(scene.GetPointer(), shNode, 20, nodes, itemIDs);
+  shNode->SetItemAttribute(itemIDs[0], "TestAttribute", "1");
+  shNode->EndItemBatchModify();
+  CHECK_BOOL(shNode->IsItemBatchModifyInProgress(), true);
+  CHECK_INT(counter.Counts[vtkMRMLSubjectHierarchyNode::SubjectHierarchyEndItemBatchModifyEvent], 0);
+  shNode->EndItemBatchModify();
+  CHECK_BOOL(shNode->IsItemBatchModifyInProgress(), false);
+
+  // Added events are invoked for each item, modified events are summarized
+  CHECK_INT(counter.Counts[vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemAddedEvent], 21);
+  CHECK_INT(counter.Counts[vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent], 0);
+  CHECK_INT(counter.Counts[vtkMRMLSubjectHierarchyNode::SubjectHierarchyStartItemBatchModifyEvent], 1);
+  CHECK_INT(counter.Counts[vtkMRMLSubjectHierarchyNode::SubjectHierarchyEndItemBatchModifyEvent], 1);
+  // Summary contains at least the study and series items
+  CHECK_BOOL(counter.LastNumberOfItems >= 21, true);
+
+  // Outside of batch, modified events are invoked for each change
+  shNode->SetItemAttribute(itemIDs[1], "TestAttribute", "1");
+  CHECK_BOOL(counter.Counts[vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent] > 0, true);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int testLookupPerformance(int numberOfSeries)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  CHECK_NOT_NULL(shNode);
+
+  std::vector<vtkMRMLNode*> nodes;
+  std::vector<vtkIdType> itemIDs;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  shNode->StartItemBatchModify();
+  addStudy(scene.GetPointer(), shNode, numberOfSeries, nodes, itemIDs);
+  shNode->EndItemBatchModify();
+  timer->StopTimer();
+  double addTime = timer->GetElapsedTime();
+
+  timer->StartTimer();
+  for (int i = 0; i < numberOfSeries; ++i)
+    {
+    CHECK_INT(shNode->GetItemByDataNode(nodes[i]), itemIDs[i]);
+    CHECK_INT(shNode->GetItemPositionUnderParent(itemIDs[i]), i);
+    }
+  timer->StopTimer();
+  double lookupTime = timer->GetElapsedTime();
+
+  std::cout << "<DartMeasurement name=\"vtkMRMLSubjectHierarchyNode-AddItems-"
+            << numberOfSeries << "\" type=\"numeric/double\">"
+            << addTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkMRMLSubjectHierarchyNode-LookupItems-"
+            << numberOfSeries << "\" type=\"numeric/double\">"
+            << lookupTime << "</DartMeasurement>" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSubjectHierarchyNodeIndexTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(testIndexConsistency());
+  CHECK_EXIT_SUCCESS(testBatchEvents());
+  CHECK_EXIT_SUCCESS(testLookupPerformance(1000));
+  CHECK_EXIT_SUCCESS(testLookupPerformance(10000));
+  return EXIT_SUCCESS;
+}
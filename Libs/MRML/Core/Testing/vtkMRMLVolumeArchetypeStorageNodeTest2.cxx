@@ -0,0 +1,244 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Create a short volume with smooth gradients and some noise, compressible
+/// about as well as a typical medical image.
+void CreateVolume(int size, vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkNew<vtkImageData> volume;
+  volume->SetDimensions(size, size, size / 2 + 16);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(volume->GetScalarPointer());
+  int* dimensions = volume->GetDimensions();
+  unsigned int seed = 1;
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i, ++ptr)
+        {
+        seed = seed * 1103515245 + 12345;
+        *ptr = static_cast<short>(i + 2 * j - 3 * k + ((seed >> 16) & 0x7));
+        }
+      }
+    }
+  volumeNode->SetAndObserveImageData(volume.GetPointer());
+  volumeNode->SetSpacing(0.5, 0.75, 2.0);
+  volumeNode->SetOrigin(10.0, -20.0, 30.0);
+}
+
+//----------------------------------------------------------------------------
+bool WriteVolume(vtkMRMLScene* scene, vtkMRMLScalarVolumeNode* volumeNode,
+                 const std::string& fileName, int compressionLevel)
+{
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetUseCompression(1);
+  storageNode->SetCompressionLevel(compressionLevel);
+  bool success = (storageNode->WriteData(volumeNode) != 0);
+  scene->RemoveNode(storageNode.GetPointer());
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool ReadAndCompare(vtkMRMLScene* scene, vtkMRMLScalarVolumeNode* volumeNode,
+                    const std::string& fileName)
+{
+  vtkNew<vtkMRMLScalarVolumeNode> readVolumeNode;
+  scene->AddNode(readVolumeNode.GetPointer());
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(fileName.c_str());
+  bool success = (storageNode->ReadData(readVolumeNode.GetPointer()) != 0);
+
+  vtkImageData* volume = volumeNode->GetImageData();
+  vtkImageData* readVolume = readVolumeNode->GetImageData();
+  vtkIdType numberOfVoxels = volume->GetNumberOfPoints();
+  if (!success || readVolume == NULL
+    || readVolume->GetNumberOfPoints() != numberOfVoxels
+    || readVolume->GetScalarType() != VTK_SHORT)
+    {
+    std::cerr << "Failed to read " << fileName << std::endl;
+    success = false;
+    }
+  else
+    {
+    short* ptr = static_cast<short*>(volume->GetScalarPointer());
+    short* readPtr = static_cast<short*>(readVolume->GetScalarPointer());
+    vtkNew<vtkMatrix4x4> ijkToRAS;
+    vtkNew<vtkMatrix4x4> readIJKToRAS;
+    volumeNode->GetIJKToRASMatrix(ijkToRAS.GetPointer());
+    readVolumeNode->GetIJKToRASMatrix(readIJKToRAS.GetPointer());
+    for (int i = 0; i < 4; ++i)
+      {
+      for (int j = 0; j < 4; ++j)
+        {
+        if (fabs(ijkToRAS->GetElement(i, j) - readIJKToRAS->GetElement(i, j)) > 1e-6)
+          {
+          success = false;
+          }
+        }
+      }
+    if (!success || !std::equal(ptr, ptr + numberOfVoxels, readPtr))
+      {
+      std::cerr << "Volume read from " << fileName
+                << " is different from the written volume" << std::endl;
+      success = false;
+      }
+    }
+  scene->RemoveNode(storageNode.GetPointer());
+  scene->RemoveNode(readVolumeNode.GetPointer());
+  return success;
+}
+
+//----------------------------------------------------------------------------
+/// Return true if the data of the nrrd file is compressed by blocks
+/// (gzip header with an "SL" extra subfield).
+bool IsBlockCompressed(const std::string& fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  size_t dataStart = content.find("\n\n");
+  if (dataStart == std::string::npos || dataStart + 2 + 16 > content.size())
+    {
+    return false;
+    }
+  const unsigned char* gzipHeader = reinterpret_cast<const unsigned char*>(content.c_str() + dataStart + 2);
+  return gzipHeader[0] == 0x1f && gzipHeader[1] == 0x8b
+    && (gzipHeader[3] & 0x04) != 0
+    && gzipHeader[12] == 'S' && gzipHeader[13] == 'L';
+}
+
+//----------------------------------------------------------------------------
+int TestWriteCompressedNRRD(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  // large enough to be compressed in several blocks
+  CreateVolume(128, volumeNode.GetPointer());
+
+  int defaultNumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(4);
+  std::string fileName = tempDir + "/vtkMRMLVolumeArchetypeStorageNodeTest2.nrrd";
+  bool written = WriteVolume(scene.GetPointer(), volumeNode.GetPointer(), fileName, 1);
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(defaultNumberOfThreads);
+  CHECK_BOOL(written, true);
+  CHECK_BOOL(ReadAndCompare(scene.GetPointer(), volumeNode.GetPointer(), fileName), true);
+#ifdef MRML_USE_vtkTeem
+  // compressed nrrd files are written by blocks on several threads
+  CHECK_BOOL(IsBlockCompressed(fileName), true);
+#endif
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool RunBenchmark(const std::string& tempDir, int size)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  CreateVolume(size, volumeNode.GetPointer());
+  double sizeMiB = volumeNode->GetImageData()->GetActualMemorySize() / 1024.0;
+  std::string fileName = tempDir + "/vtkMRMLVolumeArchetypeStorageNodeTest2_benchmark.nrrd";
+
+  int defaultNumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  const int compressionLevels[3] = { 1, 6, 9 };
+  const int numberOfThreads[3] = { 1, 4, 8 };
+  vtkNew<vtkTimerLog> timer;
+  bool success = true;
+  for (int levelIndex = 0; success && levelIndex < 3; ++levelIndex)
+    {
+    for (int threadIndex = 0; success && threadIndex < 3; ++threadIndex)
+      {
+      int level = compressionLevels[levelIndex];
+      int threads = numberOfThreads[threadIndex];
+      vtkMultiThreader::SetGlobalDefaultNumberOfThreads(threads);
+      timer->StartTimer();
+      success = WriteVolume(scene.GetPointer(), volumeNode.GetPointer(), fileName, level);
+      timer->StopTimer();
+      if (!success)
+        {
+        std::cerr << "Failed to write " << fileName << std::endl;
+        break;
+        }
+      double writeTime = timer->GetElapsedTime();
+      double ratio = sizeMiB * 1024.0 * 1024.0 / vtksys::SystemTools::FileLength(fileName);
+
+      std::cout << "Level " << level << ", " << threads << " thread(s): write "
+                << sizeMiB / writeTime << " MiB/s, ratio " << ratio << std::endl;
+      std::cout << "<DartMeasurement name=\"vtkMRMLVolumeArchetypeStorageNode-WriteMiBPerSecond-L"
+                << level << "-T" << threads << "\" type=\"numeric/double\">" << sizeMiB / writeTime
+                << "</DartMeasurement>" << std::endl;
+      }
+    }
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(defaultNumberOfThreads);
+  success = success && ReadAndCompare(scene.GetPointer(), volumeNode.GetPointer(), fileName);
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  return success;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNodeTest2(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp [benchmark volume size...]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  CHECK_EXIT_SUCCESS(TestWriteCompressedNRRD(tempDir));
+
+  for (int i = 2; i < argc; ++i)
+    {
+    int size = atoi(argv[i]);
+    if (size <= 0 || !RunBenchmark(tempDir, size))
+      {
+      std::cerr << __LINE__ << ": NRRD write benchmark failed for size " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
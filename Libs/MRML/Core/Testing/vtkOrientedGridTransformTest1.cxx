@@ -20,9 +20,13 @@
 
 // VTK includes
 #include "vtkImageData.h"
+#include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
 
+// STD includes
+#include <vector>
+
 typedef double itkVectorComponentType;
 typedef itk::Vector<itkVectorComponentType, 3> itkVectorPixelType;
 typedef itk::Image<itkVectorPixelType,  3> itkDisplacementFieldType;
@@ -286,9 +290,106 @@ double getInverseErrorVtk(const double inputPoint[3], vtkOrientedGridTransform*
   return errorOfInverseComputation;
 }
 
+//----------------------------------------------------------------------------
+int testInverseGridCache()
+{
+  // Displacement is a linear function of the position, therefore its inverse is
+  // also linear and can be exactly interpolated from the cached inverse grid.
+  double origin[3] = {-50, -50, -50};
+  double spacing[3] = {10, 10, 10};
+  double direction[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  double dims[3] = {11, 11, 11};
+  vtkNew<vtkOrientedGridTransform> gridVtk;
+  CreateGridTransformVtk(gridVtk.GetPointer(), origin, spacing, direction, dims);
+  gridVtk->SetInterpolationModeToLinear();
+  for (int k = 0; k < dims[2]; k++)
+    {
+    for (int j = 0; j < dims[1]; j++)
+      {
+      for (int i = 0; i < dims[0]; i++)
+        {
+        int nodeIndex[3] = {i, j, k};
+        double nodeValue[3] = {0.1 * spacing[0] * i, 0.1 * spacing[1] * j, 0.1 * spacing[2] * k};
+        SetGridNodeVtk(gridVtk.GetPointer(), nodeIndex, nodeValue);
+        }
+      }
+    }
+
+  // Points in the grid region and their transformed position (the displacement
+  // is scaled by displacementScale)
+  std::vector<std::vector<double> > inputPoints;
+  for (double i = 1.37; i < 7; i += 1.0)
+    {
+    std::vector<double> inputPoint(3);
+    inputPoint[0] = origin[0] + spacing[0] * i;
+    inputPoint[1] = origin[1] + spacing[1] * (8 - i);
+    inputPoint[2] = origin[2] + spacing[2] * (i + 0.5);
+    inputPoints.push_back(inputPoint);
+    }
+  double displacementScale = 1.0;
+
+  // Inverse is computed by Newton iteration if there is no cached inverse grid
+  gridVtk->Update();
+  CHECK_NULL(gridVtk->GetInverseGrid());
+  for (unsigned int pointIndex = 0; pointIndex < inputPoints.size(); ++pointIndex)
+    {
+    double outputPoint[3];
+    gridVtk->TransformPoint(&inputPoints[pointIndex][0], outputPoint);
+    CHECK_BOOL(gridVtk->GetNumberOfInverseIterations(outputPoint) > 0, true);
+    }
+
+  for (int scaleIndex = 0; scaleIndex < 2; ++scaleIndex)
+    {
+    if (scaleIndex == 0)
+      {
+      gridVtk->CacheInverseGridOn();
+      }
+    else
+      {
+      // the cached inverse grid must be recomputed when the transform changes
+      displacementScale = 2.0;
+      gridVtk->SetDisplacementScale(displacementScale);
+      }
+    gridVtk->Update();
+    vtkAbstractTransform* inverseGridVtk = gridVtk->GetInverse();
+    for (unsigned int pointIndex = 0; pointIndex < inputPoints.size(); ++pointIndex)
+      {
+      const double* inputPoint = &inputPoints[pointIndex][0];
+      double outputPoint[3];
+      gridVtk->TransformPoint(inputPoint, outputPoint);
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        CHECK_DOUBLE_TOLERANCE(outputPoint[axis],
+          inputPoint[axis] + displacementScale * 0.1 * (inputPoint[axis] - origin[axis]), 1e-6);
+        }
+      // the inverse grid is computed at the first inverse transformation,
+      // not by forward transformation
+      if (pointIndex == 0)
+        {
+        CHECK_NULL(gridVtk->GetInverseGrid());
+        }
+      // inverse is interpolated from the cached inverse grid, without any iteration
+      CHECK_INT(gridVtk->GetNumberOfInverseIterations(outputPoint), 0);
+      double inversePoint[3];
+      inverseGridVtk->TransformPoint(outputPoint, inversePoint);
+      CHECK_BOOL(sqrt(vtkMath::Distance2BetweenPoints(inputPoint, inversePoint))
+        < gridVtk->GetInverseTolerance(), true);
+      }
+    CHECK_NOT_NULL(gridVtk->GetInverseGrid());
+    }
+
+  gridVtk->CacheInverseGridOff();
+  gridVtk->Update();
+  CHECK_NULL(gridVtk->GetInverseGrid());
+
+  return EXIT_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 int vtkOrientedGridTransformTest1(int , char * [] )
 {
+  CHECK_EXIT_SUCCESS(testInverseGridCache());
+
   double averageSpacing=100;
   double origin[3] = {-100, -100, -100};
   double spacing[3] = {averageSpacing, averageSpacing, averageSpacing};
@@ -324,6 +425,7 @@ int vtkOrientedGridTransformTest1(int , char * [] )
   int numberOfSingleDoubleVtkPointMismatches=0;
   int numberOfDerivativeMismatches=0;
   int numberOfInverseMismatches=0;
+  int numberOfCachedInverseMismatches=0;
 
   // We take samples in the grid region (first node + 2 < node < last node - 1)
   // because the boundaries are handled differently in ITK and VTK (in ITK there is an
@@ -418,13 +520,40 @@ int vtkOrientedGridTransformTest1(int , char * [] )
       }
     }
 
+  // Verify VTK inverse transform computed using the cached inverse grid
+  gridVtk->CacheInverseGridOn();
+  for (double k=startK+incK; k<=endK-incK; k+=incK)
+    {
+    for (double j=startJ+incJ; j<=endJ-incJ; j+=incJ)
+      {
+      for (double i=startI+incI; i<=endI-incI; i+=incI)
+        {
+        numberOfPointsTested++;
+        double inputPoint[3];
+        inputPoint[0] = origin[0]+direction[0][0]*spacing[0]*i+direction[0][1]*spacing[1]*j+direction[0][2]*spacing[2]*k;
+        inputPoint[1] = origin[1]+direction[1][0]*spacing[0]*i+direction[1][1]*spacing[1]*j+direction[1][2]*spacing[2]*k;
+        inputPoint[2] = origin[2]+direction[2][0]*spacing[0]*i+direction[2][1]*spacing[1]*j+direction[2][2]*spacing[2]*k;
+        double inverseError = getInverseErrorVtk(inputPoint, gridVtk.GetPointer(), false);
+        if ( inverseError > gridVtk->GetInverseTolerance()*1.10 )
+          {
+          getInverseErrorVtk(inputPoint, gridVtk.GetPointer(), true);
+          std::cout << "ERROR: Point transformed by forward and cached inverse transform does not match the original point" << std::endl;
+          numberOfCachedInverseMismatches++;
+          }
+        }
+      }
+    }
+  gridVtk->CacheInverseGridOff();
+
   std::cout << "Number of points tested: " << numberOfPointsTested << std::endl;
   std::cout << "Number of ITK/VTK mismatches: " << numberOfItkVtkPointMismatches << std::endl;
   std::cout << "Number of single/double precision mismatches: " << numberOfSingleDoubleVtkPointMismatches << std::endl;
   std::cout << "Number of derivative mismatches: " << numberOfDerivativeMismatches << std::endl;
   std::cout << "Number of inverse mismatches: " << numberOfInverseMismatches << std::endl;
+  std::cout << "Number of cached inverse mismatches: " << numberOfCachedInverseMismatches << std::endl;
 
-  if (numberOfItkVtkPointMismatches==0 && numberOfDerivativeMismatches==0 && numberOfInverseMismatches==0)
+  if (numberOfItkVtkPointMismatches==0 && numberOfDerivativeMismatches==0 && numberOfInverseMismatches==0
+    && numberOfCachedInverseMismatches==0)
     {
     std::cout << "Test result: PASSED" << std::endl;
     return EXIT_SUCCESS;
@@ -22,6 +22,11 @@
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
 //----------------------------------------------------------------------------
@@ -95,6 +100,8 @@ vtkEventBroker::vtkEventBroker()
   this->EventNestingLevel = 0;
   this->TimerLog = vtkTimerLog::New();
   this->CompressCallData = 0;
+  this->CoalesceEvents = 0;
+  this->NumberOfCoalescedEvents = 0;
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
@@ -140,6 +147,7 @@ void vtkEventBroker::DetachObservations()
       }
     }
   this->SubjectMap.clear();
+  this->CoalescableEvents.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -319,6 +327,20 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
       }
     }
 
+  // forget the coalescable events of the removed observations
+  std::map< CoalescingKey, vtkObservation* >::iterator coalescableIter;
+  for (coalescableIter = this->CoalescableEvents.begin(); coalescableIter != this->CoalescableEvents.end();)
+    {
+    if (observations.find(coalescableIter->second) != observations.end())
+      {
+      this->CoalescableEvents.erase(coalescableIter++);
+      }
+    else
+      {
+      ++coalescableIter;
+      }
+    }
+
   // detach and delete each of the observations
   for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
     {
@@ -751,6 +773,34 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
   // If the event is not currently in the queue, add it and keep a flag.
   //
   vtkObservation::CallType call(eid, callData);
+
+  //
+  // CoalesceEventsOn: drop the event if the observer callback is already
+  // going to be invoked for the same subject and event without call data.
+  //
+  if ( this->CoalesceEvents && callData == NULL )
+    {
+    CoalescingKey key(observation, eid);
+    std::map< CoalescingKey, vtkObservation* >::iterator coalescableIter =
+      this->CoalescableEvents.find(key);
+    if ( coalescableIter != this->CoalescableEvents.end() &&
+         coalescableIter->second->GetInEventQueue() )
+      {
+      // the call may have been replaced (CompressCallDataOn)
+      std::deque< vtkObservation::CallType >* queuedCalls = coalescableIter->second->GetCallDataList();
+      for (std::deque< vtkObservation::CallType >::const_iterator queuedCallIter = queuedCalls->begin();
+           queuedCallIter != queuedCalls->end(); ++queuedCallIter)
+        {
+        if ( queuedCallIter->EventID == eid && queuedCallIter->CallData == NULL )
+          {
+          this->NumberOfCoalescedEvents++;
+          return;
+          }
+        }
+      }
+    this->CoalescableEvents[key] = observation;
+    }
+
   if ( this->GetCompressCallData() &&
        observation->GetEvent() != vtkCommand::AnyEvent)
     {
@@ -841,6 +891,8 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
   double elapsedTime = this->TimerLog->GetUniversalTime() - startTime;
   observation->SetTotalElapsedTime (observation->GetTotalElapsedTime() + elapsedTime);
   observation->SetLastElapsedTime (elapsedTime);
+  observation->SetMaxElapsedTime (std::max(observation->GetMaxElapsedTime(), elapsedTime));
+  observation->SetInvocationCount (observation->GetInvocationCount() + 1);
   this->LogEvent (observation);
 
   // clear reference to observation (may cause delete)
@@ -869,6 +921,17 @@ void vtkEventBroker::ProcessEventQueue ()
       vtkObservation::CallType call = observation->GetCallDataList()->front();
       observation->GetCallDataList()->pop_front();
       finished = (observation->GetCallDataList()->size() == 0);
+      if ( call.CallData == NULL && !this->CoalescableEvents.empty() )
+        {
+        // from now on, the same event must be queued again
+        std::map< CoalescingKey, vtkObservation* >::iterator coalescableIter =
+          this->CoalescableEvents.find(CoalescingKey(observation, call.EventID));
+        if ( coalescableIter != this->CoalescableEvents.end() &&
+             coalescableIter->second == observation )
+          {
+          this->CoalescableEvents.erase(coalescableIter);
+          }
+        }
       this->InvokeObservation( observation, call.EventID, call.CallData );
       if ( !observation->GetInEventQueue() )
         {
@@ -882,6 +945,157 @@ void vtkEventBroker::ProcessEventQueue ()
     }
 }
 
+//----------------------------------------------------------------------------
+vtkEventBroker::CoalescingKey::CoalescingKey(vtkObservation* observation, unsigned long eid)
+  : Subject(observation->GetSubject())
+  , Event(eid)
+  , Observer(observation->GetObserver())
+  , CallbackCommand(observation->GetCallbackCommand())
+  , Script(observation->GetScript())
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkEventBroker::CoalescingKey::operator<(const CoalescingKey& other) const
+{
+  if (this->Subject != other.Subject)
+    {
+    return this->Subject < other.Subject;
+    }
+  if (this->Event != other.Event)
+    {
+    return this->Event < other.Event;
+    }
+  if (this->Observer != other.Observer)
+    {
+    return this->Observer < other.Observer;
+    }
+  if (this->CallbackCommand != other.CallbackCommand)
+    {
+    return this->CallbackCommand < other.CallbackCommand;
+    }
+  return this->Script < other.Script;
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+bool IsTotalElapsedTimeGreater(vtkObservation* observation1, vtkObservation* observation2)
+{
+  return observation1->GetTotalElapsedTime() > observation2->GetTotalElapsedTime();
+}
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetEventStatistics()
+{
+  ObjectToObservationVectorMap::iterator mapIter;
+  for (mapIter = this->SubjectMap.begin(); mapIter != this->SubjectMap.end(); ++mapIter)
+    {
+    for (ObservationVector::iterator obsIter = mapIter->second.begin();
+         obsIter != mapIter->second.end(); ++obsIter)
+      {
+      (*obsIter)->SetInvocationCount(0);
+      (*obsIter)->SetLastElapsedTime(0.0);
+      (*obsIter)->SetTotalElapsedTime(0.0);
+      (*obsIter)->SetMaxElapsedTime(0.0);
+      }
+    }
+  this->NumberOfCoalescedEvents = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintEventStatistics(ostream& os, int maximumNumberOfObservations/*=0*/)
+{
+  std::vector< vtkObservation* > invokedObservations;
+  ObjectToObservationVectorMap::iterator mapIter;
+  for (mapIter = this->SubjectMap.begin(); mapIter != this->SubjectMap.end(); ++mapIter)
+    {
+    for (ObservationVector::iterator obsIter = mapIter->second.begin();
+         obsIter != mapIter->second.end(); ++obsIter)
+      {
+      if ((*obsIter)->GetInvocationCount() > 0)
+        {
+        invokedObservations.push_back(*obsIter);
+        }
+      }
+    }
+  std::sort(invokedObservations.begin(), invokedObservations.end(), IsTotalElapsedTimeGreater);
+  if (maximumNumberOfObservations > 0
+    && invokedObservations.size() > static_cast<size_t>(maximumNumberOfObservations))
+    {
+    invokedObservations.resize(maximumNumberOfObservations);
+    }
+
+  os << "# Invoked observations: " << invokedObservations.size()
+     << ", coalesced events: " << this->NumberOfCoalescedEvents << "\n";
+  os << "# total (s)\tmax (s)\tmean (s)\tcount\tsubject -> observer [event]\n";
+  for (std::vector< vtkObservation* >::iterator obsIter = invokedObservations.begin();
+       obsIter != invokedObservations.end(); ++obsIter)
+    {
+    vtkObservation* observation = *obsIter;
+    const char* eventString = vtkCommand::GetStringFromEventId( observation->GetEvent() );
+    std::stringstream eventStream;
+    if ( !strcmp(eventString, "NoEvent") )
+      {
+      eventStream << observation->GetEvent();
+      }
+    else
+      {
+      eventStream << eventString;
+      }
+    std::string observerString = "No observer class";
+    if ( observation->GetScript() != NULL )
+      {
+      observerString = std::string("\"") + observation->GetScript() + "\"";
+      }
+    else if ( observation->GetObserver() )
+      {
+      observerString = observation->GetObserver()->GetClassName();
+      }
+
+    os << std::fixed << std::setprecision(6)
+       << observation->GetTotalElapsedTime() << "\t"
+       << observation->GetMaxElapsedTime() << "\t"
+       << observation->GetTotalElapsedTime() / observation->GetInvocationCount() << "\t"
+       << observation->GetInvocationCount() << "\t"
+       << observation->GetSubject()->GetClassName() << observation->GetSubject()
+       << " -> " << observerString
+       << " [" << eventStream.str() << "]";
+    if ( observation->GetComment() )
+      {
+      os << " # " << observation->GetComment();
+      }
+    os << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+const char* vtkEventBroker::GetEventStatisticsReport(int maximumNumberOfObservations/*=0*/)
+{
+  std::stringstream report;
+  this->PrintEventStatistics(report, maximumNumberOfObservations);
+  this->EventStatisticsReport = report.str();
+  return this->EventStatisticsReport.c_str();
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::WriteEventStatisticsReport(const char* fileName, int maximumNumberOfObservations/*=0*/)
+{
+  std::ofstream file;
+
+  file.open( fileName, std::ios::out );
+
+  if ( file.fail() )
+    {
+    vtkErrorMacro( "could not write to " << fileName );
+    return 1;
+    }
+  this->PrintEventStatistics(file, maximumNumberOfObservations);
+  file.close();
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -892,6 +1106,9 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
+  os << indent << "CompressCallData: " << this->CompressCallData << "\n";
+  os << indent << "CoalesceEvents: " << this->CoalesceEvents << "\n";
+  os << indent << "NumberOfCoalescedEvents: " << this->NumberOfCoalescedEvents << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
 }
@@ -28,6 +28,7 @@ class vtkTimerLog;
 #include <set>
 #include <map>
 #include <fstream>
+#include <string>
 
 class vtkCollection;
 class vtkCallbackCommand;
@@ -233,6 +234,40 @@ public:
   vtkGetMacro (CompressCallData, int);
   vtkSetMacro (CompressCallData, int);
 
+  ///
+  /// When on, an event without call data is not queued if the same event of
+  /// the same subject is already queued for the same observer and callback
+  /// (possibly through another observation). The callback is then invoked
+  /// only once when the event queue is processed.
+  /// Only applies in asynchronous mode. Off by default.
+  vtkBooleanMacro (CoalesceEvents, int);
+  vtkGetMacro (CoalesceEvents, int);
+  vtkSetMacro (CoalesceEvents, int);
+
+  ///
+  /// Number of events dropped by CoalesceEvents since the last
+  /// ResetEventStatistics()
+  vtkGetMacro (NumberOfCoalescedEvents, unsigned long);
+
+  /// Event profiling
+  ///
+  /// Each observation keeps count of its invocations and of the total and
+  /// maximum time spent in its callback (see vtkObservation).
+  /// Reset these statistics for all observations.
+  void ResetEventStatistics();
+
+  ///
+  /// Report of the invoked observations, sorted by decreasing total time.
+  /// If maximumNumberOfObservations is != 0, only the most expensive
+  /// observations are reported.
+  void PrintEventStatistics(ostream& os, int maximumNumberOfObservations = 0);
+  const char* GetEventStatisticsReport(int maximumNumberOfObservations = 0);
+
+  ///
+  /// Write the event statistics report to a file.
+  /// Returns 0 on success, 1 on failure (as GenerateGraphFile).
+  int WriteEventStatisticsReport(const char* fileName, int maximumNumberOfObservations = 0);
+
   ///
   /// Sets the method pointer to be used for processing script observations
   void SetScriptHandler ( void (*scriptHandler) (const char* script, void *clientData), void *clientData )
@@ -275,6 +310,22 @@ protected:
   /// The event queue of triggered but not-yet-invoked observations
   std::deque< vtkObservation * > EventQueue;
 
+  ///
+  /// Identifies the queued events that can be coalesced
+  struct CoalescingKey
+  {
+    CoalescingKey(vtkObservation* observation, unsigned long eid);
+    bool operator<(const CoalescingKey& other) const;
+    vtkObject* Subject;
+    unsigned long Event;
+    vtkObject* Observer;
+    vtkCallbackCommand* CallbackCommand;
+    const char* Script;
+  };
+  /// Observation queued for each event without call data, used by
+  /// CoalesceEvents
+  std::map< CoalescingKey, vtkObservation* > CoalescableEvents;
+
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
 
@@ -285,6 +336,10 @@ protected:
 
   int EventMode;
   int CompressCallData;
+  int CoalesceEvents;
+  unsigned long NumberOfCoalescedEvents;
+
+  std::string EventStatisticsReport;
 
   std::ofstream LogFile;
 private:
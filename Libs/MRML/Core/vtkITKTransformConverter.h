@@ -1287,6 +1287,8 @@ vtkAbstractTransform* vtkITKTransformConverter::CreateVTKTransformFromITK(
     }
   // Grid
   vtkNew<vtkOrientedGridTransform> gridTransformVtk;
+  // volumes and slices are resampled using the inverse of the grid
+  gridTransformVtk->CacheInverseGridOn();
   conversionSuccess = SetVTKOrientedGridTransformFromITK<T>(loggerObject, gridTransformVtk.GetPointer(), transformItk);
   if (conversionSuccess)
     {
@@ -369,6 +369,9 @@ int ExerciseBasicStorageMRMLMethods(vtkMRMLStorageNode* node)
   const char *f0 = node->GetNthFileName(0);
   std::cout << "Filename 0 = " << (f0 == NULL ? "NULL" : f0) << std::endl;
   TEST_SET_GET_BOOLEAN(node, UseCompression);
+  TEST_SET_GET_INT(node, CompressionLevel, 0);
+  TEST_SET_GET_INT(node, CompressionLevel, 9);
+  TEST_SET_GET_INT(node, CompressionLevel, -1);
   TEST_SET_GET_STRING(node, URI);
 
   vtkURIHandler *handler = vtkURIHandler::New();
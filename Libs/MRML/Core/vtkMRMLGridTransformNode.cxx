@@ -41,6 +41,7 @@ vtkMRMLGridTransformNode::vtkMRMLGridTransformNode()
 
   vtkNew<vtkOrientedGridTransform> warp;
   warp->SetDisplacementGridData( emptyDisplacementField.GetPointer() );
+  warp->CacheInverseGridOn();
 
   this->SetAndObserveTransformFromParent(warp.GetPointer());
 }
@@ -19,6 +19,8 @@
 
 // VTK includes
 #include <vtkActor.h>
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
 #include <vtkBYUReader.h>
 #include <vtkCellArray.h>
 #include <vtkDataSetSurfaceFilter.h>
@@ -30,6 +32,8 @@
 #include <vtkPolyDataMapper.h>
 #include <vtkPLYReader.h>
 #include <vtkPLYWriter.h>
+#include <vtkPointSet.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkProperty.h>
@@ -47,6 +51,7 @@
 #include <vtkXMLPolyDataWriter.h>
 #include <vtkXMLUnstructuredGridReader.h>
 #include <vtkXMLUnstructuredGridWriter.h>
+#include <vtkZLibDataCompressor.h>
 #include <vtkVersion.h>
 
 // ITK includes
@@ -90,6 +95,7 @@ vtkMRMLNodeNewMacro(vtkMRMLModelStorageNode);
 vtkMRMLModelStorageNode::vtkMRMLModelStorageNode()
 {
   this->DefaultWriteFileExtension = "vtk";
+  this->DetachedWriteMeshType = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -152,86 +158,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   int result = 1;
   try
     {
-    if ( extension == std::string(".g") || extension == std::string(".byu") )
-      {
-      vtkNew<vtkBYUReader> reader;
-      reader->SetGeometryFileName(fullName.c_str());
-      reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
-      }
-    else if (extension == std::string(".vtk"))
-      {
-      vtkNew<vtkPolyDataReader> reader;
-      reader->SetFileName(fullName.c_str());
-      vtkNew<vtkUnstructuredGridReader> unstructuredGridReader;
-      unstructuredGridReader->SetFileName(fullName.c_str());
-
-      if (reader->IsFilePolyData())
-        {
-        reader->Update();
-        reader->ReadAllScalarsOn();
-        reader->ReadAllVectorsOn();
-        reader->ReadAllNormalsOn();
-        reader->ReadAllTensorsOn();
-        reader->ReadAllColorScalarsOn();
-        reader->ReadAllTCoordsOn();
-        reader->ReadAllFieldsOn();
-        modelNode->SetPolyDataConnection(reader->GetOutputPort());
-        }
-      else if (unstructuredGridReader->IsFileUnstructuredGrid())
-        {
-        unstructuredGridReader->ReadAllScalarsOn();
-        unstructuredGridReader->ReadAllVectorsOn();
-        unstructuredGridReader->ReadAllNormalsOn();
-        unstructuredGridReader->ReadAllTensorsOn();
-        unstructuredGridReader->ReadAllColorScalarsOn();
-        unstructuredGridReader->ReadAllTCoordsOn();
-        unstructuredGridReader->ReadAllFieldsOn();
-        unstructuredGridReader->Update();
-        modelNode->SetUnstructuredGridConnection(unstructuredGridReader->GetOutputPort());
-        }
-      else
-        {
-        vtkErrorMacro("File " << fullName.c_str()
-                      << " is not recognized as polydata nor as an unstructured grid.");
-        }
-      }
-    else if (extension == std::string(".vtp"))
-      {
-      vtkNew<vtkXMLPolyDataReader> reader;
-      reader->SetFileName(fullName.c_str());
-      reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
-      }
-    else if (extension == std::string(".vtu"))
-      {
-      vtkNew<vtkXMLUnstructuredGridReader> reader;
-      reader->SetFileName(fullName.c_str());
-      reader->Update();
-      modelNode->SetUnstructuredGridConnection(reader->GetOutputPort());
-      }
-    else if (extension == std::string(".stl"))
-      {
-      vtkNew<vtkSTLReader> reader;
-      reader->SetFileName(fullName.c_str());
-      reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
-      }
-    else if (extension == std::string(".ply"))
-      {
-      vtkNew<vtkPLYReader> reader;
-      reader->SetFileName(fullName.c_str());
-      reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
-      }
-    else if (extension == std::string(".obj"))
-      {
-      vtkNew<vtkOBJReader> reader;
-      reader->SetFileName(fullName.c_str());
-      reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
-      }
-    else if (extension == std::string(".meta"))  // model in meta format
+    if (extension == std::string(".meta"))  // model in meta format
       {
       floatMesh::Pointer surfaceMesh = floatMesh::New();
       MeshReaderType::Pointer readerSH = MeshReaderType::New();
@@ -293,8 +220,17 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       }
     else
       {
-      vtkDebugMacro("Cannot read model file '" << fullName.c_str() << "' (extension = " << extension.c_str() << ")");
-      return 0;
+      std::string errorMessage;
+      vtkSmartPointer<vtkAlgorithm> reader = this->ReadMeshWithVTKReader(fullName, extension, errorMessage);
+      if (!reader)
+        {
+        if (!errorMessage.empty())
+          {
+          vtkErrorMacro(<< errorMessage);
+          }
+        return 0;
+        }
+      this->SetMeshConnectionFromReader(modelNode, reader);
       }
     }
   catch (...)
@@ -303,6 +239,114 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     result = 0;
     }
 
+  this->UpdateDisplayScalarRange(modelNode);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkAlgorithm> vtkMRMLModelStorageNode::ReadMeshWithVTKReader(
+  const std::string& fullName, const std::string& extension, std::string& errorMessage)
+{
+  vtkSmartPointer<vtkAlgorithm> result;
+  if ( extension == std::string(".g") || extension == std::string(".byu") )
+    {
+    vtkSmartPointer<vtkBYUReader> reader = vtkSmartPointer<vtkBYUReader>::New();
+    reader->SetGeometryFileName(fullName.c_str());
+    result = reader;
+    }
+  else if (extension == std::string(".vtk"))
+    {
+    vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+    reader->SetFileName(fullName.c_str());
+    vtkSmartPointer<vtkUnstructuredGridReader> unstructuredGridReader =
+      vtkSmartPointer<vtkUnstructuredGridReader>::New();
+    unstructuredGridReader->SetFileName(fullName.c_str());
+
+    if (reader->IsFilePolyData())
+      {
+      reader->ReadAllScalarsOn();
+      reader->ReadAllVectorsOn();
+      reader->ReadAllNormalsOn();
+      reader->ReadAllTensorsOn();
+      reader->ReadAllColorScalarsOn();
+      reader->ReadAllTCoordsOn();
+      reader->ReadAllFieldsOn();
+      result = reader;
+      }
+    else if (unstructuredGridReader->IsFileUnstructuredGrid())
+      {
+      unstructuredGridReader->ReadAllScalarsOn();
+      unstructuredGridReader->ReadAllVectorsOn();
+      unstructuredGridReader->ReadAllNormalsOn();
+      unstructuredGridReader->ReadAllTensorsOn();
+      unstructuredGridReader->ReadAllColorScalarsOn();
+      unstructuredGridReader->ReadAllTCoordsOn();
+      unstructuredGridReader->ReadAllFieldsOn();
+      result = unstructuredGridReader;
+      }
+    else
+      {
+      errorMessage = std::string("File ") + fullName
+        + " is not recognized as polydata nor as an unstructured grid.";
+      return NULL;
+      }
+    }
+  else if (extension == std::string(".vtp"))
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> reader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->SetFileName(fullName.c_str());
+    result = reader;
+    }
+  else if (extension == std::string(".vtu"))
+    {
+    vtkSmartPointer<vtkXMLUnstructuredGridReader> reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+    reader->SetFileName(fullName.c_str());
+    result = reader;
+    }
+  else if (extension == std::string(".stl"))
+    {
+    vtkSmartPointer<vtkSTLReader> reader = vtkSmartPointer<vtkSTLReader>::New();
+    reader->SetFileName(fullName.c_str());
+    result = reader;
+    }
+  else if (extension == std::string(".ply"))
+    {
+    vtkSmartPointer<vtkPLYReader> reader = vtkSmartPointer<vtkPLYReader>::New();
+    reader->SetFileName(fullName.c_str());
+    result = reader;
+    }
+  else if (extension == std::string(".obj"))
+    {
+    vtkSmartPointer<vtkOBJReader> reader = vtkSmartPointer<vtkOBJReader>::New();
+    reader->SetFileName(fullName.c_str());
+    result = reader;
+    }
+  else
+    {
+    vtkDebugMacro("Cannot read model file '" << fullName.c_str() << "' (extension = " << extension.c_str() << ")");
+    return NULL;
+    }
+  result->Update();
+  return result;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::SetMeshConnectionFromReader(vtkMRMLModelNode* modelNode, vtkAlgorithm* reader)
+{
+  if (vtkUnstructuredGrid::SafeDownCast(reader->GetOutputDataObject(0)))
+    {
+    modelNode->SetUnstructuredGridConnection(reader->GetOutputPort());
+    }
+  else
+    {
+    modelNode->SetPolyDataConnection(reader->GetOutputPort());
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::UpdateDisplayScalarRange(vtkMRMLModelNode* modelNode)
+{
   if (modelNode->GetMesh() != NULL)
     {
     // is there an active scalar array?
@@ -317,8 +361,143 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
         }
       }
     }
+}
 
-  return result;
+//----------------------------------------------------------------------------
+bool vtkMRMLModelStorageNode::CanReadDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  // models in meta format are read with ITK, only the VTK readers are used
+  // from worker threads
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(
+    this->GetFileName() ? this->GetFileName() : "");
+  return !extension.empty() && extension != std::string(".meta");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::ReadDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName.c_str()))
+    {
+    return 0;
+    }
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (extension.empty() || extension == std::string(".meta"))
+    {
+    return 0;
+    }
+  try
+    {
+    // errors are reported by ReadData() on the main thread
+    this->DetachedReader = this->ReadMeshWithVTKReader(fullName, extension, this->DetachedReadMessage);
+    }
+  catch (...)
+    {
+    this->DetachedReader = NULL;
+    this->DetachedReadMessage = "ReadData: unknown exception while trying to read file: " + fullName;
+    }
+  return this->DetachedReader.GetPointer() != NULL ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::AttachDetachedDataInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLModelNode *modelNode = vtkMRMLModelNode::SafeDownCast(refNode);
+  if (!modelNode || !this->DetachedReader)
+    {
+    return 0;
+    }
+  this->SetMeshConnectionFromReader(modelNode, this->DetachedReader);
+  this->UpdateDisplayScalarRange(modelNode);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::ClearDetachedData()
+{
+  this->DetachedReader = NULL;
+  this->Superclass::ClearDetachedData();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLModelStorageNode::CanWriteDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(
+    this->GetFileName() ? this->GetFileName() : "");
+  return extension == std::string(".vtk")
+    || extension == std::string(".vtp")
+    || extension == std::string(".vtu")
+    || extension == std::string(".stl")
+    || extension == std::string(".ply");
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+// We explicitly write the coordinate system into the file header.
+// For now, if space is not defined in a file then we assume that it is in the RAS
+// space (for backward compatibility) but in the future we will switch to LPS by default
+// to be consistent with image coordinate system (that is most often LPS).
+const std::string coordinateSystemTag = "SPACE"; // following NRRD naming convention
+const std::string coordinateSystemValue = "RAS";
+// SPACE=RAS format follows Mimics software's convention, saving extra information into the
+// STL file header: COLOR=rgba,MATERIAL=rgbargbargba
+// (see details at https://en.wikipedia.org/wiki/STL_(file_format)#Color_in_binary_STL)
+const std::string coordinateSytemSpecification = coordinateSystemTag + "=" + coordinateSystemValue;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::PrepareWriteDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(refNode);
+  vtkPointSet* mesh = modelNode ? modelNode->GetMesh() : NULL;
+  if (mesh == NULL)
+    {
+    return 0;
+    }
+  // the writers of the worker threads must not update the pipeline of the
+  // model node, nor share the mesh with the pipelines of other writers
+  this->DetachedWriteMesh = vtkSmartPointer<vtkPointSet>::Take(mesh->NewInstance());
+  this->DetachedWriteMesh->ShallowCopy(mesh);
+  this->DetachedWriteMeshType = modelNode->GetMeshType();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::WriteDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  this->DetachedWriteMessage.clear();
+  if (this->DetachedWriteMesh.GetPointer() == NULL)
+    {
+    return 0;
+    }
+  return this->WriteMeshInternal(this->DetachedWriteMesh, this->DetachedWriteMeshType,
+                                 this->GetFullNameFromFileName(), this->DetachedWriteMessage);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::CompleteWriteDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  if (!this->DetachedWriteMessage.empty())
+    {
+    if (this->DetachedWriteResult)
+      {
+      vtkWarningMacro("WriteData: " << refNode->GetID() << ": " << this->DetachedWriteMessage);
+      }
+    else
+      {
+      vtkErrorMacro("WriteData: " << refNode->GetID() << ": " << this->DetachedWriteMessage);
+      }
+    }
+  return this->DetachedWriteResult;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::ClearDetachedWriteData()
+{
+  this->DetachedWriteMesh = NULL;
+  this->DetachedWriteMessage.clear();
+  this->Superclass::ClearDetachedWriteData();
 }
 
 //----------------------------------------------------------------------------
@@ -335,33 +514,95 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 
   std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
 
-  // We explicitly write the coordinate system into the file header.
-  // For now, if space is not defined in a file then we assume that it is in the RAS
-  // space (for backward compatibility) but in the future we will switch to LPS by default
-  // to be consistent with image coordinate system (that is most often LPS).
-  const std::string coordinateSystemTag = "SPACE"; // following NRRD naming convention
-  const std::string coordinateSystemValue = "RAS";
-  // SPACE=RAS format follows Mimics software's convention, saving extra information into the
-  // STL file header: COLOR=rgba,MATERIAL=rgbargbargba
-  // (see details at https://en.wikipedia.org/wiki/STL_(file_format)#Color_in_binary_STL)
-  const std::string coordinateSytemSpecification = coordinateSystemTag + "=" + coordinateSystemValue;
+  int result = 1;
+  if (extension == ".obj")
+    {
+    vtkNew<vtkPolyDataMapper> mapper;
+    mapper->SetInputConnection(modelNode->GetPolyDataConnection());
+    vtkNew<vtkActor> actor;
+    actor->SetMapper(mapper.GetPointer());
+    vtkMRMLDisplayNode* displayNode = modelNode->GetDisplayNode();
+    if (displayNode)
+      {
+      double color[3] = { 0.5, 0.5, 0.5 };
+      displayNode->GetColor(color);
+      // OBJ exporter sets the same color for ambient, diffuse, specular
+      // so we scale it by 1/3 to avoid having too bright material.
+      double colorScale = 1.0 / 3.0;
+      actor->GetProperty()->SetColor(color[0] * colorScale, color[1] * colorScale, color[2] * colorScale);
+      actor->GetProperty()->SetSpecularPower(3.0);
+      actor->GetProperty()->SetOpacity(displayNode->GetOpacity());
+      }
+    vtkNew<vtkRenderer> renderer;
+    renderer->AddActor(actor.GetPointer());
+    vtkNew<vtkRenderWindow> renderWindow;
+    renderWindow->AddRenderer(renderer.GetPointer());
+    vtkNew<vtkOBJExporter> exporter;
+    exporter->SetRenderWindow(renderWindow.GetPointer());
+    std::string fullNameWithoutExtension = fullName;
+    if (fullNameWithoutExtension.size() > 4)
+      {
+      fullNameWithoutExtension.erase(fullNameWithoutExtension.size() - 4);
+      }
+    exporter->SetFilePrefix(fullNameWithoutExtension.c_str());
+#if VTK_MAJOR_VERSION >= 9
+    std::string header = std::string("3D Slicer output. ") + coordinateSytemSpecification;
+    exporter->SetOBJFileComment(header.c_str());
+#endif
+    try
+      {
+      exporter->Write();
+      this->ResetFileNameList();
+      std::string materialFileName = fullNameWithoutExtension + ".mtl";
+      this->AddFileName(materialFileName.c_str());
+      }
+    catch (...)
+      {
+      result = 0;
+      }
+    }
+  else
+    {
+    std::string message;
+    result = this->WriteMeshInternal(modelNode->GetMesh(), modelNode->GetMeshType(), fullName, message);
+    if (!message.empty())
+      {
+      if (result)
+        {
+        vtkWarningMacro("WriteDataInternal: " << message);
+        }
+      else
+        {
+        vtkErrorMacro("WriteDataInternal: " << message);
+        }
+      }
+    }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::WriteMeshInternal(vtkPointSet* mesh, int meshType,
+                                               const std::string& fullName,
+                                               std::string& message)
+{
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
 
   int result = 1;
   if (extension == ".vtk" &&
-    (modelNode->GetMeshType() == vtkMRMLModelNode::PolyDataMeshType
-    || modelNode->GetMeshType() == vtkMRMLModelNode::UnstructuredGridMeshType))
+    (meshType == vtkMRMLModelNode::PolyDataMeshType
+    || meshType == vtkMRMLModelNode::UnstructuredGridMeshType))
     {
     vtkSmartPointer<vtkDataWriter> writer;
-    if (modelNode->GetMeshType() == vtkMRMLModelNode::PolyDataMeshType)
+    if (meshType == vtkMRMLModelNode::PolyDataMeshType)
       {
       writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-      writer->SetInputConnection(modelNode->GetPolyDataConnection());
       }
     else
       {
       writer = vtkSmartPointer<vtkUnstructuredGridWriter>::New();
-      writer->SetInputConnection(modelNode->GetMeshConnection());
       }
+    writer->SetInputData(mesh);
 
     writer->SetFileName(fullName.c_str());
     writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
@@ -387,13 +628,13 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       {
       writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
       inputData = vtkSmartPointer<vtkUnstructuredGrid>::New();
-      inputData->ShallowCopy(modelNode->GetUnstructuredGrid());
+      inputData->ShallowCopy(vtkUnstructuredGrid::SafeDownCast(mesh));
       }
     else
       {
       writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
       inputData = vtkSmartPointer<vtkPolyData>::New();
-      inputData->ShallowCopy(modelNode->GetPolyData());
+      inputData->ShallowCopy(vtkPolyData::SafeDownCast(mesh));
       }
     writer->SetInputData(inputData);
     writer->SetFileName(fullName.c_str());
@@ -401,6 +642,11 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       this->GetUseCompression() ? vtkXMLWriter::ZLIB : vtkXMLWriter::NONE);
     writer->SetDataMode(
       this->GetUseCompression() ? vtkXMLWriter::Appended : vtkXMLWriter::Ascii);
+    vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::SafeDownCast(writer->GetCompressor());
+    if (compressor && this->GetCompressionLevel() >= 0)
+      {
+      compressor->SetCompressionLevel(this->GetCompressionLevel());
+      }
 
     // Write coordinate system space (RAS) to field data
     // In the future (when Slicer switches to VTK8) array metadata may be used instead of separate field data.
@@ -420,7 +666,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       }
     else
       {
-      vtkWarningMacro("vtkMRMLModelStorageNode::WriteDataInternal 'space' field already exists, cannot write coordinate system name into file");
+      message = "'space' field already exists, cannot write coordinate system name into file";
       }
 
     try
@@ -439,7 +685,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     vtkNew<vtkSTLWriter> writer;
     writer->SetFileName(fullName.c_str());
     writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
-    triangulator->SetInputConnection( modelNode->GetPolyDataConnection() );
+    triangulator->SetInputData(vtkPolyData::SafeDownCast(mesh));
     writer->SetInputConnection( triangulator->GetOutputPort() );
     std::string header = std::string("3D Slicer output. ") + coordinateSytemSpecification;
     writer->SetHeader(header.c_str());
@@ -458,7 +704,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     vtkNew<vtkPLYWriter> writer;
     writer->SetFileName(fullName.c_str());
     writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
-    triangulator->SetInputConnection( modelNode->GetPolyDataConnection() );
+    triangulator->SetInputData(vtkPolyData::SafeDownCast(mesh));
     writer->SetInputConnection( triangulator->GetOutputPort() );
     std::string header = std::string("3D Slicer output. ") + coordinateSytemSpecification;
     writer->AddComment(coordinateSytemSpecification);
@@ -471,56 +717,10 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       result = 0;
       }
     }
-  else if (extension == ".obj")
-    {
-    vtkNew<vtkPolyDataMapper> mapper;
-    mapper->SetInputConnection(modelNode->GetPolyDataConnection());
-    vtkNew<vtkActor> actor;
-    actor->SetMapper(mapper.GetPointer());
-    vtkMRMLDisplayNode* displayNode = modelNode->GetDisplayNode();
-    if (displayNode)
-      {
-      double color[3] = { 0.5, 0.5, 0.5 };
-      displayNode->GetColor(color);
-      // OBJ exporter sets the same color for ambient, diffuse, specular
-      // so we scale it by 1/3 to avoid having too bright material.
-      double colorScale = 1.0 / 3.0;
-      actor->GetProperty()->SetColor(color[0] * colorScale, color[1] * colorScale, color[2] * colorScale);
-      actor->GetProperty()->SetSpecularPower(3.0);
-      actor->GetProperty()->SetOpacity(displayNode->GetOpacity());
-      }
-    vtkNew<vtkRenderer> renderer;
-    renderer->AddActor(actor.GetPointer());
-    vtkNew<vtkRenderWindow> renderWindow;
-    renderWindow->AddRenderer(renderer.GetPointer());
-    vtkNew<vtkOBJExporter> exporter;
-    exporter->SetRenderWindow(renderWindow.GetPointer());
-    std::string fullNameWithoutExtension = fullName;
-    if (fullNameWithoutExtension.size() > 4)
-      {
-      fullNameWithoutExtension.erase(fullNameWithoutExtension.size() - 4);
-      }
-    exporter->SetFilePrefix(fullNameWithoutExtension.c_str());
-#if VTK_MAJOR_VERSION >= 9
-    std::string header = std::string("3D Slicer output. ") + coordinateSytemSpecification;
-    exporter->SetOBJFileComment(header.c_str());
-#endif
-    try
-      {
-      exporter->Write();
-      this->ResetFileNameList();
-      std::string materialFileName = fullNameWithoutExtension + ".mtl";
-      this->AddFileName(materialFileName.c_str());
-      }
-    catch (...)
-      {
-      result = 0;
-      }
-    }
   else
     {
     result = 0;
-    vtkErrorMacro( << "No file extension recognized: " << fullName.c_str() );
+    message = "No file extension recognized: " + fullName;
     }
 
   return result;
@@ -17,7 +17,12 @@
 
 #include "vtkMRMLStorageNode.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
+class vtkAlgorithm;
 class vtkMRMLModelNode;
+class vtkPointSet;
 
 /// \brief MRML node for model storage on disk.
 ///
@@ -41,6 +46,9 @@ public:
   /// Return true if the reference node can be read in
   virtual bool CanReadInReferenceNode(vtkMRMLNode *refNode) VTK_OVERRIDE;
 
+  /// Release the reader used by ReadDataDetached()
+  virtual void ClearDetachedData() VTK_OVERRIDE;
+
 protected:
   vtkMRMLModelStorageNode();
   ~vtkMRMLModelStorageNode();
@@ -62,6 +70,48 @@ protected:
   /// Write data from a  referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
 
+  /// Models in VTK file formats can be read from worker threads
+  virtual bool CanReadDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int ReadDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int AttachDetachedDataInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+
+  /// Models in VTK file formats can be written from worker threads,
+  /// OBJ export needs a render window and is left to WriteData().
+  virtual bool CanWriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int PrepareWriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int WriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int CompleteWriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual void ClearDetachedWriteData() VTK_OVERRIDE;
+
+  /// Write \a mesh in \a fullName with the VTK writer matching its extension.
+  /// Does not modify the storage node nor invoke events, errors and warnings
+  /// are returned in \a message. OBJ files are written by WriteDataInternal().
+  /// Returns 1 on success, 0 otherwise.
+  int WriteMeshInternal(vtkPointSet* mesh, int meshType,
+                        const std::string& fullName, std::string& message);
+
+  /// Read the file with the VTK reader matching \a extension.
+  /// Returns the up-to-date reader or NULL if the file cannot be read, in
+  /// which case the error (if any) is set in \a errorMessage.
+  vtkSmartPointer<vtkAlgorithm> ReadMeshWithVTKReader(const std::string& fullName,
+                                                      const std::string& extension,
+                                                      std::string& errorMessage);
+
+  /// Set the output of \a reader as the mesh of \a modelNode
+  void SetMeshConnectionFromReader(vtkMRMLModelNode* modelNode, vtkAlgorithm* reader);
+
+  /// Set the data scalar range to the display node if it uses it
+  void UpdateDisplayScalarRange(vtkMRMLModelNode* modelNode);
+
+  /// Reader that was updated by ReadDataDetached()
+  vtkSmartPointer<vtkAlgorithm> DetachedReader;
+
+  /// Shallow copy of the mesh written by WriteDataDetached()
+  vtkSmartPointer<vtkPointSet> DetachedWriteMesh;
+  int DetachedWriteMeshType;
+  /// Error or warning of WriteDataDetached(), reported on the main thread
+  std::string DetachedWriteMessage;
+
 };
 
 #endif
@@ -76,7 +76,9 @@ vtkMRMLNode::~vtkMRMLNode()
   this->NodeReferenceEvents.clear();
 
   this->SetID(NULL);
-  this->SetName(NULL);
+  // Do not call SetName(): the scene does not need to be notified anymore.
+  delete [] this->Name;
+  this->Name = NULL;
   this->SetDescription(NULL);
 
   if (this->MRMLObserverManager)
@@ -927,6 +929,35 @@ void vtkMRMLNode::SetID (const char* _arg)
   this->Modified();
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLNode::SetName(const char* _arg)
+{
+  // Mostly copied from vtkSetStringMacro() in vtkSetGet.cxx
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting Name to " << (_arg?_arg:"(null)") );
+  if ( this->Name == NULL && _arg == NULL) { return;}
+  if ( this->Name && _arg && (!strcmp(this->Name,_arg))) { return;}
+  char* oldName = this->Name;
+  if (_arg)
+    {
+    size_t n = strlen(_arg) + 1;
+    char *cp1 =  new char[n];
+    const char *cp2 = (_arg);
+    this->Name = cp1;
+    do { *cp1++ = *cp2++; } while ( --n );
+    }
+   else
+    {
+    this->Name = NULL;
+    }
+  if (this->Scene)
+    {
+    // keep the scene name index in sync
+    this->Scene->UpdateNodeName(this, oldName);
+    }
+  if (oldName) { delete [] oldName; }
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 const char * vtkMRMLNode::URLEncodeString(const char *inString)
 {
@@ -336,8 +336,11 @@ public:
   vtkSetStringMacro(Description);
   vtkGetStringMacro(Description);
 
-  /// Name of this node, to be set by the user
-  vtkSetStringMacro(Name);
+  /// \brief Name of this node, to be set by the user.
+  ///
+  /// The scene the node belongs to is notified so that its name index
+  /// (used by vtkMRMLScene::GetNodesByName()) stays up-to-date.
+  virtual void SetName(const char* name);
   vtkGetStringMacro(Name);
 
   /// ID use by other nodes to reference this node in XML.
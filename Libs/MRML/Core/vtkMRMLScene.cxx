@@ -54,6 +54,8 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLSliceCompositeNode.h"
 #include "vtkMRMLSliceNode.h"
 #include "vtkMRMLSnapshotClipNode.h"
+#include "vtkMRMLStorableNode.h"
+#include "vtkMRMLStorageNode.h"
 #include "vtkMRMLSubjectHierarchyNode.h"
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableStorageNode.h"
@@ -63,6 +65,7 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLVectorVolumeDisplayNode.h"
 #include "vtkMRMLViewNode.h"
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
+#include "vtkMRMLVolumeNode.h"
 #include "vtkURIHandler.h"
 #include "vtkMRMLLayoutNode.h"
 
@@ -84,8 +87,14 @@ Version:   $Revision: 1.18 $
 #include <vtkCollection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointSet.h>
+#include <vtkSimpleMutexLock.h>
 #include <vtkSmartPointer.h>
+#include <vtkTable.h>
 
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
@@ -93,7 +102,9 @@ Version:   $Revision: 1.18 $
 
 // STD includes
 #include <algorithm>
+#include <iterator>
 #include <numeric>
+#include <sstream>
 
 //#define MRMLSCENE_VERBOSE
 
@@ -110,13 +121,17 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NextNodeOrderKey = 0;
+  this->NodeIndicesMTime = 0;
 
   this->RegisteredNodeClasses.clear();
   this->UniqueIDs.clear();
   this->UniqueNames.clear();
 
   this->Nodes =  vtkCollection::New();
-  this->UndoStackSize = 100;
+  this->MaximumNumberOfUndoLevels = 100;
+  this->MaximumUndoMemorySizeInMiB = 1024;
+  this->MaximumNumberOfReadThreads = 0;
   this->UndoFlag = false;
   this->InUndo = false;
 
@@ -737,6 +752,109 @@ int vtkMRMLScene::Connect()
   return res;
 }
 
+//------------------------------------------------------------------------------
+namespace
+{
+
+struct ReadDataDetachedThreadData
+{
+  std::vector<std::pair<vtkMRMLStorageNode*, vtkMRMLNode*> > Jobs;
+  int NextJob;
+  int EndJob;
+  vtkSimpleMutexLock* JobLock;
+};
+
+//------------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ReadDataDetachedThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ReadDataDetachedThreadData* threadData = static_cast<ReadDataDetachedThreadData*>(threadInfo->UserData);
+  // No event is invoked here: progress is reported between batches on the
+  // calling thread and read errors are reported by ReadData().
+  while (true)
+    {
+    threadData->JobLock->Lock();
+    int job = threadData->NextJob++;
+    threadData->JobLock->Unlock();
+    if (job >= threadData->EndJob)
+      {
+      break;
+      }
+    threadData->Jobs[job].first->ReadDataDetached(threadData->Jobs[job].second);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+std::vector<vtkSmartPointer<vtkMRMLStorageNode> > vtkMRMLScene::ReadDataDetached(vtkCollection* nodes)
+{
+  std::vector<vtkSmartPointer<vtkMRMLStorageNode> > storageNodes;
+  int maximumNumberOfThreads = this->MaximumNumberOfReadThreads;
+  if (maximumNumberOfThreads <= 0)
+    {
+    maximumNumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  if (maximumNumberOfThreads <= 1 || !this->ReadDataOnLoad)
+    {
+    return storageNodes;
+    }
+
+  ReadDataDetachedThreadData threadData;
+  std::set<vtkMRMLStorageNode*> jobStorageNodes;
+  vtkMRMLNode* node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (nodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+    if (!storableNode || !storableNode->GetAddToScene())
+      {
+      continue;
+      }
+    for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); ++i)
+      {
+      vtkMRMLStorageNode* storageNode = storableNode->GetNthStorageNode(i);
+      // a storage node shared by several nodes is read the usual way
+      if (!storageNode || !jobStorageNodes.insert(storageNode).second ||
+          !storageNode->CanReadDataDetached(storableNode))
+        {
+        continue;
+        }
+      threadData.Jobs.push_back(std::make_pair(storageNode, node));
+      storageNodes.push_back(storageNode);
+      }
+    }
+  if (threadData.Jobs.size() < 2)
+    {
+    // nothing to gain
+    storageNodes.clear();
+    return storageNodes;
+    }
+
+  vtkNew<vtkSimpleMutexLock> jobLock;
+  threadData.NextJob = 0;
+  threadData.JobLock = jobLock.GetPointer();
+
+  int numberOfJobs = static_cast<int>(threadData.Jobs.size());
+  int numberOfThreads = std::min(maximumNumberOfThreads, numberOfJobs);
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ReadDataDetachedThreadFunction, &threadData);
+  // Read the files in batches to report progress from the calling thread
+  // between them, observers may then safely update the GUI.
+  int batchSize = 4 * numberOfThreads;
+  while (threadData.NextJob < numberOfJobs)
+    {
+    threadData.EndJob = std::min(threadData.NextJob + batchSize, numberOfJobs);
+    threader->SingleMethodExecute();
+    threadData.NextJob = threadData.EndJob;
+    this->ProgressState(vtkMRMLScene::ImportState, threadData.EndJob);
+    }
+  return storageNodes;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Import()
 {
@@ -797,6 +915,11 @@ int vtkMRMLScene::Import()
 
     this->InvokeEvent(vtkMRMLScene::NewSceneEvent, NULL);
 
+    // Read the data files first, concurrently. The data is set into the
+    // nodes by UpdateScene() below, in order and with the usual events.
+    std::vector<vtkSmartPointer<vtkMRMLStorageNode> > detachedStorageNodes =
+      this->ReadDataDetached(addedNodes);
+
     // Notify the imported nodes about that all nodes are created
     // (so the observers can be attached to referenced nodes, etc.)
     // by calling UpdateScene on each node
@@ -820,6 +943,12 @@ int vtkMRMLScene::Import()
         // this->SetErrorCode(0);
         }
       }
+    // release the data that has not been used (e.g. node removed meanwhile)
+    for (std::vector<vtkSmartPointer<vtkMRMLStorageNode> >::iterator storageNodeIt =
+         detachedStorageNodes.begin(); storageNodeIt != detachedStorageNodes.end(); ++storageNodeIt)
+      {
+      (*storageNodeIt)->ClearDetachedData();
+      }
 
     this->Modified();
     this->RemoveUnusedNodeReferences();
@@ -1182,10 +1311,16 @@ vtkMRMLNode* vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
     n->SetName(this->GenerateUniqueName(n).c_str());
     }
   n->SetScene( this );
+  // indices that are already out-of-date are rebuilt when they are queried
+  bool nodeIndicesUpToDate = this->AreNodeIndicesUpToDate();
   this->Nodes->vtkCollection::AddItem((vtkObject *)n);
 
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  if (nodeIndicesUpToDate)
+    {
+    this->AddNodeToIndices(n);
+    }
 
   //n->OnNodeAddedToScene();
 
@@ -1344,10 +1479,15 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     {
     n->SetScene(0);
     }
+  bool nodeIndicesUpToDate = this->AreNodeIndicesUpToDate();
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
 
   std::string nid=n->GetID();
   this->RemoveNodeID(n->GetID());
+  if (nodeIndicesUpToDate)
+    {
+    this->RemoveNodeFromIndices(n);
+    }
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1525,18 +1665,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetNodeClassIndex(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1548,15 +1677,11 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  nodes.reserve(classIndex.size());
+  for (NodeIndexType::const_iterator it = classIndex.begin(); it != classIndex.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
+    nodes.push_back(it->second);
     }
   return static_cast<int>(nodes.size());
 }
@@ -1570,15 +1695,10 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return 0;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  for (NodeIndexType::const_iterator it = classIndex.begin(); it != classIndex.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(it->second);
     }
   return nodes;
 }
@@ -1639,13 +1759,11 @@ vtkMRMLNode* vtkMRMLScene::GetSingletonNode(const char* singletonTag, const char
     return NULL;
     }
 
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node = NULL;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  for (NodeIndexType::const_iterator it = classIndex.begin(); it != classIndex.end(); ++it)
     {
-    if (node->IsA(className) &&
-        node->GetSingletonTag() != NULL &&
+    vtkMRMLNode* node = it->second;
+    if (node->GetSingletonTag() != NULL &&
         strcmp(node->GetSingletonTag(), singletonTag) == 0)
       {
       return node;
@@ -1715,22 +1833,12 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return NULL;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetNodeClassArray(className);
+  if (n >= static_cast<int>(classNodes.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return NULL;
     }
-  return NULL;
+  return classNodes[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1750,14 +1858,12 @@ vtkCollection* vtkMRMLScene::GetNodesByName(const char* name)
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const NodeIndexType* nameIndex = this->GetNodeNameIndex(name);
+  if (nameIndex)
     {
-    if (!strcmp(node->GetName(), name))
+    for (NodeIndexType::const_iterator it = nameIndex->begin(); it != nameIndex->end(); ++it)
       {
-      nodes->AddItem(node);
+      nodes->AddItem(it->second);
       }
     }
   return nodes;
@@ -1801,23 +1907,18 @@ vtkMRMLNode* vtkMRMLScene::GetFirstNode(const char* byName,
 //------------------------------------------------------------------------------
 vtkMRMLNode* vtkMRMLScene::GetFirstNodeByName(const char* name)
 {
-  vtkMRMLNode *node = 0;
   if (name == 0)
     {
     vtkErrorMacro("GetNodesByName: name is null");
-    return node;
+    return 0;
     }
 
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const NodeIndexType* nameIndex = this->GetNodeNameIndex(name);
+  if (!nameIndex || nameIndex->empty())
     {
-    if (node->GetName() != 0 && !strcmp(node->GetName(), name))
-      {
-      return node;
-      }
+    return 0;
     }
-  return 0;
+  return nameIndex->begin()->second;
 }
 
 //------------------------------------------------------------------------------
@@ -1877,13 +1978,17 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  // Names are usually unique, therefore filter the (short) list of nodes
+  // having that name by class.
+  const NodeIndexType* nameIndex = this->GetNodeNameIndex(name);
+  if (nameIndex)
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (!strcmp(node->GetName(), name) && node->IsA(className))
+    for (NodeIndexType::const_iterator it = nameIndex->begin(); it != nameIndex->end(); ++it)
       {
-      nodes->AddItem(node);
+      if (it->second->IsA(className))
+        {
+        nodes->AddItem(it->second);
+        }
       }
     }
 
@@ -1963,6 +2068,8 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-to-date
   this->AddNodeID(n);
+  // the node may not be at the end of the collection, indices must be rebuilt
+  this->InvalidateNodeIndices();
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2048,6 +2155,8 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  // the node may not be at the end of the collection, indices must be rebuilt
+  this->InvalidateNodeIndices();
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2068,6 +2177,7 @@ void vtkMRMLScene::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ErrorCode = " << this->ErrorCode << "\n";
   os << indent << "URL = " << this->GetURL() << "\n";
   os << indent << "Root Directory = " << this->GetRootDirectory() << "\n";
+  os << indent << "MaximumNumberOfReadThreads = " << this->MaximumNumberOfReadThreads << "\n";
 
   this->Nodes->vtkCollection::PrintSelf(os,indent);
   std::list<std::string> classes = this->GetNodeClassesList();
@@ -2347,6 +2457,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
     {
     this->CopyNodeInUndoStack(node);
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2378,6 +2489,7 @@ void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2417,6 +2529,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2438,89 +2551,280 @@ void vtkMRMLScene::SaveStateForUndo ()
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to all the nodes in the current scene
-void vtkMRMLScene::PushIntoUndoStack()
+// State of the scene saved for undo/redo.
+struct vtkMRMLScene::UndoStateType
 {
-  if (this->Nodes == NULL)
+  struct NodeCopyType
     {
-    return;
+    vtkSmartPointer<vtkMRMLNode> Node;
+    /// MTime of the scene node when the copy was made
+    vtkMTimeType SourceMTime;
+    /// Estimated memory size of the node properties
+    size_t MemorySize;
+    /// Bulk data referenced by the copy (NULL if none)
+    vtkSmartPointer<vtkDataObject> Data;
+    /// Memory size of the bulk data
+    size_t DataMemorySize;
+    };
+  typedef std::map< vtkMRMLNode*, NodeCopyType > NodeCopiesType;
+
+  /// Nodes of the scene when the state was saved.
+  /// Shared between consecutive states if no node was added or removed.
+  vtkSmartPointer<vtkCollection> Nodes;
+  vtkMTimeType NodesMTime;
+
+  /// Copies of the saved nodes, indexed by the scene node they were copied
+  /// from. A copy is shared between consecutive states if the scene node has
+  /// not been modified in between.
+  NodeCopiesType NodeCopies;
+
+  /// Return the copy of \a node saved in this state, \a node if it was not
+  /// saved.
+  vtkMRMLNode* GetNodeState(vtkMRMLNode* node)
+    {
+    NodeCopiesType::iterator it = this->NodeCopies.find(node);
+    return (it != this->NodeCopies.end() ? it->second.Node.GetPointer() : node);
     }
+};
 
-  vtkCollection* newScene = vtkCollection::New();
+namespace
+{
 
-  vtkCollection* currentScene = this->Nodes;
+//------------------------------------------------------------------------------
+// Estimate of the memory used by the properties of a node copy: the node
+// object and its properties, as they are written in the scene file.
+size_t EstimateNodeMemorySize(vtkMRMLNode* node)
+{
+  std::stringstream properties;
+  node->WriteXML(properties, 0);
+  return sizeof(vtkMRMLNode) + static_cast<size_t>(properties.tellp());
+}
 
-  int nnodes = currentScene->GetNumberOfItems();
+//------------------------------------------------------------------------------
+// Bulk data of a node (image data, mesh, table), NULL if the node has none.
+vtkDataObject* GetNodeData(vtkMRMLNode* node)
+{
+  if (vtkMRMLVolumeNode::SafeDownCast(node))
+    {
+    return vtkMRMLVolumeNode::SafeDownCast(node)->GetImageData();
+    }
+  if (vtkMRMLModelNode::SafeDownCast(node))
+    {
+    return vtkMRMLModelNode::SafeDownCast(node)->GetMesh();
+    }
+  if (vtkMRMLTableNode::SafeDownCast(node))
+    {
+    return vtkMRMLTableNode::SafeDownCast(node)->GetTable();
+    }
+  return NULL;
+}
 
+//------------------------------------------------------------------------------
+void GetNodeIDs(vtkCollection* nodes, std::vector<std::string>& ids, std::vector<vtkMRMLNode*>& nodeList)
+{
+  int nnodes = nodes->GetNumberOfItems();
   for (int n=0; n<nnodes; n++)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
+    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(n));
     if (node && !node->IsA("vtkMRMLSceneViewNode"))
       {
-      newScene->AddItem(node);
+      ids.push_back(node->GetID());
+      nodeList.push_back(node);
       }
     }
+}
 
-  //TODO check max stack size
-  this->UndoStack.push_back(newScene);
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to the current scene nodes
-void vtkMRMLScene::PushIntoRedoStack()
+vtkMRMLScene::UndoStateType* vtkMRMLScene::CreateUndoState(const UndoStackType& stack)
+{
+  UndoStateType* state = new UndoStateType;
+  state->NodesMTime = this->Nodes->GetMTime();
+  if (!stack.States.empty() && stack.States.back()->NodesMTime == state->NodesMTime)
+    {
+    // no node has been added or removed since the last state, share the list
+    state->Nodes = stack.States.back()->Nodes;
+    return state;
+    }
+  // Make a new collection that has pointers to all the nodes in the current scene
+  state->Nodes = vtkSmartPointer<vtkCollection>::New();
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    if (!node->IsA("vtkMRMLSceneViewNode"))
+      {
+      state->Nodes->AddItem(node);
+      }
+    }
+  return state;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PushIntoUndoStack()
 {
   if (this->Nodes == NULL)
     {
     return;
     }
+  this->PushState(this->UndoStack, this->CreateUndoState(this->UndoStack));
+}
 
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PushIntoRedoStack()
+{
+  if (this->Nodes == NULL)
+    {
+    return;
+    }
+  this->PushState(this->RedoStack, this->CreateUndoState(this->RedoStack));
+}
 
-  int nnodes = currentScene->GetNumberOfItems();
+//------------------------------------------------------------------------------
+void vtkMRMLScene::CopyNodeInStack(UndoStackType& stack, vtkMRMLNode *copyNode)
+{
+  if (stack.States.empty())
+    {
+    vtkErrorMacro("CopyNodeInStack: no state to copy the node into");
+    return;
+    }
+  UndoStateType* state = stack.States.back();
+  if (state->NodeCopies.find(copyNode) != state->NodeCopies.end())
+    {
+    // already saved, keep the state of the node when it was first saved
+    return;
+    }
 
-  for (int n=0; n<nnodes; n++)
+  // Share the copy of the previous state if the node has not been modified since
+  if (stack.States.size() > 1)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
+    UndoStateType* previousState = *(++stack.States.rbegin());
+    UndoStateType::NodeCopiesType::iterator previousCopyIt = previousState->NodeCopies.find(copyNode);
+    if (previousCopyIt != previousState->NodeCopies.end()
+      && previousCopyIt->second.SourceMTime == copyNode->GetMTime()
+      && copyNode->GetModifiedEventPending() == 0)
       {
-      newScene->AddItem(node);
+      state->NodeCopies[copyNode] = previousCopyIt->second;
+      this->UpdateStackNodeCopyMemorySize(stack, state, copyNode, true);
+      return;
       }
     }
 
-  //TODO check max stack size
-  this->RedoStack.push_back(newScene);
+  UndoStateType::NodeCopyType nodeCopy;
+  nodeCopy.Node = vtkSmartPointer<vtkMRMLNode>::Take(copyNode->CreateNodeInstance());
+  if (nodeCopy.Node.GetPointer() == NULL)
+    {
+    vtkErrorMacro("CopyNodeInStack: failed to create a copy of " << copyNode->GetID());
+    return;
+    }
+  // Data objects are copied by reference, only the node properties are duplicated.
+  nodeCopy.Node->CopyWithScene(copyNode);
+  nodeCopy.SourceMTime = copyNode->GetMTime();
+  nodeCopy.MemorySize = EstimateNodeMemorySize(copyNode);
+  nodeCopy.Data = GetNodeData(nodeCopy.Node);
+  nodeCopy.DataMemorySize = (nodeCopy.Data.GetPointer() ?
+    static_cast<size_t>(nodeCopy.Data->GetActualMemorySize()) * 1024 : 0);
+  state->NodeCopies[copyNode] = nodeCopy;
+  this->UpdateStackNodeCopyMemorySize(stack, state, copyNode, true);
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the undoable copy of the scene so that the node
-// can be edited
-void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
+void vtkMRMLScene::PushState(UndoStackType& stack, UndoStateType* state)
 {
-  if (!copyNode)
+  stack.States.push_back(state);
+  this->UpdateStackMemorySize(stack, state, true);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PopState(UndoStackType& stack, bool front)
+{
+  if (stack.States.empty())
     {
-    vtkErrorMacro("CopyNodeInUndoStack: node is null");
     return;
     }
+  UndoStateType* state = (front ? stack.States.front() : stack.States.back());
+  this->UpdateStackMemorySize(stack, state, false);
+  if (front)
+    {
+    stack.States.pop_front();
+    }
+  else
+    {
+    stack.States.pop_back();
+    }
+  delete state;
+}
 
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::UpdateStackMemorySize(UndoStackType& stack, UndoStateType* state, bool add)
+{
+  size_t stateSize = sizeof(UndoStateType);
+  stack.MemorySize = (add ? stack.MemorySize + stateSize : stack.MemorySize - stateSize);
+  // a collection element holds a pointer to the node and the next element
+  this->UpdateStackObjectMemorySize(stack, state->Nodes,
+    state->Nodes->GetNumberOfItems() * 2 * sizeof(void*), add);
+  for (UndoStateType::NodeCopiesType::iterator copyIt = state->NodeCopies.begin();
+    copyIt != state->NodeCopies.end(); ++copyIt)
     {
-    snode->CopyWithScene(copyNode);
+    this->UpdateStackNodeCopyMemorySize(stack, state, copyIt->first, add);
     }
-  vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::UpdateStackNodeCopyMemorySize(UndoStackType& stack, UndoStateType* state,
+                                                 vtkMRMLNode* node, bool add)
+{
+  UndoStateType::NodeCopiesType::iterator copyIt = state->NodeCopies.find(node);
+  if (copyIt == state->NodeCopies.end())
+    {
+    return;
+    }
+  // map entry
+  size_t entrySize = sizeof(UndoStateType::NodeCopiesType::value_type) + 4 * sizeof(void*);
+  stack.MemorySize = (add ? stack.MemorySize + entrySize : stack.MemorySize - entrySize);
+  this->UpdateStackObjectMemorySize(stack, copyIt->second.Node, copyIt->second.MemorySize, add);
+  if (copyIt->second.Data.GetPointer())
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
+    this->UpdateStackObjectMemorySize(stack, copyIt->second.Data, copyIt->second.DataMemorySize, add);
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::UpdateStackObjectMemorySize(UndoStackType& stack, vtkObject* object, size_t size, bool add)
+{
+  if (add)
+    {
+    if (++stack.ObjectUseCounts[object] == 1)
       {
-      undoScene->ReplaceItem (n, snode);
-      break;
+      stack.MemorySize += size;
       }
+    return;
+    }
+  std::map< vtkObject*, int >::iterator useCountIt = stack.ObjectUseCounts.find(object);
+  if (useCountIt == stack.ObjectUseCounts.end())
+    {
+    return;
+    }
+  if (--useCountIt->second == 0)
+    {
+    stack.ObjectUseCounts.erase(useCountIt);
+    stack.MemorySize -= size;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Put a replacement node into the undoable copy of the scene so that the node
+// can be edited
+void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
+{
+  if (!copyNode)
+    {
+    vtkErrorMacro("CopyNodeInUndoStack: node is null");
+    return;
     }
-  snode->Delete();
+  this->CopyNodeInStack(this->UndoStack, copyNode);
 }
 
 //------------------------------------------------------------------------------
@@ -2533,23 +2837,40 @@ void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInRedoStack: node is null");
     return;
     }
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+  this->CopyNodeInStack(this->RedoStack, copyNode);
+}
+
+//------------------------------------------------------------------------------
+double vtkMRMLScene::GetUndoStackMemorySizeInMiB()
+{
+  return this->GetStackMemorySize(this->UndoStack) / (1024.0 * 1024.0);
+}
+
+//------------------------------------------------------------------------------
+double vtkMRMLScene::GetRedoStackMemorySizeInMiB()
+{
+  return this->GetStackMemorySize(this->RedoStack) / (1024.0 * 1024.0);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::TrimUndoStack()
+{
+  if (this->MaximumNumberOfUndoLevels > 0)
     {
-    snode->CopyWithSceneWithSingleModifiedEvent(copyNode);
+    while (static_cast<int>(this->UndoStack.States.size()) > this->MaximumNumberOfUndoLevels)
+      {
+      this->PopState(this->UndoStack, true);
+      }
     }
-  vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->RedoStack.back() );
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  if (this->MaximumUndoMemorySizeInMiB > 0)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
+    // the most recent state is always kept
+    while (this->UndoStack.States.size() > 1
+      && this->GetUndoStackMemorySizeInMiB() > this->MaximumUndoMemorySizeInMiB)
       {
-      undoScene->ReplaceItem (n, snode);
-      break;
+      this->PopState(this->UndoStack, true);
       }
     }
-  snode->Delete();
 }
 
 //------------------------------------------------------------------------------
@@ -2562,7 +2883,7 @@ void vtkMRMLScene::Undo()
     return;
     }
 
-  if (this->UndoStack.size() == 0)
+  if (this->UndoStack.States.empty())
     {
     return;
     }
@@ -2571,82 +2892,61 @@ void vtkMRMLScene::Undo()
 
   this->InUndo = true;
 
-  int nnodes;
-  int n;
   unsigned int nn;
 
   PushIntoRedoStack();
 
-  vtkCollection* currentScene = this->Nodes;
   // We use 2 vectors instead of a map in order to keep the ordering of the
   // nodes.
   std::vector<std::string> currentIDs;
   std::vector<vtkMRMLNode*> currentNodes;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  GetNodeIDs(this->Nodes, currentIDs, currentNodes);
+  std::map<std::string, vtkMRMLNode*> currentMap;
+  for (nn=0; nn<currentIDs.size(); nn++)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      currentIDs.push_back(node->GetID());
-      currentNodes.push_back(node);
-      }
+    currentMap[currentIDs[nn]] = currentNodes[nn];
     }
 
-  vtkCollection* undoScene = NULL;
+  UndoStateType* undoState = this->UndoStack.States.back();
   std::vector<std::string> undoIDs;
   std::vector<vtkMRMLNode*> undoNodes;
-
-  if (!this->UndoStack.empty())
-    {
-    undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
-      {
-      vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-      if (node && !node->IsA("vtkMRMLSceneViewNode"))
-        {
-        undoIDs.push_back(node->GetID());
-        undoNodes.push_back(node);
-        }
-      }
-    }
-
-  std::vector<std::string>::iterator iterID;
-  std::vector<vtkMRMLNode*>::iterator iterNode;
-  std::vector<std::string>::iterator curIterID;
-  std::vector<vtkMRMLNode*>::iterator curIterNode;
+  GetNodeIDs(undoState->Nodes, undoIDs, undoNodes);
+  std::set<std::string> undoIDSet(undoIDs.begin(), undoIDs.end());
 
   // copy back changes and add deleted nodes to the current scene
   std::vector<vtkMRMLNode*> addNodes;
 
-  for(iterID=undoIDs.begin(), iterNode = undoNodes.begin(); iterID != undoIDs.end(); iterID++, iterNode++)
+  for (nn=0; nn<undoNodes.size(); nn++)
     {
-    curIterID = std::find(currentIDs.begin(), currentIDs.end(), *iterID);
-    curIterNode = currentNodes.begin() + std::distance(currentIDs.begin(), curIterID);
-    if ( curIterID == currentIDs.end() )
+    vtkMRMLNode* undoNode = undoNodes[nn];
+    vtkMRMLNode* undoNodeState = undoState->GetNodeState(undoNode);
+    std::map<std::string, vtkMRMLNode*>::iterator curIter = currentMap.find(undoIDs[nn]);
+    if ( curIter == currentMap.end() )
       {
-      // the node was deleted, add Node back to the curreent scene
-      addNodes.push_back(*iterNode);
+      // the node was deleted, add Node back to the current scene
+      if (undoNodeState != undoNode)
+        {
+        undoNode->CopyWithSceneWithSingleModifiedEvent(undoNodeState);
+        }
+      addNodes.push_back(undoNode);
       }
-    else if (*iterNode != *curIterNode)
+    else if (undoNodeState != curIter->second)
       {
       // nodes differ, copy from undo to current scene
       // but before create a copy in redo stack from current
-      this->CopyNodeInRedoStack(*curIterNode);
-      (*curIterNode)->CopyWithSceneWithSingleModifiedEvent(*iterNode);
+      this->CopyNodeInRedoStack(curIter->second);
+      curIter->second->CopyWithSceneWithSingleModifiedEvent(undoNodeState);
       }
     }
 
   // remove new nodes created before Undo
   std::vector<vtkMRMLNode*> removeNodes;
-  for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
+  for (nn=0; nn<currentIDs.size(); nn++)
     {
-    iterID = std::find(undoIDs.begin(),undoIDs.end(), *curIterID);
     // Remove only if the node is not present in the previous state.
-    if ( iterID == undoIDs.end() )
+    if (undoIDSet.find(currentIDs[nn]) == undoIDSet.end())
       {
-      removeNodes.push_back(*curIterNode);
+      removeNodes.push_back(currentNodes[nn]);
       }
     }
 
@@ -2665,18 +2965,9 @@ void vtkMRMLScene::Undo()
       }
     }
 
-  if (undoScene)
-    {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
-    }
-
   this->RemoveUnusedNodeReferences();
 
-  if (!this->UndoStack.empty())
-   {
-   UndoStack.pop_back();
-   }
+  this->PopState(this->UndoStack, false);
   this->Modified();
 
   this->InUndo = false;
@@ -2690,73 +2981,61 @@ void vtkMRMLScene::Redo()
     return;
     }
 
-  if (this->RedoStack.size() == 0)
+  if (this->RedoStack.States.empty())
     {
     return;
     }
 
-  int nnodes;
-  int n;
   unsigned int nn;
 
   this->RemoveUnusedNodeReferences();
 
   PushIntoUndoStack();
 
-  vtkCollection* currentScene = this->Nodes;
-  //std::hash_map<std::string, vtkMRMLNode*> currentMap;
+  std::vector<std::string> currentIDs;
+  std::vector<vtkMRMLNode*> currentNodes;
+  GetNodeIDs(this->Nodes, currentIDs, currentNodes);
   std::map<std::string, vtkMRMLNode*> currentMap;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  for (nn=0; nn<currentIDs.size(); nn++)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      currentMap[node->GetID()] = node;
-      }
+    currentMap[currentIDs[nn]] = currentNodes[nn];
     }
 
-  //std::hash_map<std::string, vtkMRMLNode*> undoMap;
-  std::map<std::string, vtkMRMLNode*> undoMap;
-
-  vtkCollection* undoScene = NULL;
-
-  if (!this->RedoStack.empty())
+  UndoStateType* redoState = this->RedoStack.States.back();
+  std::vector<std::string> redoIDs;
+  std::vector<vtkMRMLNode*> redoNodes;
+  GetNodeIDs(redoState->Nodes, redoIDs, redoNodes);
+  std::map<std::string, vtkMRMLNode*> redoMap;
+  for (nn=0; nn<redoIDs.size(); nn++)
     {
-    undoScene = dynamic_cast < vtkCollection *>( this->RedoStack.back() );;
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
-      {
-      vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-      if (node && !node->IsA("vtkMRMLSceneViewNode"))
-        {
-        undoMap[node->GetID()] = node;
-        }
-      }
+    redoMap[redoIDs[nn]] = redoNodes[nn];
     }
 
-  //std::hash_map<std::string, vtkMRMLNode*>::iterator iter;
-  //std::hash_map<std::string, vtkMRMLNode*>::iterator curIter;
   std::map<std::string, vtkMRMLNode*>::iterator iter;
   std::map<std::string, vtkMRMLNode*>::iterator curIter;
 
   // copy back changes and add deleted nodes to the current scene
   std::vector<vtkMRMLNode*> addNodes;
 
-  for(iter=undoMap.begin(); iter != undoMap.end(); iter++)
+  for(iter=redoMap.begin(); iter != redoMap.end(); iter++)
     {
+    vtkMRMLNode* redoNodeState = redoState->GetNodeState(iter->second);
     curIter = currentMap.find(iter->first);
     if ( curIter == currentMap.end() )
       {
-      // the node was deleted, add Node back to the curreent scene
+      // the node was deleted, add Node back to the current scene
+      if (redoNodeState != iter->second)
+        {
+        iter->second->CopyWithSceneWithSingleModifiedEvent(redoNodeState);
+        }
       addNodes.push_back(iter->second);
       }
-    else if (iter->second != curIter->second)
+    else if (redoNodeState != curIter->second)
       {
       // nodes differ, copy from redo to current scene
       // but before create a copy in undo stack from current
       this->CopyNodeInUndoStack(curIter->second);
-      curIter->second->CopyWithSceneWithSingleModifiedEvent(iter->second);
+      curIter->second->CopyWithSceneWithSingleModifiedEvent(redoNodeState);
       }
     }
 
@@ -2764,8 +3043,8 @@ void vtkMRMLScene::Redo()
   std::vector<vtkMRMLNode*> removeNodes;
   for(curIter=currentMap.begin(); curIter != currentMap.end(); curIter++)
     {
-    iter = undoMap.find(curIter->first);
-    if ( iter == undoMap.end() )
+    iter = redoMap.find(curIter->first);
+    if ( iter == redoMap.end() )
       {
       removeNodes.push_back(curIter->second);
       }
@@ -2780,39 +3059,35 @@ void vtkMRMLScene::Redo()
     this->RemoveNode(removeNodes[nn]);
     }
 
-  if (undoScene)
-    {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
-    }
+  this->PopState(this->RedoStack, false);
 
-  RedoStack.pop_back();
+  this->TrimUndoStack();
 
   this->Modified();
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::ClearUndoStack()
+void vtkMRMLScene::ClearStack(UndoStackType& stack)
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
+  for (std::list< UndoStateType* >::iterator iter = stack.States.begin(); iter != stack.States.end(); ++iter)
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    delete *iter;
     }
-  this->UndoStack.clear();
+  stack.States.clear();
+  stack.ObjectUseCounts.clear();
+  stack.MemorySize = 0;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ClearUndoStack()
+{
+  this->ClearStack(this->UndoStack);
 }
 
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearRedoStack()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
-    {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
-    }
-  this->RedoStack.clear();
+  this->ClearStack(this->RedoStack);
 }
 
 //------------------------------------------------------------------------------
@@ -3137,6 +3412,217 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+bool vtkMRMLScene::AreNodeIndicesUpToDate()
+{
+  return this->NodeIndicesMTime != 0 && this->Nodes->GetMTime() <= this->NodeIndicesMTime;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodeIndices()
+{
+  if (this->AreNodeIndicesUpToDate())
+    {
+    // up-to-date
+    return;
+    }
+#ifdef MRMLSCENE_VERBOSE
+  std::cerr << "Recompute node class and name indices..." << std::endl;
+#endif
+  this->NodeOrderKeys.clear();
+  this->NodeClassIndices.clear();
+  this->NodeClassArrays.clear();
+  this->NodeNameIndices.clear();
+  this->NextNodeOrderKey = 0;
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    unsigned long orderKey = this->NextNodeOrderKey++;
+    this->NodeOrderKeys[node] = orderKey;
+    if (node->GetName())
+      {
+      this->NodeNameIndices[node->GetName()][orderKey] = node;
+      }
+    }
+  // Class indices are populated on demand by GetNodeClassIndex()
+  this->NodeIndicesMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToIndices(vtkMRMLNode *node)
+{
+  if (!node || this->NodeIndicesMTime == 0)
+    {
+    // indices will be fully rebuilt when they are queried
+    return;
+    }
+  if (this->NodeOrderKeys.find(node) != this->NodeOrderKeys.end())
+    {
+    // node is already indexed, indices are out of sync
+    this->InvalidateNodeIndices();
+    return;
+    }
+  unsigned long orderKey = this->NextNodeOrderKey++;
+  this->NodeOrderKeys[node] = orderKey;
+  if (node->GetName())
+    {
+    this->NodeNameIndices[node->GetName()][orderKey] = node;
+    }
+  for (std::map< std::string, NodeIndexType >::iterator classIt = this->NodeClassIndices.begin();
+    classIt != this->NodeClassIndices.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second[orderKey] = node;
+      // the node has the largest order key, it goes last
+      std::map< std::string, std::vector<vtkMRMLNode*> >::iterator arrayIt =
+        this->NodeClassArrays.find(classIt->first);
+      if (arrayIt != this->NodeClassArrays.end())
+        {
+        arrayIt->second.push_back(node);
+        }
+      }
+    }
+  this->NodeIndicesMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromIndices(vtkMRMLNode *node)
+{
+  if (!node || this->NodeIndicesMTime == 0)
+    {
+    return;
+    }
+  std::map< vtkMRMLNode*, unsigned long >::iterator orderKeyIt = this->NodeOrderKeys.find(node);
+  if (orderKeyIt == this->NodeOrderKeys.end())
+    {
+    // node is not indexed, indices are out of sync
+    this->InvalidateNodeIndices();
+    return;
+    }
+  unsigned long orderKey = orderKeyIt->second;
+  this->NodeOrderKeys.erase(orderKeyIt);
+  if (node->GetName())
+    {
+    std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(node->GetName());
+    if (nameIt != this->NodeNameIndices.end())
+      {
+      nameIt->second.erase(orderKey);
+      if (nameIt->second.empty())
+        {
+        this->NodeNameIndices.erase(nameIt);
+        }
+      }
+    }
+  for (std::map< std::string, NodeIndexType >::iterator classIt = this->NodeClassIndices.begin();
+    classIt != this->NodeClassIndices.end(); ++classIt)
+    {
+    if (classIt->second.erase(orderKey))
+      {
+      this->NodeClassArrays.erase(classIt->first);
+      }
+    }
+  this->NodeIndicesMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::InvalidateNodeIndices()
+{
+  this->NodeOrderKeys.clear();
+  this->NodeClassIndices.clear();
+  this->NodeClassArrays.clear();
+  this->NodeNameIndices.clear();
+  this->NodeIndicesMTime = 0;
+}
+
+//-----------------------------------------------------------------------------
+const vtkMRMLScene::NodeIndexType& vtkMRMLScene::GetNodeClassIndex(const char* className)
+{
+  this->UpdateNodeIndices();
+  std::map< std::string, NodeIndexType >::iterator classIt = this->NodeClassIndices.find(className);
+  if (classIt != this->NodeClassIndices.end())
+    {
+    return classIt->second;
+    }
+  // First time this class is requested, populate its index
+  NodeIndexType& classIndex = this->NodeClassIndices[className];
+  for (std::map< vtkMRMLNode*, unsigned long >::iterator orderKeyIt = this->NodeOrderKeys.begin();
+    orderKeyIt != this->NodeOrderKeys.end(); ++orderKeyIt)
+    {
+    if (orderKeyIt->first->IsA(className))
+      {
+      classIndex[orderKeyIt->second] = orderKeyIt->first;
+      }
+    }
+  return classIndex;
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>& vtkMRMLScene::GetNodeClassArray(const char* className)
+{
+  const NodeIndexType& classIndex = this->GetNodeClassIndex(className);
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator arrayIt =
+    this->NodeClassArrays.find(className);
+  if (arrayIt != this->NodeClassArrays.end())
+    {
+    return arrayIt->second;
+    }
+  std::vector<vtkMRMLNode*>& classNodes = this->NodeClassArrays[className];
+  classNodes.reserve(classIndex.size());
+  for (NodeIndexType::const_iterator it = classIndex.begin(); it != classIndex.end(); ++it)
+    {
+    classNodes.push_back(it->second);
+    }
+  return classNodes;
+}
+
+//-----------------------------------------------------------------------------
+const vtkMRMLScene::NodeIndexType* vtkMRMLScene::GetNodeNameIndex(const char* name)
+{
+  this->UpdateNodeIndices();
+  std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(name);
+  if (nameIt == this->NodeNameIndices.end())
+    {
+    return 0;
+    }
+  return &(nameIt->second);
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodeName(vtkMRMLNode* node, const char* oldName)
+{
+  if (!node || !this->AreNodeIndicesUpToDate())
+    {
+    // indices will be fully rebuilt when they are queried
+    return;
+    }
+  std::map< vtkMRMLNode*, unsigned long >::iterator orderKeyIt = this->NodeOrderKeys.find(node);
+  if (orderKeyIt == this->NodeOrderKeys.end())
+    {
+    // node is not in the scene (yet)
+    return;
+    }
+  unsigned long orderKey = orderKeyIt->second;
+  if (oldName)
+    {
+    std::map< std::string, NodeIndexType >::iterator nameIt = this->NodeNameIndices.find(oldName);
+    if (nameIt != this->NodeNameIndices.end())
+      {
+      nameIt->second.erase(orderKey);
+      if (nameIt->second.empty())
+        {
+        this->NodeNameIndices.erase(nameIt);
+        }
+      }
+    }
+  if (node->GetName())
+    {
+    this->NodeNameIndices[node->GetName()][orderKey] = node;
+    }
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
@@ -43,6 +43,7 @@ class vtkGeneralTransform;
 class vtkURIHandler;
 class vtkMRMLNode;
 class vtkMRMLSceneViewNode;
+class vtkMRMLStorageNode;
 
 /// \brief A set of MRML Nodes that supports serialization and undo/redo.
 ///
@@ -59,6 +60,11 @@ class VTK_MRML_EXPORT vtkMRMLScene : public vtkObject
   /// but that's the only class that is allowed to do so
   friend class vtkMRMLSceneViewNode;
 
+  ///
+  /// make the vtkMRMLNode a friend so that it can notify the scene about
+  /// name changes, for example UpdateNodeName()
+  friend class vtkMRMLNode;
+
 public:
   static vtkMRMLScene *New();
   vtkTypeMacro(vtkMRMLScene, vtkObject);
@@ -349,10 +355,38 @@ public:
   void ClearRedoStack();
 
   /// returns number of undo steps in the history buffer
-  int GetNumberOfUndoLevels() { return (int)this->UndoStack.size();};
+  int GetNumberOfUndoLevels() { return (int)this->UndoStack.States.size();};
 
   /// returns number of redo steps in the history buffer
-  int GetNumberOfRedoLevels() { return (int)this->RedoStack.size();};
+  int GetNumberOfRedoLevels() { return (int)this->RedoStack.States.size();};
+
+  /// \brief Maximum number of undo steps kept in the history buffer.
+  ///
+  /// When the limit is reached, the oldest steps are discarded.
+  /// Set to 0 for no limit. Default is 100.
+  vtkSetMacro(MaximumNumberOfUndoLevels, int);
+  vtkGetMacro(MaximumNumberOfUndoLevels, int);
+
+  /// \brief Maximum estimated memory size of the undo history buffer.
+  ///
+  /// When the limit is exceeded, the oldest steps are discarded (the most
+  /// recent step is always kept).
+  /// Set to 0 for no limit. Default is 1024 MiB.
+  /// \sa GetUndoStackMemorySizeInMiB()
+  vtkSetMacro(MaximumUndoMemorySizeInMiB, double);
+  vtkGetMacro(MaximumUndoMemorySizeInMiB, double);
+
+  /// \brief Returns the estimated memory size of the undo history buffer.
+  ///
+  /// Node states and bulk data (image data, polydata, ...) shared between
+  /// undo steps are counted once. Bulk data is shared with the nodes of the
+  /// scene, but it is counted because the undo steps keep it in memory
+  /// after the scene nodes have released it.
+  double GetUndoStackMemorySizeInMiB();
+
+  /// Returns the estimated memory size of the redo history buffer.
+  /// \sa GetUndoStackMemorySizeInMiB()
+  double GetRedoStackMemorySizeInMiB();
 
   /// Save current state in the undo buffer
   void SaveStateForUndo();
@@ -468,6 +502,16 @@ public:
   vtkSetMacro(ReadDataOnLoad,int);
   vtkGetMacro(ReadDataOnLoad,int);
 
+  /// \brief Maximum number of threads used to read data files on import.
+  ///
+  /// Import() first reads the files of all the storage nodes that support
+  /// it (see vtkMRMLStorageNode::CanReadDataDetached()) concurrently, then
+  /// sets the data into the nodes in order on the calling thread.
+  /// 0 (default) uses the vtkMultiThreader default number of threads,
+  /// 1 reads the files one after the other while updating the nodes.
+  vtkSetMacro(MaximumNumberOfReadThreads,int);
+  vtkGetMacro(MaximumNumberOfReadThreads,int);
+
   void SetErrorMessage(const std::string &error);
   std::string GetErrorMessage();
 
@@ -701,6 +745,9 @@ protected:
 
   typedef std::map< std::string, std::set<std::string> > NodeReferencesType;
 
+  /// Nodes sorted by their position (order key) in the \a Nodes collection.
+  typedef std::map< unsigned long, vtkMRMLNode* > NodeIndexType;
+
   vtkMRMLScene();
   virtual ~vtkMRMLScene();
 
@@ -710,6 +757,62 @@ protected:
   void CopyNodeInUndoStack(vtkMRMLNode *node);
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// State of the scene saved in the undo or redo stack.
+  /// Defined in the implementation file.
+  struct UndoStateType;
+
+  /// States of the undo or redo stack. The estimated memory size of the
+  /// states is updated when a state or a node copy is added or removed.
+  struct UndoStackType
+    {
+    UndoStackType() : MemorySize(0) {}
+    std::list< UndoStateType* > States;
+    /// Number of states using each node list, node copy and data object.
+    /// Shared objects are counted in MemorySize only once.
+    std::map< vtkObject*, int > ObjectUseCounts;
+    /// Estimated memory size of the states in bytes
+    size_t MemorySize;
+    };
+
+  /// Create a new state from the current scene. The list of nodes is shared
+  /// with the last state of \a stack if no node has been added or removed.
+  UndoStateType* CreateUndoState(const UndoStackType& stack);
+
+  /// Save a copy of \a node into the last state of \a stack. The copy saved in
+  /// the previous state is reused if the node has not been modified since.
+  void CopyNodeInStack(UndoStackType& stack, vtkMRMLNode *node);
+
+  /// Add \a state to the end of \a stack and update the stack memory size.
+  void PushState(UndoStackType& stack, UndoStateType* state);
+
+  /// Remove and delete the oldest (\a front is true) or most recent state of
+  /// \a stack and update the stack memory size.
+  void PopState(UndoStackType& stack, bool front);
+
+  /// Add or remove the memory size of a state and all of its node copies to
+  /// or from the stack memory size.
+  void UpdateStackMemorySize(UndoStackType& stack, UndoStateType* state, bool add);
+
+  /// Add or remove the memory size of the copy of \a node saved in \a state
+  /// (node properties and bulk data) to or from the stack memory size.
+  void UpdateStackNodeCopyMemorySize(UndoStackType& stack, UndoStateType* state, vtkMRMLNode* node, bool add);
+
+  /// Add or remove one use of \a object of \a size bytes. The size is added to
+  /// the stack memory size when the object is first used and removed when it is
+  /// not used by any state anymore.
+  void UpdateStackObjectMemorySize(UndoStackType& stack, vtkObject* object, size_t size, bool add);
+
+  /// Discard the oldest undo states until the number of levels and the
+  /// estimated memory size are within MaximumNumberOfUndoLevels and
+  /// MaximumUndoMemorySizeInMiB.
+  void TrimUndoStack();
+
+  /// Estimated memory size of the states of \a stack in bytes.
+  size_t GetStackMemorySize(const UndoStackType& stack) { return stack.MemorySize; }
+
+  /// Delete all the states of the stack.
+  void ClearStack(UndoStackType& stack);
+
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
   /// \warning Use with extreme caution as it might unsynchronize observer.
@@ -717,6 +820,15 @@ protected:
 
   void AddReferencedNodes(vtkMRMLNode *node, vtkCollection *refNodes);
 
+  /// Read concurrently the files of the storable nodes in \a nodes that
+  /// can be read detached. The data is attached to the nodes later by
+  /// vtkMRMLStorableNode::UpdateScene(). The files are read in batches,
+  /// the number of files read so far is reported after each batch with
+  /// ProgressState(ImportState, ...) on the calling thread.
+  /// Returns the storage nodes that were asked to read.
+  /// \sa MaximumNumberOfReadThreads, vtkMRMLStorageNode::ReadDataDetached()
+  std::vector<vtkSmartPointer<vtkMRMLStorageNode> > ReadDataDetached(vtkCollection* nodes);
+
   /// Handle vtkMRMLScene::DeleteEvent: clear the scene.
   static void SceneCallback( vtkObject *caller, unsigned long eid,
                              void *clientData, void *callData );
@@ -755,6 +867,55 @@ protected:
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
+  /// Return true if the class and name indices are in sync with the
+  /// \a Nodes collection.
+  bool AreNodeIndicesUpToDate();
+
+  /// \brief Synchronize the class and name indices used to speedup
+  /// GetNodesByClass() and GetNodesByName() methods with the \a Nodes
+  /// collection.
+  ///
+  /// Indices are rebuilt if they have been invalidated or if the \a Nodes
+  /// collection has been modified without updating them.
+  void UpdateNodeIndices();
+
+  /// Add node to the class and name indices. The node must have been appended
+  /// at the end of the \a Nodes collection and the indices must have been
+  /// up-to-date before it was appended (see AreNodeIndicesUpToDate()).
+  void AddNodeToIndices(vtkMRMLNode *node);
+
+  /// Remove node from the class and name indices. The indices must have been
+  /// up-to-date before the node was removed from the \a Nodes collection.
+  void RemoveNodeFromIndices(vtkMRMLNode *node);
+
+  /// \brief Clear the class and name indices.
+  ///
+  /// They are rebuilt the next time they are queried.
+  void InvalidateNodeIndices();
+
+  /// \brief Return the nodes of the scene that are of type \a className
+  /// (including subclasses), sorted by their position in the scene.
+  ///
+  /// The index for a class is created the first time it is requested and is
+  /// kept up-to-date when nodes are added to or removed from the scene.
+  const NodeIndexType& GetNodeClassIndex(const char* className);
+
+  /// \brief Same as GetNodeClassIndex() but in a vector, for constant time
+  /// access by position as in GetNthNodeByClass().
+  ///
+  /// The vector is created the first time it is requested, nodes appended to
+  /// the scene are appended to it and it is recreated after a node is removed.
+  const std::vector<vtkMRMLNode*>& GetNodeClassArray(const char* className);
+
+  /// \brief Return the nodes of the scene named \a name, sorted by their
+  /// position in the scene.
+  ///
+  /// Return 0 if no node has the given name.
+  const NodeIndexType* GetNodeNameIndex(const char* name);
+
+  /// Called by vtkMRMLNode::SetName() to keep the name index in sync.
+  void UpdateNodeName(vtkMRMLNode* node, const char* oldName);
+
   vtkCollection*  Nodes;
 
   /// data i/o handling members
@@ -765,12 +926,13 @@ protected:
 
   std::vector<unsigned long> States;
 
-  int  UndoStackSize;
+  int  MaximumNumberOfUndoLevels;
+  double MaximumUndoMemorySizeInMiB;
   bool UndoFlag;
   bool InUndo;
 
-  std::list< vtkCollection* >  UndoStack;
-  std::list< vtkCollection* >  RedoStack;
+  UndoStackType UndoStack;
+  UndoStackType RedoStack;
 
   std::string                 URL;
   std::string                 RootDirectory;
@@ -786,6 +948,17 @@ protected:
   std::map< std::string, std::string > ReferencedIDChanges;
   std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
 
+  // Indices used to speedup GetNodesByClass() and GetNodesByName() methods.
+  // Each node in the scene is given an increasing order key so that the
+  // indexed nodes can be returned in the same order as in the Nodes collection.
+  std::map< vtkMRMLNode*, unsigned long > NodeOrderKeys;
+  std::map< std::string, NodeIndexType > NodeClassIndices;
+  std::map< std::string, std::vector<vtkMRMLNode*> > NodeClassArrays;
+  std::map< std::string, NodeIndexType > NodeNameIndices;
+  unsigned long NextNodeOrderKey;
+  // 0 if the indices are invalid and must be rebuilt
+  vtkMTimeType NodeIndicesMTime;
+
   // Stores default nodes. If a class is created or reset (using CreateNodeByClass or Clear) and
   // a default node is defined for it then the content of the default node will be used to initialize
   // the class. It is useful for overriding default values that are set in a node's constructor.
@@ -801,6 +974,8 @@ protected:
 
   int ReadDataOnLoad;
 
+  int MaximumNumberOfReadThreads;
+
   vtkMTimeType  NodeIDsMTime;
 
   void RemoveAllNodes(bool removeSingletons);
@@ -214,6 +214,7 @@ void vtkMRMLSceneViewNode::ProcessChildNode(vtkMRMLNode *node)
   this->SnapshotScene->GetNodes()->vtkCollection::AddItem((vtkObject *)node);
 
   this->SnapshotScene->AddNodeID(node);
+  this->SnapshotScene->InvalidateNodeIndices();
 
   node->SetScene(this->SnapshotScene);
 
@@ -242,6 +243,7 @@ void vtkMRMLSceneViewNode::Copy(vtkMRMLNode *anode)
     {
     this->SnapshotScene->GetNodes()->RemoveAllItems();
     this->SnapshotScene->ClearNodeIDs();
+    this->SnapshotScene->InvalidateNodeIndices();
     }
   vtkMRMLNode *node = NULL;
   if ( snode->SnapshotScene != NULL )
@@ -600,9 +600,13 @@ bool vtkMRMLSegmentationNode::GenerateMergedLabelmap(
       continue;
       }
 
-    // Get binary labelmap from segment
-    vtkOrientedImageData* representationBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
-      currentSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    // Get binary labelmap from segment (without splitting it out of a shared labelmap layer)
+    vtkSmartPointer<vtkOrientedImageData> representationBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!this->Segmentation->GetSegmentBinaryLabelmap(currentSegmentId, representationBinaryLabelmap))
+      {
+      vtkWarningMacro("GenerateMergedLabelmap: Binary labelmap not found in segment: " << currentSegmentId);
+      continue;
+      }
     // If binary labelmap is empty then skip
     if (representationBinaryLabelmap->IsEmpty())
       {
@@ -833,7 +837,8 @@ vtkOrientedImageData* vtkMRMLSegmentationNode::GetBinaryLabelmapRepresentation(c
     vtkErrorMacro("GetBinaryLabelmapRepresentation: Invalid segment");
     return NULL;
     }
-  return vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  return vtkOrientedImageData::SafeDownCast(this->Segmentation->GetSegmentRepresentation(
+    segmentId, vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
 }
 
 //---------------------------------------------------------------------------
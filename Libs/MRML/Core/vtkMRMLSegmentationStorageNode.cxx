@@ -51,6 +51,7 @@
 #include <vtkTransform.h>
 #include <vtkXMLMultiBlockDataWriter.h>
 #include <vtkXMLMultiBlockDataReader.h>
+#include <vtkZLibDataCompressor.h>
 #include <vtksys/SystemTools.hxx>
 
 #ifdef SUPPORT_4D_SPATIAL_NRRD
@@ -480,6 +481,9 @@ int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation4DSpatial(vt
   // Create contained representations now that all the data is loaded
   this->CreateRepresentationsBySerializedNames(segmentation, containedRepresentationNames);
 
+  // Store loaded labelmaps in shared labelmap layers if requested
+  segmentation->CollapseBinaryLabelmaps();
+
   return 1;
 }
 #endif // SUPPORT_4D_SPATIAL_NRRD
@@ -767,6 +771,9 @@ int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation(vtkMRMLSegm
   // Create contained representations now that all the data is loaded
   this->CreateRepresentationsBySerializedNames(segmentation, containedRepresentationNames);
 
+  // Store loaded labelmaps in shared labelmap layers if requested
+  segmentation->CollapseBinaryLabelmaps();
+
   return 1;
 }
 
@@ -1031,6 +1038,7 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
   vtkNew<vtkTeemNRRDWriter> writer;
   writer->SetFileName(fullName.c_str());
   writer->SetUseCompression(this->GetUseCompression());
+  writer->SetCompressionLevel(this->GetCompressionLevel());
 
   // Create metadata dictionary
 
@@ -1075,10 +1083,10 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
     std::string currentSegmentID = *segmentIdIt;
     vtkSegment* currentSegment = segmentation->GetSegment(*segmentIdIt);
 
-    // Get master representation from segment
-    vtkSmartPointer<vtkOrientedImageData> currentBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
-      currentSegment->GetRepresentation(segmentationNode->GetSegmentation()->GetMasterRepresentationName()));
-    if (!currentBinaryLabelmap)
+    // Get master representation from segment. Labelmaps stored in shared labelmap layers are
+    // extracted into a temporary image so that the layers are kept intact.
+    vtkSmartPointer<vtkOrientedImageData> currentBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!segmentation->GetSegmentBinaryLabelmap(currentSegmentID, currentBinaryLabelmap))
       {
       vtkErrorMacro("WriteBinaryLabelmapRepresentation: Failed to retrieve master representation from segment " << currentSegmentID);
       continue;
@@ -1305,6 +1313,11 @@ int vtkMRMLSegmentationStorageNode::WritePolyDataRepresentation(vtkMRMLSegmentat
     {
     writer->SetDataModeToBinary();
     writer->SetCompressorTypeToZLib();
+    vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::SafeDownCast(writer->GetCompressor());
+    if (compressor && this->GetCompressionLevel() >= 0)
+      {
+      compressor->SetCompressionLevel(this->GetCompressionLevel());
+      }
     }
   else
     {
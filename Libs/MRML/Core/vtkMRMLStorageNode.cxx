@@ -46,6 +46,7 @@ vtkMRMLStorageNode::vtkMRMLStorageNode()
   this->URI = NULL;
   this->URIHandler = NULL;
   this->UseCompression = 1;
+  this->CompressionLevel = -1;
   this->ReadState = this->Idle;
   this->WriteState = this->Idle;
   this->URIHandler = NULL;
@@ -56,6 +57,10 @@ vtkMRMLStorageNode::vtkMRMLStorageNode()
   this->SupportedWriteFileTypes = vtkStringArray::New();
   this->WriteFileFormat = NULL;
   this->StoredTime = vtkTimeStamp::New();
+  this->DetachedDataNode = NULL;
+  this->DetachedReadResult = 0;
+  this->DetachedWriteNode = NULL;
+  this->DetachedWriteResult = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -184,6 +189,10 @@ void vtkMRMLStorageNode::WriteXML(ostream& of, int nIndent)
   std::stringstream ss;
   ss << this->UseCompression;
   of << " useCompression=\"" << ss.str() << "\"";
+  if (this->CompressionLevel >= 0)
+    {
+    of << " compressionLevel=\"" << this->CompressionLevel << "\"";
+    }
 
   if (this->GetDefaultWriteFileExtension() != NULL)
     {
@@ -304,6 +313,14 @@ void vtkMRMLStorageNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->UseCompression;
       }
+    else if (!strcmp(attName, "compressionLevel"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int compressionLevel = -1;
+      ss >> compressionLevel;
+      this->SetCompressionLevel(compressionLevel);
+      }
     else if (!strcmp(attName, "readState"))
       {
       std::stringstream ss;
@@ -339,6 +356,7 @@ void vtkMRMLStorageNode::Copy(vtkMRMLNode *anode)
     this->AddURI(node->GetNthURI(i));
     }
   this->SetUseCompression(node->UseCompression);
+  this->SetCompressionLevel(node->CompressionLevel);
   this->SetReadState(node->ReadState);
   this->SetWriteState(node->WriteState);
   this->SetDefaultWriteFileExtension(node->GetDefaultWriteFileExtension());
@@ -365,6 +383,7 @@ void vtkMRMLStorageNode::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << "URIListMember: " << this->GetNthURI(i) << "\n";
     }
   os << indent << "UseCompression:   " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
   os << indent << "ReadState:  " << this->GetReadStateAsString() << "\n";
   os << indent << "WriteState: " << this->GetWriteStateAsString() << "\n";
   os << indent << "SupportedWriteFileTypes: \n";
@@ -1181,7 +1200,25 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
   vtkDebugMacro("ReadData: read state is ready, "
     <<  "URI = " << (this->GetURI() == NULL ? "null" : this->GetURI()) << ", "
     << "filename = " << (this->GetFileName() == NULL ? "null" : this->GetFileName()));
-  int res = this->ReadDataInternal(refNode);
+  int res = 0;
+  if (this->DetachedDataNode == refNode)
+    {
+    // the file has already been read by ReadDataDetached()
+    if (this->DetachedReadResult)
+      {
+      res = this->AttachDetachedDataInternal(refNode);
+      }
+    else
+      {
+      vtkErrorMacro(<< this->DetachedReadMessage);
+      }
+    this->ClearDetachedData();
+    }
+  else
+    {
+    this->ClearDetachedData();
+    res = this->ReadDataInternal(refNode);
+    }
   if (res)
     {
     vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(refNode);
@@ -1199,21 +1236,81 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
 }
 
 //------------------------------------------------------------------------------
-int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
+bool vtkMRMLStorageNode::CanReadDataDetached(vtkMRMLNode* refNode)
 {
+  // same conditions as ReadData(), remote files must be downloaded first
+  return refNode != NULL
+    && refNode->GetAddToScene()
+    && this->CanReadInReferenceNode(refNode)
+    && !(this->GetScene() && this->GetScene()->GetReadDataOnLoad() == 0)
+    && this->GetFileName() != NULL
+    && this->GetURI() == NULL
+    && this->CanReadDataDetachedInternal(refNode);
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::ReadDataDetached(vtkMRMLNode* refNode)
+{
+  this->ClearDetachedData();
   if (refNode == NULL)
     {
-    vtkErrorMacro("WriteData: can't write, input node is null");
     return 0;
     }
+  int res = this->ReadDataDetachedInternal(refNode);
+  // a failure without error message is retried by ReadData()
+  if (res || !this->DetachedReadMessage.empty())
+    {
+    this->DetachedDataNode = refNode;
+    this->DetachedReadResult = res;
+    }
+  else
+    {
+    this->ClearDetachedData();
+    }
+  return res;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::HasDetachedData()
+{
+  return this->DetachedDataNode != NULL;
+}
 
-  // test whether refNode is a valid node to hold a volume
-  if (!this->CanWriteFromReferenceNode(refNode) )
+//------------------------------------------------------------------------------
+void vtkMRMLStorageNode::ClearDetachedData()
+{
+  this->DetachedDataNode = NULL;
+  this->DetachedReadResult = 0;
+  this->DetachedReadMessage.clear();
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
+{
+  if (refNode == NULL)
     {
+    vtkErrorMacro("WriteData: can't write, input node is null");
     return 0;
     }
 
-  int res = this->WriteDataInternal(refNode);
+  int res = 0;
+  if (this->DetachedWriteNode == refNode)
+    {
+    // the data has already been written by WriteDataDetached()
+    res = this->CompleteWriteDataDetachedInternal(refNode);
+    this->DetachedWriteNode = NULL;
+    this->ClearDetachedWriteData();
+    }
+  else
+    {
+    this->DetachedWriteNode = NULL;
+    // test whether refNode is a valid node to hold a volume
+    if (!this->CanWriteFromReferenceNode(refNode) )
+      {
+      return 0;
+      }
+    res = this->WriteDataInternal(refNode);
+    }
 
   if (res)
     {
@@ -1224,6 +1321,42 @@ int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
   return res;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanWriteDataDetached(vtkMRMLNode* refNode)
+{
+  // remote files are uploaded by WriteData() on the main thread
+  return refNode != NULL
+    && this->CanWriteFromReferenceNode(refNode)
+    && this->GetFileName() != NULL
+    && (this->GetURI() == NULL || this->GetURI()[0] == '\0')
+    && this->CanWriteDataDetachedInternal(refNode);
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::PrepareWriteDataDetached(vtkMRMLNode* refNode)
+{
+  this->DetachedWriteNode = NULL;
+  this->ClearDetachedWriteData();
+  if (!this->CanWriteDataDetached(refNode))
+    {
+    return 0;
+    }
+  return this->PrepareWriteDataDetachedInternal(refNode);
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::WriteDataDetached(vtkMRMLNode* refNode)
+{
+  this->DetachedWriteNode = NULL;
+  if (refNode == NULL)
+    {
+    return 0;
+    }
+  this->DetachedWriteResult = this->WriteDataDetachedInternal(refNode);
+  this->DetachedWriteNode = refNode;
+  return this->DetachedWriteResult;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::ReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
 {
@@ -1236,6 +1369,53 @@ int vtkMRMLStorageNode::WriteDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
   return 0;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanReadDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return false;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::ReadDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::AttachDetachedDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanWriteDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return false;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::PrepareWriteDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::WriteDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  return this->WriteDataInternal(refNode);
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::CompleteWriteDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return this->DetachedWriteResult;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLStorageNode::ClearDetachedWriteData()
+{
+}
+
 //------------------------------------------------------------------------------
 std::string vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(const std::string& filename)
 {
@@ -51,12 +51,69 @@ public:
   /// \sa SetFileName(), ReadDataInternal(), GetStoredTime()
   virtual int ReadData(vtkMRMLNode *refNode, bool temporaryFile = false);
 
+  ///
+  /// Return true if ReadDataDetached() can be used to read the file of
+  /// \a refNode: the storage node supports it, the file is local and
+  /// ReadData() would read it.
+  /// \sa ReadDataDetached()
+  bool CanReadDataDetached(vtkMRMLNode *refNode);
+
+  ///
+  /// Read the file without modifying \a refNode nor invoking any event.
+  /// The data is kept by the storage node and attached to \a refNode by
+  /// the next call to ReadData(), which then does not read the file again.
+  /// Unlike ReadData(), this method can be called from a worker thread,
+  /// concurrently with the other storage nodes of the scene.
+  /// Errors are not reported by this method: if reading fails, ReadData()
+  /// reports the error message set in DetachedReadMessage, or reads the file
+  /// again the usual way if there is none.
+  /// Return 1 on success, 0 on failure.
+  /// \sa CanReadDataDetached(), ClearDetachedData(), vtkMRMLScene::Import()
+  int ReadDataDetached(vtkMRMLNode *refNode);
+
+  ///
+  /// Return true if data (or the error) read by ReadDataDetached() is
+  /// waiting to be attached to (or reported for) its reference node.
+  bool HasDetachedData();
+
+  ///
+  /// Release data read by ReadDataDetached() that has not been attached.
+  virtual void ClearDetachedData();
+
   ///
   /// Write data from a  referenced node
+  /// If the data has already been written by WriteDataDetached() for
+  /// \a refNode, that write is completed instead.
   /// Return 1 on success, 0 on failure.
   /// NOTE: Subclasses should implement this method
   virtual int WriteData(vtkMRMLNode *refNode);
 
+  ///
+  /// Return true if WriteDataDetached() can be used to write the data of
+  /// \a refNode: the storage node supports it for the current file name
+  /// and the file is local.
+  /// \sa WriteDataDetached()
+  bool CanWriteDataDetached(vtkMRMLNode *refNode);
+
+  ///
+  /// Keep a shallow copy of the data of \a refNode for WriteDataDetached(),
+  /// so that the writers never share a pipeline with the scene or with each
+  /// other. Must be called on the main thread, before WriteDataDetached().
+  /// Return 1 on success, 0 on failure.
+  /// \sa WriteDataDetached()
+  int PrepareWriteDataDetached(vtkMRMLNode *refNode);
+
+  ///
+  /// Write the data kept by PrepareWriteDataDetached() without modifying
+  /// \a refNode, the scene nor invoking any event. Unlike WriteData(), this
+  /// method can be called from a worker thread, concurrently with the other
+  /// storage nodes of the scene. The next call to WriteData() for \a refNode
+  /// does not write the data again but completes the write on the main
+  /// thread: file list, error reporting, write state and stored time.
+  /// Return 1 on success, 0 on failure.
+  /// \sa CanWriteDataDetached(), vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory()
+  int WriteDataDetached(vtkMRMLNode *refNode);
+
   ///
   /// Write this node's information to a MRML file in XML format.
   virtual void WriteXML(ostream& of, int indent) VTK_OVERRIDE;
@@ -91,6 +148,14 @@ public:
   vtkGetMacro(UseCompression, int);
   vtkSetMacro(UseCompression, int);
 
+  ///
+  /// Compression level used on write when UseCompression is on,
+  /// from 0 (fastest) to 9 (smallest files).
+  /// -1 (default) uses the default level of the writer.
+  /// Not all the writers support it.
+  vtkSetClampMacro(CompressionLevel, int, -1, 9);
+  vtkGetMacro(CompressionLevel, int);
+
   ///
   /// Location of the remote copy of this file.
   vtkSetStringMacro(URI);
@@ -318,6 +383,48 @@ protected:
   /// To be reimplemented in subclass.
   virtual int WriteDataInternal(vtkMRMLNode* refNode);
 
+  /// Return true if the subclass implements ReadDataDetachedInternal()
+  /// and AttachDetachedDataInternal() for \a refNode.
+  /// Returns false by default.
+  virtual bool CanReadDataDetachedInternal(vtkMRMLNode* refNode);
+
+  /// Read the file into members of the storage node. Must not modify
+  /// \a refNode, the scene, nor invoke events as it is called from worker
+  /// threads. Returns 1 on success, 0 otherwise: errors must be set in
+  /// DetachedReadMessage to be reported later on the main thread.
+  /// To be reimplemented in subclass with ClearDetachedData().
+  virtual int ReadDataDetachedInternal(vtkMRMLNode* refNode);
+
+  /// Set the data read by ReadDataDetachedInternal() in \a refNode, the
+  /// same way ReadDataInternal() would. Returns 1 on success, 0 otherwise.
+  /// To be reimplemented in subclass.
+  virtual int AttachDetachedDataInternal(vtkMRMLNode* refNode);
+
+  /// Return true if WriteDataDetachedInternal() can write \a refNode.
+  /// Returns false by default.
+  virtual bool CanWriteDataDetachedInternal(vtkMRMLNode* refNode);
+
+  /// Copy the data of \a refNode into members of the storage node for
+  /// WriteDataDetachedInternal(). Called on the main thread.
+  /// Returns 1 by default. To be reimplemented in subclass with
+  /// ClearDetachedWriteData().
+  virtual int PrepareWriteDataDetachedInternal(vtkMRMLNode* refNode);
+
+  /// Write the data copied by PrepareWriteDataDetachedInternal(). Must not
+  /// modify \a refNode, the scene, nor invoke events (no vtkErrorMacro) as it
+  /// is called from worker threads.
+  /// Returns WriteDataInternal() by default, subclasses must reimplement it
+  /// if WriteDataInternal() does not meet these requirements.
+  virtual int WriteDataDetachedInternal(vtkMRMLNode* refNode);
+
+  /// Complete on the main thread the write done by
+  /// WriteDataDetachedInternal(), e.g. report its errors.
+  /// Returns DetachedWriteResult by default.
+  virtual int CompleteWriteDataDetachedInternal(vtkMRMLNode* refNode);
+
+  /// Release the data copied by PrepareWriteDataDetachedInternal().
+  virtual void ClearDetachedWriteData();
+
   ///
   /// If the URI is not null, fetch it and save it to the node's FileName location or
   /// load directly into the reference node.
@@ -333,6 +440,7 @@ protected:
   char *URI;
   vtkURIHandler *URIHandler;
   int UseCompression;
+  int CompressionLevel;
   int ReadState;
   int WriteState;
 
@@ -363,6 +471,20 @@ protected:
   /// Can be reset with InvalidateFile.
   /// \sa InvalidateFile
   vtkTimeStamp* StoredTime;
+
+  /// Node the data read by ReadDataDetached() is for, NULL if there is
+  /// no detached data.
+  vtkMRMLNode* DetachedDataNode;
+  /// Value returned by ReadDataDetachedInternal() for DetachedDataNode
+  int DetachedReadResult;
+  /// Error of ReadDataDetachedInternal(), reported by ReadData() on the
+  /// main thread. To be set by subclasses instead of calling vtkErrorMacro.
+  std::string DetachedReadMessage;
+
+  /// Node the file was written for by WriteDataDetached(), NULL if none.
+  vtkMRMLNode* DetachedWriteNode;
+  /// Value returned by WriteDataDetachedInternal() for DetachedWriteNode
+  int DetachedWriteResult;
 };
 
 #endif
@@ -31,6 +31,7 @@
 
 // VTK includes
 #include <vtkCollection.h>
+#include <vtkIdList.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
@@ -79,6 +80,9 @@ public:
   vtkSubjectHierarchyItem* Parent;
   /// Ordered list of children
   ChildVector Children;
+  /// Position of the item in the children list of its parent. Only a hint that speeds up
+  /// finding the item under its parent, it is validated and rebuilt on use (\sa GetPositionUnderParent)
+  int PositionUnderParentHint;
 
   /// Name of the owner plugin that claimed this node
   std::string OwnerPluginName;
@@ -106,6 +110,18 @@ public:
   /// Item cache to speed up lookup by ID that needs to be performed many times.
   /// It can be static as the item IDs are unique in one application session.
   static std::map<vtkIdType, vtkSubjectHierarchyItem*> ItemCache;
+  /// Item cache to speed up lookup by data node (e.g. when the data node is modified, or a new node is added).
+  /// Contains all items in the tree that have a data node. Multiple items may be associated to the same data node
+  /// if they are in different subject hierarchies. Can be static for the same reason as \sa ItemCache
+  static std::multimap<vtkMRMLNode*, vtkSubjectHierarchyItem*> DataNodeCache;
+  /// Data node pointer that was used as key when adding this item to \sa DataNodeCache.
+  /// Stored because the data node may be deleted (and the weak pointer reset) before the item.
+  vtkMRMLNode* DataNodeCacheKey;
+
+  /// Add item to data node cache if it has a data node
+  void AddToDataNodeCache();
+  /// Remove item from data node cache
+  void RemoveFromDataNodeCache();
 
 // Get/set functions
 public:
@@ -148,6 +164,8 @@ public:
 
 // Child related functions
 public:
+  /// Determine whether this item is in the branch of a given item (or is the given item)
+  bool IsInBranch(vtkSubjectHierarchyItem* branchItem);
   /// Determine whether this item has any children
   bool HasChildren();
   /// Determine whether this item is the parent of a virtual branch
@@ -199,6 +217,9 @@ public:
   /// Get position of item under its parent
   /// \return Position of item under its parent. -1 on failure.
   int GetPositionUnderParent();
+  /// Find iterator of a direct child item in the children list.
+  /// \return End iterator of the children list if the item is not a direct child of this item
+  ChildVector::iterator FindChildIterator(vtkSubjectHierarchyItem* childItem);
   /// Get child item by position
   /// \return ID of child item found in given position. Invalid if no item found at that position
   vtkIdType GetChildByPositionUnderParent(int position);
@@ -248,6 +269,7 @@ vtkStandardNewMacro(vtkSubjectHierarchyItem);
 vtkIdType vtkSubjectHierarchyItem::NextSubjectHierarchyItemID = vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID + 1;
 
 std::map<vtkIdType, vtkSubjectHierarchyItem*> vtkSubjectHierarchyItem::ItemCache = std::map<vtkIdType, vtkSubjectHierarchyItem*>();
+std::multimap<vtkMRMLNode*, vtkSubjectHierarchyItem*> vtkSubjectHierarchyItem::DataNodeCache = std::multimap<vtkMRMLNode*, vtkSubjectHierarchyItem*>();
 
 //---------------------------------------------------------------------------
 // vtkSubjectHierarchyItem methods
@@ -258,6 +280,8 @@ vtkSubjectHierarchyItem::vtkSubjectHierarchyItem()
   , DataNode(NULL)
   , Name("")
   , Parent(NULL)
+  , PositionUnderParentHint(-1)
+  , DataNodeCacheKey(NULL)
   , OwnerPluginName("")
   , Expanded(true)
   , TemporaryID(vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
@@ -273,11 +297,46 @@ vtkSubjectHierarchyItem::vtkSubjectHierarchyItem()
 vtkSubjectHierarchyItem::~vtkSubjectHierarchyItem()
 {
   this->RemoveAllChildren();
+  this->RemoveFromDataNodeCache();
 
   this->Attributes.clear();
   this->UIDs.clear();
 }
 
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::AddToDataNodeCache()
+{
+  vtkMRMLNode* dataNode = this->DataNode.GetPointer();
+  if (!dataNode || this->DataNodeCacheKey == dataNode)
+    {
+    return;
+    }
+  this->RemoveFromDataNodeCache();
+  vtkSubjectHierarchyItem::DataNodeCache.insert(std::make_pair(dataNode, this));
+  this->DataNodeCacheKey = dataNode;
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::RemoveFromDataNodeCache()
+{
+  if (!this->DataNodeCacheKey)
+    {
+    return;
+    }
+  typedef std::multimap<vtkMRMLNode*, vtkSubjectHierarchyItem*>::iterator DataNodeCacheIterator;
+  std::pair<DataNodeCacheIterator, DataNodeCacheIterator> itemRange =
+    vtkSubjectHierarchyItem::DataNodeCache.equal_range(this->DataNodeCacheKey);
+  for (DataNodeCacheIterator itemIt = itemRange.first; itemIt != itemRange.second; ++itemIt)
+    {
+    if (itemIt->second == this)
+      {
+      vtkSubjectHierarchyItem::DataNodeCache.erase(itemIt);
+      break;
+      }
+    }
+  this->DataNodeCacheKey = NULL;
+}
+
 //---------------------------------------------------------------------------
 vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, vtkMRMLNode* dataNode)
 {
@@ -300,9 +359,11 @@ vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, vt
     // Add under parent
     vtkSmartPointer<vtkSubjectHierarchyItem> childPointer(this);
     this->Parent->Children.push_back(childPointer);
+    this->PositionUnderParentHint = static_cast<int>(this->Parent->Children.size()) - 1;
 
     // Add to cache
     vtkSubjectHierarchyItem::ItemCache[this->ID] = this;
+    this->AddToDataNodeCache();
     }
   else
     {
@@ -337,6 +398,7 @@ vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, st
     // Add under parent
     vtkSmartPointer<vtkSubjectHierarchyItem> childPointer(this);
     this->Parent->Children.push_back(childPointer);
+    this->PositionUnderParentHint = static_cast<int>(this->Parent->Children.size()) - 1;
 
     // Add to cache
     vtkSubjectHierarchyItem::ItemCache[this->ID] = this;
@@ -747,24 +809,36 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByDataNode(vtkMRMLNod
     return NULL;
     }
 
-  ChildVector::iterator childIt;
-  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
+  // All items in the tree that have a data node are in the cache, so it is not necessary to traverse the tree.
+  // Items of other subject hierarchies may reference the same data node, so only accept items in this branch.
+  // The data node of an item cannot change, but the item may have been added to the cache with a deleted node
+  // whose address is now used by the given data node, so the data node is also checked.
+  typedef std::multimap<vtkMRMLNode*, vtkSubjectHierarchyItem*>::iterator DataNodeCacheIterator;
+  std::pair<DataNodeCacheIterator, DataNodeCacheIterator> itemRange =
+    vtkSubjectHierarchyItem::DataNodeCache.equal_range(dataNode);
+  for (DataNodeCacheIterator itemIt = itemRange.first; itemIt != itemRange.second; ++itemIt)
     {
-    vtkSubjectHierarchyItem* currentItem = childIt->GetPointer();
-    if (dataNode == currentItem->DataNode.GetPointer())
+    vtkSubjectHierarchyItem* cachedItem = itemIt->second;
+    if ( cachedItem != this && cachedItem->DataNode.GetPointer() == dataNode
+      && (recursive ? cachedItem->IsInBranch(this) : cachedItem->Parent == this) )
       {
-      return currentItem;
+      return cachedItem;
       }
-    if (recursive)
+    }
+  return NULL;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSubjectHierarchyItem::IsInBranch(vtkSubjectHierarchyItem* branchItem)
+{
+  for (vtkSubjectHierarchyItem* currentItem = this; currentItem; currentItem = currentItem->Parent)
+    {
+    if (currentItem == branchItem)
       {
-      vtkSubjectHierarchyItem* foundItemInBranch = currentItem->FindChildByDataNode(dataNode);
-      if (foundItemInBranch)
-        {
-        return foundItemInBranch;
-        }
+      return true;
       }
     }
-  return NULL;
+  return false;
 }
 
 //---------------------------------------------------------------------------
@@ -940,14 +1014,7 @@ bool vtkSubjectHierarchyItem::Reparent(vtkSubjectHierarchyItem* newParentItem)
     }
 
   // Remove item from former parent
-  vtkSubjectHierarchyItem::ChildVector::iterator childIt;
-  for (childIt=formerParentItem->Children.begin(); childIt!=formerParentItem->Children.end(); ++childIt)
-    {
-    if (this == childIt->GetPointer())
-      {
-      break;
-      }
-    }
+  vtkSubjectHierarchyItem::ChildVector::iterator childIt = formerParentItem->FindChildIterator(this);
   if (childIt == formerParentItem->Children.end())
     {
     vtkErrorMacro("Reparent: Subject hierarchy item '" << this->GetName() << "' not found under item '" << formerParentItem->GetName() << "'");
@@ -963,6 +1030,7 @@ bool vtkSubjectHierarchyItem::Reparent(vtkSubjectHierarchyItem* newParentItem)
   // Add item to new parent
   this->Parent = newParentItem;
   newParentItem->Children.push_back(thisPointer);
+  this->PositionUnderParentHint = static_cast<int>(newParentItem->Children.size()) - 1;
 
   // Invoke modified events on all affected items
   formerParentItem->Modified();
@@ -987,14 +1055,7 @@ bool vtkSubjectHierarchyItem::Move(vtkSubjectHierarchyItem* beforeItem)
     }
 
   // Remove item from parent
-  ChildVector::iterator removedIt;
-  for (removedIt=this->Parent->Children.begin(); removedIt!=this->Parent->Children.end(); ++removedIt)
-    {
-    if (this == removedIt->GetPointer())
-      {
-      break;
-      }
-    }
+  ChildVector::iterator removedIt = this->Parent->FindChildIterator(this);
   if (removedIt == this->Parent->Children.end())
     {
     vtkErrorMacro("Move: Failed to find subject hierarchy item '" << this->GetName()
@@ -1015,14 +1076,7 @@ bool vtkSubjectHierarchyItem::Move(vtkSubjectHierarchyItem* beforeItem)
     return true;
     }
 
-  ChildVector::iterator beforeIt;
-  for (beforeIt=this->Parent->Children.begin(); beforeIt!=this->Parent->Children.end(); ++beforeIt)
-    {
-    if (beforeItem == beforeIt->GetPointer())
-      {
-      break;
-      }
-    }
+  ChildVector::iterator beforeIt = this->Parent->FindChildIterator(beforeItem);
   if (beforeIt == this->Parent->Children.end())
     {
     vtkErrorMacro("Move: Failed to find subject hierarchy item '" << beforeItem->GetName()
@@ -1044,31 +1098,53 @@ int vtkSubjectHierarchyItem::GetPositionUnderParent()
     return 0;
     }
 
-  int position = 0;
+  ChildVector::iterator childIt = this->Parent->FindChildIterator(this);
+  if (childIt == this->Parent->Children.end())
+    {
+    // Failed to find item
+    vtkErrorMacro("GetPositionUnderParent: Failed to find subject hierarchy item " << this->Name << " under its parent");
+    return -1;
+    }
+  return static_cast<int>(childIt - this->Parent->Children.begin());
+}
+
+//---------------------------------------------------------------------------
+vtkSubjectHierarchyItem::ChildVector::iterator vtkSubjectHierarchyItem::FindChildIterator(vtkSubjectHierarchyItem* childItem)
+{
+  if (!childItem || childItem->Parent != this)
+    {
+    return this->Children.end();
+    }
+
+  // Position hint is valid unless children were inserted or removed before the item since it was set
+  int position = childItem->PositionUnderParentHint;
+  if ( position >= 0 && position < static_cast<int>(this->Children.size())
+    && this->Children[position].GetPointer() == childItem )
+    {
+    return this->Children.begin() + position;
+    }
+
+  // Rebuild position hints of all children, so that subsequent lookups of siblings are fast
+  ChildVector::iterator foundIt = this->Children.end();
+  position = 0;
   ChildVector::iterator childIt;
-  for (childIt=this->Parent->Children.begin(); childIt!=this->Parent->Children.end(); ++childIt, ++position)
+  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt, ++position)
     {
-    if (childIt->GetPointer() == this)
+    (*childIt)->PositionUnderParentHint = position;
+    if (childIt->GetPointer() == childItem)
       {
-      return position;
+      foundIt = childIt;
       }
     }
-  // Failed to find item
-  vtkErrorMacro("GetPositionUnderParent: Failed to find subject hierarchy item " << this->Name << " under its parent");
-  return -1;
+  return foundIt;
 }
 
 //---------------------------------------------------------------------------
 vtkIdType vtkSubjectHierarchyItem::GetChildByPositionUnderParent(int position)
 {
-  int currentPosition = 0;
-  ChildVector::iterator childIt;
-  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt, ++currentPosition)
+  if (position >= 0 && position < static_cast<int>(this->Children.size()))
     {
-    if (currentPosition == position)
-      {
-      return childIt->GetPointer()->ID;
-      }
+    return this->Children[position]->ID;
     }
   // Failed to find item
   vtkErrorMacro("GetChildByPositionUnderParent: Failed to find subject hierarchy item under parent " << this->Name << " at position " << position);
@@ -1084,14 +1160,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkSubjectHierarchyItem* item)
     return false;
     }
 
-  ChildVector::iterator childIt;
-  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
-    {
-    if (item == childIt->GetPointer())
-      {
-      break;
-      }
-    }
+  ChildVector::iterator childIt = this->FindChildIterator(item);
   if (childIt == this->Children.end())
     {
     vtkErrorMacro("RemoveChild: Subject hierarchy item '" << item->GetName() << "' not found in item '" << this->GetName() << "'");
@@ -1117,6 +1186,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkSubjectHierarchyItem* item)
 
   // Remove from cache
   vtkSubjectHierarchyItem::ItemCache.erase(removedItem->ID);
+  removedItem->RemoveFromDataNodeCache();
 
   // Invoke events
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, item);
@@ -1128,12 +1198,21 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkSubjectHierarchyItem* item)
 //---------------------------------------------------------------------------
 bool vtkSubjectHierarchyItem::RemoveChild(vtkIdType itemID)
 {
-  ChildVector::iterator childIt;
-  for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
+  ChildVector::iterator childIt = this->Children.end();
+  std::map<vtkIdType, vtkSubjectHierarchyItem*>::iterator itemIt = vtkSubjectHierarchyItem::ItemCache.find(itemID);
+  if (itemIt != vtkSubjectHierarchyItem::ItemCache.end())
     {
-    if (itemID == (*childIt)->ID)
+    childIt = this->FindChildIterator(itemIt->second);
+    }
+  else
+    {
+    // Items that are not in the tree (e.g. unresolved items) are not in the cache
+    for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
       {
-      break;
+      if (itemID == (*childIt)->ID)
+        {
+        break;
+        }
       }
     }
   if (childIt == this->Children.end())
@@ -1161,6 +1240,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkIdType itemID)
 
   // Remove from cache
   vtkSubjectHierarchyItem::ItemCache.erase(removedItem->ID);
+  removedItem->RemoveFromDataNodeCache();
 
   // Invoke events
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, removedItem.GetPointer());
@@ -1449,6 +1529,13 @@ public:
   /// Flag indicating whether resolving unresolved items is underway (after scene import or restore)
   bool IsResolving;
 
+  /// Nesting level of item batch modifications \sa StartItemBatchModify
+  int ItemBatchModifyCount;
+  /// IDs of items added or modified during the current item batch modification
+  std::set<vtkIdType> ItemBatchModifiedItemIDs;
+  /// Flag indicating that the node needs to be marked modified after the current item batch modification
+  bool ItemBatchModifyNodeModifiedPending;
+
 private:
   vtkMRMLSubjectHierarchyNode* External;
 };
@@ -1460,6 +1547,8 @@ private:
 vtkMRMLSubjectHierarchyNode::vtkInternal::vtkInternal(vtkMRMLSubjectHierarchyNode* external)
 : EventsDisabled(false)
 , IsResolving(false)
+, ItemBatchModifyCount(0)
+, ItemBatchModifyNodeModifiedPending(false)
 , External(external)
 {
   // Create scene item
@@ -1519,6 +1608,8 @@ bool vtkMRMLSubjectHierarchyNode::vtkInternal::ResolveUnresolvedItems()
   // Indicate that resolving unresolved items is underway
   bool wasResolving = this->IsResolving;
   this->IsResolving = true;
+  // Update views only once after all items are added
+  this->External->StartItemBatchModify();
 
   // Find unresolved scene item so that later the top-level items can be found and added under the actual scene item instead
   vtkIdType unresolvedSceneItemID = vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID;
@@ -1550,6 +1641,7 @@ bool vtkMRMLSubjectHierarchyNode::vtkInternal::ResolveUnresolvedItems()
     {
     vtkErrorWithObjectMacro(this->External, "ResolveUnresolvedItems: Failed to find scene item among unresolved items");
     this->IsResolving = false;
+    this->External->EndItemBatchModify();
     return false;
     }
 
@@ -1648,6 +1740,7 @@ bool vtkMRMLSubjectHierarchyNode::vtkInternal::ResolveUnresolvedItems()
       {
       vtkErrorWithObjectMacro(this->External, "ResolveUnresolvedItems: Failed to process " << numberOfUnresolvedItems << " unresolved items");
       this->IsResolving = false;
+      this->External->EndItemBatchModify();
       return false;
       }
     numberOfUnresolvedItems = this->UnresolvedItems->Children.size();
@@ -1655,6 +1748,7 @@ bool vtkMRMLSubjectHierarchyNode::vtkInternal::ResolveUnresolvedItems()
 
   // Indicate end of resolving
   this->IsResolving = wasResolving;
+  this->External->EndItemBatchModify();
 
   return true;
 }
@@ -1748,6 +1842,81 @@ void vtkMRMLSubjectHierarchyNode::PrintItem(vtkIdType itemID, ostream& os, vtkIn
   item->PrintSelf(os, indent);
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::StartItemBatchModify()
+{
+  if (this->Internal->ItemBatchModifyCount++ > 0)
+    {
+    // Nested batch, events are invoked by the outermost one
+    return;
+    }
+  this->Internal->ItemBatchModifiedItemIDs.clear();
+  this->Internal->ItemBatchModifyNodeModifiedPending = false;
+  this->InvokeCustomModifiedEvent(SubjectHierarchyStartItemBatchModifyEvent);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::EndItemBatchModify()
+{
+  if (this->Internal->ItemBatchModifyCount <= 0)
+    {
+    vtkErrorMacro("EndItemBatchModify: No item batch modification is in progress");
+    return;
+    }
+  if (--this->Internal->ItemBatchModifyCount > 0)
+    {
+    return;
+    }
+
+  vtkNew<vtkIdList> modifiedItemIDs;
+  for (std::set<vtkIdType>::iterator itemIt = this->Internal->ItemBatchModifiedItemIDs.begin();
+    itemIt != this->Internal->ItemBatchModifiedItemIDs.end(); ++itemIt)
+    {
+    // Items may have been removed during the batch
+    if (this->Internal->FindItemByID(*itemIt))
+      {
+      modifiedItemIDs->InsertNextId(*itemIt);
+      }
+    }
+  this->Internal->ItemBatchModifiedItemIDs.clear();
+
+  if (this->Internal->ItemBatchModifyNodeModifiedPending)
+    {
+    this->Internal->ItemBatchModifyNodeModifiedPending = false;
+    this->Modified();
+    }
+  this->InvokeCustomModifiedEvent(SubjectHierarchyEndItemBatchModifyEvent, modifiedItemIDs.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLSubjectHierarchyNode::IsItemBatchModifyInProgress()
+{
+  return (this->Internal->ItemBatchModifyCount > 0);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::InvokeItemModifiedEvent(vtkIdType itemID)
+{
+  if (this->Internal->ItemBatchModifyCount > 0)
+    {
+    // Modified events are summarized in the event invoked at the end of the batch
+    this->Internal->ItemBatchModifiedItemIDs.insert(itemID);
+    return;
+    }
+  this->InvokeCustomModifiedEvent(SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::ContentModified()
+{
+  if (this->Internal->ItemBatchModifyCount > 0)
+    {
+    this->Internal->ItemBatchModifyNodeModifiedPending = true;
+    return;
+    }
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 const char* vtkMRMLSubjectHierarchyNode::GetNodeTagName()
 {
@@ -1882,7 +2051,7 @@ void vtkMRMLSubjectHierarchyNode::SetItemName(vtkIdType itemID, std::string name
 
   if (nameChanged)
     {
-    this->InvokeCustomModifiedEvent(SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+    this->InvokeItemModifiedEvent(itemID);
     }
 }
 
@@ -1941,7 +2110,7 @@ void vtkMRMLSubjectHierarchyNode::SetItemOwnerPluginName(vtkIdType itemID, std::
   if (item->OwnerPluginName.compare(ownerPluginName))
     {
     item->OwnerPluginName = ownerPluginName;
-    this->InvokeCustomModifiedEvent(SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+    this->InvokeItemModifiedEvent(itemID);
     }
 }
 
@@ -1971,7 +2140,7 @@ void vtkMRMLSubjectHierarchyNode::SetItemExpanded(vtkIdType itemID, bool expande
   if (item->Expanded != expanded)
     {
     item->Expanded = expanded;
-    this->InvokeCustomModifiedEvent(SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+    this->InvokeItemModifiedEvent(itemID);
     }
 }
 
@@ -2117,7 +2286,7 @@ void vtkMRMLSubjectHierarchyNode::ItemModified(vtkIdType itemID)
     }
 
   // Invoke the node event directly, thus saving an extra callback round
-  this->InvokeCustomModifiedEvent(SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+  this->InvokeItemModifiedEvent(itemID);
 }
 
 //---------------------------------------------------------------------------
@@ -3096,8 +3265,20 @@ void vtkMRMLSubjectHierarchyNode::ItemEventCallback(vtkObject* caller, unsigned
       vtkSubjectHierarchyItem* item = reinterpret_cast<vtkSubjectHierarchyItem*>(callData);
       if (item)
         {
+        if (self->Internal->ItemBatchModifyCount > 0)
+          {
+          // Keep track of the affected items for the summary event at the end of the batch
+          if (eid == vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent)
+            {
+            self->Internal->ItemBatchModifiedItemIDs.erase(item->ID);
+            }
+          else
+            {
+            self->Internal->ItemBatchModifiedItemIDs.insert(item->ID);
+            }
+          }
         self->InvokeCustomModifiedEvent(eid, (void*)&item->ID);
-        self->Modified(); // Indicate that the content of the subject hierarchy node has changed, so it needs to be saved
+        self->ContentModified(); // Indicate that the content of the subject hierarchy node has changed, so it needs to be saved
         }
       }
       break;
@@ -3109,8 +3290,8 @@ void vtkMRMLSubjectHierarchyNode::ItemEventCallback(vtkObject* caller, unsigned
       if (item)
         {
         // Propagate item modified event
-        self->InvokeCustomModifiedEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent, (void*)&item->ID);
-        self->Modified(); // Indicate that the content of the subject hierarchy node has changed, so it needs to be saved
+        self->InvokeItemModifiedEvent(item->ID);
+        self->ContentModified(); // Indicate that the content of the subject hierarchy node has changed, so it needs to be saved
         }
       else if (dataNode)
         {
@@ -3118,7 +3299,7 @@ void vtkMRMLSubjectHierarchyNode::ItemEventCallback(vtkObject* caller, unsigned
         vtkIdType itemID = self->GetItemByDataNode(dataNode);
         if (itemID != vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
           {
-          self->InvokeCustomModifiedEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+          self->InvokeItemModifiedEvent(itemID);
           }
         }
       }
@@ -3134,7 +3315,7 @@ void vtkMRMLSubjectHierarchyNode::ItemEventCallback(vtkObject* caller, unsigned
         vtkIdType itemID = self->GetItemByDataNode(dataNode);
         if (itemID != vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
           {
-          self->InvokeCustomModifiedEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent, (void*)&itemID);
+          self->InvokeItemModifiedEvent(itemID);
           }
         }
       }
@@ -77,7 +77,13 @@ public:
     /// Event invoked when item resolving starts (e.g. after scene import)
     SubjectHierarchyStartResolveEvent,
     /// Event invoked when item resolving finished (e.g. after scene import)
-    SubjectHierarchyEndResolveEvent
+    SubjectHierarchyEndResolveEvent,
+    /// Event invoked when batch modification of items starts \sa StartItemBatchModify
+    SubjectHierarchyStartItemBatchModifyEvent,
+    /// Event invoked when batch modification of items ends \sa EndItemBatchModify.
+    /// Summarizes the item added and modified events that were not invoked during the batch.
+    /// Call data is a vtkIdList containing the IDs of the items that were added or modified.
+    SubjectHierarchyEndItemBatchModifyEvent
   };
 
 public:
@@ -351,10 +357,28 @@ public:
   /// Print subject hierarchy item info on stream
   void PrintItem(vtkIdType itemID, ostream& os, vtkIndent indent);
 
+  /// Start batch modification of items (e.g. bulk import of many items).
+  /// Until the matching \sa EndItemBatchModify call, SubjectHierarchyItemModifiedEvent is not invoked for the items,
+  /// and views are expected to ignore the per-item events (\sa IsItemBatchModifyInProgress) and update once when
+  /// SubjectHierarchyEndItemBatchModifyEvent is invoked. Item added, removed, UID added, and owner plugin search
+  /// events are still invoked, as they are needed to process the individual items (e.g. to assign owner plugin).
+  /// Calls can be nested, in which case the events are invoked by the outermost call pair.
+  void StartItemBatchModify();
+  /// End batch modification of items. Invokes SubjectHierarchyEndItemBatchModifyEvent with the list of items
+  /// that were added or modified during the batch, if this call ends the outermost batch
+  void EndItemBatchModify();
+  /// Determine whether batch modification of items is in progress \sa StartItemBatchModify
+  bool IsItemBatchModifyInProgress();
+
 protected:
   /// Callback function for all events from the subject hierarchy items
   static void ItemEventCallback(vtkObject* caller, unsigned long eid, void* clientData, void* callData);
 
+  /// Invoke item modified event, or record the item for the summary event if item batch modification is in progress
+  void InvokeItemModifiedEvent(vtkIdType itemID);
+  /// Mark node modified when its content changed. Deferred to the end of item batch modification if in progress
+  void ContentModified();
+
 protected:
   vtkMRMLSubjectHierarchyNode();
   ~vtkMRMLSubjectHierarchyNode();
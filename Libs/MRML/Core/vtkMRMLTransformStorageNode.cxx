@@ -261,6 +261,8 @@ int vtkMRMLTransformStorageNode::ReadFromImageFile(vtkMRMLNode *refNode)
     }
 
   vtkNew<vtkOrientedGridTransform> gridTransform_Ras;
+  // volumes and slices are resampled using the inverse of the grid
+  gridTransform_Ras->CacheInverseGridOn();
   vtkITKTransformConverter::SetVTKOrientedGridTransformFromITKImage<double>(
         this, gridTransform_Ras.GetPointer(), gridImage_Lps);
 
@@ -29,6 +29,11 @@ Version:   $Revision: 1.6 $
 #include "vtkITKArchetypeImageSeriesVectorReaderSeries.h"
 #include "vtkITKImageWriter.h"
 
+#ifdef MRML_USE_vtkTeem
+// vtkTeem includes
+#include <vtkTeemNRRDWriter.h>
+#endif
+
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
@@ -37,6 +42,8 @@ Version:   $Revision: 1.6 $
 #include <vtkDataArray.h>
 #include <vtkErrorCode.h>
 #include <vtkImageChangeInformation.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
@@ -46,6 +53,7 @@ Version:   $Revision: 1.6 $
 // STD includes
 #include <algorithm>
 #include <iterator>
+#include <sstream>
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLVolumeArchetypeStorageNode);
@@ -291,6 +299,27 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (volNode->GetImageData())
+    {
+    volNode->SetAndObserveImageData(NULL);
+    }
+
+  std::string errorMessage;
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader =
+    this->ReadImage(refNode, fullName, true, errorMessage);
+  if (reader.GetPointer() == NULL)
+    {
+    vtkErrorMacro(<< errorMessage);
+    return 0;
+    }
+  return this->SetImageFromReader(volNode, reader, fullName);
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkITKArchetypeImageSeriesReader> vtkMRMLVolumeArchetypeStorageNode
+::ReadImage(vtkMRMLNode* refNode, const std::string& fullName, bool observeProgress,
+            std::string& errorMessage)
+{
   vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
 
   if (refNode->IsA("vtkMRMLVectorVolumeNode"))
@@ -312,15 +341,13 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   if (reader.GetPointer() == NULL)
     {
-    vtkErrorMacro("ReadData: Failed to instantiate a file reader");
-    return 0;
+    errorMessage = "ReadData: Failed to instantiate a file reader";
+    return NULL;
     }
 
-  reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
-
-  if (volNode->GetImageData())
+  if (observeProgress)
     {
-    volNode->SetAndObserveImageData(NULL);
+    reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
     }
 
   // Set the list of file names on the reader
@@ -343,7 +370,7 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     }
 
   bool readingWorked = true;
-  std::string errorMessage = "";
+  std::string readerErrorMessage = "";
   try
     {
     vtkDebugMacro("ReadData: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
@@ -351,13 +378,13 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     if (reader->GetErrorCode() != vtkErrorCode::NoError)
       {
       readingWorked = false;
-      errorMessage = std::string(vtkErrorCode::GetStringFromErrorCode(reader->GetErrorCode()));
+      readerErrorMessage = std::string(vtkErrorCode::GetStringFromErrorCode(reader->GetErrorCode()));
       }
     }
   catch (itk::ExceptionObject& e)
     {
     readingWorked = false;
-    errorMessage = std::string("ITK exception info: error in ") + e.GetLocation() + "\n"
+    readerErrorMessage = std::string("ITK exception info: error in ") + e.GetLocation() + "\n"
                                                 + e.GetDescription() + "\n";
     }
   if (!readingWorked)
@@ -367,50 +394,60 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       {
       reader0thFileName = std::string("reader 0th file name = ") + std::string(reader->GetFileName(0));
       }
-    vtkErrorMacro(<< "ReadData: Cannot read file as a volume of type "
-                  << (refNode ? refNode->GetNodeTagName() : "null")
-                  << "[" << "fullName = " << fullName << "]\n"
-                  << "\tNumber of files listed in the node = "
-                  << this->GetNumberOfFileNames() << ".\n"
-                  << "\tFile reader says it was able to read "
-                  << reader->GetNumberOfFileNames() << " files.\n"
-                  << "\tFile reader used the archetype file name of " << reader->GetArchetype()
-                  << " [" << reader0thFileName.c_str() << "]\n"
-                  << errorMessage << "\n");
-    return 0;
+    std::stringstream message;
+    message << "ReadData: Cannot read file as a volume of type "
+            << (refNode ? refNode->GetNodeTagName() : "null")
+            << "[" << "fullName = " << fullName << "]\n"
+            << "\tNumber of files listed in the node = "
+            << this->GetNumberOfFileNames() << ".\n"
+            << "\tFile reader says it was able to read "
+            << reader->GetNumberOfFileNames() << " files.\n"
+            << "\tFile reader used the archetype file name of " << reader->GetArchetype()
+            << " [" << reader0thFileName.c_str() << "]\n"
+            << readerErrorMessage << "\n";
+    errorMessage = message.str();
+    return NULL;
     }
 
   if (reader->GetOutput() == NULL || reader->GetOutput()->GetPointData() == NULL)
     {
-    vtkErrorMacro("ReadData: Unable to read data from file: " << fullName);
-    return 0;
+    errorMessage = std::string("ReadData: Unable to read data from file: ") + fullName;
+    return NULL;
     }
 
   vtkPointData * pointData = reader->GetOutput()->GetPointData();
-  if (volNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+  if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
     {
     if (pointData->GetTensors() == NULL || pointData->GetTensors()->GetNumberOfTuples() == 0)
       {
-      vtkErrorMacro("ReadData: Unable to read DiffusionTensorVolume data from file: " << fullName );
-      return 0;
+      errorMessage = std::string("ReadData: Unable to read DiffusionTensorVolume data from file: ") + fullName;
+      return NULL;
       }
     }
   else
     {
     if (pointData->GetScalars() == NULL || pointData->GetScalars()->GetNumberOfTuples() == 0)
       {
-      vtkErrorMacro("ReadData: Unable to read ScalarVolume data from file: " << fullName );
-      return 0;
+      errorMessage = std::string("ReadData: Unable to read ScalarVolume data from file: ") + fullName;
+      return NULL;
       }
     }
 
-  if (!volNode->IsA("vtkMRMLVectorVolumeNode")
-      && !volNode->IsA("vtkMRMLDiffusionTensorVolumeNode")
+  if (!refNode->IsA("vtkMRMLVectorVolumeNode")
+      && !refNode->IsA("vtkMRMLDiffusionTensorVolumeNode")
       && reader->GetNumberOfComponents() != 1)
     {
-    vtkErrorMacro("ReadData: Not a scalar volume file: " << fullName );
-    return 0;
+    errorMessage = std::string("ReadData: Not a scalar volume file: ") + fullName;
+    return NULL;
     }
+  return reader;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::SetImageFromReader(vtkMRMLScalarVolumeNode* volNode,
+                                                          vtkITKArchetypeImageSeriesReader* reader,
+                                                          const std::string& fullName)
+{
 
   // Set volume attributes
   vtkMRMLVolumeArchetypeStorageNode::SetMetaDataDictionaryFromReader(volNode, reader);
@@ -481,10 +518,201 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 }
 
 //----------------------------------------------------------------------------
-int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
+bool vtkMRMLVolumeArchetypeStorageNode::CanReadDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  return refNode->IsA("vtkMRMLScalarVolumeNode");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::ReadDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+    {
+    return 0;
+    }
+  try
+    {
+    // errors are reported by ReadData() on the main thread
+    this->DetachedReader = this->ReadImage(refNode, fullName, false, this->DetachedReadMessage);
+    }
+  catch (...)
+    {
+    this->DetachedReader = NULL;
+    }
+  return this->DetachedReader.GetPointer() != NULL ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::AttachDetachedDataInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLScalarVolumeNode* volNode = vtkMRMLScalarVolumeNode::SafeDownCast(refNode);
+  if (volNode == NULL || this->DetachedReader.GetPointer() == NULL)
+    {
+    return 0;
+    }
+  return this->SetImageFromReader(volNode, this->DetachedReader,
+                                  this->GetFullNameFromFileName());
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeArchetypeStorageNode::ClearDetachedData()
+{
+  this->DetachedReader = NULL;
+  this->Superclass::ClearDetachedData();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::CanWriteDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  if (!refNode->IsA("vtkMRMLScalarVolumeNode"))
+    {
+    return false;
+    }
+  std::string extension = this->GetSupportedFileExtension(this->GetFileName());
+  if (extension != std::string(".nrrd")
+    && extension != std::string(".nii")
+    && extension != std::string(".nii.gz")
+    && extension != std::string(".mha"))
+    {
+    return false;
+    }
+  // the image IO is chosen from the file extension, it must match the
+  // requested write format
+  return this->WriteFileFormat == NULL
+    || vtksys::SystemTools::LowerCase(vtkDataFileFormatHelper::GetFileExtensionFromFormatString(
+         this->WriteFileFormat)) == extension;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::PrepareWriteDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLVolumeNode* volNode = vtkMRMLScalarVolumeNode::SafeDownCast(refNode);
+  if (volNode == NULL || volNode->GetImageData() == NULL)
+    {
+    return 0;
+    }
+  // the writers of the worker threads must not update the pipeline of the
+  // volume node, nor share the image with the pipelines of other writers
+  this->DetachedWriteImage = vtkSmartPointer<vtkImageData>::New();
+  this->DetachedWriteImage->ShallowCopy(volNode->GetImageData());
+  this->DetachedWriteRASToIJKMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  volNode->GetRASToIJKMatrix(this->DetachedWriteRASToIJKMatrix);
+  this->DetachedWriteImageIOClassName = this->GetWriteImageIOClassName();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::WriteDataDetachedInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  this->DetachedWriteTempName.clear();
+  this->DetachedWriteErrorMessage.clear();
+  if (this->DetachedWriteImage.GetPointer() == NULL)
+    {
+    return 0;
+    }
+  // same temporary write as UpdateFileList(), the file list is updated and
+  // the files are moved by CompleteWriteDataDetachedInternal()
+  this->DetachedWriteTempName = this->WriteToTemporaryDirectory(
+    this->DetachedWriteImage, this->DetachedWriteRASToIJKMatrix,
+    this->DetachedWriteImageIOClassName, this->DetachedWriteErrorMessage);
+  return this->DetachedWriteTempName.empty() ? 0 : 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::CompleteWriteDataDetachedInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLVolumeNode* volNode = vtkMRMLScalarVolumeNode::SafeDownCast(refNode);
+  if (!this->DetachedWriteResult)
+    {
+    vtkErrorMacro("WriteData: " << this->DetachedWriteErrorMessage);
+    return 0;
+    }
+  this->ResetFileNameList();
+  std::string moveFromDir = this->UpdateFileListFromTemporaryDirectory(
+    volNode, this->DetachedWriteTempName, 1);
+  return this->MoveFilesFromTemporaryDirectory(volNode, moveFromDir);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeArchetypeStorageNode::ClearDetachedWriteData()
+{
+  this->DetachedWriteImage = NULL;
+  this->DetachedWriteRASToIJKMatrix = NULL;
+  this->DetachedWriteImageIOClassName.clear();
+  this->DetachedWriteTempName.clear();
+  this->DetachedWriteErrorMessage.clear();
+  this->Superclass::ClearDetachedWriteData();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLVolumeArchetypeStorageNode::GetWriteImageIOClassName()
+{
+  if (this->WriteFileFormat &&
+      this->GetScene() &&
+      this->GetScene()->GetDataIOManager() &&
+      this->GetScene()->GetDataIOManager()->GetFileFormatHelper())
+    {
+    return this->GetScene()->GetDataIOManager()->GetFileFormatHelper()->
+      GetClassNameFromFormatString(this->WriteFileFormat);
+    }
+  return std::string();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::WriteImageToFile(vtkImageData* imageData,
+  vtkMatrix4x4* rasToIJKMatrix, const std::string& fileName, const std::string& imageIOClassName)
 {
-  int result = 1;
+#ifdef MRML_USE_vtkTeem
+  // ITK compresses nrrd files on a single thread with its default level,
+  // the teem writer supports CompressionLevel and compresses by blocks on
+  // all threads
+  std::string extension = vtksys::SystemTools::LowerCase(
+    vtksys::SystemTools::GetFilenameLastExtension(fileName));
+  if (this->GetUseCompression() && extension == ".nrrd"
+    && (imageIOClassName.empty() || imageIOClassName == "NrrdImageIO")
+    && imageData->GetNumberOfScalarComponents() == 1
+    && imageData->GetPointData()->GetScalars() != NULL)
+    {
+    vtkNew<vtkMatrix4x4> ijkToRAS;
+    vtkMatrix4x4::Invert(rasToIJKMatrix, ijkToRAS.GetPointer());
+    vtkNew<vtkTeemNRRDWriter> nrrdWriter;
+    nrrdWriter->SetFileName(fileName.c_str());
+    nrrdWriter->SetInputData(imageData);
+    nrrdWriter->SetUseCompression(1);
+    nrrdWriter->SetCompressionLevel(this->GetCompressionLevel());
+    nrrdWriter->SetIJKToRASMatrix(ijkToRAS.GetPointer());
+    nrrdWriter->Write();
+    return nrrdWriter->GetWriteError() ? 0 : 1;
+    }
+#endif
+
+  vtkNew<vtkITKImageWriter> writer;
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(imageData);
+  writer->SetUseCompression(this->GetUseCompression());
+  if (!imageIOClassName.empty())
+    {
+    writer->SetImageIOClassName(imageIOClassName.c_str());
+    }
+
+  // set volume attributes
+  writer->SetRasToIJKMatrix(rasToIJKMatrix);
+
+  try
+    {
+    writer->Write();
+    }
+  catch (...)
+    {
+    return 0;
+    }
+  return 1;
+}
 
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
+{
   vtkMRMLVolumeNode *volNode = vtkMRMLScalarVolumeNode::SafeDownCast(refNode);
 
   if (volNode->GetImageData() == NULL)
@@ -496,7 +724,13 @@ int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   // update the file list
   std::string moveFromDir = this->UpdateFileList(refNode, 1);
 
+  return this->MoveFilesFromTemporaryDirectory(volNode, moveFromDir);
+}
 
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::MoveFilesFromTemporaryDirectory(
+  vtkMRMLVolumeNode* volNode, const std::string& moveFromDir)
+{
   std::string fullName = this->GetFullNameFromFileName();
   if (fullName.empty())
     {
@@ -575,35 +809,16 @@ int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     {
     vtkDebugMacro("WriteData: writing out file with archetype " << fullName);
 
-    vtkNew<vtkITKImageWriter> writer;
-    writer->SetFileName(fullName.c_str());
-
-    writer->SetInputConnection( volNode->GetImageDataConnection() );
-    writer->SetUseCompression(this->GetUseCompression());
-    if(this->WriteFileFormat)
-      {
-      writer->SetImageIOClassName(
-                                  this->GetScene()->GetDataIOManager()->GetFileFormatHelper()->
-                                  GetClassNameFromFormatString(this->WriteFileFormat));
-      }
-
-    // set volume attributes
     vtkNew<vtkMatrix4x4> mat;
     volNode->GetRASToIJKMatrix(mat.GetPointer());
-    writer->SetRasToIJKMatrix(mat.GetPointer());
-
-    try
-      {
-      writer->Write();
-      }
-    catch (...)
+    if (!this->WriteImageToFile(volNode->GetImageData(), mat.GetPointer(), fullName,
+                                this->GetWriteImageIOClassName()))
       {
-      result = 0;
+      return 0;
       }
     }
 
-  return result;
-
+  return 1;
 }
 
 //----------------------------------------------------------------------------
@@ -627,7 +842,6 @@ void vtkMRMLVolumeArchetypeStorageNode::InitializeSupportedWriteFileTypes()
 //----------------------------------------------------------------------------
 std::string vtkMRMLVolumeArchetypeStorageNode::UpdateFileList(vtkMRMLNode *refNode, int move)
 {
-  bool result = true;
   std::string returnString;
   // test whether refNode is a valid node to hold a volume
   if (!refNode->IsA("vtkMRMLScalarVolumeNode") )
@@ -656,6 +870,33 @@ std::string vtkMRMLVolumeArchetypeStorageNode::UpdateFileList(vtkMRMLNode *refNo
   // clear out the old file list
   this->ResetFileNameList();
 
+  vtkNew<vtkMatrix4x4> mat;
+  volNode->GetRASToIJKMatrix(mat.GetPointer());
+  std::string errorMessage;
+  std::string tempName = this->WriteToTemporaryDirectory(volNode->GetImageData(), mat.GetPointer(),
+                                                         this->GetWriteImageIOClassName(), errorMessage);
+  if (tempName.empty())
+    {
+    vtkErrorMacro("UpdateFileList: " << errorMessage);
+    return returnString;
+    }
+
+  return this->UpdateFileListFromTemporaryDirectory(volNode, tempName, move);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLVolumeArchetypeStorageNode::WriteToTemporaryDirectory(vtkImageData* imageData,
+  vtkMatrix4x4* rasToIJKMatrix, const std::string& imageIOClassName, std::string& errorMessage)
+{
+  bool result = true;
+  std::string returnString;
+  std::string oldName(this->GetFileName() ? this->GetFileName() : "");
+  if (oldName.empty())
+    {
+    errorMessage = "File name not specified";
+    return returnString;
+    }
+
   // make a new dir to write temporary stuff out to
 //  std::vector<std::string> pathComponents;
   // get the base dir of the destination
@@ -676,67 +917,49 @@ std::string vtkMRMLVolumeArchetypeStorageNode::UpdateFileList(vtkMRMLNode *refNo
   std::string originalDir = vtksys::SystemTools::GetParentDirectory(oldName.c_str());
   std::vector<std::string> pathComponents;
   vtksys::SystemTools::SplitPath(originalDir.c_str(), pathComponents);
-  // add a temp dir to it
+  // add a temp dir to it, named after the whole file name as volumes with
+  // the same base name can be written at the same time
   pathComponents.push_back(std::string("TempWrite") +
-    vtksys::SystemTools::GetFilenameWithoutExtension(oldName));
+    vtksys::SystemTools::GetFilenameName(oldName));
   std::string tempDir = vtksys::SystemTools::JoinPath(pathComponents);
-  vtkDebugMacro("UpdateFileList: deleting and then re-creating temp dir "<< tempDir.c_str());
   if (vtksys::SystemTools::FileExists(tempDir.c_str()))
     {
     result = vtksys::SystemTools::RemoveADirectory(tempDir.c_str());
     }
   if (!result)
     {
-    vtkErrorMacro("UpdateFileList: Failed to delete directory '" << tempDir << "'.");
+    errorMessage = "Failed to delete directory '" + tempDir + "'.";
     return returnString;
     }
   result = vtksys::SystemTools::MakeDirectory(tempDir.c_str());
   if (!result)
     {
-    vtkErrorMacro("UpdateFileList: Failed to create directory" << tempDir);
+    errorMessage = "Failed to create directory " + tempDir;
     return returnString;
     }
   // make a new name,
   pathComponents.push_back(vtksys::SystemTools::GetFilenameName(oldName));
   std::string tempName = vtksys::SystemTools::JoinPath(pathComponents);
-  vtkDebugMacro("UpdateFileList: new archetype file name = " << tempName.c_str());
-
-  // set up the writer and write
-  vtkNew<vtkITKImageWriter> writer;
-  writer->SetFileName(tempName.c_str());
-  writer->SetInputData( volNode->GetImageData() );
-  writer->SetUseCompression(this->GetUseCompression());
-  if(this->WriteFileFormat)
-    {
-    if (this->GetScene() &&
-        this->GetScene()->GetDataIOManager() &&
-        this->GetScene()->GetDataIOManager()->GetFileFormatHelper())
-      {
-      writer->SetImageIOClassName(this->GetScene()->GetDataIOManager()->GetFileFormatHelper()->
-                                  GetClassNameFromFormatString(this->WriteFileFormat));
-      }
-    }
-
-  // set volume attributes
-  vtkNew<vtkMatrix4x4> mat;
-  volNode->GetRASToIJKMatrix(mat.GetPointer());
-  writer->SetRasToIJKMatrix(mat.GetPointer());
-
-  try
-    {
-    writer->Write();
-    }
-    catch (...)
-    {
-    result = false;
-    }
 
-  if (!result)
+  if (!this->WriteImageToFile(imageData, rasToIJKMatrix, tempName, imageIOClassName))
     {
-    vtkErrorMacro("UpdateFileList: Failed to write '" << tempName.c_str()
-      << "'.");
+    errorMessage = "Failed to write '" + tempName + "'.";
     return returnString;
     }
+  return tempName;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLVolumeArchetypeStorageNode::UpdateFileListFromTemporaryDirectory(
+  vtkMRMLVolumeNode* volNode, const std::string& tempName, int move)
+{
+  bool result = true;
+  std::string returnString;
+  std::string oldName(this->GetFileName() ? this->GetFileName() : "");
+  std::string originalDir = vtksys::SystemTools::GetParentDirectory(oldName.c_str());
+  std::string tempDir = vtksys::SystemTools::GetParentDirectory(tempName.c_str());
+  std::vector<std::string> pathComponents;
+  vtksys::SystemTools::SplitPath(tempName.c_str(), pathComponents);
 
   // look through the new dir and populate the file list
   vtksys::Directory dir;
@@ -17,8 +17,13 @@
 
 #include "vtkMRMLStorageNode.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
 class vtkImageData;
 class vtkITKArchetypeImageSeriesReader;
+class vtkMatrix4x4;
+class vtkMRMLScalarVolumeNode;
 class vtkMRMLVolumeNode;
 
 /// \brief MRML node for representing a volume storage.
@@ -90,6 +95,9 @@ public:
   /// using only wrapped types.
   static void SetMetaDataDictionaryFromReader(vtkMRMLVolumeNode*, vtkITKArchetypeImageSeriesReader*);
 
+  /// Release the reader used by ReadDataDetached()
+  virtual void ClearDetachedData() VTK_OVERRIDE;
+
 protected:
   vtkMRMLVolumeArchetypeStorageNode();
   ~vtkMRMLVolumeArchetypeStorageNode();
@@ -107,6 +115,72 @@ protected:
   /// Write data from a referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
 
+  /// Volumes can be read from worker threads
+  virtual bool CanReadDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int ReadDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int AttachDetachedDataInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+
+  /// Volumes in single file formats can be written from worker threads.
+  /// They are written in the temporary directory of UpdateFileList(), the
+  /// file list is updated and the files are moved on the main thread.
+  virtual bool CanWriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int PrepareWriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int WriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual int CompleteWriteDataDetachedInternal(vtkMRMLNode *refNode) VTK_OVERRIDE;
+  virtual void ClearDetachedWriteData() VTK_OVERRIDE;
+
+  /// Return the image IO matching WriteFileFormat, empty to choose it from
+  /// the file extension.
+  std::string GetWriteImageIOClassName();
+
+  /// Write \a imageData in \a fileName. Does not modify the storage node
+  /// nor invoke events. Returns 1 on success, 0 otherwise.
+  int WriteImageToFile(vtkImageData* imageData, vtkMatrix4x4* rasToIJKMatrix,
+                       const std::string& fileName, const std::string& imageIOClassName);
+
+  /// Write \a imageData in a new temporary directory next to the file name.
+  /// Does not modify the storage node nor invoke events.
+  /// Returns the name of the written archetype, empty with \a errorMessage set
+  /// on failure.
+  std::string WriteToTemporaryDirectory(vtkImageData* imageData, vtkMatrix4x4* rasToIJKMatrix,
+                                        const std::string& imageIOClassName,
+                                        std::string& errorMessage);
+
+  /// Add the files written by WriteToTemporaryDirectory() in the file list.
+  /// \sa UpdateFileList()
+  std::string UpdateFileListFromTemporaryDirectory(vtkMRMLVolumeNode* volNode,
+                                                   const std::string& tempName, int move);
+
+  /// Move the files of \a moveFromDir next to the file name. Writes the image
+  /// of \a volNode again if they cannot be moved.
+  /// Returns 1 on success, 0 otherwise.
+  int MoveFilesFromTemporaryDirectory(vtkMRMLVolumeNode* volNode, const std::string& moveFromDir);
+
+  /// Instantiate the reader for \a refNode and read the file.
+  /// Returns the up-to-date reader or NULL if the file cannot be read, in
+  /// which case the error is set in \a errorMessage.
+  /// \a observeProgress must be false when not called on the main thread.
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> ReadImage(
+    vtkMRMLNode* refNode, const std::string& fullName, bool observeProgress,
+    std::string& errorMessage);
+
+  /// Set the image, geometry and meta data read by \a reader into \a volNode
+  int SetImageFromReader(vtkMRMLScalarVolumeNode* volNode,
+                         vtkITKArchetypeImageSeriesReader* reader,
+                         const std::string& fullName);
+
+  /// Reader that was updated by ReadDataDetached()
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> DetachedReader;
+
+  /// Data copied by PrepareWriteDataDetached()
+  vtkSmartPointer<vtkImageData> DetachedWriteImage;
+  vtkSmartPointer<vtkMatrix4x4> DetachedWriteRASToIJKMatrix;
+  std::string DetachedWriteImageIOClassName;
+  /// Archetype written by WriteDataDetached() in the temporary directory
+  std::string DetachedWriteTempName;
+  /// Error of WriteDataDetached(), reported on the main thread
+  std::string DetachedWriteErrorMessage;
+
   int CenterImage;
   int SingleFile;
   int UseOrientationFromFile;
@@ -21,17 +21,29 @@
 // MRML includes
 #include "vtkMRMLApplicationLogic.h"
 #include "vtkMRMLCoreTestingMacros.h"
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSliceNode.h>
+#include <vtkMRMLStorageNode.h>
 
 // VTK includes
+#include <vtkCellArray.h>
 #include <vtkCollection.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
 #include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/Directory.hxx>
 #include <vtksys/SystemTools.hxx>
 
 // STD includes
 #include <sstream>
 #include <string>
+#include <vector>
 
 
 //-----------------------------------------------------------------------------
@@ -39,6 +51,7 @@ int SliceLogicsTest();
 int SliceOrientationPresetInitializationTest();
 int TemporaryPathTest();
 int CreateUniqueFileNameTest(std::string tempDir);
+int SaveSceneToSlicerDataBundleDirectoryTest(std::string tempDir);
 
 //-----------------------------------------------------------------------------
 int vtkMRMLApplicationLogicTest1(int argc, char *argv [])
@@ -57,6 +70,7 @@ int vtkMRMLApplicationLogicTest1(int argc, char *argv [])
   CHECK_EXIT_SUCCESS(SliceOrientationPresetInitializationTest());
   CHECK_EXIT_SUCCESS(TemporaryPathTest());
   CHECK_EXIT_SUCCESS(CreateUniqueFileNameTest(tempDir));
+  CHECK_EXIT_SUCCESS(SaveSceneToSlicerDataBundleDirectoryTest(tempDir));
   return EXIT_SUCCESS;
 }
 
@@ -239,3 +253,97 @@ int CreateUniqueFileNameTest(std::string tempDir)
 
   return EXIT_SUCCESS;
 }
+
+//-----------------------------------------------------------------------------
+int SaveSceneToSlicerDataBundleDirectoryTest(std::string tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLApplicationLogic> appLogic;
+  appLogic->SetMRMLScene(scene.GetPointer());
+  appLogic->SetMaximumNumberOfWriteThreads(4);
+  // small enough to write the models one after another
+  appLogic->SetWriteMemoryBudget(1);
+
+  // models with the same name must be written in different files, models
+  // sharing their mesh can be written at the same time
+  const int numberOfModels = 6;
+  vtkSmartPointer<vtkPolyData> polyData;
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    if (i % 2 == 0)
+      {
+      vtkNew<vtkPoints> points;
+      vtkNew<vtkCellArray> vertices;
+      for (int pointId = 0; pointId < 1000; ++pointId)
+        {
+        points->InsertNextPoint(i, pointId, 0.);
+        vertices->InsertNextCell(1);
+        vertices->InsertCellPoint(pointId);
+        }
+      polyData = vtkSmartPointer<vtkPolyData>::New();
+      polyData->SetPoints(points.GetPointer());
+      polyData->SetVerts(vertices.GetPointer());
+      }
+    vtkNew<vtkMRMLModelNode> modelNode;
+    modelNode->SetName("Model");
+    modelNode->SetAndObservePolyData(polyData);
+    scene->AddNode(modelNode.GetPointer());
+    }
+
+  // volumes are written in temporary directories named after their file
+  const int numberOfVolumes = 2;
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(16, 16, 16);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  imageData->GetPointData()->GetScalars()->Fill(1);
+  for (int i = 0; i < numberOfVolumes; ++i)
+    {
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    volumeNode->SetName("Volume");
+    volumeNode->SetAndObserveImageData(imageData.GetPointer());
+    scene->AddNode(volumeNode.GetPointer());
+    }
+
+  std::string bundleDir = tempDir + "/SaveSceneToSlicerDataBundleDirectoryTest";
+  vtksys::SystemTools::RemoveADirectory(bundleDir);
+  vtksys::SystemTools::MakeDirectory(bundleDir);
+  CHECK_BOOL(appLogic->SaveSceneToSlicerDataBundleDirectory(bundleDir.c_str()), true);
+  CHECK_INT(appLogic->GetNumberOfSaveFailedNodes(), 0);
+
+  vtksys::Directory dataDir;
+  CHECK_BOOL(dataDir.Load((bundleDir + "/Data").c_str()), true);
+  int numberOfModelFiles = 0;
+  int numberOfVolumeFiles = 0;
+  for (unsigned long fileIndex = 0; fileIndex < dataDir.GetNumberOfFiles(); ++fileIndex)
+    {
+    std::string fileName = bundleDir + "/Data/" + dataDir.GetFile(fileIndex);
+    // temporary write directories must have been removed
+    CHECK_BOOL(std::string(dataDir.GetFile(fileIndex)).find("TempWrite") == std::string::npos, true);
+    std::string extension = vtksys::SystemTools::GetFilenameLastExtension(fileName);
+    if (extension == ".vtk")
+      {
+      CHECK_BOOL(vtksys::SystemTools::FileLength(fileName) > 0, true);
+      ++numberOfModelFiles;
+      }
+    else if (extension == ".nrrd")
+      {
+      CHECK_BOOL(vtksys::SystemTools::FileLength(fileName) > 0, true);
+      ++numberOfVolumeFiles;
+      }
+    }
+  CHECK_INT(numberOfModelFiles, numberOfModels);
+  CHECK_INT(numberOfVolumeFiles, numberOfVolumes);
+
+  // the file list of the volumes is updated as by a synchronous write
+  std::vector<vtkMRMLNode*> volumeNodes;
+  scene->GetNodesByClass("vtkMRMLScalarVolumeNode", volumeNodes);
+  for (size_t i = 0; i < volumeNodes.size(); ++i)
+    {
+    vtkMRMLStorageNode* storageNode =
+      vtkMRMLScalarVolumeNode::SafeDownCast(volumeNodes[i])->GetStorageNode();
+    CHECK_NOT_NULL(storageNode);
+    CHECK_INT(storageNode->GetNumberOfFileNames(), 1);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -19,10 +19,12 @@
 ==============================================================================*/
 
 // MRMLLogic includes
+#include "vtkCachedImageReslice.h"
 #include "vtkMRMLSliceLayerLogic.h"
 
 // MRML includes
 #include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeDisplayNode.h"
 #include "vtkMRMLScene.h"
 
 // VTK includes
@@ -34,11 +36,13 @@
 #include <vtkImageReslice.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 #include <vtkTrivialProducer.h>
 
 namespace
 {
 bool testDTIPipeline();
+int testResliceReuse();
 }
 
 //----------------------------------------------------------------------------
@@ -73,6 +77,7 @@ int vtkMRMLSliceLayerLogicTest(int , char * [] )
 
   bool res = true;
   res = res && testDTIPipeline();
+  res = res && (testResliceReuse() == EXIT_SUCCESS);
   return res ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -136,4 +141,107 @@ bool testDTIPipeline()
   return true;
 }
 
+//----------------------------------------------------------------------------
+int testResliceReuse()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  scene->AddNode(displayNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(10, 10, 10);
+  imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  // each slice of the volume has a different value
+  for (int k = 0; k < 10; ++k)
+    {
+    for (int j = 0; j < 10; ++j)
+      {
+      for (int i = 0; i < 10; ++i)
+        {
+        imageData->SetScalarComponentFromDouble(i, j, k, 0, 1. + k);
+        }
+      }
+    }
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetDimensions(20, 20, 1);
+  sliceNode->SetFieldOfView(20., 20., 1.);
+
+  vtkNew<vtkMRMLSliceLayerLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+  logic->SetSliceNode(sliceNode.GetPointer());
+  logic->SetVolumeNode(volumeNode.GetPointer());
+  logic->PipelineTimingOn();
+  CHECK_BOOL(logic->GetPipelineTiming(), true);
+
+  logic->GetReslice()->Update();
+  CHECK_INT(logic->GetResliceExecutionCount(), 1);
+
+  // The slice geometry is unchanged, the previous slice is reused
+  vtkMTimeType resliceMTime = logic->GetReslice()->GetMTime();
+  vtkMTimeType logicMTime = logic->GetMTime();
+  logic->UpdateTransforms();
+  CHECK_BOOL(logic->GetReslice()->GetMTime() == resliceMTime, true);
+  CHECK_BOOL(logic->GetMTime() == logicMTime, true);
+  logic->GetReslice()->Update();
+  CHECK_INT(logic->GetResliceExecutionCount(), 1);
+
+  // Moving the slice reslices the volume again
+  sliceNode->SetSliceOffset(2.);
+  CHECK_BOOL(logic->GetReslice()->GetMTime() > resliceMTime, true);
+  logic->GetReslice()->Update();
+  CHECK_INT(logic->GetResliceExecutionCount(), 2);
+  CHECK_BOOL(logic->GetLastResliceTime() >= 0., true);
+
+  // Scrolling back reuses the slice kept by the reslice filter
+  vtkCachedImageReslice* reslice = vtkCachedImageReslice::SafeDownCast(logic->GetReslice());
+  CHECK_NOT_NULL(reslice);
+  CHECK_INT(reslice->GetNumberOfCachedSlices(), 2);
+  CHECK_INT(reslice->GetCacheHitCount(), 0);
+  vtkNew<vtkImageData> sliceAtOffset2;
+  sliceAtOffset2->DeepCopy(reslice->GetOutput());
+  sliceNode->SetSliceOffset(0.);
+  reslice->Update();
+  CHECK_INT(reslice->GetCacheHitCount(), 1);
+  CHECK_BOOL(reslice->GetOutput()->GetScalarRange()[1] != sliceAtOffset2->GetScalarRange()[1], true);
+  sliceNode->SetSliceOffset(2.);
+  reslice->Update();
+  CHECK_INT(reslice->GetCacheHitCount(), 2);
+  vtkDataArray* scalars = reslice->GetOutput()->GetPointData()->GetScalars();
+  vtkDataArray* expectedScalars = sliceAtOffset2->GetPointData()->GetScalars();
+  CHECK_INT(static_cast<int>(scalars->GetNumberOfTuples()), static_cast<int>(expectedScalars->GetNumberOfTuples()));
+  for (vtkIdType i = 0; i < scalars->GetNumberOfTuples(); ++i)
+    {
+    CHECK_BOOL(scalars->GetTuple1(i) == expectedScalars->GetTuple1(i), true);
+    }
+
+  // A new slice does not overwrite the kept ones
+  vtkSmartPointer<vtkDataArray> cachedScalars = scalars;
+  sliceNode->SetSliceOffset(4.);
+  reslice->Update();
+  CHECK_INT(reslice->GetCacheHitCount(), 2);
+  CHECK_INT(reslice->GetNumberOfCachedSlices(), 3);
+  CHECK_BOOL(reslice->GetOutput()->GetPointData()->GetScalars() != cachedScalars.GetPointer(), true);
+  for (vtkIdType i = 0; i < cachedScalars->GetNumberOfTuples(); ++i)
+    {
+    CHECK_BOOL(cachedScalars->GetTuple1(i) == expectedScalars->GetTuple1(i), true);
+    }
+
+  // Panning changes the stack of slices, the kept slices are released
+  sliceNode->SetXYZOrigin(1., 0., 0.);
+  reslice->Update();
+  CHECK_INT(reslice->GetNumberOfCachedSlices(), 1);
+
+  // Modifying the volume releases the kept slices
+  imageData->Modified();
+  reslice->Update();
+  CHECK_INT(reslice->GetNumberOfCachedSlices(), 1);
+  CHECK_INT(reslice->GetCacheHitCount(), 2);
+
+  return EXIT_SUCCESS;
+}
+
 }
@@ -19,8 +19,23 @@
 #include <archive.h>
 #include <archive_entry.h>
 
+// Memory mapping includes
+#ifdef _WIN32
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
 // STD includes
+#include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 
 namespace
@@ -57,8 +72,99 @@ public:
       }
     vtkArchiveTools::Message(message.c_str(), "Error");
   }
+  // Returns true if the content of the file is already compressed, in which
+  // case compressing it again in the archive would only cost time.
+  static bool IsCompressedFile(const char* fileName)
+  {
+    FILE* fd = fopen(fileName, "rb");
+    if (!fd)
+      {
+      return false;
+      }
+    char header[4096];
+    size_t len = fread(header, sizeof(char), sizeof(header), fd);
+    fclose(fd);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(header);
+    if ((len >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) // gzip (.gz, .nii.gz, ...)
+      || (len >= 3 && memcmp(header, "BZh", 3) == 0) // bzip2
+      || (len >= 4 && memcmp(header, "PK\x03\x04", 4) == 0) // zip
+      || (len >= 8 && memcmp(header, "\x89PNG\r\n\x1a\n", 8) == 0) // png
+      || (len >= 3 && bytes[0] == 0xff && bytes[1] == 0xd8 && bytes[2] == 0xff)) // jpeg
+      {
+      return true;
+      }
+
+    // nrrd and metaimage files with a compressed data encoding
+    bool nrrd = (len >= 4 && memcmp(header, "NRRD", 4) == 0);
+    bool metaImage = (vtksys::SystemTools::LowerCase(
+      vtksys::SystemTools::GetFilenameLastExtension(fileName)) == ".mha");
+    if (!nrrd && !metaImage)
+      {
+      return false;
+      }
+    // only the header lines are parsed, scanning stops before the data
+    size_t lineStart = 0;
+    while (lineStart < len)
+      {
+      const char* lineEnd = static_cast<const char*>(
+        memchr(header + lineStart, '\n', len - lineStart));
+      if (!lineEnd)
+        {
+        // truncated line, the header is longer than the buffer
+        break;
+        }
+      std::string line(header + lineStart, lineEnd);
+      lineStart = (lineEnd - header) + 1;
+      line.erase(std::remove_if(line.begin(), line.end(), IsSpace), line.end());
+      line = vtksys::SystemTools::LowerCase(line);
+      if ((nrrd && (line == "encoding:gzip" || line == "encoding:gz"
+                    || line == "encoding:bzip2" || line == "encoding:bz2"))
+        || (metaImage && line == "compresseddata=true"))
+        {
+        return true;
+        }
+      if ((nrrd && line.empty())
+        || (metaImage && line.compare(0, 15, "elementdatafile") == 0))
+        {
+        // end of the header, the data follows
+        break;
+        }
+      }
+    return false;
+  }
+  // isspace() is undefined for negative values, cast to unsigned char first
+  static bool IsSpace(char c)
+  {
+    return isspace(static_cast<unsigned char>(c)) != 0;
+  }
 };
 
+// --------------------------------------------------------------------------
+vtkTypeUInt64 ReadLittleEndian(const unsigned char* buffer, int numberOfBytes)
+{
+  vtkTypeUInt64 value = 0;
+  for (int i = numberOfBytes - 1; i >= 0; --i)
+    {
+    value = (value << 8) | buffer[i];
+    }
+  return value;
+}
+
+// --------------------------------------------------------------------------
+bool ReadFileRange(std::ifstream& file, vtkTypeInt64 offset, vtkTypeInt64 size,
+                   std::vector<unsigned char>& buffer)
+{
+  if (offset < 0 || size <= 0)
+    {
+    return false;
+    }
+  buffer.resize(static_cast<size_t>(size));
+  file.clear();
+  file.seekg(offset, std::ios::beg);
+  file.read(reinterpret_cast<char*>(&buffer[0]), size);
+  return !file.fail();
+}
+
 // --------------------------------------------------------------------------
 #define BSDTAR_FILESIZE_PRINTF  "%lu"
 #define BSDTAR_FILESIZE_TYPE    unsigned long
@@ -346,7 +452,7 @@ bool extract_tar(const char* tarFileName, bool verbose, bool extract, std::vecto
 //-----------------------------------------------------------------------------
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
-bool zip(const char* zipFileName, const char* directoryToZip)
+bool zip(const char* zipFileName, const char* directoryToZip, bool compress)
 {
 
   //
@@ -396,18 +502,16 @@ bool zip(const char* zipFileName, const char* directoryToZip)
   zipArchive = archive_write_new();
 
   // create a zip archive
-#ifdef HAVE_ZLIB_H
-  std::string compression_type = "deflate";
-#else
-  std::string compression_type = "store";
-#endif
-
   archive_write_set_format_zip(zipArchive);
 
-  archive_write_set_format_option(zipArchive, "zip", "compression", compression_type.c_str());
-
   archive_write_open_filename(zipArchive, zipFileName);
 
+  // files are stored by default, deflate is only available if libarchive
+  // has been built with zlib
+  bool deflate = compress
+    && (archive_write_zip_set_compression_deflate(zipArchive) == ARCHIVE_OK);
+  archive_write_zip_set_compression_store(zipArchive);
+
   // add the data directory
   dirEntry = archive_entry_new();
   archive_entry_set_mtime(dirEntry, 11, 110);
@@ -443,6 +547,19 @@ bool zip(const char* zipFileName, const char* directoryToZip)
     archive_entry_set_size(entry, fileLength);
     archive_entry_set_filetype(entry, AE_IFREG);
     archive_entry_set_perm(entry, 0644);
+    // already compressed files are stored, compressing them again would
+    // only cost time
+    if (deflate)
+      {
+      if (vtkArchiveTools::IsCompressedFile(fileName))
+        {
+        archive_write_zip_set_compression_store(zipArchive);
+        }
+      else
+        {
+        archive_write_zip_set_compression_deflate(zipArchive);
+        }
+      }
     archive_write_header(zipArchive, entry);
 
     //
@@ -629,3 +746,326 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
 
   return (result == ARCHIVE_OK);
 }
+
+//-----------------------------------------------------------------------------
+bool find_stored_zip_member(const char* zipFileName, const char* memberName,
+                            vtkTypeInt64& offset, vtkTypeInt64& size)
+{
+  //
+  // Locating the member data
+  // - find the end of central directory record (zip64 one if needed)
+  // - search the member in the central directory
+  // - skip the local file header of the member
+  //
+
+  if ( !zipFileName || !memberName )
+    {
+    vtkArchiveTools::Error("Find stored member:", "Invalid zipfile or member name");
+    return false;
+    }
+
+  std::ifstream file(zipFileName, std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    {
+    vtkArchiveTools::Error("Find stored member: cannot open", zipFileName);
+    return false;
+    }
+  file.seekg(0, std::ios::end);
+  vtkTypeInt64 fileSize = file.tellg();
+
+  // the end of central directory record is followed by a comment of at most 64 KiB
+  const vtkTypeInt64 endRecordSize = 22;
+  vtkTypeInt64 tailSize = std::min(fileSize, static_cast<vtkTypeInt64>(endRecordSize + 0xffff));
+  std::vector<unsigned char> tail;
+  if (!ReadFileRange(file, fileSize - tailSize, tailSize, tail))
+    {
+    return false;
+    }
+  vtkTypeInt64 endRecord = -1;
+  for (vtkTypeInt64 position = tailSize - endRecordSize; position >= 0; --position)
+    {
+    if (ReadLittleEndian(&tail[position], 4) == 0x06054b50)
+      {
+      endRecord = position;
+      break;
+      }
+    }
+  if (endRecord < 0)
+    {
+    vtkArchiveTools::Error("Find stored member: not a zip file", zipFileName);
+    return false;
+    }
+  vtkTypeUInt64 numberOfEntries = ReadLittleEndian(&tail[endRecord + 10], 2);
+  vtkTypeInt64 directorySize = ReadLittleEndian(&tail[endRecord + 12], 4);
+  vtkTypeInt64 directoryOffset = ReadLittleEndian(&tail[endRecord + 16], 4);
+  if (numberOfEntries == 0xffff || directorySize == 0xffffffff || directoryOffset == 0xffffffff)
+    {
+    // zip64, the locator precedes the end of central directory record
+    std::vector<unsigned char> zip64EndRecord;
+    if (endRecord < 20 || ReadLittleEndian(&tail[endRecord - 20], 4) != 0x07064b50
+      || !ReadFileRange(file, ReadLittleEndian(&tail[endRecord - 12], 8), 56, zip64EndRecord)
+      || ReadLittleEndian(&zip64EndRecord[0], 4) != 0x06064b50)
+      {
+      vtkArchiveTools::Error("Find stored member: invalid zip64 file", zipFileName);
+      return false;
+      }
+    numberOfEntries = ReadLittleEndian(&zip64EndRecord[32], 8);
+    directorySize = ReadLittleEndian(&zip64EndRecord[40], 8);
+    directoryOffset = ReadLittleEndian(&zip64EndRecord[48], 8);
+    }
+
+  std::vector<unsigned char> directory;
+  if (!ReadFileRange(file, directoryOffset, directorySize, directory))
+    {
+    vtkArchiveTools::Error("Find stored member: cannot read central directory of", zipFileName);
+    return false;
+    }
+  size_t memberNameLength = strlen(memberName);
+  size_t position = 0;
+  for (vtkTypeUInt64 entry = 0; entry < numberOfEntries; ++entry)
+    {
+    if (position + 46 > directory.size()
+      || ReadLittleEndian(&directory[position], 4) != 0x02014b50)
+      {
+      vtkArchiveTools::Error("Find stored member: invalid central directory in", zipFileName);
+      return false;
+      }
+    const unsigned char* header = &directory[position];
+    size_t nameLength = ReadLittleEndian(header + 28, 2);
+    size_t extraLength = ReadLittleEndian(header + 30, 2);
+    size_t commentLength = ReadLittleEndian(header + 32, 2);
+    if (position + 46 + nameLength + extraLength > directory.size())
+      {
+      vtkArchiveTools::Error("Find stored member: invalid central directory in", zipFileName);
+      return false;
+      }
+    if (nameLength != memberNameLength
+      || memcmp(header + 46, memberName, nameLength) != 0)
+      {
+      position += 46 + nameLength + extraLength + commentLength;
+      continue;
+      }
+
+    bool encrypted = (ReadLittleEndian(header + 8, 2) & 0x1) != 0;
+    bool stored = (ReadLittleEndian(header + 10, 2) == 0);
+    if (encrypted || !stored)
+      {
+      return false;
+      }
+    vtkTypeUInt64 fields[3] = { ReadLittleEndian(header + 24, 4), // uncompressed size
+                                ReadLittleEndian(header + 20, 4), // compressed size
+                                ReadLittleEndian(header + 42, 4) }; // local header offset
+    // zip64 extended information replaces the fields set to 0xffffffff, in order
+    const unsigned char* extra = header + 46 + nameLength;
+    for (size_t extraPosition = 0; extraPosition + 4 <= extraLength; )
+      {
+      size_t dataLength = ReadLittleEndian(extra + extraPosition + 2, 2);
+      if (ReadLittleEndian(extra + extraPosition, 2) == 0x0001)
+        {
+        size_t dataPosition = extraPosition + 4;
+        for (int field = 0; field < 3; ++field)
+          {
+          if (fields[field] == 0xffffffff && dataPosition + 8 <= extraPosition + 4 + dataLength)
+            {
+            fields[field] = ReadLittleEndian(extra + dataPosition, 8);
+            dataPosition += 8;
+            }
+          }
+        }
+      extraPosition += 4 + dataLength;
+      }
+
+    std::vector<unsigned char> localHeader;
+    if (!ReadFileRange(file, fields[2], 30, localHeader)
+      || ReadLittleEndian(&localHeader[0], 4) != 0x04034b50)
+      {
+      vtkArchiveTools::Error("Find stored member: invalid local header for", memberName);
+      return false;
+      }
+    offset = fields[2] + 30 + ReadLittleEndian(&localHeader[26], 2) + ReadLittleEndian(&localHeader[28], 2);
+    size = fields[1];
+    return (offset + size <= fileSize);
+    }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+bool map_stored_zip_member(const char* zipFileName, const char* memberName,
+                           vtkArchiveMappedMember* member)
+{
+  //
+  // Mapping the member data
+  // - locate the member data in the zip file
+  // - map the pages that contain the data, the mapping must start at a
+  //   multiple of the allocation granularity
+  // - the file can be closed once mapped
+  //
+
+  if ( !member )
+    {
+    vtkArchiveTools::Error("Map stored member:", "Invalid member");
+    return false;
+    }
+  member->Data = 0;
+  member->Size = 0;
+  member->MappedAddress = 0;
+  member->MappedLength = 0;
+
+  vtkTypeInt64 offset = 0;
+  vtkTypeInt64 size = 0;
+  if ( !find_stored_zip_member(zipFileName, memberName, offset, size) )
+    {
+    return false;
+    }
+
+#ifdef _WIN32
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  vtkTypeInt64 granularity = systemInfo.dwAllocationGranularity;
+#else
+  vtkTypeInt64 granularity = sysconf(_SC_PAGESIZE);
+#endif
+  vtkTypeInt64 mappedOffset = offset - offset % granularity;
+  vtkTypeInt64 mappedLength = offset + size - mappedOffset;
+  if ( size == 0 || static_cast<vtkTypeUInt64>(mappedLength) > static_cast<size_t>(-1) )
+    {
+    // nothing to map, or too large for the address space
+    return false;
+    }
+
+  void* mappedAddress = 0;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(zipFileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    {
+    vtkArchiveTools::Error("Map stored member: cannot open", zipFileName);
+    return false;
+    }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping)
+    {
+    mappedAddress = MapViewOfFile(mapping, FILE_MAP_READ,
+                                  static_cast<DWORD>(mappedOffset >> 32),
+                                  static_cast<DWORD>(mappedOffset & 0xffffffff),
+                                  static_cast<SIZE_T>(mappedLength));
+    CloseHandle(mapping);
+    }
+  CloseHandle(file);
+#else
+  int fd = open(zipFileName, O_RDONLY);
+  if (fd < 0)
+    {
+    vtkArchiveTools::Error("Map stored member: cannot open", zipFileName);
+    return false;
+    }
+  mappedAddress = mmap(NULL, static_cast<size_t>(mappedLength), PROT_READ, MAP_SHARED,
+                       fd, static_cast<off_t>(mappedOffset));
+  if (mappedAddress == MAP_FAILED)
+    {
+    mappedAddress = 0;
+    }
+  close(fd);
+#endif
+  if (!mappedAddress)
+    {
+    vtkArchiveTools::Error("Map stored member: cannot map", memberName);
+    return false;
+    }
+
+  member->MappedAddress = mappedAddress;
+  member->MappedLength = mappedLength;
+  member->Data = static_cast<const char*>(mappedAddress) + (offset - mappedOffset);
+  member->Size = size;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void unmap_zip_member(vtkArchiveMappedMember* member)
+{
+  if ( !member || !member->MappedAddress )
+    {
+    return;
+    }
+#ifdef _WIN32
+  UnmapViewOfFile(member->MappedAddress);
+#else
+  munmap(member->MappedAddress, static_cast<size_t>(member->MappedLength));
+#endif
+  member->Data = 0;
+  member->Size = 0;
+  member->MappedAddress = 0;
+  member->MappedLength = 0;
+}
+
+//-----------------------------------------------------------------------------
+bool unzip_member(const char* zipFileName, const char* memberName, std::ostream& output)
+{
+  //
+  // Streaming a member
+  // - read the headers until the member is found
+  // - copy its data blocks, inflated by libarchive if needed, to the output
+  //
+
+  if ( !zipFileName || !memberName )
+    {
+    vtkArchiveTools::Error("Unzip member:", "Invalid zipfile or member name");
+    return false;
+    }
+
+  struct archive *zipArchive = archive_read_new();
+  archive_read_support_filter_all(zipArchive);
+  archive_read_support_format_all(zipArchive);
+  if (archive_read_open_filename(zipArchive, zipFileName, 10240) != ARCHIVE_OK)
+    {
+    vtkArchiveTools::Error("Unzip member: cannot open archive file", zipFileName);
+    archive_read_free(zipArchive);
+    return false;
+    }
+
+  bool found = false;
+  bool success = false;
+  struct archive_entry *entry;
+  int result;
+  while (!found
+    && (result = archive_read_next_header(zipArchive, &entry)) != ARCHIVE_EOF)
+    {
+    if (result < ARCHIVE_WARN)
+      {
+      vtkArchiveTools::Error("Unzip member error:", archive_error_string(zipArchive));
+      break;
+      }
+    const char* pathName = archive_entry_pathname(entry);
+    if (!pathName || strcmp(pathName, memberName) != 0)
+      {
+      continue;
+      }
+    found = true;
+    const void *buff;
+    size_t size;
+#if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3000000
+    __LA_INT64_T offset;
+#else
+    off_t offset;
+#endif
+    for (;;)
+      {
+      result = archive_read_data_block(zipArchive, &buff, &size, &offset);
+      if (result == ARCHIVE_EOF)
+        {
+        success = !output.fail();
+        break;
+        }
+      if (result != ARCHIVE_OK)
+        {
+        vtkArchiveTools::Error("Unzip member error:", archive_error_string(zipArchive));
+        break;
+        }
+      output.write(static_cast<const char*>(buff), size);
+      }
+    }
+
+  archive_read_close(zipArchive);
+  archive_read_free(zipArchive);
+  return success;
+}
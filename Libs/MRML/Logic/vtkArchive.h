@@ -13,7 +13,11 @@
 #ifndef __vtkArchive_h
 #define __vtkArchive_h
 
+// VTK includes
+#include <vtkType.h>
+
 // STD includes
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -37,11 +41,49 @@ VTK_MRML_LOGIC_EXPORT bool extract_tar(const char* tarFileName, bool verbose, bo
 
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
-VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip);
+// Files are stored without compression by default, so that they can be read
+// or memory mapped directly from the zip file (see map_stored_zip_member).
+// If compress is true, files are deflated except those that are already
+// compressed (gzip, zip, png, jpeg, compressed nrrd and metaimage).
+VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip,
+                               bool compress = false);
 
 // unzips zip file into specified directory
 // (internally this supports many formats of archive, not just zip)
 VTK_MRML_LOGIC_EXPORT bool unzip(const char* zipFileName, const char *destinationDirectory);
+
+// writes the content of a member of a zip file to output, without
+// extracting any file to disk. Compressed members are inflated.
+// Returns false if the member does not exist or cannot be read.
+VTK_MRML_LOGIC_EXPORT bool unzip_member(const char* zipFileName, const char* memberName,
+                                        std::ostream& output);
+
+// finds the data of a member stored without compression in a zip file
+// offset is the position of the first byte of the member data in the zip
+// file and size its length, so that the member can be read or memory mapped
+// directly from the zip file without extracting it.
+// Returns false if the member does not exist or is compressed.
+VTK_MRML_LOGIC_EXPORT bool find_stored_zip_member(const char* zipFileName, const char* memberName,
+                                                  vtkTypeInt64& offset, vtkTypeInt64& size);
+
+// memory mapped data of a member stored in a zip file
+struct vtkArchiveMappedMember
+{
+  const char* Data;
+  vtkTypeInt64 Size;
+  // mapped pages, Data points inside them
+  void* MappedAddress;
+  vtkTypeInt64 MappedLength;
+};
+
+// memory maps the data of a member stored without compression in a zip file
+// The data is read-only and remains valid until unmap_zip_member is called.
+// Returns false if the member does not exist, is compressed or empty.
+VTK_MRML_LOGIC_EXPORT bool map_stored_zip_member(const char* zipFileName, const char* memberName,
+                                                 vtkArchiveMappedMember* member);
+
+// releases a mapping made by map_stored_zip_member
+VTK_MRML_LOGIC_EXPORT void unmap_zip_member(vtkArchiveMappedMember* member);
 #ifdef __cplusplus
 }
 #endif
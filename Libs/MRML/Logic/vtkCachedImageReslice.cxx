@@ -0,0 +1,231 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkCachedImageReslice.h"
+
+// VTK includes
+#include <vtkAbstractImageInterpolator.h>
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkLinearTransform.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkCachedImageReslice);
+
+//----------------------------------------------------------------------------
+vtkCachedImageReslice::vtkCachedImageReslice()
+{
+  this->CacheSize = 4;
+  this->CacheHitCount = 0;
+  this->CacheInput = 0;
+  this->CacheInputMTime = 0;
+  this->CacheFilterMTime = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkCachedImageReslice::~vtkCachedImageReslice()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedImageReslice::SetCacheSize(int size)
+{
+  size = std::max(size, 0);
+  if (this->CacheSize == size)
+    {
+    return;
+    }
+  this->CacheSize = size;
+  while (static_cast<int>(this->Cache.size()) > this->CacheSize)
+    {
+    this->Cache.pop_back();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkCachedImageReslice::GetNumberOfCachedSlices()
+{
+  return static_cast<int>(this->Cache.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedImageReslice::ClearCache()
+{
+  this->Cache.clear();
+  this->CacheInput = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCachedImageReslice::GetCacheableMatrix(double matrix[16])
+{
+  vtkLinearTransform* linearTransform = vtkLinearTransform::SafeDownCast(this->GetResliceTransform());
+  if (linearTransform == 0 || this->GetResliceAxes() != 0)
+    {
+    return false;
+    }
+  vtkMatrix4x4::DeepCopy(matrix, linearTransform->GetMatrix());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCachedImageReslice::IsSameSliceStack(const double matrix1[16], const double matrix2[16])
+{
+  const double tolerance = 1e-6;
+  double scale = 0.0;
+  for (int row = 0; row < 3; ++row)
+    {
+    for (int column = 0; column < 3; ++column)
+      {
+      double element = matrix1[row * 4 + column];
+      if (fabs(element - matrix2[row * 4 + column]) > tolerance)
+        {
+        return false;
+        }
+      scale = std::max(scale, fabs(element));
+      }
+    }
+  // the translation may only change along the slice normal
+  double normal[3] = { matrix1[2], matrix1[6], matrix1[10] };
+  double translationDifference[3] =
+    {
+    matrix2[3] - matrix1[3],
+    matrix2[7] - matrix1[7],
+    matrix2[11] - matrix1[11]
+    };
+  double normalLength2 = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+  double alongNormal = normalLength2 > 0.0 ?
+    (translationDifference[0] * normal[0] + translationDifference[1] * normal[1]
+      + translationDifference[2] * normal[2]) / normalLength2 : 0.0;
+  for (int i = 0; i < 3; ++i)
+    {
+    if (fabs(translationDifference[i] - alongNormal * normal[i]) > tolerance * std::max(scale, 1.0))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkCachedImageReslice::RequestData(vtkInformation* request,
+                                       vtkInformationVector** inputVector,
+                                       vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+  double matrix[16];
+  if (this->CacheSize <= 0 || input == 0 || output == 0 || !this->GetCacheableMatrix(matrix))
+    {
+    this->ClearCache();
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+
+  // the slices must have been computed from the same input with the same parameters
+  vtkMTimeType filterMTime = this->MTime.GetMTime();
+  if (this->Interpolator)
+    {
+    filterMTime = std::max(filterMTime, this->Interpolator->GetMTime());
+    }
+  if (this->CacheInput != input || this->CacheInputMTime != input->GetMTime()
+      || this->CacheFilterMTime != filterMTime)
+    {
+    this->Cache.clear();
+    }
+
+  int updateExtent[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), updateExtent);
+  vtkImageStencilData* stencil = 0;
+  if (this->GetGenerateStencilOutput() && outputVector->GetNumberOfInformationObjects() > 1)
+    {
+    stencil = vtkImageStencilData::SafeDownCast(
+      outputVector->GetInformationObject(1)->Get(vtkDataObject::DATA_OBJECT()));
+    }
+  for (std::deque<CachedSlice>::iterator it = this->Cache.begin(); it != this->Cache.end(); ++it)
+    {
+    if (!std::equal(matrix, matrix + 16, it->Matrix))
+      {
+      continue;
+      }
+    int* cachedExtent = it->Image->GetExtent();
+    if (!std::equal(updateExtent, updateExtent + 6, cachedExtent))
+      {
+      continue;
+      }
+    output->ShallowCopy(it->Image);
+    if (stencil && it->Stencil)
+      {
+      stencil->DeepCopy(it->Stencil);
+      }
+    // move to the front as most recently used
+    CachedSlice slice = *it;
+    this->Cache.erase(it);
+    this->Cache.push_front(slice);
+    ++this->CacheHitCount;
+    return 1;
+    }
+
+  // only the slices of the same stack are kept, scrolling back reuses them
+  if (!this->Cache.empty() && !IsSameSliceStack(this->Cache.front().Matrix, matrix))
+    {
+    this->Cache.clear();
+    }
+
+  if (!this->Cache.empty())
+    {
+    // do not write into the scalars shared with the last cached slice
+    output->GetPointData()->Initialize();
+    }
+  int result = this->Superclass::RequestData(request, inputVector, outputVector);
+  if (!result)
+    {
+    return result;
+    }
+
+  CachedSlice slice;
+  std::copy(matrix, matrix + 16, slice.Matrix);
+  slice.Image = vtkSmartPointer<vtkImageData>::New();
+  slice.Image->ShallowCopy(output);
+  if (stencil)
+    {
+    slice.Stencil = vtkSmartPointer<vtkImageStencilData>::New();
+    slice.Stencil->DeepCopy(stencil);
+    }
+  this->Cache.push_front(slice);
+  while (static_cast<int>(this->Cache.size()) > this->CacheSize)
+    {
+    this->Cache.pop_back();
+    }
+  this->CacheInput = input;
+  this->CacheInputMTime = input->GetMTime();
+  this->CacheFilterMTime = filterMTime;
+  return result;
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedImageReslice::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "CacheSize: " << this->CacheSize << "\n";
+  os << indent << "NumberOfCachedSlices: " << this->Cache.size() << "\n";
+  os << indent << "CacheHitCount: " << this->CacheHitCount << "\n";
+}
@@ -0,0 +1,98 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkCachedImageReslice_h
+#define __vtkCachedImageReslice_h
+
+#include "vtkMRMLLogicExport.h"
+
+// VTK includes
+#include <vtkImageReslice.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <deque>
+
+class vtkImageData;
+class vtkImageStencilData;
+
+/// \brief Image reslice filter that keeps its last slices.
+///
+/// When only the offset of the slice changes (the reslice transform is
+/// translated along the slice normal), the slices previously computed in
+/// the same stack are kept, so scrolling back to one of them reuses it
+/// instead of reslicing the input again.
+/// The cache is cleared when the input, the filter parameters or the
+/// slice orientation, spacing or in-plane position change. It is only
+/// used with a linear reslice transform and no reslice axes.
+class VTK_MRML_LOGIC_EXPORT vtkCachedImageReslice : public vtkImageReslice
+{
+public:
+  static vtkCachedImageReslice *New();
+  vtkTypeMacro(vtkCachedImageReslice,vtkImageReslice);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Maximum number of slices kept. 0 disables the cache.
+  /// Default is 4.
+  void SetCacheSize(int size);
+  vtkGetMacro(CacheSize, int);
+
+  ///
+  /// Number of slices currently kept
+  int GetNumberOfCachedSlices();
+
+  ///
+  /// Number of executions that reused a kept slice
+  vtkGetMacro(CacheHitCount, int);
+
+  ///
+  /// Remove all the kept slices
+  void ClearCache();
+
+protected:
+  vtkCachedImageReslice();
+  ~vtkCachedImageReslice();
+
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector) VTK_OVERRIDE;
+
+  /// Get the matrix of the reslice transform in \a matrix.
+  /// Returns false if the slices cannot be cached for this transform.
+  bool GetCacheableMatrix(double matrix[16]);
+
+  /// Returns true if \a matrix1 and \a matrix2 only differ by a
+  /// translation along the slice normal (third column).
+  static bool IsSameSliceStack(const double matrix1[16], const double matrix2[16]);
+
+  struct CachedSlice
+  {
+    double Matrix[16];
+    vtkSmartPointer<vtkImageData> Image;
+    vtkSmartPointer<vtkImageStencilData> Stencil;
+  };
+
+  int CacheSize;
+  int CacheHitCount;
+  /// Most recently used slice first
+  std::deque<CachedSlice> Cache;
+  /// State the cached slices were computed with
+  vtkImageData* CacheInput;
+  vtkMTimeType CacheInputMTime;
+  vtkMTimeType CacheFilterMTime;
+
+private:
+  vtkCachedImageReslice(const vtkCachedImageReslice&);  // Not implemented.
+  void operator=(const vtkCachedImageReslice&);  // Not implemented.
+};
+
+#endif
@@ -32,6 +32,7 @@
 
 // MRML includes
 #include "vtkMRMLInteractionNode.h"
+#include "vtkMRMLModelNode.h"
 #include "vtkMRMLPlotViewNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLSelectionNode.h"
@@ -42,13 +43,18 @@
 #include "vtkMRMLSceneViewNode.h"
 #include "vtkMRMLTableViewNode.h"
 #include "vtkMRMLViewNode.h"
+#include "vtkMRMLVolumeNode.h"
 
 // VTK includes
 #include <vtkCollection.h>
+#include <vtkConditionVariable.h>
 #include <vtkImageData.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPNGWriter.h>
+#include <vtkPointSet.h>
+#include <vtkSimpleMutexLock.h>
 #include <vtkSmartPointer.h>
 
 // VTKSYS includes
@@ -56,6 +62,7 @@
 #include <vtksys/Glob.hxx>
 
 // STD includes
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
@@ -161,6 +168,8 @@ vtkMRMLApplicationLogic::vtkMRMLApplicationLogic()
   this->Internal->ViewLinkLogic->SetMRMLApplicationLogic(this);
   this->Internal->ModelHierarchyLogic->SetMRMLApplicationLogic(this);
   this->Internal->ColorLogic->SetMRMLApplicationLogic(this);
+  this->MaximumNumberOfWriteThreads = 0;
+  this->WriteMemoryBudget = 1024 * 1024;
 }
 
 //----------------------------------------------------------------------------
@@ -173,6 +182,8 @@ vtkMRMLApplicationLogic::~vtkMRMLApplicationLogic()
 void vtkMRMLApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumNumberOfWriteThreads: " << this->MaximumNumberOfWriteThreads << "\n";
+  os << indent << "WriteMemoryBudget: " << this->WriteMemoryBudget << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -743,8 +754,11 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char* s
     }
 
   // change all storage nodes and file names to be unique in the new directory
-  // write the new data as we go; save old values
+  // write the new data as we go, or queue it to be written concurrently; save old values
   this->OriginalStorageNodeFileNames.clear();
+  this->PendingWrites.clear();
+  this->PendingWriteFileNames.clear();
+  this->SaveFailedNodeIDs.clear();
 
   std::map<std::string, vtkMRMLNode *> storableNodes;
 
@@ -823,6 +837,9 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char* s
       }
     }
 
+  // write the data of the nodes that have been deferred
+  this->WritePendingStorableNodes();
+
   // write the scene to disk, changes paths to relative
   vtkDebugMacro("calling commit on the scene, to url " << this->GetMRMLScene()->GetURL());
   this->GetMRMLScene()->Commit();
@@ -974,22 +991,201 @@ void vtkMRMLApplicationLogic::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRM
 
   // Make sure the filename is unique (default filenames may be the same if for example there are multiple
   // nodes with the same name).
+  // Files of the pending writes do not exist yet, their names are reserved.
   std::string existingFileName = (storageNode->GetFileName() ? storageNode->GetFileName() : "");
-  if (vtksys::SystemTools::FileExists(existingFileName, true))
+  if (vtksys::SystemTools::FileExists(existingFileName, true)
+    || this->PendingWriteFileNames.count(existingFileName) > 0)
     {
     std::string currentExtension = storageNode->GetSupportedFileExtension(existingFileName.c_str());
-    std::string uniqueFileName = this->CreateUniqueFileName(existingFileName, currentExtension);
+    std::string uniqueFileName = this->CreateUniqueFileName(existingFileName, currentExtension,
+                                                            this->PendingWriteFileNames);
     vtkDebugMacro("file " << existingFileName << " already exists, use " << uniqueFileName << " filename instead");
     storageNode->SetFileName(uniqueFileName.c_str());
     }
 
-  storageNode->WriteData(storableNode);
- }
+  int maximumNumberOfThreads = this->MaximumNumberOfWriteThreads;
+  if (maximumNumberOfThreads <= 0)
+    {
+    maximumNumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  if (maximumNumberOfThreads > 1 && storageNode->CanWriteDataDetached(storableNode))
+    {
+    bool pending = false;
+    for (size_t i = 0; i < this->PendingWrites.size(); ++i)
+      {
+      pending = pending || this->PendingWrites[i].first == storageNode;
+      }
+    if (!pending && storageNode->PrepareWriteDataDetached(storableNode))
+      {
+      this->PendingWriteFileNames.insert(storageNode->GetFileName());
+      this->PendingWrites.push_back(std::make_pair(storageNode, storableNode));
+      return;
+      }
+    }
+
+  if (!storageNode->WriteData(storableNode))
+    {
+    vtkErrorMacro("SaveStorableNodeToSlicerDataBundleDirectory: failed to write data of node "
+      << storableNode->GetID() << " to " << storageNode->GetFileName());
+    this->SaveFailedNodeIDs.push_back(storableNode->GetID());
+    }
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+
+struct WriteDataDetachedThreadData
+{
+  std::vector<std::pair<vtkMRMLStorageNode*, vtkMRMLStorableNode*> > Jobs;
+  /// Estimated memory used while writing each job, in kibibytes
+  std::vector<unsigned long> JobSizes;
+  int NextJob;
+  unsigned long MemoryInUse;
+  unsigned long MemoryBudget;
+  vtkSimpleMutexLock* JobLock;
+  vtkSimpleConditionVariable* MemoryReleased;
+};
+
+//----------------------------------------------------------------------------
+unsigned long EstimateWriteMemorySize(vtkMRMLStorableNode* storableNode)
+{
+  // writers keep about one (compressed) copy of the data
+  vtkDataObject* data = NULL;
+  if (vtkMRMLVolumeNode::SafeDownCast(storableNode))
+    {
+    data = vtkMRMLVolumeNode::SafeDownCast(storableNode)->GetImageData();
+    }
+  else if (vtkMRMLModelNode::SafeDownCast(storableNode))
+    {
+    data = vtkMRMLModelNode::SafeDownCast(storableNode)->GetMesh();
+    }
+  return data ? data->GetActualMemorySize() : 0;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE WriteDataDetachedThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  WriteDataDetachedThreadData* threadData = static_cast<WriteDataDetachedThreadData*>(threadInfo->UserData);
+  int numberOfJobs = static_cast<int>(threadData->Jobs.size());
+  while (true)
+    {
+    threadData->JobLock->Lock();
+    int job = threadData->NextJob;
+    // wait for the nodes being written to release enough memory, a node
+    // larger than the budget is written alone
+    while (job < numberOfJobs
+      && threadData->MemoryBudget > 0
+      && threadData->MemoryInUse > 0
+      && threadData->MemoryInUse + threadData->JobSizes[job] > threadData->MemoryBudget)
+      {
+      threadData->MemoryReleased->Wait(*threadData->JobLock);
+      job = threadData->NextJob;
+      }
+    if (job < numberOfJobs)
+      {
+      ++threadData->NextJob;
+      threadData->MemoryInUse += threadData->JobSizes[job];
+      }
+    threadData->JobLock->Unlock();
+    if (job >= numberOfJobs)
+      {
+      break;
+      }
+
+    threadData->Jobs[job].first->WriteDataDetached(threadData->Jobs[job].second);
+
+    threadData->JobLock->Lock();
+    threadData->MemoryInUse -= threadData->JobSizes[job];
+    threadData->JobLock->Unlock();
+    threadData->MemoryReleased->Broadcast();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkMRMLApplicationLogic::WritePendingStorableNodes()
+{
+  if (this->PendingWrites.empty())
+    {
+    return;
+    }
+  int maximumNumberOfThreads = this->MaximumNumberOfWriteThreads;
+  if (maximumNumberOfThreads <= 0)
+    {
+    maximumNumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+
+  WriteDataDetachedThreadData threadData;
+  threadData.Jobs = this->PendingWrites;
+  for (size_t i = 0; i < threadData.Jobs.size(); ++i)
+    {
+    threadData.JobSizes.push_back(EstimateWriteMemorySize(threadData.Jobs[i].second));
+    }
+  vtkSimpleMutexLock jobLock;
+  vtkSimpleConditionVariable memoryReleased;
+  threadData.NextJob = 0;
+  threadData.MemoryInUse = 0;
+  threadData.MemoryBudget = this->WriteMemoryBudget;
+  threadData.JobLock = &jobLock;
+  threadData.MemoryReleased = &memoryReleased;
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(
+    std::max(1, std::min(maximumNumberOfThreads, static_cast<int>(threadData.Jobs.size()))));
+  threader->SetSingleMethod(WriteDataDetachedThreadFunction, &threadData);
+  threader->SingleMethodExecute();
+
+  // update the write state and stored time of the storage nodes on the
+  // main thread and collect the failures
+  for (size_t i = 0; i < this->PendingWrites.size(); ++i)
+    {
+    vtkMRMLStorageNode* storageNode = this->PendingWrites[i].first;
+    vtkMRMLStorableNode* storableNode = this->PendingWrites[i].second;
+    if (!storageNode->WriteData(storableNode))
+      {
+      vtkErrorMacro("WritePendingStorableNodes: failed to write data of node "
+        << storableNode->GetID() << " to " << storageNode->GetFileName());
+      this->SaveFailedNodeIDs.push_back(storableNode->GetID());
+      }
+    }
+  this->PendingWrites.clear();
+  this->PendingWriteFileNames.clear();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLApplicationLogic::GetNumberOfSaveFailedNodes()
+{
+  return static_cast<int>(this->SaveFailedNodeIDs.size());
+}
+
+//----------------------------------------------------------------------------
+const char* vtkMRMLApplicationLogic::GetNthSaveFailedNodeID(int n)
+{
+  if (n < 0 || n >= static_cast<int>(this->SaveFailedNodeIDs.size()))
+    {
+    vtkErrorMacro("GetNthSaveFailedNodeID: index " << n << " out of range");
+    return NULL;
+    }
+  return this->SaveFailedNodeIDs[n].c_str();
+}
 
 //----------------------------------------------------------------------------
 std::string vtkMRMLApplicationLogic::CreateUniqueFileName(const std::string &filename, const std::string& knownExtension)
 {
-  if (!vtksys::SystemTools::FileExists(filename.c_str()))
+  return vtkMRMLApplicationLogic::CreateUniqueFileName(filename, knownExtension, std::set<std::string>());
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLApplicationLogic::CreateUniqueFileName(const std::string &filename,
+                                                          const std::string& knownExtension,
+                                                          const std::set<std::string>& reservedFileNames)
+{
+  if (!vtksys::SystemTools::FileExists(filename.c_str())
+    && reservedFileNames.count(filename) == 0)
     {
     // filename is unique already
     return filename;
@@ -1041,7 +1237,8 @@ std::string vtkMRMLApplicationLogic::CreateUniqueFileName(const std::string &fil
     std::stringstream ss;
     ss << baseName << "_" << suffix << extension;
     uniqueFilename = ss.str();
-    if (!vtksys::SystemTools::FileExists(uniqueFilename))
+    if (!vtksys::SystemTools::FileExists(uniqueFilename)
+      && reservedFileNames.count(uniqueFilename) == 0)
       {
       // found unique filename
       break;
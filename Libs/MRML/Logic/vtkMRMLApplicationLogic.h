@@ -43,6 +43,8 @@ class vtkCollection;
 class vtkImageData;
 
 // STD includes
+#include <set>
+#include <string>
 #include <vector>
 
 class VTK_MRML_LOGIC_EXPORT vtkMRMLApplicationLogic
@@ -140,6 +142,8 @@ public:
   void PropagatePlotChartSelection();
 
   /// zip the directory into a zip file
+  /// Files are stored without compression, they can be read or memory
+  /// mapped directly from the zip file (see vtkArchive.h).
   /// Returns success or failure.
   bool Zip(const char* zipFileName, const char* directoryToZip);
 
@@ -165,6 +169,24 @@ public:
   /// Returns false if the save failed
   bool SaveSceneToSlicerDataBundleDirectory(const char* sdbDir, vtkImageData* screenShot = NULL);
 
+  /// Maximum number of threads used by SaveSceneToSlicerDataBundleDirectory()
+  /// to write the data files of the storable nodes concurrently.
+  /// 0 (default) uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads(),
+  /// 1 writes the files one after another.
+  vtkSetMacro(MaximumNumberOfWriteThreads, int);
+  vtkGetMacro(MaximumNumberOfWriteThreads, int);
+
+  /// Maximum size in kibibytes of the data being written concurrently by
+  /// SaveSceneToSlicerDataBundleDirectory(). A node larger than the budget
+  /// is written alone. 0 means no limit. 1048576 (1GiB) by default.
+  vtkSetMacro(WriteMemoryBudget, unsigned long);
+  vtkGetMacro(WriteMemoryBudget, unsigned long);
+
+  /// Nodes whose data could not be written by the last call to
+  /// SaveSceneToSlicerDataBundleDirectory()
+  int GetNumberOfSaveFailedNodes();
+  const char* GetNthSaveFailedNodeID(int n);
+
   /// Open the file into a temp directory and load the scene file
   /// inside.  Note that the first mrml file found in the extracted
   /// directory will be used.
@@ -232,6 +254,19 @@ protected:
   void SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode* storableNode,
                                                  std::string &dataDir);
 
+  /// Creates a unique file name that does not exist and is not in \a reservedFileNames.
+  /// \sa CreateUniqueFileName(const std::string&, const std::string&)
+  static std::string CreateUniqueFileName(const std::string &filename,
+                                          const std::string& knownExtension,
+                                          const std::set<std::string>& reservedFileNames);
+
+  /// Write the data of the nodes queued by SaveStorableNodeToSlicerDataBundleDirectory()
+  /// on up to MaximumNumberOfWriteThreads threads.
+  void WritePendingStorableNodes();
+
+  int MaximumNumberOfWriteThreads;
+  unsigned long WriteMemoryBudget;
+
 private:
 
   /// use a map to store the file names from a storage node, the 0th one is by
@@ -239,6 +274,16 @@ private:
   /// from GetNthFileName(n)
   std::map<vtkMRMLStorageNode*, std::vector<std::string> > OriginalStorageNodeFileNames;
 
+  /// Storage nodes that can be written from worker threads, waiting for
+  /// WritePendingStorableNodes()
+  std::vector<std::pair<vtkMRMLStorageNode*, vtkMRMLStorableNode*> > PendingWrites;
+
+  /// File names of PendingWrites, reserved until they are written
+  std::set<std::string> PendingWriteFileNames;
+
+  /// IDs of the nodes that failed to be written
+  std::vector<std::string> SaveFailedNodeIDs;
+
   vtkMRMLApplicationLogic(const vtkMRMLApplicationLogic&);
   void operator=(const vtkMRMLApplicationLogic&);
 
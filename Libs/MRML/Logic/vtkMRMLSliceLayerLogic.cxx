@@ -29,6 +29,7 @@
 #include <vtkAlgorithm.h>
 #include <vtkAlgorithmOutput.h>
 #include <vtkAssignAttribute.h>
+#include <vtkCallbackCommand.h>
 #include <vtkDiffusionTensorMathematics.h>
 #include <vtkFloatArray.h>
 #include <vtkGeneralTransform.h>
@@ -39,16 +40,20 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkTimerLog.h>
 #include <vtkTrivialProducer.h>
 #include <vtkTransform.h>
 #include <vtkVersion.h>
 #include <vtkAddonMathUtilities.h>
 
 //
+#include "vtkCachedImageReslice.h"
 #include "vtkImageLabelOutline.h"
 
 // STD includes
 #include <algorithm>
+#include <set>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkMRMLSliceLayerLogic);
@@ -110,6 +115,8 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
 
   this->XYToIJKTransform = vtkGeneralTransform ::New();
   this->UVWToIJKTransform = vtkGeneralTransform ::New();
+  this->LinearXYToIJKTransform = vtkTransform::New();
+  this->LinearUVWToIJKTransform = vtkTransform::New();
 
   this->IsLabelLayer = 0;
 
@@ -121,7 +128,8 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->AssignAttributeScalarsToTensorsUVW->Assign(vtkDataSetAttributes::SCALARS, vtkDataSetAttributes::TENSORS, vtkAssignAttribute::POINT_DATA);
 
   // Create the parts for the scalar layer pipeline
-  this->Reslice = vtkImageReslice::New();
+  // the previously resliced slices are reused when scrolling back to them
+  this->Reslice = vtkCachedImageReslice::New();
   this->ResliceUVW = vtkImageReslice::New();
   this->LabelOutline = vtkImageLabelOutline::New();
   this->LabelOutlineUVW = vtkImageLabelOutline::New();
@@ -146,6 +154,22 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->ResliceUVW->GenerateStencilOutputOn();
 
   this->UpdatingTransforms = 0;
+
+  this->PipelineTiming = false;
+  this->ResliceStartTime = -1.0;
+  this->LabelOutlineStartTime = -1.0;
+  this->DisplayStartTime = -1.0;
+  this->LastResliceTime = 0.0;
+  this->LastLabelOutlineTime = 0.0;
+  this->LastDisplayTime = 0.0;
+  this->ResliceExecutionCount = 0;
+  this->PipelineTimingCommand = vtkCallbackCommand::New();
+  this->PipelineTimingCommand->SetClientData(this);
+  this->PipelineTimingCommand->SetCallback(vtkMRMLSliceLayerLogic::PipelineTimingCallback);
+  this->Reslice->AddObserver(vtkCommand::StartEvent, this->PipelineTimingCommand);
+  this->Reslice->AddObserver(vtkCommand::EndEvent, this->PipelineTimingCommand);
+  this->LabelOutline->AddObserver(vtkCommand::StartEvent, this->PipelineTimingCommand);
+  this->LabelOutline->AddObserver(vtkCommand::EndEvent, this->PipelineTimingCommand);
 }
 
 //----------------------------------------------------------------------------
@@ -168,6 +192,12 @@ vtkMRMLSliceLayerLogic::~vtkMRMLSliceLayerLogic()
   this->SetVolumeNode(0);
   this->XYToIJKTransform->Delete();
   this->UVWToIJKTransform->Delete();
+  this->LinearXYToIJKTransform->Delete();
+  this->LinearUVWToIJKTransform->Delete();
+
+  // display pipeline filters may outlive the logic and still be observed
+  this->PipelineTimingCommand->SetClientData(0);
+  this->PipelineTimingCommand->Delete();
 
   this->Reslice->SetInputConnection( 0 );
   this->ResliceUVW->SetInputConnection( 0 );
@@ -476,6 +506,9 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
   // Ensure display node matches the one we are observing
   this->UpdateNodeReferences();
 
+  vtkMTimeType oldReSliceMTime = this->Reslice->GetMTime();
+  vtkMTimeType oldReSliceUVWMTime = this->ResliceUVW->GetMTime();
+
   int dimensions[3];
   dimensions[0] = 100;  // dummy values until SliceNode is set
   dimensions[1] = 100;
@@ -534,21 +567,23 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
     // vtkImageReslice works faster if the input is a linear transform, so try to convert it
     // to a linear transform.
     // Also attempt to make it a permute transform, as it makes reslicing even faster.
-    vtkSmartPointer<vtkTransform> linearXYToIJKTransform = vtkSmartPointer<vtkTransform>::New();
-    if (vtkMRMLTransformNode::IsGeneralTransformLinear(this->XYToIJKTransform, linearXYToIJKTransform))
+    vtkNew<vtkTransform> linearXYToIJKTransform;
+    if (vtkMRMLTransformNode::IsGeneralTransformLinear(this->XYToIJKTransform, linearXYToIJKTransform.GetPointer()))
       {
-      SnapToPermuteMatrix(linearXYToIJKTransform);
-      this->Reslice->SetResliceTransform(linearXYToIJKTransform);
+      SnapToPermuteMatrix(linearXYToIJKTransform.GetPointer());
+      this->SetLinearResliceTransform(this->Reslice,
+        this->LinearXYToIJKTransform, linearXYToIJKTransform.GetPointer());
       }
     else
       {
       this->Reslice->SetResliceTransform(this->XYToIJKTransform);
       }
-    vtkSmartPointer<vtkTransform> linearUVWToIJKTransform = vtkSmartPointer<vtkTransform>::New();
-    if (vtkMRMLTransformNode::IsGeneralTransformLinear(this->UVWToIJKTransform, linearUVWToIJKTransform))
+    vtkNew<vtkTransform> linearUVWToIJKTransform;
+    if (vtkMRMLTransformNode::IsGeneralTransformLinear(this->UVWToIJKTransform, linearUVWToIJKTransform.GetPointer()))
       {
-      SnapToPermuteMatrix(linearUVWToIJKTransform);
-      this->ResliceUVW->SetResliceTransform( linearUVWToIJKTransform );
+      SnapToPermuteMatrix(linearUVWToIJKTransform.GetPointer());
+      this->SetLinearResliceTransform(this->ResliceUVW,
+        this->LinearUVWToIJKTransform, linearUVWToIJKTransform.GetPointer());
       }
     else
       {
@@ -557,24 +592,6 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
 
   }
 
-  /***
-  // Optimisation: If there is no volume, calling or not Modified() won't
-  // have any visual impact. the transform has no sense if there is no volume
-  bool transformModified = this->VolumeNode &&
-    !AreMatricesEqual(this->XYToIJKTransform->GetMatrix(), xyToIJK.GetPointer());
-  if (transformModified)
-    {
-    this->XYToIJKTransform->SetMatrix(xyToIJK.GetPointer());
-    }
-
-  bool transformModifiedUVW = this->VolumeNode &&
-    !AreMatricesEqual(this->UVWToIJKTransform->GetMatrix(), uvwToIJK.GetPointer());
-  if (transformModifiedUVW)
-    {
-    this->UVWToIJKTransform->SetMatrix(uvwToIJK.GetPointer());
-    }
-  ***/
-
   this->Reslice->SetOutputExtent( 0, dimensions[0]-1,
                                   0, dimensions[1]-1,
                                   0, dimensions[2]-1);
@@ -585,12 +602,30 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
 
   this->UpdatingTransforms = 0;
 
-  //if (transformModified || transformModifiedUVW)
+  // Optimisation: if the slice geometry did not change (e.g. the slice node
+  // was modified for an unrelated property), the reslice filters are left
+  // untouched and their previous output is reused.
+  if (oldReSliceMTime != this->Reslice->GetMTime() ||
+      oldReSliceUVWMTime != this->ResliceUVW->GetMTime())
     {
     this->Modified();
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetLinearResliceTransform(vtkImageReslice* reslice,
+                                                       vtkTransform* currentLinearTransform,
+                                                       vtkTransform* linearTransform)
+{
+  if (reslice->GetResliceTransform() == currentLinearTransform &&
+      AreMatricesEqual(currentLinearTransform->GetMatrix(), linearTransform->GetMatrix()))
+    {
+    return;
+    }
+  currentLinearTransform->SetMatrix(linearTransform->GetMatrix());
+  reslice->SetResliceTransform(currentLinearTransform);
+}
+
 //----------------------------------------------------------------------------
 vtkImageData* vtkMRMLSliceLayerLogic::GetImageData()
 {
@@ -784,6 +819,11 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
       }
     }
 
+  if (this->PipelineTiming)
+    {
+    this->ObserveDisplayPipelineForTiming();
+    }
+
   if ( oldReSliceMTime != this->Reslice->GetMTime() ||
        oldReSliceUVWMTime != this->ResliceUVW->GetMTime() ||
        oldAssign != this->AssignAttributeTensorsToScalars->GetMTime() ||
@@ -897,6 +937,135 @@ void vtkMRMLSliceLayerLogic::UpdateGlyphs()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetPipelineTiming(bool enable)
+{
+  if (this->PipelineTiming == enable)
+    {
+    return;
+    }
+  this->PipelineTiming = enable;
+  this->ResliceStartTime = -1.0;
+  this->LabelOutlineStartTime = -1.0;
+  this->DisplayStartTime = -1.0;
+  this->LastResliceTime = 0.0;
+  this->LastLabelOutlineTime = 0.0;
+  this->LastDisplayTime = 0.0;
+  this->ResliceExecutionCount = 0;
+  if (this->PipelineTiming)
+    {
+    this->ObserveDisplayPipelineForTiming();
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::ObserveDisplayPipelineForTiming()
+{
+  vtkAlgorithmOutput* outputConnection = 0;
+  if (this->VolumeNode && this->VolumeDisplayNode)
+    {
+    outputConnection = this->VolumeDisplayNode->GetOutputImageDataConnection();
+    }
+  this->DisplayOutputAlgorithm = outputConnection ? outputConnection->GetProducer() : 0;
+
+  // Walk the display node pipeline upstream until the slice image, the
+  // filters in between map the resliced image to colors.
+  vtkAlgorithmOutput* sliceConnection = this->GetSliceImageDataConnection();
+  vtkAlgorithm* sliceAlgorithm = sliceConnection ? sliceConnection->GetProducer() : 0;
+  std::set<vtkAlgorithm*> visited;
+  std::vector<vtkAlgorithm*> algorithms;
+  if (this->DisplayOutputAlgorithm)
+    {
+    algorithms.push_back(this->DisplayOutputAlgorithm);
+    }
+  while (!algorithms.empty())
+    {
+    vtkAlgorithm* algorithm = algorithms.back();
+    algorithms.pop_back();
+    if (algorithm == sliceAlgorithm || algorithm == this->Reslice ||
+        !visited.insert(algorithm).second)
+      {
+      continue;
+      }
+    if (!algorithm->HasObserver(vtkCommand::StartEvent, this->PipelineTimingCommand))
+      {
+      algorithm->AddObserver(vtkCommand::StartEvent, this->PipelineTimingCommand);
+      algorithm->AddObserver(vtkCommand::EndEvent, this->PipelineTimingCommand);
+      }
+    for (int port = 0; port < algorithm->GetNumberOfInputPorts(); ++port)
+      {
+      for (int i = 0; i < algorithm->GetNumberOfInputConnections(port); ++i)
+        {
+        vtkAlgorithmOutput* input = algorithm->GetInputConnection(port, i);
+        if (input && input->GetProducer())
+          {
+          algorithms.push_back(input->GetProducer());
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::PipelineTimingCallback(vtkObject* caller,
+                                                    unsigned long eid,
+                                                    void* clientData,
+                                                    void* vtkNotUsed(callData))
+{
+  vtkMRMLSliceLayerLogic* self = reinterpret_cast<vtkMRMLSliceLayerLogic*>(clientData);
+  if (!self || !self->PipelineTiming)
+    {
+    return;
+    }
+  double now = vtkTimerLog::GetUniversalTime();
+  if (caller == self->Reslice)
+    {
+    if (eid == vtkCommand::StartEvent)
+      {
+      self->ResliceStartTime = now;
+      }
+    else if (self->ResliceStartTime >= 0.0)
+      {
+      self->LastResliceTime = now - self->ResliceStartTime;
+      self->ResliceStartTime = -1.0;
+      ++self->ResliceExecutionCount;
+      vtkDebugWithObjectMacro(self, "Reslice: " << self->LastResliceTime << "s");
+      }
+    }
+  else if (caller == self->LabelOutline)
+    {
+    if (eid == vtkCommand::StartEvent)
+      {
+      self->LabelOutlineStartTime = now;
+      }
+    else if (self->LabelOutlineStartTime >= 0.0)
+      {
+      self->LastLabelOutlineTime = now - self->LabelOutlineStartTime;
+      self->LabelOutlineStartTime = -1.0;
+      vtkDebugWithObjectMacro(self, "Label outline: " << self->LastLabelOutlineTime << "s");
+      }
+    }
+  else
+    {
+    // Display node filters execute one after the other, the stage starts
+    // with the first of them and ends with the display node output.
+    if (eid == vtkCommand::StartEvent)
+      {
+      if (self->DisplayStartTime < 0.0)
+        {
+        self->DisplayStartTime = now;
+        }
+      }
+    else if (caller == self->DisplayOutputAlgorithm && self->DisplayStartTime >= 0.0)
+      {
+      self->LastDisplayTime = now - self->DisplayStartTime;
+      self->DisplayStartTime = -1.0;
+      vtkDebugWithObjectMacro(self, "Display: " << self->LastDisplayTime << "s");
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLayerLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -991,4 +1160,13 @@ void vtkMRMLSliceLayerLogic::PrintSelf(ostream& os, vtkIndent indent)
     {
     os << indent << " (0)\n";
     }
+
+  os << indent << "PipelineTiming: " << this->PipelineTiming << "\n";
+  if (this->PipelineTiming)
+    {
+    os << indent << "LastResliceTime: " << this->LastResliceTime << "\n";
+    os << indent << "LastLabelOutlineTime: " << this->LastLabelOutlineTime << "\n";
+    os << indent << "LastDisplayTime: " << this->LastDisplayTime << "\n";
+    os << indent << "ResliceExecutionCount: " << this->ResliceExecutionCount << "\n";
+    }
 }
@@ -46,8 +46,11 @@
 #include <vtkImageLogic.h>
 #include <vtkImageExtractComponents.h>
 #include <vtkVersion.h>
+#include <vtkWeakPointer.h>
 
+class vtkAlgorithm;
 class vtkAssignAttribute;
+class vtkCallbackCommand;
 class vtkImageReslice;
 class vtkGeneralTransform;
 
@@ -85,7 +88,9 @@ public:
   void SetSliceNode (vtkMRMLSliceNode *SliceNode);
 
   ///
-  /// The image reslice or slice being used
+  /// The image reslice or slice being used.
+  /// Reslice is a vtkCachedImageReslice: when only the slice offset
+  /// changes, the last slices are kept and reused when scrolling back.
   vtkGetObjectMacro (Reslice, vtkImageReslice);
   vtkGetObjectMacro (ResliceUVW, vtkImageReslice);
 
@@ -129,6 +134,28 @@ public:
   /// The current reslice transform XYToIJK
   vtkGetObjectMacro (XYToIJKTransform, vtkGeneralTransform);
 
+  ///
+  /// Measure how long each stage of the slice pipeline takes to execute.
+  /// This is a debugging aid for finding out where the time goes when
+  /// browsing slices, it is off by default.
+  void SetPipelineTiming(bool enable);
+  vtkGetMacro (PipelineTiming, bool);
+  vtkBooleanMacro (PipelineTiming, bool);
+
+  ///
+  /// Duration in seconds of the last execution of the reslice filter,
+  /// of the label outline filter and of the display node filters that
+  /// apply window/level, threshold and lookup table to the slice.
+  /// Only measured when PipelineTiming is enabled.
+  vtkGetMacro (LastResliceTime, double);
+  vtkGetMacro (LastLabelOutlineTime, double);
+  vtkGetMacro (LastDisplayTime, double);
+
+  ///
+  /// Number of times the reslice filter executed since PipelineTiming
+  /// was enabled. Useful to check that a slice is not resliced again
+  /// when its geometry did not change.
+  vtkGetMacro (ResliceExecutionCount, int);
 
 protected:
   vtkMRMLSliceLayerLogic();
@@ -156,6 +183,20 @@ protected:
   // Copy VolumeDisplayNodeObserved into VolumeDisplayNode
   void UpdateVolumeDisplayNode();
 
+  /// Set \a linearTransform as reslice transform of \a reslice unless it
+  /// already uses a transform with the same matrix. Keeping the transform
+  /// unchanged avoids reslicing again when the slice geometry is the same.
+  void SetLinearResliceTransform(vtkImageReslice* reslice,
+                                 vtkTransform* currentLinearTransform,
+                                 vtkTransform* linearTransform);
+
+  /// Observe the filters of the display node pipeline to measure the
+  /// display stage duration when PipelineTiming is enabled.
+  void ObserveDisplayPipelineForTiming();
+
+  static void PipelineTimingCallback(vtkObject* caller, unsigned long eid,
+                                     void* clientData, void* callData);
+
   ///
   /// the MRML Nodes that define this Logic's parameters
   vtkMRMLVolumeNode *VolumeNode;
@@ -179,9 +220,28 @@ protected:
   vtkGeneralTransform *XYToIJKTransform;
   vtkGeneralTransform *UVWToIJKTransform;
 
+  /// Linear approximations of XYToIJKTransform and UVWToIJKTransform,
+  /// kept between updates so the reslice filters are only modified when
+  /// the matrices change.
+  vtkTransform *LinearXYToIJKTransform;
+  vtkTransform *LinearUVWToIJKTransform;
+
   int IsLabelLayer;
 
   int UpdatingTransforms;
+
+  bool PipelineTiming;
+  vtkCallbackCommand *PipelineTimingCommand;
+  double ResliceStartTime;
+  double LabelOutlineStartTime;
+  double DisplayStartTime;
+  double LastResliceTime;
+  double LastLabelOutlineTime;
+  double LastDisplayTime;
+  int ResliceExecutionCount;
+  /// Last filter of the display node pipeline, its end marks the end of
+  /// the display stage.
+  vtkWeakPointer<vtkAlgorithm> DisplayOutputAlgorithm;
 };
 
 #endif
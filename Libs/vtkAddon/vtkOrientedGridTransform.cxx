@@ -9,10 +9,15 @@
 
 #include "vtkOrientedGridTransform.h"
 
+#include "vtkImageData.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkSimpleMutexLock.h"
+
+#include <algorithm>
+#include <vector>
 
 vtkStandardNewMacro(vtkOrientedGridTransform);
 
@@ -26,6 +31,14 @@ vtkOrientedGridTransform::vtkOrientedGridTransform()
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
 
   this->LastWarningMTime = 0;
+
+  this->CacheInverseGrid = false;
+  this->InverseGridCached = NULL;
+  this->InverseGridPointer = NULL;
+  this->InverseGridIncrements[0] = 0;
+  this->InverseGridIncrements[1] = 0;
+  this->InverseGridIncrements[2] = 0;
+  this->InverseGridLock = vtkSimpleMutexLock::New();
 }
 
 //----------------------------------------------------------------------------
@@ -42,6 +55,13 @@ vtkOrientedGridTransform::~vtkOrientedGridTransform()
     this->OutputToGridIndexTransformMatrixCached->Delete();
     this->OutputToGridIndexTransformMatrixCached = NULL;
     }
+  if (this->InverseGridCached)
+    {
+    this->InverseGridCached->Delete();
+    this->InverseGridCached = NULL;
+    }
+  this->InverseGridLock->Delete();
+  this->InverseGridLock = NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -54,6 +74,8 @@ void vtkOrientedGridTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GridDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "CacheInverseGrid: " << this->CacheInverseGrid << "\n";
+  os << indent << "InverseGrid: " << this->GetInverseGrid() << "\n";
 }
 
 //------------------------------------------------------------------------
@@ -174,6 +196,30 @@ void vtkOrientedGridTransform::ForwardTransformDerivative(const double inPoint[3
   outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
 }
 
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InverseTransformPoint(const double inPoint[3],
+                                                     double outPoint[3])
+{
+  if (this->UpdateInverseGridIfNeeded())
+    {
+    // Use the interpolated inverse if it maps back to the input point within tolerance
+    double inverse[3];
+    double forward[3];
+    this->InterpolateInverseGrid(inPoint, inverse);
+    this->ForwardTransformPoint(inverse, forward);
+    if (vtkMath::Distance2BetweenPoints(forward, inPoint) < this->InverseTolerance * this->InverseTolerance)
+      {
+      outPoint[0] = inverse[0];
+      outPoint[1] = inverse[1];
+      outPoint[2] = inverse[2];
+      return;
+      }
+    }
+
+  double derivative[3][3];
+  this->InverseTransformDerivative(inPoint, outPoint, derivative);
+}
+
 //----------------------------------------------------------------------------
 void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3],
                                                   double outPoint[3],
@@ -185,6 +231,79 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     return;
     }
 
+  double errorSquared = 0.0;
+  int numberOfIterations = 0;
+  bool converged = this->InverseTransformDerivativeInternal(inPoint, outPoint, derivative,
+    errorSquared, numberOfIterations);
+
+  vtkDebugMacro("Inverse Iterations: " << numberOfIterations);
+
+  if (!converged)
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                      ") error = " << sqrt(errorSquared) << " after " <<
+                      numberOfIterations << " iterations."
+                      "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedGridTransform::GetNumberOfInverseIterations(const double point[3])
+{
+  this->Update();
+  if (this->GridDirectionMatrix == NULL || this->GridPointer == NULL)
+    {
+    vtkErrorMacro("GetNumberOfInverseIterations: displacement grid or grid direction matrix is not set");
+    return -1;
+    }
+  double inverse[3];
+  double derivative[3][3];
+  double errorSquared = 0.0;
+  int numberOfIterations = 0;
+  this->InverseTransformDerivativeInternal(point, inverse, derivative, errorSquared, numberOfIterations);
+  return numberOfIterations;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InverseTransformDerivativeInternal(const double inPoint[3],
+  double outPoint[3], double derivative[3][3], double& errorSquared, int& numberOfIterations)
+{
+  double initialGuess[3];
+  bool useInitialGuess = false;
+  if (this->UpdateInverseGridIfNeeded())
+    {
+    // Use the interpolated inverse if it maps back to the input point within tolerance,
+    // otherwise use it as starting point of the iteration.
+    double forward[3];
+    this->InterpolateInverseGrid(inPoint, initialGuess);
+    this->ForwardTransformDerivative(initialGuess, forward, derivative);
+    errorSquared = vtkMath::Distance2BetweenPoints(forward, inPoint);
+    if (errorSquared < this->InverseTolerance * this->InverseTolerance)
+      {
+      outPoint[0] = initialGuess[0];
+      outPoint[1] = initialGuess[1];
+      outPoint[2] = initialGuess[2];
+      numberOfIterations = 0;
+      return true;
+      }
+    useInitialGuess = true;
+    }
+
+  return this->InverseTransformDerivativeNewton(inPoint, useInitialGuess ? initialGuess : NULL,
+    outPoint, derivative, errorSquared, numberOfIterations);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InverseTransformDerivativeNewton(const double inPoint[3],
+  const double initialGuess[3], double outPoint[3], double derivative[3][3],
+  double& errorSquared, int& numberOfIterations)
+{
   void *gridPtr = this->GridPointer;
   int gridType = this->GridScalarType;
 
@@ -201,24 +320,33 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
   double functionDerivative = 0;
   double lastFunctionValue = VTK_DOUBLE_MAX;
 
-  double errorSquared = 0.0;
+  errorSquared = 0.0;
   double toleranceSquared = this->InverseTolerance;
   toleranceSquared *= toleranceSquared;
 
   double f = 1.0;
   double a;
 
-  // convert the inPoint to i,j,k indices plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+  if (initialGuess)
+    {
+    inverse[0] = initialGuess[0];
+    inverse[1] = initialGuess[1];
+    inverse[2] = initialGuess[2];
+    }
+  else
+    {
+    // convert the inPoint to i,j,k indices plus fractions
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
 
-  // first guess at inverse point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->InterpolationFunction(point, deltaP, NULL,
-                              gridPtr, gridType, extent, increments);
+    // first guess at inverse point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->InterpolationFunction(point, deltaP, NULL,
+                                gridPtr, gridType, extent, increments);
 
-  inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
-  inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
-  inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
+    inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
+    inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -315,31 +443,134 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
-  vtkDebugMacro("Inverse Iterations: " << (i+1));
+  numberOfIterations = i + 1;
 
-  if (i >= n)
+  bool converged = (i < n);
+  if (!converged)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
-
-    if (this->MTime > this->LastWarningMTime)
-      {
-      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                      ") error = " << sqrt(errorSquared) << " after " <<
-                      i << " iterations."
-                      "  Further convergence warnings suppressed until transform is modified.");
-      this->LastWarningMTime = this->MTime;
-      }
-    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
     }
 
   // convert point
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InterpolateInverseGrid(const double inPoint[3], double outPoint[3])
+{
+  double point[3];
+  double displacement[3];
+  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+  this->InterpolationFunction(point, displacement, NULL,
+                              this->InverseGridPointer, VTK_DOUBLE, this->GridExtent, this->InverseGridIncrements);
+  outPoint[0] = inPoint[0] + displacement[0];
+  outPoint[1] = inPoint[1] + displacement[1];
+  outPoint[2] = inPoint[2] + displacement[2];
+}
+
+//----------------------------------------------------------------------------
+struct vtkOrientedGridTransformInverseGridThreadData
+{
+  vtkOrientedGridTransform* Transform;
+  std::vector<int> NumberOfConvergenceFailures;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkOrientedGridTransform::UpdateInverseGridThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkOrientedGridTransformInverseGridThreadData* data =
+    static_cast<vtkOrientedGridTransformInverseGridThreadData*>(threadInfo->UserData);
+  vtkOrientedGridTransform* self = data->Transform;
+  const int* extent = self->GridExtent;
+
+  // Slices are distributed between the threads
+  for (int k = extent[4] + threadInfo->ThreadID; k <= extent[5]; k += threadInfo->NumberOfThreads)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      double* inverseGridPtr = static_cast<double*>(self->InverseGridCached->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; ++i, inverseGridPtr += 3)
+        {
+        double gridIndex[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+        double point[3];
+        vtkLinearTransformPoint(self->GridIndexToOutputTransformMatrixCached->Element, gridIndex, point);
+        double inverse[3];
+        double derivative[3][3];
+        double errorSquared = 0.0;
+        int numberOfIterations = 0;
+        if (!self->InverseTransformDerivativeNewton(point, NULL, inverse, derivative, errorSquared, numberOfIterations))
+          {
+          data->NumberOfConvergenceFailures[threadInfo->ThreadID]++;
+          }
+        inverseGridPtr[0] = inverse[0] - point[0];
+        inverseGridPtr[1] = inverse[1] - point[1];
+        inverseGridPtr[2] = inverse[2] - point[2];
+        }
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::UpdateInverseGridIfNeeded()
+{
+  if (!this->CacheInverseGrid || this->GridDirectionMatrix == NULL || this->GridPointer == NULL)
+    {
+    return false;
+    }
+  // Inverse transformation is often computed from multiple threads (for example
+  // when resampling a volume), only the first one computes the inverse grid.
+  this->InverseGridLock->Lock();
+  if (this->InverseGridPointer == NULL)
+    {
+    this->UpdateInverseGrid();
+    }
+  this->InverseGridLock->Unlock();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateInverseGrid()
+{
+  if (!this->InverseGridCached)
+    {
+    this->InverseGridCached = vtkImageData::New();
+    }
+  this->InverseGridCached->SetExtent(this->GridExtent);
+  this->InverseGridCached->AllocateScalars(VTK_DOUBLE, 3);
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = std::min(threader->GetNumberOfThreads(), this->GridExtent[5] - this->GridExtent[4] + 1);
+  numberOfThreads = std::max(numberOfThreads, 1);
+  vtkOrientedGridTransformInverseGridThreadData data;
+  data.Transform = this;
+  data.NumberOfConvergenceFailures.resize(numberOfThreads, 0);
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(vtkOrientedGridTransform::UpdateInverseGridThreadFunction, &data);
+  threader->SingleMethodExecute();
+
+  int numberOfConvergenceFailures = 0;
+  for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+    {
+    numberOfConvergenceFailures += data.NumberOfConvergenceFailures[threadIndex];
+    }
+  if (numberOfConvergenceFailures > 0)
+    {
+    vtkWarningMacro("UpdateInverseGrid: inverse computation did not converge at "
+      << numberOfConvergenceFailures << " grid points");
+    }
+
+  this->InverseGridPointer = this->InverseGridCached->GetScalarPointer();
+  this->InverseGridCached->GetIncrements(this->InverseGridIncrements);
 }
 
 //----------------------------------------------------------------------------
@@ -348,6 +579,7 @@ void vtkOrientedGridTransform::InternalDeepCopy(vtkAbstractTransform *transform)
   vtkOrientedGridTransform *gridTransform = (vtkOrientedGridTransform *)transform;
 
   this->SetGridDirectionMatrix(gridTransform->GetGridDirectionMatrix());
+  this->SetCacheInverseGrid(gridTransform->GetCacheInverseGrid());
 
   // Cached matrices will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
@@ -385,6 +617,16 @@ void vtkOrientedGridTransform::InternalUpdate()
   // Compute Output to GridIndex transform
   vtkMatrix4x4::Invert(this->GridIndexToOutputTransformMatrixCached, this->OutputToGridIndexTransformMatrixCached);
 
+  // Inverse grid depends on the displacement grid and the cached matrices,
+  // it is recomputed at the next inverse transformation
+  this->InverseGridLock->Lock();
+  this->InverseGridPointer = NULL;
+  if (!this->CacheInverseGrid && this->InverseGridCached)
+    {
+    this->InverseGridCached->Delete();
+    this->InverseGridCached = NULL;
+    }
+  this->InverseGridLock->Unlock();
 }
 
 //----------------------------------------------------------------------------
@@ -20,6 +20,10 @@
 
 #include "vtkCommand.h"
 #include "vtkGridTransform.h"
+#include "vtkMultiThreader.h"
+
+class vtkImageData;
+class vtkSimpleMutexLock;
 
 class VTK_ADDON_EXPORT vtkOrientedGridTransform : public vtkGridTransform
 {
@@ -36,6 +40,34 @@ public:
   virtual void SetGridDirectionMatrix(vtkMatrix4x4*);
   vtkGetObjectMacro(GridDirectionMatrix,vtkMatrix4x4);
 
+  // Description:
+  // If enabled, then the inverse displacement is computed at each grid point
+  // (using multiple threads) at the first inverse transformation after the
+  // transform is updated, and inverse transformation of a point uses
+  // interpolation of this inverse grid.
+  // If the interpolated point is not mapped back to the input point within
+  // InverseTolerance then Newton iteration is used, starting from the
+  // interpolated point. It makes inverse transformation of many points
+  // (such as resampling of volumes) much faster, at the cost of
+  // computing the inverse grid once after each change of the displacement grid.
+  // Transforms that are only used in the forward direction do not compute it.
+  // Disabled by default.
+  vtkSetMacro(CacheInverseGrid, bool);
+  vtkGetMacro(CacheInverseGrid, bool);
+  vtkBooleanMacro(CacheInverseGrid, bool);
+
+  // Description:
+  // Inverse displacement at each grid point.
+  // NULL if CacheInverseGrid is disabled or if no inverse transformation
+  // has been computed since the last update of the transform.
+  vtkImageData* GetInverseGrid() { return this->InverseGridPointer ? this->InverseGridCached : NULL; }
+
+  // Description:
+  // Number of Newton iterations that are needed to compute the inverse of
+  // the point. It is 0 if the interpolated inverse grid was accurate enough.
+  // Returns -1 if the displacement grid is not set.
+  int GetNumberOfInverseIterations(const double point[3]);
+
   // Description:
   // Make another transform of the same type.
   vtkAbstractTransform *MakeTransform() VTK_OVERRIDE;
@@ -65,6 +97,7 @@ protected:
   // the float versions)
   using vtkGridTransform::ForwardTransformPoint;
   using vtkGridTransform::ForwardTransformDerivative;
+  using vtkGridTransform::InverseTransformPoint;
   using vtkGridTransform::InverseTransformDerivative;
 
   // Description:
@@ -74,9 +107,44 @@ protected:
   void ForwardTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]) VTK_OVERRIDE;
 
+  void InverseTransformPoint(const double in[3], double out[3]) VTK_OVERRIDE;
+
   void InverseTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]) VTK_OVERRIDE;
 
+  // Description:
+  // Compute inverse using the interpolated inverse grid if it is accurate
+  // enough, by Newton iteration otherwise (numberOfIterations is 0 if the
+  // Newton iteration was not needed).
+  // Returns false if the iteration did not converge.
+  // Does not modify the transform, therefore it can be called from multiple threads.
+  bool InverseTransformDerivativeInternal(const double in[3], double out[3], double derivative[3][3],
+    double& errorSquared, int& numberOfIterations);
+
+  // Description:
+  // Compute inverse by Newton iteration, starting from initialGuess
+  // (if NULL then the input point minus the displacement is used).
+  // Returns false if the iteration did not converge.
+  // Does not modify the transform, therefore it can be called from multiple threads.
+  bool InverseTransformDerivativeNewton(const double in[3], const double initialGuess[3],
+    double out[3], double derivative[3][3], double& errorSquared, int& numberOfIterations);
+
+  // Description:
+  // Compute inverse by interpolating the cached inverse grid.
+  void InterpolateInverseGrid(const double in[3], double out[3]);
+
+  // Description:
+  // Compute the inverse grid if CacheInverseGrid is enabled and it has not
+  // been computed since the last update of the transform.
+  // Returns true if the inverse grid can be used.
+  // Can be called from multiple threads.
+  bool UpdateInverseGridIfNeeded();
+
+  // Description:
+  // Recompute the inverse grid. Must be called with InverseGridLock locked.
+  void UpdateInverseGrid();
+  static VTK_THREAD_RETURN_TYPE UpdateInverseGridThreadFunction(void* arg);
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -92,6 +160,16 @@ protected:
   // by keeping track of the MTime when the last warning was issued.
   vtkMTimeType LastWarningMTime;
 
+  // Description:
+  // Inverse displacement at each grid point (NULL if CacheInverseGrid is disabled).
+  // InverseGridPointer is NULL until the inverse grid is computed for the
+  // current displacement grid.
+  bool CacheInverseGrid;
+  vtkImageData* InverseGridCached;
+  void* InverseGridPointer;
+  vtkIdType InverseGridIncrements[3];
+  vtkSimpleMutexLock* InverseGridLock;
+
 private:
   vtkOrientedGridTransform(const vtkOrientedGridTransform&);  // Not implemented.
   void operator=(const vtkOrientedGridTransform&);  // Not implemented.
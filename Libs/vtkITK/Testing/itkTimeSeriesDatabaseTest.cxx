@@ -0,0 +1,227 @@
+#include <itkTimeSeriesDatabase.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+#include <itkImage.h>
+#include <itkImageFileWriter.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+typedef itk::TimeSeriesDatabase<short> DatabaseType;
+typedef DatabaseType::OutputImageType  ImageType;
+
+const int numberOfVolumes = 6;
+/// 3x3x2 blocks per volume, the last blocks along each axis are partial
+const unsigned int volumeSize[3] = { 40, 40, 20 };
+const unsigned long numberOfBlocksPerVolume = 18;
+
+//----------------------------------------------------------------------------
+short GetExpectedValue(int volume, const ImageType::IndexType& index)
+{
+  return static_cast<short>(1000 * volume + index[0] + index[1] + index[2]);
+}
+
+//----------------------------------------------------------------------------
+bool WriteVolumes(const std::string& directory)
+{
+  for (int volume = 0; volume < numberOfVolumes; ++volume)
+    {
+    ImageType::Pointer image = ImageType::New();
+    ImageType::SizeType size;
+    size[0] = volumeSize[0];
+    size[1] = volumeSize[1];
+    size[2] = volumeSize[2];
+    image->SetRegions(size);
+    image->Allocate();
+    itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      it.Set(GetExpectedValue(volume, it.GetIndex()));
+      }
+
+    std::ostringstream fileName;
+    fileName << directory << "/volume" << volume + 1 << ".nrrd";
+    typedef itk::ImageFileWriter<ImageType> WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName(fileName.str());
+    writer->SetInput(image);
+    try
+      {
+      writer->Update();
+      }
+    catch (itk::ExceptionObject& err)
+      {
+      std::cerr << "Unable to write file '" << fileName.str() << "', err = \n" << err << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+#define CHECK_VALUE(actual, expected) \
+  if ((actual) != (expected)) \
+    { \
+    std::cerr << "Line " << __LINE__ << ": " << #actual << " is " << (actual) \
+              << ", expected " << (expected) << std::endl; \
+    return EXIT_FAILURE; \
+    }
+
+//----------------------------------------------------------------------------
+int CheckVolume(DatabaseType* database, int volume)
+{
+  database->SetCurrentImage(volume);
+  database->Update();
+  ImageType* image = database->GetOutput();
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != GetExpectedValue(volume, it.GetIndex()))
+      {
+      std::cerr << "Volume " << volume << ": invalid value at " << it.GetIndex() << ": " << it.Get()
+                << ", expected " << GetExpectedValue(volume, it.GetIndex()) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Wait for the read-ahead thread to read the given number of blocks
+bool WaitForPrefetchedBlocks(DatabaseType* database, unsigned long numberOfBlocks)
+{
+  for (int i = 0; i < 1000 && database->GetNumberOfPrefetchedBlocks() < numberOfBlocks; ++i)
+    {
+    itksys::SystemTools::Delay(10);
+    }
+  return database->GetNumberOfPrefetchedBlocks() >= numberOfBlocks;
+}
+
+//----------------------------------------------------------------------------
+int TestRead(const std::string& databaseFileName)
+{
+  DatabaseType::Pointer database = DatabaseType::New();
+  database->Connect(databaseFileName.c_str());
+  CHECK_VALUE(database->GetNumberOfVolumes(), numberOfVolumes);
+
+  for (int volume = 0; volume < numberOfVolumes; ++volume)
+    {
+    if (CheckVolume(database, volume) != EXIT_SUCCESS)
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  CHECK_VALUE(database->GetNumberOfCacheMisses(), numberOfVolumes * numberOfBlocksPerVolume);
+  CHECK_VALUE(database->GetNumberOfPrefetchedBlocks(), 0ul);
+
+  // Time series of a voxel of a partial block
+  ImageType::IndexType index;
+  index[0] = 35;
+  index[1] = 2;
+  index[2] = 17;
+  DatabaseType::ArrayType timeSeries;
+  database->GetVoxelTimeSeries(index, timeSeries);
+  CHECK_VALUE(timeSeries.GetSize(), static_cast<unsigned int>(numberOfVolumes));
+  for (int volume = 0; volume < numberOfVolumes; ++volume)
+    {
+    CHECK_VALUE(timeSeries[volume], GetExpectedValue(volume, index));
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestReadAhead(const std::string& databaseFileName)
+{
+  DatabaseType::Pointer database = DatabaseType::New();
+  database->SetReadAheadNumberOfImages(2);
+  database->ReadAheadOn();
+  database->Connect(databaseFileName.c_str());
+
+  // The next two volumes are read ahead
+  if (CheckVolume(database, 0) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  CHECK_VALUE(WaitForPrefetchedBlocks(database, 2 * numberOfBlocksPerVolume), true);
+  database->ResetStatistics();
+  if (CheckVolume(database, 1) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  CHECK_VALUE(database->GetNumberOfCacheMisses(), 0ul);
+  CHECK_VALUE(database->GetNumberOfPrefetchHits(), numberOfBlocksPerVolume);
+
+  // Only the volume that is not cached yet is read ahead
+  CHECK_VALUE(WaitForPrefetchedBlocks(database, numberOfBlocksPerVolume), true);
+  for (int volume = 2; volume <= 3; ++volume)
+    {
+    if (CheckVolume(database, volume) != EXIT_SUCCESS)
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  CHECK_VALUE(database->GetNumberOfCacheMisses(), 0ul);
+  CHECK_VALUE(database->GetNumberOfPrefetchHits(), 3 * numberOfBlocksPerVolume);
+
+  // Stepping backward is predicted too, volumes requested while they are
+  // read ahead are still valid
+  for (int volume = numberOfVolumes - 1; volume >= 0; --volume)
+    {
+    if (CheckVolume(database, volume) != EXIT_SUCCESS)
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  database->ReadAheadOff();
+  database->Disconnect();
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 2)
+    {
+    std::cout << "ERROR: need to specify a temporary directory on the command line." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string testDirectory = std::string(argv[1]) + "/itkTimeSeriesDatabaseTest";
+  itksys::SystemTools::RemoveADirectory(testDirectory);
+  if (!itksys::SystemTools::MakeDirectory(testDirectory.c_str())
+    || !WriteVolumes(testDirectory))
+    {
+    std::cout << "ERROR: failed to write volumes in " << testDirectory << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string databaseFileName = testDirectory + "/database.tsd";
+  try
+    {
+    DatabaseType::CreateFromFileArchetype(databaseFileName.c_str(), (testDirectory + "/volume1.nrrd").c_str());
+    }
+  catch (itk::ExceptionObject& err)
+    {
+    std::cout << "Unable to create database, err = \n" << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (TestRead(databaseFileName) != EXIT_SUCCESS
+    || TestReadAhead(databaseFileName) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  itksys::SystemTools::RemoveADirectory(testDirectory);
+  return EXIT_SUCCESS;
+}
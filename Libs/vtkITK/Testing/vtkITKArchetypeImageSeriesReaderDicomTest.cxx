@@ -0,0 +1,331 @@
+#include <vtkITKArchetypeImageSeriesScalarReader.h>
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+#include <itkGDCMImageIO.h>
+#include <itkImage.h>
+#include <itkImageFileWriter.h>
+#include <itkMetaDataObject.h>
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+const int numberOfSlices = 10;
+
+//----------------------------------------------------------------------------
+/// Write a DICOM file of a single 8x8 slice at the given position.
+/// Content time is padded with a space, as found in some DICOM files.
+bool WriteDicomSlice(const std::string& fileName, const std::string& seriesInstanceUID, int sliceIndex,
+  double firstSlicePosition = 0.0)
+{
+  typedef itk::Image<short, 3> ImageType;
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size[0] = 8;
+  size[1] = 8;
+  size[2] = 1;
+  image->SetRegions(size);
+  ImageType::PointType origin;
+  origin[0] = 0.0;
+  origin[1] = 0.0;
+  origin[2] = firstSlicePosition + 2.5 * sliceIndex;
+  image->SetOrigin(origin);
+  image->Allocate();
+  image->FillBuffer(static_cast<short>(sliceIndex));
+
+  std::ostringstream instanceNumber;
+  instanceNumber << sliceIndex + 1;
+  itk::MetaDataDictionary& dictionary = image->GetMetaDataDictionary();
+  itk::EncapsulateMetaData<std::string>(dictionary, "0020|000d", "1.2.826.0.1.3680043.2.1125.1");
+  itk::EncapsulateMetaData<std::string>(dictionary, "0020|000e", seriesInstanceUID);
+  itk::EncapsulateMetaData<std::string>(dictionary, "0008|0018", seriesInstanceUID + "." + instanceNumber.str());
+  itk::EncapsulateMetaData<std::string>(dictionary, "0020|0013", instanceNumber.str());
+  itk::EncapsulateMetaData<std::string>(dictionary, "0008|0033", "120000.50 ");
+
+  itk::GDCMImageIO::Pointer dicomIO = itk::GDCMImageIO::New();
+  dicomIO->KeepOriginalUIDOn();
+  typedef itk::ImageFileWriter<ImageType> WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(dicomIO);
+  writer->SetFileName(fileName);
+  writer->SetInput(image);
+  try
+    {
+    writer->Update();
+    }
+  catch (itk::ExceptionObject& err)
+    {
+    std::cerr << "Unable to write file '" << fileName << "', err = \n" << err << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string GetSliceFileName(const std::string& directory, int sliceIndex, const std::string& prefix = "slice")
+{
+  std::ostringstream fileName;
+  fileName << directory << "/" << prefix << sliceIndex << ".dcm";
+  return fileName.str();
+}
+
+//----------------------------------------------------------------------------
+bool WriteDicomSeries(const std::string& directory, const std::string& seriesInstanceUID, int numberOfFiles)
+{
+  itksys::SystemTools::MakeDirectory(directory.c_str());
+  for (int sliceIndex = 0; sliceIndex < numberOfFiles; ++sliceIndex)
+    {
+    if (!WriteDicomSlice(GetSliceFileName(directory, sliceIndex), seriesInstanceUID, sliceIndex))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Analyze the headers of all the DICOM files in the directory of the archetype.
+/// Returns the number of files whose headers were found in the header index cache.
+int ReadSeriesInformation(const std::string& archetype, vtkITKArchetypeImageSeriesReader* reader)
+{
+  unsigned long numberOfHitsBefore = vtkITKArchetypeImageSeriesReader::GetNumberOfHeaderIndexCacheHits();
+  reader->SetArchetype(archetype.c_str());
+  reader->SetSingleFile(0);
+  reader->SetOutputScalarTypeToNative();
+  reader->SetDesiredCoordinateOrientationToNative();
+  reader->UpdateInformation();
+  return static_cast<int>(vtkITKArchetypeImageSeriesReader::GetNumberOfHeaderIndexCacheHits() - numberOfHitsBefore);
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> GetIndexFilePaths(const std::string& cacheDirectory)
+{
+  std::vector<std::string> indexFilePaths;
+  itksys::Directory directory;
+  if (!directory.Load(cacheDirectory))
+    {
+    return indexFilePaths;
+    }
+  for (unsigned long fileIndex = 0; fileIndex < directory.GetNumberOfFiles(); ++fileIndex)
+    {
+    std::string fileName = directory.GetFile(fileIndex);
+    if (itksys::SystemTools::GetFilenameLastExtension(fileName) == ".txt")
+      {
+      indexFilePaths.push_back(cacheDirectory + "/" + fileName);
+      }
+    }
+  return indexFilePaths;
+}
+
+//----------------------------------------------------------------------------
+int GetNumberOfIndexFiles(const std::string& cacheDirectory)
+{
+  return static_cast<int>(GetIndexFilePaths(cacheDirectory).size());
+}
+
+//----------------------------------------------------------------------------
+/// Remove the last tag value from each line of the index file,
+/// as if the file had been truncated or edited by hand
+bool TruncateIndexFileLines(const std::string& indexFilePath)
+{
+  std::ifstream indexFile(indexFilePath.c_str());
+  std::string line;
+  std::ostringstream truncatedContent;
+  // first line is the source directory
+  if (!std::getline(indexFile, line))
+    {
+    return false;
+    }
+  truncatedContent << line << "\n";
+  while (std::getline(indexFile, line))
+    {
+    truncatedContent << line.substr(0, line.rfind('\t')) << "\n";
+    }
+  indexFile.close();
+  std::ofstream truncatedIndexFile(indexFilePath.c_str());
+  truncatedIndexFile << truncatedContent.str();
+  return !truncatedIndexFile.fail();
+}
+
+//----------------------------------------------------------------------------
+#define CHECK_VALUE(actual, expected) \
+  if ((actual) != (expected)) \
+    { \
+    std::cerr << "Line " << __LINE__ << ": " << #actual << " is " << (actual) \
+              << ", expected " << (expected) << std::endl; \
+    return EXIT_FAILURE; \
+    }
+
+//----------------------------------------------------------------------------
+int TestHeaderIndexCache(const std::string& testDirectory)
+{
+  std::string seriesDirectory = testDirectory + "/Series";
+  std::string otherSeriesDirectory = testDirectory + "/OtherSeries";
+  std::string cacheDirectory = testDirectory + "/HeaderIndexCache";
+  if (!WriteDicomSeries(seriesDirectory, "1.2.826.0.1.3680043.2.1125.1.1", numberOfSlices))
+    {
+    return EXIT_FAILURE;
+    }
+  vtkITKArchetypeImageSeriesReader::SetHeaderIndexCacheDirectory(cacheDirectory);
+  vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries();
+  std::string archetype = GetSliceFileName(seriesDirectory, 0);
+
+  // All the headers are parsed, then stored in an index file
+  {
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  CHECK_VALUE(ReadSeriesInformation(archetype, reader.GetPointer()), 0);
+  CHECK_VALUE(reader->GetNumberOfImagePositionPatient(), static_cast<unsigned int>(numberOfSlices));
+  CHECK_VALUE(GetNumberOfIndexFiles(cacheDirectory), 1);
+  }
+
+  // Tag values are read from the index file
+  vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries();
+  {
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  CHECK_VALUE(ReadSeriesInformation(archetype, reader.GetPointer()), numberOfSlices);
+  CHECK_VALUE(reader->GetNumberOfImagePositionPatient(), static_cast<unsigned int>(numberOfSlices));
+  }
+
+  // Lines with missing tag values are ignored, the headers are parsed again
+  // and the index file is rewritten
+  CHECK_VALUE(TruncateIndexFileLines(GetIndexFilePaths(cacheDirectory)[0]), true);
+  vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries();
+  {
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  CHECK_VALUE(ReadSeriesInformation(archetype, reader.GetPointer()), 0);
+  CHECK_VALUE(reader->GetNumberOfImagePositionPatient(), static_cast<unsigned int>(numberOfSlices));
+  }
+  vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries();
+  {
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  CHECK_VALUE(ReadSeriesInformation(archetype, reader.GetPointer()), numberOfSlices);
+  }
+
+  // A file rewritten with the same size within the same second is parsed again
+  itksys::SystemTools::Delay(10);
+  if (!WriteDicomSlice(GetSliceFileName(seriesDirectory, 3), "1.2.826.0.1.3680043.2.1125.1.1", 3))
+    {
+    return EXIT_FAILURE;
+    }
+  vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries();
+  {
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  CHECK_VALUE(ReadSeriesInformation(archetype, reader.GetPointer()), numberOfSlices - 1);
+  CHECK_VALUE(reader->GetNumberOfImagePositionPatient(), static_cast<unsigned int>(numberOfSlices));
+  }
+
+  // Index files of directories that do not exist anymore are removed
+  if (!WriteDicomSeries(otherSeriesDirectory, "1.2.826.0.1.3680043.2.1125.1.2", 2))
+    {
+    return EXIT_FAILURE;
+    }
+  {
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  ReadSeriesInformation(GetSliceFileName(otherSeriesDirectory, 0), reader.GetPointer());
+  }
+  CHECK_VALUE(GetNumberOfIndexFiles(cacheDirectory), 2);
+  itksys::SystemTools::RemoveADirectory(otherSeriesDirectory);
+  vtkITKArchetypeImageSeriesReader::SetHeaderIndexCacheDirectory(cacheDirectory);
+  CHECK_VALUE(GetNumberOfIndexFiles(cacheDirectory), 1);
+
+  vtkITKArchetypeImageSeriesReader::SetHeaderIndexCacheDirectory("");
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Tag values read by one thread and by many threads must be grouped the same way,
+/// in the order of the files.
+int TestParallelHeaderScan(const std::string& testDirectory)
+{
+  std::string seriesDirectory = testDirectory + "/TwoSeries";
+  itksys::SystemTools::MakeDirectory(seriesDirectory.c_str());
+  for (int sliceIndex = 0; sliceIndex < numberOfSlices; ++sliceIndex)
+    {
+    if (!WriteDicomSlice(GetSliceFileName(seriesDirectory, sliceIndex, "a"),
+          "1.2.826.0.1.3680043.2.1125.1.3", sliceIndex)
+      || !WriteDicomSlice(GetSliceFileName(seriesDirectory, sliceIndex, "b"),
+          "1.2.826.0.1.3680043.2.1125.1.4", sliceIndex, 100.0))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  std::string archetype = GetSliceFileName(seriesDirectory, 0, "a");
+
+  int defaultNumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  std::vector<std::string> seriesInstanceUIDs[2];
+  std::vector<float> slicePositions[2];
+  std::vector<std::string> fileNames[2];
+  for (int run = 0; run < 2; ++run)
+    {
+    // headers are parsed by a single thread then by a pool of threads
+    vtkMultiThreader::SetGlobalDefaultNumberOfThreads(run == 0 ? 1 : std::max(defaultNumberOfThreads, 4));
+    vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries();
+    vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+    CHECK_VALUE(ReadSeriesInformation(archetype, reader.GetPointer()), 0);
+    CHECK_VALUE(reader->GetNumberOfSeriesInstanceUIDs(), 2u);
+    CHECK_VALUE(reader->GetNumberOfImagePositionPatient(), static_cast<unsigned int>(2 * numberOfSlices));
+    // spaces are removed from the values
+    CHECK_VALUE(reader->GetNumberOfContentTime(), 1u);
+    CHECK_VALUE(std::string(reader->GetNthContentTime(0)), std::string("120000.50"));
+    for (unsigned int n = 0; n < reader->GetNumberOfSeriesInstanceUIDs(); ++n)
+      {
+      seriesInstanceUIDs[run].push_back(reader->GetNthSeriesInstanceUID(n));
+      }
+    for (unsigned int n = 0; n < reader->GetNumberOfImagePositionPatient(); ++n)
+      {
+      slicePositions[run].push_back(reader->GetNthImagePositionPatient(n)[2]);
+      }
+    // only the files of the series of the archetype are loaded
+    fileNames[run] = reader->GetFileNames();
+    CHECK_VALUE(fileNames[run].size(), static_cast<size_t>(numberOfSlices));
+    }
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(defaultNumberOfThreads);
+
+  CHECK_VALUE(seriesInstanceUIDs[1] == seriesInstanceUIDs[0], true);
+  CHECK_VALUE(slicePositions[1] == slicePositions[0], true);
+  CHECK_VALUE(fileNames[1] == fileNames[0], true);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 2)
+    {
+    std::cout << "ERROR: need to specify a temporary directory on the command line." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string testDirectory = std::string(argv[1]) + "/vtkITKArchetypeImageSeriesReaderDicomTest";
+  itksys::SystemTools::RemoveADirectory(testDirectory);
+  if (!itksys::SystemTools::MakeDirectory(testDirectory.c_str()))
+    {
+    std::cout << "ERROR: failed to create directory " << testDirectory << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (TestHeaderIndexCache(testDirectory) != EXIT_SUCCESS
+    || TestParallelHeaderScan(testDirectory) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  itksys::SystemTools::RemoveADirectory(testDirectory);
+  return EXIT_SUCCESS;
+}
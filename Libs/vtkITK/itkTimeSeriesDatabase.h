@@ -5,8 +5,12 @@
 #include <itkImage.h>
 #include <itkArray.h>
 #include <itkImageSource.h>
+#include <itkConditionVariable.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleMutexLock.h>
 #include <iostream>
 #include <fstream>
+#include <deque>
 #include <itkTimeSeriesDatabaseHelper.h>
 
 #define TimeSeriesBlockSize 16
@@ -24,6 +28,12 @@ namespace itk
  * The main idea behind TimeSeriesDatabase is to have a representation of a 4 dimensional dataset that
  * is larger than main memory, but may still be accessed in a rapid manner.  Though not strictly
  * ITK conforming, this initial pass is strictly 4 dimensional datasets.
+ *
+ * Blocks are kept in a least recently used cache of bounded size (see SetCacheSizeInMiB).
+ * When ReadAhead is enabled, the images that are expected to be requested next are
+ * predicted from the sequence of requested images (for example stepping forward or
+ * backward through time) and the blocks of the last requested region in those images
+ * are read into the cache by a background thread.
  */
 template <class TPixel> class TimeSeriesDatabase : public ImageSource<Image<TPixel,3> > {
 public:
@@ -101,6 +111,41 @@ public:
    */
   float GetCacheSizeInMiB ();
 
+  /** Enable/disable reading blocks of the predicted next images in a
+   * background thread. Disabled by default.
+   * Prefetched blocks are stored in the cache, therefore read-ahead is limited
+   * by the cache size: the cache must be large enough to hold the blocks of
+   * the requested region in more than one image.
+   */
+  void SetReadAhead ( bool );
+  itkGetMacro ( ReadAhead, bool );
+  itkBooleanMacro ( ReadAhead );
+
+  /** Maximum number of images to read ahead. Default is 2.
+   */
+  itkSetMacro ( ReadAheadNumberOfImages, unsigned int );
+  itkGetMacro ( ReadAheadNumberOfImages, unsigned int );
+
+  /** Read blocks from memory mapped database files instead of file streams.
+   * Takes effect at the next Connect. Files that cannot be mapped (for example
+   * because of lack of address space) are read through file streams.
+   * Disabled by default.
+   */
+  itkSetMacro ( UseMemoryMapping, bool );
+  itkGetMacro ( UseMemoryMapping, bool );
+  itkBooleanMacro ( UseMemoryMapping );
+
+  /** Cache statistics since the last Connect or ResetStatistics call.
+   * Hits and misses count block requests of GenerateData and GetVoxelTimeSeries.
+   * PrefetchedBlocks is the number of blocks read by the read-ahead thread and
+   * PrefetchHits is the number of those that have been requested later.
+   */
+  unsigned long GetNumberOfCacheHits();
+  unsigned long GetNumberOfCacheMisses();
+  unsigned long GetNumberOfPrefetchedBlocks();
+  unsigned long GetNumberOfPrefetchHits();
+  void ResetStatistics();
+
 
 protected:
   TimeSeriesDatabase();
@@ -130,6 +175,19 @@ protected:
                                typename OutputImageType::RegionType& ImageRegion );
   bool IsOpen() const;
 
+  typedef TimeSeriesDatabaseHelper::counted_ptr<TimeSeriesDatabaseHelper::MappedFile> MappedFilePtr;
+
+  /// Read block at index from the mapped files or from the provided streams.
+  void ReadBlock ( unsigned long index, TPixel* data, std::vector<StreamPtr>& files );
+
+  /// Queue the blocks of the predicted next images for the read-ahead thread.
+  /// Must be called with m_CacheLock locked.
+  void ScheduleReadAhead ( const std::vector<Size<3> >& blocks );
+  void StartReadAheadThread();
+  void StopReadAheadThread();
+  static ITK_THREAD_RETURN_TYPE ReadAheadThreaderCallback ( void* arg );
+  void ProcessReadAheadRequests();
+
   /// How many pixels are in the last block?
   Array<unsigned int> m_PixelRemainder;
 
@@ -139,14 +197,42 @@ protected:
   std::vector<StreamPtr>   m_DatabaseFiles;
   std::vector<std::string> m_DatabaseFileNames;
   unsigned long            m_BlocksPerFile;
+  std::vector<MappedFilePtr> m_MappedFiles;
+  bool                       m_UseMemoryMapping;
 
   /// our cache
   struct CacheBlock
   {
     TPixel data[TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize];
+    /// Set if the block was read by the read-ahead thread and has not been requested yet
+    bool Prefetched;
   };
   TimeSeriesDatabaseHelper::LRUCache<unsigned long, CacheBlock> m_Cache;
-  CacheBlock* GetCacheBlock ( unsigned long index );
+  /// Copy length pixels starting at offset of the block at index into data.
+  /// The block is read and added to the cache if it is not cached yet.
+  /// Must be called with m_CacheLock unlocked: the lock is not held while
+  /// the block is read, so that the read-ahead thread is not blocked.
+  void CopyBlockData ( unsigned long index, unsigned long offset, unsigned long length, TPixel* data );
+
+  /// Protects the cache, the read-ahead queue and the statistics
+  SimpleMutexLock m_CacheLock;
+  /// Serializes reads from m_DatabaseFiles
+  SimpleMutexLock m_DatabaseFilesLock;
+
+  bool                      m_ReadAhead;
+  unsigned int              m_ReadAheadNumberOfImages;
+  int                       m_LastRequestedImage;
+  int                       m_ReadAheadImageStep;
+  std::deque<unsigned long> m_ReadAheadQueue;
+  MultiThreader::Pointer    m_ReadAheadThreader;
+  ConditionVariable::Pointer m_ReadAheadCondition;
+  int                       m_ReadAheadThreadId;
+  bool                      m_ReadAheadThreadActive;
+
+  unsigned long m_NumberOfCacheHits;
+  unsigned long m_NumberOfCacheMisses;
+  unsigned long m_NumberOfPrefetchedBlocks;
+  unsigned long m_NumberOfPrefetchHits;
 };
 
 } // end namespace itk
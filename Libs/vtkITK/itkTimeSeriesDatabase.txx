@@ -9,8 +9,11 @@
 #include <itksys/SystemTools.hxx>
 #include <itkImage.h>
 #include <itkImageFileReader.h>
+#include <itkMutexLockHolder.h>
 #include <itksys/SystemTools.hxx>
 #include "itkArchetypeSeriesFileNames.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <vector>
 
@@ -60,6 +63,8 @@ bool TimeSeriesDatabase<TPixel>::IsOpen () const
 template <class TPixel>
 void TimeSeriesDatabase<TPixel>::Disconnect ()
 {
+  this->StopReadAheadThread();
+  this->m_MappedFiles.clear();
   for ( int idx = 0; idx < this->m_DatabaseFiles.size(); idx++ )
     {
     this->m_DatabaseFiles[idx]->close();
@@ -130,6 +135,29 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
     // std::cout << "Reading file " << idx << " " << Filename << std::endl;
     this->m_DatabaseFileNames.push_back ( Filename );
     this->m_DatabaseFiles.push_back ( StreamPtr ( new std::fstream ( Filename.c_str(), ::std::ios::in | ::std::ios::binary ) ) );
+    MappedFilePtr mappedFile;
+    if ( this->m_UseMemoryMapping )
+      {
+      mappedFile = MappedFilePtr ( new TimeSeriesDatabaseHelper::MappedFile );
+      if ( !mappedFile->Open ( Filename.c_str() ) )
+        {
+        itkWarningMacro ( "TimeSeriesDatabase::Connect: failed to map " << Filename << ", using file stream" );
+        mappedFile = MappedFilePtr();
+        }
+      }
+    this->m_MappedFiles.push_back ( mappedFile );
+    }
+
+  // Blocks of a previously connected database are not valid anymore
+  this->m_CacheLock.Lock();
+  this->m_Cache.clear();
+  this->m_LastRequestedImage = -1;
+  this->m_ReadAheadImageStep = 1;
+  this->m_CacheLock.Unlock();
+  this->ResetStatistics();
+  if ( this->m_ReadAhead )
+    {
+    this->StartReadAheadThread();
     }
   /*
   std::cout << "ImageSize: " << m_OutputRegion.GetSize() << endl;
@@ -184,20 +212,67 @@ template <class TPixel>
 
 
 template <class TPixel>
-typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index )
+void TimeSeriesDatabase<TPixel>::ReadBlock ( unsigned long index, TPixel* data, std::vector<StreamPtr>& files )
 {
+  unsigned int FileIdx = this->CalculateFileIndex ( index );
+  const size_t BlockLength = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  ::std::streampos position = this->CalculatePosition ( index, this->m_BlocksPerFile );
+
+  if ( FileIdx < this->m_MappedFiles.size() && this->m_MappedFiles[FileIdx].get() )
+    {
+    const TimeSeriesDatabaseHelper::MappedFile* mappedFile = this->m_MappedFiles[FileIdx].get();
+    size_t offset = static_cast<size_t> ( position );
+    if ( offset + BlockLength <= mappedFile->GetSize() )
+      {
+      memcpy ( data, mappedFile->GetData() + offset, BlockLength );
+      return;
+      }
+    }
+
+  files[FileIdx]->seekg ( position );
+  files[FileIdx]->read ( reinterpret_cast<char*> ( data ), BlockLength );
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::CopyBlockData ( unsigned long index, unsigned long offset, unsigned long length, TPixel* data )
+{
+  this->m_CacheLock.Lock();
   CacheBlock* Buffer = this->m_Cache.find ( index );
-  if ( Buffer == 0 ) {
-    // Fill it in
-    CacheBlock B;
-    int FileIdx = this->CalculateFileIndex ( index );
-
-    this->m_DatabaseFiles[FileIdx]->seekg ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
-    this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( B.data ), TimeSeriesVolumeBlockSize * sizeof ( TPixel ) );
-    this->m_Cache.insert ( index, B );
-    Buffer = this->m_Cache.find ( index );
+  if ( Buffer ) {
+    this->m_NumberOfCacheHits++;
+    if ( Buffer->Prefetched )
+      {
+      this->m_NumberOfPrefetchHits++;
+      Buffer->Prefetched = false;
+      }
+    std::copy ( Buffer->data + offset, Buffer->data + offset + length, data );
+    this->m_CacheLock.Unlock();
+    return;
   }
-  return Buffer;
+  this->m_NumberOfCacheMisses++;
+  this->m_CacheLock.Unlock();
+
+  // Fill it in
+  CacheBlock* B = new CacheBlock;
+  B->Prefetched = false;
+  this->m_DatabaseFilesLock.Lock();
+  this->ReadBlock ( index, B->data, this->m_DatabaseFiles );
+  this->m_DatabaseFilesLock.Unlock();
+  std::copy ( B->data + offset, B->data + offset + length, data );
+
+  this->m_CacheLock.Lock();
+  // The read-ahead thread may have inserted the block while it was read
+  Buffer = this->m_Cache.find ( index );
+  if ( Buffer == 0 )
+    {
+    this->m_Cache.insert ( index, *B );
+    }
+  else
+    {
+    Buffer->Prefetched = false;
+    }
+  this->m_CacheLock.Unlock();
+  delete B;
 }
 
 
@@ -209,17 +284,16 @@ void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( typename OutputImageType::
   Size<3> CurrentBlock;
   Size<3> Offset;
   for ( int i = 0; i < 3; i++ ) {
-    if ( idx[i] < 0 || idx[i] > this->m_OutputRegion.Size[i] ) {
+    if ( idx[i] < 0 || idx[i] >= static_cast<IndexValueType> ( this->m_OutputRegion.GetSize(i) ) ) {
       throw 1;
     }
-    CurrentBlock[i] = reinterpret_cast<unsigned long> ( idx[i] / (double)TimeSeriesBlockSize );
+    CurrentBlock[i] = static_cast<unsigned long> ( idx[i] / TimeSeriesBlockSize );
     Offset[i] = idx[i] % TimeSeriesBlockSize;
   }
   unsigned long offset = Offset[0] + Offset[1] * TimeSeriesBlockSize + Offset[2] * TimeSeriesBlockSizeP2;
   array = ArrayType ( this->m_Dimensions[3] );
-  for ( int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
-    CacheBlock* cache = this->GetCacheBlock ( CurrentBlock, volume );
-    array[volume] = cache->data[offset];
+  for ( unsigned int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
+    this->CopyBlockData ( this->CalculateIndex ( CurrentBlock, volume ), offset, 1, &array[volume] );
   }
 }
 
@@ -263,8 +337,22 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
     output->Print ( std::cout );
     }
 
+  // Predict the next images from the step between the last two requested images
+  this->m_CacheLock.Lock();
+  int CurrentImage = static_cast<int> ( this->m_CurrentImage );
+  if ( this->m_LastRequestedImage >= 0 && this->m_LastRequestedImage != CurrentImage )
+    {
+    this->m_ReadAheadImageStep = CurrentImage - this->m_LastRequestedImage;
+    }
+  this->m_LastRequestedImage = CurrentImage;
+  this->m_CacheLock.Unlock();
+  std::vector<Size<3> > RequestedBlocks;
+  // Blocks are copied out of the cache, as cached blocks may be evicted
+  // by the read-ahead thread while they are used
+  std::vector<TPixel> BlockData ( TimeSeriesVolumeBlockSize );
+
   Size<3> CurrentBlock;
-  // Now, read our data, caching as we go, in future, make this thread safe
+  // Now, read our data, caching as we go
   Size<3> BlockSize = { {TimeSeriesBlockSize, TimeSeriesBlockSize, TimeSeriesBlockSize }};
   ImageRegion<3> BlockRegion;
   BlockRegion.SetSize ( BlockSize );
@@ -275,7 +363,9 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         typename OutputImageType::RegionType BR, IR;
         if ( print ) {  std::cout << "For Block Index: " << CurrentBlock << std::endl; }
         unsigned long index = this->CalculateIndex ( CurrentBlock, this->m_CurrentImage );
-        CacheBlock* Buffer = this->GetCacheBlock ( index );
+        this->CopyBlockData ( index, 0, TimeSeriesVolumeBlockSize, &BlockData[0] );
+        const TPixel* Buffer = &BlockData[0];
+        RequestedBlocks.push_back ( CurrentBlock );
         if ( this->CalculateIntersection ( CurrentBlock, Region, BR, IR ) ) {
           // Just iterate over whole block
           // Good we can use an iterator!
@@ -290,7 +380,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
           BlockRegion.SetIndex ( BlockIndex );
           ImageRegionIterator<OutputImageType> it ( output, IR );
           it.GoToBegin();
-          TPixel* ptr = Buffer->data;
+          const TPixel* ptr = Buffer;
           while ( !it.IsAtEnd() ) {
             it.Set ( *ptr );
             ++it;
@@ -305,7 +395,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
             std::cout << "Count: " << Count << std::endl;
             std::cout << "Block Region: " << BR;
             std::cout << "Image Region: " << IR;
-            std::cout << "First voxel: " << Buffer->data[0] << std::endl;
+            std::cout << "First voxel: " << Buffer[0] << std::endl;
           }
           unsigned int bx, by, bz, x, y, z;
           for ( z = 0; z < Count[2]; z++ ) {
@@ -325,7 +415,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
                 }
                 */
 
-                output->SetPixel ( ImageIndex, Buffer->data[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
+                output->SetPixel ( ImageIndex, Buffer[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
                 }
               }
             }
@@ -334,9 +424,158 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
       }
     }
 
+  if ( this->m_ReadAhead )
+    {
+    MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
+    this->ScheduleReadAhead ( RequestedBlocks );
+    }
   return;
 }
 
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ScheduleReadAhead ( const std::vector<Size<3> >& blocks )
+{
+  // Previous predictions that have not been read yet are obsolete
+  this->m_ReadAheadQueue.clear();
+
+  // Prefetched blocks must not evict the blocks of the current request
+  size_t MaximumQueueSize = 0;
+  if ( this->m_Cache.get_maxsize() > blocks.size() )
+    {
+    MaximumQueueSize = this->m_Cache.get_maxsize() - blocks.size();
+    }
+
+  int NumberOfImages = static_cast<int> ( this->m_Dimensions[3] );
+  for ( unsigned int ahead = 1; ahead <= this->m_ReadAheadNumberOfImages; ahead++ )
+    {
+    int image = this->m_LastRequestedImage + static_cast<int> ( ahead ) * this->m_ReadAheadImageStep;
+    if ( image < 0 || image >= NumberOfImages )
+      {
+      break;
+      }
+    for ( size_t blockIdx = 0; blockIdx < blocks.size(); blockIdx++ )
+      {
+      if ( this->m_ReadAheadQueue.size() >= MaximumQueueSize )
+        {
+        break;
+        }
+      this->m_ReadAheadQueue.push_back ( this->CalculateIndex ( blocks[blockIdx], image ) );
+      }
+    }
+
+  if ( !this->m_ReadAheadQueue.empty() )
+    {
+    this->m_ReadAheadCondition->Signal();
+    }
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::SetReadAhead ( bool readAhead )
+{
+  if ( this->m_ReadAhead == readAhead )
+    {
+    return;
+    }
+  this->m_ReadAhead = readAhead;
+  if ( readAhead && this->IsOpen() )
+    {
+    this->StartReadAheadThread();
+    }
+  else if ( !readAhead )
+    {
+    this->StopReadAheadThread();
+    }
+  this->Modified();
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::StartReadAheadThread()
+{
+  if ( this->m_ReadAheadThreadId >= 0 )
+    {
+    return;
+    }
+  this->m_CacheLock.Lock();
+  this->m_ReadAheadThreadActive = true;
+  this->m_CacheLock.Unlock();
+  this->m_ReadAheadThreadId = this->m_ReadAheadThreader->SpawnThread (
+    TimeSeriesDatabase<TPixel>::ReadAheadThreaderCallback, this );
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::StopReadAheadThread()
+{
+  if ( this->m_ReadAheadThreadId < 0 )
+    {
+    return;
+    }
+  this->m_CacheLock.Lock();
+  this->m_ReadAheadThreadActive = false;
+  this->m_ReadAheadQueue.clear();
+  this->m_ReadAheadCondition->Broadcast();
+  this->m_CacheLock.Unlock();
+  // Waits for the thread to finish
+  this->m_ReadAheadThreader->TerminateThread ( this->m_ReadAheadThreadId );
+  this->m_ReadAheadThreadId = -1;
+}
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE TimeSeriesDatabase<TPixel>::ReadAheadThreaderCallback ( void* arg )
+{
+  Self* self = static_cast<Self*> ( static_cast<MultiThreader::ThreadInfoStruct*> ( arg )->UserData );
+  self->ProcessReadAheadRequests();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ProcessReadAheadRequests()
+{
+  // The read-ahead thread uses its own streams so that it does not
+  // have to hold the lock while reading
+  std::vector<StreamPtr> files;
+  for ( size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
+    {
+    files.push_back ( StreamPtr ( new std::fstream ( this->m_DatabaseFileNames[idx].c_str(), ::std::ios::in | ::std::ios::binary ) ) );
+    }
+
+  CacheBlock* B = new CacheBlock;
+  B->Prefetched = true;
+  this->m_CacheLock.Lock();
+  while ( true )
+    {
+    while ( this->m_ReadAheadThreadActive && this->m_ReadAheadQueue.empty() )
+      {
+      this->m_ReadAheadCondition->Wait ( &this->m_CacheLock );
+      }
+    if ( !this->m_ReadAheadThreadActive )
+      {
+      break;
+      }
+    unsigned long index = this->m_ReadAheadQueue.front();
+    this->m_ReadAheadQueue.pop_front();
+    if ( this->m_Cache.find ( index ) )
+      {
+      continue;
+      }
+    this->m_CacheLock.Unlock();
+    this->ReadBlock ( index, B->data, files );
+    this->m_CacheLock.Lock();
+    // The block may have been requested while it was read
+    if ( !this->m_Cache.find ( index ) )
+      {
+      this->m_Cache.insert ( index, *B );
+      this->m_NumberOfPrefetchedBlocks++;
+      }
+    }
+  this->m_CacheLock.Unlock();
+  delete B;
+
+  for ( size_t idx = 0; idx < files.size(); idx++ )
+    {
+    files[idx]->close();
+    }
+}
+
 
 template <class TPixel>
 void TimeSeriesDatabase<TPixel>::CreateFromFileArchetype ( const char* TSDFilename, const char* archetype )
@@ -569,18 +808,73 @@ void TimeSeriesDatabase<TPixel>::SetCacheSizeInMiB ( float sz )
 {
   // How many blocks is this?
   double BlockSizeInMiB = sizeof ( TPixel ) * TimeSeriesVolumeBlockSize / ( 1024*1024.);
-  unsigned long int blocks = (unsigned long int) ceil ( sz * BlockSizeInMiB );
+  unsigned long int blocks = (unsigned long int) ceil ( sz / BlockSizeInMiB );
+  MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
   this->m_Cache.set_maxsize ( blocks );
 }
 
+template <class TPixel>
+unsigned long TimeSeriesDatabase<TPixel>::GetNumberOfCacheHits()
+{
+  MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
+  return this->m_NumberOfCacheHits;
+}
+
+template <class TPixel>
+unsigned long TimeSeriesDatabase<TPixel>::GetNumberOfCacheMisses()
+{
+  MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
+  return this->m_NumberOfCacheMisses;
+}
+
+template <class TPixel>
+unsigned long TimeSeriesDatabase<TPixel>::GetNumberOfPrefetchedBlocks()
+{
+  MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
+  return this->m_NumberOfPrefetchedBlocks;
+}
+
+template <class TPixel>
+unsigned long TimeSeriesDatabase<TPixel>::GetNumberOfPrefetchHits()
+{
+  MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
+  return this->m_NumberOfPrefetchHits;
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ResetStatistics()
+{
+  MutexLockHolder<SimpleMutexLock> lockHolder ( this->m_CacheLock );
+  this->m_NumberOfCacheHits = 0;
+  this->m_NumberOfCacheMisses = 0;
+  this->m_NumberOfPrefetchedBlocks = 0;
+  this->m_NumberOfPrefetchHits = 0;
+}
+
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::TimeSeriesDatabase () : m_Cache ( 1024 ){
   this->m_Dimensions.SetSize ( 4 );
   this->m_BlocksPerImage.SetSize ( 4 );
+  this->m_CurrentImage = 0;
+  this->m_BlocksPerFile = 0;
+  this->m_UseMemoryMapping = false;
+  this->m_ReadAhead = false;
+  this->m_ReadAheadNumberOfImages = 2;
+  this->m_LastRequestedImage = -1;
+  this->m_ReadAheadImageStep = 1;
+  this->m_ReadAheadThreader = MultiThreader::New();
+  this->m_ReadAheadCondition = ConditionVariable::New();
+  this->m_ReadAheadThreadId = -1;
+  this->m_ReadAheadThreadActive = false;
+  this->m_NumberOfCacheHits = 0;
+  this->m_NumberOfCacheMisses = 0;
+  this->m_NumberOfPrefetchedBlocks = 0;
+  this->m_NumberOfPrefetchHits = 0;
 }
 
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::~TimeSeriesDatabase () {
+  this->StopReadAheadThread();
   // m_Cache.statistics ( std::cout );
 }
 
@@ -609,6 +903,13 @@ TimeSeriesDatabase<TPixel>
   } else {
     os << indent << "Database is closed." << "\n";
   }
+  os << indent << "ReadAhead: " << m_ReadAhead << "\n";
+  os << indent << "ReadAheadNumberOfImages: " << m_ReadAheadNumberOfImages << "\n";
+  os << indent << "UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "NumberOfCacheHits: " << m_NumberOfCacheHits << "\n";
+  os << indent << "NumberOfCacheMisses: " << m_NumberOfCacheMisses << "\n";
+  os << indent << "NumberOfPrefetchedBlocks: " << m_NumberOfPrefetchedBlocks << "\n";
+  os << indent << "NumberOfPrefetchHits: " << m_NumberOfPrefetchHits << "\n";
 
   this->m_Cache.statistics ( os );
 }
@@ -0,0 +1,121 @@
+/*=========================================================================
+
+  Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+==========================================================================*/
+
+#include "itkTimeSeriesDatabaseHelper.h"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace itk {
+  namespace TimeSeriesDatabaseHelper {
+
+//----------------------------------------------------------------------------
+MappedFile::MappedFile()
+  : m_Data(0)
+  , m_Size(0)
+  , m_FileHandle(0)
+  , m_MappingHandle(0)
+{
+}
+
+//----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool MappedFile::Open(const char* filename)
+{
+  this->Close();
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, 0);
+  if (file == INVALID_HANDLE_VALUE)
+    {
+    return false;
+    }
+  m_FileHandle = file;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0
+    || static_cast<unsigned long long>(fileSize.QuadPart) > static_cast<size_t>(-1))
+    {
+    this->Close();
+    return false;
+    }
+  m_MappingHandle = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+  if (m_MappingHandle)
+    {
+    m_Data = static_cast<char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+    }
+#else
+  int fileDescriptor = open(filename, O_RDONLY);
+  if (fileDescriptor < 0)
+    {
+    return false;
+    }
+  struct stat fileStatus;
+  if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0
+    && static_cast<unsigned long long>(fileStatus.st_size) <= static_cast<size_t>(-1))
+    {
+    void* data = mmap(0, fileStatus.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (data != MAP_FAILED)
+      {
+      m_Data = static_cast<char*>(data);
+      m_Size = static_cast<size_t>(fileStatus.st_size);
+      }
+    }
+  // the mapping remains valid after the file is closed
+  close(fileDescriptor);
+#endif
+  if (!m_Data)
+    {
+    this->Close();
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+  if (m_Data)
+    {
+    UnmapViewOfFile(m_Data);
+    }
+  if (m_MappingHandle)
+    {
+    CloseHandle(m_MappingHandle);
+    }
+  if (m_FileHandle)
+    {
+    CloseHandle(m_FileHandle);
+    }
+#else
+  if (m_Data)
+    {
+    munmap(m_Data, m_Size);
+    }
+#endif
+  m_Data = 0;
+  m_Size = 0;
+  m_FileHandle = 0;
+  m_MappingHandle = 0;
+}
+
+  }
+}
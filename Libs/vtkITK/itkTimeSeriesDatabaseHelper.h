@@ -7,8 +7,38 @@
 #include <cstdarg>
 #include <cassert>
 
+#include "vtkITK.h"
+
 namespace itk {
   namespace TimeSeriesDatabaseHelper {
+    /// Read-only memory mapping of a file.
+    ///
+    /// Used to read database blocks without a seek and read call
+    /// for each block. The mapping is safe to read from multiple
+    /// threads.
+    class VTK_ITK_EXPORT MappedFile
+      {
+      public:
+        MappedFile();
+        ~MappedFile();
+
+        /// Map the entire file. Returns false if the file cannot be mapped.
+        bool Open(const char* filename);
+        void Close();
+
+        const char* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+
+      private:
+        MappedFile(const MappedFile&); /// Not implemented.
+        void operator=(const MappedFile&); /// Not implemented.
+
+        char*  m_Data;
+        size_t m_Size;
+        void*  m_FileHandle;
+        void*  m_MappingHandle;
+      };
+
     /// Some useful classes
     /*
      * counted_ptr - simple reference counted pointer.
@@ -23,9 +23,11 @@
 #include <vtkMatrix4x4.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkSimpleMutexLock.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
 // ITK includes
@@ -36,11 +38,29 @@
 #include <itkMetaDataObject.h>
 #include <itkMetaImageIO.h>
 #include <itkTimeProbe.h>
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
 
 // STD includes
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <set>
 #include <vector>
 
+#ifdef _WIN32
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <windows.h>
+#else
+# include <sys/stat.h>
+#endif
+
 #include "itkArchetypeSeriesFileNames.h"
 #include "itkOrientImageFilter.h"
 #include "itkImageSeriesReader.h"
@@ -48,6 +68,8 @@
 #include "itkDCMTKImageIO.h"
 #include "itkGDCMSeriesFileNames.h"
 #include "itkGDCMImageIO.h"
+#include "gdcmReader.h"
+#include "gdcmStringFilter.h"
 #endif
 
 vtkStandardNewMacro(vtkITKArchetypeImageSeriesReader);
@@ -1110,14 +1132,537 @@ void vtkITKArchetypeImageSeriesReader::GroupFiles ( int idxSeriesInstanceUID,
   return;
 }
 
+namespace
+{
+//----------------------------------------------------------------------------
+/// isspace is undefined for negative values, which non-ASCII characters
+/// of a signed char are
+bool IsSpace(char c)
+{
+  return isspace(static_cast<unsigned char>(c)) != 0;
+}
+} // end of anonymous namespace
+
 std::string vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(const itk::MetaDataDictionary &dict, const std::string& tag)
 {
   std::string tagValue;
   itk::ExposeMetaData<std::string>(dict, tag, tagValue);
-  tagValue.erase(std::remove_if(tagValue.begin(), tagValue.end(), isspace), tagValue.end());
+  tagValue.erase(std::remove_if(tagValue.begin(), tagValue.end(), IsSpace), tagValue.end());
   return tagValue;
 }
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Get size and modification time of a file. The modification time is in
+/// nanoseconds since the epoch, with the resolution provided by the file system,
+/// so that a file rewritten within the same second is not taken for the old one.
+/// Returns false if the file cannot be accessed.
+bool GetFileSizeAndModifiedTime(const std::string& filePath,
+  unsigned long long& fileSize, long long& modifiedTime)
+{
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA fileAttributes;
+  if (!GetFileAttributesExA(filePath.c_str(), GetFileExInfoStandard, &fileAttributes))
+    {
+    return false;
+    }
+  fileSize = (static_cast<unsigned long long>(fileAttributes.nFileSizeHigh) << 32) | fileAttributes.nFileSizeLow;
+  // 100-nanosecond intervals since January 1, 1601
+  long long fileTime = (static_cast<long long>(fileAttributes.ftLastWriteTime.dwHighDateTime) << 32)
+    | fileAttributes.ftLastWriteTime.dwLowDateTime;
+  modifiedTime = (fileTime - 116444736000000000LL) * 100;
+#else
+  struct stat fileStat;
+  if (stat(filePath.c_str(), &fileStat) != 0)
+    {
+    return false;
+    }
+  fileSize = static_cast<unsigned long long>(fileStat.st_size);
+# ifdef __APPLE__
+  modifiedTime = static_cast<long long>(fileStat.st_mtimespec.tv_sec) * 1000000000LL + fileStat.st_mtimespec.tv_nsec;
+# else
+  modifiedTime = static_cast<long long>(fileStat.st_mtim.tv_sec) * 1000000000LL + fileStat.st_mtim.tv_nsec;
+# endif
+#endif
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Tags analyzed by AnalyzeDicomHeaders
+enum DicomHeaderTagIndex
+{
+  SeriesInstanceUIDTag = 0,
+  ContentTimeTag,
+  TriggerTimeTag,
+  EchoNumbersTag,
+  DiffusionGradientOrientationTag,
+  SliceLocationTag,
+  ImageOrientationPatientTag,
+  ImagePositionPatientTag,
+  NumberOfDicomHeaderTags
+};
+
+//----------------------------------------------------------------------------
+/// Process-wide index of parsed DICOM header tag values.
+/// Values are identified by file path, size, and modification time.
+/// If a cache directory is set, then values of files in the same directory
+/// are stored in one index file in the cache directory.
+class HeaderIndexCache
+{
+public:
+  HeaderIndexCache() : NumberOfHits(0) { }
+
+  /// Set the directory of the index files. Index files of source directories
+  /// that do not exist anymore or that have not been used for
+  /// MaximumIndexFileAgeInDays are removed from the directory.
+  void SetCacheDirectory(const std::string& directory)
+  {
+    this->Lock.Lock();
+    this->CacheDirectory = directory;
+    if (!directory.empty() && !itksys::SystemTools::MakeDirectory(directory.c_str()))
+      {
+      vtkGenericWarningMacro("vtkITKArchetypeImageSeriesReader: failed to create header index cache directory " << directory);
+      this->CacheDirectory.clear();
+      }
+    this->LoadedDirectories.clear();
+    this->ModifiedDirectories.clear();
+    this->PruneIndexFiles();
+    this->Lock.Unlock();
+  }
+
+  std::string GetCacheDirectory()
+  {
+    this->Lock.Lock();
+    std::string directory = this->CacheDirectory;
+    this->Lock.Unlock();
+    return directory;
+  }
+
+  void RemoveAllEntries()
+  {
+    this->Lock.Lock();
+    this->Entries.clear();
+    this->LoadedDirectories.clear();
+    this->ModifiedDirectories.clear();
+    this->NumberOfHits = 0;
+    this->Lock.Unlock();
+  }
+
+  /// Number of files whose tag values were found in the index
+  unsigned long GetNumberOfHits()
+  {
+    this->Lock.Lock();
+    unsigned long numberOfHits = this->NumberOfHits;
+    this->Lock.Unlock();
+    return numberOfHits;
+  }
+
+  /// Get tag values of a file. Returns false if the file is not in the index
+  /// or it has been changed since it was added.
+  bool Find(const std::string& filePath, unsigned long long fileSize, long long modifiedTime,
+    std::vector<std::string>& tagValues)
+  {
+    bool found = false;
+    this->Lock.Lock();
+    EntryMapType::const_iterator entryIt = this->Entries.find(filePath);
+    if (entryIt != this->Entries.end()
+      && entryIt->second.FileSize == fileSize && entryIt->second.ModifiedTime == modifiedTime
+      && entryIt->second.TagValues.size() == NumberOfDicomHeaderTags)
+      {
+      tagValues = entryIt->second.TagValues;
+      found = true;
+      ++this->NumberOfHits;
+      }
+    this->Lock.Unlock();
+    return found;
+  }
+
+  void Add(const std::string& filePath, unsigned long long fileSize, long long modifiedTime,
+    const std::vector<std::string>& tagValues)
+  {
+    this->Lock.Lock();
+    if (this->Entries.size() >= MaximumNumberOfEntries)
+      {
+      // Keep memory usage bounded, index files still contain the removed entries
+      this->Entries.clear();
+      this->LoadedDirectories.clear();
+      }
+    Entry& entry = this->Entries[filePath];
+    entry.FileSize = fileSize;
+    entry.ModifiedTime = modifiedTime;
+    entry.TagValues = tagValues;
+    if (!this->CacheDirectory.empty())
+      {
+      this->ModifiedDirectories.insert(itksys::SystemTools::GetFilenamePath(filePath));
+      }
+    this->Lock.Unlock();
+  }
+
+  /// Read index files of the directories that have not been read yet
+  void LoadDirectoryIndexes(const std::set<std::string>& directories)
+  {
+    this->Lock.Lock();
+    if (!this->CacheDirectory.empty())
+      {
+      for (std::set<std::string>::const_iterator dirIt = directories.begin(); dirIt != directories.end(); ++dirIt)
+        {
+        if (this->LoadedDirectories.insert(*dirIt).second)
+          {
+          this->ReadIndexFile(*dirIt);
+          }
+        }
+      }
+    this->Lock.Unlock();
+  }
+
+  /// Write index files of all directories that have new entries
+  void SaveModifiedDirectoryIndexes()
+  {
+    this->Lock.Lock();
+    for (std::set<std::string>::const_iterator dirIt = this->ModifiedDirectories.begin();
+      dirIt != this->ModifiedDirectories.end(); ++dirIt)
+      {
+      this->WriteIndexFile(*dirIt);
+      }
+    this->ModifiedDirectories.clear();
+    this->Lock.Unlock();
+  }
+
+private:
+  HeaderIndexCache(const HeaderIndexCache&); //purposely not implemented
+  void operator=(const HeaderIndexCache&); //purposely not implemented
+
+  struct Entry
+  {
+    Entry() : FileSize(0), ModifiedTime(0) { }
+    unsigned long long FileSize;
+    /// Nanoseconds since the epoch
+    long long ModifiedTime;
+    std::vector<std::string> TagValues;
+  };
+  typedef std::map<std::string, Entry> EntryMapType;
+
+  static const size_t MaximumNumberOfEntries = 1000000;
+  static const long MaximumIndexFileAgeInDays = 30;
+
+  /// Index files are named by the hash of the directory path
+  std::string GetIndexFilePath(const std::string& directory)
+  {
+    // 64-bit FNV-1a hash
+    unsigned long long hash = 14695981039346656037ULL;
+    for (std::string::const_iterator it = directory.begin(); it != directory.end(); ++it)
+      {
+      hash = (hash ^ static_cast<unsigned char>(*it)) * 1099511628211ULL;
+      }
+    char hashString[17];
+    sprintf(hashString, "%016llx", hash);
+    return this->CacheDirectory + "/" + hashString + ".txt";
+  }
+
+  /// Returns true if the file name is the name of an index file
+  static bool IsIndexFileName(const std::string& fileName)
+  {
+    return fileName.size() == 20 && fileName.compare(16, 4, ".txt") == 0
+      && fileName.find_first_not_of("0123456789abcdef") == 16;
+  }
+
+  /// Remove index files of source directories that do not exist anymore and
+  /// index files that have not been read or written for MaximumIndexFileAgeInDays.
+  void PruneIndexFiles()
+  {
+    itksys::Directory cacheDirectory;
+    if (this->CacheDirectory.empty() || !cacheDirectory.Load(this->CacheDirectory))
+      {
+      return;
+      }
+    long now = static_cast<long>(time(NULL));
+    for (unsigned long fileIndex = 0; fileIndex < cacheDirectory.GetNumberOfFiles(); ++fileIndex)
+      {
+      std::string fileName = cacheDirectory.GetFile(fileIndex);
+      if (!IsIndexFileName(fileName))
+        {
+        continue;
+        }
+      std::string indexFilePath = this->CacheDirectory + "/" + fileName;
+      bool expired = (now - itksys::SystemTools::ModifiedTime(indexFilePath)
+        > MaximumIndexFileAgeInDays * 24 * 3600);
+      if (!expired)
+        {
+        std::ifstream indexFile(indexFilePath.c_str());
+        std::string sourceDirectory;
+        expired = !std::getline(indexFile, sourceDirectory)
+          || !itksys::SystemTools::FileIsDirectory(sourceDirectory);
+        }
+      if (expired)
+        {
+        itksys::SystemTools::RemoveFile(indexFilePath);
+        }
+      }
+  }
+
+  /// Each line of the index file contains the file name, size, modification time
+  /// and tag values of a file, separated by tab characters. Tag values do not
+  /// contain whitespace.
+  void ReadIndexFile(const std::string& directory)
+  {
+    std::string indexFilePath = this->GetIndexFilePath(directory);
+    std::ifstream indexFile(indexFilePath.c_str());
+    std::string line;
+    if (!std::getline(indexFile, line) || line != directory)
+      {
+      // missing index or hash collision
+      return;
+      }
+    // keep used index files from being pruned
+    itksys::SystemTools::Touch(indexFilePath, false);
+    while (std::getline(indexFile, line))
+      {
+      std::vector<std::string> fields;
+      std::string::size_type fieldStart = 0;
+      while (true)
+        {
+        std::string::size_type fieldEnd = line.find('\t', fieldStart);
+        fields.push_back(line.substr(fieldStart, fieldEnd == std::string::npos ? std::string::npos : fieldEnd - fieldStart));
+        if (fieldEnd == std::string::npos)
+          {
+          break;
+          }
+        fieldStart = fieldEnd + 1;
+        }
+      if (fields.size() != 3 + NumberOfDicomHeaderTags)
+        {
+        // truncated or invalid line
+        continue;
+        }
+      Entry entry;
+      entry.FileSize = strtoull(fields[1].c_str(), NULL, 10);
+      entry.ModifiedTime = strtoll(fields[2].c_str(), NULL, 10);
+      entry.TagValues.assign(fields.begin() + 3, fields.end());
+      std::string filePath = directory + "/" + fields[0];
+      if (this->Entries.find(filePath) == this->Entries.end())
+        {
+        this->Entries[filePath] = entry;
+        }
+      }
+  }
+
+  void WriteIndexFile(const std::string& directory)
+  {
+    std::string indexFilePath = this->GetIndexFilePath(directory);
+    // Write into a temporary file first so that other processes never see a partially written file
+    std::string temporaryFilePath = indexFilePath + ".tmp";
+    std::ofstream indexFile(temporaryFilePath.c_str());
+    if (!indexFile)
+      {
+      vtkGenericWarningMacro("vtkITKArchetypeImageSeriesReader: failed to write header index file for " << directory);
+      return;
+      }
+    indexFile << directory << "\n";
+    std::string prefix = directory + "/";
+    for (EntryMapType::const_iterator entryIt = this->Entries.lower_bound(prefix);
+      entryIt != this->Entries.end() && entryIt->first.compare(0, prefix.size(), prefix) == 0; ++entryIt)
+      {
+      std::string fileName = entryIt->first.substr(prefix.size());
+      if (fileName.find_first_of("/\t\n") != std::string::npos)
+        {
+        // file in a subdirectory or name cannot be stored
+        continue;
+        }
+      indexFile << fileName << "\t" << entryIt->second.FileSize << "\t" << entryIt->second.ModifiedTime;
+      for (std::vector<std::string>::const_iterator valueIt = entryIt->second.TagValues.begin();
+        valueIt != entryIt->second.TagValues.end(); ++valueIt)
+        {
+        indexFile << "\t" << *valueIt;
+        }
+      indexFile << "\n";
+      }
+    indexFile.close();
+    if (indexFile.fail() || !itksys::SystemTools::RenameFile(temporaryFilePath.c_str(), indexFilePath.c_str()))
+      {
+      vtkGenericWarningMacro("vtkITKArchetypeImageSeriesReader: failed to write header index file for " << directory);
+      itksys::SystemTools::RemoveFile(temporaryFilePath);
+      }
+  }
+
+  vtkSimpleMutexLock Lock;
+  std::string CacheDirectory;
+  EntryMapType Entries;
+  /// Directories whose index file has been read
+  std::set<std::string> LoadedDirectories;
+  /// Directories that have entries not written to the index file yet
+  std::set<std::string> ModifiedDirectories;
+  unsigned long NumberOfHits;
+};
+
+HeaderIndexCache HeaderIndexCacheInstance;
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkITKArchetypeImageSeriesReader::SetHeaderIndexCacheDirectory(const std::string& directory)
+{
+  HeaderIndexCacheInstance.SetCacheDirectory(directory);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkITKArchetypeImageSeriesReader::GetHeaderIndexCacheDirectory()
+{
+  return HeaderIndexCacheInstance.GetCacheDirectory();
+}
+
+//----------------------------------------------------------------------------
+void vtkITKArchetypeImageSeriesReader::RemoveAllHeaderIndexCacheEntries()
+{
+  HeaderIndexCacheInstance.RemoveAllEntries();
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkITKArchetypeImageSeriesReader::GetNumberOfHeaderIndexCacheHits()
+{
+  return HeaderIndexCacheInstance.GetNumberOfHits();
+}
+
+#ifdef VTKITK_BUILD_DICOM_SUPPORT
+namespace
+{
+
+const gdcm::Tag DicomHeaderTags[NumberOfDicomHeaderTags] =
+{
+  gdcm::Tag(0x0020, 0x000e), // series instance UID
+  gdcm::Tag(0x0008, 0x0033), // content time
+  gdcm::Tag(0x0018, 0x1060), // trigger time
+  gdcm::Tag(0x0018, 0x0086), // echo numbers
+  gdcm::Tag(0x0010, 0x9089), // diffusion gradient orientation
+  gdcm::Tag(0x0020, 0x1041), // slice location
+  gdcm::Tag(0x0020, 0x0037), // image orientation patient
+  gdcm::Tag(0x0020, 0x0032)  // image position patient
+};
+
+//----------------------------------------------------------------------------
+/// Read values of the analyzed tags from a DICOM file.
+/// Parsing stops after the last analyzed tag, so pixel data and the remaining
+/// elements are not read.
+/// Extra spaces are removed from the values, because extra spaces were found in some
+/// DICOM files before/after the multi-value separator backslashes.
+bool ReadDicomHeaderTagValues(const std::string& fileName, std::vector<std::string>& tagValues)
+{
+  std::set<gdcm::Tag> selectedTags(DicomHeaderTags, DicomHeaderTags + NumberOfDicomHeaderTags);
+  gdcm::Reader reader;
+  reader.SetFileName(fileName.c_str());
+  if (!reader.ReadSelectedTags(selectedTags))
+    {
+    return false;
+    }
+  gdcm::StringFilter stringFilter;
+  stringFilter.SetFile(reader.GetFile());
+  tagValues.resize(NumberOfDicomHeaderTags);
+  for (int tagIndex = 0; tagIndex < NumberOfDicomHeaderTags; ++tagIndex)
+    {
+    std::string tagValue = stringFilter.ToString(DicomHeaderTags[tagIndex]);
+    tagValue.erase(std::remove_if(tagValue.begin(), tagValue.end(), IsSpace), tagValue.end());
+    // values may be padded with null characters
+    tagValue.erase(std::remove(tagValue.begin(), tagValue.end(), '\0'), tagValue.end());
+    tagValues[tagIndex] = tagValue;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+struct DicomHeaderThreadData
+{
+  /// Full paths of the files
+  const std::vector<std::string>* FilePaths;
+  std::vector<std::vector<std::string> >* TagValues;
+  /// Non-zero for each file that could not be read
+  std::vector<char> Failed;
+  vtkSimpleMutexLock* FileIndexLock;
+  size_t NextFileIndex;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ReadDicomHeadersThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  DicomHeaderThreadData* threadData = static_cast<DicomHeaderThreadData*>(threadInfo->UserData);
+
+  // Access time of files may be very different, so files are taken one by one
+  while (true)
+    {
+    threadData->FileIndexLock->Lock();
+    size_t fileIndex = threadData->NextFileIndex++;
+    threadData->FileIndexLock->Unlock();
+    if (fileIndex >= threadData->FilePaths->size())
+      {
+      break;
+      }
+    const std::string& filePath = (*threadData->FilePaths)[fileIndex];
+    std::vector<std::string>& tagValues = (*threadData->TagValues)[fileIndex];
+    unsigned long long fileSize = 0;
+    long long modifiedTime = 0;
+    bool fileTimeValid = GetFileSizeAndModifiedTime(filePath, fileSize, modifiedTime);
+    if (fileTimeValid && HeaderIndexCacheInstance.Find(filePath, fileSize, modifiedTime, tagValues))
+      {
+      continue;
+      }
+    if (!ReadDicomHeaderTagValues(filePath, tagValues))
+      {
+      threadData->Failed[fileIndex] = 1;
+      continue;
+      }
+    if (fileTimeValid)
+      {
+      HeaderIndexCacheInstance.Add(filePath, fileSize, modifiedTime, tagValues);
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Read values of the analyzed tags from all the files using a pool of threads.
+/// Values of files that are found in the header index cache are not read again.
+/// Returns index of the first file that could not be read, -1 if all files were read.
+int ReadDicomHeaders(const std::vector<std::string>& fileNames, std::vector<std::vector<std::string> >& tagValues)
+{
+  if (fileNames.empty())
+    {
+    return -1;
+    }
+
+  std::vector<std::string> filePaths(fileNames.size());
+  std::set<std::string> directories;
+  for (size_t fileIndex = 0; fileIndex < fileNames.size(); ++fileIndex)
+    {
+    filePaths[fileIndex] = itksys::SystemTools::CollapseFullPath(fileNames[fileIndex]);
+    directories.insert(itksys::SystemTools::GetFilenamePath(filePaths[fileIndex]));
+    }
+  HeaderIndexCacheInstance.LoadDirectoryIndexes(directories);
+
+  vtkNew<vtkSimpleMutexLock> fileIndexLock;
+  DicomHeaderThreadData threadData;
+  threadData.FilePaths = &filePaths;
+  threadData.TagValues = &tagValues;
+  threadData.Failed.resize(fileNames.size(), 0);
+  threadData.FileIndexLock = fileIndexLock.GetPointer();
+  threadData.NextFileIndex = 0;
+
+  int numberOfThreads = std::min(vtkMultiThreader::GetGlobalDefaultNumberOfThreads(), static_cast<int>(fileNames.size()));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ReadDicomHeadersThreadFunction, &threadData);
+  threader->SingleMethodExecute();
+
+  HeaderIndexCacheInstance.SaveModifiedDirectoryIndexes();
+
+  std::vector<char>::iterator failedIt = std::find(threadData.Failed.begin(), threadData.Failed.end(), 1);
+  return (failedIt != threadData.Failed.end() ? static_cast<int>(failedIt - threadData.Failed.begin()) : -1);
+}
+
+} // end of anonymous namespace
+#endif
+
 //----------------------------------------------------------------------------
 void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
 {
@@ -1225,20 +1770,24 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
   // if Archetype is a Dicom File
-  gdcmIO->SetFileName( this->Archetype );
+  // Headers are parsed concurrently, as reading many small files is dominated
+  // by file access latency (especially on network storage). Tag values are
+  // then inserted into the index tables in file order, so that the result does
+  // not depend on the order the headers are read in.
+  std::vector<std::vector<std::string> > headerTagValues(nFiles);
+  int failedFileIndex = ReadDicomHeaders(this->AllFileNames, headerTagValues);
+  if (failedFileIndex >= 0)
+    {
+    itkGenericExceptionMacro("Failed to read DICOM header of file " << this->AllFileNames[failedFileIndex]);
+    }
+
   for (int f = 0; f < nFiles; f++)
   {
-    gdcmIO->SetFileName( this->AllFileNames[f] );
-    gdcmIO->ReadImageInformation();
-    itk::MetaDataDictionary &dict = gdcmIO->GetMetaDataDictionary();
+    const std::vector<std::string>& tagValues = headerTagValues[f];
     std::string tagValue;
 
-    // Use vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces to remove extra spaces
-    // from the DICOM tag, because extra spaces were found in some DICOM file before/after the
-    // multi-value separator backslashes.
-
     // series instance UID
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|000e");
+    tagValue = tagValues[SeriesInstanceUIDTag];
     if (!tagValue.empty())
     {
       int idx = InsertSeriesInstanceUIDs( tagValue.c_str() );
@@ -1250,7 +1799,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // content time
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0008|0033");
+    tagValue = tagValues[ContentTimeTag];
     if (!tagValue.empty())
     {
       int idx = InsertContentTime( tagValue.c_str() );
@@ -1262,7 +1811,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // trigger time
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0018|1060");
+    tagValue = tagValues[TriggerTimeTag];
     if (!tagValue.empty())
     {
       int idx = InsertTriggerTime( tagValue.c_str() );
@@ -1274,7 +1823,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // echo numbers
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0018|0086");
+    tagValue = tagValues[EchoNumbersTag];
     if (!tagValue.empty())
     {
       int idx = InsertEchoNumbers( tagValue.c_str() );
@@ -1286,7 +1835,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // diffision gradient orientation
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0010|9089");
+    tagValue = tagValues[DiffusionGradientOrientationTag];
     if (!tagValue.empty())
     {
       float a[3] = { -1 };
@@ -1300,7 +1849,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // slice location
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|1041");
+    tagValue = tagValues[SliceLocationTag];
     if (!tagValue.empty())
     {
       float a = -1;
@@ -1314,7 +1863,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // image orientation patient
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|0037");
+    tagValue = tagValues[ImageOrientationPatientTag];
     if (!tagValue.empty())
     {
       float a[6] = { -1 };
@@ -1327,7 +1876,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       this->IndexImageOrientationPatient[f] = -1;
     }
     // image position patient
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|0032");
+    tagValue = tagValues[ImagePositionPatientTag];
     if (!tagValue.empty())
     {
       float a[3] = { -1 };
@@ -778,6 +778,28 @@ public:
 
   void AnalyzeDicomHeaders( );
 
+  ///
+  /// Directory where the DICOM tag values parsed by AnalyzeDicomHeaders are stored,
+  /// so that headers of the same files are not parsed again in later sessions.
+  /// Parsed values are kept in memory for the entire process even if no directory is set.
+  /// Entries are identified by file path, size, and modification time (with the
+  /// resolution of the file system), therefore entries of files that have been
+  /// changed are not used. Setting the directory removes the index files of
+  /// directories that do not exist anymore or that have not been used for 30 days.
+  /// Empty by default.
+  static void SetHeaderIndexCacheDirectory(const std::string& directory);
+  static std::string GetHeaderIndexCacheDirectory();
+
+  ///
+  /// Remove all parsed DICOM tag values from memory and reset the number of hits.
+  /// Files in the header index cache directory are kept.
+  static void RemoveAllHeaderIndexCacheEntries();
+
+  ///
+  /// Number of files whose DICOM tag values were found in the header index cache
+  /// instead of being parsed.
+  static unsigned long GetNumberOfHeaderIndexCacheHits();
+
   void AssembleNthVolume( int n );
   int AssembleVolumeContainingArchetype();
 
@@ -66,6 +66,44 @@ public:
   int GetNumberOfVolumes()
   { DelegateITKOutputMacro ( GetNumberOfVolumes ); };
 
+  /// Get/Set the size of the block cache in MiB
+  void SetCacheSizeInMiB ( float value )
+  { DelegateITKInputMacro ( SetCacheSizeInMiB, value ); };
+  float GetCacheSizeInMiB()
+  { DelegateITKOutputMacro ( GetCacheSizeInMiB ); };
+
+  /// Enable/disable reading blocks of the predicted next images
+  /// in a background thread. Disabled by default.
+  void SetReadAhead ( bool value )
+  { DelegateITKInputMacro ( SetReadAhead, value ); };
+  bool GetReadAhead()
+  { DelegateITKOutputMacro ( GetReadAhead ); };
+
+  /// Get/Set the maximum number of images to read ahead
+  void SetReadAheadNumberOfImages ( unsigned int value )
+  { DelegateITKInputMacro ( SetReadAheadNumberOfImages, value ); };
+  unsigned int GetReadAheadNumberOfImages()
+  { DelegateITKOutputMacro ( GetReadAheadNumberOfImages ); };
+
+  /// Read blocks from memory mapped files instead of file streams.
+  /// Takes effect at the next connection to a database.
+  void SetUseMemoryMapping ( bool value )
+  { DelegateITKInputMacro ( SetUseMemoryMapping, value ); };
+  bool GetUseMemoryMapping()
+  { DelegateITKOutputMacro ( GetUseMemoryMapping ); };
+
+  /// Cache statistics
+  unsigned long GetNumberOfCacheHits()
+  { DelegateITKOutputMacro ( GetNumberOfCacheHits ); };
+  unsigned long GetNumberOfCacheMisses()
+  { DelegateITKOutputMacro ( GetNumberOfCacheMisses ); };
+  unsigned long GetNumberOfPrefetchedBlocks()
+  { DelegateITKOutputMacro ( GetNumberOfPrefetchedBlocks ); };
+  unsigned long GetNumberOfPrefetchHits()
+  { DelegateITKOutputMacro ( GetNumberOfPrefetchHits ); };
+  void ResetStatistics()
+  { this->m_Filter->ResetStatistics(); };
+
 protected:
   vtkITKTimeSeriesDatabase()
     {
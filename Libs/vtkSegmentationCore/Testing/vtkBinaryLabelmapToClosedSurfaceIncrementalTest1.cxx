@@ -0,0 +1,217 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointLocator.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkSegmentation.h"
+#include "vtkSegment.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegmentationConverterFactory.h"
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateSphereLabelmap(vtkOrientedImageData* labelmap)
+{
+  labelmap->SetExtent(0, 59, 0, 49, 0, 39);
+  labelmap->SetSpacing(0.8, 1.0, 1.3);
+  labelmap->SetOrigin(10.0, -5.0, 3.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = 0; k < 40; ++k)
+    {
+    for (int j = 0; j < 50; ++j)
+      {
+      for (int i = 0; i < 60; ++i)
+        {
+        int distanceSquared = (i - 30) * (i - 30) + (j - 25) * (j - 25) + (k - 20) * (k - 20);
+        *static_cast<unsigned char*>(labelmap->GetScalarPointer(i, j, k)) = (distanceSquared <= 15 * 15 ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Simulate local edits: add a bump on the sphere surface and cut a hole in it
+void EditLabelmap(vtkOrientedImageData* labelmap)
+{
+  int paintExtent[6] = { 42, 48, 22, 28, 17, 23 };
+  vtkOrientedImageDataResample::FillImage(labelmap, 1, paintExtent);
+  int eraseExtent[6] = { 27, 33, 8, 13, 18, 22 };
+  vtkOrientedImageDataResample::FillImage(labelmap, 0, eraseExtent);
+  labelmap->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool ConvertFull(vtkOrientedImageData* labelmap, vtkPolyData* surface)
+{
+  vtkNew<vtkBinaryLabelmapToClosedSurfaceConversionRule> rule;
+  rule->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetIncrementalUpdateParameterName(), "0");
+  return rule->Convert(labelmap, surface);
+}
+
+//----------------------------------------------------------------------------
+/// Check that the surfaces have the same topology size and each point of the
+/// tested surface is within tolerance of a point of the reference surface
+bool AreSurfacesEquivalent(vtkPolyData* testedSurface, vtkPolyData* referenceSurface, double tolerance)
+{
+  if (testedSurface->GetNumberOfPoints() != referenceSurface->GetNumberOfPoints()
+    || testedSurface->GetNumberOfPolys() != referenceSurface->GetNumberOfPolys())
+    {
+    std::cerr << "Surface size mismatch: " << testedSurface->GetNumberOfPoints() << " points and "
+      << testedSurface->GetNumberOfPolys() << " polygons, expected " << referenceSurface->GetNumberOfPoints()
+      << " points and " << referenceSurface->GetNumberOfPolys() << " polygons" << std::endl;
+    return false;
+    }
+  if (referenceSurface->GetNumberOfPoints() == 0)
+    {
+    return true;
+    }
+  vtkNew<vtkPointLocator> locator;
+  locator->SetDataSet(referenceSurface);
+  locator->BuildLocator();
+  double maximumDistance = 0.0;
+  for (vtkIdType pointId = 0; pointId < testedSurface->GetNumberOfPoints(); ++pointId)
+    {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    testedSurface->GetPoint(pointId, point);
+    double referencePoint[3] = { 0.0, 0.0, 0.0 };
+    referenceSurface->GetPoint(locator->FindClosestPoint(point), referencePoint);
+    maximumDistance = std::max(maximumDistance, sqrt(vtkMath::Distance2BetweenPoints(point, referencePoint)));
+    }
+  if (maximumDistance > tolerance)
+    {
+    std::cerr << "Surface point distance " << maximumDistance << " exceeds tolerance " << tolerance << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkBinaryLabelmapToClosedSurfaceIncrementalTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const double tolerance = 1e-3;
+
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateSphereLabelmap(labelmap.GetPointer());
+
+  // Initial conversion in incremental mode is equivalent to full conversion
+  vtkNew<vtkBinaryLabelmapToClosedSurfaceConversionRule> incrementalRule;
+  incrementalRule->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetIncrementalUpdateParameterName(), "1");
+  if (!incrementalRule->IsIncrementalConversionEnabled())
+    {
+    std::cerr << __LINE__ << ": Incremental conversion is expected to be enabled" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkPolyData> incrementalSurface;
+  vtkNew<vtkPolyData> fullSurface;
+  if (!incrementalRule->Convert(labelmap.GetPointer(), incrementalSurface.GetPointer())
+    || !ConvertFull(labelmap.GetPointer(), fullSurface.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!AreSurfacesEquivalent(incrementalSurface.GetPointer(), fullSurface.GetPointer(), tolerance))
+    {
+    std::cerr << __LINE__ << ": Initial incremental conversion result differs from full conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Nothing is recomputed if the labelmap is unchanged
+  vtkPoints* pointsBefore = incrementalSurface->GetPoints();
+  incrementalRule->Convert(labelmap.GetPointer(), incrementalSurface.GetPointer());
+  if (incrementalSurface->GetPoints() != pointsBefore)
+    {
+    std::cerr << __LINE__ << ": Surface is regenerated although the labelmap is unchanged" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Local edit is stitched into the previous surface
+  EditLabelmap(labelmap.GetPointer());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  incrementalRule->Convert(labelmap.GetPointer(), incrementalSurface.GetPointer());
+  timer->StopTimer();
+  double incrementalTime = timer->GetElapsedTime();
+  timer->StartTimer();
+  ConvertFull(labelmap.GetPointer(), fullSurface.GetPointer());
+  timer->StopTimer();
+  double fullTime = timer->GetElapsedTime();
+  if (!AreSurfacesEquivalent(incrementalSurface.GetPointer(), fullSurface.GetPointer(), tolerance))
+    {
+    std::cerr << __LINE__ << ": Incrementally updated surface differs from full conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "<DartMeasurement name=\"vtkBinaryLabelmapToClosedSurface-IncrementalUpdate\" type=\"numeric/double\">"
+            << incrementalTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkBinaryLabelmapToClosedSurface-FullConversion\" type=\"numeric/double\">"
+            << fullTime << "</DartMeasurement>" << std::endl;
+
+  // Segmentation keeps invalidated surfaces for incremental update
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule>::New() );
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetIncrementalUpdateParameterName(), "1");
+  vtkNew<vtkOrientedImageData> segmentLabelmap;
+  CreateSphereLabelmap(segmentLabelmap.GetPointer());
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), segmentLabelmap.GetPointer());
+  segmentation->AddSegment(segment.GetPointer(), "Segment_1");
+  if (!segmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Conversion to closed surface failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  EditLabelmap(segmentLabelmap.GetPointer());
+  if (segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Closed surface is expected to be invalidated by labelmap change" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!segmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Conversion to closed surface failed after labelmap change" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkPolyData* segmentSurface = vtkPolyData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()));
+  if (!segmentSurface || !AreSurfacesEquivalent(segmentSurface, fullSurface.GetPointer(), tolerance))
+    {
+    std::cerr << __LINE__ << ": Incrementally updated segment surface differs from full conversion" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Incremental closed surface conversion test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
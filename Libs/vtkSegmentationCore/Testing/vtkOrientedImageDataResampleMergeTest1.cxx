@@ -0,0 +1,201 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Fill image with a pattern of small label values, including negative values for signed types
+void CreateImage(vtkOrientedImageData* image, int scalarType, const int extent[6], int seed)
+{
+  image->SetExtent(const_cast<int*>(extent));
+  image->AllocateScalars(scalarType, 1);
+  bool isSigned = (image->GetScalarTypeMin() < 0);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        int value = (i * 7 + j * 13 + k * 5 + seed) % 11;
+        image->SetScalarComponentFromDouble(i, j, k, 0, isSigned ? value - 3 : value);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Compute expected voxel value of ModifyImage result
+double GetExpectedValue(double baseValue, double modifierValue, int operation, double maskThreshold, double fillValue)
+{
+  switch (operation)
+    {
+    case vtkOrientedImageDataResample::OPERATION_MAXIMUM: return std::max(baseValue, modifierValue);
+    case vtkOrientedImageDataResample::OPERATION_MINIMUM: return std::min(baseValue, modifierValue);
+    default: return (modifierValue > maskThreshold ? fillValue : baseValue);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool TestModifyImage(int baseScalarType, int modifierScalarType, int operation)
+{
+  // Row lengths are not multiple of the vector size and the images only partially overlap
+  const int baseExtent[6] = { 0, 130, 0, 99, 0, 79 };
+  const int modifierExtent[6] = { 11, 150, -5, 60, 10, 90 };
+  const double maskThreshold = 2;
+  const double fillValue = 9;
+
+  vtkNew<vtkOrientedImageData> baseImage;
+  CreateImage(baseImage.GetPointer(), baseScalarType, baseExtent, 0);
+  vtkNew<vtkOrientedImageData> originalBaseImage;
+  originalBaseImage->DeepCopy(baseImage.GetPointer());
+  vtkNew<vtkOrientedImageData> modifierImage;
+  CreateImage(modifierImage.GetPointer(), modifierScalarType, modifierExtent, 3);
+
+  if (!vtkOrientedImageDataResample::ModifyImage(baseImage.GetPointer(), modifierImage.GetPointer(),
+    operation, NULL, maskThreshold, fillValue))
+    {
+    std::cerr << "ModifyImage failed" << std::endl;
+    return false;
+    }
+
+  for (int k = baseExtent[4]; k <= baseExtent[5]; ++k)
+    {
+    for (int j = baseExtent[2]; j <= baseExtent[3]; ++j)
+      {
+      for (int i = baseExtent[0]; i <= baseExtent[1]; ++i)
+        {
+        double expectedValue = originalBaseImage->GetScalarComponentAsDouble(i, j, k, 0);
+        if (i >= modifierExtent[0] && i <= modifierExtent[1]
+          && j >= modifierExtent[2] && j <= modifierExtent[3]
+          && k >= modifierExtent[4] && k <= modifierExtent[5])
+          {
+          expectedValue = GetExpectedValue(expectedValue, modifierImage->GetScalarComponentAsDouble(i, j, k, 0),
+            operation, maskThreshold, fillValue);
+          }
+        double value = baseImage->GetScalarComponentAsDouble(i, j, k, 0);
+        if (value != expectedValue)
+          {
+          std::cerr << "Voxel value mismatch at (" << i << ", " << j << ", " << k << ") for operation " << operation
+            << ", base scalar type " << baseScalarType << ", modifier scalar type " << modifierScalarType
+            << ": expected " << expectedValue << ", got " << value << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Returns number of voxels merged per second
+double MeasureModifyImageSpeed(int scalarType, int operation)
+{
+  const int extent[6] = { 0, 255, 0, 255, 0, 255 };
+  vtkNew<vtkOrientedImageData> baseImage;
+  CreateImage(baseImage.GetPointer(), scalarType, extent, 0);
+  vtkNew<vtkOrientedImageData> modifierImage;
+  CreateImage(modifierImage.GetPointer(), scalarType, extent, 3);
+
+  const int numberOfRepetitions = 10;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfRepetitions; ++i)
+    {
+    vtkOrientedImageDataResample::ModifyImage(baseImage.GetPointer(), modifierImage.GetPointer(), operation);
+    }
+  timer->StopTimer();
+  double numberOfVoxels = static_cast<double>(baseImage->GetNumberOfPoints()) * numberOfRepetitions;
+  return numberOfVoxels / std::max(timer->GetElapsedTime(), 1e-6);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkOrientedImageDataResampleMergeTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int operations[3] = { vtkOrientedImageDataResample::OPERATION_MAXIMUM,
+    vtkOrientedImageDataResample::OPERATION_MINIMUM, vtkOrientedImageDataResample::OPERATION_MASKING };
+
+  // Vectorized (same scalar type) and generic (mixed scalar types) code paths give the expected result
+  const int scalarTypes[4][2] = {
+    { VTK_UNSIGNED_CHAR, VTK_UNSIGNED_CHAR },
+    { VTK_SHORT, VTK_SHORT },
+    { VTK_UNSIGNED_CHAR, VTK_SHORT },
+    { VTK_FLOAT, VTK_UNSIGNED_CHAR } };
+  for (int typeIndex = 0; typeIndex < 4; ++typeIndex)
+    {
+    for (int operationIndex = 0; operationIndex < 3; ++operationIndex)
+      {
+      if (!TestModifyImage(scalarTypes[typeIndex][0], scalarTypes[typeIndex][1], operations[operationIndex]))
+        {
+        std::cerr << __LINE__ << ": ModifyImage result is incorrect" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Merging an image that does not change the base image does not modify it
+  const int extent[6] = { 0, 40, 0, 30, 0, 20 };
+  vtkNew<vtkOrientedImageData> baseImage;
+  CreateImage(baseImage.GetPointer(), VTK_UNSIGNED_CHAR, extent, 0);
+  vtkNew<vtkOrientedImageData> emptyImage;
+  emptyImage->SetExtent(const_cast<int*>(extent));
+  emptyImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(emptyImage.GetPointer(), 0);
+  vtkNew<vtkOrientedImageData> mergedImage;
+  bool outputModified = true;
+  vtkOrientedImageDataResample::MergeImage(baseImage.GetPointer(), emptyImage.GetPointer(), mergedImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MAXIMUM, NULL, 0, 1, &outputModified);
+  if (outputModified)
+    {
+    std::cerr << __LINE__ << ": Merging an empty image is not expected to modify the output" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkOrientedImageDataResample::FillImage(emptyImage.GetPointer(), 10);
+  vtkOrientedImageDataResample::MergeImage(baseImage.GetPointer(), emptyImage.GetPointer(), mergedImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MAXIMUM, NULL, 0, 1, &outputModified);
+  if (!outputModified)
+    {
+    std::cerr << __LINE__ << ": Merging a non-empty image is expected to modify the output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Report merge speed for the common labelmap scalar types
+  std::cout << "<DartMeasurement name=\"vtkOrientedImageDataResample-MaximumUnsignedCharVoxelsPerSecond\" type=\"numeric/double\">"
+            << MeasureModifyImageSpeed(VTK_UNSIGNED_CHAR, vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+            << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkOrientedImageDataResample-MaskingUnsignedCharVoxelsPerSecond\" type=\"numeric/double\">"
+            << MeasureModifyImageSpeed(VTK_UNSIGNED_CHAR, vtkOrientedImageDataResample::OPERATION_MASKING)
+            << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkOrientedImageDataResample-MaximumShortVoxelsPerSecond\" type=\"numeric/double\">"
+            << MeasureModifyImageSpeed(VTK_SHORT, vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+            << "</DartMeasurement>" << std::endl;
+
+  std::cout << "Oriented image data merge test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
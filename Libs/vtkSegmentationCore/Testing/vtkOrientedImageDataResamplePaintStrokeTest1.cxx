@@ -0,0 +1,187 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkImageStencilData.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Create spherical brush stencil centered at the origin
+void CreateSphereBrush(vtkImageStencilData* brush, int radius)
+{
+  int extent[6] = { -radius, radius, -radius, radius, -radius, radius };
+  brush->SetExtent(extent);
+  brush->AllocateExtents();
+  for (int k = -radius; k <= radius; ++k)
+    {
+    for (int j = -radius; j <= radius; ++j)
+      {
+      int remainingSquared = radius * radius - j * j - k * k;
+      if (remainingSquared < 0)
+        {
+        continue;
+        }
+      int halfWidth = 0;
+      while ((halfWidth + 1) * (halfWidth + 1) <= remainingSquared)
+        {
+        ++halfWidth;
+        }
+      brush->InsertNextExtent(-halfWidth, halfWidth, j, k);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void CreateImage(vtkOrientedImageData* image, int size)
+{
+  image->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(image, 0);
+}
+
+//----------------------------------------------------------------------------
+bool CheckExtent(const int extent[6], int i0, int i1, int j0, int j1, int k0, int k1)
+{
+  int expectedExtent[6] = { i0, i1, j0, j1, k0, k1 };
+  for (int i = 0; i < 6; ++i)
+    {
+    if (extent[i] != expectedExtent[i])
+      {
+      std::cerr << "Extent mismatch: expected (" << i0 << ", " << i1 << ", " << j0 << ", " << j1 << ", " << k0 << ", " << k1
+        << "), got (" << extent[0] << ", " << extent[1] << ", " << extent[2] << ", " << extent[3] << ", " << extent[4] << ", " << extent[5] << ")" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkOrientedImageDataResamplePaintStrokeTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int radius = 3;
+  vtkNew<vtkImageStencilData> brush;
+  CreateSphereBrush(brush.GetPointer(), radius);
+
+  // Brush is swept continuously between distant stroke points
+  vtkNew<vtkOrientedImageData> image;
+  CreateImage(image.GetPointer(), 50);
+  image->SetScalarComponentFromDouble(20, 20, 20, 0, 5);
+  vtkNew<vtkPoints> strokePoints;
+  strokePoints->InsertNextPoint(10.2, 20.0, 19.8);
+  strokePoints->InsertNextPoint(30.4, 20.0, 20.0);
+  int updateExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!vtkOrientedImageDataResample::PaintStroke(image.GetPointer(), brush.GetPointer(), strokePoints.GetPointer(), 1, updateExtent)
+    || !CheckExtent(updateExtent, 7, 33, 17, 23, 17, 23))
+    {
+    std::cerr << __LINE__ << ": Stroke is expected to be painted in the union of the brush extents" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int k = 0; k < 50; ++k)
+    {
+    for (int j = 0; j < 50; ++j)
+      {
+      for (int i = 0; i < 50; ++i)
+        {
+        // Union of spheres centered at each voxel of the stroke line
+        int closestCenterI = std::min(std::max(i, 10), 30);
+        int distanceSquared = (i - closestCenterI) * (i - closestCenterI) + (j - 20) * (j - 20) + (k - 20) * (k - 20);
+        double expectedValue = (distanceSquared <= radius * radius ? 1 : 0);
+        if (i == 20 && j == 20 && k == 20)
+          {
+          // Higher values are not overwritten
+          expectedValue = 5;
+          }
+        if (image->GetScalarComponentAsDouble(i, j, k, 0) != expectedValue)
+          {
+          std::cerr << __LINE__ << ": Voxel value mismatch at (" << i << ", " << j << ", " << k << "): expected "
+            << expectedValue << ", got " << image->GetScalarComponentAsDouble(i, j, k, 0) << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // Brush is clipped at the image boundary
+  CreateImage(image.GetPointer(), 50);
+  strokePoints->Reset();
+  strokePoints->InsertNextPoint(0, 0, 0);
+  if (!vtkOrientedImageDataResample::PaintStroke(image.GetPointer(), brush.GetPointer(), strokePoints.GetPointer(), 1, updateExtent)
+    || !CheckExtent(updateExtent, 0, 3, 0, 3, 0, 3)
+    || image->GetScalarComponentAsDouble(3, 0, 0, 0) != 1 || image->GetScalarComponentAsDouble(2, 2, 2, 0) != 0)
+    {
+    std::cerr << __LINE__ << ": Brush at the image corner is expected to be clipped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Stroke outside of the image does not paint anything
+  strokePoints->Reset();
+  strokePoints->InsertNextPoint(-10, 20, 20);
+  strokePoints->InsertNextPoint(-10, 40, 20);
+  if (vtkOrientedImageDataResample::PaintStroke(image.GetPointer(), brush.GetPointer(), strokePoints.GetPointer(), 1, updateExtent)
+    || !CheckExtent(updateExtent, 0, -1, 0, -1, 0, -1))
+    {
+    std::cerr << __LINE__ << ": Stroke outside of the image is not expected to be painted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Single voxels are painted if there is no brush
+  CreateImage(image.GetPointer(), 50);
+  strokePoints->Reset();
+  strokePoints->InsertNextPoint(1, 1, 1);
+  strokePoints->InsertNextPoint(4, 1, 1);
+  if (!vtkOrientedImageDataResample::PaintStroke(image.GetPointer(), NULL, strokePoints.GetPointer(), 2, updateExtent)
+    || !CheckExtent(updateExtent, 1, 4, 1, 1, 1, 1)
+    || image->GetScalarComponentAsDouble(0, 1, 1, 0) != 0 || image->GetScalarComponentAsDouble(1, 1, 1, 0) != 2
+    || image->GetScalarComponentAsDouble(3, 1, 1, 0) != 2 || image->GetScalarComponentAsDouble(5, 1, 1, 0) != 0
+    || image->GetScalarComponentAsDouble(2, 2, 1, 0) != 0)
+    {
+    std::cerr << __LINE__ << ": Single voxel stroke is painted incorrectly" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Report painting speed of a long stroke with a large brush
+  vtkNew<vtkImageStencilData> largeBrush;
+  CreateSphereBrush(largeBrush.GetPointer(), 15);
+  CreateImage(image.GetPointer(), 256);
+  strokePoints->Reset();
+  for (int pointIndex = 0; pointIndex < 200; ++pointIndex)
+    {
+    strokePoints->InsertNextPoint(28 + pointIndex, 128 + (pointIndex % 40) - 20, 128);
+    }
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  vtkOrientedImageDataResample::PaintStroke(image.GetPointer(), largeBrush.GetPointer(), strokePoints.GetPointer(), 1);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkOrientedImageDataResample-PaintStroke\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  std::cout << "Oriented image data paint stroke test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+namespace
+{
+
+const int INPUT_EXTENT[6] = { 0, 19, 0, 29, 0, 39 };
+
+//----------------------------------------------------------------------------
+unsigned char GetInputValue(int i, int j, int k)
+{
+  return static_cast<unsigned char>((i + 2 * j + 3 * k) % 7);
+}
+
+//----------------------------------------------------------------------------
+/// Reference geometry: refI = inJ + 5, refJ = -inI + 25, refK = inK - 3, plus an optional fractional shift
+void CreateReferenceImage(vtkOrientedImageData* inputImage, double shift, vtkOrientedImageData* referenceImage)
+{
+  vtkNew<vtkMatrix4x4> inputToReferenceIjk;
+  inputToReferenceIjk->Zero();
+  inputToReferenceIjk->SetElement(0, 1, 1.0);
+  inputToReferenceIjk->SetElement(0, 3, 5.0 + shift);
+  inputToReferenceIjk->SetElement(1, 0, -1.0);
+  inputToReferenceIjk->SetElement(1, 3, 25.0 + shift);
+  inputToReferenceIjk->SetElement(2, 2, 1.0);
+  inputToReferenceIjk->SetElement(2, 3, -3.0 + shift);
+  inputToReferenceIjk->SetElement(3, 3, 1.0);
+  vtkNew<vtkMatrix4x4> referenceToInputIjk;
+  vtkMatrix4x4::Invert(inputToReferenceIjk.GetPointer(), referenceToInputIjk.GetPointer());
+
+  vtkNew<vtkMatrix4x4> inputImageToWorld;
+  inputImage->GetImageToWorldMatrix(inputImageToWorld.GetPointer());
+  vtkNew<vtkMatrix4x4> referenceImageToWorld;
+  vtkMatrix4x4::Multiply4x4(inputImageToWorld.GetPointer(), referenceToInputIjk.GetPointer(), referenceImageToWorld.GetPointer());
+  referenceImage->SetGeometryFromImageToWorldMatrix(referenceImageToWorld.GetPointer());
+  referenceImage->SetExtent(0, 40, 0, 30, -10, 30);
+}
+
+//----------------------------------------------------------------------------
+/// Compare resampled image to the expected result of nearest neighbor resampling
+bool CheckResampledImage(vtkOrientedImageData* resampledImage, vtkOrientedImageData* referenceImage)
+{
+  int* extent = resampledImage->GetExtent();
+  int* referenceExtent = referenceImage->GetExtent();
+  for (int i = 0; i < 6; ++i)
+    {
+    if (extent[i] != referenceExtent[i])
+      {
+      std::cerr << "Resampled image extent mismatch" << std::endl;
+      return false;
+      }
+    }
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        int inputI = 25 - j;
+        int inputJ = i - 5;
+        int inputK = k + 3;
+        unsigned char expectedValue = 0;
+        if (inputI >= INPUT_EXTENT[0] && inputI <= INPUT_EXTENT[1]
+          && inputJ >= INPUT_EXTENT[2] && inputJ <= INPUT_EXTENT[3]
+          && inputK >= INPUT_EXTENT[4] && inputK <= INPUT_EXTENT[5])
+          {
+          expectedValue = GetInputValue(inputI, inputJ, inputK);
+          }
+        unsigned char value = *static_cast<unsigned char*>(resampledImage->GetScalarPointer(i, j, k));
+        if (value != expectedValue)
+          {
+          std::cerr << "Voxel value mismatch at (" << i << ", " << j << ", " << k << "): expected "
+            << int(expectedValue) << ", got " << int(value) << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkOrientedImageDataResampleTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkOrientedImageData> inputImage;
+  inputImage->SetExtent(const_cast<int*>(INPUT_EXTENT));
+  inputImage->SetSpacing(1.0, 2.0, 3.0);
+  inputImage->SetOrigin(5.0, 6.0, 7.0);
+  inputImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = INPUT_EXTENT[4]; k <= INPUT_EXTENT[5]; ++k)
+    {
+    for (int j = INPUT_EXTENT[2]; j <= INPUT_EXTENT[3]; ++j)
+      {
+      for (int i = INPUT_EXTENT[0]; i <= INPUT_EXTENT[1]; ++i)
+        {
+        *static_cast<unsigned char*>(inputImage->GetScalarPointer(i, j, k)) = GetInputValue(i, j, k);
+        }
+      }
+    }
+
+  // Axis permutation and whole voxel shift: voxels are copied
+  vtkNew<vtkOrientedImageData> referenceImage;
+  CreateReferenceImage(inputImage.GetPointer(), 0.0, referenceImage.GetPointer());
+  vtkNew<vtkOrientedImageData> resampledImage;
+  if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    inputImage.GetPointer(), referenceImage.GetPointer(), resampledImage.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Resampling failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckResampledImage(resampledImage.GetPointer(), referenceImage.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Resampling with axis permutation failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Fractional shift: voxels are interpolated, nearest neighbor gives the same result
+  vtkNew<vtkOrientedImageData> shiftedReferenceImage;
+  CreateReferenceImage(inputImage.GetPointer(), 0.3, shiftedReferenceImage.GetPointer());
+  vtkNew<vtkOrientedImageData> shiftedResampledImage;
+  if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    inputImage.GetPointer(), shiftedReferenceImage.GetPointer(), shiftedResampledImage.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Resampling failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckResampledImage(shiftedResampledImage.GetPointer(), shiftedReferenceImage.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Resampling with fractional shift failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Only a small region is non-zero: the rest of the output is filled without resampling
+  vtkOrientedImageDataResample::FillImage(inputImage.GetPointer(), 0);
+  int foregroundExtent[6] = { 8, 10, 12, 14, 20, 22 };
+  vtkOrientedImageDataResample::FillImage(inputImage.GetPointer(), 1, foregroundExtent);
+  if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    inputImage.GetPointer(), shiftedReferenceImage.GetPointer(), shiftedResampledImage.GetPointer()))
+    {
+    std::cerr << __LINE__ << ": Resampling failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkOrientedImageDataResample::CalculateEffectiveExtent(shiftedResampledImage.GetPointer(), effectiveExtent);
+  // refI = inJ + 5, refJ = -inI + 25, refK = inK - 3
+  int expectedEffectiveExtent[6] = { 17, 19, 15, 17, 17, 19 };
+  for (int i = 0; i < 6; ++i)
+    {
+    if (effectiveExtent[i] != expectedEffectiveExtent[i])
+      {
+      std::cerr << __LINE__ << ": Effective extent mismatch after resampling sparse image" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Input voxels are larger than reference voxels: interpolated values extend beyond
+  // one reference voxel around the non-zero region (refIJK = 4 * inIJK)
+  vtkNew<vtkOrientedImageData> coarseInputImage;
+  coarseInputImage->SetExtent(0, 9, 0, 9, 0, 9);
+  coarseInputImage->SetSpacing(4.0, 4.0, 4.0);
+  coarseInputImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(coarseInputImage.GetPointer(), 0);
+  int coarseForegroundExtent[6] = { 5, 5, 5, 5, 5, 5 };
+  vtkOrientedImageDataResample::FillImage(coarseInputImage.GetPointer(), 100, coarseForegroundExtent);
+  vtkNew<vtkOrientedImageData> fineReferenceImage;
+  fineReferenceImage->SetExtent(0, 39, 0, 39, 0, 39);
+  vtkNew<vtkOrientedImageData> fineResampledImage;
+  if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    coarseInputImage.GetPointer(), fineReferenceImage.GetPointer(), fineResampledImage.GetPointer(), true))
+    {
+    std::cerr << __LINE__ << ": Resampling failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkOrientedImageDataResample::CalculateEffectiveExtent(fineResampledImage.GetPointer(), effectiveExtent);
+  // Linear interpolation is non-zero within one input voxel (4 reference voxels) of voxel 5
+  int expectedFineEffectiveExtent[6] = { 17, 23, 17, 23, 17, 23 };
+  for (int i = 0; i < 6; ++i)
+    {
+    if (effectiveExtent[i] != expectedFineEffectiveExtent[i])
+      {
+      std::cerr << __LINE__ << ": Effective extent mismatch after resampling to a finer reference image: "
+        << effectiveExtent[i] << " != " << expectedFineEffectiveExtent[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Oriented image data resample test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// SegmentationCore includes
+#include "vtkSegmentation.h"
+#include "vtkSegment.h"
+#include "vtkSegmentationConversionCache.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverterFactory.h"
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Create a segmentation containing a sphere, simulating loading of a segmentation file
+void CreateSegmentation(vtkSegmentation* segmentation)
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 59, 0, 49, 0, 39);
+  labelmap->SetSpacing(0.8, 1.0, 1.3);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = 0; k < 40; ++k)
+    {
+    for (int j = 0; j < 50; ++j)
+      {
+      for (int i = 0; i < 60; ++i)
+        {
+        int distanceSquared = (i - 30) * (i - 30) + (j - 25) * (j - 25) + (k - 20) * (k - 20);
+        *static_cast<unsigned char*>(labelmap->GetScalarPointer(i, j, k)) = (distanceSquared <= 15 * 15 ? 1 : 0);
+        }
+      }
+    }
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+  segmentation->AddSegment(segment.GetPointer(), "Segment_1");
+  // Conversion cache is opt-in
+  segmentation->SetConversionCacheEnabled(true);
+}
+
+//----------------------------------------------------------------------------
+/// Convert to closed surface and return number of points (-1 on failure)
+int ConvertToClosedSurface(vtkSegmentation* segmentation, double* conversionTime=NULL)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!segmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(), true))
+    {
+    return -1;
+    }
+  timer->StopTimer();
+  if (conversionTime)
+    {
+    *conversionTime = timer->GetElapsedTime();
+    }
+  vtkPolyData* closedSurface = vtkPolyData::SafeDownCast(segmentation->GetSegmentRepresentation(
+    "Segment_1", vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()));
+  return (closedSurface ? static_cast<int>(closedSurface->GetNumberOfPoints()) : -1);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationConversionCacheTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule>::New() );
+
+  vtkSegmentationConversionCache* cache = vtkSegmentationConversionCache::GetInstance();
+  cache->RemoveAllCachedRepresentations();
+  std::string cacheDirectory = vtksys::SystemTools::GetCurrentWorkingDirectory() + "/vtkSegmentationConversionCacheTest1";
+  vtksys::SystemTools::RemoveADirectory(cacheDirectory);
+  cache->SetCacheDirectory(cacheDirectory);
+
+  vtkNew<vtkSegmentation> defaultSegmentation;
+  if (defaultSegmentation->GetConversionCacheEnabled())
+    {
+    std::cerr << __LINE__ << ": Conversion cache is expected to be disabled by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkSegmentation> segmentation;
+  CreateSegmentation(segmentation.GetPointer());
+
+  // First conversion is computed
+  int hitsBefore = cache->GetNumberOfHits();
+  double computedConversionTime = 0.0;
+  int numberOfPoints = ConvertToClosedSurface(segmentation.GetPointer(), &computedConversionTime);
+  if (numberOfPoints <= 0 || cache->GetNumberOfHits() != hitsBefore || cache->GetNumberOfCachedRepresentations() != 1)
+    {
+    std::cerr << __LINE__ << ": Initial conversion is expected to be computed and cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Changing a parameter requires a new conversion
+  std::string originalSmoothingFactor = segmentation->GetConversionParameter(
+    vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSmoothingFactorParameterName());
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSmoothingFactorParameterName(), "0.0");
+  if (ConvertToClosedSurface(segmentation.GetPointer()) <= 0 || cache->GetNumberOfHits() != hitsBefore)
+    {
+    std::cerr << __LINE__ << ": Conversion with changed parameter is expected to be computed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Restoring the parameter reuses the first result
+  segmentation->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSmoothingFactorParameterName(), originalSmoothingFactor);
+  if (ConvertToClosedSurface(segmentation.GetPointer()) != numberOfPoints || cache->GetNumberOfHits() != hitsBefore + 1)
+    {
+    std::cerr << __LINE__ << ": Conversion with restored parameter is expected to be found in the cache" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Reloading the same segmentation reuses the result
+  vtkNew<vtkSegmentation> reloadedSegmentation;
+  CreateSegmentation(reloadedSegmentation.GetPointer());
+  double cachedConversionTime = 0.0;
+  if (ConvertToClosedSurface(reloadedSegmentation.GetPointer(), &cachedConversionTime) != numberOfPoints
+    || cache->GetNumberOfHits() != hitsBefore + 2)
+    {
+    std::cerr << __LINE__ << ": Conversion of reloaded segmentation is expected to be found in the cache" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Results are read from disk after they are removed from memory (e.g., in a new application session)
+  cache->RemoveAllCachedRepresentations();
+  vtkNew<vtkSegmentation> segmentationInNewSession;
+  CreateSegmentation(segmentationInNewSession.GetPointer());
+  if (ConvertToClosedSurface(segmentationInNewSession.GetPointer()) != numberOfPoints
+    || cache->GetNumberOfHits() != hitsBefore + 3)
+    {
+    std::cerr << __LINE__ << ": Conversion result is expected to be read from the cache directory" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Cache can be disabled in the converter
+  segmentation->SetConversionCacheEnabled(false);
+  if (ConvertToClosedSurface(segmentation.GetPointer()) != numberOfPoints || cache->GetNumberOfHits() != hitsBefore + 3)
+    {
+    std::cerr << __LINE__ << ": Conversion is expected to be computed if cache is disabled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Memory limit is respected
+  cache->SetMaximumMemorySizeInMiB(1e-6);
+  if (cache->GetNumberOfCachedRepresentations() != 0)
+    {
+    std::cerr << __LINE__ << ": Cached representations are expected to be removed when memory limit is decreased" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "<DartMeasurement name=\"vtkSegmentationConversionCache-ComputedConversion\" type=\"numeric/double\">"
+            << computedConversionTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkSegmentationConversionCache-CachedConversion\" type=\"numeric/double\">"
+            << cachedConversionTime << "</DartMeasurement>" << std::endl;
+
+  cache->SetCacheDirectory("");
+  cache->SetMaximumMemorySizeInMiB(256.0);
+  vtksys::SystemTools::RemoveADirectory(cacheDirectory);
+
+  std::cout << "Segmentation conversion cache test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkImageAccumulate.h>
+#include <vtkNew.h>
+
+// SegmentationCore includes
+#include "vtkSegmentation.h"
+#include "vtkSegmentationHistory.h"
+#include "vtkSegment.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// STD includes
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* GetLabelmap(vtkSegmentation* segmentation)
+{
+  return vtkOrientedImageData::SafeDownCast(segmentation->GetSegmentRepresentation("Segment_1",
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+}
+
+//----------------------------------------------------------------------------
+int GetVoxelCount(vtkSegmentation* segmentation)
+{
+  vtkOrientedImageData* labelmap = GetLabelmap(segmentation);
+  if (!labelmap)
+    {
+    return -1;
+    }
+  vtkNew<vtkImageAccumulate> imageAccumulate;
+  imageAccumulate->SetInputData(labelmap);
+  imageAccumulate->IgnoreZeroOn();
+  imageAccumulate->Update();
+  return static_cast<int>(imageAccumulate->GetVoxelCount());
+}
+
+//----------------------------------------------------------------------------
+/// Paint a small cube in the labelmap, simulating a paint stroke
+void Paint(vtkSegmentation* segmentation, int strokeIndex)
+{
+  vtkOrientedImageData* labelmap = GetLabelmap(segmentation);
+  int cubeExtent[6] = { 0, 3, 0, 3, 4 * strokeIndex, 4 * strokeIndex + 3 };
+  vtkOrientedImageDataResample::FillImage(labelmap, 1, cubeExtent);
+  labelmap->Modified();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationHistoryTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSegmentation> segmentation;
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 127, 0, 127, 0, 127);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 0);
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+  segmentation->AddSegment(segment.GetPointer(), "Segment_1");
+
+  vtkNew<vtkSegmentationHistory> history;
+  history->SetSegmentation(segmentation.GetPointer());
+  history->SetMaximumNumberOfStates(100);
+
+  // Save many states, each after a small edit
+  const int numberOfStrokes = 30;
+  std::vector<int> expectedVoxelCounts;
+  for (int strokeIndex = 0; strokeIndex < numberOfStrokes; ++strokeIndex)
+    {
+    history->SaveState();
+    expectedVoxelCounts.push_back(GetVoxelCount(segmentation.GetPointer()));
+    Paint(segmentation.GetPointer(), strokeIndex);
+    }
+  int finalVoxelCount = GetVoxelCount(segmentation.GetPointer());
+
+  // A full copy of the labelmap is 2 MiB, compressed states must be much smaller than that
+  double memorySizeInMiB = history->GetMemorySizeInMiB();
+  std::cout << "<DartMeasurement name=\"vtkSegmentationHistory-MemorySizeInMiB\" type=\"numeric/double\">"
+            << memorySizeInMiB << "</DartMeasurement>" << std::endl;
+  if (memorySizeInMiB > 1.0)
+    {
+    std::cerr << __LINE__ << ": History memory usage is too high: " << memorySizeInMiB << " MiB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Undo all edits
+  for (int strokeIndex = numberOfStrokes - 1; strokeIndex >= 0; --strokeIndex)
+    {
+    if (!history->RestorePreviousState())
+      {
+      std::cerr << __LINE__ << ": Failed to restore state " << strokeIndex << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (GetVoxelCount(segmentation.GetPointer()) != expectedVoxelCounts[strokeIndex])
+      {
+      std::cerr << __LINE__ << ": Voxel count mismatch in restored state " << strokeIndex << ": expected "
+        << expectedVoxelCounts[strokeIndex] << ", got " << GetVoxelCount(segmentation.GetPointer()) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (history->IsRestorePreviousStateAvailable())
+    {
+    std::cerr << __LINE__ << ": No more undo is expected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Redo all edits
+  while (history->IsRestoreNextStateAvailable())
+    {
+    history->RestoreNextState();
+    }
+  if (GetVoxelCount(segmentation.GetPointer()) != finalVoxelCount)
+    {
+    std::cerr << __LINE__ << ": Voxel count mismatch after redo: expected "
+      << finalVoxelCount << ", got " << GetVoxelCount(segmentation.GetPointer()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Edit after undo is stored on top of the restored state
+  history->RestorePreviousState();
+  int restoredVoxelCount = GetVoxelCount(segmentation.GetPointer());
+  history->SaveState();
+  Paint(segmentation.GetPointer(), numberOfStrokes + 1);
+  if (!history->RestorePreviousState() || GetVoxelCount(segmentation.GetPointer()) != restoredVoxelCount)
+    {
+    std::cerr << __LINE__ << ": Voxel count mismatch after undoing an edit made after undo: expected "
+      << restoredVoxelCount << ", got " << GetVoxelCount(segmentation.GetPointer()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  history->RestoreNextState();
+  if (GetVoxelCount(segmentation.GetPointer()) != restoredVoxelCount + 64)
+    {
+    std::cerr << __LINE__ << ": Voxel count mismatch after redoing an edit made after undo" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Memory limit removes oldest states but the remaining ones can still be restored
+  history->SetMaximumMemorySizeInMiB(memorySizeInMiB / 4);
+  if (history->GetMemorySizeInMiB() > memorySizeInMiB / 4 && history->IsRestorePreviousStateAvailable())
+    {
+    std::cerr << __LINE__ << ": Memory limit is not respected" << std::endl;
+    return EXIT_FAILURE;
+    }
+  while (history->IsRestorePreviousStateAvailable())
+    {
+    if (!history->RestorePreviousState())
+      {
+      std::cerr << __LINE__ << ": Failed to restore state after applying memory limit" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  // Each stroke paints 64 voxels
+  int oldestVoxelCount = GetVoxelCount(segmentation.GetPointer());
+  if (oldestVoxelCount < 0 || oldestVoxelCount % 64 != 0)
+    {
+    std::cerr << __LINE__ << ": Invalid labelmap after restoring oldest remaining state" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Segmentation history test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
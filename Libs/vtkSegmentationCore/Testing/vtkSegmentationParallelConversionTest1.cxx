@@ -0,0 +1,172 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkImageAccumulate.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// SegmentationCore includes
+#include "vtkSegmentation.h"
+#include "vtkSegment.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverterFactory.h"
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
+
+// STD includes
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void OnRepresentationModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* callData)
+{
+  std::vector<std::string>* modifiedSegmentIds = reinterpret_cast<std::vector<std::string>*>(clientData);
+  modifiedSegmentIds->push_back(reinterpret_cast<const char*>(callData));
+}
+
+//----------------------------------------------------------------------------
+void CreateSegmentation(vtkSegmentation* segmentation, int numberOfSegments)
+{
+  segmentation->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName() );
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    vtkNew<vtkSphereSource> sphere;
+    sphere->SetCenter(i * 10.0, 0, 0);
+    sphere->SetRadius(5.0 + i % 4);
+    sphere->Update();
+    vtkNew<vtkSegment> segment;
+    segment->AddRepresentation(
+      vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(), sphere->GetOutput());
+    std::stringstream segmentId;
+    segmentId << "Segment_" << i;
+    segmentation->AddSegment(segment.GetPointer(), segmentId.str());
+    }
+}
+
+//----------------------------------------------------------------------------
+bool ConvertSegmentation(vtkSegmentation* segmentation, int maximumNumberOfThreads,
+  std::vector<std::string>& modifiedSegmentIds, std::vector<int>& voxelCounts, double& conversionTime)
+{
+  segmentation->SetMaximumNumberOfConversionThreads(maximumNumberOfThreads);
+
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(OnRepresentationModified);
+  callback->SetClientData(&modifiedSegmentIds);
+  segmentation->AddObserver(vtkSegmentation::RepresentationModified, callback.GetPointer());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  bool success = segmentation->CreateRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), true);
+  timer->StopTimer();
+  conversionTime = timer->GetElapsedTime();
+
+  segmentation->RemoveObserver(callback.GetPointer());
+
+  for (int i = 0; i < segmentation->GetNumberOfSegments(); ++i)
+    {
+    vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segmentation->GetNthSegment(i)->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+    if (!labelmap)
+      {
+      voxelCounts.push_back(-1);
+      continue;
+      }
+    vtkNew<vtkImageAccumulate> imageAccumulate;
+    imageAccumulate->SetInputData(labelmap);
+    imageAccumulate->IgnoreZeroOn();
+    imageAccumulate->Update();
+    voxelCounts.push_back(static_cast<int>(imageAccumulate->GetVoxelCount()));
+    }
+  return success;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationParallelConversionTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Register converter rules
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule>::New() );
+
+  const int numberOfSegments = 12;
+  vtkNew<vtkSegmentation> segmentation;
+  CreateSegmentation(segmentation.GetPointer(), numberOfSegments);
+  // Both conversions must be computed for comparing them
+  segmentation->SetConversionCacheEnabled(false);
+
+  // Convert on the calling thread
+  std::vector<std::string> serialModifiedSegmentIds;
+  std::vector<int> serialVoxelCounts;
+  double serialTime = 0.0;
+  if (!ConvertSegmentation(segmentation.GetPointer(), 1, serialModifiedSegmentIds, serialVoxelCounts, serialTime))
+    {
+    std::cerr << __LINE__ << ": Serial conversion failed!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Convert using multiple threads
+  std::vector<std::string> parallelModifiedSegmentIds;
+  std::vector<int> parallelVoxelCounts;
+  double parallelTime = 0.0;
+  if (!ConvertSegmentation(segmentation.GetPointer(), 4, parallelModifiedSegmentIds, parallelVoxelCounts, parallelTime))
+    {
+    std::cerr << __LINE__ << ": Parallel conversion failed!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Results and event order must not depend on the number of threads
+  if (parallelVoxelCounts != serialVoxelCounts)
+    {
+    std::cerr << __LINE__ << ": Parallel conversion result differs from serial conversion result!" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    if (parallelVoxelCounts[i] <= 0)
+      {
+      std::cerr << __LINE__ << ": Segment " << i << " has empty binary labelmap after conversion!" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (parallelModifiedSegmentIds.size() != static_cast<size_t>(numberOfSegments)
+    || parallelModifiedSegmentIds != serialModifiedSegmentIds)
+    {
+    std::cerr << __LINE__ << ": RepresentationModified events mismatch. Expected " << numberOfSegments
+      << " events in the same order as in serial conversion, got " << parallelModifiedSegmentIds.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "<DartMeasurement name=\"vtkSegmentation-SerialConversion\" type=\"numeric/double\">"
+            << serialTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkSegmentation-ParallelConversion\" type=\"numeric/double\">"
+            << parallelTime << "</DartMeasurement>" << std::endl;
+
+  std::cout << "Parallel segmentation conversion test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkImageAccumulate.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+
+// SegmentationCore includes
+#include "vtkSegmentation.h"
+#include "vtkSegment.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationHistory.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegmentationConverterFactory.h"
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
+
+// STD includes
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void AddCubeSegment(vtkSegmentation* segmentation, const std::string& segmentId, int origin[3], int size)
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 39, 0, 39, 0, 39);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 0);
+  int cubeExtent[6] = { origin[0], origin[0] + size - 1, origin[1], origin[1] + size - 1, origin[2], origin[2] + size - 1 };
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 1, cubeExtent);
+
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+  segmentation->AddSegment(segment.GetPointer(), segmentId);
+}
+
+//----------------------------------------------------------------------------
+int GetVoxelCount(vtkSegmentation* segmentation, const std::string& segmentId)
+{
+  vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segmentation->GetSegmentRepresentation(
+    segmentId, vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  if (!labelmap)
+    {
+    return -1;
+    }
+  if (labelmap->IsEmpty())
+    {
+    return 0;
+    }
+  vtkNew<vtkImageAccumulate> imageAccumulate;
+  imageAccumulate->SetInputData(labelmap);
+  imageAccumulate->IgnoreZeroOn();
+  imageAccumulate->Update();
+  return static_cast<int>(imageAccumulate->GetVoxelCount());
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationSharedLabelmapTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Register converter rules
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule>::New() );
+
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+
+  // Three non-overlapping segments and one segment overlapping with the first one
+  int origins[4][3] = { { 2, 2, 2 }, { 20, 2, 2 }, { 2, 20, 20 }, { 5, 5, 5 } };
+  int sizes[4] = { 10, 8, 12, 6 };
+  std::vector<std::string> segmentIds;
+  for (int i = 0; i < 4; ++i)
+    {
+    std::stringstream segmentId;
+    segmentId << "Segment_" << i;
+    segmentIds.push_back(segmentId.str());
+    AddCubeSegment(segmentation.GetPointer(), segmentIds[i], origins[i], sizes[i]);
+    }
+
+  std::vector<int> expectedVoxelCounts;
+  for (int i = 0; i < 4; ++i)
+    {
+    expectedVoxelCounts.push_back(sizes[i] * sizes[i] * sizes[i]);
+    }
+
+  // Store labelmaps in shared layers
+  segmentation->SharedLabelmapLayersOn();
+  if (segmentation->GetNumberOfLabelmapLayers() != 2)
+    {
+    std::cerr << __LINE__ << ": Expected 2 shared labelmap layers, got " << segmentation->GetNumberOfLabelmapLayers() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    if (segmentation->GetSegmentLabelmapLayerIndex(segmentIds[i]) != 0
+      || segmentation->GetSegmentLabelValue(segmentIds[i]) != i + 1)
+      {
+      std::cerr << __LINE__ << ": Segment " << segmentIds[i] << " is expected in layer 0 with label value " << i + 1 << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (segmentation->GetSegmentLabelmapLayerIndex(segmentIds[3]) != 1)
+    {
+    std::cerr << __LINE__ << ": Overlapping segment is expected in layer 1" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!segmentation->ContainsRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Segmentation does not report binary labelmap representation" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Read-only access does not move labelmaps out of the layers
+  for (int i = 0; i < 4; ++i)
+    {
+    vtkMTimeType labelmapMTime = segmentation->GetSegmentBinaryLabelmapMTime(segmentIds[i]);
+    vtkNew<vtkOrientedImageData> labelmap;
+    if (!segmentation->GetSegmentBinaryLabelmap(segmentIds[i], labelmap.GetPointer()))
+      {
+      std::cerr << __LINE__ << ": Failed to get binary labelmap of segment " << segmentIds[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkNew<vtkImageAccumulate> imageAccumulate;
+    imageAccumulate->SetInputData(labelmap.GetPointer());
+    imageAccumulate->IgnoreZeroOn();
+    imageAccumulate->Update();
+    if (static_cast<int>(imageAccumulate->GetVoxelCount()) != expectedVoxelCounts[i])
+      {
+      std::cerr << __LINE__ << ": Voxel count mismatch in read-only labelmap of segment " << segmentIds[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (segmentation->GetSegmentLabelmapLayerIndex(segmentIds[i]) < 0
+      || segmentation->GetSegmentBinaryLabelmapMTime(segmentIds[i]) != labelmapMTime)
+      {
+      std::cerr << __LINE__ << ": Read-only access modified the shared labelmap of segment " << segmentIds[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (segmentation->GetNumberOfLabelmapLayers() != 2)
+    {
+    std::cerr << __LINE__ << ": Read-only access changed the number of shared labelmap layers" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Direct segment access extracts the labelmap on demand
+  vtkOrientedImageData* directLabelmap = vtkOrientedImageData::SafeDownCast(segmentation->GetSegment(segmentIds[1])->GetRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  if (!directLabelmap || directLabelmap->IsEmpty())
+    {
+    std::cerr << __LINE__ << ": Segment does not provide its binary labelmap stored in a shared layer" << std::endl;
+    return EXIT_FAILURE;
+    }
+  segmentation->CollapseBinaryLabelmaps();
+  if (segmentation->GetSegmentLabelmapLayerIndex(segmentIds[1]) != 0)
+    {
+    std::cerr << __LINE__ << ": Unmodified labelmap is expected back in layer 0" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Undo history keeps the labelmaps in the layers
+  vtkNew<vtkSegmentationHistory> history;
+  history->SetSegmentation(segmentation.GetPointer());
+  history->SaveState();
+  segmentation->RemoveSegment(segmentIds[2]);
+  history->SaveState();
+  if (!history->RestorePreviousState() || !segmentation->GetSegment(segmentIds[2]))
+    {
+    std::cerr << __LINE__ << ": Failed to restore removed segment" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 4; ++i)
+    {
+    if (segmentation->GetSegmentLabelmapLayerIndex(segmentIds[i]) < 0)
+      {
+      std::cerr << __LINE__ << ": Segment " << segmentIds[i] << " is not stored in a shared layer after undo" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  history->SetSegmentation(NULL);
+
+  // Per-segment view is unchanged
+  for (int i = 0; i < 4; ++i)
+    {
+    int voxelCount = GetVoxelCount(segmentation.GetPointer(), segmentIds[i]);
+    if (voxelCount != expectedVoxelCounts[i])
+      {
+      std::cerr << __LINE__ << ": Voxel count mismatch in segment " << segmentIds[i]
+        << ". Expected " << expectedVoxelCounts[i] << ", got " << voxelCount << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Conversion works on shared labelmaps
+  segmentation->CollapseBinaryLabelmaps();
+  if (!segmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()))
+    {
+    std::cerr << __LINE__ << ": Conversion to closed surface failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 4; ++i)
+    {
+    vtkPolyData* closedSurface = vtkPolyData::SafeDownCast(segmentation->GetSegmentRepresentation(
+      segmentIds[i], vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName()));
+    if (!closedSurface || closedSurface->GetNumberOfPoints() == 0)
+      {
+      std::cerr << __LINE__ << ": Empty closed surface in segment " << segmentIds[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Removing the overlapping segment releases its layer
+  segmentation->CollapseBinaryLabelmaps();
+  segmentation->RemoveSegment(segmentIds[3]);
+  if (segmentation->GetNumberOfLabelmapLayers() != 1)
+    {
+    std::cerr << __LINE__ << ": Expected 1 shared labelmap layer after removing segment, got "
+      << segmentation->GetNumberOfLabelmapLayers() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Deep copy preserves shared labelmaps
+  vtkNew<vtkSegmentation> segmentationCopy;
+  segmentationCopy->DeepCopy(segmentation.GetPointer());
+  for (int i = 0; i < 3; ++i)
+    {
+    int voxelCount = GetVoxelCount(segmentationCopy.GetPointer(), segmentIds[i]);
+    if (voxelCount != expectedVoxelCounts[i])
+      {
+      std::cerr << __LINE__ << ": Voxel count mismatch in copied segment " << segmentIds[i]
+        << ". Expected " << expectedVoxelCounts[i] << ", got " << voxelCount << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Switching back to individual labelmaps
+  segmentation->SharedLabelmapLayersOff();
+  if (segmentation->GetNumberOfLabelmapLayers() != 0)
+    {
+    std::cerr << __LINE__ << ": Shared labelmap layers are not released" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    if (!segmentation->GetSegment(segmentIds[i])->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+      {
+      std::cerr << __LINE__ << ": Segment " << segmentIds[i] << " does not contain its binary labelmap" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Shared labelmap test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
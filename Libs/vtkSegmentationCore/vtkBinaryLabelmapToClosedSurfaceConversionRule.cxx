@@ -31,22 +31,306 @@
 #else
   #include <vtkDiscreteMarchingCubes.h>
 #endif
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageConstantPad.h>
 #include <vtkImageThreshold.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkUnsignedCharArray.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 #include <vtkMatrix3x3.h>
 #include <vtkReverseSense.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkBinaryLabelmapToClosedSurfaceConversionRule);
 
+namespace
+{
+
+/// Names of the arrays that store information for incremental update in the result surface
+const char* INCREMENTAL_UNSMOOTHED_POINTS_ARRAY_NAME = "IncrementalUpdateUnsmoothedPoints";
+const char* INCREMENTAL_MASK_ARRAY_NAME = "IncrementalUpdateMask";
+const char* INCREMENTAL_GEOMETRY_ARRAY_NAME = "IncrementalUpdateGeometry";
+/// Number of values in the geometry array: image to world matrix (16), mask extent (6), smoothing factor, compute normals
+const int INCREMENTAL_GEOMETRY_ARRAY_SIZE = 24;
+
+/// Size of the blocks (in cells along each axis) that are re-extracted if any of their voxels change
+const int INCREMENTAL_BLOCK_SIZE = 16;
+
+/// Number of smoothing iterations. Smoothed position of a point only depends on points within this many
+/// edges distance, which allows updating the smoothed surface locally.
+const int SMOOTHING_ITERATIONS = 20; // based on VTK documentation ("Ten or twenty iterations is all the is usually necessary")
+
+//----------------------------------------------------------------------------
+void SetupSmoothingFilter(vtkWindowedSincPolyDataFilter* smoother, double smoothingFactor)
+{
+  smoother->SetNumberOfIterations(SMOOTHING_ITERATIONS);
+  // This formula maps:
+  // 0.0  -> 1.0   (almost no smoothing)
+  // 0.25 -> 0.1   (average smoothing)
+  // 0.5  -> 0.01  (more smoothing)
+  // 1.0  -> 0.001 (very strong smoothing)
+  double passBand = pow(10.0, -4.0*smoothingFactor);
+  smoother->SetPassBand(passBand);
+  smoother->BoundarySmoothingOff();
+  smoother->FeatureEdgeSmoothingOff();
+  smoother->NonManifoldSmoothingOn();
+  smoother->NormalizeCoordinatesOn();
+}
+
+//----------------------------------------------------------------------------
+inline bool GetMaskBit(const unsigned char* maskBits, vtkIdType index)
+{
+  return ((maskBits[index >> 3] >> (index & 7)) & 1) != 0;
+}
+
+//----------------------------------------------------------------------------
+/// Set bits of the mask where the labelmap is equal to the fill value. Mask extent may be larger than the labelmap extent.
+template<class ImageScalarType>
+void GetForegroundMaskGeneric(vtkImageData* binaryLabelMap, double fillValue, const int maskExtent[6], unsigned char* maskBits)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  binaryLabelMap->GetExtent(extent);
+  vtkIdType maskRowSize = maskExtent[1] - maskExtent[0] + 1;
+  vtkIdType maskSliceSize = maskRowSize * (maskExtent[3] - maskExtent[2] + 1);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      const ImageScalarType* row = static_cast<ImageScalarType*>(binaryLabelMap->GetScalarPointer(extent[0], j, k));
+      vtkIdType maskIndex = (extent[0] - maskExtent[0]) + (j - maskExtent[2]) * maskRowSize + (k - maskExtent[4]) * maskSliceSize;
+      for (int i = 0; i <= extent[1] - extent[0]; ++i, ++maskIndex)
+        {
+        if (row[i] == fillValue)
+          {
+          maskBits[maskIndex >> 3] |= static_cast<unsigned char>(1 << (maskIndex & 7));
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Run discrete marching cubes on the cells of the mask within cellExtent.
+/// Cell (i,j,k) is the cube between voxels (i,j,k) and (i+1,j+1,k+1).
+/// Points of the output are in the IJK coordinate system of the mask.
+vtkSmartPointer<vtkPolyData> ExtractSurfacePatch(const unsigned char* maskBits, const int maskExtent[6], const int cellExtent[6])
+{
+  vtkNew<vtkImageData> patchImage;
+  patchImage->SetExtent(cellExtent[0], cellExtent[1] + 1, cellExtent[2], cellExtent[3] + 1, cellExtent[4], cellExtent[5] + 1);
+  patchImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkIdType maskRowSize = maskExtent[1] - maskExtent[0] + 1;
+  vtkIdType maskSliceSize = maskRowSize * (maskExtent[3] - maskExtent[2] + 1);
+  for (int k = cellExtent[4]; k <= cellExtent[5] + 1; ++k)
+    {
+    for (int j = cellExtent[2]; j <= cellExtent[3] + 1; ++j)
+      {
+      unsigned char* row = static_cast<unsigned char*>(patchImage->GetScalarPointer(cellExtent[0], j, k));
+      vtkIdType maskIndex = (cellExtent[0] - maskExtent[0]) + (j - maskExtent[2]) * maskRowSize + (k - maskExtent[4]) * maskSliceSize;
+      for (int i = 0; i <= cellExtent[1] + 1 - cellExtent[0]; ++i, ++maskIndex)
+        {
+        row[i] = (GetMaskBit(maskBits, maskIndex) ? 1 : 0);
+        }
+      }
+    }
+
+#if VTK_MAJOR_VERSION >= 9
+  vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
+#else
+  vtkNew<vtkDiscreteMarchingCubes> marchingCubes;
+#endif
+  marchingCubes->SetInputData(patchImage.GetPointer());
+  marchingCubes->GenerateValues(1, 1, 1);
+  marchingCubes->ComputeGradientsOff();
+  marchingCubes->ComputeNormalsOff();
+  marchingCubes->ComputeScalarsOff();
+  marchingCubes->Update();
+  vtkSmartPointer<vtkPolyData> patch = marchingCubes->GetOutput();
+  return patch;
+}
+
+//----------------------------------------------------------------------------
+/// Marching cubes generates each triangle within a single cell. The cell is identified by the centroid of the triangle.
+bool IsTriangleInCellExtent(const double point0[3], const double point1[3], const double point2[3], const int cellExtent[6])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    int cellIndex = static_cast<int>(floor((point0[axis] + point1[axis] + point2[axis]) / 3.0));
+    if (cellIndex < cellExtent[axis * 2] || cellIndex > cellExtent[axis * 2 + 1])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Only points on the boundary of the cell extent may be shared between triangles inside and outside the extent
+bool IsPointOnCellExtentBoundary(const double point[3], const int cellExtent[6])
+{
+  bool onBoundary = false;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (point[axis] < cellExtent[axis * 2] || point[axis] > cellExtent[axis * 2 + 1] + 1)
+      {
+      return false;
+      }
+    if (point[axis] == cellExtent[axis * 2] || point[axis] == cellExtent[axis * 2 + 1] + 1)
+      {
+      onBoundary = true;
+      }
+    }
+  return onBoundary;
+}
+
+//----------------------------------------------------------------------------
+/// Marching cubes points are at half voxel positions, therefore doubled coordinates identify the points exactly
+vtkTypeInt64 GetPointKey(const double point[3])
+{
+  const vtkTypeInt64 offset = 1 << 20;
+  vtkTypeInt64 key = 0;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    vtkTypeInt64 doubledCoordinate = static_cast<vtkTypeInt64>(floor(2.0 * point[axis] + 0.5));
+    key = (key << 21) | ((doubledCoordinate + offset) & 0x1FFFFF);
+    }
+  return key;
+}
+
+//----------------------------------------------------------------------------
+/// Update smoothed positions of points within SMOOTHING_ITERATIONS edges distance from the seed points.
+/// The region of twice that distance is smoothed, so that the missing surface beyond the region
+/// does not influence the updated points.
+void SmoothAroundPoints(const std::vector<double>& unsmoothedPoints, const std::vector<vtkIdType>& triangles,
+  const std::vector<vtkIdType>& seedPointIds, double smoothingFactor, std::vector<double>& smoothedPoints)
+{
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(unsmoothedPoints.size() / 3);
+  vtkIdType numberOfTriangles = static_cast<vtkIdType>(triangles.size() / 3);
+
+  // Point neighbors in compressed row storage
+  std::vector<vtkIdType> neighborsStart(numberOfPoints + 1, 0);
+  for (vtkIdType triangleIndex = 0; triangleIndex < numberOfTriangles; ++triangleIndex)
+    {
+    for (int edge = 0; edge < 3; ++edge)
+      {
+      ++neighborsStart[triangles[triangleIndex * 3 + edge] + 1];
+      ++neighborsStart[triangles[triangleIndex * 3 + (edge + 1) % 3] + 1];
+      }
+    }
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    neighborsStart[pointId + 1] += neighborsStart[pointId];
+    }
+  std::vector<vtkIdType> neighbors(neighborsStart[numberOfPoints]);
+  std::vector<vtkIdType> nextNeighbor(neighborsStart.begin(), neighborsStart.end() - 1);
+  for (vtkIdType triangleIndex = 0; triangleIndex < numberOfTriangles; ++triangleIndex)
+    {
+    for (int edge = 0; edge < 3; ++edge)
+      {
+      vtkIdType pointId0 = triangles[triangleIndex * 3 + edge];
+      vtkIdType pointId1 = triangles[triangleIndex * 3 + (edge + 1) % 3];
+      neighbors[nextNeighbor[pointId0]++] = pointId1;
+      neighbors[nextNeighbor[pointId1]++] = pointId0;
+      }
+    }
+
+  // Breadth-first search from the seeds. Points are stored in the order they are reached.
+  const int maximumDistance = 2 * SMOOTHING_ITERATIONS + 1;
+  std::vector<int> distance(numberOfPoints, -1);
+  std::vector<vtkIdType> regionPointIds;
+  for (std::vector<vtkIdType>::const_iterator seedIt = seedPointIds.begin(); seedIt != seedPointIds.end(); ++seedIt)
+    {
+    if (distance[*seedIt] < 0)
+      {
+      distance[*seedIt] = 0;
+      regionPointIds.push_back(*seedIt);
+      }
+    }
+  for (size_t regionIndex = 0; regionIndex < regionPointIds.size(); ++regionIndex)
+    {
+    vtkIdType pointId = regionPointIds[regionIndex];
+    if (distance[pointId] >= maximumDistance)
+      {
+      continue;
+      }
+    for (vtkIdType neighborIndex = neighborsStart[pointId]; neighborIndex < neighborsStart[pointId + 1]; ++neighborIndex)
+      {
+      vtkIdType neighborId = neighbors[neighborIndex];
+      if (distance[neighborId] < 0)
+        {
+        distance[neighborId] = distance[pointId] + 1;
+        regionPointIds.push_back(neighborId);
+        }
+      }
+    }
+
+  // Smooth the region
+  std::vector<vtkIdType> pointIdToRegionPointId(numberOfPoints, -1);
+  vtkNew<vtkPoints> regionPoints;
+  regionPoints->SetNumberOfPoints(static_cast<vtkIdType>(regionPointIds.size()));
+  for (size_t regionIndex = 0; regionIndex < regionPointIds.size(); ++regionIndex)
+    {
+    pointIdToRegionPointId[regionPointIds[regionIndex]] = static_cast<vtkIdType>(regionIndex);
+    regionPoints->SetPoint(static_cast<vtkIdType>(regionIndex), &unsmoothedPoints[regionPointIds[regionIndex] * 3]);
+    }
+  vtkNew<vtkCellArray> regionPolys;
+  for (vtkIdType triangleIndex = 0; triangleIndex < numberOfTriangles; ++triangleIndex)
+    {
+    vtkIdType regionTriangle[3] = { -1, -1, -1 };
+    bool inRegion = true;
+    for (int vertex = 0; vertex < 3 && inRegion; ++vertex)
+      {
+      regionTriangle[vertex] = pointIdToRegionPointId[triangles[triangleIndex * 3 + vertex]];
+      inRegion = (regionTriangle[vertex] >= 0);
+      }
+    if (inRegion)
+      {
+      regionPolys->InsertNextCell(3, regionTriangle);
+      }
+    }
+  vtkNew<vtkPolyData> region;
+  region->SetPoints(regionPoints.GetPointer());
+  region->SetPolys(regionPolys.GetPointer());
+
+  vtkNew<vtkWindowedSincPolyDataFilter> smoother;
+  smoother->SetInputData(region.GetPointer());
+  SetupSmoothingFilter(smoother.GetPointer(), smoothingFactor);
+  smoother->Update();
+  vtkPoints* smoothedRegionPoints = smoother->GetOutput()->GetPoints();
+  if (!smoothedRegionPoints || smoothedRegionPoints->GetNumberOfPoints() != regionPoints->GetNumberOfPoints())
+    {
+    return;
+    }
+  for (size_t regionIndex = 0; regionIndex < regionPointIds.size(); ++regionIndex)
+    {
+    vtkIdType pointId = regionPointIds[regionIndex];
+    if (distance[pointId] <= SMOOTHING_ITERATIONS)
+      {
+      smoothedRegionPoints->GetPoint(static_cast<vtkIdType>(regionIndex), &smoothedPoints[pointId * 3]);
+      }
+    }
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurfaceConversionRule()
 {
@@ -58,6 +342,10 @@ vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurface
   this->ConversionParameters[GetComputeSurfaceNormalsParameterName()] = std::make_pair("1",
     "Compute surface normals. 1 (default) = surface normals are computed. "
     "0 = surface normals are not computed (slightly faster but produces less smooth surface display).");
+  this->ConversionParameters[GetIncrementalUpdateParameterName()] = std::make_pair("0",
+    "Update the surface incrementally after labelmap changes. 1 = only surface patches around the modified region are"
+    " regenerated (faster update after local edits, but the surface stores additional data). 0 (default) = the whole"
+    " surface is regenerated. Incremental update is not available if decimation is enabled.");
 }
 
 //----------------------------------------------------------------------------
@@ -143,6 +431,11 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
     return true;
     }
 
+  if (this->IsIncrementalConversionEnabled())
+    {
+    return this->ConvertIncremental(orientedBinaryLabelMap, closedSurfacePolyData);
+    }
+
   /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
   /// This function adds a 1 voxel padding to the labelmap in these cases.
   bool paddingNecessary = this->IsLabelmapPaddingNecessary(binaryLabelMap);
@@ -217,18 +510,7 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
     {
     vtkSmartPointer<vtkWindowedSincPolyDataFilter> smoother = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
     smoother->SetInputData(processingResult);
-    smoother->SetNumberOfIterations(20); // based on VTK documentation ("Ten or twenty iterations is all the is usually necessary")
-    // This formula maps:
-    // 0.0  -> 1.0   (almost no smoothing)
-    // 0.25 -> 0.1   (average smoothing)
-    // 0.5  -> 0.01  (more smoothing)
-    // 1.0  -> 0.001 (very strong smoothing)
-    double passBand = pow(10.0, -4.0*smoothingFactor);
-    smoother->SetPassBand(passBand);
-    smoother->BoundarySmoothingOff();
-    smoother->FeatureEdgeSmoothingOff();
-    smoother->NonManifoldSmoothingOn();
-    smoother->NormalizeCoordinatesOn();
+    SetupSmoothingFilter(smoother, smoothingFactor);
     smoother->Update();
     processingResult = smoother->GetOutput();
     }
@@ -290,6 +572,329 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::IsIncrementalConversionEnabled()
+{
+  int incrementalUpdate = vtkVariant(this->ConversionParameters[GetIncrementalUpdateParameterName()].first).ToInt();
+  double decimationFactor = vtkVariant(this->ConversionParameters[GetDecimationFactorParameterName()].first).ToDouble();
+  // Decimation changes the whole surface, therefore it cannot be updated locally
+  return incrementalUpdate > 0 && decimationFactor <= 0.0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::ConvertIncremental(vtkOrientedImageData* binaryLabelMap, vtkPolyData* closedSurfacePolyData)
+{
+  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
+  int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
+
+  // The mask is padded so that the surface is closed where the labelmap has foreground border voxels
+  int maskExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  binaryLabelMap->GetExtent(maskExtent);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    --maskExtent[axis * 2];
+    ++maskExtent[axis * 2 + 1];
+    }
+  vtkIdType maskDimensions[3] = { maskExtent[1] - maskExtent[0] + 1, maskExtent[3] - maskExtent[2] + 1, maskExtent[5] - maskExtent[4] + 1 };
+  vtkIdType numberOfMaskVoxels = maskDimensions[0] * maskDimensions[1] * maskDimensions[2];
+  vtkSmartPointer<vtkUnsignedCharArray> mask = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  mask->SetName(INCREMENTAL_MASK_ARRAY_NAME);
+  mask->SetNumberOfTuples((numberOfMaskVoxels + 7) / 8);
+  memset(mask->GetPointer(0), 0, mask->GetNumberOfTuples());
+  const int labelmapFillValue = binaryLabelMap->GetScalarRange()[1]; // max value
+  if (labelmapFillValue != 0)
+    {
+    switch (binaryLabelMap->GetScalarType())
+      {
+      vtkTemplateMacro(GetForegroundMaskGeneric<VTK_TT>(binaryLabelMap, labelmapFillValue, maskExtent, mask->GetPointer(0)));
+      default:
+        vtkErrorMacro("ConvertIncremental: Unknown image scalar type!");
+        return false;
+      }
+    }
+
+  vtkSmartPointer<vtkMatrix4x4> labelmapImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  binaryLabelMap->GetImageToWorldMatrix(labelmapImageToWorldMatrix);
+  vtkSmartPointer<vtkDoubleArray> geometry = vtkSmartPointer<vtkDoubleArray>::New();
+  geometry->SetName(INCREMENTAL_GEOMETRY_ARRAY_NAME);
+  geometry->SetNumberOfTuples(INCREMENTAL_GEOMETRY_ARRAY_SIZE);
+  for (int i = 0; i < 16; ++i)
+    {
+    geometry->SetValue(i, labelmapImageToWorldMatrix->GetElement(i / 4, i % 4));
+    }
+  for (int i = 0; i < 6; ++i)
+    {
+    geometry->SetValue(16 + i, maskExtent[i]);
+    }
+  geometry->SetValue(22, smoothingFactor);
+  geometry->SetValue(23, computeSurfaceNormals);
+
+  // Determine if the target contains a previous conversion result that can be updated
+  vtkUnsignedCharArray* previousMask = vtkUnsignedCharArray::SafeDownCast(
+    closedSurfacePolyData->GetFieldData()->GetAbstractArray(INCREMENTAL_MASK_ARRAY_NAME));
+  vtkDoubleArray* previousGeometry = vtkDoubleArray::SafeDownCast(
+    closedSurfacePolyData->GetFieldData()->GetAbstractArray(INCREMENTAL_GEOMETRY_ARRAY_NAME));
+  vtkDataArray* previousUnsmoothedPoints = closedSurfacePolyData->GetPointData()->GetArray(INCREMENTAL_UNSMOOTHED_POINTS_ARRAY_NAME);
+  bool previousResultValid = (previousMask && previousGeometry
+    && previousMask->GetNumberOfTuples() == mask->GetNumberOfTuples()
+    && previousGeometry->GetNumberOfTuples() == INCREMENTAL_GEOMETRY_ARRAY_SIZE
+    && closedSurfacePolyData->GetNumberOfCells() == closedSurfacePolyData->GetNumberOfPolys()
+    && (previousUnsmoothedPoints
+      ? (previousUnsmoothedPoints->GetNumberOfComponents() == 3
+        && previousUnsmoothedPoints->GetNumberOfTuples() == closedSurfacePolyData->GetNumberOfPoints())
+      : closedSurfacePolyData->GetNumberOfPoints() == 0));
+  for (int i = 0; previousResultValid && i < INCREMENTAL_GEOMETRY_ARRAY_SIZE; ++i)
+    {
+    previousResultValid = (previousGeometry->GetValue(i) == geometry->GetValue(i));
+    }
+
+  // Cells to re-extract. All cells if there is no valid previous result.
+  int modifiedCellExtent[6] = { maskExtent[0], maskExtent[1] - 1, maskExtent[2], maskExtent[3] - 1, maskExtent[4], maskExtent[5] - 1 };
+  if (previousResultValid)
+    {
+    int modifiedVoxelExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    const unsigned char* maskBits = mask->GetPointer(0);
+    const unsigned char* previousMaskBits = previousMask->GetPointer(0);
+    vtkIdType numberOfMaskBytes = mask->GetNumberOfTuples();
+    for (vtkIdType byteIndex = 0; byteIndex < numberOfMaskBytes; ++byteIndex)
+      {
+      unsigned char difference = maskBits[byteIndex] ^ previousMaskBits[byteIndex];
+      if (!difference)
+        {
+        continue;
+        }
+      for (int bit = 0; bit < 8; ++bit)
+        {
+        if (!(difference & (1 << bit)))
+          {
+          continue;
+          }
+        vtkIdType voxelIndex = byteIndex * 8 + bit;
+        int voxel[3] =
+          {
+          maskExtent[0] + static_cast<int>(voxelIndex % maskDimensions[0]),
+          maskExtent[2] + static_cast<int>((voxelIndex / maskDimensions[0]) % maskDimensions[1]),
+          maskExtent[4] + static_cast<int>(voxelIndex / (maskDimensions[0] * maskDimensions[1]))
+          };
+        for (int axis = 0; axis < 3; ++axis)
+          {
+          modifiedVoxelExtent[axis * 2] = std::min(modifiedVoxelExtent[axis * 2], voxel[axis]);
+          modifiedVoxelExtent[axis * 2 + 1] = std::max(modifiedVoxelExtent[axis * 2 + 1], voxel[axis]);
+          }
+        }
+      }
+    if (modifiedVoxelExtent[0] > modifiedVoxelExtent[1])
+      {
+      // Labelmap has not changed since the previous conversion, the target is up-to-date
+      return true;
+      }
+    // Cells that have any modified voxel as corner, extended to whole blocks
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      int firstCell = std::max(modifiedVoxelExtent[axis * 2] - 1, maskExtent[axis * 2]);
+      int lastCell = std::min(modifiedVoxelExtent[axis * 2 + 1], maskExtent[axis * 2 + 1] - 1);
+      modifiedCellExtent[axis * 2] = maskExtent[axis * 2]
+        + ((firstCell - maskExtent[axis * 2]) / INCREMENTAL_BLOCK_SIZE) * INCREMENTAL_BLOCK_SIZE;
+      modifiedCellExtent[axis * 2 + 1] = std::min(maskExtent[axis * 2 + 1] - 1, maskExtent[axis * 2]
+        + ((lastCell - maskExtent[axis * 2]) / INCREMENTAL_BLOCK_SIZE + 1) * INCREMENTAL_BLOCK_SIZE - 1);
+      }
+    }
+
+  // Merge triangles of the previous result outside the modified blocks with the re-extracted patch.
+  // Unsmoothed points are in IJK coordinate system. Smoothed points of the new patch are computed later.
+  std::vector<double> unsmoothedPoints;
+  std::vector<double> smoothedPoints;
+  std::vector<vtkIdType> triangles;
+  // Points of new and removed triangles, around which the surface has to be smoothed again
+  std::vector<vtkIdType> seedPointIds;
+  std::map<vtkTypeInt64, vtkIdType> boundaryPointIds;
+  vtkNew<vtkIdList> cellPointIds;
+  if (previousResultValid && closedSurfacePolyData->GetNumberOfPolys() > 0)
+    {
+    vtkNew<vtkMatrix4x4> labelmapWorldToImageMatrix;
+    vtkMatrix4x4::Invert(labelmapImageToWorldMatrix, labelmapWorldToImageMatrix.GetPointer());
+    vtkPoints* previousPoints = closedSurfacePolyData->GetPoints();
+    std::vector<vtkIdType> previousToMergedPointIds(closedSurfacePolyData->GetNumberOfPoints(), -1);
+    std::vector<vtkIdType> removedTrianglePointIds;
+    vtkCellArray* previousPolys = closedSurfacePolyData->GetPolys();
+    previousPolys->InitTraversal();
+    while (previousPolys->GetNextCell(cellPointIds.GetPointer()))
+      {
+      if (cellPointIds->GetNumberOfIds() != 3)
+        {
+        continue;
+        }
+      double trianglePoints[3][3];
+      for (int vertex = 0; vertex < 3; ++vertex)
+        {
+        previousUnsmoothedPoints->GetTuple(cellPointIds->GetId(vertex), trianglePoints[vertex]);
+        }
+      if (IsTriangleInCellExtent(trianglePoints[0], trianglePoints[1], trianglePoints[2], modifiedCellExtent))
+        {
+        for (int vertex = 0; vertex < 3; ++vertex)
+          {
+          removedTrianglePointIds.push_back(cellPointIds->GetId(vertex));
+          }
+        continue;
+        }
+      for (int vertex = 0; vertex < 3; ++vertex)
+        {
+        vtkIdType& mergedPointId = previousToMergedPointIds[cellPointIds->GetId(vertex)];
+        if (mergedPointId < 0)
+          {
+          mergedPointId = static_cast<vtkIdType>(unsmoothedPoints.size() / 3);
+          double worldPoint[4] = { 0.0, 0.0, 0.0, 1.0 };
+          previousPoints->GetPoint(cellPointIds->GetId(vertex), worldPoint);
+          double ijkPoint[4] = { 0.0, 0.0, 0.0, 1.0 };
+          labelmapWorldToImageMatrix->MultiplyPoint(worldPoint, ijkPoint);
+          for (int axis = 0; axis < 3; ++axis)
+            {
+            unsmoothedPoints.push_back(trianglePoints[vertex][axis]);
+            smoothedPoints.push_back(ijkPoint[axis]);
+            }
+          if (IsPointOnCellExtentBoundary(trianglePoints[vertex], modifiedCellExtent))
+            {
+            boundaryPointIds[GetPointKey(trianglePoints[vertex])] = mergedPointId;
+            }
+          }
+        triangles.push_back(mergedPointId);
+        }
+      }
+    for (std::vector<vtkIdType>::iterator pointIt = removedTrianglePointIds.begin(); pointIt != removedTrianglePointIds.end(); ++pointIt)
+      {
+      if (previousToMergedPointIds[*pointIt] >= 0)
+        {
+        seedPointIds.push_back(previousToMergedPointIds[*pointIt]);
+        }
+      }
+    }
+
+  vtkSmartPointer<vtkPolyData> patch = ExtractSurfacePatch(mask->GetPointer(0), maskExtent, modifiedCellExtent);
+  if (patch->GetNumberOfPolys() > 0)
+    {
+    vtkPoints* patchPoints = patch->GetPoints();
+    std::vector<vtkIdType> patchToMergedPointIds(patch->GetNumberOfPoints(), -1);
+    vtkCellArray* patchPolys = patch->GetPolys();
+    patchPolys->InitTraversal();
+    while (patchPolys->GetNextCell(cellPointIds.GetPointer()))
+      {
+      if (cellPointIds->GetNumberOfIds() != 3)
+        {
+        continue;
+        }
+      double trianglePoints[3][3];
+      for (int vertex = 0; vertex < 3; ++vertex)
+        {
+        patchPoints->GetPoint(cellPointIds->GetId(vertex), trianglePoints[vertex]);
+        }
+      if (!IsTriangleInCellExtent(trianglePoints[0], trianglePoints[1], trianglePoints[2], modifiedCellExtent))
+        {
+        continue;
+        }
+      for (int vertex = 0; vertex < 3; ++vertex)
+        {
+        vtkIdType& mergedPointId = patchToMergedPointIds[cellPointIds->GetId(vertex)];
+        if (mergedPointId < 0)
+          {
+          bool onBoundary = IsPointOnCellExtentBoundary(trianglePoints[vertex], modifiedCellExtent);
+          std::map<vtkTypeInt64, vtkIdType>::iterator boundaryPointIt = boundaryPointIds.end();
+          if (onBoundary)
+            {
+            boundaryPointIt = boundaryPointIds.find(GetPointKey(trianglePoints[vertex]));
+            }
+          if (boundaryPointIt != boundaryPointIds.end())
+            {
+            // Stitch to the point of the previous surface
+            mergedPointId = boundaryPointIt->second;
+            }
+          else
+            {
+            mergedPointId = static_cast<vtkIdType>(unsmoothedPoints.size() / 3);
+            for (int axis = 0; axis < 3; ++axis)
+              {
+              unsmoothedPoints.push_back(trianglePoints[vertex][axis]);
+              smoothedPoints.push_back(trianglePoints[vertex][axis]);
+              }
+            if (onBoundary)
+              {
+              boundaryPointIds[GetPointKey(trianglePoints[vertex])] = mergedPointId;
+              }
+            }
+          }
+        triangles.push_back(mergedPointId);
+        seedPointIds.push_back(mergedPointId);
+        }
+      }
+    }
+
+  if (smoothingFactor > 0 && !triangles.empty())
+    {
+    SmoothAroundPoints(unsmoothedPoints, triangles, seedPointIds, smoothingFactor, smoothedPoints);
+    }
+
+  // Assemble the surface in IJK coordinate system
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(unsmoothedPoints.size() / 3);
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkNew<vtkFloatArray> unsmoothedPointsArray;
+  unsmoothedPointsArray->SetName(INCREMENTAL_UNSMOOTHED_POINTS_ARRAY_NAME);
+  unsmoothedPointsArray->SetNumberOfComponents(3);
+  unsmoothedPointsArray->SetNumberOfTuples(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    points->SetPoint(pointId, &smoothedPoints[pointId * 3]);
+    unsmoothedPointsArray->SetTuple(pointId, &unsmoothedPoints[pointId * 3]);
+    }
+  vtkNew<vtkCellArray> polys;
+  for (size_t triangleIndex = 0; triangleIndex < triangles.size() / 3; ++triangleIndex)
+    {
+    polys->InsertNextCell(3, &triangles[triangleIndex * 3]);
+    }
+
+  if (triangles.empty())
+    {
+    vtkNew<vtkPolyData> emptySurface;
+    closedSurfacePolyData->ShallowCopy(emptySurface.GetPointer());
+    }
+  else
+    {
+    vtkNew<vtkPolyData> surfaceIjk;
+    surfaceIjk->SetPoints(points.GetPointer());
+    surfaceIjk->SetPolys(polys.GetPointer());
+    surfaceIjk->GetPointData()->AddArray(unsmoothedPointsArray.GetPointer());
+
+    // Transform the result surface from labelmap IJK to world coordinate system
+    vtkNew<vtkTransform> labelmapGeometryTransform;
+    labelmapGeometryTransform->SetMatrix(labelmapImageToWorldMatrix);
+    vtkNew<vtkTransformPolyDataFilter> transformPolyDataFilter;
+    transformPolyDataFilter->SetInputData(surfaceIjk.GetPointer());
+    transformPolyDataFilter->SetTransform(labelmapGeometryTransform.GetPointer());
+    if (computeSurfaceNormals > 0)
+      {
+      vtkNew<vtkPolyDataNormals> polyDataNormals;
+      polyDataNormals->SetInputConnection(transformPolyDataFilter->GetOutputPort());
+      polyDataNormals->ConsistencyOn(); // discrete marching cubes may generate inconsistent surface
+      polyDataNormals->SplittingOff();
+      polyDataNormals->Update();
+      closedSurfacePolyData->ShallowCopy(polyDataNormals->GetOutput());
+      }
+    else
+      {
+      transformPolyDataFilter->Update();
+      closedSurfacePolyData->ShallowCopy(transformPolyDataFilter->GetOutput());
+      }
+    }
+
+  // Store the converted labelmap for the next update. A new field data object is used,
+  // as the current one may be shared with the previous conversion result.
+  vtkNew<vtkFieldData> fieldData;
+  fieldData->AddArray(mask);
+  fieldData->AddArray(geometry);
+  closedSurfacePolyData->SetFieldData(fieldData.GetPointer());
+  return true;
+}
+
 //----------------------------------------------------------------------------
 template<class ImageScalarType>
 void IsLabelmapPaddingNecessaryGeneric(vtkImageData* binaryLabelMap, bool &paddingNecessary)
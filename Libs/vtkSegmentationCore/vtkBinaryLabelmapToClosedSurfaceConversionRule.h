@@ -27,11 +27,18 @@
 
 #include "vtkSegmentationCoreConfigure.h"
 
+class vtkPolyData;
+
 /// \ingroup SegmentationCore
 /// \brief Convert binary labelmap representation (vtkOrientedImageData type) to
 ///   closed surface representation (vtkPolyData type). The conversion algorithm
 ///   performs a marching cubes operation on the image data followed by an optional
 ///   decimation step.
+///
+/// If incremental update is enabled (and decimation is disabled) then the result surface also stores
+/// the labelmap it was created from and the surface before smoothing. When the rule is asked to update
+/// such a surface then only blocks of the labelmap that have changed since are re-extracted, and only
+/// the neighborhood of the re-extracted patches is smoothed again.
 class vtkSegmentationCore_EXPORT vtkBinaryLabelmapToClosedSurfaceConversionRule
   : public vtkSegmentationConverterRule
 {
@@ -42,6 +49,8 @@ public:
   static const std::string GetSmoothingFactorParameterName() { return "Smoothing factor"; };
   /// Conversion parameter: compute surface normals
   static const std::string GetComputeSurfaceNormalsParameterName() { return "Compute surface normals"; };
+  /// Conversion parameter: incremental update
+  static const std::string GetIncrementalUpdateParameterName() { return "Incremental update"; };
 
 public:
   static vtkBinaryLabelmapToClosedSurfaceConversionRule* New();
@@ -73,11 +82,18 @@ public:
   /// Human-readable name of the target representation
   virtual const char* GetTargetRepresentationName() VTK_OVERRIDE { return vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(); };
 
+  /// Incremental update is used if it is enabled in the conversion parameters and decimation is disabled
+  virtual bool IsIncrementalConversionEnabled() VTK_OVERRIDE;
+
 protected:
   /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
   /// This function checks whether this is the case.
   bool IsLabelmapPaddingNecessary(vtkImageData* binaryLabelMap);
 
+  /// Convert labelmap to closed surface, reusing the parts of the previous conversion result (if it is
+  /// stored in the target surface) that are not affected by the changes of the labelmap since then.
+  bool ConvertIncremental(vtkOrientedImageData* binaryLabelMap, vtkPolyData* closedSurfacePolyData);
+
 protected:
   vtkBinaryLabelmapToClosedSurfaceConversionRule();
   ~vtkBinaryLabelmapToClosedSurfaceConversionRule();
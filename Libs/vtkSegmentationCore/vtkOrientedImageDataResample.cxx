@@ -29,11 +29,14 @@
 #include <vtkGeneralTransform.h>
 #include <vtkImageReslice.h>
 #include <vtkImageConstantPad.h>
+#include <vtkImageStencilData.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlaneSource.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
@@ -42,9 +45,402 @@
 
 // STD includes
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// SSE2 is part of the x86-64 baseline instruction set, therefore it can be used without extra compiler flags
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VTK_SEGMENTATION_CORE_USE_SSE2
+#include <emmintrin.h>
+#endif
 
 vtkStandardNewMacro(vtkOrientedImageDataResample);
 
+namespace
+{
+
+/// Below this number of voxels copying and merging is not split between threads
+const vtkIdType MINIMUM_NUMBER_OF_VOXELS_FOR_THREADING = 64 * 64 * 64;
+
+//----------------------------------------------------------------------------
+/// Determine if the matrix maps voxel centers to voxel centers, i.e., it only permutes and flips axes
+/// and shifts by whole voxels: outputIjk[axis] = signs[axis] * inputIjk[permutation[axis]] + offsets[axis]
+bool GetVoxelPermutation(vtkMatrix4x4* inputToOutputIjkMatrix, int permutation[3], int signs[3], int offsets[3])
+{
+  bool inputAxisUsed[3] = { false, false, false };
+  for (int row = 0; row < 3; ++row)
+    {
+    permutation[row] = -1;
+    for (int column = 0; column < 3; ++column)
+      {
+      double element = inputToOutputIjkMatrix->GetElement(row, column);
+      if (vtkOrientedImageDataResample::AreEqualWithTolerance(element, 0.0))
+        {
+        continue;
+        }
+      if (permutation[row] >= 0 || inputAxisUsed[column]
+        || !vtkOrientedImageDataResample::AreEqualWithTolerance(fabs(element), 1.0))
+        {
+        return false;
+        }
+      permutation[row] = column;
+      signs[row] = (element > 0 ? 1 : -1);
+      inputAxisUsed[column] = true;
+      }
+    if (permutation[row] < 0)
+      {
+      return false;
+      }
+    double offset = inputToOutputIjkMatrix->GetElement(row, 3);
+    offsets[row] = static_cast<int>(floor(offset + 0.5));
+    if (!vtkOrientedImageDataResample::AreEqualWithTolerance(offset, offsets[row]))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+struct PermutedCopyThreadData
+{
+  vtkImageData* InputImage;
+  vtkImageData* OutputImage;
+  /// Region of the output image that input voxels are copied to
+  int CopyExtent[6];
+  int Permutation[3];
+  int Signs[3];
+  int Offsets[3];
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE CopyPermutedVoxelsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  PermutedCopyThreadData* data = static_cast<PermutedCopyThreadData*>(threadInfo->UserData);
+  const int* copyExtent = data->CopyExtent;
+
+  vtkIdType voxelSize = data->InputImage->GetScalarSize() * data->InputImage->GetNumberOfScalarComponents();
+  vtkIdType inputIncrements[3] = { 0, 0, 0 };
+  data->InputImage->GetIncrements(inputIncrements);
+  // Input pointer step (in bytes) corresponding to a step along the output row
+  vtkIdType inputRowStep = data->Signs[0] * inputIncrements[data->Permutation[0]] * data->InputImage->GetScalarSize();
+  vtkIdType rowLength = copyExtent[1] - copyExtent[0] + 1;
+
+  // Slices are distributed between the threads
+  for (int k = copyExtent[4] + threadInfo->ThreadID; k <= copyExtent[5]; k += threadInfo->NumberOfThreads)
+    {
+    for (int j = copyExtent[2]; j <= copyExtent[3]; ++j)
+      {
+      int outputIjk[3] = { copyExtent[0], j, k };
+      int inputIjk[3] = { 0, 0, 0 };
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        inputIjk[data->Permutation[axis]] = data->Signs[axis] * (outputIjk[axis] - data->Offsets[axis]);
+        }
+      const char* inputPtr = static_cast<char*>(data->InputImage->GetScalarPointer(inputIjk));
+      char* outputPtr = static_cast<char*>(data->OutputImage->GetScalarPointer(outputIjk));
+      if (inputRowStep == voxelSize)
+        {
+        memcpy(outputPtr, inputPtr, rowLength * voxelSize);
+        continue;
+        }
+      for (vtkIdType i = 0; i < rowLength; ++i, outputPtr += voxelSize, inputPtr += inputRowStep)
+        {
+        memcpy(outputPtr, inputPtr, voxelSize);
+        }
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Allocate image with the scalar type and number of components of the template image and fill it with a value
+void AllocateFilledImage(vtkImageData* image, const int extent[6], vtkImageData* templateImage, double fillValue)
+{
+  image->SetExtent(const_cast<int*>(extent));
+  image->AllocateScalars(templateImage->GetScalarType(), templateImage->GetNumberOfScalarComponents());
+  vtkOrientedImageDataResample::FillImage(image, fillValue);
+}
+
+//----------------------------------------------------------------------------
+/// Resample by copying voxels. Input voxels must map exactly to output voxels (see GetVoxelPermutation).
+void CopyPermutedVoxels(vtkImageData* inputImage, vtkImageData* outputImage, const int outputExtent[6],
+  const int permutation[3], const int signs[3], const int offsets[3], double backgroundValue)
+{
+  PermutedCopyThreadData data;
+  data.InputImage = inputImage;
+  data.OutputImage = outputImage;
+  int* inputExtent = inputImage->GetExtent();
+  bool emptyCopyExtent = false;
+  vtkIdType numberOfVoxelsToCopy = 1;
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    data.Permutation[axis] = permutation[axis];
+    data.Signs[axis] = signs[axis];
+    data.Offsets[axis] = offsets[axis];
+    int bound1 = signs[axis] * inputExtent[permutation[axis] * 2] + offsets[axis];
+    int bound2 = signs[axis] * inputExtent[permutation[axis] * 2 + 1] + offsets[axis];
+    data.CopyExtent[axis * 2] = std::max(std::min(bound1, bound2), outputExtent[axis * 2]);
+    data.CopyExtent[axis * 2 + 1] = std::min(std::max(bound1, bound2), outputExtent[axis * 2 + 1]);
+    emptyCopyExtent = emptyCopyExtent || (data.CopyExtent[axis * 2] > data.CopyExtent[axis * 2 + 1]);
+    numberOfVoxelsToCopy *= std::max(0, data.CopyExtent[axis * 2 + 1] - data.CopyExtent[axis * 2] + 1);
+    }
+
+  outputImage->SetExtent(const_cast<int*>(outputExtent));
+  outputImage->AllocateScalars(inputImage->GetScalarType(), inputImage->GetNumberOfScalarComponents());
+  bool copyFillsOutput = !emptyCopyExtent;
+  for (int i = 0; i < 6; ++i)
+    {
+    copyFillsOutput = copyFillsOutput && (data.CopyExtent[i] == outputExtent[i]);
+    }
+  if (!copyFillsOutput)
+    {
+    vtkOrientedImageDataResample::FillImage(outputImage, backgroundValue);
+    }
+  if (emptyCopyExtent)
+    {
+    return;
+    }
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = 1;
+  if (numberOfVoxelsToCopy >= MINIMUM_NUMBER_OF_VOXELS_FOR_THREADING)
+    {
+    numberOfThreads = std::min(threader->GetNumberOfThreads(), data.CopyExtent[5] - data.CopyExtent[4] + 1);
+    }
+  threader->SetNumberOfThreads(std::max(numberOfThreads, 1));
+  threader->SetSingleMethod(CopyPermutedVoxelsThreadFunction, &data);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+/// Copy a region between images of the same scalar type and number of components
+void CopyImageRegion(vtkImageData* sourceImage, vtkImageData* targetImage, const int extent[6])
+{
+  size_t rowSizeInBytes = static_cast<size_t>(extent[1] - extent[0] + 1)
+    * sourceImage->GetScalarSize() * sourceImage->GetNumberOfScalarComponents();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      memcpy(targetImage->GetScalarPointer(extent[0], j, k), sourceImage->GetScalarPointer(extent[0], j, k), rowSizeInBytes);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Merge a row of voxels into the base image. Returns true if any base image voxel was changed
+/// (in masking mode: if any modifier voxel is above the threshold).
+template <class BaseImageScalarType, class ModifierImageScalarType>
+bool MergeRow(BaseImageScalarType* basePtr, const ModifierImageScalarType* modifierPtr, vtkIdType length,
+  int operation, ModifierImageScalarType maskThreshold, BaseImageScalarType fillValue)
+{
+  bool baseImageModified = false;
+  BaseImageScalarType* baseEndPtr = basePtr + length;
+  // The operation is checked outside of the loops to keep the per-voxel work minimal
+  if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+    {
+    for (; basePtr != baseEndPtr; ++basePtr, ++modifierPtr)
+      {
+      if (static_cast<BaseImageScalarType>(*modifierPtr) > *basePtr)
+        {
+        *basePtr = *modifierPtr;
+        baseImageModified = true;
+        }
+      }
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
+    {
+    for (; basePtr != baseEndPtr; ++basePtr, ++modifierPtr)
+      {
+      if (static_cast<BaseImageScalarType>(*modifierPtr) < *basePtr)
+        {
+        *basePtr = *modifierPtr;
+        baseImageModified = true;
+        }
+      }
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+    {
+    for (; basePtr != baseEndPtr; ++basePtr, ++modifierPtr)
+      {
+      if ((*modifierPtr) > maskThreshold)
+        {
+        *basePtr = fillValue;
+        baseImageModified = true;
+        }
+      }
+    }
+  return baseImageModified;
+}
+
+#ifdef VTK_SEGMENTATION_CORE_USE_SSE2
+//----------------------------------------------------------------------------
+/// Returns true if any bit is set in the vector
+inline bool IsAnyBitSet(__m128i value)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_setzero_si128())) != 0xFFFF;
+}
+
+//----------------------------------------------------------------------------
+/// Vectorized merge of unsigned char rows (most common labelmap scalar type)
+bool MergeRow(unsigned char* basePtr, const unsigned char* modifierPtr, vtkIdType length,
+  int operation, unsigned char maskThreshold, unsigned char fillValue)
+{
+  const vtkIdType vectorLength = 16;
+  vtkIdType vectorizedLength = length - length % vectorLength;
+  // Bits that differ between the original and merged values are accumulated
+  __m128i changedBits = _mm_setzero_si128();
+  if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+    {
+    for (vtkIdType i = 0; i < vectorizedLength; i += vectorLength)
+      {
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(basePtr + i));
+      __m128i result = _mm_max_epu8(base, _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifierPtr + i)));
+      changedBits = _mm_or_si128(changedBits, _mm_xor_si128(base, result));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(basePtr + i), result);
+      }
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
+    {
+    for (vtkIdType i = 0; i < vectorizedLength; i += vectorLength)
+      {
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(basePtr + i));
+      __m128i result = _mm_min_epu8(base, _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifierPtr + i)));
+      changedBits = _mm_or_si128(changedBits, _mm_xor_si128(base, result));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(basePtr + i), result);
+      }
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+    {
+    const __m128i threshold = _mm_set1_epi8(static_cast<char>(maskThreshold));
+    const __m128i fill = _mm_set1_epi8(static_cast<char>(fillValue));
+    const __m128i allBitsSet = _mm_cmpeq_epi8(threshold, threshold);
+    for (vtkIdType i = 0; i < vectorizedLength; i += vectorLength)
+      {
+      __m128i modifier = _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifierPtr + i));
+      // There is no unsigned comparison in SSE2: modifier > threshold if min(modifier, threshold) != modifier
+      __m128i aboveThreshold = _mm_xor_si128(_mm_cmpeq_epi8(_mm_min_epu8(modifier, threshold), modifier), allBitsSet);
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(basePtr + i));
+      __m128i result = _mm_or_si128(_mm_and_si128(aboveThreshold, fill), _mm_andnot_si128(aboveThreshold, base));
+      changedBits = _mm_or_si128(changedBits, aboveThreshold);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(basePtr + i), result);
+      }
+    }
+  bool remainderModified = MergeRow<unsigned char, unsigned char>(basePtr + vectorizedLength, modifierPtr + vectorizedLength,
+    length - vectorizedLength, operation, maskThreshold, fillValue);
+  return IsAnyBitSet(changedBits) || remainderModified;
+}
+
+//----------------------------------------------------------------------------
+/// Vectorized merge of short rows (default scalar type of imported labelmap volumes)
+bool MergeRow(short* basePtr, const short* modifierPtr, vtkIdType length,
+  int operation, short maskThreshold, short fillValue)
+{
+  const vtkIdType vectorLength = 8;
+  vtkIdType vectorizedLength = length - length % vectorLength;
+  __m128i changedBits = _mm_setzero_si128();
+  if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+    {
+    for (vtkIdType i = 0; i < vectorizedLength; i += vectorLength)
+      {
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(basePtr + i));
+      __m128i result = _mm_max_epi16(base, _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifierPtr + i)));
+      changedBits = _mm_or_si128(changedBits, _mm_xor_si128(base, result));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(basePtr + i), result);
+      }
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
+    {
+    for (vtkIdType i = 0; i < vectorizedLength; i += vectorLength)
+      {
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(basePtr + i));
+      __m128i result = _mm_min_epi16(base, _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifierPtr + i)));
+      changedBits = _mm_or_si128(changedBits, _mm_xor_si128(base, result));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(basePtr + i), result);
+      }
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+    {
+    const __m128i threshold = _mm_set1_epi16(maskThreshold);
+    const __m128i fill = _mm_set1_epi16(fillValue);
+    for (vtkIdType i = 0; i < vectorizedLength; i += vectorLength)
+      {
+      __m128i modifier = _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifierPtr + i));
+      __m128i aboveThreshold = _mm_cmpgt_epi16(modifier, threshold);
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(basePtr + i));
+      __m128i result = _mm_or_si128(_mm_and_si128(aboveThreshold, fill), _mm_andnot_si128(aboveThreshold, base));
+      changedBits = _mm_or_si128(changedBits, aboveThreshold);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(basePtr + i), result);
+      }
+    }
+  bool remainderModified = MergeRow<short, short>(basePtr + vectorizedLength, modifierPtr + vectorizedLength,
+    length - vectorizedLength, operation, maskThreshold, fillValue);
+  return IsAnyBitSet(changedBits) || remainderModified;
+}
+#endif
+
+//----------------------------------------------------------------------------
+template <class BaseImageScalarType, class ModifierImageScalarType>
+struct MergeImageThreadData
+{
+  vtkImageData* BaseImage;
+  vtkImageData* ModifierImage;
+  int UpdateExtent[6];
+  int Operation;
+  ModifierImageScalarType MaskThreshold;
+  BaseImageScalarType FillValue;
+  /// Each thread sets its own element if it modified the base image
+  std::vector<char> ThreadModified;
+};
+
+//----------------------------------------------------------------------------
+template <class BaseImageScalarType, class ModifierImageScalarType>
+VTK_THREAD_RETURN_TYPE MergeImageThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  MergeImageThreadData<BaseImageScalarType, ModifierImageScalarType>* data =
+    static_cast< MergeImageThreadData<BaseImageScalarType, ModifierImageScalarType>* >(threadInfo->UserData);
+  int* updateExt = data->UpdateExtent;
+
+  // Each thread processes a slab of consecutive slices
+  int numberOfSlices = updateExt[5] - updateExt[4] + 1;
+  int firstSlice = updateExt[4] + numberOfSlices * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  int lastSlice = updateExt[4] + numberOfSlices * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads - 1;
+
+  vtkIdType rowLength = static_cast<vtkIdType>(updateExt[1] - updateExt[0] + 1) * data->BaseImage->GetNumberOfScalarComponents();
+  vtkIdType baseIncrements[3] = { 0, 0, 0 };
+  data->BaseImage->GetIncrements(baseIncrements);
+  vtkIdType modifierIncrements[3] = { 0, 0, 0 };
+  data->ModifierImage->GetIncrements(modifierIncrements);
+  BaseImageScalarType* baseExtentPtr = static_cast<BaseImageScalarType*>(data->BaseImage->GetScalarPointerForExtent(updateExt));
+  ModifierImageScalarType* modifierExtentPtr = static_cast<ModifierImageScalarType*>(data->ModifierImage->GetScalarPointerForExtent(updateExt));
+
+  bool baseImageModified = false;
+  for (int k = firstSlice; k <= lastSlice; ++k)
+    {
+    for (int j = updateExt[2]; j <= updateExt[3]; ++j)
+      {
+      BaseImageScalarType* basePtr = baseExtentPtr
+        + (k - updateExt[4]) * baseIncrements[2] + (j - updateExt[2]) * baseIncrements[1];
+      const ModifierImageScalarType* modifierPtr = modifierExtentPtr
+        + (k - updateExt[4]) * modifierIncrements[2] + (j - updateExt[2]) * modifierIncrements[1];
+      if (MergeRow(basePtr, modifierPtr, rowLength, data->Operation, data->MaskThreshold, data->FillValue))
+        {
+        baseImageModified = true;
+        }
+      }
+    }
+  data->ThreadModified[threadInfo->ThreadID] = baseImageModified;
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
 template <class BaseImageScalarType, class ModifierImageScalarType>
@@ -85,18 +481,6 @@ void MergeImageGeneric2(
     return;
     }
 
-  // Get increments to march through data
-  vtkIdType baseIncX = 0;
-  vtkIdType baseIncY = 0;
-  vtkIdType baseIncZ = 0;
-  vtkIdType modifierIncX = 0;
-  vtkIdType modifierIncY = 0;
-  vtkIdType modifierIncZ = 0;
-  baseImage->GetContinuousIncrements(updateExt, baseIncX, baseIncY, baseIncZ);
-  modifierImage->GetContinuousIncrements(updateExt, modifierIncX, modifierIncY, modifierIncZ);
-  int maxX = (updateExt[1] - updateExt[0]) * baseImage->GetNumberOfScalarComponents();
-  int maxY = updateExt[3] - updateExt[2];
-  int maxZ = updateExt[5] - updateExt[4];
   BaseImageScalarType* baseImagePtr = static_cast<BaseImageScalarType*>(baseImage->GetScalarPointerForExtent(updateExt));
   ModifierImageScalarType* modifierImagePtr = static_cast<ModifierImageScalarType*>(modifierImage->GetScalarPointerForExtent(updateExt));
 
@@ -111,115 +495,57 @@ void MergeImageGeneric2(
     return;
     }
 
-  bool baseImageModified = false;
+  MergeImageThreadData<BaseImageScalarType, ModifierImageScalarType> data;
+  data.BaseImage = baseImage;
+  data.ModifierImage = modifierImage;
+  std::copy(updateExt, updateExt + 6, data.UpdateExtent);
+  data.Operation = operation;
 
-  // Loop through output pixels
-  // There is difference in only one line between min/max computation but the comparison
-  // is performed for each pixel, so it is faster to make the conditional expression in the outer loop.
-  // Looping is performed in two step: first we just check if any of the pixels have to be changed,
-  // if we find any, then we set baseImageModified flag and to the second loop without need to set
-  // baseImageModified flag again (setting a flag in a hot loop may impact speed).
-  if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+  // Make sure the fill value is valid for the base image scalar range
+  if (fillValue < baseImage->GetScalarTypeMin())
     {
-    for (vtkIdType idxZ = 0; idxZ <= maxZ; idxZ++)
-      {
-      for (vtkIdType idxY = 0; idxY <= maxY; idxY++)
-        {
-        for (vtkIdType idxX = 0; idxX <= maxX; idxX++)
-          {
-          if (static_cast<BaseImageScalarType>(*modifierImagePtr) > *baseImagePtr)
-            {
-            *baseImagePtr = *modifierImagePtr;
-            baseImageModified = true;
-            }
-          baseImagePtr++;
-          modifierImagePtr++;
-          }
-        baseImagePtr += baseIncY;
-        modifierImagePtr += modifierIncY;
-        }
-      baseImagePtr += baseIncZ;
-      modifierImagePtr += modifierIncZ;
-      }
+    data.FillValue = static_cast<BaseImageScalarType>(baseImage->GetScalarTypeMin());
     }
-  else if (operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
+  else if (fillValue > baseImage->GetScalarTypeMax())
     {
-    for (vtkIdType idxZ = 0; idxZ <= maxZ; idxZ++)
-      {
-      for (vtkIdType idxY = 0; idxY <= maxY; idxY++)
-        {
-        for (vtkIdType idxX = 0; idxX <= maxX; idxX++)
-          {
-          if (static_cast<BaseImageScalarType>(*modifierImagePtr) < *baseImagePtr)
-            {
-            *baseImagePtr = *modifierImagePtr;
-            baseImageModified = true;
-            }
-          baseImagePtr++;
-          modifierImagePtr++;
-          }
-        baseImagePtr += baseIncY;
-        modifierImagePtr += modifierIncY;
-        }
-      baseImagePtr += baseIncZ;
-      modifierImagePtr += modifierIncZ;
-      }
+    data.FillValue = static_cast<BaseImageScalarType>(baseImage->GetScalarTypeMax());
     }
-  else if (operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+  else
     {
+    data.FillValue = static_cast<BaseImageScalarType>(fillValue);
+    }
 
-    // Make sure the fill value is valid for the base image scalar range
-    BaseImageScalarType fillValueBaseImageType = 0;
-    if (fillValue < baseImage->GetScalarTypeMin())
-      {
-      fillValueBaseImageType = static_cast<BaseImageScalarType>(baseImage->GetScalarTypeMin());
-      }
-    else if (fillValue > baseImage->GetScalarTypeMax())
-      {
-      fillValueBaseImageType = static_cast<BaseImageScalarType>(baseImage->GetScalarTypeMax());
-      }
-    else
-      {
-      fillValueBaseImageType = static_cast<BaseImageScalarType>(fillValue);
-      }
-
-    // Make sure the threshold is valid for the modifier scalar range
-    ModifierImageScalarType maskThresholdModifierType = 0;
-    if (maskThreshold < modifierImage->GetScalarTypeMin())
-      {
-      maskThresholdModifierType = static_cast<ModifierImageScalarType>(modifierImage->GetScalarTypeMin());
-      }
-    else if (maskThreshold > modifierImage->GetScalarTypeMax())
-      {
-      maskThresholdModifierType = static_cast<ModifierImageScalarType>(modifierImage->GetScalarTypeMax());
-      }
-    else
-      {
-      maskThresholdModifierType = static_cast<ModifierImageScalarType>(maskThreshold);
-      }
+  // Make sure the threshold is valid for the modifier scalar range
+  if (maskThreshold < modifierImage->GetScalarTypeMin())
+    {
+    data.MaskThreshold = static_cast<ModifierImageScalarType>(modifierImage->GetScalarTypeMin());
+    }
+  else if (maskThreshold > modifierImage->GetScalarTypeMax())
+    {
+    data.MaskThreshold = static_cast<ModifierImageScalarType>(modifierImage->GetScalarTypeMax());
+    }
+  else
+    {
+    data.MaskThreshold = static_cast<ModifierImageScalarType>(maskThreshold);
+    }
 
-    for (vtkIdType idxZ = 0; idxZ <= maxZ; idxZ++)
-      {
-      for (vtkIdType idxY = 0; idxY <= maxY; idxY++)
-        {
-        for (vtkIdType idxX = 0; idxX <= maxX; idxX++)
-          {
-          if ((*modifierImagePtr) > maskThresholdModifierType)
-            {
-            *baseImagePtr = fillValueBaseImageType;
-            baseImageModified = true;
-            }
-          baseImagePtr++;
-          modifierImagePtr++;
-        }
-        baseImagePtr += baseIncY;
-        modifierImagePtr += modifierIncY;
-        }
-      baseImagePtr += baseIncZ;
-      modifierImagePtr += modifierIncZ;
-      }
+  // Rows are merged by MergeRow (vectorized for the common label scalar types),
+  // large regions are split into slabs that are processed in parallel.
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = 1;
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(updateExt[1] - updateExt[0] + 1)
+    * (updateExt[3] - updateExt[2] + 1) * (updateExt[5] - updateExt[4] + 1);
+  if (numberOfVoxels >= MINIMUM_NUMBER_OF_VOXELS_FOR_THREADING)
+    {
+    numberOfThreads = std::min(threader->GetNumberOfThreads(), updateExt[5] - updateExt[4] + 1);
     }
-  if (baseImageModified)
+  numberOfThreads = std::max(numberOfThreads, 1);
+  data.ThreadModified.resize(numberOfThreads, 0);
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(MergeImageThreadFunction<BaseImageScalarType, ModifierImageScalarType>, &data);
+  threader->SingleMethodExecute();
+
+  if (std::find(data.ThreadModified.begin(), data.ThreadModified.end(), 1) != data.ThreadModified.end())
     {
     baseImage->Modified();
     }
@@ -373,6 +699,61 @@ bool vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage
     return false;
     }
 
+  int resliceExtent[6] = { unionExtent[0], unionExtent[1], unionExtent[2], unionExtent[3], unionExtent[4], unionExtent[5] };
+  vtkNew<vtkTransform> inputImageToReferenceImageLinearTransform;
+  if (inputImage->GetPointData()->GetScalars()
+    && vtkOrientedImageDataResample::IsTransformLinear(inputImageToReferenceImageTransform.GetPointer(),
+    inputImageToReferenceImageLinearTransform.GetPointer()))
+    {
+    // If input voxels are mapped exactly onto reference voxels then interpolation is not needed
+    int permutation[3] = { 0, 1, 2 };
+    int signs[3] = { 1, 1, 1 };
+    int offsets[3] = { 0, 0, 0 };
+    if (GetVoxelPermutation(inputImageToReferenceImageLinearTransform->GetMatrix(), permutation, signs, offsets))
+      {
+      vtkNew<vtkImageData> permutedImage;
+      CopyPermutedVoxels(inputImage, permutedImage.GetPointer(), unionExtent, permutation, signs, offsets, backgroundValue);
+      outputImage->ShallowCopy(permutedImage.GetPointer());
+      outputImage->SetGeometryFromImageToWorldMatrix(referenceImageToWorldMatrix.GetPointer());
+      return true;
+      }
+
+    // Output voxels that no foreground input voxel is mapped to are zero, so they do not need to be resampled
+    if (backgroundValue == 0.0 && inputImage->GetNumberOfScalarComponents() == 1
+      && (inputImage->GetScalarTypeMin() >= 0.0 || inputImage->GetScalarRange()[0] >= 0.0))
+      {
+      int effectiveInputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      bool emptyResliceExtent = !vtkOrientedImageDataResample::CalculateEffectiveExtent(inputImage, effectiveInputExtent);
+      if (!emptyResliceExtent)
+        {
+        int effectiveExtentInReferenceFrame[6] = { 0, -1, 0, -1, 0, -1 };
+        vtkOrientedImageDataResample::TransformExtent(effectiveInputExtent,
+          inputImageToReferenceImageLinearTransform.GetPointer(), effectiveExtentInReferenceFrame);
+        vtkMatrix4x4* inputToReferenceIjkMatrix = inputImageToReferenceImageLinearTransform->GetMatrix();
+        for (int i = 0; i < 3; i++)
+          {
+          // Margin for interpolation: interpolated values may be non-zero up to one input voxel
+          // away from the effective extent, which is more than one reference voxel if the input
+          // voxels are larger than the reference voxels (one more voxel is added for rounding).
+          double inputVoxelSizeInReferenceVoxels = fabs(inputToReferenceIjkMatrix->GetElement(i, 0))
+            + fabs(inputToReferenceIjkMatrix->GetElement(i, 1)) + fabs(inputToReferenceIjkMatrix->GetElement(i, 2));
+          int margin = static_cast<int>(ceil(inputVoxelSizeInReferenceVoxels)) + 1;
+          resliceExtent[i * 2] = std::max(unionExtent[i * 2], effectiveExtentInReferenceFrame[i * 2] - margin);
+          resliceExtent[i * 2 + 1] = std::min(unionExtent[i * 2 + 1], effectiveExtentInReferenceFrame[i * 2 + 1] + margin);
+          emptyResliceExtent = emptyResliceExtent || (resliceExtent[i * 2] > resliceExtent[i * 2 + 1]);
+          }
+        }
+      if (emptyResliceExtent)
+        {
+        vtkNew<vtkImageData> emptyImage;
+        AllocateFilledImage(emptyImage.GetPointer(), unionExtent, inputImage, backgroundValue);
+        outputImage->ShallowCopy(emptyImage.GetPointer());
+        outputImage->SetGeometryFromImageToWorldMatrix(referenceImageToWorldMatrix.GetPointer());
+        return true;
+        }
+      }
+    }
+
   // Invert transform for the resampling
   vtkAbstractTransform* referenceImageToInputImageTransform = inputImageToReferenceImageTransform->GetInverse();
   referenceImageToInputImageTransform->Update();
@@ -390,7 +771,7 @@ bool vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage
   resliceFilter->SetInputData(identityInputImage);
   resliceFilter->SetOutputOrigin(0, 0, 0);
   resliceFilter->SetOutputSpacing(1, 1, 1);
-  resliceFilter->SetOutputExtent(unionExtent);
+  resliceFilter->SetOutputExtent(resliceExtent);
   resliceFilter->SetOutputScalarType(inputImage->GetScalarType());
   resliceFilter->SetBackgroundLevel(backgroundValue);
   resliceFilter->SetResliceTransform(referenceImageToInputImageTransform);
@@ -407,7 +788,22 @@ bool vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage
   resliceFilter->Update();
 
   // Set output
-  outputImage->ShallowCopy(resliceFilter->GetOutput());
+  bool resliceExtentIsUnionExtent = true;
+  for (int i = 0; i < 6; ++i)
+    {
+    resliceExtentIsUnionExtent = resliceExtentIsUnionExtent && (resliceExtent[i] == unionExtent[i]);
+    }
+  if (resliceExtentIsUnionExtent)
+    {
+    outputImage->ShallowCopy(resliceFilter->GetOutput());
+    }
+  else
+    {
+    vtkNew<vtkImageData> paddedImage;
+    AllocateFilledImage(paddedImage.GetPointer(), unionExtent, resliceFilter->GetOutput(), backgroundValue);
+    CopyImageRegion(resliceFilter->GetOutput(), paddedImage.GetPointer(), resliceExtent);
+    outputImage->ShallowCopy(paddedImage.GetPointer());
+    }
   outputImage->SetGeometryFromImageToWorldMatrix(referenceImageToWorldMatrix.GetPointer());
 
   return true;
@@ -1322,3 +1718,239 @@ void vtkOrientedImageDataResample::FillImage(vtkImageData* image, double fillVal
     vtkGenericWarningMacro("vtkOrientedImageDataResample::FillImage: Unknown ScalarType");
     }
 }
+
+//----------------------------------------------------------------------------
+namespace
+{
+/// Horizontal run of voxels [Start, End] in row (Row, Slice)
+struct PaintSpan
+{
+  int Start;
+  int End;
+  int Row;
+  int Slice;
+};
+
+//----------------------------------------------------------------------------
+bool ComparePaintSpanStart(const PaintSpan& span1, const PaintSpan& span2)
+{
+  return span1.Start < span2.Start;
+}
+
+//----------------------------------------------------------------------------
+/// Merge overlapping spans of each row and write fillValue into the covered voxels
+template <typename T> void PaintSpansGeneric(vtkImageData* image, std::vector< std::vector<PaintSpan> >& rowSpans,
+  const int paintExtent[6], T fillValue)
+{
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  int numberOfRows = paintExtent[3] - paintExtent[2] + 1;
+  for (std::vector< std::vector<PaintSpan> >::iterator rowIt = rowSpans.begin(); rowIt != rowSpans.end(); ++rowIt)
+    {
+    std::vector<PaintSpan>& spans = *rowIt;
+    if (spans.empty())
+      {
+      continue;
+      }
+    int rowIndex = static_cast<int>(rowIt - rowSpans.begin());
+    int j = paintExtent[2] + rowIndex % numberOfRows;
+    int k = paintExtent[4] + rowIndex / numberOfRows;
+    std::sort(spans.begin(), spans.end(), ComparePaintSpanStart);
+    std::vector<PaintSpan>::iterator spanIt = spans.begin();
+    while (spanIt != spans.end())
+      {
+      int start = spanIt->Start;
+      int end = spanIt->End;
+      for (++spanIt; spanIt != spans.end() && spanIt->Start <= end + 1; ++spanIt)
+        {
+        end = std::max(end, spanIt->End);
+        }
+      T* voxelPtr = static_cast<T*>(image->GetScalarPointer(start, j, k));
+      for (int i = start; i <= end; ++i, voxelPtr += numberOfComponents)
+        {
+        if (*voxelPtr < fillValue)
+          {
+          *voxelPtr = fillValue;
+          }
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool vtkOrientedImageDataResample::PaintStroke(vtkImageData* image, vtkImageStencilData* brushStencil,
+  vtkPoints* strokePoints_Ijk, double fillValue, int updateExtent[6]/*=NULL*/)
+{
+  int paintExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (updateExtent)
+    {
+    std::copy(paintExtent, paintExtent + 6, updateExtent);
+    }
+  if (!image || !strokePoints_Ijk || strokePoints_Ijk->GetNumberOfPoints() == 0)
+    {
+    return false;
+    }
+  if (image->GetPointData() == NULL || image->GetPointData()->GetScalars() == NULL)
+    {
+    return false;
+    }
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(imageExtent);
+  if (imageExtent[0] > imageExtent[1] || imageExtent[2] > imageExtent[3] || imageExtent[4] > imageExtent[5])
+    {
+    return false;
+    }
+
+  // Decompose brush shape into horizontal spans, relative to the brush center
+  std::vector<PaintSpan> brushSpans;
+  int brushExtent[6] = { 0, 0, 0, 0, 0, 0 };
+  if (brushStencil)
+    {
+    brushStencil->GetExtent(brushExtent);
+    for (int k = brushExtent[4]; k <= brushExtent[5]; ++k)
+      {
+      for (int j = brushExtent[2]; j <= brushExtent[3]; ++j)
+        {
+        int iter = 0;
+        PaintSpan span;
+        span.Row = j;
+        span.Slice = k;
+        while (brushStencil->GetNextExtent(span.Start, span.End, brushExtent[0], brushExtent[1], j, k, iter))
+          {
+          brushSpans.push_back(span);
+          }
+        }
+      }
+    }
+  else
+    {
+    PaintSpan span = { 0, 0, 0, 0 };
+    brushSpans.push_back(span);
+    }
+  if (brushSpans.empty())
+    {
+    return false;
+    }
+
+  // Sweep brush center along the stroke in steps of at most one voxel.
+  // Positions where the brush does not overlap with the image are skipped.
+  std::vector<int> brushPositions;
+  int previousPosition[3] = { 0, 0, 0 };
+  int lastPosition[3] = { 0, 0, 0 };
+  bool lastPositionValid = false;
+  vtkIdType numberOfPoints = strokePoints_Ijk->GetNumberOfPoints();
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+    double* point = strokePoints_Ijk->GetPoint(pointIndex);
+    int position[3] = { 0, 0, 0 };
+    for (int i = 0; i < 3; ++i)
+      {
+      position[i] = static_cast<int>(floor(point[i] + 0.5));
+      }
+    int numberOfSteps = 0;
+    if (pointIndex > 0)
+      {
+      for (int i = 0; i < 3; ++i)
+        {
+        numberOfSteps = std::max(numberOfSteps, abs(position[i] - previousPosition[i]));
+        }
+      }
+    for (int step = (pointIndex > 0 ? 1 : 0); step <= numberOfSteps; ++step)
+      {
+      int stepPosition[3] = { position[0], position[1], position[2] };
+      if (step < numberOfSteps)
+        {
+        for (int i = 0; i < 3; ++i)
+          {
+          stepPosition[i] = previousPosition[i] + static_cast<int>(
+            floor(double(position[i] - previousPosition[i]) * step / numberOfSteps + 0.5));
+          }
+        }
+      if (lastPositionValid && stepPosition[0] == lastPosition[0]
+        && stepPosition[1] == lastPosition[1] && stepPosition[2] == lastPosition[2])
+        {
+        continue;
+        }
+      std::copy(stepPosition, stepPosition + 3, lastPosition);
+      lastPositionValid = true;
+      bool overlapsImage = true;
+      for (int i = 0; i < 3; ++i)
+        {
+        if (stepPosition[i] + brushExtent[i * 2] > imageExtent[i * 2 + 1]
+          || stepPosition[i] + brushExtent[i * 2 + 1] < imageExtent[i * 2])
+          {
+          overlapsImage = false;
+          }
+        }
+      if (!overlapsImage)
+        {
+        continue;
+        }
+      brushPositions.insert(brushPositions.end(), stepPosition, stepPosition + 3);
+      for (int i = 0; i < 3; ++i)
+        {
+        int brushMin = std::max(stepPosition[i] + brushExtent[i * 2], imageExtent[i * 2]);
+        int brushMax = std::min(stepPosition[i] + brushExtent[i * 2 + 1], imageExtent[i * 2 + 1]);
+        if (brushPositions.size() == 3)
+          {
+          paintExtent[i * 2] = brushMin;
+          paintExtent[i * 2 + 1] = brushMax;
+          }
+        else
+          {
+          paintExtent[i * 2] = std::min(paintExtent[i * 2], brushMin);
+          paintExtent[i * 2 + 1] = std::max(paintExtent[i * 2 + 1], brushMax);
+          }
+        }
+      }
+    std::copy(position, position + 3, previousPosition);
+    }
+  if (brushPositions.empty())
+    {
+    return false;
+    }
+
+  // Collect spans of all brush positions for each row of the painted region
+  int numberOfRows = paintExtent[3] - paintExtent[2] + 1;
+  int numberOfSlices = paintExtent[5] - paintExtent[4] + 1;
+  std::vector< std::vector<PaintSpan> > rowSpans(numberOfRows * numberOfSlices);
+  for (std::vector<int>::iterator positionIt = brushPositions.begin(); positionIt != brushPositions.end(); positionIt += 3)
+    {
+    int* position = &(*positionIt);
+    for (std::vector<PaintSpan>::iterator brushSpanIt = brushSpans.begin(); brushSpanIt != brushSpans.end(); ++brushSpanIt)
+      {
+      int j = brushSpanIt->Row + position[1];
+      int k = brushSpanIt->Slice + position[2];
+      if (j < paintExtent[2] || j > paintExtent[3] || k < paintExtent[4] || k > paintExtent[5])
+        {
+        continue;
+        }
+      PaintSpan span;
+      span.Start = std::max(brushSpanIt->Start + position[0], paintExtent[0]);
+      span.End = std::min(brushSpanIt->End + position[0], paintExtent[1]);
+      if (span.Start > span.End)
+        {
+        continue;
+        }
+      span.Row = j;
+      span.Slice = k;
+      rowSpans[(k - paintExtent[4]) * numberOfRows + (j - paintExtent[2])].push_back(span);
+      }
+    }
+
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(PaintSpansGeneric<VTK_TT>(image, rowSpans, paintExtent, static_cast<VTK_TT>(fillValue)));
+  default:
+    vtkGenericWarningMacro("vtkOrientedImageDataResample::PaintStroke: Unknown ScalarType");
+    return false;
+    }
+  image->Modified();
+
+  if (updateExtent)
+    {
+    std::copy(paintExtent, paintExtent + 6, updateExtent);
+    }
+  return true;
+}
@@ -27,8 +27,10 @@
 #include "vtkObject.h"
 
 class vtkImageData;
+class vtkImageStencilData;
 class vtkMatrix4x4;
 class vtkOrientedImageData;
+class vtkPoints;
 class vtkTransform;
 class vtkAbstractTransform;
 
@@ -65,6 +67,9 @@ public:
   ///          to be outside the reference extent, then it is padded. Disabled by default.
   /// \param inputImageTransform If specified then inputImage will be transformed with inputImageTransform before resampled into referenceImage.
   /// \return Success flag
+  /// If input voxels map exactly to reference voxels (the geometries only differ in whole voxel shifts, axis permutations
+  /// and flips) then voxels are copied without interpolation. Otherwise, if the transform is linear, only the region
+  /// where non-zero input voxels are mapped to is resampled.
   static bool ResampleOrientedImageToReferenceOrientedImage(vtkOrientedImageData* inputImage, vtkOrientedImageData* referenceImage, vtkOrientedImageData* outputImage, bool linearInterpolation=false, bool padImage=false, vtkAbstractTransform* inputImageTransform=NULL, double backgroundValue=0);
 
   /// Transform an oriented image data using a transform that can be linear or non-linear.
@@ -87,6 +92,7 @@ public:
   /// The extent will remain unchanged.
   /// Extent can be specified to restrict modifierImage's extent to a smaller region.
   /// inputImage and modifierImage must have the same geometry (origin, spacing, directions) and scalar type, but they may have different extents.
+  /// Unsigned char and short images are merged using vectorized operations and large regions are processed in parallel.
   static bool ModifyImage(vtkOrientedImageData* inputImage, vtkOrientedImageData* modifierImage, int operation,
     const int extent[6] = 0, double maskThreshold = 0, double fillValue = 1);
 
@@ -100,6 +106,20 @@ public:
   /// \param extent The whole extent is filled if extent is not specified
   static void FillImage(vtkImageData* image, double fillValue, const int extent[6]=NULL);
 
+  /// Paint a brush shape into an image along a stroke, in a single pass.
+  /// The brush is swept between consecutive stroke points in steps of at most one voxel,
+  /// so the painted region is continuous even if the stroke points are far apart.
+  /// Each voxel covered by the swept brush is set to the maximum of its current value and fillValue,
+  /// and each voxel is written only once, regardless of how many brush positions cover it.
+  /// \param image Image to paint into. Voxels outside its extent are ignored.
+  /// \param brushStencil Brush shape in IJK coordinates, relative to the brush center.
+  ///   If NULL then a single voxel is painted at each position.
+  /// \param strokePoints_Ijk Stroke points in the IJK coordinate system of the image
+  /// \param updateExtent If not NULL, it is set to the extent of the painted region (empty extent if nothing was painted)
+  /// \return True if any voxel was painted
+  static bool PaintStroke(vtkImageData* image, vtkImageStencilData* brushStencil, vtkPoints* strokePoints_Ijk,
+    double fillValue, int updateExtent[6]=NULL);
+
 public:
   /// Calculate effective extent of an image: the IJK extent where non-zero voxels are located
   static bool CalculateEffectiveExtent(vtkOrientedImageData* image, int effectiveExtent[6], double threshold = 0.0);
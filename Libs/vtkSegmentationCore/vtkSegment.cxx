@@ -21,6 +21,7 @@
 // SegmentationCore includes
 #include "vtkSegment.h"
 
+#include "vtkSegmentation.h"
 #include "vtkSegmentationConverterFactory.h"
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
@@ -189,6 +190,18 @@ void vtkSegment::DeepCopy(vtkSegment* source)
     representationNamesToKeep.insert(reprIt->first);
     }
 
+  // Binary labelmap stored in a shared labelmap layer is copied without moving it out of the layer
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  if (source->SharedLabelmapSegmentation && !source->GetStoredRepresentation(binaryLabelmapName))
+    {
+    vtkSmartPointer<vtkOrientedImageData> labelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (source->SharedLabelmapSegmentation->GetSharedLabelmap(source, labelmapCopy))
+      {
+      this->AddRepresentation(binaryLabelmapName, labelmapCopy);
+      representationNamesToKeep.insert(binaryLabelmapName);
+      }
+    }
+
   // Remove representations that are not in the source segment
   for (reprIt = this->Representations.begin(); reprIt != this->Representations.end();
     /*upon deletion the increment is done already, so don't increment here*/)
@@ -239,11 +252,36 @@ void vtkSegment::GetBounds(double bounds[6])
       boundingBox.AddBounds(representationBounds);
       }
     }
+
+  // Binary labelmap stored in a shared labelmap layer
+  vtkNew<vtkOrientedImageData> sharedLabelmapGeometry;
+  if (this->SharedLabelmapSegmentation
+    && !this->GetStoredRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    && this->SharedLabelmapSegmentation->GetSharedLabelmapGeometry(this, sharedLabelmapGeometry.GetPointer())
+    && !sharedLabelmapGeometry->IsEmpty())
+    {
+    double representationBounds[6] = { 1, -1, 1, -1, 1, -1 };
+    sharedLabelmapGeometry->GetBounds(representationBounds);
+    boundingBox.AddBounds(representationBounds);
+    }
   boundingBox.GetBounds(bounds);
 }
 
 //---------------------------------------------------------------------------
 vtkDataObject* vtkSegment::GetRepresentation(std::string name)
+{
+  vtkDataObject* representation = this->GetStoredRepresentation(name);
+  if (!representation && this->SharedLabelmapSegmentation
+    && name == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    // Binary labelmap is stored in a shared labelmap layer of the segmentation, extract it on demand
+    representation = this->SharedLabelmapSegmentation->ExtractSharedLabelmapToSegment(this);
+    }
+  return representation;
+}
+
+//---------------------------------------------------------------------------
+vtkDataObject* vtkSegment::GetStoredRepresentation(const std::string& name)
 {
   // Use find function instead of operator[] not to create empty representation if it is missing
   RepresentationMap::iterator reprIt = this->Representations.find(name);
@@ -260,7 +298,7 @@ vtkDataObject* vtkSegment::GetRepresentation(std::string name)
 //---------------------------------------------------------------------------
 void vtkSegment::AddRepresentation(std::string name, vtkDataObject* representation)
 {
-  if (this->GetRepresentation(name) == representation)
+  if (this->GetStoredRepresentation(name) == representation)
     {
     return;
     }
@@ -272,10 +310,19 @@ void vtkSegment::AddRepresentation(std::string name, vtkDataObject* representati
 //---------------------------------------------------------------------------
 void vtkSegment::RemoveRepresentation(std::string name)
 {
-  vtkDataObject* representation = this->GetRepresentation(name);
+  vtkDataObject* representation = this->GetStoredRepresentation(name);
+  bool shared = (this->SharedLabelmapSegmentation
+    && name == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  if (shared)
+    {
+    this->SharedLabelmapSegmentation->RemoveSegmentFromLabelmapLayers(this);
+    }
   if (representation)
     {
     this->Representations.erase(name);
+    }
+  if (representation || shared)
+    {
     this->Modified();
     }
 }
@@ -284,6 +331,12 @@ void vtkSegment::RemoveRepresentation(std::string name)
 void vtkSegment::RemoveAllRepresentations(std::string exceptionRepresentationName/*=""*/)
 {
   bool modified = false;
+  if (this->SharedLabelmapSegmentation
+    && exceptionRepresentationName != vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    this->SharedLabelmapSegmentation->RemoveSegmentFromLabelmapLayers(this);
+    modified = true;
+    }
   RepresentationMap::iterator reprIt = this->Representations.begin();
   while (reprIt != this->Representations.end())
     {
@@ -314,6 +367,12 @@ void vtkSegment::GetContainedRepresentationNames(std::vector<std::string>& repre
     {
     representationNames.push_back(reprIt->first);
     }
+
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  if (this->SharedLabelmapSegmentation && !this->GetStoredRepresentation(binaryLabelmapName))
+    {
+    representationNames.push_back(binaryLabelmapName);
+    }
 }
 
 //---------------------------------------------------------------------------
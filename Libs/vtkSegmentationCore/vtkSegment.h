@@ -25,6 +25,7 @@
 #include <vtkObject.h>
 #include <vtkSmartPointer.h>
 #include <vtkDataObject.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
 #include <vector>
@@ -33,6 +34,8 @@
 // Segmentation includes
 #include "vtkSegmentationCoreConfigure.h"
 
+class vtkSegmentation;
+
 /// \ingroup SegmentationCore
 /// \brief This class encapsulates a segment that is part of a segmentation
 /// \details
@@ -44,9 +47,9 @@
 ///   
 class vtkSegmentationCore_EXPORT vtkSegment : public vtkObject
 {
+public:
   typedef std::map<std::string, vtkSmartPointer<vtkDataObject> > RepresentationMap;
 
-public:
   static const double SEGMENT_COLOR_INVALID[3];
 
   static const char* GetTerminologyEntryTagName();
@@ -72,6 +75,9 @@ public:
   virtual void GetBounds(double bounds[6]);
 
   /// Get representation of a given type. This class is not responsible for conversion, only storage!
+  /// If the binary labelmap of the segment is stored in a shared labelmap layer of its segmentation
+  /// (see vtkSegmentation::SetSharedLabelmapLayers) then it is extracted into the segment on first access.
+  /// Use vtkSegmentation::GetSegmentBinaryLabelmap for read-only access that keeps the layers intact.
   /// \param name Representation name. Default representation names can be queried from \sa vtkSegmentationConverter,
   ///   for example by calling vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()
   /// \return The specified representation object, NULL if not present
@@ -106,7 +112,8 @@ public:
   /// Get tags
   void GetTags(std::map<std::string,std::string> &tags);
 
-  /// Get representation names present in this segment in an output string vector
+  /// Get representation names present in this segment in an output string vector.
+  /// Includes binary labelmap if it is stored in a shared labelmap layer of the segmentation.
   void GetContainedRepresentationNames(std::vector<std::string>& representationNames);
 
 public:
@@ -129,6 +136,10 @@ protected:
   ~vtkSegment();
   void operator=(const vtkSegment&);
 
+  /// Get representation that is stored in this segment, without extracting binary labelmap
+  /// from the shared labelmap layers
+  vtkDataObject* GetStoredRepresentation(const std::string& name);
+
 protected:
   /// Stored representations. Map from type string to data object
   RepresentationMap Representations;
@@ -149,6 +160,12 @@ protected:
   bool NameAutoGenerated;
   /// Flag indicating whether color was automatically generated. False after user manually overrides. True by default
   bool ColorAutoGenerated;
+
+  /// Segmentation that stores the binary labelmap of this segment in a shared labelmap layer.
+  /// NULL if the binary labelmap is not stored in a shared labelmap layer.
+  vtkWeakPointer<vtkSegmentation> SharedLabelmapSegmentation;
+
+  friend class vtkSegmentation;
 };
 
 #endif // __vtkSegment_h
@@ -38,14 +38,18 @@
 #include <vtkStringArray.h>
 #include <vtkAbstractTransform.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkTransform.h>
 #include <vtkPolyData.h>
+#include <vtkSimpleMutexLock.h>
 #include <vtkTransformPolyDataFilter.h>
 
 // STD includes
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <set>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentation);
@@ -61,6 +65,313 @@ public:
     }
 };
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]);
+}
+
+//----------------------------------------------------------------------------
+/// Create a binary labelmap (0/1 unsigned char) of the voxels that have the given value in
+/// a shared labelmap layer. Only the given extent of the layer is processed, which is also
+/// the extent of the output.
+void ExtractLabelFromLayer(vtkOrientedImageData* layer, int labelValue, const int extent[6], vtkOrientedImageData* binaryLabelmap)
+{
+  vtkNew<vtkMatrix4x4> layerImageToWorldMatrix;
+  layer->GetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+  int outputExtent[6] = { extent[0], extent[1], extent[2], extent[3], extent[4], extent[5] };
+  binaryLabelmap->SetExtent(outputExtent);
+  binaryLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  binaryLabelmap->SetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+  if (IsExtentEmpty(outputExtent))
+    {
+    return;
+    }
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      const unsigned char* layerRow = static_cast<unsigned char*>(layer->GetScalarPointer(extent[0], j, k));
+      unsigned char* outputRow = static_cast<unsigned char*>(binaryLabelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = 0; i <= extent[1] - extent[0]; ++i)
+        {
+        outputRow[i] = (layerRow[i] == labelValue ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Set mask voxels to 1 where image voxel value is positive, 0 elsewhere, within the given extent
+template <class T>
+void CreateForegroundMaskGeneric(vtkImageData* image, T*, vtkImageData* mask, const int extent[6])
+{
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      const T* imageRow = static_cast<T*>(image->GetScalarPointer(extent[0], j, k));
+      unsigned char* maskRow = static_cast<unsigned char*>(mask->GetScalarPointer(extent[0], j, k));
+      for (int i = 0; i <= extent[1] - extent[0]; ++i)
+        {
+        maskRow[i] = (imageRow[i] > 0 ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Create an empty (zero-filled) shared labelmap layer
+vtkSmartPointer<vtkOrientedImageData> CreateLabelmapLayer(vtkMatrix4x4* imageToWorldMatrix, const int extent[6])
+{
+  vtkSmartPointer<vtkOrientedImageData> layer = vtkSmartPointer<vtkOrientedImageData>::New();
+  int layerExtent[6] = { extent[0], extent[1], extent[2], extent[3], extent[4], extent[5] };
+  layer->SetExtent(layerExtent);
+  layer->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  layer->SetImageToWorldMatrix(imageToWorldMatrix);
+  if (!IsExtentEmpty(layerExtent))
+    {
+    vtkOrientedImageDataResample::FillImage(layer, 0);
+    }
+  return layer;
+}
+
+//----------------------------------------------------------------------------
+/// Enlarge a shared labelmap layer to the given extent, keeping its content
+void PadLabelmapLayer(vtkOrientedImageData* layer, const int extent[6])
+{
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  layer->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+  vtkSmartPointer<vtkOrientedImageData> paddedLayer = CreateLabelmapLayer(imageToWorldMatrix.GetPointer(), extent);
+  int* oldExtent = layer->GetExtent();
+  if (!IsExtentEmpty(oldExtent))
+    {
+    for (int k = oldExtent[4]; k <= oldExtent[5]; ++k)
+      {
+      for (int j = oldExtent[2]; j <= oldExtent[3]; ++j)
+        {
+        memcpy(paddedLayer->GetScalarPointer(oldExtent[0], j, k), layer->GetScalarPointer(oldExtent[0], j, k),
+          oldExtent[1] - oldExtent[0] + 1);
+        }
+      }
+    }
+  layer->ShallowCopy(paddedLayer);
+}
+
+//----------------------------------------------------------------------------
+/// Determine if any foreground voxel of the mask is already occupied in the layer
+bool IsMaskOverlappingLayer(vtkImageData* mask, vtkImageData* layer, const int extent[6])
+{
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      const unsigned char* maskRow = static_cast<unsigned char*>(mask->GetScalarPointer(extent[0], j, k));
+      const unsigned char* layerRow = static_cast<unsigned char*>(layer->GetScalarPointer(extent[0], j, k));
+      for (int i = 0; i <= extent[1] - extent[0]; ++i)
+        {
+        if (maskRow[i] && layerRow[i])
+          {
+          return true;
+          }
+        }
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+/// Set layer voxels to newValue where the mask is foreground (if mask is specified)
+/// or where the layer contains oldValue (if mask is NULL)
+void SetLabelInLayer(vtkImageData* layer, vtkImageData* mask, int oldValue, int newValue, const int extent[6])
+{
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      const unsigned char* maskRow = (mask ? static_cast<unsigned char*>(mask->GetScalarPointer(extent[0], j, k)) : NULL);
+      unsigned char* layerRow = static_cast<unsigned char*>(layer->GetScalarPointer(extent[0], j, k));
+      for (int i = 0; i <= extent[1] - extent[0]; ++i)
+        {
+        if (maskRow ? maskRow[i] != 0 : layerRow[i] == oldValue)
+          {
+          layerRow[i] = static_cast<unsigned char>(newValue);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Conversion of a single segment. The conversion may run on a worker thread,
+/// therefore created representations are only stored here and added to the
+/// segment later on the calling thread (so that no events are invoked on the worker).
+struct SegmentConversionJob
+{
+  SegmentConversionJob()
+    : Segment(NULL)
+    , SharedLabelmapLayer(NULL)
+    , LabelValue(0)
+    , Success(false)
+    , RepresentationBefore(NULL)
+    , RepresentationMTimeBefore(0)
+    {
+    }
+
+  std::string SegmentId;
+  vtkSegment* Segment;
+
+  /// Location of the binary labelmap in the shared labelmap layers.
+  /// Only set if the segment does not contain its own binary labelmap.
+  vtkOrientedImageData* SharedLabelmapLayer;
+  int LabelValue;
+  int LabelExtent[6];
+  /// Binary labelmap extracted from the shared layer for the duration of the conversion
+  vtkSmartPointer<vtkOrientedImageData> SharedLabelmap;
+
+  /// Invalidated representations of the segment that the conversion can update incrementally
+  vtkSegment::RepresentationMap InvalidatedRepresentations;
+
+  /// Representations created by the conversion steps (representation name, object), in path order
+  std::vector< std::pair<std::string, vtkSmartPointer<vtkDataObject> > > Representations;
+  bool Success;
+  std::string ErrorMessage;
+
+  /// Target representation before the conversion, used for detecting changes
+  vtkDataObject* RepresentationBefore;
+  vtkMTimeType RepresentationMTimeBefore;
+
+  /// Determine if the shared labelmap layer provides the requested representation.
+  /// Must be checked before accessing the segment, as the segment would extract the labelmap otherwise.
+  bool IsSharedLabelmap(const std::string& name)
+    {
+    return this->SharedLabelmapLayer != NULL
+      && name == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+    }
+
+  /// Determine if representation is available for the conversion without extracting it
+  bool HasRepresentation(const std::string& name)
+    {
+    for (size_t i = 0; i < this->Representations.size(); ++i)
+      {
+      if (this->Representations[i].first == name)
+        {
+        return true;
+        }
+      }
+    return this->IsSharedLabelmap(name) || this->Segment->GetRepresentation(name) != NULL;
+    }
+
+  /// Get representation as seen by the conversion: latest converted, the one stored in the segment,
+  /// or binary labelmap extracted from the shared labelmap layer
+  vtkDataObject* GetRepresentation(const std::string& name)
+    {
+    for (int i = static_cast<int>(this->Representations.size()) - 1; i >= 0; --i)
+      {
+      if (this->Representations[i].first == name)
+        {
+        return this->Representations[i].second;
+        }
+      }
+    if (this->IsSharedLabelmap(name))
+      {
+      if (!this->SharedLabelmap)
+        {
+        this->SharedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+        ExtractLabelFromLayer(this->SharedLabelmapLayer, this->LabelValue, this->LabelExtent, this->SharedLabelmap);
+        }
+      return this->SharedLabelmap;
+      }
+    return this->Segment->GetRepresentation(name);
+    }
+};
+
+//----------------------------------------------------------------------------
+void ConvertSegmentConversionJob(SegmentConversionJob& job, const vtkSegmentationConverter::ConversionPathType& path, bool overwriteExisting,
+  vtkSegmentationConverter* converter, const std::string& conversionParameters)
+{
+  vtkSegmentationConverter::ConversionPathType::const_iterator pathIt;
+  for (pathIt = path.begin(); pathIt != path.end(); ++pathIt)
+    {
+    vtkSegmentationConverterRule* currentConversionRule = (*pathIt);
+
+    // Get source representation. It is expected to exist
+    vtkDataObject* sourceRepresentation = job.GetRepresentation(currentConversionRule->GetSourceRepresentationName());
+    if (!sourceRepresentation)
+      {
+      job.ErrorMessage = "Source representation does not exist in segment " + job.SegmentId;
+      job.Success = false;
+      return;
+      }
+
+    // If target representation exists and we do not overwrite existing representations,
+    // then no conversion is necessary with this conversion rule
+    if (job.HasRepresentation(currentConversionRule->GetTargetRepresentationName()) && !overwriteExisting)
+      {
+      continue;
+      }
+
+    // Always convert into a new object, existing representation objects are only updated on the calling thread
+    vtkSmartPointer<vtkDataObject> targetRepresentation = vtkSmartPointer<vtkDataObject>::Take(
+      currentConversionRule->ConstructRepresentationObjectByRepresentation(currentConversionRule->GetTargetRepresentationName()) );
+    vtkSegment::RepresentationMap::iterator invalidatedIt =
+      job.InvalidatedRepresentations.find(currentConversionRule->GetTargetRepresentationName());
+    if (invalidatedIt != job.InvalidatedRepresentations.end() && targetRepresentation.GetPointer())
+      {
+      // Start from the previous result so that the rule only needs to update it
+      targetRepresentation->ShallowCopy(invalidatedIt->second);
+      }
+    converter->Convert(currentConversionRule, sourceRepresentation, targetRepresentation, conversionParameters);
+    job.Representations.push_back(std::make_pair(
+      std::string(currentConversionRule->GetTargetRepresentationName()), targetRepresentation));
+    }
+  // Release extracted labelmap as soon as possible to keep memory usage low
+  job.SharedLabelmap = NULL;
+  job.Success = true;
+}
+
+//----------------------------------------------------------------------------
+struct SegmentConversionThreadData
+{
+  std::vector<SegmentConversionJob>* Jobs;
+  /// Conversion path for each thread. Each thread uses its own clone of the rules.
+  std::vector<vtkSegmentationConverter::ConversionPathType> ThreadPaths;
+  bool OverwriteExisting;
+  vtkSegmentationConverter* Converter;
+  std::string ConversionParameters;
+  vtkSimpleMutexLock* JobLock;
+  size_t NextJobIndex;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ConvertSegmentsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SegmentConversionThreadData* threadData = static_cast<SegmentConversionThreadData*>(threadInfo->UserData);
+  const vtkSegmentationConverter::ConversionPathType& path = threadData->ThreadPaths[threadInfo->ThreadID];
+
+  // Segments may take very different time to convert, so jobs are taken one by one
+  while (true)
+    {
+    threadData->JobLock->Lock();
+    size_t jobIndex = threadData->NextJobIndex++;
+    threadData->JobLock->Unlock();
+    if (jobIndex >= threadData->Jobs->size())
+      {
+      break;
+      }
+    ConvertSegmentConversionJob((*threadData->Jobs)[jobIndex], path, threadData->OverwriteExisting,
+      threadData->Converter, threadData->ConversionParameters);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkSegmentation::vtkSegmentation()
 {
@@ -78,6 +389,8 @@ vtkSegmentation::vtkSegmentation()
 
   this->SegmentIdAutogeneratorIndex = 0;
 
+  this->SharedLabelmapLayers = false;
+
   this->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
 }
 
@@ -108,6 +421,7 @@ vtkSegmentation::~vtkSegmentation()
 void vtkSegmentation::WriteXML(ostream& of, int vtkNotUsed(nIndent))
 {
   of << " MasterRepresentationName=\"" << this->MasterRepresentationName << "\"";
+  of << " SharedLabelmapLayers=\"" << (this->SharedLabelmapLayers ? "true" : "false") << "\"";
 
   // Note: Segment info is not written as it is managed by the storage node instead.
 }
@@ -126,6 +440,10 @@ void vtkSegmentation::ReadXMLAttributes(const char** atts)
       {
       this->SetMasterRepresentationName(attValue);
       }
+    else if (!strcmp(attName, "SharedLabelmapLayers"))
+      {
+      this->SetSharedLabelmapLayers(!strcmp(attValue, "true"));
+      }
     }
 }
 
@@ -145,11 +463,48 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
   // Copy conversion parameters
   this->Converter->DeepCopy(aSegmentation->Converter);
 
+  // Deep copy shared labelmap layers
+  this->SharedLabelmapLayers = aSegmentation->SharedLabelmapLayers;
+  for (std::vector< vtkSmartPointer<vtkOrientedImageData> >::iterator layerIt = aSegmentation->LabelmapLayers.begin();
+    layerIt != aSegmentation->LabelmapLayers.end(); ++layerIt)
+    {
+    vtkSmartPointer<vtkOrientedImageData> layer = vtkSmartPointer<vtkOrientedImageData>::New();
+    layer->DeepCopy(*layerIt);
+    this->LabelmapLayers.push_back(layer);
+    }
+
   // Deep copy segments list
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
   for (std::deque< std::string >::iterator segmentIdIt = aSegmentation->SegmentIds.begin(); segmentIdIt != aSegmentation->SegmentIds.end(); ++segmentIdIt)
     {
+    vtkSegment* sourceSegment = aSegmentation->Segments[*segmentIdIt];
     vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
-    segment->DeepCopy(aSegmentation->Segments[*segmentIdIt]);
+    SharedLabelmapLocationMap::iterator locationIt = aSegmentation->SharedLabelmapLocations.find(sourceSegment);
+    if (locationIt != aSegmentation->SharedLabelmapLocations.end())
+      {
+      // Labelmap in the shared layer is copied with the layers, so the segment copy must not extract it
+      sourceSegment->SharedLabelmapSegmentation = NULL;
+      segment->DeepCopy(sourceSegment);
+      sourceSegment->SharedLabelmapSegmentation = aSegmentation;
+      segment->SharedLabelmapSegmentation = this;
+
+      SharedLabelmapLocation location = locationIt->second;
+      location.ExtractedLabelmap = NULL;
+      location.ExtractedLabelmapMTime = 0;
+      vtkDataObject* sourceLabelmap = sourceSegment->GetStoredRepresentation(binaryLabelmapName);
+      if (sourceLabelmap && sourceLabelmap == locationIt->second.ExtractedLabelmap.GetPointer()
+        && sourceLabelmap->GetMTime() == locationIt->second.ExtractedLabelmapMTime)
+        {
+        // The copied labelmap is an unchanged view of the copied layer
+        location.ExtractedLabelmap = segment->GetStoredRepresentation(binaryLabelmapName);
+        location.ExtractedLabelmapMTime = location.ExtractedLabelmap->GetMTime();
+        }
+      this->SharedLabelmapLocations[segment] = location;
+      }
+    else
+      {
+      segment->DeepCopy(sourceSegment);
+      }
     this->AddSegment(segment);
     }
 }
@@ -171,6 +526,8 @@ void vtkSegmentation::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "MasterRepresentationName:  " << this->MasterRepresentationName << "\n";
   os << indent << "Number of segments:  " << this->Segments.size() << "\n";
+  os << indent << "SharedLabelmapLayers:  " << (this->SharedLabelmapLayers ? "true" : "false") << "\n";
+  os << indent << "Number of labelmap layers:  " << this->LabelmapLayers.size() << "\n";
 
   for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin();
     segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
@@ -200,6 +557,7 @@ void vtkSegmentation::GetBounds(double bounds[6])
     {
     double segmentBounds[6] = { 1, -1, 1, -1, 1, -1 };
 
+    // Segment bounds include binary labelmap stored in a shared labelmap layer
     vtkSegment* segment = it->second;
     segment->GetBounds(segmentBounds);
     boundingBox.AddBounds(segmentBounds);
@@ -244,7 +602,7 @@ bool vtkSegmentation::SetMasterRepresentationModifiedEnabled(bool enabled)
   // Add/remove observation of master representation in all segments
   for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
     {
-    vtkDataObject* masterRepresentation = segmentIt->second->GetRepresentation(this->MasterRepresentationName);
+    vtkDataObject* masterRepresentation = segmentIt->second->GetStoredRepresentation(this->MasterRepresentationName);
     if (masterRepresentation)
       {
       if (enabled)
@@ -358,7 +716,7 @@ bool vtkSegmentation::AddSegment(vtkSegment* segment, std::string segmentId/*=""
     // Perform necessary conversions if needed on the added segment:
     // 1. If the segment can be added, and it does not contain the master representation,
     // then the master representation is converted using the cheapest available path.
-    if (!segment->GetRepresentation(this->MasterRepresentationName))
+    if (!this->IsSegmentRepresentationAvailable(segment, this->MasterRepresentationName))
       {
       // Collect all available paths to master representation
       vtkSegmentationConverter::ConversionPathAndCostListType allPathsToMaster;
@@ -396,7 +754,7 @@ bool vtkSegmentation::AddSegment(vtkSegment* segment, std::string segmentId/*=""
         reprIt != requiredRepresentationNames.end(); ++reprIt)
         {
         // If representation exists then there is nothing to do
-        if (segment->GetRepresentation(*reprIt))
+        if (this->IsSegmentRepresentationAvailable(segment, *reprIt))
           {
           continue;
           }
@@ -419,7 +777,7 @@ bool vtkSegmentation::AddSegment(vtkSegment* segment, std::string segmentId/*=""
       for (std::vector<std::string>::iterator reprIt = containedRepresentationNamesInAddedSegment.begin();
         reprIt != containedRepresentationNamesInAddedSegment.end(); ++reprIt)
         {
-        if (!firstSegment->GetRepresentation(*reprIt))
+        if (!this->IsSegmentRepresentationAvailable(firstSegment, *reprIt))
           {
           segment->RemoveRepresentation(*reprIt);
           }
@@ -451,7 +809,7 @@ bool vtkSegmentation::AddSegment(vtkSegment* segment, std::string segmentId/*=""
     }
 
   // Add observation of master representation in new segment
-  vtkDataObject* masterRepresentation = segment->GetRepresentation(this->MasterRepresentationName);
+  vtkDataObject* masterRepresentation = segment->GetStoredRepresentation(this->MasterRepresentationName);
   if (masterRepresentation && this->MasterRepresentationModifiedEnabled)
     {
     // Observe segment's master representation
@@ -518,11 +876,14 @@ void vtkSegmentation::RemoveSegment(SegmentMap::iterator segmentIt)
   // Remove observation of segment modified event
   segmentIt->second.GetPointer()->RemoveObservers(vtkCommand::ModifiedEvent, this->SegmentCallbackCommand);
   // Remove observation of master representation of removed segment
-  vtkDataObject* masterRepresentation = segmentIt->second->GetRepresentation(this->MasterRepresentationName);
+  vtkDataObject* masterRepresentation = segmentIt->second->GetStoredRepresentation(this->MasterRepresentationName);
   if (masterRepresentation)
     {
     masterRepresentation->RemoveObservers(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
     }
+  // Release voxels of the removed segment in the shared labelmap layers
+  this->RemoveSegmentFromLabelmapLayers(segmentIt->second);
+  this->InvalidatedRepresentations.erase(segmentIt->second);
 
   // Remove segment
   this->SegmentIds.erase(std::remove(this->SegmentIds.begin(), this->SegmentIds.end(), segmentId), this->SegmentIds.end());
@@ -541,6 +902,8 @@ void vtkSegmentation::RemoveSegment(SegmentMap::iterator segmentIt)
 //---------------------------------------------------------------------------
 void vtkSegmentation::RemoveAllSegments()
 {
+  // Layers are removed at once instead of erasing the segments from them one by one
+  this->RemoveAllLabelmapLayers();
   this->SegmentIds.clear();
 
   std::vector<std::string> segmentIds;
@@ -550,6 +913,7 @@ void vtkSegmentation::RemoveAllSegments()
     this->RemoveSegment(*segmentIt);
     }
   this->Segments.clear();
+  this->InvalidatedRepresentations.clear();
 
   this->SegmentIdAutogeneratorIndex = 0;
 }
@@ -839,11 +1203,14 @@ void vtkSegmentation::ApplyLinearTransform(vtkAbstractTransform* transform)
   // Apply transform on reference image geometry conversion parameter (to preserve validity of merged labelmap)
   this->Converter->ApplyTransformOnReferenceImageGeometry(transform);
 
+  // Transform labelmaps stored in shared labelmap layers individually
+  this->ExpandBinaryLabelmaps();
+
   // Apply linear transform for each segment:
   // Harden transform on master representation if poly data, apply directions if oriented image data
   for (SegmentMap::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
     {
-    vtkDataObject* currentMasterRepresentation = it->second->GetRepresentation(this->MasterRepresentationName);
+    vtkDataObject* currentMasterRepresentation = it->second->GetStoredRepresentation(this->MasterRepresentationName);
     if (!currentMasterRepresentation)
       {
       vtkErrorMacro("ApplyLinearTransform: Cannot get master representation (" << this->MasterRepresentationName << ") from segment!");
@@ -871,6 +1238,8 @@ void vtkSegmentation::ApplyLinearTransform(vtkAbstractTransform* transform)
       vtkErrorMacro("ApplyLinearTransform: Representation data type '" << currentMasterRepresentation->GetClassName() << "' not supported!");
       }
     }
+
+  this->CollapseBinaryLabelmaps();
 }
 
 //---------------------------------------------------------------------------
@@ -887,10 +1256,13 @@ void vtkSegmentation::ApplyNonLinearTransform(vtkAbstractTransform* transform)
   // Apply transform on reference image geometry conversion parameter (to preserve validity of merged labelmap)
   this->Converter->ApplyTransformOnReferenceImageGeometry(transform);
 
+  // Transform labelmaps stored in shared labelmap layers individually
+  this->ExpandBinaryLabelmaps();
+
   // Harden transform on master representation (both image data and poly data) for each segment individually
   for (SegmentMap::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
     {
-    vtkDataObject* currentMasterRepresentation = it->second->GetRepresentation(this->MasterRepresentationName);
+    vtkDataObject* currentMasterRepresentation = it->second->GetStoredRepresentation(this->MasterRepresentationName);
     if (!currentMasterRepresentation)
       {
       vtkErrorMacro("ApplyNonLinearTransform: Cannot get master representation (" << this->MasterRepresentationName << ") from segment!");
@@ -918,11 +1290,22 @@ void vtkSegmentation::ApplyNonLinearTransform(vtkAbstractTransform* transform)
       vtkErrorMacro("ApplyLinearTransform: Representation data type '" << currentMasterRepresentation->GetClassName() << "' not supported!");
       }
     }
+
+  this->CollapseBinaryLabelmaps();
 }
 
 //-----------------------------------------------------------------------------
 bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting/*=false*/)
 {
+  // Binary labelmap stored in a shared labelmap layer is only extracted for the duration of the conversion
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  vtkSmartPointer<vtkOrientedImageData> sharedLabelmap;
+  if (!segment->GetStoredRepresentation(binaryLabelmapName) && this->SharedLabelmapLocations.count(segment))
+    {
+    sharedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    this->GetSharedLabelmap(segment, sharedLabelmap);
+    }
+
   // Execute each conversion step in the selected path
   vtkSegmentationConverter::ConversionPathType::iterator pathIt;
   for (pathIt = path.begin(); pathIt != path.end(); ++pathIt)
@@ -935,8 +1318,13 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
       }
 
     // Get source representation from segment. It is expected to exist
-    vtkDataObject* sourceRepresentation = segment->GetRepresentation(
+    vtkDataObject* sourceRepresentation = segment->GetStoredRepresentation(
       currentConversionRule->GetSourceRepresentationName() );
+    if (!sourceRepresentation && sharedLabelmap.GetPointer()
+      && currentConversionRule->GetSourceRepresentationName() == binaryLabelmapName)
+      {
+      sourceRepresentation = sharedLabelmap;
+      }
     if (!sourceRepresentation)
       {
       vtkErrorMacro("ConvertSegmentUsingPath: Source representation does not exist!");
@@ -944,11 +1332,13 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
       }
 
     // Get target representation
-    vtkSmartPointer<vtkDataObject> targetRepresentation = segment->GetRepresentation(
+    vtkSmartPointer<vtkDataObject> targetRepresentation = segment->GetStoredRepresentation(
       currentConversionRule->GetTargetRepresentationName() );
     // If target representation exists and we do not overwrite existing representations,
     // then no conversion is necessary with this conversion rule
-    if (targetRepresentation.GetPointer() && !overwriteExisting)
+    bool targetInSharedLabelmap = (sharedLabelmap.GetPointer()
+      && currentConversionRule->GetTargetRepresentationName() == binaryLabelmapName);
+    if ((targetRepresentation.GetPointer() || targetInSharedLabelmap) && !overwriteExisting)
       {
       continue;
       }
@@ -957,10 +1347,18 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
       {
       targetRepresentation = vtkSmartPointer<vtkDataObject>::Take(
         currentConversionRule->ConstructRepresentationObjectByRepresentation(currentConversionRule->GetTargetRepresentationName()) );
+      vtkDataObject* invalidatedRepresentation = this->GetInvalidatedRepresentation(segment, currentConversionRule->GetTargetRepresentationName());
+      if (invalidatedRepresentation && targetRepresentation.GetPointer())
+        {
+        // Start from the previous result so that the rule only needs to update it
+        targetRepresentation->ShallowCopy(invalidatedRepresentation);
+        }
       }
 
     // Perform conversion step
-    currentConversionRule->Convert(sourceRepresentation, targetRepresentation);
+    this->Converter->Convert(currentConversionRule, sourceRepresentation, targetRepresentation,
+      this->Converter->SerializeAllConversionParameters());
+    this->RemoveInvalidatedRepresentation(segment, currentConversionRule->GetTargetRepresentationName());
 
     // Add representation to segment
     segment->AddRepresentation(currentConversionRule->GetTargetRepresentationName(), targetRepresentation);
@@ -969,6 +1367,128 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
   return true;
 }
 
+//-----------------------------------------------------------------------------
+bool vtkSegmentation::ConvertSegmentsUsingPath(vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting,
+  bool alwaysInvokeRepresentationModified)
+{
+  vtkSegmentationConverter::ConversionPathType::iterator pathIt;
+  for (pathIt = path.begin(); pathIt != path.end(); ++pathIt)
+    {
+    if (!(*pathIt))
+      {
+      vtkErrorMacro("ConvertSegmentsUsingPath: Invalid converter rule!");
+      return false;
+      }
+    }
+  if (path.empty())
+    {
+    return true;
+    }
+  std::string targetRepresentationName = path.back()->GetTargetRepresentationName();
+
+  std::vector<SegmentConversionJob> jobs(this->Segments.size());
+  std::vector<SegmentConversionJob>::iterator jobIt = jobs.begin();
+  for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt, ++jobIt)
+    {
+    jobIt->SegmentId = segmentIt->first;
+    jobIt->Segment = segmentIt->second;
+    SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segmentIt->second);
+    if (locationIt != this->SharedLabelmapLocations.end()
+      && !segmentIt->second->GetStoredRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+      {
+      jobIt->SharedLabelmapLayer = this->LabelmapLayers[locationIt->second.LayerIndex];
+      jobIt->LabelValue = locationIt->second.LabelValue;
+      for (int i = 0; i < 6; ++i)
+        {
+        jobIt->LabelExtent[i] = locationIt->second.Extent[i];
+        }
+      }
+    std::map< vtkSegment*, vtkSegment::RepresentationMap >::iterator invalidatedIt = this->InvalidatedRepresentations.find(segmentIt->second);
+    if (invalidatedIt != this->InvalidatedRepresentations.end())
+      {
+      jobIt->InvalidatedRepresentations = invalidatedIt->second;
+      }
+    jobIt->RepresentationBefore = segmentIt->second->GetStoredRepresentation(targetRepresentationName);
+    jobIt->RepresentationMTimeBefore = (jobIt->RepresentationBefore ? jobIt->RepresentationBefore->GetMTime() : 0);
+    }
+
+  std::string conversionParameters = this->Converter->SerializeAllConversionParameters();
+  int numberOfThreads = this->Converter->GetNumberOfConversionThreads(static_cast<int>(jobs.size()));
+  if (numberOfThreads <= 1)
+    {
+    for (jobIt = jobs.begin(); jobIt != jobs.end(); ++jobIt)
+      {
+      ConvertSegmentConversionJob(*jobIt, path, overwriteExisting, this->Converter, conversionParameters);
+      }
+    }
+  else
+    {
+    // Rules may store state during conversion, therefore each thread gets its own copy
+    std::vector< vtkSmartPointer<vtkSegmentationConverterRule> > clonedRules;
+    SegmentConversionThreadData threadData;
+    threadData.ThreadPaths.resize(numberOfThreads);
+    for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+      {
+      for (pathIt = path.begin(); pathIt != path.end(); ++pathIt)
+        {
+        vtkSmartPointer<vtkSegmentationConverterRule> clonedRule =
+          vtkSmartPointer<vtkSegmentationConverterRule>::Take((*pathIt)->Clone());
+        clonedRules.push_back(clonedRule);
+        threadData.ThreadPaths[threadIndex].push_back(clonedRule);
+        }
+      }
+    vtkNew<vtkSimpleMutexLock> jobLock;
+    threadData.Jobs = &jobs;
+    threadData.OverwriteExisting = overwriteExisting;
+    threadData.Converter = this->Converter;
+    threadData.ConversionParameters = conversionParameters;
+    threadData.JobLock = jobLock.GetPointer();
+    threadData.NextJobIndex = 0;
+
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(ConvertSegmentsThreadFunction, &threadData);
+    threader->SingleMethodExecute();
+    }
+
+  // Store results in the segments and notify observers on the calling thread, in segment order
+  for (jobIt = jobs.begin(); jobIt != jobs.end(); ++jobIt)
+    {
+    if (!jobIt->Success)
+      {
+      vtkErrorMacro("ConvertSegmentsUsingPath: " << jobIt->ErrorMessage);
+      return false;
+      }
+    std::vector< std::pair<std::string, vtkSmartPointer<vtkDataObject> > >::iterator reprIt;
+    for (reprIt = jobIt->Representations.begin(); reprIt != jobIt->Representations.end(); ++reprIt)
+      {
+      vtkDataObject* existingRepresentation = jobIt->Segment->GetStoredRepresentation(reprIt->first);
+      if (existingRepresentation && !strcmp(existingRepresentation->GetClassName(), reprIt->second->GetClassName()))
+        {
+        // Update existing object so that references to it remain valid
+        existingRepresentation->ShallowCopy(reprIt->second);
+        }
+      else
+        {
+        jobIt->Segment->AddRepresentation(reprIt->first, reprIt->second);
+        }
+      this->RemoveInvalidatedRepresentation(jobIt->Segment, reprIt->first);
+      }
+
+    vtkDataObject* representationAfter = jobIt->Segment->GetStoredRepresentation(targetRepresentationName);
+    if (alwaysInvokeRepresentationModified
+      || jobIt->RepresentationBefore != representationAfter
+      || (representationAfter != NULL && representationAfter->GetMTime() != jobIt->RepresentationMTimeBefore) )
+      {
+      // representation has been modified
+      const char* segmentId = jobIt->SegmentId.c_str();
+      this->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentId);
+      }
+    }
+
+  return true;
+}
+
 //---------------------------------------------------------------------------
 bool vtkSegmentation::CreateRepresentation(const std::string& targetRepresentationName, bool alwaysConvert/*=false*/)
 {
@@ -984,7 +1504,7 @@ bool vtkSegmentation::CreateRepresentation(const std::string& targetRepresentati
     bool representationExists = true;
     for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
       {
-      if (!segmentIt->second->GetRepresentation(targetRepresentationName))
+      if (!this->IsSegmentRepresentationAvailable(segmentIt->second, targetRepresentationName))
         {
         // All segments should have the same representation configuration,
         // so checking each segment is mostly a safety measure
@@ -1031,22 +1551,10 @@ bool vtkSegmentation::CreateRepresentation(const std::string& targetRepresentati
     }
 
   // Perform conversion on all segments (no overwrites)
-  for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
+  if (!this->ConvertSegmentsUsingPath(cheapestPath, alwaysConvert, false))
     {
-    vtkDataObject* representationBefore = segmentIt->second->GetRepresentation(targetRepresentationName);
-    if (!this->ConvertSegmentUsingPath(segmentIt->second, cheapestPath, alwaysConvert))
-      {
-      vtkErrorMacro("CreateRepresentation: Conversion failed");
-      return false;
-      }
-    vtkDataObject* representationAfter = segmentIt->second->GetRepresentation(targetRepresentationName);
-    if (representationBefore != representationAfter
-      || (representationBefore != NULL && representationAfter != NULL && representationBefore->GetMTime() != representationAfter->GetMTime()) )
-      {
-      // representation has been modified
-      const char* segmentId = segmentIt->first.c_str();
-      this->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentId);
-      }
+    vtkErrorMacro("CreateRepresentation: Conversion failed");
+    return false;
     }
 
   this->InvokeEvent(vtkSegmentation::ContainedRepresentationNamesModified);
@@ -1071,15 +1579,10 @@ bool vtkSegmentation::CreateRepresentation(vtkSegmentationConverter::ConversionP
   this->Converter->SetConversionParameters(parameters);
 
   // Perform conversion on all segments (do overwrites)
-  for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
+  if (!this->ConvertSegmentsUsingPath(path, true, true))
     {
-    if (!this->ConvertSegmentUsingPath(segmentIt->second, path, true))
-      {
-      vtkErrorMacro("CreateRepresentation: Conversion failed");
-      return false;
-      }
-    const char* segmentId = segmentIt->first.c_str();
-    this->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentId);
+    vtkErrorMacro("CreateRepresentation: Conversion failed");
+    return false;
     }
 
   this->InvokeEvent(vtkSegmentation::ContainedRepresentationNamesModified);
@@ -1089,9 +1592,14 @@ bool vtkSegmentation::CreateRepresentation(vtkSegmentationConverter::ConversionP
 //---------------------------------------------------------------------------
 void vtkSegmentation::RemoveRepresentation(const std::string& representationName)
 {
+  if (representationName == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    this->RemoveAllLabelmapLayers();
+    }
   for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
     {
     segmentIt->second->RemoveRepresentation(representationName);
+    this->RemoveInvalidatedRepresentation(segmentIt->second, representationName);
     }
 
   this->InvokeEvent(vtkSegmentation::ContainedRepresentationNamesModified);
@@ -1105,19 +1613,107 @@ vtkDataObject* vtkSegmentation::GetSegmentRepresentation(std::string segmentId,
     {
     return NULL;
     }
+  if (representationName == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    // Provide per-segment labelmap if it is stored in a shared labelmap layer
+    this->ExtractSharedLabelmapToSegment(segment);
+    }
   return segment->GetRepresentation(representationName);
 }
 
 //---------------------------------------------------------------------------
 void vtkSegmentation::InvalidateNonMasterRepresentations()
 {
+  // Representations that are directly converted from the master representation by a rule
+  // that can update its previous result are kept for the next conversion
+  std::set<std::string> incrementalRepresentationNames;
+  std::set<std::string> representationNames;
+  this->Converter->GetAvailableRepresentationNames(representationNames);
+  for (std::set<std::string>::iterator nameIt = representationNames.begin(); nameIt != representationNames.end(); ++nameIt)
+    {
+    if (*nameIt == this->MasterRepresentationName)
+      {
+      continue;
+      }
+    vtkSegmentationConverter::ConversionPathAndCostListType pathCosts;
+    this->Converter->GetPossibleConversions(this->MasterRepresentationName, *nameIt, pathCosts);
+    for (vtkSegmentationConverter::ConversionPathAndCostListType::iterator pathIt = pathCosts.begin(); pathIt != pathCosts.end(); ++pathIt)
+      {
+      if (pathIt->first.size() == 1 && pathIt->first[0]->IsIncrementalConversionEnabled())
+        {
+        incrementalRepresentationNames.insert(*nameIt);
+        }
+      }
+    }
+
+  if (this->MasterRepresentationName != vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    {
+    this->RemoveAllLabelmapLayers();
+    }
+
   // Iterate through all segments and remove all representations that are not the master representation
   for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
     {
+    vtkSegment::RepresentationMap& invalidatedRepresentations = this->InvalidatedRepresentations[segmentIt->second];
+    for (vtkSegment::RepresentationMap::iterator invalidatedIt = invalidatedRepresentations.begin();
+      invalidatedIt != invalidatedRepresentations.end(); )
+      {
+      if (incrementalRepresentationNames.find(invalidatedIt->first) == incrementalRepresentationNames.end())
+        {
+        invalidatedRepresentations.erase(invalidatedIt++);
+        }
+      else
+        {
+        ++invalidatedIt;
+        }
+      }
+    for (std::set<std::string>::iterator nameIt = incrementalRepresentationNames.begin(); nameIt != incrementalRepresentationNames.end(); ++nameIt)
+      {
+      vtkDataObject* representation = segmentIt->second->GetStoredRepresentation(*nameIt);
+      if (representation)
+        {
+        invalidatedRepresentations[*nameIt] = representation;
+        }
+      }
+    if (invalidatedRepresentations.empty())
+      {
+      this->InvalidatedRepresentations.erase(segmentIt->second);
+      }
     segmentIt->second->RemoveAllRepresentations(this->MasterRepresentationName);
     }
 }
 
+//---------------------------------------------------------------------------
+vtkDataObject* vtkSegmentation::GetInvalidatedRepresentation(vtkSegment* segment, const std::string& representationName)
+{
+  std::map< vtkSegment*, vtkSegment::RepresentationMap >::iterator segmentIt = this->InvalidatedRepresentations.find(segment);
+  if (segmentIt == this->InvalidatedRepresentations.end())
+    {
+    return NULL;
+    }
+  vtkSegment::RepresentationMap::iterator representationIt = segmentIt->second.find(representationName);
+  if (representationIt == segmentIt->second.end())
+    {
+    return NULL;
+    }
+  return representationIt->second;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentation::RemoveInvalidatedRepresentation(vtkSegment* segment, const std::string& representationName)
+{
+  std::map< vtkSegment*, vtkSegment::RepresentationMap >::iterator segmentIt = this->InvalidatedRepresentations.find(segment);
+  if (segmentIt == this->InvalidatedRepresentations.end())
+    {
+    return;
+    }
+  segmentIt->second.erase(representationName);
+  if (segmentIt->second.empty())
+    {
+    this->InvalidatedRepresentations.erase(segmentIt);
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkSegmentation::GetContainedRepresentationNames(std::vector<std::string>& representationNames)
 {
@@ -1153,16 +1749,17 @@ bool vtkSegmentation::IsMasterRepresentationPolyData()
     {
     // Assume the first segment contains the same name of representations as all segments (this should be the case by design)
     vtkSegment* firstSegment = this->Segments.begin()->second;
-    vtkDataObject* masterRepresentation = firstSegment->GetRepresentation(this->MasterRepresentationName);
-    return vtkPolyData::SafeDownCast(masterRepresentation) != NULL;
-    }
-  else
-    {
-    // There are no segments, create an empty representation to find out what type it is
-    vtkSmartPointer<vtkDataObject> masterRepresentation = vtkSmartPointer<vtkDataObject>::Take(
-      vtkSegmentationConverterFactory::GetInstance()->ConstructRepresentationObjectByRepresentation(this->MasterRepresentationName));
-    return vtkPolyData::SafeDownCast(masterRepresentation) != NULL;
+    vtkDataObject* masterRepresentation = firstSegment->GetStoredRepresentation(this->MasterRepresentationName);
+    if (masterRepresentation || !this->IsSegmentRepresentationAvailable(firstSegment, this->MasterRepresentationName))
+      {
+      return vtkPolyData::SafeDownCast(masterRepresentation) != NULL;
+      }
     }
+  // There are no segments (or master is stored in shared labelmap layers),
+  // create an empty representation to find out what type it is
+  vtkSmartPointer<vtkDataObject> masterRepresentation = vtkSmartPointer<vtkDataObject>::Take(
+    vtkSegmentationConverterFactory::GetInstance()->ConstructRepresentationObjectByRepresentation(this->MasterRepresentationName));
+  return vtkPolyData::SafeDownCast(masterRepresentation) != NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -1172,16 +1769,17 @@ bool vtkSegmentation::IsMasterRepresentationImageData()
     {
     // Assume the first segment contains the same name of representations as all segments (this should be the case by design)
     vtkSegment* firstSegment = this->Segments.begin()->second;
-    vtkDataObject* masterRepresentation = firstSegment->GetRepresentation(this->MasterRepresentationName);
-    return vtkOrientedImageData::SafeDownCast(masterRepresentation) != NULL;
-    }
-  else
-    {
-    // There are no segments, create an empty representation to find out what type it is
-    vtkSmartPointer<vtkDataObject> masterRepresentation = vtkSmartPointer<vtkDataObject>::Take(
-      vtkSegmentationConverterFactory::GetInstance()->ConstructRepresentationObjectByRepresentation(this->MasterRepresentationName));
-    return vtkOrientedImageData::SafeDownCast(masterRepresentation) != NULL;
+    vtkDataObject* masterRepresentation = firstSegment->GetStoredRepresentation(this->MasterRepresentationName);
+    if (masterRepresentation || !this->IsSegmentRepresentationAvailable(firstSegment, this->MasterRepresentationName))
+      {
+      return vtkOrientedImageData::SafeDownCast(masterRepresentation) != NULL;
+      }
     }
+  // There are no segments (or master is stored in shared labelmap layers),
+  // create an empty representation to find out what type it is
+  vtkSmartPointer<vtkDataObject> masterRepresentation = vtkSmartPointer<vtkDataObject>::Take(
+    vtkSegmentationConverterFactory::GetInstance()->ConstructRepresentationObjectByRepresentation(this->MasterRepresentationName));
+  return vtkOrientedImageData::SafeDownCast(masterRepresentation) != NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -1299,7 +1897,6 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
     vtkErrorMacro("CopySegmentFromSegmentation: Failed to get segment!");
     return false;
     }
-
   // If source segmentation contains reference image geometry conversion parameter,
   // but target segmentation does not, then copy that parameter from the source segmentation
   // TODO: Do this with all parameters? (so those which have non-default values are replaced)
@@ -1311,6 +1908,7 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
     }
 
   // If copy, then duplicate segment and add it to the target segmentation
+  // (binary labelmap stored in a shared labelmap layer of the source is copied without extracting it in the source)
   if (!removeFromSource)
     {
     vtkSmartPointer<vtkSegment> segmentCopy = vtkSmartPointer<vtkSegment>::New();
@@ -1324,6 +1922,8 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
   // If move, then just add segment to target and remove from source (ownership is transferred)
   else
     {
+    // Moved segment must contain its own binary labelmap if it is stored in a shared labelmap layer
+    fromSegmentation->ExtractSharedLabelmapToSegment(segment);
     if (!this->AddSegment(segment, targetSegmentId))
       {
       vtkErrorMacro("CopySegmentFromSegmentation: Failed to add segment '" << targetSegmentId << "' to segmentation");
@@ -1390,8 +1990,14 @@ std::string vtkSegmentation::DetermineCommonLabelmapGeometry(int extentComputati
       continue;
       }
     vtkOrientedImageData* currentBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
-      currentSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
-    if (currentBinaryLabelmap->IsEmpty())
+      currentSegment->GetStoredRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    // Only the geometry is needed, which is available without extraction for labelmaps in shared layers
+    vtkNew<vtkOrientedImageData> sharedLabelmapGeometry;
+    if (!currentBinaryLabelmap && this->GetSharedLabelmapGeometry(currentSegment, sharedLabelmapGeometry.GetPointer()))
+      {
+      currentBinaryLabelmap = sharedLabelmapGeometry.GetPointer();
+      }
+    if (currentBinaryLabelmap == NULL || currentBinaryLabelmap->IsEmpty())
       {
       continue;
       }
@@ -1485,7 +2091,15 @@ void vtkSegmentation::DetermineCommonLabelmapExtent(int commonGeometryExtent[6],
       continue;
       }
     vtkOrientedImageData* currentBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
-      currentSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+      currentSegment->GetStoredRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+    // Labelmaps in shared layers are stored with their effective extent, so their geometry is sufficient
+    vtkNew<vtkOrientedImageData> sharedLabelmapGeometry;
+    bool sharedLabelmap = false;
+    if (!currentBinaryLabelmap && this->GetSharedLabelmapGeometry(currentSegment, sharedLabelmapGeometry.GetPointer()))
+      {
+      currentBinaryLabelmap = sharedLabelmapGeometry.GetPointer();
+      sharedLabelmap = true;
+      }
     if (currentBinaryLabelmap==NULL || currentBinaryLabelmap->IsEmpty())
       {
       continue;
@@ -1493,7 +2107,7 @@ void vtkSegmentation::DetermineCommonLabelmapExtent(int commonGeometryExtent[6],
 
     int currentBinaryLabelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
     bool validExtent = true;
-    if (computeEffectiveExtent)
+    if (computeEffectiveExtent && !sharedLabelmap)
       {
       validExtent = vtkOrientedImageDataResample::CalculateEffectiveExtent(currentBinaryLabelmap, currentBinaryLabelmapExtent);
       }
@@ -1596,3 +2210,409 @@ void vtkSegmentation::DeserializeConversionParameters(std::string conversionPara
 {
   this->Converter->DeserializeConversionParameters(conversionParametersString);
 }
+
+//----------------------------------------------------------------------------
+void vtkSegmentation::SetSharedLabelmapLayers(bool shared)
+{
+  if (this->SharedLabelmapLayers == shared)
+    {
+    return;
+    }
+  if (shared)
+    {
+    this->SharedLabelmapLayers = true;
+    this->CollapseBinaryLabelmaps();
+    }
+  else
+    {
+    this->ExpandBinaryLabelmaps();
+    this->SharedLabelmapLayers = false;
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentation::CollapseBinaryLabelmaps()
+{
+  if (!this->SharedLabelmapLayers)
+    {
+    return;
+    }
+
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    vtkSegment* segment = this->Segments[*segmentIdIt];
+    vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segment->GetStoredRepresentation(binaryLabelmapName));
+    if (!labelmap)
+      {
+      // Already stored in a layer or there is no binary labelmap
+      continue;
+      }
+
+    // Labelmaps that were extracted from the layers and have not changed since do not have to be stored again
+    SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segment);
+    bool unchanged = (locationIt != this->SharedLabelmapLocations.end()
+      && locationIt->second.ExtractedLabelmap.GetPointer() == labelmap
+      && locationIt->second.ExtractedLabelmapMTime == labelmap->GetMTime());
+    if (!unchanged)
+      {
+      this->RemoveSegmentFromLabelmapLayers(segment);
+      if (!this->AddLabelmapToLayers(segment, labelmap))
+        {
+        vtkErrorMacro("CollapseBinaryLabelmaps: Failed to store binary labelmap of segment " << (*segmentIdIt) << " in shared labelmap layers");
+        continue;
+        }
+      }
+
+    // Release labelmap from the segment. The content of the segment does not change, therefore no events are invoked.
+    labelmap->RemoveObservers(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
+    this->SharedLabelmapLocations[segment].ExtractedLabelmap = NULL;
+    segment->Representations.erase(binaryLabelmapName);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentation::ExpandBinaryLabelmaps()
+{
+  for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
+    {
+    this->ExtractSharedLabelmapToSegment(segmentIt->second);
+    }
+  this->RemoveAllLabelmapLayers();
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentation::RemoveAllLabelmapLayers()
+{
+  for (SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.begin();
+    locationIt != this->SharedLabelmapLocations.end(); ++locationIt)
+    {
+    locationIt->first->SharedLabelmapSegmentation = NULL;
+    }
+  this->SharedLabelmapLocations.clear();
+  this->LabelmapLayers.clear();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentation::AddLabelmapToLayers(vtkSegment* segment, vtkOrientedImageData* labelmap)
+{
+  if (!segment || !labelmap)
+    {
+    return false;
+    }
+
+  SharedLabelmapLocation location;
+  location.LayerIndex = -1;
+  location.LabelValue = 0;
+  location.ExtractedLabelmapMTime = 0;
+  int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::copy(emptyExtent, emptyExtent + 6, location.Extent);
+
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool labelmapEmpty = !vtkOrientedImageDataResample::CalculateEffectiveExtent(labelmap, effectiveExtent);
+
+  vtkNew<vtkMatrix4x4> labelmapImageToWorldMatrix;
+  labelmap->GetImageToWorldMatrix(labelmapImageToWorldMatrix.GetPointer());
+  if (this->LabelmapLayers.empty())
+    {
+    this->LabelmapLayers.push_back(CreateLabelmapLayer(labelmapImageToWorldMatrix.GetPointer(), emptyExtent));
+    }
+  else if (!labelmapEmpty && this->LabelmapLayers[0]->IsEmpty())
+    {
+    // Layers do not contain any voxels yet, so they can simply take the geometry of the labelmap
+    for (std::vector< vtkSmartPointer<vtkOrientedImageData> >::iterator layerIt = this->LabelmapLayers.begin();
+      layerIt != this->LabelmapLayers.end(); ++layerIt)
+      {
+      (*layerIt)->SetImageToWorldMatrix(labelmapImageToWorldMatrix.GetPointer());
+      }
+    }
+  vtkOrientedImageData* firstLayer = this->LabelmapLayers[0];
+
+  // Create foreground mask of the labelmap in the geometry of the layers
+  vtkSmartPointer<vtkImageData> mask;
+  if (!labelmapEmpty)
+    {
+    vtkSmartPointer<vtkOrientedImageData> labelmapInLayerGeometry = labelmap;
+    if (!vtkOrientedImageDataResample::DoGeometriesMatch(labelmap, firstLayer))
+      {
+      labelmapInLayerGeometry = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        labelmap, firstLayer, labelmapInLayerGeometry, false, true))
+        {
+        vtkErrorMacro("AddLabelmapToLayers: Failed to resample labelmap to the geometry of the shared labelmap layers");
+        return false;
+        }
+      labelmapEmpty = !vtkOrientedImageDataResample::CalculateEffectiveExtent(labelmapInLayerGeometry, effectiveExtent);
+      }
+    if (!labelmapEmpty)
+      {
+      // Pad layers so that they contain the labelmap
+      int* layerExtent = firstLayer->GetExtent();
+      int unionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      bool padRequired = IsExtentEmpty(layerExtent);
+      for (int i = 0; i < 3; ++i)
+        {
+        unionExtent[i * 2] = padRequired ? effectiveExtent[i * 2] : std::min(effectiveExtent[i * 2], layerExtent[i * 2]);
+        unionExtent[i * 2 + 1] = padRequired ? effectiveExtent[i * 2 + 1] : std::max(effectiveExtent[i * 2 + 1], layerExtent[i * 2 + 1]);
+        }
+      padRequired = padRequired || !std::equal(unionExtent, unionExtent + 6, layerExtent);
+      if (padRequired)
+        {
+        for (std::vector< vtkSmartPointer<vtkOrientedImageData> >::iterator layerIt = this->LabelmapLayers.begin();
+          layerIt != this->LabelmapLayers.end(); ++layerIt)
+          {
+          PadLabelmapLayer(*layerIt, unionExtent);
+          }
+        }
+
+      mask = vtkSmartPointer<vtkImageData>::New();
+      mask->SetExtent(effectiveExtent);
+      mask->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+      switch (labelmapInLayerGeometry->GetScalarType())
+        {
+        vtkTemplateMacro(CreateForegroundMaskGeneric(labelmapInLayerGeometry.GetPointer(), static_cast<VTK_TT*>(NULL), mask.GetPointer(), effectiveExtent));
+        default:
+          vtkErrorMacro("AddLabelmapToLayers: Unknown scalar type");
+          return false;
+        }
+      std::copy(effectiveExtent, effectiveExtent + 6, location.Extent);
+      }
+    }
+
+  // Find the first layer that has a free label value and where the segment does not overlap with other segments
+  int numberOfLayers = static_cast<int>(this->LabelmapLayers.size());
+  for (int layerIndex = 0; layerIndex < numberOfLayers && location.LayerIndex < 0; ++layerIndex)
+    {
+    std::set<int> usedLabelValues;
+    for (SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.begin();
+      locationIt != this->SharedLabelmapLocations.end(); ++locationIt)
+      {
+      if (locationIt->second.LayerIndex == layerIndex)
+        {
+        usedLabelValues.insert(locationIt->second.LabelValue);
+        }
+      }
+    int labelValue = 1;
+    while (labelValue <= VTK_UNSIGNED_CHAR_MAX && usedLabelValues.count(labelValue))
+      {
+      ++labelValue;
+      }
+    if (labelValue > VTK_UNSIGNED_CHAR_MAX)
+      {
+      continue;
+      }
+    if (mask && IsMaskOverlappingLayer(mask, this->LabelmapLayers[layerIndex], location.Extent))
+      {
+      continue;
+      }
+    location.LayerIndex = layerIndex;
+    location.LabelValue = labelValue;
+    }
+  if (location.LayerIndex < 0)
+    {
+    // Overlapping segment, add a new layer
+    vtkNew<vtkMatrix4x4> layerImageToWorldMatrix;
+    firstLayer->GetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+    this->LabelmapLayers.push_back(CreateLabelmapLayer(layerImageToWorldMatrix.GetPointer(), firstLayer->GetExtent()));
+    location.LayerIndex = numberOfLayers;
+    location.LabelValue = 1;
+    }
+
+  if (mask)
+    {
+    SetLabelInLayer(this->LabelmapLayers[location.LayerIndex], mask, 0, location.LabelValue, location.Extent);
+    this->LabelmapLayers[location.LayerIndex]->Modified();
+    }
+  location.StoredTime.Modified();
+  this->SharedLabelmapLocations[segment] = location;
+  segment->SharedLabelmapSegmentation = this;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentation::RemoveSegmentFromLabelmapLayers(vtkSegment* segment)
+{
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segment);
+  if (locationIt == this->SharedLabelmapLocations.end())
+    {
+    return;
+    }
+  int layerIndex = locationIt->second.LayerIndex;
+  if (!IsExtentEmpty(locationIt->second.Extent))
+    {
+    SetLabelInLayer(this->LabelmapLayers[layerIndex], NULL, locationIt->second.LabelValue, 0, locationIt->second.Extent);
+    this->LabelmapLayers[layerIndex]->Modified();
+    }
+  this->SharedLabelmapLocations.erase(locationIt);
+  segment->SharedLabelmapSegmentation = NULL;
+
+  // Remove the layer if it is not used anymore
+  for (locationIt = this->SharedLabelmapLocations.begin(); locationIt != this->SharedLabelmapLocations.end(); ++locationIt)
+    {
+    if (locationIt->second.LayerIndex == layerIndex)
+      {
+      return;
+      }
+    }
+  this->LabelmapLayers.erase(this->LabelmapLayers.begin() + layerIndex);
+  for (locationIt = this->SharedLabelmapLocations.begin(); locationIt != this->SharedLabelmapLocations.end(); ++locationIt)
+    {
+    if (locationIt->second.LayerIndex > layerIndex)
+      {
+      --locationIt->second.LayerIndex;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkSegmentation::ExtractSharedLabelmapToSegment(vtkSegment* segment)
+{
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  if (!segment)
+    {
+    return NULL;
+    }
+  vtkOrientedImageData* storedLabelmap = vtkOrientedImageData::SafeDownCast(segment->GetStoredRepresentation(binaryLabelmapName));
+  if (storedLabelmap)
+    {
+    return storedLabelmap;
+    }
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segment);
+  if (locationIt == this->SharedLabelmapLocations.end())
+    {
+    return NULL;
+    }
+
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  this->GetSharedLabelmap(segment, labelmap);
+
+  // The content of the segment does not change, therefore no events are invoked
+  segment->Representations[binaryLabelmapName] = labelmap;
+  locationIt->second.ExtractedLabelmap = labelmap;
+  locationIt->second.ExtractedLabelmapMTime = labelmap->GetMTime();
+
+  if (this->MasterRepresentationModifiedEnabled && this->MasterRepresentationName == binaryLabelmapName)
+    {
+    labelmap->AddObserver(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
+    }
+  return labelmap;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentation::GetSharedLabelmap(vtkSegment* segment, vtkOrientedImageData* labelmap)
+{
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segment);
+  if (locationIt == this->SharedLabelmapLocations.end() || !labelmap)
+    {
+    return false;
+    }
+  ExtractLabelFromLayer(this->LabelmapLayers[locationIt->second.LayerIndex], locationIt->second.LabelValue,
+    locationIt->second.Extent, labelmap);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentation::GetSegmentBinaryLabelmap(std::string segmentId, vtkOrientedImageData* labelmap)
+{
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment || !labelmap)
+    {
+    return false;
+    }
+  vtkOrientedImageData* storedLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetStoredRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  if (storedLabelmap)
+    {
+    labelmap->ShallowCopy(storedLabelmap);
+    return true;
+    }
+  return this->GetSharedLabelmap(segment, labelmap);
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkSegmentation::GetSegmentBinaryLabelmapMTime(std::string segmentId)
+{
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    return 0;
+    }
+  vtkDataObject* storedLabelmap = segment->GetStoredRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  if (storedLabelmap)
+    {
+    return storedLabelmap->GetMTime();
+    }
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segment);
+  if (locationIt == this->SharedLabelmapLocations.end())
+    {
+    return 0;
+    }
+  return std::max(this->LabelmapLayers[locationIt->second.LayerIndex]->GetMTime(), locationIt->second.StoredTime.GetMTime());
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentation::GetSharedLabelmapGeometry(vtkSegment* segment, vtkOrientedImageData* geometryImage)
+{
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(segment);
+  if (locationIt == this->SharedLabelmapLocations.end() || !geometryImage)
+    {
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> layerImageToWorldMatrix;
+  this->LabelmapLayers[locationIt->second.LayerIndex]->GetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+  geometryImage->SetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+  geometryImage->SetExtent(locationIt->second.Extent);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentation::IsSegmentRepresentationAvailable(vtkSegment* segment, const std::string& representationName)
+{
+  if (segment->GetStoredRepresentation(representationName))
+    {
+    return true;
+    }
+  return (representationName == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()
+    && this->SharedLabelmapLocations.count(segment) > 0);
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentation::GetNumberOfLabelmapLayers()
+{
+  return static_cast<int>(this->LabelmapLayers.size());
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkSegmentation::GetNthLabelmapLayer(int layerIndex)
+{
+  if (layerIndex < 0 || layerIndex >= static_cast<int>(this->LabelmapLayers.size()))
+    {
+    vtkErrorMacro("GetNthLabelmapLayer: Invalid layer index " << layerIndex);
+    return NULL;
+    }
+  return this->LabelmapLayers[layerIndex];
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentation::GetSegmentLabelmapLayerIndex(std::string segmentId)
+{
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(this->GetSegment(segmentId));
+  if (locationIt == this->SharedLabelmapLocations.end())
+    {
+    return -1;
+    }
+  return locationIt->second.LayerIndex;
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentation::GetSegmentLabelValue(std::string segmentId)
+{
+  SharedLabelmapLocationMap::iterator locationIt = this->SharedLabelmapLocations.find(this->GetSegment(segmentId));
+  if (locationIt == this->SharedLabelmapLocations.end())
+    {
+    return 0;
+    }
+  return locationIt->second.LabelValue;
+}
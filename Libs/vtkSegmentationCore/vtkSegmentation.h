@@ -24,6 +24,8 @@
 // VTK includes
 #include <vtkObject.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
 #include <map>
@@ -38,6 +40,7 @@
 
 class vtkAbstractTransform;
 class vtkCallbackCommand;
+class vtkOrientedImageData;
 class vtkStringArray;
 
 /// \ingroup SegmentationCore
@@ -269,7 +272,9 @@ public:
   /// \return Vector of segments containing the requested tag
   std::vector<vtkSegment*> GetSegmentsByTag(std::string tag, std::string value="");
 
-  /// Get representation from segment
+  /// Get representation from segment.
+  /// Binary labelmap stored in a shared labelmap layer is extracted into the segment, which is needed
+  /// if the labelmap is going to be modified. For read-only access use \sa GetSegmentBinaryLabelmap.
   vtkDataObject* GetSegmentRepresentation(std::string segmentId, std::string representationName);
 
   /// Copy segment from one segmentation to this one
@@ -357,6 +362,20 @@ public:
   /// Note: all parameters with the same name should contain the same value
   std::string GetConversionParameter(const std::string& name) { return this->Converter->GetConversionParameter(name); };
 
+  /// Set maximum number of threads used for converting segments in parallel (0 = automatic)
+  /// \sa vtkSegmentationConverter::SetMaximumNumberOfThreads
+  void SetMaximumNumberOfConversionThreads(int numberOfThreads) { this->Converter->SetMaximumNumberOfThreads(numberOfThreads); };
+
+  /// Get maximum number of threads used for converting segments in parallel
+  int GetMaximumNumberOfConversionThreads() { return this->Converter->GetMaximumNumberOfThreads(); };
+
+  /// Enable/disable reusing cached conversion results
+  /// \sa vtkSegmentationConverter::SetConversionCacheEnabled
+  void SetConversionCacheEnabled(bool enabled) { this->Converter->SetConversionCacheEnabled(enabled); };
+
+  /// Get whether cached conversion results are reused
+  bool GetConversionCacheEnabled() { return this->Converter->GetConversionCacheEnabled(); };
+
   /// Get names of all conversion parameters used by the selected conversion path
   void GetConversionParametersForPath(vtkSegmentationConverterRule::ConversionParameterListType& conversionParameters,
     const vtkSegmentationConverter::ConversionPathType& path) { this->Converter->GetConversionParametersForPath(conversionParameters, path); };
@@ -378,6 +397,51 @@ public:
   /// the segmentation! Use \sa CreateRepresentation for that.
   virtual void SetMasterRepresentationName(const std::string& representationName);
 
+// Shared labelmap layers
+
+  /// Enable/disable storing binary labelmaps of segments in shared labelmap layers.
+  /// In this mode non-overlapping segments are stored in the same multi-label image (layer)
+  /// with distinct label values, and overlapping segments are placed in additional layers.
+  /// This greatly reduces memory usage of segmentations that contain many segments.
+  /// Binary labelmap of a segment is extracted from its layer on demand by \sa GetSegmentRepresentation
+  /// (or vtkSegment::GetRepresentation) and read without extraction by \sa GetSegmentBinaryLabelmap
+  /// and during conversions. A binary labelmap stored in the segment (extracted or newly set) takes
+  /// precedence over the layers until \sa CollapseBinaryLabelmaps is called.
+  /// Disabled by default.
+  virtual void SetSharedLabelmapLayers(bool shared);
+  vtkGetMacro(SharedLabelmapLayers, bool);
+  vtkBooleanMacro(SharedLabelmapLayers, bool);
+
+  /// Move binary labelmaps stored in the segments into the shared labelmap layers.
+  /// Labelmaps that were extracted from the layers and have not been modified since are just released.
+  /// Has no effect if shared labelmap layers are disabled.
+  void CollapseBinaryLabelmaps();
+
+  /// Get number of shared labelmap layers
+  int GetNumberOfLabelmapLayers();
+
+  /// Get shared labelmap layer. Voxel values are label values of the segments, 0 is background.
+  vtkOrientedImageData* GetNthLabelmapLayer(int layerIndex);
+
+  /// Get index of the shared labelmap layer that stores the segment.
+  /// Returns -1 if the segment is not stored in a shared labelmap layer.
+  int GetSegmentLabelmapLayerIndex(std::string segmentId);
+
+  /// Get label value of the segment in its shared labelmap layer.
+  /// Returns 0 if the segment is not stored in a shared labelmap layer.
+  int GetSegmentLabelValue(std::string segmentId);
+
+  /// Get binary labelmap of a segment without moving it out of the shared labelmap layers.
+  /// If the segment contains its own binary labelmap then the output is a shallow copy of it,
+  /// otherwise the voxels of the segment are extracted from its shared labelmap layer into the output.
+  /// \return False if the segment does not have a binary labelmap
+  bool GetSegmentBinaryLabelmap(std::string segmentId, vtkOrientedImageData* labelmap);
+
+  /// Get the last time the binary labelmap of a segment was changed. For segments stored in
+  /// a shared labelmap layer it is the time the layer or the location of the segment in it changed.
+  /// Returns 0 if the segment does not have a binary labelmap.
+  vtkMTimeType GetSegmentBinaryLabelmapMTime(std::string segmentId);
+
 protected:
   /// Convert given segment along a specified path
   /// \param segment Segment to convert
@@ -387,6 +451,19 @@ protected:
   /// \return Success flag
   bool ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting=false);
 
+  /// Convert all segments along a specified path. Segments are converted in parallel
+  /// if allowed by the converter (\sa vtkSegmentationConverter::MaximumNumberOfThreads), each
+  /// thread using its own clone of the conversion rules. Conversion results are added to the
+  /// segments and RepresentationModified events are invoked on the calling thread, in segment order.
+  /// \param path Path to do the conversion along
+  /// \param overwriteExisting If true then do each conversion step regardless the target representation
+  ///   exists. If false then skip those conversion steps that would overwrite existing representation
+  /// \param alwaysInvokeRepresentationModified If true then RepresentationModified is invoked for each
+  ///   segment, otherwise only for segments where the target representation has changed
+  /// \return Success flag
+  bool ConvertSegmentsUsingPath(vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting,
+    bool alwaysInvokeRepresentationModified);
+
   /// Converts a single segment to a representation.
   bool ConvertSingleSegment(std::string segmentId, std::string targetRepresentationName);
 
@@ -394,6 +471,43 @@ protected:
   /// finding the iterator based on their different input arguments.
   void RemoveSegment(SegmentMap::iterator segmentIt);
 
+  /// Determine if a representation is available in a segment, including binary labelmap stored in a shared labelmap layer
+  bool IsSegmentRepresentationAvailable(vtkSegment* segment, const std::string& representationName);
+
+  /// Extract binary labelmap of a segment from its shared labelmap layer and store it in the segment.
+  /// Nothing is done if the segment already contains a binary labelmap or it is not stored in a layer.
+  /// \return Binary labelmap of the segment, NULL if there is none
+  vtkOrientedImageData* ExtractSharedLabelmapToSegment(vtkSegment* segment);
+
+  /// Extract binary labelmap of a segment from its shared labelmap layer into the given image,
+  /// without modifying the segment or the layers.
+  /// \return False if the segment is not stored in a shared labelmap layer
+  bool GetSharedLabelmap(vtkSegment* segment, vtkOrientedImageData* labelmap);
+
+  /// Store binary labelmap of a segment in the shared labelmap layers. The labelmap is resampled
+  /// to the geometry of the layers if necessary, and layers are padded to contain it.
+  /// \return Success flag
+  bool AddLabelmapToLayers(vtkSegment* segment, vtkOrientedImageData* labelmap);
+
+  /// Erase the label of a segment from its shared labelmap layer. The layer is removed if it becomes unused.
+  void RemoveSegmentFromLabelmapLayers(vtkSegment* segment);
+
+  /// Extract binary labelmaps of all segments from the shared labelmap layers and remove the layers
+  void ExpandBinaryLabelmaps();
+
+  /// Remove all shared labelmap layers, without extracting the labelmaps they contain
+  void RemoveAllLabelmapLayers();
+
+  /// Get geometry and extent of a segment that is stored in a shared labelmap layer, without extracting voxels.
+  /// \return False if the segment is not stored in a shared labelmap layer
+  bool GetSharedLabelmapGeometry(vtkSegment* segment, vtkOrientedImageData* geometryImage);
+
+  /// Get representation of a segment that was invalidated but kept for incremental conversion. Returns NULL if not found.
+  vtkDataObject* GetInvalidatedRepresentation(vtkSegment* segment, const std::string& representationName);
+
+  /// Release representation of a segment that was kept for incremental conversion
+  void RemoveInvalidatedRepresentation(vtkSegment* segment, const std::string& representationName);
+
   /// Temporarily enable/disable master representation modified event.
   /// \return Old value of MasterRepresentationModifiedEnabled.
   /// In general, the old value should be restored after modified is temporarily disabled to ensure proper
@@ -445,6 +559,34 @@ protected:
   /// alphabetical order)
   std::deque< std::string > SegmentIds;
 
+  /// Flag indicating whether binary labelmaps are stored in shared labelmap layers
+  bool SharedLabelmapLayers;
+
+  /// Shared labelmap layers. All layers have the same geometry and extent.
+  std::vector< vtkSmartPointer<vtkOrientedImageData> > LabelmapLayers;
+
+  /// Location of a segment's binary labelmap in the shared labelmap layers
+  struct SharedLabelmapLocation
+    {
+    int LayerIndex;
+    int LabelValue;
+    /// Extent of the label in the layer (may be empty)
+    int Extent[6];
+    /// Time the segment was stored in the layer
+    vtkTimeStamp StoredTime;
+    /// Binary labelmap extracted into the segment and its modification time at extraction
+    vtkWeakPointer<vtkDataObject> ExtractedLabelmap;
+    vtkMTimeType ExtractedLabelmapMTime;
+    };
+  typedef std::map< vtkSegment*, SharedLabelmapLocation > SharedLabelmapLocationMap;
+  SharedLabelmapLocationMap SharedLabelmapLocations;
+
+  /// Representations removed by \sa InvalidateNonMasterRepresentations that the converter rule can update
+  /// incrementally (\sa vtkSegmentationConverterRule::IsIncrementalConversionEnabled). They are used as
+  /// initial content of the target representation in the next conversion of the segment.
+  std::map< vtkSegment*, vtkSegment::RepresentationMap > InvalidatedRepresentations;
+
+  friend class vtkSegment;
   friend class vtkSlicerSegmentationsModuleLogic;
   friend class qMRMLSegmentEditorWidgetPrivate;
 };
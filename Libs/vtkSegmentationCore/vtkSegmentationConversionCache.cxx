@@ -0,0 +1,706 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkSegmentationConversionCache.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverterRule.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkDirectory.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSimpleMutexLock.h>
+#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
+#include <vtkXMLImageDataReader.h>
+#include <vtkXMLImageDataWriter.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtkXMLPolyDataWriter.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+/// Name of the field data array that stores image directions in cache files
+const char* IMAGE_DIRECTIONS_ARRAY_NAME = "SegmentationConversionCacheImageDirections";
+
+//----------------------------------------------------------------------------
+/// 64-bit FNV-1a style hash, processing 8 bytes at a time for speed
+class ContentHasher
+{
+public:
+  ContentHasher() : Hash(14695981039346656037ULL) { }
+
+  void AddBytes(const void* data, size_t size)
+    {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t numberOfWords = size / sizeof(vtkTypeUInt64);
+    for (size_t i = 0; i < numberOfWords; ++i, bytes += sizeof(vtkTypeUInt64))
+      {
+      vtkTypeUInt64 word = 0;
+      memcpy(&word, bytes, sizeof(vtkTypeUInt64));
+      this->AddWord(word);
+      }
+    for (size_t i = numberOfWords * sizeof(vtkTypeUInt64); i < size; ++i, ++bytes)
+      {
+      this->AddWord(*bytes);
+      }
+    }
+
+  template <class T>
+  void AddValue(T value)
+    {
+    this->AddBytes(&value, sizeof(T));
+    }
+
+  void AddString(const std::string& text)
+    {
+    this->AddValue(static_cast<vtkTypeUInt64>(text.size()));
+    this->AddBytes(text.c_str(), text.size());
+    }
+
+  void AddDataArray(vtkDataArray* dataArray)
+    {
+    if (!dataArray)
+      {
+      this->AddValue(static_cast<vtkTypeUInt64>(0));
+      return;
+      }
+    this->AddValue(dataArray->GetDataType());
+    this->AddValue(dataArray->GetNumberOfComponents());
+    this->AddValue(static_cast<vtkTypeInt64>(dataArray->GetNumberOfTuples()));
+    size_t size = static_cast<size_t>(dataArray->GetNumberOfTuples()) * dataArray->GetNumberOfComponents()
+      * dataArray->GetDataTypeSize();
+    if (size > 0)
+      {
+      this->AddBytes(dataArray->GetVoidPointer(0), size);
+      }
+    }
+
+  void AddCellArray(vtkCellArray* cellArray)
+    {
+    if (!cellArray)
+      {
+      this->AddValue(static_cast<vtkTypeUInt64>(0));
+      return;
+      }
+#if VTK_MAJOR_VERSION >= 9
+    this->AddDataArray(cellArray->GetOffsetsArray());
+    this->AddDataArray(cellArray->GetConnectivityArray());
+#else
+    this->AddDataArray(cellArray->GetData());
+#endif
+    }
+
+  std::string GetHashString()
+    {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << this->Hash;
+    return ss.str();
+    }
+
+private:
+  void AddWord(vtkTypeUInt64 word)
+    {
+    this->Hash = (this->Hash ^ word) * 1099511628211ULL;
+    }
+
+  vtkTypeUInt64 Hash;
+};
+
+//----------------------------------------------------------------------------
+std::string GetCacheFileExtension(vtkDataObject* representation)
+{
+  if (vtkPolyData::SafeDownCast(representation))
+    {
+    return ".vtp";
+    }
+  if (vtkImageData::SafeDownCast(representation))
+    {
+    return ".vti";
+    }
+  return "";
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// The segmentation conversion cache singleton.
+// This MUST be default initialized to zero by the compiler and is
+// therefore not initialized here.  The ClassInitialize and ClassFinalize methods handle this instance.
+static vtkSegmentationConversionCache* vtkSegmentationConversionCacheInstance;
+
+//----------------------------------------------------------------------------
+// Must NOT be initialized.  Default initialization to zero is necessary.
+unsigned int vtkSegmentationConversionCacheInitialize::Count;
+
+//----------------------------------------------------------------------------
+// Implementation of vtkSegmentationConversionCacheInitialize class.
+//----------------------------------------------------------------------------
+vtkSegmentationConversionCacheInitialize::vtkSegmentationConversionCacheInitialize()
+{
+  if(++Self::Count == 1)
+    {
+    vtkSegmentationConversionCache::classInitialize();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentationConversionCacheInitialize::~vtkSegmentationConversionCacheInitialize()
+{
+  if(--Self::Count == 0)
+    {
+    vtkSegmentationConversionCache::classFinalize();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Up the reference count so it behaves like New
+vtkSegmentationConversionCache* vtkSegmentationConversionCache::New()
+{
+  vtkSegmentationConversionCache* ret = vtkSegmentationConversionCache::GetInstance();
+  ret->Register(NULL);
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// Return the single instance of the vtkSegmentationConversionCache
+vtkSegmentationConversionCache* vtkSegmentationConversionCache::GetInstance()
+{
+  if(!vtkSegmentationConversionCacheInstance)
+    {
+    // Try the factory first
+    vtkSegmentationConversionCacheInstance = (vtkSegmentationConversionCache*)vtkObjectFactory::CreateInstance("vtkSegmentationConversionCache");
+    // if the factory did not provide one, then create it here
+    if(!vtkSegmentationConversionCacheInstance)
+      {
+      vtkSegmentationConversionCacheInstance = new vtkSegmentationConversionCache;
+#ifdef VTK_HAS_INITIALIZE_OBJECT_BASE
+      vtkSegmentationConversionCacheInstance->InitializeObjectBase();
+#endif
+      }
+    }
+  // return the instance
+  return vtkSegmentationConversionCacheInstance;
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentationConversionCache::vtkSegmentationConversionCache()
+  : MemorySizeInMiB(0.0)
+  , MaximumMemorySizeInMiB(256.0)
+  , MaximumDiskSizeInMiB(1024.0)
+  , NumberOfHits(0)
+  , NumberOfMisses(0)
+{
+  this->Lock = vtkSimpleMutexLock::New();
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentationConversionCache::~vtkSegmentationConversionCache()
+{
+  this->CacheEntries.clear();
+  this->CacheEntryIndex.clear();
+  this->Lock->Delete();
+  this->Lock = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->vtkObject::PrintSelf(os, indent);
+  os << indent << "NumberOfCachedRepresentations: " << this->CacheEntries.size() << "\n";
+  os << indent << "MemorySizeInMiB: " << this->MemorySizeInMiB << "\n";
+  os << indent << "MaximumMemorySizeInMiB: " << this->MaximumMemorySizeInMiB << "\n";
+  os << indent << "CacheDirectory: " << this->CacheDirectory << "\n";
+  os << indent << "MaximumDiskSizeInMiB: " << this->MaximumDiskSizeInMiB << "\n";
+  os << indent << "NumberOfHits: " << this->NumberOfHits << "\n";
+  os << indent << "NumberOfMisses: " << this->NumberOfMisses << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::classInitialize()
+{
+  // Allocate the singleton
+  vtkSegmentationConversionCacheInstance = vtkSegmentationConversionCache::GetInstance();
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::classFinalize()
+{
+  vtkSegmentationConversionCacheInstance->Delete();
+  vtkSegmentationConversionCacheInstance = 0;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSegmentationConversionCache::GetRepresentationContentHash(vtkDataObject* representation)
+{
+  ContentHasher hasher;
+  vtkImageData* image = vtkImageData::SafeDownCast(representation);
+  vtkPolyData* polyData = vtkPolyData::SafeDownCast(representation);
+  if (image)
+    {
+    hasher.AddString(image->GetClassName());
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    image->GetExtent(extent);
+    hasher.AddBytes(extent, sizeof(extent));
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    image->GetOrigin(origin);
+    hasher.AddBytes(origin, sizeof(origin));
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    image->GetSpacing(spacing);
+    hasher.AddBytes(spacing, sizeof(spacing));
+    vtkOrientedImageData* orientedImage = vtkOrientedImageData::SafeDownCast(image);
+    if (orientedImage)
+      {
+      double directions[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+      orientedImage->GetDirections(directions);
+      hasher.AddBytes(directions, sizeof(directions));
+      }
+    hasher.AddDataArray(image->GetPointData() ? image->GetPointData()->GetScalars() : NULL);
+    }
+  else if (polyData)
+    {
+    hasher.AddString(polyData->GetClassName());
+    hasher.AddDataArray(polyData->GetPoints() ? polyData->GetPoints()->GetData() : NULL);
+    hasher.AddCellArray(polyData->GetVerts());
+    hasher.AddCellArray(polyData->GetLines());
+    hasher.AddCellArray(polyData->GetPolys());
+    hasher.AddCellArray(polyData->GetStrips());
+    }
+  else
+    {
+    return "";
+    }
+  return hasher.GetHashString();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSegmentationConversionCache::GetConversionKey(vtkSegmentationConverterRule* rule,
+  vtkDataObject* sourceRepresentation, const std::string& conversionParameters)
+{
+  if (!rule)
+    {
+    return "";
+    }
+  std::string contentHash = vtkSegmentationConversionCache::GetRepresentationContentHash(sourceRepresentation);
+  if (contentHash.empty())
+    {
+    return "";
+    }
+  ContentHasher conversionHasher;
+  conversionHasher.AddString(rule->GetClassName());
+  conversionHasher.AddString(rule->GetSourceRepresentationName());
+  conversionHasher.AddString(rule->GetTargetRepresentationName());
+  conversionHasher.AddString(conversionParameters);
+  return contentHash + "-" + conversionHasher.GetHashString();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentationConversionCache::Convert(vtkSegmentationConverterRule* rule, vtkDataObject* sourceRepresentation,
+  vtkDataObject* targetRepresentation, const std::string& conversionParameters)
+{
+  if (!rule || !sourceRepresentation || !targetRepresentation)
+    {
+    vtkErrorMacro("Convert: Invalid inputs");
+    return false;
+    }
+
+  this->Lock->Lock();
+  bool cacheEnabled = (this->MaximumMemorySizeInMiB > 0.0 || !this->CacheDirectory.empty());
+  this->Lock->Unlock();
+  if (!cacheEnabled)
+    {
+    return rule->Convert(sourceRepresentation, targetRepresentation);
+    }
+
+  std::string key = vtkSegmentationConversionCache::GetConversionKey(rule, sourceRepresentation, conversionParameters);
+  if (key.empty())
+    {
+    return rule->Convert(sourceRepresentation, targetRepresentation);
+    }
+  if (this->GetCachedRepresentation(key, targetRepresentation))
+    {
+    return true;
+    }
+
+  if (!rule->Convert(sourceRepresentation, targetRepresentation))
+    {
+    return false;
+    }
+  this->AddCachedRepresentation(key, targetRepresentation);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentationConversionCache::GetCachedRepresentation(const std::string& key, vtkDataObject* targetRepresentation)
+{
+  if (!targetRepresentation)
+    {
+    return false;
+    }
+  vtkSmartPointer<vtkDataObject> cachedRepresentation;
+  this->Lock->Lock();
+  std::map<std::string, CacheEntryListType::iterator>::iterator indexIt = this->CacheEntryIndex.find(key);
+  if (indexIt != this->CacheEntryIndex.end()
+    && !strcmp(indexIt->second->Representation->GetClassName(), targetRepresentation->GetClassName()))
+    {
+    // Move to the front of the list to mark it as most recently used
+    this->CacheEntries.splice(this->CacheEntries.begin(), this->CacheEntries, indexIt->second);
+    cachedRepresentation = indexIt->second->Representation;
+    }
+  std::string cacheDirectory = this->CacheDirectory;
+  this->Lock->Unlock();
+
+  // Cached representations are never modified after they are added, therefore they can be
+  // copied (and files can be read) without holding the lock and blocking other threads.
+  bool found = false;
+  if (cachedRepresentation)
+    {
+    targetRepresentation->DeepCopy(cachedRepresentation);
+    found = true;
+    }
+  else if (!cacheDirectory.empty() && this->ReadCachedRepresentation(cacheDirectory, key, targetRepresentation))
+    {
+    found = true;
+    }
+
+  this->Lock->Lock();
+  if (found)
+    {
+    this->NumberOfHits++;
+    }
+  else
+    {
+    this->NumberOfMisses++;
+    }
+  this->Lock->Unlock();
+
+  if (found && !cachedRepresentation)
+    {
+    // Read from disk, keep it in memory for subsequent requests
+    this->AddCachedRepresentation(key, targetRepresentation);
+    }
+  return found;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::AddCachedRepresentation(const std::string& key, vtkDataObject* representation)
+{
+  if (!representation || key.empty())
+    {
+    return;
+    }
+  this->Lock->Lock();
+  bool cacheInMemory = (this->MaximumMemorySizeInMiB > 0.0);
+  std::string cacheDirectory = this->CacheDirectory;
+  double maximumDiskSizeInMiB = this->MaximumDiskSizeInMiB;
+  // Only one thread writes the file of a key, others would just overwrite it with the same content
+  bool writeFile = (!cacheDirectory.empty() && this->KeysBeingWritten.insert(key).second);
+  this->Lock->Unlock();
+
+  // Representation is copied so that later changes of the original object do not affect the cache.
+  // Copying is done without holding the lock, as it may take long for large representations.
+  vtkSmartPointer<vtkDataObject> representationCopy;
+  double sizeInMiB = 0.0;
+  if (cacheInMemory)
+    {
+    representationCopy = vtkSmartPointer<vtkDataObject>::Take(representation->NewInstance());
+    representationCopy->DeepCopy(representation);
+    sizeInMiB = representationCopy->GetActualMemorySize() / 1024.0;
+    }
+
+  this->Lock->Lock();
+  std::map<std::string, CacheEntryListType::iterator>::iterator indexIt = this->CacheEntryIndex.find(key);
+  if (indexIt != this->CacheEntryIndex.end())
+    {
+    this->MemorySizeInMiB -= indexIt->second->SizeInMiB;
+    this->CacheEntries.erase(indexIt->second);
+    this->CacheEntryIndex.erase(indexIt);
+    }
+  if (representationCopy && this->MaximumMemorySizeInMiB > 0.0 && sizeInMiB <= this->MaximumMemorySizeInMiB)
+    {
+    CacheEntry entry;
+    entry.Key = key;
+    entry.Representation = representationCopy;
+    entry.SizeInMiB = sizeInMiB;
+    this->CacheEntries.push_front(entry);
+    this->CacheEntryIndex[key] = this->CacheEntries.begin();
+    this->MemorySizeInMiB += sizeInMiB;
+    this->RemoveLeastRecentlyUsedRepresentations();
+    }
+  this->Lock->Unlock();
+
+  if (writeFile)
+    {
+    // The file is written before returning, so the original representation can be written directly
+    std::string filePath = cacheDirectory + "/" + key + GetCacheFileExtension(representation);
+    if (!vtksys::SystemTools::FileExists(filePath.c_str(), true))
+      {
+      this->WriteCachedRepresentation(cacheDirectory, maximumDiskSizeInMiB, key, representation);
+      }
+    this->Lock->Lock();
+    this->KeysBeingWritten.erase(key);
+    this->Lock->Unlock();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::RemoveLeastRecentlyUsedRepresentations()
+{
+  while (!this->CacheEntries.empty() && this->MemorySizeInMiB > this->MaximumMemorySizeInMiB)
+    {
+    this->MemorySizeInMiB -= this->CacheEntries.back().SizeInMiB;
+    this->CacheEntryIndex.erase(this->CacheEntries.back().Key);
+    this->CacheEntries.pop_back();
+    }
+  if (this->CacheEntries.empty())
+    {
+    // Prevent accumulation of rounding errors
+    this->MemorySizeInMiB = 0.0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::RemoveAllCachedRepresentations()
+{
+  this->Lock->Lock();
+  this->CacheEntries.clear();
+  this->CacheEntryIndex.clear();
+  this->MemorySizeInMiB = 0.0;
+  this->Lock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::SetMaximumMemorySizeInMiB(double maximumMemorySizeInMiB)
+{
+  this->Lock->Lock();
+  if (this->MaximumMemorySizeInMiB == maximumMemorySizeInMiB)
+    {
+    this->Lock->Unlock();
+    return;
+    }
+  this->MaximumMemorySizeInMiB = maximumMemorySizeInMiB;
+  this->RemoveLeastRecentlyUsedRepresentations();
+  this->Lock->Unlock();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentationConversionCache::GetMemorySizeInMiB()
+{
+  this->Lock->Lock();
+  double memorySizeInMiB = this->MemorySizeInMiB;
+  this->Lock->Unlock();
+  return memorySizeInMiB;
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentationConversionCache::GetNumberOfCachedRepresentations()
+{
+  this->Lock->Lock();
+  int numberOfCachedRepresentations = static_cast<int>(this->CacheEntries.size());
+  this->Lock->Unlock();
+  return numberOfCachedRepresentations;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::SetCacheDirectory(const std::string& cacheDirectory)
+{
+  this->Lock->Lock();
+  if (this->CacheDirectory == cacheDirectory)
+    {
+    this->Lock->Unlock();
+    return;
+    }
+  this->CacheDirectory = cacheDirectory;
+  if (!this->CacheDirectory.empty() && !vtksys::SystemTools::MakeDirectory(this->CacheDirectory.c_str()))
+    {
+    vtkErrorMacro("SetCacheDirectory: Failed to create cache directory " << this->CacheDirectory);
+    this->CacheDirectory.clear();
+    }
+  this->Lock->Unlock();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSegmentationConversionCache::GetCacheDirectory()
+{
+  this->Lock->Lock();
+  std::string cacheDirectory = this->CacheDirectory;
+  this->Lock->Unlock();
+  return cacheDirectory;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentationConversionCache::ReadCachedRepresentation(const std::string& cacheDirectory,
+  const std::string& key, vtkDataObject* targetRepresentation)
+{
+  std::string filePath = cacheDirectory + "/" + key + GetCacheFileExtension(targetRepresentation);
+  if (!vtksys::SystemTools::FileExists(filePath.c_str(), true))
+    {
+    return false;
+    }
+
+  if (vtkPolyData::SafeDownCast(targetRepresentation))
+    {
+    vtkNew<vtkXMLPolyDataReader> reader;
+    reader->SetFileName(filePath.c_str());
+    reader->Update();
+    if (reader->GetErrorCode() != 0 || !reader->GetOutput())
+      {
+      return false;
+      }
+    targetRepresentation->DeepCopy(reader->GetOutput());
+    }
+  else
+    {
+    vtkNew<vtkXMLImageDataReader> reader;
+    reader->SetFileName(filePath.c_str());
+    reader->Update();
+    if (reader->GetErrorCode() != 0 || !reader->GetOutput())
+      {
+      return false;
+      }
+    targetRepresentation->DeepCopy(reader->GetOutput());
+    vtkOrientedImageData* orientedImage = vtkOrientedImageData::SafeDownCast(targetRepresentation);
+    vtkDoubleArray* directionsArray = vtkDoubleArray::SafeDownCast(
+      targetRepresentation->GetFieldData()->GetArray(IMAGE_DIRECTIONS_ARRAY_NAME));
+    if (orientedImage && directionsArray && directionsArray->GetNumberOfValues() == 9)
+      {
+      double directions[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+      for (int i = 0; i < 9; ++i)
+        {
+        directions[i / 3][i % 3] = directionsArray->GetValue(i);
+        }
+      orientedImage->SetDirections(directions);
+      }
+    targetRepresentation->GetFieldData()->RemoveArray(IMAGE_DIRECTIONS_ARRAY_NAME);
+    }
+
+  // Update modification time, which is used for finding the oldest files
+  vtksys::SystemTools::Touch(filePath, false);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationConversionCache::WriteCachedRepresentation(const std::string& cacheDirectory,
+  double maximumDiskSizeInMiB, const std::string& key, vtkDataObject* representation)
+{
+  std::string fileExtension = GetCacheFileExtension(representation);
+  std::string filePath = cacheDirectory + "/" + key + fileExtension;
+  // Write into a temporary file first so that other processes never see a partially written file
+  std::string temporaryFilePath = filePath + ".tmp";
+  int writeSuccess = 0;
+  if (vtkPolyData::SafeDownCast(representation))
+    {
+    vtkNew<vtkXMLPolyDataWriter> writer;
+    writer->SetFileName(temporaryFilePath.c_str());
+    writer->SetInputData(representation);
+    writer->SetDataModeToBinary();
+    writer->SetCompressorTypeToZLib();
+    writeSuccess = writer->Write();
+    }
+  else if (vtkImageData::SafeDownCast(representation))
+    {
+    // Image directions are not stored in VTK image files, add them as field data
+    vtkSmartPointer<vtkImageData> imageToWrite = vtkSmartPointer<vtkImageData>::New();
+    imageToWrite->ShallowCopy(representation);
+    vtkSmartPointer<vtkFieldData> fieldData = vtkSmartPointer<vtkFieldData>::New();
+    fieldData->ShallowCopy(representation->GetFieldData());
+    imageToWrite->SetFieldData(fieldData);
+    vtkOrientedImageData* orientedImage = vtkOrientedImageData::SafeDownCast(representation);
+    if (orientedImage)
+      {
+      double directions[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+      orientedImage->GetDirections(directions);
+      vtkNew<vtkDoubleArray> directionsArray;
+      directionsArray->SetName(IMAGE_DIRECTIONS_ARRAY_NAME);
+      directionsArray->SetNumberOfValues(9);
+      for (int i = 0; i < 9; ++i)
+        {
+        directionsArray->SetValue(i, directions[i / 3][i % 3]);
+        }
+      fieldData->AddArray(directionsArray.GetPointer());
+      }
+    vtkNew<vtkXMLImageDataWriter> writer;
+    writer->SetFileName(temporaryFilePath.c_str());
+    writer->SetInputData(imageToWrite);
+    writer->SetDataModeToBinary();
+    writer->SetCompressorTypeToZLib();
+    writeSuccess = writer->Write();
+    }
+  else
+    {
+    return;
+    }
+  if (!writeSuccess || !vtksys::SystemTools::RenameFile(temporaryFilePath.c_str(), filePath.c_str()))
+    {
+    vtkWarningMacro("WriteCachedRepresentation: Failed to write cache file " << filePath);
+    vtksys::SystemTools::RemoveFile(temporaryFilePath);
+    return;
+    }
+
+  // Remove oldest files if the cache directory grew too large
+  vtkNew<vtkDirectory> directory;
+  if (!directory->Open(cacheDirectory.c_str()))
+    {
+    return;
+    }
+  std::vector< std::pair<long, std::string> > cacheFiles; // modification time, file path
+  double diskSizeInMiB = 0.0;
+  for (vtkIdType fileIndex = 0; fileIndex < directory->GetNumberOfFiles(); ++fileIndex)
+    {
+    std::string fileName = directory->GetFile(fileIndex);
+    std::string extension = vtksys::SystemTools::GetFilenameLastExtension(fileName);
+    if (extension != ".vtp" && extension != ".vti")
+      {
+      continue;
+      }
+    std::string cacheFilePath = cacheDirectory + "/" + fileName;
+    diskSizeInMiB += vtksys::SystemTools::FileLength(cacheFilePath) / (1024.0 * 1024.0);
+    cacheFiles.push_back(std::make_pair(vtksys::SystemTools::ModifiedTime(cacheFilePath), cacheFilePath));
+    }
+  std::sort(cacheFiles.begin(), cacheFiles.end());
+  for (std::vector< std::pair<long, std::string> >::iterator fileIt = cacheFiles.begin();
+    fileIt != cacheFiles.end() && diskSizeInMiB > maximumDiskSizeInMiB; ++fileIt)
+    {
+    if (fileIt->second == filePath)
+      {
+      // Keep the file that has just been written
+      continue;
+      }
+    diskSizeInMiB -= vtksys::SystemTools::FileLength(fileIt->second) / (1024.0 * 1024.0);
+    vtksys::SystemTools::RemoveFile(fileIt->second);
+    }
+}
@@ -0,0 +1,195 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSegmentationConversionCache_h
+#define __vtkSegmentationConversionCache_h
+
+#include "vtkSegmentationCoreConfigure.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+class vtkDataObject;
+class vtkSegmentationConverterRule;
+class vtkSimpleMutexLock;
+
+/// \ingroup SegmentationCore
+/// \brief Process-wide cache of segmentation conversion results.
+///
+/// Conversion results are stored with a key computed from the content of the source
+/// representation (voxels and geometry of images, points and cells of poly data),
+/// the conversion rule, and the serialized conversion parameters. Converting the same
+/// source again with the same parameters (e.g., after toggling a parameter back and forth,
+/// or reloading the same segmentation) only copies the cached result.
+///
+/// Least recently used results are removed from memory when the total size exceeds
+/// MaximumMemorySizeInMiB. If CacheDirectory is set then results are also written to disk,
+/// which allows reusing them across application sessions.
+///
+/// The cache is only used by converters that enable it (see vtkSegmentationConverter::SetConversionCacheEnabled).
+/// The cache can be accessed from multiple threads. Copying of representations and file
+/// reading and writing is performed without holding the lock.
+/// Singleton pattern adopted from vtkSegmentationConverterFactory class.
+class vtkSegmentationCore_EXPORT vtkSegmentationConversionCache : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkSegmentationConversionCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Convert source representation to target representation using the conversion rule.
+  /// If the cache contains the result of the same conversion then it is copied to the target
+  /// representation, otherwise the rule performs the conversion and the result is added to the cache.
+  /// \param conversionParameters Serialized conversion parameters (see vtkSegmentationConverter::SerializeAllConversionParameters)
+  /// \return Success flag of the conversion
+  bool Convert(vtkSegmentationConverterRule* rule, vtkDataObject* sourceRepresentation,
+    vtkDataObject* targetRepresentation, const std::string& conversionParameters);
+
+  /// Get cached representation. Target representation is overwritten by a copy of the cached object.
+  /// \return True if the representation was found in the cache
+  bool GetCachedRepresentation(const std::string& key, vtkDataObject* targetRepresentation);
+
+  /// Add a copy of the representation to the cache
+  void AddCachedRepresentation(const std::string& key, vtkDataObject* representation);
+
+  /// Remove all cached representations from memory. Files in the cache directory are kept.
+  void RemoveAllCachedRepresentations();
+
+  /// Compute a hash string that identifies the content of a representation.
+  /// Returns empty string if the representation type is not supported for caching.
+  static std::string GetRepresentationContentHash(vtkDataObject* representation);
+
+  /// Compute cache key of a conversion. Returns empty string if the source representation cannot be cached.
+  static std::string GetConversionKey(vtkSegmentationConverterRule* rule, vtkDataObject* sourceRepresentation,
+    const std::string& conversionParameters);
+
+  /// Maximum total size of representations kept in memory.
+  /// Set to 0 to disable in-memory caching. Default is 256 MiB.
+  void SetMaximumMemorySizeInMiB(double maximumMemorySizeInMiB);
+  vtkGetMacro(MaximumMemorySizeInMiB, double);
+
+  /// Get total size of representations kept in memory, in MiB
+  double GetMemorySizeInMiB();
+
+  /// Get number of representations kept in memory
+  int GetNumberOfCachedRepresentations();
+
+  /// Directory where conversion results are stored for reuse across sessions.
+  /// Empty by default, which means that results are only cached in memory.
+  void SetCacheDirectory(const std::string& cacheDirectory);
+  std::string GetCacheDirectory();
+
+  /// Maximum total size of the files in the cache directory.
+  /// Oldest files are removed when the limit is exceeded. Default is 1024 MiB.
+  vtkSetMacro(MaximumDiskSizeInMiB, double);
+  vtkGetMacro(MaximumDiskSizeInMiB, double);
+
+  /// Number of conversions that were served from the cache (memory or disk)
+  vtkGetMacro(NumberOfHits, int);
+  /// Number of conversions that had to be computed
+  vtkGetMacro(NumberOfMisses, int);
+
+public:
+  /// Return the singleton instance with no reference counting.
+  static vtkSegmentationConversionCache* GetInstance();
+
+  /// This is a singleton pattern New.  There will only be ONE
+  /// reference to a vtkSegmentationConversionCache object per process.  Clients that
+  /// call this must call Delete on the object so that the reference
+  /// counting will work. The single instance will be unreferenced when
+  /// the program exits.
+  static vtkSegmentationConversionCache* New();
+
+protected:
+  vtkSegmentationConversionCache();
+  ~vtkSegmentationConversionCache();
+  vtkSegmentationConversionCache(const vtkSegmentationConversionCache&);
+  void operator=(const vtkSegmentationConversionCache&);
+
+  /// Remove least recently used representations until memory size is within the limit.
+  /// Must be called with the lock held.
+  void RemoveLeastRecentlyUsedRepresentations();
+
+  /// Read representation from the cache directory.
+  /// Does not access cache members, so it is called without holding the lock.
+  bool ReadCachedRepresentation(const std::string& cacheDirectory, const std::string& key,
+    vtkDataObject* targetRepresentation);
+
+  /// Write representation to the cache directory and remove oldest files if size limit is exceeded.
+  /// Does not access cache members, so it is called without holding the lock.
+  void WriteCachedRepresentation(const std::string& cacheDirectory, double maximumDiskSizeInMiB,
+    const std::string& key, vtkDataObject* representation);
+
+  // Singleton management functions.
+  static void classInitialize();
+  static void classFinalize();
+
+  friend class vtkSegmentationConversionCacheInitialize;
+  typedef vtkSegmentationConversionCache Self;
+
+protected:
+  struct CacheEntry
+    {
+    std::string Key;
+    vtkSmartPointer<vtkDataObject> Representation;
+    double SizeInMiB;
+    };
+  typedef std::list<CacheEntry> CacheEntryListType;
+
+  /// Cached representations, most recently used first
+  CacheEntryListType CacheEntries;
+  /// Fast lookup of cache entries by key
+  std::map<std::string, CacheEntryListType::iterator> CacheEntryIndex;
+
+  double MemorySizeInMiB;
+  double MaximumMemorySizeInMiB;
+  std::string CacheDirectory;
+  double MaximumDiskSizeInMiB;
+
+  int NumberOfHits;
+  int NumberOfMisses;
+
+  /// Keys of representations that are being written to the cache directory
+  std::set<std::string> KeysBeingWritten;
+
+  /// Protects all members, as conversions may run on multiple threads
+  vtkSimpleMutexLock* Lock;
+};
+
+/// Utility class to make sure vtkSegmentationConversionCache is initialized before it is used.
+class vtkSegmentationCore_EXPORT vtkSegmentationConversionCacheInitialize
+{
+public:
+  typedef vtkSegmentationConversionCacheInitialize Self;
+
+  vtkSegmentationConversionCacheInitialize();
+  ~vtkSegmentationConversionCacheInitialize();
+private:
+  static unsigned int Count;
+};
+
+/// This instance will show up in any translation unit that uses
+/// vtkSegmentationConversionCache.  It will make sure vtkSegmentationConversionCache is initialized
+/// before it is used.
+static vtkSegmentationConversionCacheInitialize vtkSegmentationConversionCacheInitializer;
+
+#endif
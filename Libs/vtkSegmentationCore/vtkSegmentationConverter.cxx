@@ -21,6 +21,7 @@
 // Segmentations includes
 #include "vtkSegmentationConverter.h"
 #include "vtkSegmentationConverterFactory.h"
+#include "vtkSegmentationConversionCache.h"
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
 #include "vtkSegmentationConverterRule.h"
@@ -47,6 +48,9 @@ vtkStandardNewMacro(vtkSegmentationConverter);
 //----------------------------------------------------------------------------
 vtkSegmentationConverter::vtkSegmentationConverter()
 {
+  this->MaximumNumberOfThreads = 0;
+  this->ConversionCacheEnabled = false;
+
   // Get default converter rules from factory
   vtkSegmentationConverterFactory::GetInstance()->CopyConverterRules(this->ConverterRules);
   this->RebuildRulesGraph();
@@ -62,6 +66,9 @@ void vtkSegmentationConverter::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
 
+  os << indent << "MaximumNumberOfThreads: " << this->MaximumNumberOfThreads << "\n";
+  os << indent << "ConversionCacheEnabled: " << (this->ConversionCacheEnabled ? "true" : "false") << "\n";
+
   ConverterRulesListType::iterator ruleIt;
   for (ruleIt = this->ConverterRules.begin(); ruleIt != this->ConverterRules.end(); ++ruleIt)
     {
@@ -93,6 +100,45 @@ void vtkSegmentationConverter::DeepCopy(vtkSegmentationConverter* aConverter)
       this->SetConversionParameter(paramIt->first, paramIt->second.first);
       }
     }
+
+  this->MaximumNumberOfThreads = aConverter->MaximumNumberOfThreads;
+  this->ConversionCacheEnabled = aConverter->ConversionCacheEnabled;
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentationConverter::GetNumberOfConversionThreads(int numberOfSegments)
+{
+  int numberOfThreads = this->MaximumNumberOfThreads;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  if (numberOfThreads > numberOfSegments)
+    {
+    numberOfThreads = numberOfSegments;
+    }
+  if (numberOfThreads > VTK_MAX_THREADS)
+    {
+    numberOfThreads = VTK_MAX_THREADS;
+    }
+  return (numberOfThreads < 1 ? 1 : numberOfThreads);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentationConverter::Convert(vtkSegmentationConverterRule* rule, vtkDataObject* sourceRepresentation,
+  vtkDataObject* targetRepresentation, const std::string& conversionParameters)
+{
+  if (!rule)
+    {
+    vtkErrorMacro("Convert: Invalid converter rule");
+    return false;
+    }
+  if (!this->ConversionCacheEnabled)
+    {
+    return rule->Convert(sourceRepresentation, targetRepresentation);
+    }
+  return vtkSegmentationConversionCache::GetInstance()->Convert(
+    rule, sourceRepresentation, targetRepresentation, conversionParameters);
 }
 
 //----------------------------------------------------------------------------
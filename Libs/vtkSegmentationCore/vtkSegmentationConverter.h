@@ -23,6 +23,7 @@
 
 // VTK includes
 #include <vtkObject.h>
+#include <vtkMultiThreader.h>
 #include <vtkSmartPointer.h>
 
 // STD includes
@@ -37,6 +38,7 @@
 #include "vtkSegmentationConverterRule.h"
 
 class vtkAbstractTransform;
+class vtkDataObject;
 class vtkSegment;
 class vtkMatrix4x4;
 class vtkImageData;
@@ -122,6 +124,32 @@ public:
   /// Non-linear: calculate new extents and change only the extents
   void ApplyTransformOnReferenceImageGeometry(vtkAbstractTransform* transform);
 
+  /// Maximum number of threads used for converting segments in parallel.
+  /// Each thread uses its own copy of the conversion rules.
+  /// If 0 (default) then the number of threads is determined by vtkMultiThreader.
+  /// If 1 then segments are converted one after the other on the calling thread.
+  vtkSetClampMacro(MaximumNumberOfThreads, int, 0, VTK_MAX_THREADS);
+  vtkGetMacro(MaximumNumberOfThreads, int);
+
+  /// Get number of threads that should be used for converting the given number of segments.
+  /// Takes into account \sa MaximumNumberOfThreads. Returns at least 1.
+  int GetNumberOfConversionThreads(int numberOfSegments);
+
+  /// If enabled then conversion results are stored in and reused from the
+  /// process-wide vtkSegmentationConversionCache, keyed on the source representation
+  /// content and \sa SerializeAllConversionParameters.
+  /// Disabled by default, as computing the key requires hashing the entire source
+  /// representation, which only pays off if the same conversions are repeated.
+  vtkSetMacro(ConversionCacheEnabled, bool);
+  vtkGetMacro(ConversionCacheEnabled, bool);
+  vtkBooleanMacro(ConversionCacheEnabled, bool);
+
+  /// Perform a conversion step. Uses the conversion cache if \sa ConversionCacheEnabled.
+  /// \param conversionParameters Serialized conversion parameters of this converter, obtained by
+  ///   \sa SerializeAllConversionParameters on the calling thread (rules may be used from worker threads)
+  bool Convert(vtkSegmentationConverterRule* rule, vtkDataObject* sourceRepresentation,
+    vtkDataObject* targetRepresentation, const std::string& conversionParameters);
+
 // Utility functions
 public:
   /// Return cheapest path from a list of paths with costs
@@ -185,6 +213,12 @@ protected:
 
   /// Source representation to target representation rule graph
   RepresentationToRepresentationToRuleMapType RulesGraph;
+
+  /// Maximum number of threads used for converting segments in parallel (0 = automatic)
+  int MaximumNumberOfThreads;
+
+  /// Flag determining whether conversion results are cached
+  bool ConversionCacheEnabled;
 };
 
 #endif // __vtkSegmentationConverter_h
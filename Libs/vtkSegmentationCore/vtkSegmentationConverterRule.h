@@ -83,6 +83,11 @@ public:
   /// Update the target representation based on the source representation
   virtual bool Convert(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation) = 0;
 
+  /// Returns true if the rule can update a target representation that it created from an earlier version of the
+  /// source representation faster than converting from scratch. The segmentation then keeps the target representations
+  /// that are invalidated by source representation changes and passes them to \sa Convert as initial target content.
+  virtual bool IsIncrementalConversionEnabled() { return false; };
+
   /// Get the cost of the conversion.
   /// \return Expected duration of the conversion in milliseconds. If the arguments are omitted, then a rough average can be
   ///   given just to indicate the relative computational cost of the algorithm. If the objects are given, then a more educated
@@ -22,11 +22,400 @@
 #include "vtkSegmentationHistory.h"
 #include "vtkSegmentationConverterFactory.h"
 #include "vtkSegmentation.h"
+#include "vtkOrientedImageData.h"
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkCallbackCommand.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPointData.h>
+
+// VTKSYS includes
+#include <vtksys/SystemInformation.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+//----------------------------------------------------------------------------
+/// \brief Stored state of an image representation.
+///
+/// Voxels are run-length encoded, which is very efficient for binary labelmaps.
+/// If a baseline is set then only the region that is different from the baseline is stored.
+class vtkSegmentationHistoryImageState : public vtkObject
+{
+public:
+  static vtkSegmentationHistoryImageState* New();
+  vtkTypeMacro(vtkSegmentationHistoryImageState, vtkObject);
+
+  /// Store image. If baseline is specified and it has the same geometry as the image
+  /// then only the changed region is stored (unless most of the image is changed or
+  /// the baseline already depends on maximumNumberOfDifferentialStates states).
+  void SetImage(vtkOrientedImageData* image, vtkSegmentationHistoryImageState* baseline,
+    unsigned int maximumNumberOfDifferentialStates);
+
+  /// Reconstruct the stored image
+  void GetImage(vtkOrientedImageData* image);
+
+  /// Keep a copy of the reconstructed image so that the next state can be compared to it
+  /// without decoding the chain of baseline states again.
+  void SetDecodedImage(vtkOrientedImageData* image);
+
+  /// Release the reconstructed image copy (see \sa SetDecodedImage)
+  void ReleaseDecodedImage() { this->DecodedImage = NULL; };
+
+  /// Store the full image instead of the difference compared to the baseline
+  void RemoveBaseline();
+
+  /// Get the state that this state stores the difference to (NULL if this state is self-contained)
+  vtkSegmentationHistoryImageState* GetBaseline() { return this->Baseline; };
+
+  /// Get memory used by this state (not including the baseline) in bytes.
+  /// The decoded image copy is not included, as it is only kept for the most recent state.
+  unsigned long GetMemorySize();
+
+protected:
+  vtkSegmentationHistoryImageState();
+  ~vtkSegmentationHistoryImageState() VTK_OVERRIDE { };
+
+  /// Returns true if the image has the same geometry and scalar type as the stored one
+  bool IsGeometryMatching(vtkOrientedImageData* image);
+
+  /// Run-length encode region of an image
+  void EncodeRegion(vtkImageData* image, const int region[6]);
+
+  /// Write stored runs into region of an image
+  void DecodeRegion(vtkImageData* image, const int region[6]);
+
+protected:
+  double ImageToWorldMatrix[16];
+  int Extent[6];
+  int ScalarType;
+  int NumberOfComponents;
+  bool HasScalars;
+  /// Size of a voxel (all components) in bytes
+  int ElementSize;
+
+  vtkSmartPointer<vtkSegmentationHistoryImageState> Baseline;
+  /// Number of baseline states needed to reconstruct the image
+  unsigned int NumberOfDifferentialStates;
+
+  /// Region of the image that is stored in the runs
+  int StoredExtent[6];
+  std::vector<unsigned int> RunLengths;
+  /// Voxel value of each run (ElementSize bytes per run)
+  std::vector<char> RunValues;
+
+  /// Uncompressed copy of the stored image. It is only kept for the state that the
+  /// next state is most likely to be compared to.
+  vtkSmartPointer<vtkOrientedImageData> DecodedImage;
+
+private:
+  vtkSegmentationHistoryImageState(const vtkSegmentationHistoryImageState&); // Not implemented
+  void operator=(const vtkSegmentationHistoryImageState&); // Not implemented
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSegmentationHistoryImageState);
+
+//----------------------------------------------------------------------------
+vtkSegmentationHistoryImageState::vtkSegmentationHistoryImageState()
+{
+  vtkMatrix4x4::Identity(this->ImageToWorldMatrix);
+  int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::copy(emptyExtent, emptyExtent + 6, this->Extent);
+  std::copy(emptyExtent, emptyExtent + 6, this->StoredExtent);
+  this->ScalarType = VTK_UNSIGNED_CHAR;
+  this->NumberOfComponents = 1;
+  this->HasScalars = false;
+  this->ElementSize = 1;
+  this->NumberOfDifferentialStates = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationHistoryImageState::SetImage(vtkOrientedImageData* image,
+  vtkSegmentationHistoryImageState* baseline, unsigned int maximumNumberOfDifferentialStates)
+{
+  this->Baseline = NULL;
+  this->NumberOfDifferentialStates = 0;
+  this->RunLengths.clear();
+  this->RunValues.clear();
+  this->SetDecodedImage(image);
+  int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::copy(emptyExtent, emptyExtent + 6, this->StoredExtent);
+
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  image->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      this->ImageToWorldMatrix[i * 4 + j] = imageToWorldMatrix->GetElement(i, j);
+      }
+    }
+  image->GetExtent(this->Extent);
+  this->HasScalars = (image->GetPointData()->GetScalars() != NULL);
+  if (this->HasScalars)
+    {
+    this->ScalarType = image->GetScalarType();
+    this->NumberOfComponents = image->GetNumberOfScalarComponents();
+    this->ElementSize = image->GetScalarSize() * this->NumberOfComponents;
+    }
+  this->Modified();
+
+  if (!this->HasScalars || image->IsEmpty())
+    {
+    return;
+    }
+
+  if (baseline && baseline->NumberOfDifferentialStates < maximumNumberOfDifferentialStates
+    && baseline->IsGeometryMatching(image))
+    {
+    // Find bounding box of the voxels that are different from the baseline.
+    // The baseline is usually the most recent state, which has its image decoded already.
+    vtkSmartPointer<vtkOrientedImageData> baselineImage = baseline->DecodedImage;
+    if (!baselineImage.GetPointer())
+      {
+      baselineImage = vtkSmartPointer<vtkOrientedImageData>::New();
+      baseline->GetImage(baselineImage);
+      }
+    // This state becomes the most recent one
+    baseline->ReleaseDecodedImage();
+    int changedExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    int rowLength = this->Extent[1] - this->Extent[0] + 1;
+    for (int k = this->Extent[4]; k <= this->Extent[5]; ++k)
+      {
+      for (int j = this->Extent[2]; j <= this->Extent[3]; ++j)
+        {
+        const char* row = static_cast<char*>(image->GetScalarPointer(this->Extent[0], j, k));
+        const char* baselineRow = static_cast<char*>(baselineImage->GetScalarPointer(this->Extent[0], j, k));
+        if (memcmp(row, baselineRow, rowLength * this->ElementSize) == 0)
+          {
+          continue;
+          }
+        int firstChanged = 0;
+        while (memcmp(row + firstChanged * this->ElementSize, baselineRow + firstChanged * this->ElementSize, this->ElementSize) == 0)
+          {
+          ++firstChanged;
+          }
+        int lastChanged = rowLength - 1;
+        while (memcmp(row + lastChanged * this->ElementSize, baselineRow + lastChanged * this->ElementSize, this->ElementSize) == 0)
+          {
+          --lastChanged;
+          }
+        changedExtent[0] = std::min(changedExtent[0], this->Extent[0] + firstChanged);
+        changedExtent[1] = std::max(changedExtent[1], this->Extent[0] + lastChanged);
+        changedExtent[2] = std::min(changedExtent[2], j);
+        changedExtent[3] = std::max(changedExtent[3], j);
+        changedExtent[4] = std::min(changedExtent[4], k);
+        changedExtent[5] = std::max(changedExtent[5], k);
+        }
+      }
+
+    // Only store the difference if it is substantially smaller than the full image
+    double numberOfVoxels = double(rowLength) * (this->Extent[3] - this->Extent[2] + 1) * (this->Extent[5] - this->Extent[4] + 1);
+    double numberOfChangedVoxels = 0.0;
+    if (changedExtent[0] <= changedExtent[1])
+      {
+      numberOfChangedVoxels = double(changedExtent[1] - changedExtent[0] + 1)
+        * (changedExtent[3] - changedExtent[2] + 1) * (changedExtent[5] - changedExtent[4] + 1);
+      }
+    else
+      {
+      std::copy(emptyExtent, emptyExtent + 6, changedExtent);
+      }
+    if (numberOfChangedVoxels <= numberOfVoxels / 2)
+      {
+      this->Baseline = baseline;
+      this->NumberOfDifferentialStates = baseline->NumberOfDifferentialStates + 1;
+      std::copy(changedExtent, changedExtent + 6, this->StoredExtent);
+      this->EncodeRegion(image, this->StoredExtent);
+      return;
+      }
+    }
+
+  std::copy(this->Extent, this->Extent + 6, this->StoredExtent);
+  this->EncodeRegion(image, this->StoredExtent);
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationHistoryImageState::GetImage(vtkOrientedImageData* image)
+{
+  if (this->DecodedImage.GetPointer())
+    {
+    image->DeepCopy(this->DecodedImage);
+    return;
+    }
+  if (this->Baseline)
+    {
+    // Baseline has the same geometry, so the image is allocated already
+    this->Baseline->GetImage(image);
+    }
+  else
+    {
+    image->SetExtent(this->Extent);
+    if (this->HasScalars)
+      {
+      image->AllocateScalars(this->ScalarType, this->NumberOfComponents);
+      }
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    imageToWorldMatrix->DeepCopy(this->ImageToWorldMatrix);
+    image->SetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    }
+  this->DecodeRegion(image, this->StoredExtent);
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationHistoryImageState::SetDecodedImage(vtkOrientedImageData* image)
+{
+  if (!image)
+    {
+    this->DecodedImage = NULL;
+    return;
+    }
+  this->DecodedImage = vtkSmartPointer<vtkOrientedImageData>::New();
+  this->DecodedImage->DeepCopy(image);
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationHistoryImageState::RemoveBaseline()
+{
+  if (!this->Baseline)
+    {
+    return;
+    }
+  vtkNew<vtkOrientedImageData> image;
+  this->GetImage(image.GetPointer());
+  this->Baseline = NULL;
+  this->NumberOfDifferentialStates = 0;
+  std::copy(this->Extent, this->Extent + 6, this->StoredExtent);
+  this->EncodeRegion(image.GetPointer(), this->StoredExtent);
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkSegmentationHistoryImageState::GetMemorySize()
+{
+  return static_cast<unsigned long>(sizeof(vtkSegmentationHistoryImageState)
+    + this->RunLengths.capacity() * sizeof(unsigned int) + this->RunValues.capacity());
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentationHistoryImageState::IsGeometryMatching(vtkOrientedImageData* image)
+{
+  if (!this->HasScalars || image->GetPointData()->GetScalars() == NULL
+    || this->ScalarType != image->GetScalarType()
+    || this->NumberOfComponents != image->GetNumberOfScalarComponents())
+    {
+    return false;
+    }
+  int* extent = image->GetExtent();
+  if (!std::equal(this->Extent, this->Extent + 6, extent))
+    {
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  image->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      if (this->ImageToWorldMatrix[i * 4 + j] != imageToWorldMatrix->GetElement(i, j))
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationHistoryImageState::EncodeRegion(vtkImageData* image, const int region[6])
+{
+  this->RunLengths.clear();
+  this->RunValues.clear();
+  if (region[0] > region[1] || region[2] > region[3] || region[4] > region[5])
+    {
+    return;
+    }
+  const int elementSize = this->ElementSize;
+  const char* runValue = NULL;
+  unsigned int runLength = 0;
+  for (int k = region[4]; k <= region[5]; ++k)
+    {
+    for (int j = region[2]; j <= region[3]; ++j)
+      {
+      const char* element = static_cast<char*>(image->GetScalarPointer(region[0], j, k));
+      for (int i = region[0]; i <= region[1]; ++i, element += elementSize)
+        {
+        if (runLength > 0 && runLength < VTK_UNSIGNED_INT_MAX && memcmp(element, runValue, elementSize) == 0)
+          {
+          ++runLength;
+          continue;
+          }
+        if (runLength > 0)
+          {
+          this->RunLengths.push_back(runLength);
+          this->RunValues.insert(this->RunValues.end(), runValue, runValue + elementSize);
+          }
+        runValue = element;
+        runLength = 1;
+        }
+      }
+    }
+  this->RunLengths.push_back(runLength);
+  this->RunValues.insert(this->RunValues.end(), runValue, runValue + elementSize);
+
+  // Release unused capacity
+  std::vector<unsigned int>(this->RunLengths).swap(this->RunLengths);
+  std::vector<char>(this->RunValues).swap(this->RunValues);
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentationHistoryImageState::DecodeRegion(vtkImageData* image, const int region[6])
+{
+  if (this->RunLengths.empty())
+    {
+    return;
+    }
+  const int elementSize = this->ElementSize;
+  size_t runIndex = 0;
+  unsigned int remainingRunLength = this->RunLengths[0];
+  const int rowLength = region[1] - region[0] + 1;
+  for (int k = region[4]; k <= region[5]; ++k)
+    {
+    for (int j = region[2]; j <= region[3]; ++j)
+      {
+      char* element = static_cast<char*>(image->GetScalarPointer(region[0], j, k));
+      int remainingRowLength = rowLength;
+      while (remainingRowLength > 0)
+        {
+        if (remainingRunLength == 0)
+          {
+          ++runIndex;
+          remainingRunLength = this->RunLengths[runIndex];
+          }
+        int count = static_cast<int>(std::min<unsigned int>(remainingRunLength, remainingRowLength));
+        const char* runValue = &(this->RunValues[runIndex * elementSize]);
+        if (elementSize == 1)
+          {
+          memset(element, *runValue, count);
+          element += count;
+          }
+        else
+          {
+          for (int i = 0; i < count; ++i, element += elementSize)
+            {
+            memcpy(element, runValue, elementSize);
+            }
+          }
+        remainingRunLength -= count;
+        remainingRowLength -= count;
+        }
+      }
+    }
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentationHistory);
@@ -36,7 +425,18 @@ vtkSegmentationHistory::vtkSegmentationHistory()
 {
   this->Segmentation = NULL;
 
-  this->MaximumNumberOfStates = 5;
+  this->MaximumNumberOfStates = 100;
+
+  // Number of states is limited by the memory budget, which is reduced on computers with little memory
+  this->MaximumMemorySizeInMiB = 512.0;
+  vtksys::SystemInformation systemInformation;
+  systemInformation.QueryMemory();
+  double totalPhysicalMemoryInMiB = static_cast<double>(systemInformation.GetTotalPhysicalMemory());
+  if (totalPhysicalMemoryInMiB > 0.0 && totalPhysicalMemoryInMiB / 16.0 < this->MaximumMemorySizeInMiB)
+    {
+    this->MaximumMemorySizeInMiB = totalPhysicalMemoryInMiB / 16.0;
+    }
+  this->MaximumNumberOfDifferentialStates = 10;
 
   this->LastRestoredState = 0;
   this->RestoreStateInProgress = false;
@@ -95,6 +495,9 @@ void vtkSegmentationHistory::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Modified Time: " << this->GetMTime() << "\n";
 
   os << indent << "Number of saved states:  " << this->SegmentationStates.size() << "\n";
+  os << indent << "MaximumNumberOfStates:  " << this->MaximumNumberOfStates << "\n";
+  os << indent << "MaximumMemorySizeInMiB:  " << this->MaximumMemorySizeInMiB << "\n";
+  os << indent << "MaximumNumberOfDifferentialStates:  " << this->MaximumNumberOfDifferentialStates << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -130,19 +533,25 @@ bool vtkSegmentationHistory::SaveState()
     // Previous saved state of the segment
     // (if the new state has exactly the same representation then only a shallow copy will be made)
     vtkSegment* baselineSegment = NULL;
+    ImageStatesMap* baselineImages = NULL;
     if (this->SegmentationStates.size() > 0)
       {
-      SegmentsMap::iterator baselineSegmentIt = this->SegmentationStates.back().Segments.find(*segmentIDIt);
-      if (baselineSegmentIt != this->SegmentationStates.back().Segments.end())
+      SegmentationState& baselineState = this->SegmentationStates.back();
+      SegmentsMap::iterator baselineSegmentIt = baselineState.Segments.find(*segmentIDIt);
+      if (baselineSegmentIt != baselineState.Segments.end())
         {
         baselineSegment = baselineSegmentIt->second.GetPointer();
+        baselineImages = &(baselineState.SegmentImages[*segmentIDIt]);
         }
       }
     vtkSmartPointer<vtkSegment> segmentClone = vtkSmartPointer<vtkSegment>::New();
-    CopySegment(segmentClone, segment, baselineSegment);
+    CopySegment(segmentClone, newSegmentationState.SegmentImages[*segmentIDIt], segment, *segmentIDIt,
+      baselineSegment, baselineImages);
     newSegmentationState.Segments[*segmentIDIt] = segmentClone;
     }
   this->SegmentationStates.push_back(newSegmentationState);
+  // Only the new state is kept decoded, as the next state will be compared to it
+  this->ReleaseDecodedImages(this->SegmentationStates.size() - 1);
 
   // Set the current state as last restored state
   this->LastRestoredState = (unsigned int)this->SegmentationStates.size();
@@ -153,18 +562,72 @@ bool vtkSegmentationHistory::SaveState()
 }
 
 //---------------------------------------------------------------------------
-void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline)
+void vtkSegmentationHistory::CopySegment(vtkSegment* destination, ImageStatesMap& destinationImages, vtkSegment* source,
+  const std::string& sourceSegmentId, vtkSegment* baseline, ImageStatesMap* baselineImages)
 {
   destination->RemoveAllRepresentations();
   destination->DeepCopyMetadata(source);
+  destinationImages.clear();
 
   // Copy representations
+  std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
   std::vector<std::string> representationNames;
   source->GetContainedRepresentationNames(representationNames);
   for (std::vector<std::string>::iterator representationNameIt = representationNames.begin();
     representationNameIt != representationNames.end(); ++representationNameIt)
     {
-    vtkDataObject* sourceRepresentation = source->GetRepresentation(*representationNameIt);
+    vtkDataObject* sourceRepresentation = NULL;
+    vtkSmartPointer<vtkOrientedImageData> sourceImage;
+    vtkMTimeType sourceMTime = 0;
+    bool binaryLabelmap = (*representationNameIt == binaryLabelmapName);
+    if (binaryLabelmap)
+      {
+      // Binary labelmap may be stored in a shared labelmap layer, which must not be split up for saving the state.
+      // Voxels are only extracted if the labelmap changed since the baseline.
+      sourceMTime = this->Segmentation->GetSegmentBinaryLabelmapMTime(sourceSegmentId);
+      }
+    else
+      {
+      sourceRepresentation = source->GetRepresentation(*representationNameIt);
+      sourceImage = vtkOrientedImageData::SafeDownCast(sourceRepresentation);
+      sourceMTime = (sourceRepresentation ? sourceRepresentation->GetMTime() : 0);
+      }
+
+    // Image representations are stored compressed
+    if (sourceImage.GetPointer() || binaryLabelmap)
+      {
+      vtkSegmentationHistoryImageState* baselineImage = NULL;
+      if (baselineImages)
+        {
+        ImageStatesMap::iterator baselineImageIt = baselineImages->find(*representationNameIt);
+        if (baselineImageIt != baselineImages->end())
+          {
+          baselineImage = baselineImageIt->second;
+          }
+        }
+      if (baselineImage != NULL && baselineImage->GetMTime() > sourceMTime)
+        {
+        // we already have an up-to-date copy in the baseline, so reuse that
+        destinationImages[*representationNameIt] = baselineImage;
+        }
+      else
+        {
+        if (!sourceImage.GetPointer())
+          {
+          sourceImage = vtkSmartPointer<vtkOrientedImageData>::New();
+          if (!this->Segmentation->GetSegmentBinaryLabelmap(sourceSegmentId, sourceImage))
+            {
+            vtkErrorMacro("CopySegment: Failed to get binary labelmap of segment " << sourceSegmentId);
+            continue;
+            }
+          }
+        vtkSmartPointer<vtkSegmentationHistoryImageState> imageState = vtkSmartPointer<vtkSegmentationHistoryImageState>::New();
+        imageState->SetImage(sourceImage, baselineImage, this->MaximumNumberOfDifferentialStates);
+        destinationImages[*representationNameIt] = imageState;
+        }
+      continue;
+      }
+
     vtkDataObject* baselineRepresentation = NULL;
     if (baseline)
       {
@@ -220,6 +683,11 @@ bool vtkSegmentationHistory::RestorePreviousState()
     // this->SegmentationStates.size() - 1 is the state that we've just saved
     // this->SegmentationStates.size() - 2 is the state that was the last saved state before
     stateToRestore = (int)this->SegmentationStates.size() - 2;
+    if (stateToRestore < 0)
+      {
+      vtkWarningMacro("vtkSegmentation::RestorePreviousState failed: previous state was removed because of memory limit");
+      return false;
+      }
     }
   return this->RestoreState(stateToRestore);
 }
@@ -246,23 +714,35 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
   this->RestoreStateInProgress = true;
 
   SegmentationState restoredState = this->SegmentationStates[stateIndex];
+  this->ReleaseDecodedImages(stateIndex);
 
   std::set<std::string> segmentIDsToKeep;
   for (SegmentsMap::iterator restoredSegmentsIt = restoredState.Segments.begin();
     restoredSegmentsIt != restoredState.Segments.end(); ++restoredSegmentsIt)
     {
     segmentIDsToKeep.insert(restoredSegmentsIt->first);
+    // Reconstruct compressed image representations
+    vtkSmartPointer<vtkSegment> restoredSegment = vtkSmartPointer<vtkSegment>::New();
+    restoredSegment->DeepCopy(restoredSegmentsIt->second);
+    ImageStatesMap& restoredImages = restoredState.SegmentImages[restoredSegmentsIt->first];
+    for (ImageStatesMap::iterator imageIt = restoredImages.begin(); imageIt != restoredImages.end(); ++imageIt)
+      {
+      vtkSmartPointer<vtkOrientedImageData> image = vtkSmartPointer<vtkOrientedImageData>::New();
+      imageIt->second->GetImage(image);
+      // Keep the decoded image, as the state saved after the next edit will be compared to it
+      imageIt->second->SetDecodedImage(image);
+      restoredSegment->AddRepresentation(imageIt->first, image);
+      }
+
     vtkSegment* segment = this->Segmentation->GetSegment(restoredSegmentsIt->first);
     if (segment != NULL)
       {
-      segment->DeepCopy(restoredSegmentsIt->second);
+      segment->DeepCopy(restoredSegment);
       segment->Modified();
       }
     else
       {
-      vtkSmartPointer<vtkSegment> newSegment = vtkSmartPointer<vtkSegment>::New();
-      newSegment->DeepCopy(restoredSegmentsIt->second);
-      this->Segmentation->AddSegment(newSegment);
+      this->Segmentation->AddSegment(restoredSegment, restoredSegmentsIt->first);
       }
     }
 
@@ -281,6 +761,9 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
 
   this->Segmentation->ReorderSegments(restoredState.SegmentIds);
 
+  // Restored binary labelmaps are stored in the shared labelmap layers again (if the segmentation uses them)
+  this->Segmentation->CollapseBinaryLabelmaps();
+
   this->LastRestoredState = stateIndex;
 
   this->RestoreStateInProgress = false;
@@ -328,16 +811,156 @@ void vtkSegmentationHistory::RemoveAllObsoleteStates()
   bool modified = false;
   while ((this->SegmentationStates.size() > this->MaximumNumberOfStates) && (!this->SegmentationStates.empty()))
     {
-    this->SegmentationStates.pop_front();
-    this->LastRestoredState--;
+    this->RemoveOldestState();
     modified = true;
-   }
+    }
+  if (this->MaximumMemorySizeInMiB > 0)
+    {
+    // Sum up memory usage starting from the most recent state (which is always kept)
+    // and keep as many states as fit into the memory budget.
+    std::set<vtkObject*> countedObjects;
+    double memorySizeInBytes = 0.0;
+    size_t numberOfStatesToKeep = 0;
+    for (std::deque<SegmentationState>::reverse_iterator stateIt = this->SegmentationStates.rbegin();
+      stateIt != this->SegmentationStates.rend(); ++stateIt)
+      {
+      memorySizeInBytes += this->GetStateMemorySize(*stateIt, countedObjects);
+      if (numberOfStatesToKeep > 0 && memorySizeInBytes > this->MaximumMemorySizeInMiB * 1024.0 * 1024.0)
+        {
+        break;
+        }
+      ++numberOfStatesToKeep;
+      }
+    if (this->SegmentationStates.size() > numberOfStatesToKeep)
+      {
+      while (this->SegmentationStates.size() > numberOfStatesToKeep)
+        {
+        this->RemoveOldestState();
+        }
+      // The new oldest state may have grown by storing its images self-contained
+      while (this->SegmentationStates.size() > 1 && this->GetMemorySizeInMiB() > this->MaximumMemorySizeInMiB)
+        {
+        this->RemoveOldestState();
+        }
+      modified = true;
+      }
+    }
   if (modified)
     {
     this->Modified();
     }
 }
 
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::RemoveOldestState()
+{
+  if (this->SegmentationStates.empty())
+    {
+    return;
+    }
+  this->SegmentationStates.pop_front();
+  if (this->LastRestoredState > 0)
+    {
+    this->LastRestoredState--;
+    }
+  if (this->SegmentationStates.empty())
+    {
+    return;
+    }
+
+  // Images of the new oldest state must not depend on the removed state
+  SegmentationState& oldestState = this->SegmentationStates.front();
+  for (std::map<std::string, ImageStatesMap>::iterator segmentImagesIt = oldestState.SegmentImages.begin();
+    segmentImagesIt != oldestState.SegmentImages.end(); ++segmentImagesIt)
+    {
+    for (ImageStatesMap::iterator imageIt = segmentImagesIt->second.begin(); imageIt != segmentImagesIt->second.end(); ++imageIt)
+      {
+      imageIt->second->RemoveBaseline();
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+double vtkSegmentationHistory::GetMemorySizeInMiB()
+{
+  // Count each stored object only once, as unchanged representations are shared between states
+  std::set<vtkObject*> countedObjects;
+  double memorySizeInBytes = 0.0;
+  for (std::deque<SegmentationState>::iterator stateIt = this->SegmentationStates.begin();
+    stateIt != this->SegmentationStates.end(); ++stateIt)
+    {
+    memorySizeInBytes += this->GetStateMemorySize(*stateIt, countedObjects);
+    }
+  return memorySizeInBytes / (1024.0 * 1024.0);
+}
+
+//---------------------------------------------------------------------------
+double vtkSegmentationHistory::GetStateMemorySize(SegmentationState& state, std::set<vtkObject*>& countedObjects)
+{
+  double memorySizeInBytes = 0.0;
+  for (std::map<std::string, ImageStatesMap>::iterator segmentImagesIt = state.SegmentImages.begin();
+    segmentImagesIt != state.SegmentImages.end(); ++segmentImagesIt)
+    {
+    for (ImageStatesMap::iterator imageIt = segmentImagesIt->second.begin(); imageIt != segmentImagesIt->second.end(); ++imageIt)
+      {
+      for (vtkSegmentationHistoryImageState* imageState = imageIt->second;
+        imageState && countedObjects.insert(imageState).second; imageState = imageState->GetBaseline())
+        {
+        memorySizeInBytes += imageState->GetMemorySize();
+        }
+      }
+    }
+  for (SegmentsMap::iterator segmentIt = state.Segments.begin(); segmentIt != state.Segments.end(); ++segmentIt)
+    {
+    std::vector<std::string> representationNames;
+    segmentIt->second->GetContainedRepresentationNames(representationNames);
+    for (std::vector<std::string>::iterator representationNameIt = representationNames.begin();
+      representationNameIt != representationNames.end(); ++representationNameIt)
+      {
+      vtkDataObject* representation = segmentIt->second->GetRepresentation(*representationNameIt);
+      if (representation && countedObjects.insert(representation).second)
+        {
+        memorySizeInBytes += representation->GetActualMemorySize() * 1024.0;
+        }
+      }
+    }
+  return memorySizeInBytes;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::ReleaseDecodedImages(size_t keptStateIndex)
+{
+  // Unchanged images are shared between states, images of the kept state must not be released
+  std::set<vtkSegmentationHistoryImageState*> keptImages;
+  if (keptStateIndex < this->SegmentationStates.size())
+    {
+    SegmentationState& keptState = this->SegmentationStates[keptStateIndex];
+    for (std::map<std::string, ImageStatesMap>::iterator segmentImagesIt = keptState.SegmentImages.begin();
+      segmentImagesIt != keptState.SegmentImages.end(); ++segmentImagesIt)
+      {
+      for (ImageStatesMap::iterator imageIt = segmentImagesIt->second.begin(); imageIt != segmentImagesIt->second.end(); ++imageIt)
+        {
+        keptImages.insert(imageIt->second);
+        }
+      }
+    }
+  for (std::deque<SegmentationState>::iterator stateIt = this->SegmentationStates.begin();
+    stateIt != this->SegmentationStates.end(); ++stateIt)
+    {
+    for (std::map<std::string, ImageStatesMap>::iterator segmentImagesIt = stateIt->SegmentImages.begin();
+      segmentImagesIt != stateIt->SegmentImages.end(); ++segmentImagesIt)
+      {
+      for (ImageStatesMap::iterator imageIt = segmentImagesIt->second.begin(); imageIt != segmentImagesIt->second.end(); ++imageIt)
+        {
+        if (keptImages.find(imageIt->second) == keptImages.end())
+          {
+          imageIt->second->ReleaseDecodedImage();
+          }
+        }
+      }
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkSegmentationHistory::SetMaximumNumberOfStates(unsigned int maximumNumberOfStates)
 {
@@ -350,6 +973,18 @@ void vtkSegmentationHistory::SetMaximumNumberOfStates(unsigned int maximumNumber
   this->Modified();
 }
 
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::SetMaximumMemorySizeInMiB(double maximumMemorySizeInMiB)
+{
+  if (maximumMemorySizeInMiB == this->MaximumMemorySizeInMiB)
+    {
+    return;
+    }
+  this->MaximumMemorySizeInMiB = maximumMemorySizeInMiB;
+  this->RemoveAllObsoleteStates();
+  this->Modified();
+}
+
 //---------------------------------------------------------------------------
 void vtkSegmentationHistory::OnSegmentationModified(vtkObject* vtkNotUsed(caller),
   unsigned long vtkNotUsed(eid),
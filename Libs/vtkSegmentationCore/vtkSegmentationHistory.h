@@ -28,15 +28,24 @@
 // STD includes
 #include <deque>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "vtkSegmentationCoreConfigure.h"
 
 class vtkCallbackCommand;
+class vtkOrientedImageData;
 class vtkSegment;
 class vtkSegmentation;
+class vtkSegmentationHistoryImageState;
 
 /// \ingroup SegmentationCore
+/// \brief Stores undo/redo states of a segmentation.
+///
+/// Image representations (binary labelmaps) are stored run-length encoded. If a labelmap has the same
+/// geometry as in the previous state then only the region that changed since the previous state
+/// is stored. States are discarded, starting from the oldest, if either the maximum number of states
+/// or the memory budget is exceeded.
 class vtkSegmentationCore_EXPORT vtkSegmentationHistory : public vtkObject
 {
 public:
@@ -77,11 +86,29 @@ public:
 
   /// Limits how many states may be stored.
   /// If the number of stored states exceed the limit then the oldest state is removed.
+  /// Default is 100. Memory usage is limited by MaximumMemorySizeInMiB.
   void SetMaximumNumberOfStates(unsigned int maximumNumberOfStates);
 
   /// Get the limit of how many states may be stored.
   vtkGetMacro(MaximumNumberOfStates, unsigned int);
 
+  /// Limits how much memory the stored states may use.
+  /// If the limit is exceeded then the oldest states are removed (the most recent state is always kept).
+  /// Set to 0 for no limit. Default is 512 MiB, or 1/16 of the physical memory if that is less.
+  void SetMaximumMemorySizeInMiB(double maximumMemorySizeInMiB);
+
+  /// Get the limit of how much memory the stored states may use.
+  vtkGetMacro(MaximumMemorySizeInMiB, double);
+
+  /// Get memory used by all stored states, in MiB.
+  /// Data shared between states is only counted once.
+  double GetMemorySizeInMiB();
+
+  /// Limits how many consecutive states may store only the changes compared to the previous state.
+  /// Higher value reduces memory usage but makes restoring older states slower. Default is 10.
+  vtkSetMacro(MaximumNumberOfDifferentialStates, unsigned int);
+  vtkGetMacro(MaximumNumberOfDifferentialStates, unsigned int);
+
 protected:
   /// Callback function called when the segmentation has been modified.
   /// It clears all states that are more recent than the last restored state.
@@ -91,8 +118,13 @@ protected:
   void RemoveAllNextStates();
 
   /// Delete all old states so that we keep only up to MaximumNumberOfStates states
+  /// and stay within MaximumMemorySizeInMiB
   void RemoveAllObsoleteStates();
 
+  /// Remove the oldest state. Stored images of the next state that only contain changes
+  /// compared to the removed state are converted to self-contained images.
+  void RemoveOldestState();
+
   /// Restores a state defined by stateIndex.
   bool RestoreState(unsigned int stateIndex);
 
@@ -101,9 +133,17 @@ protected:
   ~vtkSegmentationHistory();
   void operator=(const vtkSegmentationHistory&);
 
+  /// Container type for compressed image representations. Maps representation names to stored images
+  typedef std::map<std::string, vtkSmartPointer<vtkSegmentationHistoryImageState> > ImageStatesMap;
+
   /// Deep copies source segment to destination segment. If the same representation is found in baseline
   /// with up-to-date timestamp then the representation is reused from baseline.
-  void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline);
+  /// Image representations are stored compressed in destinationImages instead of the destination segment,
+  /// only storing changes compared to the baseline image if possible.
+  /// Binary labelmap of the source is read from the segmentation, without moving it out of
+  /// the shared labelmap layers (see vtkSegmentation::GetSegmentBinaryLabelmap).
+  void CopySegment(vtkSegment* destination, ImageStatesMap& destinationImages, vtkSegment* source,
+    const std::string& sourceSegmentId, vtkSegment* baseline, ImageStatesMap* baselineImages);
 
 protected:  /// Container type for segments. Maps segment IDs to segment objects
   typedef std::map<std::string, vtkSmartPointer<vtkSegment> > SegmentsMap;
@@ -111,13 +151,24 @@ protected:  /// Container type for segments. Maps segment IDs to segment objects
   struct SegmentationState
     {
     SegmentsMap Segments;
+    std::map<std::string, ImageStatesMap> SegmentImages; // compressed image representations of segments
     std::vector<std::string> SegmentIds; // order of segments
     };
 
+  /// Get memory used by a state in bytes. Objects that are in countedObjects are skipped
+  /// and counted objects are added to it, so that data shared between states is counted once.
+  double GetStateMemorySize(SegmentationState& state, std::set<vtkObject*>& countedObjects);
+
+  /// Release decoded image copies of all states except the specified one.
+  /// Only the state that the next saved state will be compared to keeps its images decoded.
+  void ReleaseDecodedImages(size_t keptStateIndex);
+
   vtkSegmentation* Segmentation;
   vtkCallbackCommand* SegmentationModifiedCallbackCommand;
   std::deque<SegmentationState> SegmentationStates;
   unsigned int MaximumNumberOfStates;
+  double MaximumMemorySizeInMiB;
+  unsigned int MaximumNumberOfDifferentialStates;
 
   // Index of the state in SegmentationStates that was restored last.
   // If index == size of states then it means that the segmentation has changed
@@ -0,0 +1,214 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include "vtkTeemNRRDReader.h"
+#include "vtkTeemNRRDWriter.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Create a short volume with smooth gradients and some noise, compressible
+/// about as well as a typical medical image.
+void CreateVolume(int size, vtkImageData* volume)
+{
+  volume->SetDimensions(size, size, size / 2 + 16);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(volume->GetScalarPointer());
+  int* dimensions = volume->GetDimensions();
+  unsigned int seed = 1;
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i, ++ptr)
+        {
+        seed = seed * 1103515245 + 12345;
+        *ptr = static_cast<short>(i + 2 * j - 3 * k + ((seed >> 16) & 0x7));
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool AreVolumesEqual(vtkImageData* volume1, vtkImageData* volume2)
+{
+  vtkIdType numberOfVoxels = volume1->GetNumberOfPoints();
+  if (volume2->GetNumberOfPoints() != numberOfVoxels
+    || volume1->GetScalarType() != VTK_SHORT
+    || volume2->GetScalarType() != VTK_SHORT)
+    {
+    return false;
+    }
+  short* ptr1 = static_cast<short*>(volume1->GetScalarPointer());
+  short* ptr2 = static_cast<short*>(volume2->GetScalarPointer());
+  return std::equal(ptr1, ptr1 + numberOfVoxels, ptr2);
+}
+
+//----------------------------------------------------------------------------
+bool WriteVolume(vtkImageData* volume, const std::string& fileName,
+                 int compressionLevel, int numberOfThreads)
+{
+  vtkNew<vtkTeemNRRDWriter> writer;
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(volume);
+  writer->SetUseCompression(1);
+  writer->SetCompressionLevel(compressionLevel);
+  writer->SetNumberOfCompressionThreads(numberOfThreads);
+  writer->Write();
+  return !writer->GetWriteError();
+}
+
+//----------------------------------------------------------------------------
+bool ReadAndCompare(vtkImageData* volume, const std::string& fileName, int numberOfThreads)
+{
+  vtkNew<vtkTeemNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->SetNumberOfDecompressionThreads(numberOfThreads);
+  reader->Update();
+  if (!AreVolumesEqual(volume, reader->GetOutput()))
+    {
+    std::cerr << "Volume read from " << fileName << " with " << numberOfThreads
+              << " thread(s) is different from the written volume" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestRoundTrip(const std::string& tempDir)
+{
+  // large enough to be compressed in several blocks
+  vtkNew<vtkImageData> volume;
+  CreateVolume(128, volume.GetPointer());
+
+  // block compressed file must be readable by teem and by blocks
+  std::string blockFileName = tempDir + "/vtkTeemNRRDWriterTest1_block.nrrd";
+  if (!WriteVolume(volume.GetPointer(), blockFileName, 1, 4)
+    || !ReadAndCompare(volume.GetPointer(), blockFileName, 1)
+    || !ReadAndCompare(volume.GetPointer(), blockFileName, 4))
+    {
+    return false;
+    }
+
+  // file compressed by teem must still be readable with multiple threads
+  std::string teemFileName = tempDir + "/vtkTeemNRRDWriterTest1_teem.nrrd";
+  if (!WriteVolume(volume.GetPointer(), teemFileName, -1, 1)
+    || !ReadAndCompare(volume.GetPointer(), teemFileName, 4))
+    {
+    return false;
+    }
+
+  vtksys::SystemTools::RemoveFile(blockFileName.c_str());
+  vtksys::SystemTools::RemoveFile(teemFileName.c_str());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool RunBenchmark(const std::string& tempDir, int size)
+{
+  vtkNew<vtkImageData> volume;
+  CreateVolume(size, volume.GetPointer());
+  double sizeMiB = volume->GetActualMemorySize() / 1024.0;
+  std::string fileName = tempDir + "/vtkTeemNRRDWriterTest1_benchmark.nrrd";
+
+  const int compressionLevels[3] = { 1, 6, 9 };
+  const int numberOfThreads[3] = { 1, 4, 8 };
+  vtkNew<vtkTimerLog> timer;
+  for (int levelIndex = 0; levelIndex < 3; ++levelIndex)
+    {
+    for (int threadIndex = 0; threadIndex < 3; ++threadIndex)
+      {
+      int level = compressionLevels[levelIndex];
+      int threads = numberOfThreads[threadIndex];
+      timer->StartTimer();
+      if (!WriteVolume(volume.GetPointer(), fileName, level, threads))
+        {
+        std::cerr << "Failed to write " << fileName << std::endl;
+        return false;
+        }
+      timer->StopTimer();
+      double writeTime = timer->GetElapsedTime();
+      timer->StartTimer();
+      if (!ReadAndCompare(volume.GetPointer(), fileName, threads))
+        {
+        return false;
+        }
+      timer->StopTimer();
+      double readTime = timer->GetElapsedTime();
+      double ratio = sizeMiB * 1024.0 * 1024.0 / vtksys::SystemTools::FileLength(fileName);
+
+      std::cout << "Level " << level << ", " << threads << " thread(s): write "
+                << sizeMiB / writeTime << " MiB/s, read " << sizeMiB / readTime
+                << " MiB/s, ratio " << ratio << std::endl;
+      std::cout << "<DartMeasurement name=\"vtkTeemNRRDWriter-WriteMiBPerSecond-L" << level
+                << "-T" << threads << "\" type=\"numeric/double\">" << sizeMiB / writeTime
+                << "</DartMeasurement>" << std::endl;
+      std::cout << "<DartMeasurement name=\"vtkTeemNRRDWriter-ReadMiBPerSecond-L" << level
+                << "-T" << threads << "\" type=\"numeric/double\">" << sizeMiB / readTime
+                << "</DartMeasurement>" << std::endl;
+      }
+    }
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTeemNRRDWriterTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp [benchmark volume size...]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  if (!TestRoundTrip(tempDir))
+    {
+    std::cerr << __LINE__ << ": NRRD compression round trip failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark volume sizes are specified in the remaining arguments
+  for (int argIndex = 2; argIndex < argc; ++argIndex)
+    {
+    if (!RunBenchmark(tempDir, atoi(argv[argIndex])))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "NRRD writer test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
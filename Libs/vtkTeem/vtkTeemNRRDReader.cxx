@@ -39,19 +39,28 @@
 #include "vtkIntArray.h"
 #include "vtkLongArray.h"
 #include "vtkMath.h"
+#include <vtkMultiThreader.h>
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkShortArray.h"
+#include <vtkSimpleMutexLock.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include "vtkUnsignedCharArray.h"
 #include "vtkUnsignedShortArray.h"
 #include "vtkUnsignedIntArray.h"
 #include "vtkUnsignedLongArray.h"
 #include <vtksys/SystemTools.hxx>
+#include <vtk_zlib.h>
 
 // Teem includes
 #include "teem/ten.h"
 
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
 vtkStandardNewMacro(vtkTeemNRRDReader);
 
 //----------------------------------------------------------------------------
@@ -66,6 +75,7 @@ vtkTeemNRRDReader::vtkTeemNRRDReader()
   this->PointDataType = -1;
   this->DataType = -1;
   this->NumberOfComponents = -1;
+  this->NumberOfDecompressionThreads = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -913,9 +923,16 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
     return;
     }
 
+  int numberOfThreads = this->NumberOfDecompressionThreads;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+
   // Read in the this->nrrd.  Yes, this means that the header is being read
   // twice: once by ExecuteInformation, and once here
-  if ( nrrdLoad(this->nrrd, this->GetFileName(), NULL) != 0 )
+  if ( !(numberOfThreads > 1 && this->ReadBlockGzipData(numberOfThreads))
+    && nrrdLoad(this->nrrd, this->GetFileName(), NULL) != 0 )
     {
     char *err =  biffGetDone(NRRD); // would be nice to free(err)
     vtkErrorMacro("Read: Error reading " << this->GetFileName() << ":\n" << err);
@@ -1098,8 +1115,271 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
   nrrdEmpty(this->nrrd);
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+struct BlockGunzipThreadData
+{
+  const unsigned char* CompressedData;
+  std::vector<size_t> CompressedBlockOffsets;
+  std::vector<size_t> CompressedBlockSizes;
+  unsigned char* Data;
+  size_t DataSize;
+  size_t BlockSize;
+  std::vector<uLong> BlockCRCs;
+  int NextBlock;
+  bool Failed;
+  vtkSimpleMutexLock* Lock;
+};
+
+//----------------------------------------------------------------------------
+unsigned long ReadLittleEndian(const unsigned char* buffer, int numberOfBytes)
+{
+  unsigned long value = 0;
+  for (int i = numberOfBytes - 1; i >= 0; --i)
+    {
+    value = (value << 8) | buffer[i];
+    }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE BlockGunzipThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  BlockGunzipThreadData* threadData = static_cast<BlockGunzipThreadData*>(threadInfo->UserData);
+  int numberOfBlocks = static_cast<int>(threadData->BlockCRCs.size());
+  while (true)
+    {
+    threadData->Lock->Lock();
+    int block = threadData->NextBlock++;
+    bool failed = threadData->Failed;
+    threadData->Lock->Unlock();
+    if (block >= numberOfBlocks || failed)
+      {
+      break;
+      }
+    size_t offset = block * threadData->BlockSize;
+    size_t length = std::min(threadData->BlockSize, threadData->DataSize - offset);
+
+    // each block is an independent raw deflate stream
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    bool success = (inflateInit2(&stream, -MAX_WBITS) == Z_OK);
+    if (success)
+      {
+      stream.next_in = const_cast<Bytef*>(threadData->CompressedData
+        + threadData->CompressedBlockOffsets[block]);
+      stream.avail_in = static_cast<uInt>(threadData->CompressedBlockSizes[block]);
+      stream.next_out = threadData->Data + offset;
+      stream.avail_out = static_cast<uInt>(length);
+      int res = inflate(&stream, Z_SYNC_FLUSH);
+      success = (res == Z_OK || res == Z_STREAM_END || res == Z_BUF_ERROR)
+        && stream.total_out == length;
+      inflateEnd(&stream);
+      }
+    if (!success)
+      {
+      threadData->Lock->Lock();
+      threadData->Failed = true;
+      threadData->Lock->Unlock();
+      break;
+      }
+    threadData->BlockCRCs[block] = crc32(crc32(0L, Z_NULL, 0),
+      threadData->Data + offset, static_cast<uInt>(length));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDReader::ReadBlockGzipData(int numberOfThreads)
+{
+  std::ifstream file(this->GetFileName(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    {
+    return false;
+    }
+
+  // Only attached headers with gzip encoding and the data right after the
+  // header can be read here, everything else is left to teem.
+  bool gzipEncoding = false;
+  bool headerEnd = false;
+  std::string line;
+  for (int lineIndex = 0; !headerEnd && std::getline(file, line); ++lineIndex)
+    {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      {
+      line.resize(line.size() - 1);
+      }
+    if (lineIndex == 0)
+      {
+      if (line.compare(0, 4, "NRRD") != 0)
+        {
+        return false;
+        }
+      continue;
+      }
+    if (line.empty())
+      {
+      headerEnd = true;
+      continue;
+      }
+    if (line[0] == '#' || line.find(":=") != std::string::npos)
+      {
+      // comment or key/value pair
+      continue;
+      }
+    size_t separator = line.find(": ");
+    if (separator == std::string::npos)
+      {
+      return false;
+      }
+    std::string field;
+    for (size_t i = 0; i < separator; ++i)
+      {
+      if (line[i] != ' ')
+        {
+        field += static_cast<char>(tolower(line[i]));
+        }
+      }
+    std::string value = vtksys::SystemTools::LowerCase(line.substr(separator + 2));
+    if (field == "datafile" || field == "lineskip" || field == "byteskip")
+      {
+      return false;
+      }
+    if (field == "encoding")
+      {
+      gzipEncoding = (value == "gzip" || value == "gz");
+      }
+    }
+  if (!headerEnd || !gzipEncoding)
+    {
+    return false;
+    }
+
+  // gzip header, the block sizes are stored in the "SL" extra subfield
+  unsigned char gzipHeader[12];
+  if (!file.read(reinterpret_cast<char*>(gzipHeader), 12)
+    || gzipHeader[0] != 0x1f || gzipHeader[1] != 0x8b || gzipHeader[2] != Z_DEFLATED
+    || gzipHeader[3] != 0x04 /* FEXTRA only */)
+    {
+    return false;
+    }
+  std::vector<unsigned char> extraField(ReadLittleEndian(gzipHeader + 10, 2));
+  if (extraField.empty()
+    || !file.read(reinterpret_cast<char*>(&extraField[0]), extraField.size()))
+    {
+    return false;
+    }
+  const unsigned char* blockSizes = NULL;
+  size_t blockSizesLength = 0;
+  for (size_t position = 0; position + 4 <= extraField.size(); )
+    {
+    size_t subfieldLength = ReadLittleEndian(&extraField[position + 2], 2);
+    if (position + 4 + subfieldLength > extraField.size())
+      {
+      break;
+      }
+    if (extraField[position] == 'S' && extraField[position + 1] == 'L')
+      {
+      blockSizes = &extraField[position + 4];
+      blockSizesLength = subfieldLength;
+      break;
+      }
+    position += 4 + subfieldLength;
+    }
+  if (blockSizes == NULL || blockSizesLength < 8 || blockSizesLength % 4 != 0)
+    {
+    return false;
+    }
+
+  Nrrd* blockNrrd = nrrdNew();
+  NrrdIoState *nio = nrrdIoStateNew();
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  if (nrrdLoad(blockNrrd, this->GetFileName(), nio) != 0 || nio->encoding != nrrdEncodingGzip)
+    {
+    biffDone(NRRD);
+    nrrdIoStateNix(nio);
+    nrrdNuke(blockNrrd);
+    return false;
+    }
+  int endian = nio->endian;
+  nrrdIoStateNix(nio);
+
+  BlockGunzipThreadData threadData;
+  threadData.DataSize = nrrdElementNumber(blockNrrd) * nrrdElementSize(blockNrrd);
+  threadData.BlockSize = ReadLittleEndian(blockSizes, 4);
+  size_t numberOfBlocks = blockSizesLength / 4 - 1;
+  if (threadData.BlockSize == 0 || threadData.DataSize == 0
+    || (threadData.DataSize + threadData.BlockSize - 1) / threadData.BlockSize != numberOfBlocks)
+    {
+    nrrdNuke(blockNrrd);
+    return false;
+    }
+  size_t compressedSize = 0;
+  for (size_t block = 0; block < numberOfBlocks; ++block)
+    {
+    threadData.CompressedBlockOffsets.push_back(compressedSize);
+    threadData.CompressedBlockSizes.push_back(ReadLittleEndian(blockSizes + 4 * (block + 1), 4));
+    compressedSize += threadData.CompressedBlockSizes.back();
+    }
+
+  // compressed blocks followed by the CRC32 and ISIZE trailer
+  std::vector<unsigned char> compressedData(compressedSize + 8);
+  blockNrrd->data = malloc(threadData.DataSize);
+  if (blockNrrd->data == NULL
+    || !file.read(reinterpret_cast<char*>(&compressedData[0]), compressedData.size()))
+    {
+    nrrdNuke(blockNrrd);
+    return false;
+    }
+  file.close();
+
+  threadData.CompressedData = &compressedData[0];
+  threadData.Data = static_cast<unsigned char*>(blockNrrd->data);
+  threadData.BlockCRCs.resize(numberOfBlocks);
+  threadData.NextBlock = 0;
+  threadData.Failed = false;
+  vtkNew<vtkSimpleMutexLock> lock;
+  threadData.Lock = lock.GetPointer();
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(numberOfThreads, static_cast<int>(numberOfBlocks)));
+  threader->SetSingleMethod(BlockGunzipThreadFunction, &threadData);
+  threader->SingleMethodExecute();
+
+  uLong crc = crc32(0L, Z_NULL, 0);
+  for (size_t block = 0; block < numberOfBlocks && !threadData.Failed; ++block)
+    {
+    size_t length = std::min(threadData.BlockSize, threadData.DataSize - block * threadData.BlockSize);
+    crc = crc32_combine(crc, threadData.BlockCRCs[block], static_cast<z_off_t>(length));
+    }
+  if (threadData.Failed
+    || ReadLittleEndian(&compressedData[compressedSize], 4) != (crc & 0xffffffffUL)
+    || ReadLittleEndian(&compressedData[compressedSize + 4], 4) != (threadData.DataSize & 0xffffffffUL))
+    {
+    vtkWarningMacro("ReadBlockGzipData: invalid compressed blocks in " << this->GetFileName()
+      << ", decompressing the file on a single thread");
+    nrrdNuke(blockNrrd);
+    return false;
+    }
+
+  if (endian != airEndianUnknown && endian != airMyEndian())
+    {
+    nrrdSwapEndian(blockNrrd);
+    }
+
+  nrrdNuke(this->nrrd);
+  this->nrrd = blockNrrd;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkTeemNRRDReader::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+  os << indent << "NumberOfDecompressionThreads: " << this->NumberOfDecompressionThreads << "\n";
 }
@@ -132,6 +132,15 @@ public:
   vtkSetMacro(NumberOfComponents,int);
   vtkGetMacro(NumberOfComponents,int);
 
+  ///
+  /// Number of threads used for decompressing the data of files written by
+  /// vtkTeemNRRDWriter with block compression. Other files are always read
+  /// on a single thread by teem.
+  /// 0 (default) uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads(),
+  /// 1 disables the multi-threaded decompression.
+  vtkSetMacro(NumberOfDecompressionThreads,int);
+  vtkGetMacro(NumberOfDecompressionThreads,int);
+
 
   ///
   /// Use image origin from the file
@@ -242,6 +251,12 @@ protected:
 
   static bool GetPointType(Nrrd* nrrdTemp, int& pointDataType, int &numOfComponents);
 
+  /// Read the data of a gzip encoded file written by blocks with
+  /// decompressing the blocks in parallel.
+  /// Return false if the file is not block compressed or could not be read
+  /// this way, this->nrrd is left unchanged in that case.
+  bool ReadBlockGzipData(int numberOfThreads);
+
   vtkSmartPointer<vtkMatrix4x4> RasToIjkMatrix;
   vtkSmartPointer<vtkMatrix4x4> MeasurementFrameMatrix;
   vtkSmartPointer<vtkMatrix4x4> NRRDWorldToRasMatrix;
@@ -256,6 +271,7 @@ protected:
   int DataType;
   int NumberOfComponents;
   bool UseNativeOrigin;
+  int NumberOfDecompressionThreads;
 
   std::map <std::string, std::string> HeaderKeyValue;
   std::string HeaderKeys; // buffer for returning key list
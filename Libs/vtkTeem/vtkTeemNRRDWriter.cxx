@@ -7,7 +7,17 @@
 #include "vtkPointData.h"
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkSimpleMutexLock.h>
 #include <vtkVersion.h>
+#include <vtk_zlib.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
 
 #include <vnl/vnl_math.h>
 #include <vnl/vnl_double_3.h>
@@ -29,6 +39,8 @@ vtkTeemNRRDWriter::vtkTeemNRRDWriter()
   this->IJKToRASMatrix = vtkMatrix4x4::New();
   this->MeasurementFrameMatrix = vtkMatrix4x4::New();
   this->UseCompression = 1;
+  this->CompressionLevel = -1;
+  this->NumberOfCompressionThreads = 0;
   this->DiffusionWeightedData = 0;
   this->FileType = VTK_BINARY;
   this->WriteErrorOff();
@@ -397,9 +409,26 @@ void vtkTeemNRRDWriter::WriteData()
       }
     }
 
+  nio->zlibLevel = this->CompressionLevel;
+
   // set endianness as unknown of output
   nio->endian = airEndianUnknown;
 
+  int numberOfThreads = this->NumberOfCompressionThreads;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  std::string extension = vtksys::SystemTools::LowerCase(
+    vtksys::SystemTools::GetFilenameLastExtension(this->GetFileName()));
+  if (nio->encoding == nrrdEncodingGzip && numberOfThreads > 1 && extension == ".nrrd"
+    && this->WriteBlockGzipData(nrrd, nio, numberOfThreads))
+    {
+    nrrd = nrrdNix(nrrd);
+    nio = nrrdIoStateNix(nio);
+    return;
+    }
+
   // Write the nrrd to file.
   if (nrrdSave(this->GetFileName(), nrrd, nio))
     {
@@ -414,10 +443,202 @@ void vtkTeemNRRDWriter::WriteData()
   return;
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+// Size of the uncompressed blocks
+const size_t BlockGzipBlockSize = 1 << 20;
+// The compressed block sizes must fit in the 65535 bytes of the gzip extra field
+const size_t BlockGzipMaximumNumberOfBlocks = 16000;
+
+struct BlockGzipThreadData
+{
+  const unsigned char* Data;
+  size_t DataSize;
+  size_t BlockSize;
+  int CompressionLevel;
+  std::vector<std::vector<unsigned char> > CompressedBlocks;
+  std::vector<uLong> BlockCRCs;
+  int NextBlock;
+  bool Failed;
+  vtkSimpleMutexLock* Lock;
+};
+
+//----------------------------------------------------------------------------
+void AppendLittleEndian(std::vector<unsigned char>& buffer, unsigned long value, int numberOfBytes)
+{
+  for (int i = 0; i < numberOfBytes; ++i)
+    {
+    buffer.push_back(static_cast<unsigned char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+//----------------------------------------------------------------------------
+// Each block is compressed as an independent raw deflate stream. All the
+// blocks but the last end with a sync flush so that their concatenation is
+// a single valid deflate stream.
+VTK_THREAD_RETURN_TYPE BlockGzipCompressThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  BlockGzipThreadData* threadData = static_cast<BlockGzipThreadData*>(threadInfo->UserData);
+  int numberOfBlocks = static_cast<int>(threadData->CompressedBlocks.size());
+  while (true)
+    {
+    threadData->Lock->Lock();
+    int block = threadData->NextBlock++;
+    threadData->Lock->Unlock();
+    if (block >= numberOfBlocks)
+      {
+      break;
+      }
+    size_t offset = block * threadData->BlockSize;
+    size_t length = std::min(threadData->BlockSize, threadData->DataSize - offset);
+    bool lastBlock = (block == numberOfBlocks - 1);
+    Bytef* input = const_cast<Bytef*>(threadData->Data + offset);
+
+    threadData->BlockCRCs[block] = crc32(crc32(0L, Z_NULL, 0), input, static_cast<uInt>(length));
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, threadData->CompressionLevel, Z_DEFLATED,
+                     -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      {
+      threadData->Lock->Lock();
+      threadData->Failed = true;
+      threadData->Lock->Unlock();
+      continue;
+      }
+    std::vector<unsigned char>& output = threadData->CompressedBlocks[block];
+    // room for the sync flush marker in addition to the deflate bound
+    output.resize(deflateBound(&stream, static_cast<uLong>(length)) + 64);
+    stream.next_in = input;
+    stream.avail_in = static_cast<uInt>(length);
+    stream.next_out = &output[0];
+    stream.avail_out = static_cast<uInt>(output.size());
+    int res = deflate(&stream, lastBlock ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((lastBlock && res != Z_STREAM_END)
+      || (!lastBlock && (res != Z_OK || stream.avail_in != 0 || stream.avail_out == 0)))
+      {
+      threadData->Lock->Lock();
+      threadData->Failed = true;
+      threadData->Lock->Unlock();
+      }
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDWriter::WriteBlockGzipData(Nrrd* nrrd, NrrdIoState* nio, int numberOfThreads)
+{
+  size_t dataSize = nrrdElementNumber(nrrd) * nrrdElementSize(nrrd);
+  size_t blockSize = std::max(BlockGzipBlockSize,
+    (dataSize + BlockGzipMaximumNumberOfBlocks - 1) / BlockGzipMaximumNumberOfBlocks);
+  size_t numberOfBlocks = (dataSize + blockSize - 1) / blockSize;
+  if (nrrd->data == NULL || numberOfBlocks < 2)
+    {
+    // nothing to gain
+    return false;
+    }
+
+  BlockGzipThreadData threadData;
+  threadData.Data = static_cast<const unsigned char*>(nrrd->data);
+  threadData.DataSize = dataSize;
+  threadData.BlockSize = blockSize;
+  threadData.CompressionLevel =
+    this->CompressionLevel < 0 ? Z_DEFAULT_COMPRESSION : this->CompressionLevel;
+  threadData.CompressedBlocks.resize(numberOfBlocks);
+  threadData.BlockCRCs.resize(numberOfBlocks);
+  threadData.NextBlock = 0;
+  threadData.Failed = false;
+  vtkNew<vtkSimpleMutexLock> lock;
+  threadData.Lock = lock.GetPointer();
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(numberOfThreads, static_cast<int>(numberOfBlocks)));
+  threader->SetSingleMethod(BlockGzipCompressThreadFunction, &threadData);
+  threader->SingleMethodExecute();
+  if (threadData.Failed)
+    {
+    vtkWarningMacro("WriteBlockGzipData: failed to compress " << this->GetFileName()
+      << " by blocks, compressing it on a single thread");
+    return false;
+    }
+
+  // gzip header with the block sizes in an extra subfield
+  std::vector<unsigned char> gzipHeader;
+  const unsigned char gzipMagic[10] = { 0x1f, 0x8b, Z_DEFLATED, 0x04 /* FEXTRA */,
+                                        0, 0, 0, 0 /* MTIME */, 0 /* XFL */, 0xff /* OS */ };
+  gzipHeader.insert(gzipHeader.end(), gzipMagic, gzipMagic + 10);
+  unsigned long subfieldLength = 4 * (numberOfBlocks + 1);
+  AppendLittleEndian(gzipHeader, subfieldLength + 4, 2);
+  gzipHeader.push_back('S');
+  gzipHeader.push_back('L');
+  AppendLittleEndian(gzipHeader, subfieldLength, 2);
+  AppendLittleEndian(gzipHeader, static_cast<unsigned long>(blockSize), 4);
+  uLong crc = crc32(0L, Z_NULL, 0);
+  for (size_t block = 0; block < numberOfBlocks; ++block)
+    {
+    AppendLittleEndian(gzipHeader,
+      static_cast<unsigned long>(threadData.CompressedBlocks[block].size()), 4);
+    size_t length = std::min(blockSize, dataSize - block * blockSize);
+    crc = crc32_combine(crc, threadData.BlockCRCs[block], static_cast<z_off_t>(length));
+    }
+  std::vector<unsigned char> gzipTrailer;
+  AppendLittleEndian(gzipTrailer, crc, 4);
+  AppendLittleEndian(gzipTrailer, static_cast<unsigned long>(dataSize & 0xffffffffUL), 4);
+
+  // header only, the data is appended below
+  nio->skipData = AIR_TRUE;
+  if (nrrdSave(this->GetFileName(), nrrd, nio))
+    {
+    char *err = biffGetDone(NRRD); // would be nice to free(err)
+    vtkErrorMacro("Write: Error writing "
+                      << this->GetFileName() << ":\n" << err);
+    this->WriteErrorOn();
+    return true;
+    }
+
+  // the data starts after the blank line ending the header
+  std::ifstream headerFile(this->GetFileName(), std::ios::in | std::ios::binary);
+  char lastCharacters[2] = { 0, 0 };
+  headerFile.seekg(-2, std::ios::end);
+  headerFile.read(lastCharacters, 2);
+  bool blankLine = headerFile.good() && lastCharacters[0] == '\n' && lastCharacters[1] == '\n';
+  headerFile.close();
+  std::ofstream file(this->GetFileName(), std::ios::out | std::ios::binary | std::ios::app);
+  if (!blankLine)
+    {
+    file << "\n";
+    }
+  file.write(reinterpret_cast<const char*>(&gzipHeader[0]), gzipHeader.size());
+  for (size_t block = 0; block < numberOfBlocks; ++block)
+    {
+    const std::vector<unsigned char>& compressedBlock = threadData.CompressedBlocks[block];
+    file.write(reinterpret_cast<const char*>(&compressedBlock[0]), compressedBlock.size());
+    }
+  file.write(reinterpret_cast<const char*>(&gzipTrailer[0]), gzipTrailer.size());
+  file.close();
+  if (file.fail())
+    {
+    vtkErrorMacro("Write: Error writing data to " << this->GetFileName());
+    this->WriteErrorOn();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
 void vtkTeemNRRDWriter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
 
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "NumberOfCompressionThreads: " << this->NumberOfCompressionThreads << "\n";
   os << indent << "RAS to IJK Matrix: ";
      this->IJKToRASMatrix->PrintSelf(os,indent);
   os << indent << "Measurement frame: ";
@@ -55,6 +55,26 @@ public:
   vtkGetMacro(UseCompression,int);
   vtkBooleanMacro(UseCompression,int);
 
+  ///
+  /// zlib compression level, from 0 (no compression) to 9 (best
+  /// compression). -1 (default) uses the zlib default level.
+  vtkSetClampMacro(CompressionLevel,int,-1,9);
+  vtkGetMacro(CompressionLevel,int);
+
+  ///
+  /// Number of threads compressing the data of .nrrd files.
+  /// The data is split into blocks that are compressed concurrently into a
+  /// single gzip stream, readable by any NRRD reader. The compressed size of
+  /// each block is stored in an extra field of the gzip header so that
+  /// vtkTeemNRRDReader can decompress the blocks concurrently.
+  /// 0 (default) uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads(),
+  /// 1 compresses the data with teem on the calling thread.
+  /// With the default setting, compressed .nrrd files are therefore written block
+  /// compressed on multi-core computers. Set it to 1 to write the same gzip
+  /// stream as earlier versions.
+  vtkSetMacro(NumberOfCompressionThreads,int);
+  vtkGetMacro(NumberOfCompressionThreads,int);
+
   vtkSetClampMacro(FileType,int,VTK_ASCII,VTK_BINARY);
   vtkGetMacro(FileType,int);
   void SetFileTypeToASCII() {this->SetFileType(VTK_ASCII);};
@@ -92,6 +112,12 @@ protected:
   /// Write method. It is called by vtkWriter::Write();
   void WriteData() VTK_OVERRIDE;
 
+  ///
+  /// Write the header of \a nrrd with teem, then its data compressed by
+  /// blocks on several threads. Returns false if nothing has been written,
+  /// the file must then be written by teem.
+  bool WriteBlockGzipData(Nrrd* nrrd, NrrdIoState* nio, int numberOfThreads);
+
   ///
   /// Flag to set to on when a write error occured
   int WriteError;
@@ -105,6 +131,8 @@ protected:
   vtkMatrix4x4* MeasurementFrameMatrix;
 
   int UseCompression;
+  int CompressionLevel;
+  int NumberOfCompressionThreads;
   int FileType;
 
   AttributeMapType *Attributes;
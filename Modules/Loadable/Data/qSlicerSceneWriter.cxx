@@ -206,6 +206,11 @@ bool qSlicerSceneWriter::writeToMRB(const qSlicerIO::IOProperties& properties)
     QMessageBox::critical(0, tr("Save scene as MRB"), tr("Failed to create bundle"));
     return false;
     }
+  if (!this->continueAfterDataBundleWriteFailures(tr("Save scene as MRB")))
+    {
+    ctk::removeDirRecursively(bundlePath);
+    return false;
+    }
 
   qDebug() << "zipping to " << fileInfo.absoluteFilePath();
   if ( !applicationLogic->Zip(fileInfo.absoluteFilePath().toLatin1(),
@@ -290,6 +295,10 @@ bool qSlicerSceneWriter::writeToDirectory(const qSlicerIO::IOProperties& propert
   Q_ASSERT(this->mrmlScene() == applicationLogic->GetMRMLScene());
   bool retval = applicationLogic->SaveSceneToSlicerDataBundleDirectory(
     saveDirName.toLatin1(), imageData);
+  if (retval && !this->continueAfterDataBundleWriteFailures(tr("Save scene to directory")))
+    {
+    retval = false;
+    }
   if (retval)
     {
     qDebug() << "Saved scene to dir" << saveDirName;
@@ -300,3 +309,26 @@ bool qSlicerSceneWriter::writeToDirectory(const qSlicerIO::IOProperties& propert
     }
   return retval ? true : false;
 }
+
+//---------------------------------------------------------------------------
+bool qSlicerSceneWriter::continueAfterDataBundleWriteFailures(const QString& title)
+{
+  vtkSlicerApplicationLogic* applicationLogic =
+    qSlicerCoreApplication::application()->applicationLogic();
+  for (int i = 0; i < applicationLogic->GetNumberOfSaveFailedNodes(); ++i)
+    {
+    const char* nodeID = applicationLogic->GetNthSaveFailedNodeID(i);
+    vtkMRMLNode* node = this->mrmlScene()->GetNodeByID(nodeID);
+    QString nodeName = (node && node->GetName()) ? QString(node->GetName()) : QString(nodeID);
+    QMessageBox::StandardButton answer =
+      QMessageBox::question(0, title,
+                            tr("Cannot write data of node: %1.\n"
+                               "Do you want to continue saving?").arg(nodeName),
+                            QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+    if (answer == QMessageBox::No)
+      {
+      return false;
+      }
+    }
+  return true;
+}
@@ -56,6 +56,11 @@ protected:
   bool writeToMRB(const qSlicerIO::IOProperties& properties);
   bool writeToDirectory(const qSlicerIO::IOProperties& properties);
 
+  /// Ask the user whether to keep saving the scene if the data of some
+  /// nodes could not be written into the bundle directory.
+  /// Returns true if there was no failure or the user chose to continue.
+  bool continueAfterDataBundleWriteFailures(const QString& title);
+
 private:
   Q_DISABLE_COPY(qSlicerSceneWriter);
 };
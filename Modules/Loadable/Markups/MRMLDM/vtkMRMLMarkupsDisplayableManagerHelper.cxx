@@ -103,6 +103,15 @@ void vtkMRMLMarkupsDisplayableManagerHelper::PrintSelf(ostream& os, vtkIndent in
     os << indent.GetNextIndent() << it->first.c_str() << " : projection is "
        << (it->second ? "not null" : "null") << std::endl;
     }
+
+  os << indent << "Glyph pipelines:" << std::endl;
+  for (GlyphPipelinesIt it = this->GlyphPipelines.begin();
+       it != this->GlyphPipelines.end();
+       ++it)
+    {
+    os << indent.GetNextIndent() << it->first->GetID() << " : number of points = "
+       << (it->second ? it->second->GetNumberOfPoints() : 0) << std::endl;
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -305,6 +314,48 @@ vtkAbstractWidget * vtkMRMLMarkupsDisplayableManagerHelper::GetPointProjectionWi
   return it->second;
 }
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsGlyphPipeline * vtkMRMLMarkupsDisplayableManagerHelper::GetGlyphPipeline(vtkMRMLMarkupsNode * node)
+{
+  if (!node)
+    {
+    return 0;
+    }
+
+  GlyphPipelinesIt it = this->GlyphPipelines.find(node);
+  if (it == this->GlyphPipelines.end())
+    {
+    return 0;
+    }
+
+  return it->second;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::RecordGlyphPipelineForNode(vtkMRMLMarkupsGlyphPipeline* pipeline, vtkMRMLMarkupsNode *node)
+{
+  if (!pipeline || !node)
+    {
+    return;
+    }
+  this->GlyphPipelines[node] = pipeline;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::RemoveGlyphPipeline(vtkMRMLMarkupsNode *node)
+{
+  GlyphPipelinesIt it = this->GlyphPipelines.find(node);
+  if (it == this->GlyphPipelines.end())
+    {
+    return;
+    }
+  if (it->second)
+    {
+    it->second->RemoveFromRenderer();
+    }
+  this->GlyphPipelines.erase(it);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsDisplayableManagerHelper::RemoveAllWidgetsAndNodes()
 {
@@ -338,6 +389,17 @@ void vtkMRMLMarkupsDisplayableManagerHelper::RemoveAllWidgetsAndNodes()
     }
   this->WidgetPointProjections.clear();
 
+  for (GlyphPipelinesIt glyphIt = this->GlyphPipelines.begin();
+       glyphIt != this->GlyphPipelines.end();
+       ++glyphIt)
+    {
+    if (glyphIt->second)
+      {
+      glyphIt->second->RemoveFromRenderer();
+      }
+    }
+  this->GlyphPipelines.clear();
+
   this->MarkupsNodeList.clear();
 }
 
@@ -376,6 +438,8 @@ void vtkMRMLMarkupsDisplayableManagerHelper::RemoveWidgetAndNode(
     this->WidgetIntersections.erase(node);
     }
 
+  this->RemoveGlyphPipeline(node);
+
   // go through the list and remove the projection points for it
   // this can get called after a markup has been removed from the list,
   // so turn it around and iterate through all the markups in all the lists,
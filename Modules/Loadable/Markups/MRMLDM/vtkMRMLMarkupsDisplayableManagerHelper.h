@@ -21,6 +21,7 @@
 ///   a) the Markups MRML Node (MarkupsNodeList)
 ///   b) the vtkWidget to show this markup (Widgets)
 ///   c) a vtkWidget to represent sliceIntersections in the slice viewers (WidgetIntersections)
+///   d) a glyph pipeline when the markup has too many points for one handle per point (GlyphPipelines)
 ///
 
 
@@ -33,6 +34,9 @@
 // MarkupsModule/MRML includes
 #include <vtkMRMLMarkupsNode.h>
 
+// MarkupsModule/MRMLDisplayableManager includes
+#include "vtkMRMLMarkupsGlyphPipeline.h"
+
 // VTK includes
 #include <vtkAbstractWidget.h>
 #include <vtkHandleWidget.h>
@@ -75,10 +79,17 @@ public:
   /// ...and its associated vtkAbstractWidget* for Slice projection representation. There is one
   /// projection widget per unique point.
   vtkAbstractWidget * GetPointProjectionWidget(std::string uniqueFiducialID);
+  /// ...and its glyph pipeline if all its points are displayed with one actor, NULL otherwise
+  vtkMRMLMarkupsGlyphPipeline * GetGlyphPipeline(vtkMRMLMarkupsNode * node);
+
+  /// Keep track of the glyph pipeline displaying the node
+  void RecordGlyphPipelineForNode(vtkMRMLMarkupsGlyphPipeline* pipeline, vtkMRMLMarkupsNode *node);
+  /// Remove the glyph pipeline of the node from the renderer and forget it
+  void RemoveGlyphPipeline(vtkMRMLMarkupsNode *node);
 
   /// Remove all widgets, intersection widgets, nodes
   void RemoveAllWidgetsAndNodes();
-  /// Remove a node, its widget and its intersection widget
+  /// Remove a node, its widget, its intersection widget and its glyph pipeline
   void RemoveWidgetAndNode(vtkMRMLMarkupsNode *node);
 
 
@@ -109,6 +120,12 @@ public:
   /// .. and its associated convenient typedef
   typedef std::map<std::string, vtkAbstractWidget*>::iterator WidgetPointProjectionsIt;
 
+  /// Map of glyph pipelines displaying nodes with many points indexed using associated node
+  std::map<vtkMRMLMarkupsNode*, vtkSmartPointer<vtkMRMLMarkupsGlyphPipeline> > GlyphPipelines;
+
+  /// .. and its associated convenient typedef
+  typedef std::map<vtkMRMLMarkupsNode*, vtkSmartPointer<vtkMRMLMarkupsGlyphPipeline> >::iterator GlyphPipelinesIt;
+
   //
   // End of The Lists!!
   //
@@ -22,6 +22,7 @@
 
 // MarkupsModule/MRMLDisplayableManager includes
 #include "vtkMRMLMarkupsFiducialDisplayableManager2D.h"
+#include "vtkMRMLMarkupsGlyphPipeline.h"
 
 // MarkupsModule/VTKWidgets includes
 #include <vtkMarkupsGlyphSource2D.h>
@@ -36,15 +37,18 @@
 
 // VTK includes
 #include <vtkAbstractWidget.h>
+#include <vtkCamera.h>
 #include <vtkFollower.h>
 #include <vtkHandleRepresentation.h>
 #include <vtkInteractorStyle.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOrientedPolygonalHandleRepresentation3D.h>
 #include <vtkPickingManager.h>
 #include <vtkPointHandleRepresentation2D.h>
+#include <vtkPolyData.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
@@ -246,13 +250,152 @@ public:
   bool PointMovedSinceStartInteraction;
 };
 
+//---------------------------------------------------------------------------
+// Callback of the handle widget that drags markups drawn by a glyph pipeline
+/// \ingroup Slicer_QtModules_Markups
+class vtkMarkupsFiducialGlyphHandleCallback2D : public vtkCommand
+{
+public:
+  static vtkMarkupsFiducialGlyphHandleCallback2D *New()
+  { return new vtkMarkupsFiducialGlyphHandleCallback2D; }
+
+  vtkMarkupsFiducialGlyphHandleCallback2D()
+    : Pipeline(NULL)
+    , Node(NULL)
+    , DisplayableManager(NULL)
+    , PointMovedSinceStartInteraction(false)
+  {
+  }
+
+  virtual void Execute (vtkObject *vtkNotUsed(caller), unsigned long event, void *vtkNotUsed(callData))
+  {
+    // sanity checks
+    if (!this->DisplayableManager || !this->Node || !this->Pipeline)
+      {
+      return;
+      }
+    int markupIndex = this->Pipeline->GetHandleMarkupIndex();
+    if (event == vtkCommand::StartInteractionEvent)
+      {
+      // keep the handle on this markup until the interaction ends
+      this->Pipeline->SetHandleInteracting(true);
+      this->PointMovedSinceStartInteraction = false;
+      this->SetMovingAttributes(true, markupIndex);
+      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointStartInteractionEvent, &markupIndex);
+      }
+    else if (event == vtkCommand::InteractionEvent)
+      {
+      this->PointMovedSinceStartInteraction = true;
+      this->DisplayableManager->PropagateGlyphHandleToMRML(this->Node, this->Pipeline);
+      }
+    else if (event == vtkCommand::EndInteractionEvent)
+      {
+      this->Pipeline->SetHandleInteracting(false);
+      this->SetMovingAttributes(false, markupIndex);
+      if (this->Node->GetScene())
+        {
+        this->Node->GetScene()->SaveStateForUndo(this->Node);
+        }
+      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent, &markupIndex);
+      if (!this->PointMovedSinceStartInteraction)
+        {
+        this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointClickedEvent, &markupIndex);
+        }
+      }
+  }
+
+  /// Mark the node while it is moved in this slice view, as done for the
+  /// seed widgets
+  void SetMovingAttributes(bool moving, int markupIndex)
+  {
+    vtkMRMLSliceNode *sliceNode = this->DisplayableManager->GetMRMLSliceNode();
+    if (!sliceNode)
+      {
+      return;
+      }
+    int modifiedWasDisabled = this->Node->GetDisableModifiedEvent();
+    this->Node->DisableModifiedEventOn();
+    if (moving)
+      {
+      this->Node->SetAttribute("Markups.MovingInSliceView", sliceNode->GetLayoutName());
+      std::ostringstream seedNumber;
+      seedNumber << markupIndex;
+      this->Node->SetAttribute("Markups.MovingMarkupIndex", seedNumber.str().c_str());
+      }
+    else
+      {
+      const char *movingView = this->Node->GetAttribute("Markups.MovingInSliceView");
+      if (movingView && !strcmp(movingView, sliceNode->GetLayoutName()))
+        {
+        this->Node->RemoveAttribute("Markups.MovingInSliceView");
+        }
+      }
+    this->Node->SetDisableModifiedEvent(modifiedWasDisabled);
+  }
+
+  vtkMRMLMarkupsGlyphPipeline * Pipeline;
+  vtkMRMLMarkupsNode * Node;
+  vtkMRMLMarkupsFiducialDisplayableManager2D * DisplayableManager;
+  bool PointMovedSinceStartInteraction;
+};
+
+//---------------------------------------------------------------------------
+// Interactor callback placing the glyph handle widgets under the mouse
+/// \ingroup Slicer_QtModules_Markups
+class vtkMarkupsFiducialGlyphInteractorCallback2D : public vtkCommand
+{
+public:
+  static vtkMarkupsFiducialGlyphInteractorCallback2D *New()
+  { return new vtkMarkupsFiducialGlyphInteractorCallback2D; }
+
+  vtkMarkupsFiducialGlyphInteractorCallback2D()
+    : DisplayableManager(NULL)
+  {
+  }
+
+  virtual void Execute (vtkObject *caller, unsigned long vtkNotUsed(event), void *vtkNotUsed(callData))
+  {
+    vtkRenderWindowInteractor* interactor = vtkRenderWindowInteractor::SafeDownCast(caller);
+    if (!this->DisplayableManager || !interactor)
+      {
+      return;
+      }
+    // don't pick while the slice is panned, zoomed or browsed
+    vtkSliceViewInteractorStyle* style = vtkSliceViewInteractorStyle::SafeDownCast(interactor->GetInteractorStyle());
+    if (style && style->GetActionState() != vtkSliceViewInteractorStyle::None)
+      {
+      return;
+      }
+    this->DisplayableManager->UpdateGlyphHandle(interactor->GetEventPosition()[0], interactor->GetEventPosition()[1]);
+  }
+
+  vtkMRMLMarkupsFiducialDisplayableManager2D * DisplayableManager;
+};
+
 //---------------------------------------------------------------------------
 // vtkMRMLMarkupsFiducialDisplayableManager2D methods
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkMRMLMarkupsFiducialDisplayableManager2D()
+{
+  this->Focus = "vtkMRMLMarkupsFiducialNode";
+  this->GlyphRenderingThreshold = 1000;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::~vtkMRMLMarkupsFiducialDisplayableManager2D()
+{
+  if (this->GlyphHandleInteractor && this->GlyphHandleInteractorCallback)
+    {
+    this->GlyphHandleInteractor->RemoveObserver(this->GlyphHandleInteractorCallback);
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialDisplayableManager2D::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "GlyphRenderingThreshold = " << this->GlyphRenderingThreshold << std::endl;
   this->Helper->PrintSelf(os, indent);
 }
 
@@ -459,6 +602,11 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
     {
     return false;
     }
+  if (this->UseGlyphRendering(pointsNode))
+    {
+    // the markups are drawn by the glyph pipeline, there are no seeds
+    return false;
+    }
   bool positionChanged = false;
 
 //  std::cout << "UpdateNthSeedPositionFromMRML: n = " << n << std::endl;
@@ -1071,6 +1219,34 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateMRMLToWidget(vtkMRMLMa
 
   vtkDebugMacro("Fids PropagateMRMLToWidget, node num markups = " << numberOfFiducials);
 
+  if (this->UseGlyphRendering(fiducialNode))
+    {
+    // too many markups for one handle per markup, remove the seeds created
+    // while the list was smaller and draw the markups as glyphs
+    for (int n = seedRepresentation->GetNumberOfSeeds() - 1; n >= 0; --n)
+      {
+      seedWidget->DeleteSeed(n);
+      }
+    // markups that are not on the slice are not projected
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      vtkAbstractWidget* projectionWidget = this->Helper->GetPointProjectionWidget(fiducialNode->GetNthMarkupID(n));
+      if (projectionWidget)
+        {
+        projectionWidget->Off();
+        }
+      }
+    this->UpdateGlyphPipeline(fiducialNode);
+
+    this->Helper->UpdateLocked(node, this->GetInteractionNode());
+    this->UpdateWidgetVisibility(node);
+    seedRepresentation->NeedToRenderOn();
+    seedWidget->Modified();
+    this->Updating = 0;
+    return;
+    }
+  this->Helper->RemoveGlyphPipeline(fiducialNode);
+
 #if VTK_MAJOR_VERSION < 9
   // XXX This was part of commits:
   // * r23648 (BUG: fixes for 3808 fiducial picking issue)
@@ -1450,6 +1626,17 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdatePosition(vtkAbstractWidge
    return;
    }
 
+  vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(pointsNode);
+  if (fiducialNode && this->UseGlyphRendering(fiducialNode))
+    {
+    this->UpdateGlyphPipeline(fiducialNode);
+    if (this->Updating == 0)
+      {
+      this->RequestRender();
+      }
+    return;
+    }
+
   // now get the widget properties (coordinates, measurement etc.) and if the mrml node has changed, propagate the changes
 
 
@@ -1510,6 +1697,16 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeNthMarkupModif
    vtkErrorMacro("OnMRMLMarkupsNodeNthMarkupModifiedEvent: Could not get seed widget!")
    return;
    }
+  if (this->UseGlyphRendering(node))
+    {
+    // only the point of the markup is updated, unless it enters or leaves the slice
+    if (!this->UpdateNthGlyph(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), false))
+      {
+      this->PropagateMRMLToWidget(node, seedWidget);
+      }
+    this->RequestRender();
+    return;
+    }
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), seedWidget);
 }
 
@@ -1545,6 +1742,19 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
+  if (this->UseGlyphRendering(markupsNode))
+    {
+    // a markup added at the end of a list already drawn with glyphs is
+    // appended, otherwise all the points are inserted again (this also
+    // switches from seeds to glyphs when the threshold is reached)
+    if (!this->UpdateNthGlyph(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), true))
+      {
+      this->PropagateMRMLToWidget(markupsNode, seedWidget);
+      }
+    this->RequestRender();
+    return;
+    }
+
   // this call will create a new handle and set it
   // std::cout << "OnMRMLMarkupsNodeMarkupAddedEvent: adding to markups node that currently has " << markupsNode->GetNumberOfMarkups() << std::endl;
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
@@ -1575,3 +1785,470 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeMarkupRemovedE
   this->Helper->RemoveWidgetAndNode(markupsNode);
   this->AddWidget(markupsNode);
 }
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager2D::UseGlyphRendering(vtkMRMLMarkupsNode* node)
+{
+  return node
+    && this->GlyphRenderingThreshold > 0
+    && node->GetNumberOfMarkups() >= this->GlyphRenderingThreshold;
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLMarkupsFiducialDisplayableManager2D::GetGlyphSizeInPixels(vtkMRMLMarkupsDisplayNode* displayNode)
+{
+  vtkRenderer* renderer = this->GetRenderer();
+  if (!displayNode || !renderer)
+    {
+    return 0.0;
+    }
+  // the handles are scaled in the world coordinates of the renderer camera,
+  // compute the height of the view in these coordinates
+  double visibleHeight = 2.0 * tan(vtkMath::RadiansFromDegrees(15.0)); // default camera
+  if (renderer->IsActiveCameraCreated())
+    {
+    vtkCamera* camera = renderer->GetActiveCamera();
+    if (camera->GetParallelProjection())
+      {
+      visibleHeight = 2.0 * camera->GetParallelScale();
+      }
+    else
+      {
+      visibleHeight = 2.0 * camera->GetDistance() * tan(vtkMath::RadiansFromDegrees(camera->GetViewAngle() / 2.0));
+      }
+    }
+  if (visibleHeight <= 0.0)
+    {
+    return 0.0;
+    }
+  return displayNode->GetGlyphScale() * this->GetScaleFactor2D() * renderer->GetSize()[1] / visibleHeight;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkMRMLMarkupsFiducialDisplayableManager2D::CreateGlyph(vtkMRMLMarkupsDisplayNode* displayNode, double scale)
+{
+  int glyphType = displayNode->GetGlyphType();
+  if (displayNode->GlyphTypeIs3D())
+    {
+    // map the 3d sphere to a filled circle, the 3d diamond to a filled
+    // diamond, as for the seeds
+    if (glyphType == vtkMRMLMarkupsDisplayNode::Sphere3D)
+      {
+      glyphType = vtkMRMLMarkupsDisplayNode::Circle2D;
+      }
+    else if (glyphType == vtkMRMLMarkupsDisplayNode::Diamond3D)
+      {
+      glyphType = vtkMRMLMarkupsDisplayNode::Diamond2D;
+      }
+    else
+      {
+      glyphType = vtkMRMLMarkupsDisplayNode::StarBurst2D;
+      }
+    }
+  vtkNew<vtkMarkupsGlyphSource2D> glyphSource;
+  glyphSource->SetGlyphType(glyphType);
+  glyphSource->SetScale(scale);
+  glyphSource->Update();
+  return glyphSource->GetOutput();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateGlyphPipeline(vtkMRMLMarkupsFiducialNode* fiducialNode)
+{
+  if (!fiducialNode)
+    {
+    return;
+    }
+  vtkMRMLMarkupsGlyphPipeline* pipeline = this->Helper->GetGlyphPipeline(fiducialNode);
+  if (!pipeline)
+    {
+    vtkNew<vtkMRMLMarkupsGlyphPipeline> newPipeline;
+    this->Helper->RecordGlyphPipelineForNode(newPipeline.GetPointer(), fiducialNode);
+    pipeline = newPipeline.GetPointer();
+    }
+  vtkRenderer* renderer = this->GetRenderer();
+  pipeline->SetRenderer(renderer, true);
+  this->ObserveInteractorForGlyphHandles();
+
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  bool listVisible = this->IsGlyphListVisible(fiducialNode);
+
+  pipeline->ResetPoints();
+  if (listVisible)
+    {
+    // XYToRAS is only inverted once for all the markups
+    vtkNew<vtkMatrix4x4> rasToXyMatrix;
+    vtkMatrix4x4::Invert(this->GetMRMLSliceNode()->GetXYToRAS(), rasToXyMatrix.GetPointer());
+
+    int numberOfFiducials = fiducialNode->GetNumberOfMarkups();
+    double displayCoordinates[4];
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      if (!this->GetNthGlyphDisplayCoordinates(n, fiducialNode, rasToXyMatrix.GetPointer(), displayCoordinates))
+        {
+        continue;
+        }
+      pipeline->InsertNextPoint(displayCoordinates,
+        fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor(), n);
+      }
+
+    // the glyph only depends on the glyph type and the size in pixels
+    double glyphSize = this->GetGlyphSizeInPixels(displayNode);
+    if (!pipeline->IsGlyphUpToDate(displayNode->GetGlyphType(), glyphSize))
+      {
+      pipeline->SetGlyph(this->CreateGlyph(displayNode, glyphSize), displayNode->GetGlyphType(), glyphSize);
+      }
+    pipeline->SetOpacity(displayNode->GetOpacity());
+    }
+  pipeline->PointsModified();
+  pipeline->SetVisibility(pipeline->GetNumberOfPoints() > 0);
+
+  // keep the handle on its markup, unless it is being dragged
+  if (!pipeline->GetHandleInteracting())
+    {
+    this->PlaceGlyphHandle(pipeline->GetHandleMarkupIndex(), fiducialNode, pipeline);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager2D::IsGlyphListVisible(vtkMRMLMarkupsFiducialNode* fiducialNode)
+{
+  // markups are not shown in light box mode, see IsWidgetDisplayableOnSlice
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  vtkMRMLSliceNode *sliceNode = this->GetMRMLSliceNode();
+  return (displayNode && displayNode->GetVisibility() != 0 &&
+          sliceNode && this->GetRenderer() && !this->IsInLightboxMode() &&
+          displayNode->GetVisibility(sliceNode->GetID()) != 0);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager2D::GetNthGlyphDisplayCoordinates(int n,
+  vtkMRMLMarkupsFiducialNode* fiducialNode, vtkMatrix4x4* rasToXyMatrix, double displayCoordinates[4])
+{
+  if (fiducialNode->GetNthFiducialVisibility(n) == 0)
+    {
+    return false;
+    }
+  // same test as IsWidgetDisplayableOnSlice
+  double worldCoordinates[4];
+  fiducialNode->GetNthFiducialWorldCoordinates(n, worldCoordinates);
+  worldCoordinates[3] = 1.0;
+  rasToXyMatrix->MultiplyPoint(worldCoordinates, displayCoordinates);
+  double maxDistance = 0.5 + (this->GetMRMLSliceNode()->GetDimensions()[2] - 1);
+  int *viewportSize = this->GetRenderer()->GetSize();
+  if (displayCoordinates[2] < -0.5 || displayCoordinates[2] >= maxDistance ||
+      displayCoordinates[0] <= 0.0 || displayCoordinates[0] >= viewportSize[0] ||
+      displayCoordinates[1] <= 0.0 || displayCoordinates[1] >= viewportSize[1])
+    {
+    return false;
+    }
+  displayCoordinates[2] = 0.0;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthGlyph(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, bool added)
+{
+  if (!fiducialNode || n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+    {
+    return false;
+    }
+  vtkMRMLMarkupsGlyphPipeline* pipeline = this->Helper->GetGlyphPipeline(fiducialNode);
+  if (!pipeline)
+    {
+    return false;
+    }
+  // the indices of the markups after an inserted one have changed, and the
+  // glyph and display properties are only set up when there are points
+  if (added && (n != fiducialNode->GetNumberOfMarkups() - 1 || pipeline->GetLastMarkupIndex() >= n
+                || pipeline->GetNumberOfPoints() == 0))
+    {
+    return false;
+    }
+  if (!this->IsGlyphListVisible(fiducialNode))
+    {
+    // nothing is drawn, unless the list has just been hidden
+    return pipeline->GetNumberOfPoints() == 0;
+    }
+
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  vtkNew<vtkMatrix4x4> rasToXyMatrix;
+  vtkMatrix4x4::Invert(this->GetMRMLSliceNode()->GetXYToRAS(), rasToXyMatrix.GetPointer());
+  double displayCoordinates[4];
+  bool onSlice = this->GetNthGlyphDisplayCoordinates(n, fiducialNode, rasToXyMatrix.GetPointer(), displayCoordinates);
+  if (added)
+    {
+    if (onSlice)
+      {
+      pipeline->InsertNextPoint(displayCoordinates,
+        fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor(), n);
+      pipeline->PointsModified();
+      }
+    return true;
+    }
+
+  if (onSlice != (pipeline->GetPointIndex(n) >= 0))
+    {
+    // the point must be inserted or removed
+    return false;
+    }
+  if (onSlice)
+    {
+    pipeline->SetMarkupPoint(n, displayCoordinates,
+      fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor());
+    pipeline->PointsModified();
+    }
+  // keep the handle on its markup, unless it is being dragged
+  if (pipeline->GetHandleMarkupIndex() == n && !pipeline->GetHandleInteracting())
+    {
+    this->PlaceGlyphHandle(n, fiducialNode, pipeline);
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::PlaceGlyphHandle(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, vtkMRMLMarkupsGlyphPipeline* pipeline)
+{
+  if (!fiducialNode || !pipeline)
+    {
+    return;
+    }
+  vtkHandleWidget *handleWidget = pipeline->GetHandleWidget();
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  vtkRenderer* renderer = this->GetRenderer();
+  if (n < 0 || n >= fiducialNode->GetNumberOfMarkups() ||
+      !displayNode ||
+      !renderer || !renderer->IsActiveCameraCreated() ||
+      !pipeline->GetActor() || !pipeline->GetActor()->GetVisibility() ||
+      fiducialNode->GetNthFiducialVisibility(n) == 0 ||
+      !this->IsWidgetDisplayableOnSlice(fiducialNode, n))
+    {
+    if (handleWidget)
+      {
+      handleWidget->Off();
+      }
+    pipeline->SetHandleMarkupIndex(-1);
+    return;
+    }
+
+  if (!handleWidget)
+    {
+    vtkNew<vtkOrientedPolygonalHandleRepresentation3D> newHandleRep;
+    newHandleRep->SetRenderer(renderer);
+
+    vtkNew<vtkHandleWidget> newHandleWidget;
+    newHandleWidget->SetRepresentation(newHandleRep.GetPointer());
+    newHandleWidget->SetInteractor(this->GetInteractor());
+    newHandleWidget->SetCurrentRenderer(renderer);
+    newHandleWidget->ManagesCursorOff();
+
+    vtkNew<vtkMarkupsFiducialGlyphHandleCallback2D> callback;
+    callback->Pipeline = pipeline;
+    callback->Node = fiducialNode;
+    callback->DisplayableManager = this;
+    newHandleWidget->AddObserver(vtkCommand::StartInteractionEvent, callback.GetPointer());
+    newHandleWidget->AddObserver(vtkCommand::InteractionEvent, callback.GetPointer());
+    newHandleWidget->AddObserver(vtkCommand::EndInteractionEvent, callback.GetPointer());
+
+    pipeline->SetHandleWidget(newHandleWidget.GetPointer());
+    handleWidget = newHandleWidget.GetPointer();
+    }
+
+  vtkOrientedPolygonalHandleRepresentation3D *handleRep =
+    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(handleWidget->GetRepresentation());
+  if (!handleRep)
+    {
+    return;
+    }
+
+  handleRep->SetHandle(this->CreateGlyph(displayNode, 1.0));
+  handleRep->SetUniformScale(displayNode->GetGlyphScale()*this->GetScaleFactor2D());
+
+  double *color = fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor();
+  handleRep->GetProperty()->SetColor(color);
+  handleRep->GetProperty()->SetOpacity(displayNode->GetOpacity());
+
+  // the glyphs have no labels, show the label of the markup under the mouse
+  std::string textString = fiducialNode->GetNthFiducialLabel(n);
+  handleRep->SetLabelText(textString.c_str());
+  if (textString.compare("") != 0)
+    {
+    // scale it down for the 2d windows
+    double textscale[3] = {displayNode->GetTextScale(), displayNode->GetTextScale(), displayNode->GetTextScale()};
+    textscale[0] *= this->GetScaleFactor2D();
+    textscale[1] *= this->GetScaleFactor2D();
+    textscale[2] *= this->GetScaleFactor2D();
+    handleRep->SetLabelTextScale(textscale);
+    if (handleRep->GetLabelTextActor())
+      {
+      handleRep->GetLabelTextActor()->GetProperty()->SetColor(color);
+      handleRep->GetLabelTextActor()->GetProperty()->SetOpacity(displayNode->GetOpacity());
+      }
+    handleRep->LabelVisibilityOn();
+    }
+  else
+    {
+    handleRep->LabelVisibilityOff();
+    }
+
+  // update locked, as for the seeds
+  int persistentPlaceMode = 0;
+  vtkMRMLInteractionNode *interactionNode = this->GetInteractionNode();
+  if (interactionNode)
+    {
+    persistentPlaceMode =
+      (interactionNode->GetCurrentInteractionMode() == vtkMRMLInteractionNode::Place)
+      && (interactionNode->GetPlaceModePersistence() == 1);
+    }
+  if (fiducialNode->GetLocked() || persistentPlaceMode)
+    {
+    handleWidget->ProcessEventsOff();
+    }
+  else
+    {
+    handleWidget->ProcessEventsOn();
+    handleWidget->SetEnableTranslation(!fiducialNode->GetNthMarkupLocked(n));
+    }
+
+  double worldCoordinates[4];
+  fiducialNode->GetNthFiducialWorldCoordinates(n, worldCoordinates);
+  double displayCoordinates[4];
+  this->GetWorldToDisplayCoordinates(worldCoordinates, displayCoordinates);
+  handleRep->SetDisplayPosition(displayCoordinates);
+
+  pipeline->SetHandleMarkupIndex(n);
+  if (!handleWidget->GetEnabled())
+    {
+    handleWidget->On();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::ObserveInteractorForGlyphHandles()
+{
+  vtkRenderWindowInteractor* interactor = this->GetInteractor();
+  if (!interactor || interactor == this->GlyphHandleInteractor)
+    {
+    return;
+    }
+  if (!this->GlyphHandleInteractorCallback)
+    {
+    vtkNew<vtkMarkupsFiducialGlyphInteractorCallback2D> callback;
+    callback->DisplayableManager = this;
+    this->GlyphHandleInteractorCallback = callback.GetPointer();
+    }
+  if (this->GlyphHandleInteractor)
+    {
+    this->GlyphHandleInteractor->RemoveObserver(this->GlyphHandleInteractorCallback);
+    }
+  // higher priority than the widgets so that the handle is in place
+  // before they process the event
+  interactor->AddObserver(vtkCommand::MouseMoveEvent, this->GlyphHandleInteractorCallback, 1.0);
+  this->GlyphHandleInteractor = interactor;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateGlyphHandle(int x, int y)
+{
+  vtkRenderer* renderer = this->GetRenderer();
+  if (!renderer || this->Helper->GlyphPipelines.empty())
+    {
+    return;
+    }
+  vtkMRMLInteractionNode *interactionNode = this->GetInteractionNode();
+  if (interactionNode && interactionNode->GetCurrentInteractionMode() == vtkMRMLInteractionNode::Place)
+    {
+    return;
+    }
+
+  vtkMRMLMarkupsDisplayableManagerHelper::GlyphPipelinesIt it;
+  for (it = this->Helper->GlyphPipelines.begin(); it != this->Helper->GlyphPipelines.end(); ++it)
+    {
+    if (it->second->GetHandleInteracting())
+      {
+      // a markup is being dragged
+      return;
+      }
+    }
+
+  // the glyph pipelines hold the markups in the display coordinates of the
+  // renderer, search the closest one to the mouse
+  double position[3] = {static_cast<double>(x - renderer->GetOrigin()[0]),
+                        static_cast<double>(y - renderer->GetOrigin()[1]),
+                        0.0};
+  vtkMRMLMarkupsGlyphPipeline* pickedPipeline = NULL;
+  int pickedMarkupIndex = -1;
+  for (it = this->Helper->GlyphPipelines.begin(); it != this->Helper->GlyphPipelines.end(); ++it)
+    {
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    if (!fiducialNode || !it->second->GetActor() || !it->second->GetActor()->GetVisibility())
+      {
+      continue;
+      }
+    double tolerance = 0.5 * this->GetGlyphSizeInPixels(fiducialNode->GetMarkupsDisplayNode());
+    int n = it->second->FindClosestMarkup(position, tolerance);
+    if (n >= 0)
+      {
+      pickedPipeline = it->second;
+      pickedMarkupIndex = n;
+      break;
+      }
+    }
+
+  bool handleMoved = false;
+  for (it = this->Helper->GlyphPipelines.begin(); it != this->Helper->GlyphPipelines.end(); ++it)
+    {
+    int n = (it->second == pickedPipeline ? pickedMarkupIndex : -1);
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    if (!fiducialNode || it->second->GetHandleMarkupIndex() == n)
+      {
+      continue;
+      }
+    this->PlaceGlyphHandle(n, fiducialNode, it->second);
+    handleMoved = true;
+    }
+  if (handleMoved)
+    {
+    this->RequestRender();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateGlyphHandleToMRML(vtkMRMLMarkupsNode* node, vtkMRMLMarkupsGlyphPipeline* pipeline)
+{
+  vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(node);
+  if (!fiducialNode || !pipeline || !pipeline->GetHandleWidget())
+    {
+    return;
+    }
+  int n = pipeline->GetHandleMarkupIndex();
+  if (n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+    {
+    return;
+    }
+  vtkHandleRepresentation* handleRep =
+    vtkHandleRepresentation::SafeDownCast(pipeline->GetHandleWidget()->GetRepresentation());
+  if (!handleRep)
+    {
+    return;
+    }
+  double displayCoordinates[4] = {0.0, 0.0, 0.0, 1.0};
+  handleRep->GetDisplayPosition(displayCoordinates);
+  // restrict the markup to the renderer, as done for the seeds
+  if (this->RestrictDisplayCoordinatesToViewport(displayCoordinates))
+    {
+    handleRep->SetDisplayPosition(displayCoordinates);
+    }
+  double worldCoordinates[4] = {0.0, 0.0, 0.0, 1.0};
+  this->GetDisplayToWorldCoordinates(displayCoordinates, worldCoordinates);
+  double currentCoordinates[4];
+  fiducialNode->GetNthFiducialWorldCoordinates(n, currentCoordinates);
+  if (this->GetWorldCoordinatesChanged(currentCoordinates, worldCoordinates))
+    {
+    // ignore the node modified event, the glyph pipeline is updated by the
+    // point modified event
+    this->Updating = 1;
+    fiducialNode->SetNthFiducialWorldCoordinates(n, worldCoordinates);
+    this->Updating = 0;
+    }
+}
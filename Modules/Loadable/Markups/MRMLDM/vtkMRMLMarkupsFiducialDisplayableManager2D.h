@@ -24,7 +24,16 @@
 // MarkupsModule/MRMLDisplayableManager includes
 #include "vtkMRMLMarkupsDisplayableManager2D.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+class vtkCommand;
 class vtkMRMLMarkupsFiducialNode;
+class vtkMRMLMarkupsGlyphPipeline;
+class vtkMatrix4x4;
+class vtkPolyData;
+class vtkRenderWindowInteractor;
 class vtkSlicerViewerWidget;
 class vtkMRMLMarkupsDisplayNode;
 class vtkTextWidget;
@@ -45,10 +54,25 @@ public:
   /// Update a single markup position from the seed widget, return true if the position changed
   virtual bool UpdateNthMarkupPositionFromWidget(int n, vtkMRMLMarkupsNode* pointsNode, vtkAbstractWidget * widget) VTK_OVERRIDE;
 
+  /// Fiducial lists with at least this many markups are drawn with a single
+  /// glyph actor instead of one handle widget per markup. A handle widget is
+  /// only placed on the markup under the mouse so that it can be dragged.
+  /// Glyph rendering is disabled if the threshold is not positive.
+  /// Default is 1000.
+  vtkSetMacro(GlyphRenderingThreshold, int);
+  vtkGetMacro(GlyphRenderingThreshold, int);
+
+  /// Move the glyph handle widget onto the markup displayed at the display
+  /// position \a x, \a y, or hide it if there is none. Called on mouse moves.
+  void UpdateGlyphHandle(int x, int y);
+  /// Set the position of the markup the glyph handle widget is placed on
+  /// from the handle widget. Called while the handle is dragged.
+  void PropagateGlyphHandleToMRML(vtkMRMLMarkupsNode* node, vtkMRMLMarkupsGlyphPipeline* pipeline);
+
 protected:
 
-  vtkMRMLMarkupsFiducialDisplayableManager2D(){this->Focus="vtkMRMLMarkupsFiducialNode";}
-  virtual ~vtkMRMLMarkupsFiducialDisplayableManager2D(){}
+  vtkMRMLMarkupsFiducialDisplayableManager2D();
+  virtual ~vtkMRMLMarkupsFiducialDisplayableManager2D();
 
   /// Callback for click in RenderWindow
   virtual void OnClickInRenderWindow(double x, double y, const char *associatedNodeID) VTK_OVERRIDE;
@@ -83,6 +107,34 @@ protected:
   // Clean up when scene closes
   virtual void OnMRMLSceneEndClose() VTK_OVERRIDE;
 
+  /// Return true if the node has enough markups to be drawn with a glyph pipeline
+  bool UseGlyphRendering(vtkMRMLMarkupsNode* node);
+  /// Draw the markups of the node that are on the slice with its glyph pipeline
+  void UpdateGlyphPipeline(vtkMRMLMarkupsFiducialNode* fiducialNode);
+  /// Update the point of the nth markup in the glyph pipeline of the node,
+  /// or append it if \a added is true. Returns false if all the markups must
+  /// be drawn again with UpdateGlyphPipeline().
+  bool UpdateNthGlyph(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, bool added);
+  /// Return true if the markups of the node are visible in this slice view
+  bool IsGlyphListVisible(vtkMRMLMarkupsFiducialNode* fiducialNode);
+  /// Compute the display coordinates of the nth markup from \a rasToXyMatrix,
+  /// the inverse of the XYToRAS matrix of the slice node. Returns false if the
+  /// markup is hidden or not on the slice.
+  bool GetNthGlyphDisplayCoordinates(int n, vtkMRMLMarkupsFiducialNode* fiducialNode,
+                                     vtkMatrix4x4* rasToXyMatrix, double displayCoordinates[4]);
+  /// Place the handle widget of the pipeline on the nth markup, hide it if n is -1
+  void PlaceGlyphHandle(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, vtkMRMLMarkupsGlyphPipeline* pipeline);
+  /// Observe mouse moves on the interactor to place the glyph handle widgets
+  void ObserveInteractorForGlyphHandles();
+  /// Size in pixels of the glyphs of the handle widgets
+  double GetGlyphSizeInPixels(vtkMRMLMarkupsDisplayNode* displayNode);
+  /// 2D glyph of the glyph type of the display node, scaled by \a scale
+  vtkSmartPointer<vtkPolyData> CreateGlyph(vtkMRMLMarkupsDisplayNode* displayNode, double scale);
+
+  int GlyphRenderingThreshold;
+  vtkSmartPointer<vtkCommand> GlyphHandleInteractorCallback;
+  vtkWeakPointer<vtkRenderWindowInteractor> GlyphHandleInteractor;
+
 private:
 
   vtkMRMLMarkupsFiducialDisplayableManager2D(const vtkMRMLMarkupsFiducialDisplayableManager2D&); /// Not implemented
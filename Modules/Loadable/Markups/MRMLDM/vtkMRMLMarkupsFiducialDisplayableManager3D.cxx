@@ -22,6 +22,7 @@
 
 // MarkupsModule/MRMLDisplayableManager includes
 #include "vtkMRMLMarkupsFiducialDisplayableManager3D.h"
+#include "vtkMRMLMarkupsGlyphPipeline.h"
 
 // MarkupsModule/VTKWidgets includes
 #include <vtkMarkupsGlyphSource2D.h>
@@ -39,12 +40,15 @@
 #include <vtkAbstractWidget.h>
 #include <vtkFollower.h>
 #include <vtkHandleRepresentation.h>
+#include <vtkHandleWidget.h>
 #include <vtkInteractorStyle.h>
 #include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOrientedPolygonalHandleRepresentation3D.h>
 #include <vtkPickingManager.h>
+#include <vtkPropCollection.h>
+#include <vtkPropPicker.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
@@ -162,13 +166,121 @@ public:
   bool PointMovedSinceStartInteraction;
 };
 
+//---------------------------------------------------------------------------
+// Callback of the handle widget that drags markups drawn by a glyph pipeline
+/// \ingroup Slicer_QtModules_Markups
+class vtkMarkupsFiducialGlyphHandleCallback3D : public vtkCommand
+{
+public:
+  static vtkMarkupsFiducialGlyphHandleCallback3D *New()
+  { return new vtkMarkupsFiducialGlyphHandleCallback3D; }
+
+  vtkMarkupsFiducialGlyphHandleCallback3D()
+    : Pipeline(NULL)
+    , Node(NULL)
+    , DisplayableManager(NULL)
+    , PointMovedSinceStartInteraction(false)
+  {
+  }
+
+  virtual void Execute (vtkObject *vtkNotUsed(caller), unsigned long event, void *vtkNotUsed(callData))
+  {
+    // sanity checks
+    if (!this->DisplayableManager || !this->Node || !this->Pipeline)
+      {
+      return;
+      }
+    int markupIndex = this->Pipeline->GetHandleMarkupIndex();
+    if (event == vtkCommand::StartInteractionEvent)
+      {
+      // keep the handle on this markup until the interaction ends
+      this->Pipeline->SetHandleInteracting(true);
+      this->PointMovedSinceStartInteraction = false;
+      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointStartInteractionEvent, &markupIndex);
+      }
+    else if (event == vtkCommand::InteractionEvent)
+      {
+      this->PointMovedSinceStartInteraction = true;
+      this->DisplayableManager->PropagateGlyphHandleToMRML(this->Node, this->Pipeline);
+      }
+    else if (event == vtkCommand::EndInteractionEvent)
+      {
+      this->Pipeline->SetHandleInteracting(false);
+      if (this->Node->GetScene())
+        {
+        this->Node->GetScene()->SaveStateForUndo(this->Node);
+        }
+      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent, &markupIndex);
+      if (!this->PointMovedSinceStartInteraction)
+        {
+        this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointClickedEvent, &markupIndex);
+        }
+      }
+  }
+
+  vtkMRMLMarkupsGlyphPipeline * Pipeline;
+  vtkMRMLMarkupsNode * Node;
+  vtkMRMLMarkupsFiducialDisplayableManager3D * DisplayableManager;
+  bool PointMovedSinceStartInteraction;
+};
+
+//---------------------------------------------------------------------------
+// Interactor callback placing the glyph handle widgets under the mouse
+/// \ingroup Slicer_QtModules_Markups
+class vtkMarkupsFiducialGlyphInteractorCallback3D : public vtkCommand
+{
+public:
+  static vtkMarkupsFiducialGlyphInteractorCallback3D *New()
+  { return new vtkMarkupsFiducialGlyphInteractorCallback3D; }
+
+  vtkMarkupsFiducialGlyphInteractorCallback3D()
+    : DisplayableManager(NULL)
+  {
+  }
+
+  virtual void Execute (vtkObject *caller, unsigned long vtkNotUsed(event), void *vtkNotUsed(callData))
+  {
+    vtkRenderWindowInteractor* interactor = vtkRenderWindowInteractor::SafeDownCast(caller);
+    if (!this->DisplayableManager || !interactor)
+      {
+      return;
+      }
+    // don't pick while the camera is rotated, panned or zoomed
+    vtkInteractorStyle* style = vtkInteractorStyle::SafeDownCast(interactor->GetInteractorStyle());
+    if (style && style->GetState() != VTKIS_NONE)
+      {
+      return;
+      }
+    this->DisplayableManager->UpdateGlyphHandle(interactor->GetEventPosition()[0], interactor->GetEventPosition()[1]);
+  }
+
+  vtkMRMLMarkupsFiducialDisplayableManager3D * DisplayableManager;
+};
+
 //---------------------------------------------------------------------------
 // vtkMRMLMarkupsFiducialDisplayableManager3D methods
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkMRMLMarkupsFiducialDisplayableManager3D()
+{
+  this->Focus = "vtkMRMLMarkupsFiducialNode";
+  this->GlyphRenderingThreshold = 1000;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::~vtkMRMLMarkupsFiducialDisplayableManager3D()
+{
+  if (this->GlyphHandleInteractor && this->GlyphHandleInteractorCallback)
+    {
+    this->GlyphHandleInteractor->RemoveObserver(this->GlyphHandleInteractorCallback);
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialDisplayableManager3D::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "GlyphRenderingThreshold = " << this->GlyphRenderingThreshold << std::endl;
   this->Helper->PrintSelf(os, indent);
 }
 
@@ -275,6 +387,11 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
     {
     return false;
     }
+  if (this->UseGlyphRendering(pointsNode))
+    {
+    // the markups are drawn by the glyph pipeline, there are no seeds
+    return false;
+    }
   vtkSeedWidget *seedWidget = vtkSeedWidget::SafeDownCast(widget);
   if (!seedWidget)
     {
@@ -595,10 +712,26 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateMRMLToWidget(vtkMRMLMa
 
   vtkDebugMacro("Fids PropagateMRMLToWidget, node num markups = " << numberOfFiducials);
 
-  for (int n = 0; n < numberOfFiducials; n++)
+  vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+
+  if (this->UseGlyphRendering(fiducialNode))
     {
-    // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
-    this->SetNthSeed(n, fiducialNode, seedWidget);
+    // too many markups for one handle per markup, remove the seeds created
+    // while the list was smaller and draw all the markups as glyphs
+    for (int n = seedRepresentation->GetNumberOfSeeds() - 1; n >= 0; n--)
+      {
+      seedWidget->DeleteSeed(n);
+      }
+    this->UpdateGlyphPipeline(fiducialNode);
+    }
+  else
+    {
+    this->Helper->RemoveGlyphPipeline(fiducialNode);
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
+      this->SetNthSeed(n, fiducialNode, seedWidget);
+      }
     }
 
   // update lock status
@@ -608,7 +741,6 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateMRMLToWidget(vtkMRMLMa
   // std::cout << "PropagateMRMLToWidget: calling UpdateWidgetVisibility" << std::endl;
   this->UpdateWidgetVisibility(node);
 
-  vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
   seedRepresentation->NeedToRenderOn();
   seedWidget->Modified();
 
@@ -905,6 +1037,17 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdatePosition(vtkAbstractWidge
    return;
    }
 
+  vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(pointsNode);
+  if (fiducialNode && this->UseGlyphRendering(fiducialNode))
+    {
+    this->UpdateGlyphPipeline(fiducialNode);
+    if (this->Updating == 0)
+      {
+      this->RequestRender();
+      }
+    return;
+    }
+
   // now get the widget properties (coordinates, measurement etc.) and if the mrml node has changed, propagate the changes
   bool positionChanged = false;
   int numberOfFiducials = pointsNode->GetNumberOfMarkups();
@@ -955,6 +1098,16 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeNthMarkupModif
    vtkErrorMacro("OnMRMLMarkupsNodeNthMarkupModifiedEvent: Could not get seed widget!")
    return;
    }
+  if (this->UseGlyphRendering(node))
+    {
+    // only the point of the markup is updated, unless it appears or disappears
+    if (!this->UpdateNthGlyph(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), false))
+      {
+      this->PropagateMRMLToWidget(node, seedWidget);
+      }
+    this->RequestRender();
+    return;
+    }
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), seedWidget);
 }
 
@@ -989,6 +1142,19 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
+  if (this->UseGlyphRendering(markupsNode))
+    {
+    // a markup added at the end of a list already drawn with glyphs is
+    // appended, otherwise all the points are inserted again (this also
+    // switches from seeds to glyphs when the threshold is reached)
+    if (!this->UpdateNthGlyph(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), true))
+      {
+      this->PropagateMRMLToWidget(markupsNode, seedWidget);
+      }
+    this->RequestRender();
+    return;
+    }
+
   // this call will create a new handle and set it
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
 
@@ -1019,3 +1185,392 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupRemovedE
   this->Helper->RemoveWidgetAndNode(markupsNode);
   this->AddWidget(markupsNode);
 }
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager3D::UseGlyphRendering(vtkMRMLMarkupsNode* node)
+{
+  return node
+    && this->GlyphRenderingThreshold > 0
+    && node->GetNumberOfMarkups() >= this->GlyphRenderingThreshold;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateGlyphPipeline(vtkMRMLMarkupsFiducialNode* fiducialNode)
+{
+  if (!fiducialNode)
+    {
+    return;
+    }
+  vtkMRMLMarkupsGlyphPipeline* pipeline = this->Helper->GetGlyphPipeline(fiducialNode);
+  if (!pipeline)
+    {
+    vtkNew<vtkMRMLMarkupsGlyphPipeline> newPipeline;
+    this->Helper->RecordGlyphPipelineForNode(newPipeline.GetPointer(), fiducialNode);
+    pipeline = newPipeline.GetPointer();
+    }
+  pipeline->SetRenderer(this->GetRenderer(), false);
+  this->ObserveInteractorForGlyphHandles();
+
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  bool listVisible = this->IsGlyphListVisible(fiducialNode);
+
+  pipeline->ResetPoints();
+  if (listVisible)
+    {
+    int numberOfFiducials = fiducialNode->GetNumberOfMarkups();
+    double worldCoordinates[4];
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      if (fiducialNode->GetNthFiducialVisibility(n) == 0)
+        {
+        continue;
+        }
+      fiducialNode->GetNthFiducialWorldCoordinates(n, worldCoordinates);
+      pipeline->InsertNextPoint(worldCoordinates,
+        fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor(), n);
+      }
+
+    // instanced glyphs can't face the camera like the 2D glyphs of the
+    // handles do, so all glyph types are drawn as spheres
+    if (!pipeline->IsGlyphUpToDate(vtkMRMLMarkupsDisplayNode::Sphere3D, displayNode->GetGlyphScale()))
+      {
+      vtkNew<vtkSphereSource> sphereSource;
+      sphereSource->SetRadius(0.5 * displayNode->GetGlyphScale());
+      sphereSource->SetPhiResolution(10);
+      sphereSource->SetThetaResolution(10);
+      sphereSource->Update();
+      pipeline->SetGlyph(sphereSource->GetOutput(),
+        vtkMRMLMarkupsDisplayNode::Sphere3D, displayNode->GetGlyphScale());
+      }
+
+    pipeline->SetOpacity(displayNode->GetOpacity());
+    pipeline->SetMaterial(displayNode->GetAmbient(), displayNode->GetDiffuse(), displayNode->GetSpecular());
+    }
+  pipeline->PointsModified();
+  pipeline->SetVisibility(pipeline->GetNumberOfPoints() > 0);
+
+  // keep the handle on its markup, unless it is being dragged
+  if (!pipeline->GetHandleInteracting())
+    {
+    this->PlaceGlyphHandle(pipeline->GetHandleMarkupIndex(), fiducialNode, pipeline);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager3D::IsGlyphListVisible(vtkMRMLMarkupsFiducialNode* fiducialNode)
+{
+  // hide the glyphs if the list isn't visible in this view
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  bool listVisible = (displayNode && displayNode->GetVisibility() != 0);
+  vtkMRMLViewNode *viewNode = this->GetMRMLViewNode();
+  if (listVisible && viewNode && displayNode->GetVisibility(viewNode->GetID()) == 0)
+    {
+    listVisible = false;
+    }
+  return listVisible;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthGlyph(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, bool added)
+{
+  if (!fiducialNode || n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+    {
+    return false;
+    }
+  vtkMRMLMarkupsGlyphPipeline* pipeline = this->Helper->GetGlyphPipeline(fiducialNode);
+  if (!pipeline)
+    {
+    return false;
+    }
+  // the indices of the markups after an inserted one have changed, and the
+  // glyph and display properties are only set up when there are points
+  if (added && (n != fiducialNode->GetNumberOfMarkups() - 1 || pipeline->GetLastMarkupIndex() >= n
+                || pipeline->GetNumberOfPoints() == 0))
+    {
+    return false;
+    }
+  if (!this->IsGlyphListVisible(fiducialNode))
+    {
+    // nothing is drawn, unless the list has just been hidden
+    return pipeline->GetNumberOfPoints() == 0;
+    }
+
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  bool visible = (fiducialNode->GetNthFiducialVisibility(n) != 0);
+  if (added)
+    {
+    if (visible)
+      {
+      double worldCoordinates[4];
+      fiducialNode->GetNthFiducialWorldCoordinates(n, worldCoordinates);
+      pipeline->InsertNextPoint(worldCoordinates,
+        fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor(), n);
+      pipeline->PointsModified();
+      }
+    return true;
+    }
+
+  if (visible != (pipeline->GetPointIndex(n) >= 0))
+    {
+    // the point must be inserted or removed
+    return false;
+    }
+  if (visible)
+    {
+    double worldCoordinates[4];
+    fiducialNode->GetNthFiducialWorldCoordinates(n, worldCoordinates);
+    pipeline->SetMarkupPoint(n, worldCoordinates,
+      fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor());
+    pipeline->PointsModified();
+    }
+  // keep the handle on its markup, unless it is being dragged
+  if (pipeline->GetHandleMarkupIndex() == n && !pipeline->GetHandleInteracting())
+    {
+    this->PlaceGlyphHandle(n, fiducialNode, pipeline);
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::PlaceGlyphHandle(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, vtkMRMLMarkupsGlyphPipeline* pipeline)
+{
+  if (!fiducialNode || !pipeline)
+    {
+    return;
+    }
+  vtkHandleWidget *handleWidget = pipeline->GetHandleWidget();
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  if (n < 0 || n >= fiducialNode->GetNumberOfMarkups() ||
+      !displayNode ||
+      fiducialNode->GetNthFiducialVisibility(n) == 0 ||
+      !pipeline->GetActor() || !pipeline->GetActor()->GetVisibility())
+    {
+    if (handleWidget)
+      {
+      handleWidget->Off();
+      }
+    pipeline->SetHandleMarkupIndex(-1);
+    return;
+    }
+
+  if (!handleWidget)
+    {
+    vtkNew<vtkOrientedPolygonalHandleRepresentation3D> newHandleRep;
+    vtkNew<vtkSphereSource> sphereSource;
+    sphereSource->SetRadius(0.5);
+    sphereSource->SetPhiResolution(10);
+    sphereSource->SetThetaResolution(10);
+    sphereSource->Update();
+    newHandleRep->SetHandle(sphereSource->GetOutput());
+
+    vtkNew<vtkHandleWidget> newHandleWidget;
+    newHandleWidget->SetRepresentation(newHandleRep.GetPointer());
+    newHandleWidget->SetInteractor(this->GetInteractor());
+    newHandleWidget->SetCurrentRenderer(this->GetRenderer());
+    newHandleWidget->ManagesCursorOff();
+
+    vtkNew<vtkMarkupsFiducialGlyphHandleCallback3D> callback;
+    callback->Pipeline = pipeline;
+    callback->Node = fiducialNode;
+    callback->DisplayableManager = this;
+    newHandleWidget->AddObserver(vtkCommand::StartInteractionEvent, callback.GetPointer());
+    newHandleWidget->AddObserver(vtkCommand::InteractionEvent, callback.GetPointer());
+    newHandleWidget->AddObserver(vtkCommand::EndInteractionEvent, callback.GetPointer());
+
+    pipeline->SetHandleWidget(newHandleWidget.GetPointer());
+    handleWidget = newHandleWidget.GetPointer();
+    }
+
+  vtkOrientedPolygonalHandleRepresentation3D *handleRep =
+    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(handleWidget->GetRepresentation());
+  if (!handleRep)
+    {
+    return;
+    }
+
+  double worldCoordinates[4];
+  fiducialNode->GetNthFiducialWorldCoordinates(n, worldCoordinates);
+  handleRep->SetWorldPosition(worldCoordinates);
+  handleRep->SetUniformScale(displayNode->GetGlyphScale());
+
+  double *color = fiducialNode->GetNthFiducialSelected(n) ? displayNode->GetSelectedColor() : displayNode->GetColor();
+  handleRep->GetProperty()->SetColor(color);
+  handleRep->GetProperty()->SetOpacity(displayNode->GetOpacity());
+
+  // the glyphs have no labels, show the label of the markup under the mouse
+  std::string textString = fiducialNode->GetNthFiducialLabel(n);
+  handleRep->SetLabelText(textString.c_str());
+  if (textString.compare("") != 0)
+    {
+    double textscale[3] = {displayNode->GetTextScale(), displayNode->GetTextScale(), displayNode->GetTextScale()};
+    handleRep->SetLabelTextScale(textscale);
+    if (handleRep->GetLabelTextActor())
+      {
+      handleRep->GetLabelTextActor()->GetProperty()->SetColor(color);
+      handleRep->GetLabelTextActor()->GetProperty()->SetOpacity(displayNode->GetOpacity());
+      }
+    handleRep->LabelVisibilityOn();
+    }
+  else
+    {
+    handleRep->LabelVisibilityOff();
+    }
+
+  // update locked, as for the seeds
+  int persistentPlaceMode = 0;
+  vtkMRMLInteractionNode *interactionNode = this->GetInteractionNode();
+  if (interactionNode)
+    {
+    persistentPlaceMode =
+      (interactionNode->GetCurrentInteractionMode() == vtkMRMLInteractionNode::Place)
+      && (interactionNode->GetPlaceModePersistence() == 1);
+    }
+  if (fiducialNode->GetLocked() || persistentPlaceMode)
+    {
+    handleWidget->ProcessEventsOff();
+    }
+  else
+    {
+    handleWidget->ProcessEventsOn();
+    handleWidget->SetEnableTranslation(!fiducialNode->GetNthMarkupLocked(n));
+    }
+
+  pipeline->SetHandleMarkupIndex(n);
+  if (!handleWidget->GetEnabled())
+    {
+    handleWidget->On();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::ObserveInteractorForGlyphHandles()
+{
+  vtkRenderWindowInteractor* interactor = this->GetInteractor();
+  if (!interactor || interactor == this->GlyphHandleInteractor)
+    {
+    return;
+    }
+  if (!this->GlyphHandleInteractorCallback)
+    {
+    vtkNew<vtkMarkupsFiducialGlyphInteractorCallback3D> callback;
+    callback->DisplayableManager = this;
+    this->GlyphHandleInteractorCallback = callback.GetPointer();
+    }
+  if (this->GlyphHandleInteractor)
+    {
+    this->GlyphHandleInteractor->RemoveObserver(this->GlyphHandleInteractorCallback);
+    }
+  // higher priority than the widgets so that the handle is in place
+  // before they process the event
+  interactor->AddObserver(vtkCommand::MouseMoveEvent, this->GlyphHandleInteractorCallback, 1.0);
+  this->GlyphHandleInteractor = interactor;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateGlyphHandle(int x, int y)
+{
+  vtkRenderer* renderer = this->GetRenderer();
+  if (!renderer || this->Helper->GlyphPipelines.empty())
+    {
+    return;
+    }
+  vtkMRMLInteractionNode *interactionNode = this->GetInteractionNode();
+  if (interactionNode && interactionNode->GetCurrentInteractionMode() == vtkMRMLInteractionNode::Place)
+    {
+    return;
+    }
+
+  vtkNew<vtkPropCollection> glyphActors;
+  vtkMRMLMarkupsDisplayableManagerHelper::GlyphPipelinesIt it;
+  for (it = this->Helper->GlyphPipelines.begin(); it != this->Helper->GlyphPipelines.end(); ++it)
+    {
+    if (it->second->GetHandleInteracting())
+      {
+      // a markup is being dragged
+      return;
+      }
+    if (it->second->GetActor() && it->second->GetActor()->GetVisibility())
+      {
+      glyphActors->AddItem(it->second->GetActor());
+      }
+    }
+
+  // pick among the glyphs only, then find the markup closest to the picked point
+  vtkMRMLMarkupsGlyphPipeline* pickedPipeline = NULL;
+  int pickedMarkupIndex = -1;
+  if (glyphActors->GetNumberOfItems() > 0)
+    {
+    if (!this->GlyphPicker)
+      {
+      this->GlyphPicker = vtkSmartPointer<vtkPropPicker>::New();
+      }
+    if (this->GlyphPicker->PickProp(x, y, renderer, glyphActors.GetPointer()))
+      {
+      double pickPosition[3];
+      this->GlyphPicker->GetPickPosition(pickPosition);
+      for (it = this->Helper->GlyphPipelines.begin(); it != this->Helper->GlyphPipelines.end(); ++it)
+        {
+        if (it->second->GetActor() != this->GlyphPicker->GetViewProp())
+          {
+          continue;
+          }
+        vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+        vtkMRMLMarkupsDisplayNode* displayNode = (fiducialNode ? fiducialNode->GetMarkupsDisplayNode() : NULL);
+        double tolerance = (displayNode ? displayNode->GetGlyphScale() : 1.0);
+        pickedPipeline = it->second;
+        pickedMarkupIndex = pickedPipeline->FindClosestMarkup(pickPosition, tolerance);
+        break;
+        }
+      }
+    }
+
+  bool handleMoved = false;
+  for (it = this->Helper->GlyphPipelines.begin(); it != this->Helper->GlyphPipelines.end(); ++it)
+    {
+    int n = (it->second == pickedPipeline ? pickedMarkupIndex : -1);
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    if (!fiducialNode || it->second->GetHandleMarkupIndex() == n)
+      {
+      continue;
+      }
+    this->PlaceGlyphHandle(n, fiducialNode, it->second);
+    handleMoved = true;
+    }
+  if (handleMoved)
+    {
+    this->RequestRender();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateGlyphHandleToMRML(vtkMRMLMarkupsNode* node, vtkMRMLMarkupsGlyphPipeline* pipeline)
+{
+  vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(node);
+  if (!fiducialNode || !pipeline || !pipeline->GetHandleWidget())
+    {
+    return;
+    }
+  int n = pipeline->GetHandleMarkupIndex();
+  if (n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+    {
+    return;
+    }
+  vtkHandleRepresentation* handleRep =
+    vtkHandleRepresentation::SafeDownCast(pipeline->GetHandleWidget()->GetRepresentation());
+  if (!handleRep)
+    {
+    return;
+    }
+  double worldCoordinates[4] = {0.0, 0.0, 0.0, 1.0};
+  handleRep->GetWorldPosition(worldCoordinates);
+  double currentCoordinates[4];
+  fiducialNode->GetNthFiducialWorldCoordinates(n, currentCoordinates);
+  if (this->GetWorldCoordinatesChanged(currentCoordinates, worldCoordinates))
+    {
+    // ignore the node modified event, the glyph pipeline is updated by the
+    // point modified event
+    this->Updating = 1;
+    fiducialNode->SetNthFiducialWorldCoordinates(n, worldCoordinates);
+    this->Updating = 0;
+    }
+}
@@ -24,7 +24,15 @@
 // MarkupsModule/MRMLDisplayableManager includes
 #include "vtkMRMLMarkupsDisplayableManager3D.h"
 
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
 class vtkMRMLMarkupsFiducialNode;
+class vtkCommand;
+class vtkMRMLMarkupsGlyphPipeline;
+class vtkPropPicker;
+class vtkRenderWindowInteractor;
 class vtkSlicerViewerWidget;
 class vtkMRMLMarkupsDisplayNode;
 class vtkTextWidget;
@@ -39,10 +47,25 @@ public:
   vtkTypeMacro(vtkMRMLMarkupsFiducialDisplayableManager3D, vtkMRMLMarkupsDisplayableManager3D);
   void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
 
+  /// Fiducial lists with at least this many markups are drawn with a single
+  /// glyph actor instead of one handle widget per markup. A handle widget is
+  /// only placed on the markup under the mouse so that it can be dragged.
+  /// Glyph rendering is disabled if the threshold is not positive.
+  /// Default is 1000.
+  vtkSetMacro(GlyphRenderingThreshold, int);
+  vtkGetMacro(GlyphRenderingThreshold, int);
+
+  /// Move the glyph handle widget onto the markup displayed at the display
+  /// position \a x, \a y, or hide it if there is none. Called on mouse moves.
+  void UpdateGlyphHandle(int x, int y);
+  /// Set the position of the markup the glyph handle widget is placed on
+  /// from the handle widget. Called while the handle is dragged.
+  void PropagateGlyphHandleToMRML(vtkMRMLMarkupsNode* node, vtkMRMLMarkupsGlyphPipeline* pipeline);
+
 protected:
 
-  vtkMRMLMarkupsFiducialDisplayableManager3D(){this->Focus="vtkMRMLMarkupsFiducialNode";}
-  virtual ~vtkMRMLMarkupsFiducialDisplayableManager3D(){}
+  vtkMRMLMarkupsFiducialDisplayableManager3D();
+  virtual ~vtkMRMLMarkupsFiducialDisplayableManager3D();
 
   /// Callback for click in RenderWindow
   virtual void OnClickInRenderWindow(double x, double y, const char *associatedNodeID) VTK_OVERRIDE;
@@ -79,6 +102,26 @@ protected:
   // Clean up when scene closes
   virtual void OnMRMLSceneEndClose() VTK_OVERRIDE;
 
+  /// Return true if the node has enough markups to be drawn with a glyph pipeline
+  bool UseGlyphRendering(vtkMRMLMarkupsNode* node);
+  /// Draw all the markups of the node with its glyph pipeline
+  void UpdateGlyphPipeline(vtkMRMLMarkupsFiducialNode* fiducialNode);
+  /// Update the point of the nth markup in the glyph pipeline of the node,
+  /// or append it if \a added is true. Returns false if all the markups must
+  /// be drawn again with UpdateGlyphPipeline().
+  bool UpdateNthGlyph(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, bool added);
+  /// Return true if the markups of the node are visible in this view
+  bool IsGlyphListVisible(vtkMRMLMarkupsFiducialNode* fiducialNode);
+  /// Place the handle widget of the pipeline on the nth markup, hide it if n is -1
+  void PlaceGlyphHandle(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, vtkMRMLMarkupsGlyphPipeline* pipeline);
+  /// Observe mouse moves on the interactor to place the glyph handle widgets
+  void ObserveInteractorForGlyphHandles();
+
+  int GlyphRenderingThreshold;
+  vtkSmartPointer<vtkCommand> GlyphHandleInteractorCallback;
+  vtkWeakPointer<vtkRenderWindowInteractor> GlyphHandleInteractor;
+  vtkSmartPointer<vtkPropPicker> GlyphPicker;
+
 private:
 
   vtkMRMLMarkupsFiducialDisplayableManager3D(const vtkMRMLMarkupsFiducialDisplayableManager3D&); /// Not implemented
@@ -0,0 +1,331 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MarkupsModule/MRMLDisplayableManager includes
+#include "vtkMRMLMarkupsGlyphPipeline.h"
+
+// VTK includes
+#include <vtkActor.h>
+#include <vtkActor2D.h>
+#include <vtkGlyph2D.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkHandleWidget.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPointLocator.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper2D.h>
+#include <vtkProperty.h>
+#include <vtkProperty2D.h>
+#include <vtkRenderer.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <algorithm>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro (vtkMRMLMarkupsGlyphPipeline);
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsGlyphPipeline::vtkMRMLMarkupsGlyphPipeline()
+{
+  this->TwoDimensional = false;
+  this->HandleMarkupIndex = -1;
+  this->HandleInteracting = false;
+  this->GlyphType = -1;
+  this->GlyphScale = 0.0;
+
+  this->Points = vtkSmartPointer<vtkPoints>::New();
+  this->Colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  this->Colors->SetName("Colors");
+  this->Colors->SetNumberOfComponents(3);
+  this->PolyData = vtkSmartPointer<vtkPolyData>::New();
+  this->PolyData->SetPoints(this->Points);
+  this->PolyData->GetPointData()->SetScalars(this->Colors);
+  this->Locator = vtkSmartPointer<vtkPointLocator>::New();
+  this->Locator->SetDataSet(this->PolyData);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsGlyphPipeline::~vtkMRMLMarkupsGlyphPipeline()
+{
+  this->RemoveFromRenderer();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "TwoDimensional = " << this->TwoDimensional << std::endl;
+  os << indent << "NumberOfPoints = " << this->GetNumberOfPoints() << std::endl;
+  os << indent << "HandleMarkupIndex = " << this->HandleMarkupIndex << std::endl;
+  os << indent << "HandleInteracting = " << this->HandleInteracting << std::endl;
+  os << indent << "GlyphType = " << this->GlyphType << std::endl;
+  os << indent << "GlyphScale = " << this->GlyphScale << std::endl;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetRenderer(vtkRenderer* renderer, bool twoDimensional)
+{
+  if (this->Renderer == renderer && this->TwoDimensional == twoDimensional && this->Actor)
+    {
+    return;
+    }
+  this->RemoveFromRenderer();
+  this->TwoDimensional = twoDimensional;
+
+  if (this->TwoDimensional)
+    {
+    // glyphs are generated in display coordinates, there are few enough
+    // points on a slice to not need instancing
+    this->Mapper3D = NULL;
+    this->Glyph2D = vtkSmartPointer<vtkGlyph2D>::New();
+    this->Glyph2D->SetInputData(this->PolyData);
+    this->Glyph2D->ScalingOff();
+    this->Glyph2D->OrientOff();
+    this->Glyph2D->SetColorModeToColorByScalar();
+    if (this->Glyph)
+      {
+      this->Glyph2D->SetSourceData(this->Glyph);
+      }
+    vtkNew<vtkPolyDataMapper2D> mapper;
+    mapper->SetInputConnection(this->Glyph2D->GetOutputPort());
+    mapper->ScalarVisibilityOn();
+    vtkNew<vtkActor2D> actor;
+    actor->SetMapper(mapper.GetPointer());
+    this->Actor = actor.GetPointer();
+    }
+  else
+    {
+    this->Glyph2D = NULL;
+    this->Mapper3D = vtkSmartPointer<vtkGlyph3DMapper>::New();
+    this->Mapper3D->SetInputData(this->PolyData);
+    this->Mapper3D->ScalingOff();
+    this->Mapper3D->OrientOff();
+    this->Mapper3D->ScalarVisibilityOn();
+    this->Mapper3D->SetScalarModeToUsePointData();
+    if (this->Glyph)
+      {
+      this->Mapper3D->SetSourceData(this->Glyph);
+      }
+    vtkNew<vtkActor> actor;
+    actor->SetMapper(this->Mapper3D);
+    this->Actor = actor.GetPointer();
+    }
+
+  this->Renderer = renderer;
+  if (this->Renderer)
+    {
+    this->Renderer->AddViewProp(this->Actor);
+    }
+}
+
+//---------------------------------------------------------------------------
+vtkRenderer* vtkMRMLMarkupsGlyphPipeline::GetRenderer()
+{
+  return this->Renderer;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::RemoveFromRenderer()
+{
+  if (this->HandleWidget)
+    {
+    this->HandleWidget->Off();
+    }
+  if (this->Renderer && this->Actor)
+    {
+    this->Renderer->RemoveViewProp(this->Actor);
+    }
+  this->Renderer = NULL;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::ResetPoints()
+{
+  this->Points->Reset();
+  this->Colors->Reset();
+  this->MarkupIndices.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::InsertNextPoint(const double position[3], const double color[3], int markupIndex)
+{
+  this->Points->InsertNextPoint(position);
+  this->Colors->InsertNextTuple3(color[0] * 255.0, color[1] * 255.0, color[2] * 255.0);
+  this->MarkupIndices.push_back(markupIndex);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsGlyphPipeline::SetMarkupPoint(int markupIndex, const double position[3], const double color[3])
+{
+  int pointIndex = this->GetPointIndex(markupIndex);
+  if (pointIndex < 0)
+    {
+    return false;
+    }
+  this->Points->SetPoint(pointIndex, position);
+  this->Colors->SetTuple3(pointIndex, color[0] * 255.0, color[1] * 255.0, color[2] * 255.0);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsGlyphPipeline::GetPointIndex(int markupIndex)
+{
+  std::vector<int>::iterator it =
+    std::lower_bound(this->MarkupIndices.begin(), this->MarkupIndices.end(), markupIndex);
+  if (it == this->MarkupIndices.end() || *it != markupIndex)
+    {
+    return -1;
+    }
+  return static_cast<int>(it - this->MarkupIndices.begin());
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsGlyphPipeline::GetLastMarkupIndex()
+{
+  return this->MarkupIndices.empty() ? -1 : this->MarkupIndices.back();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::PointsModified()
+{
+  this->Points->Modified();
+  this->Colors->Modified();
+  this->PolyData->Modified();
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsGlyphPipeline::GetNumberOfPoints()
+{
+  return static_cast<int>(this->MarkupIndices.size());
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetGlyph(vtkPolyData* glyph)
+{
+  this->SetGlyph(glyph, -1, 0.0);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetGlyph(vtkPolyData* glyph, int glyphType, double glyphScale)
+{
+  this->Glyph = glyph;
+  this->GlyphType = glyphType;
+  this->GlyphScale = glyphScale;
+  if (this->Glyph2D)
+    {
+    this->Glyph2D->SetSourceData(glyph);
+    }
+  if (this->Mapper3D)
+    {
+    this->Mapper3D->SetSourceData(glyph);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsGlyphPipeline::IsGlyphUpToDate(int glyphType, double glyphScale)
+{
+  return this->Glyph != NULL
+    && this->GlyphType >= 0
+    && this->GlyphType == glyphType
+    && this->GlyphScale == glyphScale;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetVisibility(bool visible)
+{
+  if (this->Actor)
+    {
+    this->Actor->SetVisibility(visible);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetOpacity(double opacity)
+{
+  vtkActor2D* actor2D = vtkActor2D::SafeDownCast(this->Actor);
+  if (actor2D)
+    {
+    actor2D->GetProperty()->SetOpacity(opacity);
+    }
+  vtkActor* actor = vtkActor::SafeDownCast(this->Actor);
+  if (actor)
+    {
+    actor->GetProperty()->SetOpacity(opacity);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetMaterial(double ambient, double diffuse, double specular)
+{
+  vtkActor* actor = vtkActor::SafeDownCast(this->Actor);
+  if (actor)
+    {
+    actor->GetProperty()->SetAmbient(ambient);
+    actor->GetProperty()->SetDiffuse(diffuse);
+    actor->GetProperty()->SetSpecular(specular);
+    }
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsGlyphPipeline::FindClosestMarkup(const double position[3], double tolerance)
+{
+  if (this->MarkupIndices.empty())
+    {
+    return -1;
+    }
+  // only rebuilt if the points were modified since the last search
+  this->Locator->BuildLocator();
+  double distance2 = 0.0;
+  vtkIdType pointId = this->Locator->FindClosestPointWithinRadius(tolerance, position, distance2);
+  if (pointId < 0 || pointId >= static_cast<vtkIdType>(this->MarkupIndices.size()))
+    {
+    return -1;
+    }
+  return this->MarkupIndices[pointId];
+}
+
+//---------------------------------------------------------------------------
+vtkProp* vtkMRMLMarkupsGlyphPipeline::GetActor()
+{
+  return this->Actor;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsGlyphPipeline::SetHandleWidget(vtkHandleWidget* widget)
+{
+  if (this->HandleWidget == widget)
+    {
+    return;
+    }
+  if (this->HandleWidget)
+    {
+    this->HandleWidget->Off();
+    }
+  this->HandleWidget = widget;
+  this->HandleMarkupIndex = -1;
+  this->HandleInteracting = false;
+}
+
+//---------------------------------------------------------------------------
+vtkHandleWidget* vtkMRMLMarkupsGlyphPipeline::GetHandleWidget()
+{
+  return this->HandleWidget;
+}
@@ -0,0 +1,156 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+/// .NAME vtkMRMLMarkupsGlyphPipeline - render all points of a markups node with one actor
+/// .SECTION Description
+/// Markups nodes with many points are too slow to display with one handle
+/// widget per point. This class draws all the points of a node in a view as
+/// a single glyph-mapped actor and keeps a point locator to find the markup
+/// under the mouse. A single handle widget can be attached to the pipeline:
+/// the displayable manager moves it onto the markup under the mouse so that
+/// only that markup can be dragged.
+///
+/// Two dimensional pipelines expect points in display (XY) coordinates of a
+/// slice view and draw them with a vtkActor2D, three dimensional pipelines
+/// expect world coordinates and draw instanced glyphs with a vtkGlyph3DMapper.
+
+#ifndef __vtkMRMLMarkupsGlyphPipeline_h
+#define __vtkMRMLMarkupsGlyphPipeline_h
+
+// MarkupsModule includes
+#include "vtkSlicerMarkupsModuleMRMLDisplayableManagerExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+class vtkGlyph2D;
+class vtkGlyph3DMapper;
+class vtkHandleWidget;
+class vtkPointLocator;
+class vtkPoints;
+class vtkPolyData;
+class vtkProp;
+class vtkRenderer;
+class vtkUnsignedCharArray;
+
+/// \ingroup Slicer_QtModules_Markups
+class VTK_SLICER_MARKUPS_MODULE_MRMLDISPLAYABLEMANAGER_EXPORT vtkMRMLMarkupsGlyphPipeline :
+    public vtkObject
+{
+public:
+
+  static vtkMRMLMarkupsGlyphPipeline *New();
+  vtkTypeMacro(vtkMRMLMarkupsGlyphPipeline, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Create the actor and add it to the renderer.
+  /// Any previously used renderer is released.
+  void SetRenderer(vtkRenderer* renderer, bool twoDimensional);
+  vtkRenderer* GetRenderer();
+  /// Remove the actor and the handle widget from the renderer.
+  void RemoveFromRenderer();
+
+  /// Remove all the points, call before inserting them again.
+  void ResetPoints();
+  /// Add a point. \a markupIndex is the index of the markup in the markups
+  /// node, it must be larger than the index of the markups already inserted.
+  void InsertNextPoint(const double position[3], const double color[3], int markupIndex);
+  /// Move the point of a markup and change its color, without inserting the
+  /// other points again. Returns false if the markup has no point.
+  bool SetMarkupPoint(int markupIndex, const double position[3], const double color[3]);
+  /// Index of the point displaying the markup, -1 if the markup has no point.
+  int GetPointIndex(int markupIndex);
+  /// Index of the markup with the largest index that has a point, -1 if none.
+  int GetLastMarkupIndex();
+  /// Notify the pipeline that the points changed.
+  void PointsModified();
+  /// Number of points currently displayed
+  int GetNumberOfPoints();
+
+  /// Set the glyph drawn at each point. The glyph must already be scaled.
+  void SetGlyph(vtkPolyData* glyph);
+  /// Set the glyph drawn at each point and the parameters it was created
+  /// with, see IsGlyphUpToDate().
+  void SetGlyph(vtkPolyData* glyph, int glyphType, double glyphScale);
+  /// Return true if the current glyph has been created with these parameters
+  /// and does not need to be created again.
+  bool IsGlyphUpToDate(int glyphType, double glyphScale);
+
+  /// Display properties
+  void SetVisibility(bool visible);
+  void SetOpacity(double opacity);
+  /// Material properties, ignored by two dimensional pipelines.
+  void SetMaterial(double ambient, double diffuse, double specular);
+
+  /// Return the index of the markup displayed closest to \a position or -1
+  /// if no point is closer than \a tolerance.
+  int FindClosestMarkup(const double position[3], double tolerance);
+
+  /// Actor drawing the glyphs, used to restrict picking to the glyphs.
+  vtkProp* GetActor();
+
+  /// Widget used for moving the markup under the mouse. The pipeline takes a
+  /// reference on it and turns it off when removed from the renderer.
+  void SetHandleWidget(vtkHandleWidget* widget);
+  vtkHandleWidget* GetHandleWidget();
+
+  /// Index of the markup the handle widget is placed on, -1 if none.
+  vtkSetMacro(HandleMarkupIndex, int);
+  vtkGetMacro(HandleMarkupIndex, int);
+
+  /// Set while the handle widget is dragged, the handle must not be moved to
+  /// another markup meanwhile.
+  vtkSetMacro(HandleInteracting, bool);
+  vtkGetMacro(HandleInteracting, bool);
+
+protected:
+
+  vtkMRMLMarkupsGlyphPipeline();
+  virtual ~vtkMRMLMarkupsGlyphPipeline();
+
+  bool TwoDimensional;
+  int HandleMarkupIndex;
+  bool HandleInteracting;
+  int GlyphType;
+  double GlyphScale;
+
+  vtkSmartPointer<vtkRenderer> Renderer;
+  vtkSmartPointer<vtkPolyData> PolyData;
+  vtkSmartPointer<vtkPolyData> Glyph;
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkUnsignedCharArray> Colors;
+  vtkSmartPointer<vtkPointLocator> Locator;
+  vtkSmartPointer<vtkGlyph3DMapper> Mapper3D;
+  vtkSmartPointer<vtkGlyph2D> Glyph2D;
+  vtkSmartPointer<vtkProp> Actor;
+  vtkSmartPointer<vtkHandleWidget> HandleWidget;
+
+  /// Markup index of each point of PolyData, in increasing order. Hidden
+  /// markups are not inserted.
+  std::vector<int> MarkupIndices;
+
+private:
+
+  vtkMRMLMarkupsGlyphPipeline(const vtkMRMLMarkupsGlyphPipeline&); /// Not implemented
+  void operator=(const vtkMRMLMarkupsGlyphPipeline&); /// Not Implemented
+};
+
+#endif
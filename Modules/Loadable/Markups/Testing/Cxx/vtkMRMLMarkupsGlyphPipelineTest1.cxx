@@ -0,0 +1,290 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MarkupsModule/MRMLDisplayableManager includes
+#include "vtkMRMLMarkupsGlyphPipeline.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkActor.h>
+#include <vtkActor2D.h>
+#include <vtkAlgorithm.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkHandleWidget.h>
+#include <vtkMapper2D.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPropCollection.h>
+#include <vtkRenderer.h>
+
+namespace
+{
+
+const int numberOfMarkupsPerAxis = 40;
+
+//----------------------------------------------------------------------------
+/// Insert a grid of markups, every 10th markup is hidden and not inserted.
+/// Markups are 2 units apart.
+void InsertMarkups(vtkMRMLMarkupsGlyphPipeline* pipeline)
+{
+  pipeline->ResetPoints();
+  double color[3] = {1.0, 0.5, 0.0};
+  for (int markupIndex = 0; markupIndex < numberOfMarkupsPerAxis * numberOfMarkupsPerAxis; ++markupIndex)
+    {
+    if (markupIndex % 10 == 9)
+      {
+      continue;
+      }
+    double position[3] =
+      {
+      2.0 * (markupIndex % numberOfMarkupsPerAxis),
+      2.0 * (markupIndex / numberOfMarkupsPerAxis),
+      0.0
+      };
+    pipeline->InsertNextPoint(position, color, markupIndex);
+    }
+  pipeline->PointsModified();
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateTriangleGlyph()
+{
+  vtkNew<vtkPoints> points;
+  points->InsertNextPoint(-0.5, -0.5, 0.0);
+  points->InsertNextPoint(0.5, -0.5, 0.0);
+  points->InsertNextPoint(0.0, 0.5, 0.0);
+  vtkIdType triangle[3] = {0, 1, 2};
+  vtkSmartPointer<vtkPolyData> glyph = vtkSmartPointer<vtkPolyData>::New();
+  glyph->SetPoints(points.GetPointer());
+  glyph->Allocate(1);
+  glyph->InsertNextCell(VTK_TRIANGLE, 3, triangle);
+  return glyph;
+}
+
+//----------------------------------------------------------------------------
+int TestFindClosestMarkup()
+{
+  vtkNew<vtkMRMLMarkupsGlyphPipeline> pipeline;
+  double position[3] = {0.0, 0.0, 0.0};
+  CHECK_INT(pipeline->FindClosestMarkup(position, 1.0), -1);
+
+  InsertMarkups(pipeline.GetPointer());
+  int expectedNumberOfPoints = numberOfMarkupsPerAxis * numberOfMarkupsPerAxis * 9 / 10;
+  CHECK_INT(pipeline->GetNumberOfPoints(), expectedNumberOfPoints);
+
+  // The markup index is returned, not the index of the point
+  position[0] = 2.0 * 12 + 0.3;
+  position[1] = 2.0 * 3 - 0.2;
+  CHECK_INT(pipeline->FindClosestMarkup(position, 0.5), 3 * numberOfMarkupsPerAxis + 12);
+  // Hidden markups are not found
+  position[0] = 2.0 * 9 + 0.1;
+  CHECK_INT(pipeline->FindClosestMarkup(position, 0.5), -1);
+  CHECK_INT(pipeline->FindClosestMarkup(position, 2.5), 3 * numberOfMarkupsPerAxis + 10);
+  // Far from any markup
+  position[2] = 5.0;
+  CHECK_INT(pipeline->FindClosestMarkup(position, 0.5), -1);
+
+  // Locator follows the modified points
+  pipeline->ResetPoints();
+  double color[3] = {1.0, 1.0, 1.0};
+  double movedPosition[3] = {100.0, 100.0, 100.0};
+  pipeline->InsertNextPoint(movedPosition, color, 7);
+  pipeline->PointsModified();
+  CHECK_INT(pipeline->GetNumberOfPoints(), 1);
+  CHECK_INT(pipeline->FindClosestMarkup(movedPosition, 0.5), 7);
+  position[0] = 2.0 * 12;
+  position[1] = 2.0 * 3;
+  position[2] = 0.0;
+  CHECK_INT(pipeline->FindClosestMarkup(position, 0.5), -1);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestUpdateMarkupPoint()
+{
+  vtkNew<vtkMRMLMarkupsGlyphPipeline> pipeline;
+  CHECK_INT(pipeline->GetLastMarkupIndex(), -1);
+  InsertMarkups(pipeline.GetPointer());
+  int numberOfPoints = pipeline->GetNumberOfPoints();
+  CHECK_INT(pipeline->GetLastMarkupIndex(), numberOfMarkupsPerAxis * numberOfMarkupsPerAxis - 1);
+
+  // The point index skips the hidden markups
+  CHECK_INT(pipeline->GetPointIndex(0), 0);
+  CHECK_INT(pipeline->GetPointIndex(25), 23);
+  CHECK_INT(pipeline->GetPointIndex(19), -1);
+  CHECK_INT(pipeline->GetPointIndex(-1), -1);
+  CHECK_INT(pipeline->GetPointIndex(numberOfMarkupsPerAxis * numberOfMarkupsPerAxis), -1);
+
+  // Only the point of the markup is moved
+  double color[3] = {0.0, 0.0, 1.0};
+  double movedPosition[3] = {100.0, 100.0, 100.0};
+  CHECK_BOOL(pipeline->SetMarkupPoint(25, movedPosition, color), true);
+  pipeline->PointsModified();
+  CHECK_INT(pipeline->GetNumberOfPoints(), numberOfPoints);
+  CHECK_INT(pipeline->FindClosestMarkup(movedPosition, 0.5), 25);
+  double position[3] = {2.0 * 25, 0.0, 0.0};
+  CHECK_INT(pipeline->FindClosestMarkup(position, 0.5), -1);
+  position[0] = 2.0 * 24;
+  CHECK_INT(pipeline->FindClosestMarkup(position, 0.5), 24);
+
+  // Hidden markups have no point to move
+  CHECK_BOOL(pipeline->SetMarkupPoint(19, movedPosition, color), false);
+
+  // Appended markups are found
+  double appendedPosition[3] = {-50.0, 0.0, 0.0};
+  int appendedMarkupIndex = numberOfMarkupsPerAxis * numberOfMarkupsPerAxis;
+  pipeline->InsertNextPoint(appendedPosition, color, appendedMarkupIndex);
+  pipeline->PointsModified();
+  CHECK_INT(pipeline->GetNumberOfPoints(), numberOfPoints + 1);
+  CHECK_INT(pipeline->GetLastMarkupIndex(), appendedMarkupIndex);
+  CHECK_INT(pipeline->GetPointIndex(appendedMarkupIndex), numberOfPoints);
+  CHECK_INT(pipeline->FindClosestMarkup(appendedPosition, 0.5), appendedMarkupIndex);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestGlyphUpToDate()
+{
+  vtkNew<vtkRenderer> renderer3D;
+  vtkNew<vtkRenderer> renderer2D;
+  vtkNew<vtkMRMLMarkupsGlyphPipeline> pipeline;
+  CHECK_BOOL(pipeline->IsGlyphUpToDate(1, 2.0), false);
+
+  pipeline->SetRenderer(renderer3D.GetPointer(), false);
+  vtkSmartPointer<vtkPolyData> glyph = CreateTriangleGlyph();
+  pipeline->SetGlyph(glyph, 1, 2.0);
+  CHECK_BOOL(pipeline->IsGlyphUpToDate(1, 2.0), true);
+  CHECK_BOOL(pipeline->IsGlyphUpToDate(2, 2.0), false);
+  CHECK_BOOL(pipeline->IsGlyphUpToDate(1, 3.0), false);
+
+  // The glyph is kept when the actor is replaced
+  pipeline->SetRenderer(renderer2D.GetPointer(), true);
+  CHECK_BOOL(pipeline->IsGlyphUpToDate(1, 2.0), true);
+  vtkActor2D* actor = vtkActor2D::SafeDownCast(pipeline->GetActor());
+  CHECK_NOT_NULL(actor);
+  vtkAlgorithm* glyphFilter = actor->GetMapper()->GetInputAlgorithm();
+  CHECK_NOT_NULL(glyphFilter);
+  CHECK_POINTER(glyphFilter->GetInputDataObject(1, 0), glyph.GetPointer());
+
+  // A glyph set without parameters is never up to date
+  pipeline->SetGlyph(glyph);
+  CHECK_BOOL(pipeline->IsGlyphUpToDate(1, 2.0), false);
+
+  pipeline->RemoveFromRenderer();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestPipeline3D()
+{
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkMRMLMarkupsGlyphPipeline> pipeline;
+  pipeline->SetRenderer(renderer.GetPointer(), false);
+  CHECK_POINTER(pipeline->GetRenderer(), renderer.GetPointer());
+  vtkActor* actor = vtkActor::SafeDownCast(pipeline->GetActor());
+  CHECK_NOT_NULL(actor);
+  CHECK_BOOL(renderer->GetViewProps()->IsItemPresent(actor) != 0, true);
+
+  // All the markups are drawn by a single actor
+  InsertMarkups(pipeline.GetPointer());
+  vtkSmartPointer<vtkPolyData> glyph = CreateTriangleGlyph();
+  pipeline->SetGlyph(glyph);
+  vtkGlyph3DMapper* mapper = vtkGlyph3DMapper::SafeDownCast(actor->GetMapper());
+  CHECK_NOT_NULL(mapper);
+  CHECK_POINTER(mapper->GetSource(), glyph.GetPointer());
+  CHECK_INT(mapper->GetInput()->GetNumberOfPoints(), pipeline->GetNumberOfPoints());
+  CHECK_INT(renderer->GetViewProps()->GetNumberOfItems(), 1);
+
+  pipeline->SetVisibility(false);
+  CHECK_INT(actor->GetVisibility(), 0);
+  pipeline->SetVisibility(true);
+  CHECK_INT(actor->GetVisibility(), 1);
+
+  pipeline->RemoveFromRenderer();
+  CHECK_NULL(pipeline->GetRenderer());
+  CHECK_INT(renderer->GetViewProps()->GetNumberOfItems(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestPipeline2D()
+{
+  vtkNew<vtkRenderer> renderer3D;
+  vtkNew<vtkRenderer> renderer2D;
+  vtkNew<vtkMRMLMarkupsGlyphPipeline> pipeline;
+  pipeline->SetRenderer(renderer3D.GetPointer(), false);
+
+  // Switching to a slice view replaces the actor
+  pipeline->SetRenderer(renderer2D.GetPointer(), true);
+  CHECK_INT(renderer3D->GetViewProps()->GetNumberOfItems(), 0);
+  vtkActor2D* actor = vtkActor2D::SafeDownCast(pipeline->GetActor());
+  CHECK_NOT_NULL(actor);
+  CHECK_BOOL(renderer2D->GetViewProps()->IsItemPresent(actor) != 0, true);
+
+  // Glyphs are generated for all the points
+  InsertMarkups(pipeline.GetPointer());
+  vtkSmartPointer<vtkPolyData> glyph = CreateTriangleGlyph();
+  pipeline->SetGlyph(glyph);
+  vtkAlgorithm* glyphFilter = actor->GetMapper()->GetInputAlgorithm();
+  CHECK_NOT_NULL(glyphFilter);
+  glyphFilter->Update();
+  vtkPolyData* glyphs = vtkPolyData::SafeDownCast(glyphFilter->GetOutputDataObject(0));
+  CHECK_NOT_NULL(glyphs);
+  CHECK_INT(glyphs->GetNumberOfPoints(), pipeline->GetNumberOfPoints() * glyph->GetNumberOfPoints());
+  CHECK_INT(glyphs->GetNumberOfCells(), pipeline->GetNumberOfPoints());
+
+  // Glyphs are updated when the points are modified
+  pipeline->ResetPoints();
+  double position[3] = {10.0, 20.0, 0.0};
+  double color[3] = {0.0, 1.0, 0.0};
+  pipeline->InsertNextPoint(position, color, 3);
+  pipeline->PointsModified();
+  glyphFilter->Update();
+  CHECK_INT(glyphs->GetNumberOfPoints(), glyph->GetNumberOfPoints());
+
+  // The handle is turned off and released from the markup when removed
+  vtkNew<vtkHandleWidget> handleWidget;
+  pipeline->SetHandleMarkupIndex(3);
+  pipeline->SetHandleWidget(handleWidget.GetPointer());
+  CHECK_POINTER(pipeline->GetHandleWidget(), handleWidget.GetPointer());
+  CHECK_INT(pipeline->GetHandleMarkupIndex(), -1);
+  CHECK_BOOL(pipeline->GetHandleInteracting(), false);
+  pipeline->RemoveFromRenderer();
+  CHECK_INT(handleWidget->GetEnabled(), 0);
+  CHECK_INT(renderer2D->GetViewProps()->GetNumberOfItems(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsGlyphPipelineTest1(int , char * [] )
+{
+  CHECK_EXIT_SUCCESS(TestFindClosestMarkup());
+  CHECK_EXIT_SUCCESS(TestUpdateMarkupPoint());
+  CHECK_EXIT_SUCCESS(TestGlyphUpToDate());
+  CHECK_EXIT_SUCCESS(TestPipeline3D());
+  CHECK_EXIT_SUCCESS(TestPipeline2D());
+  return EXIT_SUCCESS;
+}
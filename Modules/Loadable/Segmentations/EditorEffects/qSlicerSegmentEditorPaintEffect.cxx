@@ -47,10 +47,8 @@
 #include <vtkGlyph2D.h>
 #include <vtkGlyph3D.h>
 #include <vtkIdList.h>
-#include <vtkImageChangeInformation.h>
 #include <vtkImageStencil.h>
 #include <vtkImageStencilData.h>
-#include <vtkImageStencilToImage.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -362,82 +360,21 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
 
   QList<int> updateExtentList;
 
+  int updateExtent[6] = { 0, -1, 0, -1, 0, -1 };
   if (q->integerParameter("BrushPixelMode"))
     {
-    this->paintPixels(viewWidget, this->PaintCoordinates_World);
+    this->paintPixels(viewWidget, this->PaintCoordinates_World, updateExtent);
     }
   else
     {
     this->updateBrushStencil(viewWidget);
-
     this->BrushPolyDataToStencil->Update();
-    vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-    int stencilExtent[6]={0,-1,0,-1,0,-1};
-    stencilData->GetExtent(stencilExtent);
-
-    vtkNew<vtkTransform> worldToModifierLabelmapIjkTransform;
-
-    vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
-    modifierLabelmap->GetWorldToImageMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-    worldToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-
-    vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
-    // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
-    // TODO: show a meaningful error message to the user if attempted
-    vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(NULL, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
-    worldToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
-
-    vtkNew<vtkPoints> paintCoordinates_Ijk;
-    worldToModifierLabelmapIjkTransform->TransformPoints(this->PaintCoordinates_World, paintCoordinates_Ijk.GetPointer());
-
-    vtkNew<vtkImageStencilToImage> stencilToImage;
-    stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-    stencilToImage->SetInsideValue(q->m_FillValue);
-    stencilToImage->SetOutsideValue(q->m_EraseValue);
-    stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-    vtkNew<vtkImageChangeInformation> brushPositioner;
-    brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-    brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-    brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
-
-    vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
-    int updateExtent[6] = { 0, -1, 0, -1, 0, -1 };
-    for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
-      {
-      double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
-      int shift[3] = {int(shiftDouble[0]+0.5), int(shiftDouble[1]+0.5), int(shiftDouble[2]+0.5)};
-      brushPositioner->SetExtentTranslation(shift);
-      brushPositioner->Update();
-      vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-      orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
-      orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
-      if (pointIndex == 0)
-        {
-        orientedBrushPositionerOutput->GetExtent(updateExtent);
-        }
-      else
-        {
-        int* brushExtent = orientedBrushPositionerOutput->GetExtent();
-        for (int i = 0; i < 3; i++)
-          {
-          if (brushExtent[i * 2] < updateExtent[i * 2])
-            {
-            updateExtent[i * 2] = brushExtent[i * 2];
-            }
-          if (brushExtent[i * 2 + 1] > updateExtent[i * 2 + 1])
-            {
-            updateExtent[i * 2 + 1] = brushExtent[i * 2 + 1];
-            }
-          }
-        }
-      vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
-      }
-    modifierLabelmap->Modified();
-    for (int i = 0; i < 6; i++)
-      {
-      updateExtentList << updateExtent[i];
-      }
+    // Brush is swept along all the points and written into the modifier labelmap in one pass
+    this->paintStroke(this->BrushPolyDataToStencil->GetOutput(), this->PaintCoordinates_World, updateExtent);
+    }
+  for (int i = 0; i < 6; i++)
+    {
+    updateExtentList << updateExtent[i];
     }
   this->PaintCoordinates_World->Reset();
 
@@ -520,7 +457,8 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintPixel(qMRMLWidget* viewWidget,
 //-----------------------------------------------------------------------------
 void qSlicerSegmentEditorPaintEffectPrivate::paintPixels(
     qMRMLWidget* viewWidget,
-    vtkPoints* pixelPositions)
+    vtkPoints* pixelPositions,
+    int updateExtent[6]/*=NULL*/)
 {
   Q_UNUSED(viewWidget);
 
@@ -529,33 +467,54 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintPixels(
     qCritical() << Q_FUNC_INFO << ": Invalid pixelPositions";
     return;
     }
-  /*
-  TODO: implement
+
+  // Single voxel brush
+  this->paintStroke(NULL, pixelPositions, updateExtent);
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerSegmentEditorPaintEffectPrivate::paintStroke(
+    vtkImageStencilData* brushStencil,
+    vtkPoints* paintCoordinates_World,
+    int updateExtent[6]/*=NULL*/)
+{
+  Q_Q(qSlicerSegmentEditorPaintEffect);
+
+  if (!q->parameterSetNode())
+    {
+    qCritical() << Q_FUNC_INFO << ": Invalid segment editor parameter set node!";
+    return false;
+    }
+  vtkMRMLSegmentationNode* segmentationNode = q->parameterSetNode()->GetSegmentationNode();
+  if (!segmentationNode)
+    {
+    qCritical() << Q_FUNC_INFO << ": Invalid segmentationNode";
+    return false;
+    }
   vtkOrientedImageData* modifierLabelmap = q->modifierLabelmap();
   if (!modifierLabelmap)
     {
-    return;
+    qCritical() << Q_FUNC_INFO << ": Invalid modifierLabelmap";
+    return false;
     }
 
-  int dims[3] = { 0, 0, 0 };
-  modifierLabelmap->GetDimensions(dims);
+  vtkNew<vtkTransform> worldToModifierLabelmapIjkTransform;
 
-  double valueToSet = (q->m_Erase ? q->m_EraseValue : q->m_FillValue);
+  vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
+  modifierLabelmap->GetWorldToImageMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
+  worldToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
 
-  vtkIdType numberOfPoints = pixelPositions->GetNumberOfPoints();
-  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
-    {
-    int ijk[3] = { 0, 0, 0 };
-    q->xyzToIjk(pixelPositions->GetPoint(pointIndex), ijk, sliceWidget, modifierLabelmap);
+  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
+  // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
+  // TODO: show a meaningful error message to the user if attempted
+  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(NULL, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
+  worldToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
 
-    // Clamp to image extent
-    if (ijk[0] < 0 || ijk[0] >= dims[0]) { continue; }
-    if (ijk[1] < 0 || ijk[1] >= dims[1]) { continue; }
-    if (ijk[2] < 0 || ijk[2] >= dims[2]) { continue; }
+  vtkNew<vtkPoints> paintCoordinates_Ijk;
+  worldToModifierLabelmapIjkTransform->TransformPoints(paintCoordinates_World, paintCoordinates_Ijk.GetPointer());
 
-    modifierLabelmap->SetScalarComponentFromDouble(ijk[0], ijk[1], ijk[2], 0, valueToSet);
-    }
-  */
+  return vtkOrientedImageDataResample::PaintStroke(modifierLabelmap, brushStencil,
+    paintCoordinates_Ijk.GetPointer(), q->m_FillValue, updateExtent);
 }
 
 //-----------------------------------------------------------------------------
@@ -62,6 +62,7 @@ class qMRMLSliceWidget;
 class qMRMLSpinBox;
 class vtkActor2D;
 class vtkGlyph3D;
+class vtkImageStencilData;
 class vtkPoints;
 class vtkPolyDataNormals;
 class vtkPolyDataToImageStencil;
@@ -108,7 +109,12 @@ protected:
 
   /// Paint one pixel to coordinate
   void paintPixel(qMRMLWidget* viewWidget, double brushPosition_World[3]);
-  void paintPixels(qMRMLWidget* viewWidget, vtkPoints* pixelPositions);
+  /// Paint pixels to coordinates. Extent of the painted region is returned in updateExtent.
+  void paintPixels(qMRMLWidget* viewWidget, vtkPoints* pixelPositions, int updateExtent[6]=NULL);
+
+  /// Paint brush stencil into the modifier labelmap along all the points, in a single pass.
+  /// Single voxels are painted if brushStencil is NULL.
+  bool paintStroke(vtkImageStencilData* brushStencil, vtkPoints* paintCoordinates_World, int updateExtent[6]=NULL);
 
   /// Scale brush diameter and save it in parameter node
   void scaleDiameter(double scaleFactor);
@@ -0,0 +1,284 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageGrowCutSegment.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemInformation.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Returns peak memory usage of the process in MiB.
+/// On Windows the current memory usage is returned.
+double GetPeakMemoryUsageInMiB()
+{
+#ifdef _WIN32
+  vtksys::SystemInformation systemInformation;
+  return systemInformation.GetProcMemoryUsed() / 1024.0;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+# ifdef __APPLE__
+  return usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+# else
+  return usage.ru_maxrss / 1024.0; // KiB
+# endif
+#endif
+}
+
+//----------------------------------------------------------------------------
+/// Create intensity volume with a bright sphere in the center and seed volume
+/// with a foreground seed (label 1) in the sphere and a background seed (label 2) in the corner.
+void CreateVolumes(int size, vtkImageData* intensityVolume, vtkImageData* seedLabelVolume)
+{
+  intensityVolume->SetDimensions(size, size, size);
+  intensityVolume->AllocateScalars(VTK_SHORT, 1);
+  seedLabelVolume->SetDimensions(size, size, size);
+  seedLabelVolume->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  short* intensityPtr = static_cast<short*>(intensityVolume->GetScalarPointer());
+  unsigned char* seedPtr = static_cast<unsigned char*>(seedLabelVolume->GetScalarPointer());
+  int center = size / 2;
+  int radius = size / 4;
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i, ++intensityPtr, ++seedPtr)
+        {
+        int distanceSquared = (i - center) * (i - center) + (j - center) * (j - center) + (k - center) * (k - center);
+        *intensityPtr = (distanceSquared <= radius * radius ? 100 : 0);
+        *seedPtr = 0;
+        if (abs(i - center) <= 1 && abs(j - center) <= 1 && abs(k - center) <= 1)
+          {
+          *seedPtr = 1;
+          }
+        else if (i >= 2 && i <= 4 && j >= 2 && j <= 4 && k >= 2 && k <= 4)
+          {
+          *seedPtr = 2;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned char GetLabel(vtkImageData* image, int i, int j, int k)
+{
+  return *static_cast<unsigned char*>(image->GetScalarPointer(i, j, k));
+}
+
+//----------------------------------------------------------------------------
+void SetSeed(vtkImageData* seedLabelVolume, int i, int j, int k, unsigned char label)
+{
+  *static_cast<unsigned char*>(seedLabelVolume->GetScalarPointer(i, j, k)) = label;
+  seedLabelVolume->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool AreLabelsEqual(vtkImageData* image1, vtkImageData* image2)
+{
+  vtkIdType numberOfVoxels = image1->GetNumberOfPoints();
+  if (image2->GetNumberOfPoints() != numberOfVoxels)
+    {
+    return false;
+    }
+  unsigned char* ptr1 = static_cast<unsigned char*>(image1->GetScalarPointer());
+  unsigned char* ptr2 = static_cast<unsigned char*>(image2->GetScalarPointer());
+  return std::equal(ptr1, ptr1 + numberOfVoxels, ptr2);
+}
+
+//----------------------------------------------------------------------------
+bool TestSegmentation()
+{
+  const int size = 40;
+  vtkNew<vtkImageData> intensityVolume;
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateVolumes(size, intensityVolume.GetPointer(), seedLabelVolume.GetPointer());
+
+  vtkNew<vtkImageGrowCutSegment> growCut;
+  growCut->SetIntensityVolume(intensityVolume.GetPointer());
+  growCut->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  growCut->Update();
+  vtkImageData* result = growCut->GetOutput();
+
+  // All voxels that are not on the image boundary are expected to be labeled by the region they are in
+  int center = size / 2;
+  int radius = size / 4;
+  for (int k = 1; k < size - 1; ++k)
+    {
+    for (int j = 1; j < size - 1; ++j)
+      {
+      for (int i = 1; i < size - 1; ++i)
+        {
+        int distanceSquared = (i - center) * (i - center) + (j - center) * (j - center) + (k - center) * (k - center);
+        unsigned char expectedLabel = (distanceSquared <= radius * radius ? 1 : 2);
+        if (GetLabel(result, i, j, k) != expectedLabel)
+          {
+          std::cerr << "Label mismatch at (" << i << ", " << j << ", " << k << "): expected "
+            << int(expectedLabel) << ", got " << int(GetLabel(result, i, j, k)) << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+
+  vtkNew<vtkImageData> initialResult;
+  initialResult->DeepCopy(result);
+
+  // Add new seed and update without reset
+  SetSeed(seedLabelVolume.GetPointer(), size - 4, size - 4, size - 4, 3);
+  growCut->Update();
+  result = growCut->GetOutput();
+  if (GetLabel(result, size - 4, size - 4, size - 4) != 3
+    || GetLabel(result, center, center, center) != 1
+    || GetLabel(result, center + radius - 1, center, center) != 1)
+    {
+    std::cerr << "Incorrect result after adding a seed" << std::endl;
+    return false;
+    }
+
+  // Removing the seed restores the initial result
+  SetSeed(seedLabelVolume.GetPointer(), size - 4, size - 4, size - 4, 0);
+  growCut->Update();
+  if (!AreLabelsEqual(growCut->GetOutput(), initialResult.GetPointer()))
+    {
+    std::cerr << "Incorrect result after removing a seed" << std::endl;
+    return false;
+    }
+
+  // Moving the background seed invalidates and recomputes the entire background
+  for (int k = 2; k <= 4; ++k)
+    {
+    for (int j = 2; j <= 4; ++j)
+      {
+      for (int i = 2; i <= 4; ++i)
+        {
+        SetSeed(seedLabelVolume.GetPointer(), i, j, k, 0);
+        }
+      }
+    }
+  SetSeed(seedLabelVolume.GetPointer(), size - 3, 2, size - 3, 2);
+  growCut->Update();
+  if (!AreLabelsEqual(growCut->GetOutput(), initialResult.GetPointer()))
+    {
+    std::cerr << "Incorrect result after moving a seed" << std::endl;
+    return false;
+    }
+
+  // Removing the foreground seed makes the background grow into the sphere
+  for (int k = center - 1; k <= center + 1; ++k)
+    {
+    for (int j = center - 1; j <= center + 1; ++j)
+      {
+      for (int i = center - 1; i <= center + 1; ++i)
+        {
+        SetSeed(seedLabelVolume.GetPointer(), i, j, k, 0);
+        }
+      }
+    }
+  growCut->Update();
+  vtkNew<vtkImageGrowCutSegment> fullGrowCut;
+  fullGrowCut->SetIntensityVolume(intensityVolume.GetPointer());
+  fullGrowCut->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  fullGrowCut->Update();
+  if (GetLabel(growCut->GetOutput(), center, center, center) != 2
+    || !AreLabelsEqual(growCut->GetOutput(), fullGrowCut->GetOutput()))
+    {
+    std::cerr << "Incremental result after removing a seed is different from full computation" << std::endl;
+    return false;
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool RunBenchmark(int size)
+{
+  vtkNew<vtkImageData> intensityVolume;
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateVolumes(size, intensityVolume.GetPointer(), seedLabelVolume.GetPointer());
+
+  vtkNew<vtkImageGrowCutSegment> growCut;
+  growCut->SetIntensityVolume(intensityVolume.GetPointer());
+  growCut->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  growCut->Update();
+  timer->StopTimer();
+  double initialTime = timer->GetElapsedTime();
+  if (GetLabel(growCut->GetOutput(), size / 2, size / 2, size / 2) != 1)
+    {
+    std::cerr << "Segmentation of " << size << "^3 volume failed" << std::endl;
+    return false;
+    }
+
+  // Update after adding a seed
+  SetSeed(seedLabelVolume.GetPointer(), size / 2 + size / 8, size / 2, size / 2, 3);
+  timer->StartTimer();
+  growCut->Update();
+  timer->StopTimer();
+  double updateTime = timer->GetElapsedTime();
+
+  std::cout << "<DartMeasurement name=\"vtkImageGrowCutSegment-InitialTime-" << size
+            << "\" type=\"numeric/double\">" << initialTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkImageGrowCutSegment-UpdateTime-" << size
+            << "\" type=\"numeric/double\">" << updateTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkImageGrowCutSegment-PeakMemoryMiB-" << size
+            << "\" type=\"numeric/double\">" << GetPeakMemoryUsageInMiB() << "</DartMeasurement>" << std::endl;
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageGrowCutSegmentTest1(int argc, char* argv[])
+{
+  if (!TestSegmentation())
+    {
+    std::cerr << __LINE__ << ": Grow cut segmentation result is incorrect" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark volume sizes are specified in the arguments
+  for (int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+    if (!RunBenchmark(atoi(argv[argIndex])))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Grow cut segmentation test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
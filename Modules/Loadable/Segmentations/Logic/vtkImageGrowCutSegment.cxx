@@ -1,6 +1,9 @@
 #include "vtkImageGrowCutSegment.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #include <vtkInformation.h>
@@ -12,8 +15,6 @@
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
 
-#include "FibHeap.h"
-
 vtkStandardNewMacro(vtkImageGrowCutSegment);
 
 //----------------------------------------------------------------------------
@@ -23,56 +24,45 @@ const DistancePixelType DIST_INF = std::numeric_limits<DistancePixelType>::max()
 const DistancePixelType DIST_EPSILON = 1e-3;
 
 //----------------------------------------------------------------------------
-class HeapNode : public FibHeapNode
+// Array-backed priority queue of voxels, ordered by distance.
+// Instead of decreasing the key of a queued voxel, the voxel is inserted again with
+// the smaller distance and the outdated entry is skipped when it is extracted
+// (its distance is larger than the current distance of the voxel).
+// Only voxels that are reached by the propagation are stored, therefore memory usage
+// is proportional to the size of the propagation front and not to the image size.
+class DistanceQueue
 {
 public:
-  HeapNode()
-  : FibHeapNode()
-  , m_Key(0)
-  , m_Index(-1)
+  struct Entry
   {
-  }
+    DistancePixelType Distance;
+    long Index;
+  };
 
-  virtual void operator =(FibHeapNode& RHS)
+  void Push(DistancePixelType distance, long index)
   {
-    FHN_Assign(RHS);
-    m_Key = ((HeapNode&)RHS).m_Key;
-  }
-
-  virtual int operator ==(FibHeapNode& RHS)
-  {
-    if (FHN_Cmp(RHS))
-      {
-      return 0;
-      }
-    return m_Key == ((HeapNode&)RHS).m_Key ? 1 : 0;
+    Entry entry = { distance, index };
+    m_Entries.push_back(entry);
+    std::push_heap(m_Entries.begin(), m_Entries.end(), IsFartherThan);
   }
 
-  virtual int operator <(FibHeapNode& RHS)
+  Entry Pop()
   {
-    int x = FHN_Cmp(RHS);
-    if (x != 0)
-      {
-      return x < 0 ? 1 : 0;
-      }
-    return m_Key < ((HeapNode&)RHS).m_Key ? 1 : 0;
+    std::pop_heap(m_Entries.begin(), m_Entries.end(), IsFartherThan);
+    Entry entry = m_Entries.back();
+    m_Entries.pop_back();
+    return entry;
   }
 
-  virtual void operator =(DistancePixelType newKeyVal)
-  {
-    HeapNode tmp;
-    tmp.m_Key = m_Key = newKeyVal;
-    FHN_Assign(tmp);
-  }
+  bool IsEmpty() const { return m_Entries.empty(); }
 
-  inline DistancePixelType GetKeyValue() { return m_Key; }
-  inline void SetKeyValue(DistancePixelType keyValue) { m_Key = keyValue; }
-  inline long int GetIndexValue() { return m_Index; }
-  inline void SetIndexValue(long int indexValue) { m_Index = indexValue; }
+  // Remove all entries and release memory
+  void Clear() { std::vector<Entry>().swap(m_Entries); }
 
 protected:
-  DistancePixelType m_Key;
-  long m_Index;
+  static bool IsFartherThan(const Entry& entry1, const Entry& entry2) { return entry1.Distance > entry2.Distance; }
+
+  std::vector<Entry> m_Entries;
 };
 
 //----------------------------------------------------------------------------
@@ -96,10 +86,14 @@ public:
   template< class SourceVolType, class SeedVolType>
   bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume);
 
+  // Get indices of all neighbors of a voxel. Unlike m_NeighborIndexOffsets,
+  // this works for voxels at the boundary of the volume, too.
+  void GetNeighborIndices(long index, std::vector<long>& neighborIndices);
+
   vtkSmartPointer<vtkImageData> m_DistanceVolume;
-  vtkSmartPointer<vtkImageData> m_DistanceVolumePre;
   vtkSmartPointer<vtkImageData> m_ResultLabelVolume;
-  vtkSmartPointer<vtkImageData> m_ResultLabelVolumePre;
+  // Seeds used in the last computation, for detecting seed changes
+  vtkSmartPointer<vtkImageData> m_SeedLabelVolumePre;
 
   long m_DimX;
   long m_DimY;
@@ -107,21 +101,17 @@ public:
   std::vector<long> m_NeighborIndexOffsets;
   std::vector<unsigned char> m_NumberOfNeighbors;
 
-  FibHeap *m_Heap;
-  HeapNode *m_HeapNodes;
+  DistanceQueue m_Queue;
   bool m_bSegInitialized;
 };
 
 //-----------------------------------------------------------------------------
 vtkImageGrowCutSegment::vtkInternal::vtkInternal()
 {
-  m_Heap = NULL;
-  m_HeapNodes = NULL;
   m_bSegInitialized = false;
   m_DistanceVolume = vtkSmartPointer<vtkImageData>::New();
-  m_DistanceVolumePre = vtkSmartPointer<vtkImageData>::New();
   m_ResultLabelVolume = vtkSmartPointer<vtkImageData>::New();
-  m_ResultLabelVolumePre = vtkSmartPointer<vtkImageData>::New();
+  m_SeedLabelVolumePre = vtkSmartPointer<vtkImageData>::New();
 };
 
 //-----------------------------------------------------------------------------
@@ -133,36 +123,52 @@ vtkImageGrowCutSegment::vtkInternal::~vtkInternal()
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::vtkInternal::Reset()
 {
-  if (m_Heap != NULL)
+  m_Queue.Clear();
+  m_bSegInitialized = false;
+  m_DistanceVolume->Initialize();
+  m_ResultLabelVolume->Initialize();
+  m_SeedLabelVolumePre->Initialize();
+}
+
+//-----------------------------------------------------------------------------
+void vtkImageGrowCutSegment::vtkInternal::GetNeighborIndices(long index, std::vector<long>& neighborIndices)
+{
+  neighborIndices.clear();
+  unsigned char nbSize = m_NumberOfNeighbors[index];
+  if (nbSize > 0)
     {
-    delete m_Heap;
-    m_Heap = NULL;
+    for (unsigned char i = 0; i < nbSize; i++)
+      {
+      neighborIndices.push_back(index + m_NeighborIndexOffsets[i]);
+      }
+    return;
     }
-  if (m_HeapNodes != NULL)
+  long x = index % m_DimX;
+  long y = (index / m_DimX) % m_DimY;
+  long z = index / (m_DimX * m_DimY);
+  for (long iz = std::max(z - 1, 0L); iz <= std::min(z + 1, m_DimZ - 1); iz++)
     {
-    delete[]m_HeapNodes;
-    m_HeapNodes = NULL;
+    for (long iy = std::max(y - 1, 0L); iy <= std::min(y + 1, m_DimY - 1); iy++)
+      {
+      for (long ix = std::max(x - 1, 0L); ix <= std::min(x + 1, m_DimX - 1); ix++)
+        {
+        if (ix != x || iy != y || iz != z)
+          {
+          neighborIndices.push_back(ix + m_DimX * (iy + m_DimY * iz));
+          }
+        }
+      }
     }
-  m_bSegInitialized = false;
-  m_DistanceVolume->Initialize();
-  m_DistanceVolumePre->Initialize();
-  m_ResultLabelVolume->Initialize();
-  m_ResultLabelVolumePre->Initialize();
 }
 
 //-----------------------------------------------------------------------------
 template<typename IntensityPixelType, typename LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
-    vtkImageData *vtkNotUsed(intensityVolume),
+    vtkImageData *intensityVolume,
     vtkImageData *seedLabelVolume)
 {
-  m_Heap = new FibHeap;
+  m_Queue.Clear();
   long dimXYZ = m_DimX * m_DimY * m_DimZ;
-  if ((m_HeapNodes = new HeapNode[dimXYZ + 1]) == NULL)
-    {
-    vtkGenericWarningMacro("Memory allocation failed. Dimensions: " << m_DimX << "x" << m_DimY << "x" << m_DimZ);
-    return false;
-    }
   LabelPixelType* seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
 
   if (!m_bSegInitialized)
@@ -175,12 +181,16 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
     m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
     m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
     m_DistanceVolume->AllocateScalars(DistancePixelTypeID, 1);
-    m_ResultLabelVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
-    m_ResultLabelVolumePre->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
-    m_DistanceVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
-    m_DistanceVolumePre->AllocateScalars(DistancePixelTypeID, 1);
+    m_SeedLabelVolumePre->SetExtent(seedLabelVolume->GetExtent());
+    m_SeedLabelVolumePre->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
     LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
     DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
+    LabelPixelType* seedLabelVolumePrePtr = static_cast<LabelPixelType*>(m_SeedLabelVolumePre->GetScalarPointer());
+    if (!resultLabelVolumePtr || !distanceVolumePtr || !seedLabelVolumePrePtr)
+      {
+      vtkGenericWarningMacro("Memory allocation failed. Dimensions: " << m_DimX << "x" << m_DimY << "x" << m_DimZ);
+      return false;
+      }
 
     // Compute index offset
     m_NeighborIndexOffsets.clear();
@@ -227,54 +237,116 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
         }
       }
 
-    for (long index = 0; index < dimXYZ; index++)
+    // Start from a state without any seeds, all seeds will be detected as added seeds
+    std::fill(resultLabelVolumePtr, resultLabelVolumePtr + dimXYZ, LabelPixelType(0));
+    std::fill(distanceVolumePtr, distanceVolumePtr + dimXYZ, DIST_INF);
+    std::fill(seedLabelVolumePrePtr, seedLabelVolumePrePtr + dimXYZ, LabelPixelType(0));
+    }
+
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
+  LabelPixelType* seedLabelVolumePrePtr = static_cast<LabelPixelType*>(m_SeedLabelVolumePre->GetScalarPointer());
+  IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
+
+  // Find seeds that changed since the last computation.
+  // Rows are compared as memory blocks, so unchanged regions are skipped quickly.
+  std::vector<long> removedSeedIndices;
+  std::vector<long> addedSeedIndices;
+  for (long rowStartIndex = 0; rowStartIndex < dimXYZ; rowStartIndex += m_DimX)
+    {
+    if (memcmp(seedLabelVolumePtr + rowStartIndex, seedLabelVolumePrePtr + rowStartIndex, m_DimX * sizeof(LabelPixelType)) == 0)
+      {
+      continue;
+      }
+    for (long index = rowStartIndex; index < rowStartIndex + m_DimX; index++)
       {
-      LabelPixelType seedValue = seedLabelVolumePtr[index];
-      resultLabelVolumePtr[index] = seedValue;
-      if (seedValue == 0)
+      if (seedLabelVolumePtr[index] == seedLabelVolumePrePtr[index])
         {
-        m_HeapNodes[index] = DIST_INF;
-        distanceVolumePtr[index] = DIST_INF;
+        continue;
         }
-      else
+      if (seedLabelVolumePrePtr[index] != 0)
+        {
+        removedSeedIndices.push_back(index);
+        }
+      if (seedLabelVolumePtr[index] != 0)
         {
-        m_HeapNodes[index] = DIST_EPSILON;
-        distanceVolumePtr[index] = DIST_EPSILON;
+        addedSeedIndices.push_back(index);
         }
-      m_Heap->Insert(&m_HeapNodes[index]);
-      m_HeapNodes[index].SetIndexValue(index);
+      seedLabelVolumePrePtr[index] = seedLabelVolumePtr[index];
       }
     }
-  else
-    {
-    // Already initialized
-    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
-    DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
 
-    for (long index = 0; index < dimXYZ; index++)
+  // Invalidate voxels that got their label from removed seeds: the removed seeds and all voxels
+  // whose shortest path leads through them. A voxel is on the shortest path tree of its neighbor
+  // if its distance is exactly what propagation from that neighbor would set.
+  std::vector<long> invalidatedIndices;
+  std::vector<DistancePixelType> invalidatedDistances;
+  std::vector<LabelPixelType> invalidatedLabels;
+  for (std::vector<long>::iterator indexIt = removedSeedIndices.begin(); indexIt != removedSeedIndices.end(); ++indexIt)
+    {
+    invalidatedIndices.push_back(*indexIt);
+    invalidatedDistances.push_back(distanceVolumePtr[*indexIt]);
+    invalidatedLabels.push_back(resultLabelVolumePtr[*indexIt]);
+    distanceVolumePtr[*indexIt] = DIST_INF;
+    resultLabelVolumePtr[*indexIt] = 0;
+    }
+  for (size_t invalidatedIndex = 0; invalidatedIndex < invalidatedIndices.size(); invalidatedIndex++)
+    {
+    long index = invalidatedIndices[invalidatedIndex];
+    DistancePixelType currentDistance = invalidatedDistances[invalidatedIndex];
+    LabelPixelType currentLabel = invalidatedLabels[invalidatedIndex];
+    DistancePixelType pixCenter = imSrc[index];
+    unsigned char nbSize = m_NumberOfNeighbors[index];
+    for (unsigned char i = 0; i < nbSize; i++)
       {
-      if (seedLabelVolumePtr[index] != 0)
+      long indexNgbh = index + m_NeighborIndexOffsets[i];
+      if (seedLabelVolumePtr[indexNgbh] != 0 || resultLabelVolumePtr[indexNgbh] != currentLabel)
         {
-        // Only grow from new/changed seeds
-        if (resultLabelVolumePtr[index] != seedLabelVolumePtr[index])
-          {
-          m_HeapNodes[index] = DIST_EPSILON;
-          distanceVolumePtr[index] = DIST_EPSILON;
-          resultLabelVolumePtr[index] = seedLabelVolumePtr[index];
-          m_Heap->Insert(&m_HeapNodes[index]);
-          m_HeapNodes[index].SetIndexValue(index);
-          }
+        // current seeds are always valid
+        continue;
+        }
+      DistancePixelType neighborPropagatedDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
+      if (distanceVolumePtr[indexNgbh] != neighborPropagatedDistance)
+        {
+        continue;
         }
-      else
+      invalidatedIndices.push_back(indexNgbh);
+      invalidatedDistances.push_back(distanceVolumePtr[indexNgbh]);
+      invalidatedLabels.push_back(currentLabel);
+      distanceVolumePtr[indexNgbh] = DIST_INF;
+      resultLabelVolumePtr[indexNgbh] = 0;
+      }
+    }
+
+  // Invalidated region is filled by propagation from its valid neighbors
+  std::vector<long> boundaryIndices;
+  std::vector<long> neighborIndices;
+  for (std::vector<long>::iterator indexIt = invalidatedIndices.begin(); indexIt != invalidatedIndices.end(); ++indexIt)
+    {
+    this->GetNeighborIndices(*indexIt, neighborIndices);
+    for (std::vector<long>::iterator neighborIt = neighborIndices.begin(); neighborIt != neighborIndices.end(); ++neighborIt)
+      {
+      if (distanceVolumePtr[*neighborIt] != DIST_INF && m_NumberOfNeighbors[*neighborIt] > 0)
         {
-        m_HeapNodes[index] = DIST_INF;
-        distanceVolumePtr[index] = DIST_INF;
-        resultLabelVolumePtr[index] = 0;
-        m_Heap->Insert(&m_HeapNodes[index]);
-        m_HeapNodes[index].SetIndexValue(index);
+        boundaryIndices.push_back(*neighborIt);
         }
       }
     }
+  std::sort(boundaryIndices.begin(), boundaryIndices.end());
+  boundaryIndices.erase(std::unique(boundaryIndices.begin(), boundaryIndices.end()), boundaryIndices.end());
+  for (std::vector<long>::iterator indexIt = boundaryIndices.begin(); indexIt != boundaryIndices.end(); ++indexIt)
+    {
+    m_Queue.Push(distanceVolumePtr[*indexIt], *indexIt);
+    }
+
+  // Grow from new/changed seeds
+  for (std::vector<long>::iterator indexIt = addedSeedIndices.begin(); indexIt != addedSeedIndices.end(); ++indexIt)
+    {
+    distanceVolumePtr[*indexIt] = DIST_EPSILON;
+    resultLabelVolumePtr[*indexIt] = seedLabelVolumePtr[*indexIt];
+    m_Queue.Push(DIST_EPSILON, *indexIt);
+    }
+
   return true;
 }
 
@@ -285,130 +357,45 @@ void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(
     vtkImageData *vtkNotUsed(seedLabelVolume))
 {
   LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
   IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
 
-  // Insert 0 then extract it, which will balance heap
-  HeapNode hnZero;
-  m_Heap->Insert(&hnZero);
-  m_Heap->ExtractMin();
-
-  if (!m_bSegInitialized)
+  // Dijkstra propagation from the queued voxels. Distances of other voxels are already valid,
+  // therefore only voxels where the distance decreases are updated. After the initial computation
+  // this is limited to the neighborhood of the changed seeds.
+  while (!m_Queue.IsEmpty())
     {
-    // Full computation
-    DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
-    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
-
-    // Normal Dijkstra (to be used in initializing the segmenter for the current image)
-    HeapNode hnTmp;
-    while (!m_Heap->IsEmpty())
+    DistanceQueue::Entry entryMin = m_Queue.Pop();
+    long index = entryMin.Index;
+    DistancePixelType currentDistance = entryMin.Distance;
+    if (currentDistance > distanceVolumePtr[index])
       {
-      HeapNode* hnMin = (HeapNode *)m_Heap->ExtractMin();
-      long index = hnMin->GetIndexValue();
-      DistancePixelType currentDistance = hnMin->GetKeyValue();
-      LabelPixelType currentLabel = resultLabelVolumePtr[index];
-      distanceVolumePtr[index] = currentDistance;
-
-      // Update neighbors
-      DistancePixelType pixCenter = imSrc[index];
-      unsigned char nbSize = m_NumberOfNeighbors[index];
-      for (unsigned char i = 0; i < nbSize; i++)
-        {
-        long indexNgbh = index + m_NeighborIndexOffsets[i];
-        DistancePixelType neighborCurrentDistance = distanceVolumePtr[indexNgbh];
-        DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
-        if (neighborCurrentDistance > neighborNewDistance)
-          {
-          distanceVolumePtr[indexNgbh] = neighborNewDistance;
-          resultLabelVolumePtr[indexNgbh] = currentLabel;
-
-          hnTmp = m_HeapNodes[indexNgbh];
-          hnTmp.SetKeyValue(neighborNewDistance);
-          m_Heap->DecreaseKey(&m_HeapNodes[indexNgbh], hnTmp);
-          }
-        }
+      // Outdated entry, the voxel has been already reached with a smaller distance
+      continue;
       }
-    }
-  else
-    {
-    // Quick update
-
-    LabelPixelType* resultLabelVolumePrePtr = static_cast<LabelPixelType*>(m_ResultLabelVolumePre->GetScalarPointer());
+    LabelPixelType currentLabel = resultLabelVolumePtr[index];
 
-    // Adaptive Dijkstra
-    HeapNode hnTmp;
-    long dimXYZ = m_DimX * m_DimY * m_DimZ;
-    while (!m_Heap->IsEmpty())
+    // Update neighbors
+    DistancePixelType pixCenter = imSrc[index];
+    unsigned char nbSize = m_NumberOfNeighbors[index];
+    for (unsigned char i = 0; i < nbSize; i++)
       {
-      DistancePixelType* distanceVolumePrePtr = static_cast<DistancePixelType*>(m_DistanceVolumePre->GetScalarPointer());
-      DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
-
-      HeapNode* hnMin = (HeapNode *)m_Heap->ExtractMin();
-      DistancePixelType currentDistance = hnMin->GetKeyValue();
-
-      // Stop of minimum value is infinite
-      if (currentDistance == DIST_INF)
+      long indexNgbh = index + m_NeighborIndexOffsets[i];
+      DistancePixelType neighborCurrentDistance = distanceVolumePtr[indexNgbh];
+      DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
+      if (neighborCurrentDistance > neighborNewDistance)
         {
-        for (long index = 0; index < dimXYZ; index++)
-          {
-          if (resultLabelVolumePtr[index] == 0)
-            {
-            resultLabelVolumePtr[index] = resultLabelVolumePrePtr[index];
-            distanceVolumePtr[index] = distanceVolumePrePtr[index];
-            }
-          }
-        break;
-        }
-
-      // Stop propagation when the new distance is larger than the previous one
-      long index = hnMin->GetIndexValue();
-      if (currentDistance > distanceVolumePrePtr[index])
-        {
-        distanceVolumePtr[index] = distanceVolumePrePtr[index];
-        resultLabelVolumePtr[index] = resultLabelVolumePrePtr[index];
-        continue;
-        }
-
-      LabelPixelType currentLabel = resultLabelVolumePtr[index];
-      distanceVolumePtr[index] = currentDistance;
-
-      // Update neighbors
-      DistancePixelType pixCenter = imSrc[index];
-      unsigned char nbSize = m_NumberOfNeighbors[index];
-      for (unsigned char i = 0; i < nbSize; i++)
-        {
-        long indexNgbh = index + m_NeighborIndexOffsets[i];
-        DistancePixelType neighborCurrentDistance = distanceVolumePtr[indexNgbh];
-        DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
-        if (neighborCurrentDistance > neighborNewDistance)
-          {
-          distanceVolumePtr[indexNgbh] = neighborNewDistance;
-          resultLabelVolumePtr[indexNgbh] = currentLabel;
-
-          hnTmp = m_HeapNodes[indexNgbh];
-          hnTmp.SetKeyValue(neighborNewDistance);
-          m_Heap->DecreaseKey(&m_HeapNodes[indexNgbh], hnTmp);
-          }
+        distanceVolumePtr[indexNgbh] = neighborNewDistance;
+        resultLabelVolumePtr[indexNgbh] = currentLabel;
+        m_Queue.Push(neighborNewDistance, indexNgbh);
         }
       }
     }
 
-  // Update previous labels and distance information
-  m_ResultLabelVolumePre->DeepCopy(m_ResultLabelVolume);
-  m_DistanceVolumePre->DeepCopy(m_DistanceVolume);
   m_bSegInitialized = true;
 
   // Release memory
-  if (m_Heap != NULL)
-    {
-    delete m_Heap;
-    m_Heap = NULL;
-    }
-  //m_HeapNodes.clear();
-  if (m_HeapNodes != NULL)
-    {
-    delete[] m_HeapNodes;
-    m_HeapNodes = NULL;
-    }
+  m_Queue.Clear();
 }
 
 //-----------------------------------------------------------------------------
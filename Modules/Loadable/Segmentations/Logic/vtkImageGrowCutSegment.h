@@ -20,7 +20,10 @@ public:
   void SetSeedLabelVolume(vtkImageData* labelImage) { this->SetInputData(1, labelImage); }
 
   // Reset to initial state. This forces full recomputation of the result label volume.
-  // This method has to be called if intensity volume changes or if seeds are deleted after initial computation.
+  // This method has to be called if intensity volume changes after initial computation.
+  // Seed changes are processed incrementally: after adding or removing seeds, only the voxels
+  // whose label may change (reachable from the new seeds or previously labeled from removed seeds)
+  // are recomputed.
   void Reset();
 
 protected:
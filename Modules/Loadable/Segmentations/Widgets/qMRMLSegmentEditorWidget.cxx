@@ -580,9 +580,8 @@ bool qMRMLSegmentEditorWidgetPrivate::updateSelectedSegmentLabelmap()
     qWarning() << Q_FUNC_INFO << " failed: Segment " << selectedSegmentID << " not found in segmentation";
     return false;
     }
-  vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
-    selectedSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
-  if (!segmentLabelmap)
+  vtkNew<vtkOrientedImageData> segmentLabelmap;
+  if (!segmentationNode->GetSegmentation()->GetSegmentBinaryLabelmap(selectedSegmentID, segmentLabelmap.GetPointer()))
     {
     qCritical() << Q_FUNC_INFO << ": Failed to get binary labelmap representation in segmentation " << segmentationNode->GetName();
     return false;
@@ -597,7 +596,7 @@ bool qMRMLSegmentEditorWidgetPrivate::updateSelectedSegmentLabelmap()
     }
   vtkNew<vtkOrientedImageData> referenceImage;
   vtkSegmentationConverter::DeserializeImageGeometry(referenceImageGeometry, referenceImage.GetPointer(), false);
-  vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(segmentLabelmap, referenceImage.GetPointer(), this->SelectedSegmentLabelmap, /*linearInterpolation=*/false);
+  vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(segmentLabelmap.GetPointer(), referenceImage.GetPointer(), this->SelectedSegmentLabelmap, /*linearInterpolation=*/false);
 
   return true;
 }
@@ -2885,6 +2884,20 @@ void qMRMLSegmentEditorWidget::setMaximumNumberOfUndoStates(int maxNumberOfState
   d->SegmentationHistory->SetMaximumNumberOfStates(maxNumberOfStates);
 }
 
+//-----------------------------------------------------------------------------
+double qMRMLSegmentEditorWidget::maximumUndoMemorySizeInMiB() const
+{
+  Q_D(const qMRMLSegmentEditorWidget);
+  return d->SegmentationHistory->GetMaximumMemorySizeInMiB();
+}
+
+//-----------------------------------------------------------------------------
+void qMRMLSegmentEditorWidget::setMaximumUndoMemorySizeInMiB(double maxMemorySizeInMiB)
+{
+  Q_D(qMRMLSegmentEditorWidget);
+  d->SegmentationHistory->SetMaximumMemorySizeInMiB(maxMemorySizeInMiB);
+}
+
 //------------------------------------------------------------------------------
 bool qMRMLSegmentEditorWidget::readOnly() const
 {
@@ -71,6 +71,7 @@ class Q_SLICER_MODULE_SEGMENTATIONS_WIDGETS_EXPORT qMRMLSegmentEditorWidget : pu
   Q_PROPERTY(bool switchToSegmentationsButtonVisible READ switchToSegmentationsButtonVisible WRITE setSwitchToSegmentationsButtonVisible)
   Q_PROPERTY(bool undoEnabled READ undoEnabled WRITE setUndoEnabled)
   Q_PROPERTY(int maximumNumberOfUndoStates READ maximumNumberOfUndoStates WRITE setMaximumNumberOfUndoStates)
+  Q_PROPERTY(double maximumUndoMemorySizeInMiB READ maximumUndoMemorySizeInMiB WRITE setMaximumUndoMemorySizeInMiB)
   Q_PROPERTY(bool readOnly READ readOnly WRITE setReadOnly)
   Q_PROPERTY(Qt::ToolButtonStyle effectButtonStyle READ effectButtonStyle WRITE setEffectButtonStyle)
   Q_PROPERTY(bool unorderedEffectsVisible READ unorderedEffectsVisible WRITE setUnorderedEffectsVisible)
@@ -162,6 +163,8 @@ public:
   bool undoEnabled() const;
   /// Get maximum number of saved undo/redo states.
   int maximumNumberOfUndoStates() const;
+  /// Get maximum memory size of saved undo/redo states, in MiB.
+  double maximumUndoMemorySizeInMiB() const;
   /// Get whether widget is read-only
   bool readOnly() const;
 
@@ -234,7 +237,10 @@ public slots:
   /// Undo/redo enabled.
   void setUndoEnabled(bool);
   /// Set maximum number of saved undo/redo states.
+  /// Oldest states are also removed if the states exceed maximumUndoMemorySizeInMiB.
   void setMaximumNumberOfUndoStates(int);
+  /// Set maximum memory size of saved undo/redo states, in MiB. 0 means no limit.
+  void setMaximumUndoMemorySizeInMiB(double);
   /// Set whether the widget is read-only
   void setReadOnly(bool aReadOnly);
   /// Enable/disable masking using master volume intensity
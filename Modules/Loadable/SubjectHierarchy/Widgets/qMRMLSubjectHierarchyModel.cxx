@@ -254,6 +254,8 @@ void qMRMLSubjectHierarchyModel::setSubjectHierarchyNode(vtkMRMLSubjectHierarchy
     shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemAboutToBeRemovedEvent, d->CallBack, +10.0);
     shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, d->CallBack, -10.0);
     shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent, d->CallBack, -10.0);
+    shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyStartItemBatchModifyEvent, d->CallBack);
+    shNode->AddObserver(vtkMRMLSubjectHierarchyNode::SubjectHierarchyEndItemBatchModifyEvent, d->CallBack, -10.0);
     }
 }
 
@@ -1136,7 +1138,8 @@ void qMRMLSubjectHierarchyModel::updateSubjectHierarchyItemFromItemData(vtkIdTyp
 void qMRMLSubjectHierarchyModel::updateModelItems(vtkIdType itemID)
 {
   Q_D(qMRMLSubjectHierarchyModel);
-  if (d->MRMLScene->IsClosing() || d->MRMLScene->IsBatchProcessing())
+  if ( d->MRMLScene->IsClosing() || d->MRMLScene->IsBatchProcessing()
+    || (d->SubjectHierarchyNode && d->SubjectHierarchyNode->IsItemBatchModifyInProgress()) )
     {
     return;
     }
@@ -1220,6 +1223,12 @@ void qMRMLSubjectHierarchyModel::onEvent(
     case vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemModifiedEvent:
       sceneModel->onSubjectHierarchyItemModified(itemID);
       break;
+    case vtkMRMLSubjectHierarchyNode::SubjectHierarchyStartItemBatchModifyEvent:
+      sceneModel->onSubjectHierarchyStartItemBatchModify();
+      break;
+    case vtkMRMLSubjectHierarchyNode::SubjectHierarchyEndItemBatchModifyEvent:
+      sceneModel->onSubjectHierarchyEndItemBatchModify();
+      break;
     case vtkMRMLScene::EndImportEvent:
       sceneModel->onMRMLSceneImported(scene);
       break;
@@ -1241,6 +1250,12 @@ void qMRMLSubjectHierarchyModel::onEvent(
 //------------------------------------------------------------------------------
 void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemAdded(vtkIdType itemID)
 {
+  Q_D(qMRMLSubjectHierarchyModel);
+  if (d->SubjectHierarchyNode && d->SubjectHierarchyNode->IsItemBatchModifyInProgress())
+    {
+    // Model is updated at the end of the batch
+    return;
+    }
   this->insertSubjectHierarchyItem(itemID);
 }
 
@@ -1248,7 +1263,8 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemAdded(vtkIdType itemID)
 void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemAboutToBeRemoved(vtkIdType itemID)
 {
   Q_D(qMRMLSubjectHierarchyModel);
-  if (d->MRMLScene->IsClosing() || d->MRMLScene->IsBatchProcessing())
+  if ( d->MRMLScene->IsClosing() || d->MRMLScene->IsBatchProcessing()
+    || (d->SubjectHierarchyNode && d->SubjectHierarchyNode->IsItemBatchModifyInProgress()) )
     {
     return;
     }
@@ -1281,7 +1297,8 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemRemoved(vtkIdType removed
 {
   Q_D(qMRMLSubjectHierarchyModel);
   Q_UNUSED(removedItemID);
-  if (d->MRMLScene->IsClosing() || d->MRMLScene->IsBatchProcessing())
+  if ( d->MRMLScene->IsClosing() || d->MRMLScene->IsBatchProcessing()
+    || (d->SubjectHierarchyNode && d->SubjectHierarchyNode->IsItemBatchModifyInProgress()) )
     {
     return;
     }
@@ -1315,6 +1332,19 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemModified(vtkIdType itemID
   this->updateModelItems(itemID);
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSubjectHierarchyModel::onSubjectHierarchyStartItemBatchModify()
+{
+  emit subjectHierarchyAboutToBeUpdated();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSubjectHierarchyModel::onSubjectHierarchyEndItemBatchModify()
+{
+  // Update all items at once instead of processing the individual item events
+  this->updateFromSubjectHierarchy();
+}
+
 //------------------------------------------------------------------------------
 void qMRMLSubjectHierarchyModel::onMRMLSceneImported(vtkMRMLScene* scene)
 {
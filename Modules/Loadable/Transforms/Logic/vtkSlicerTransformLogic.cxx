@@ -598,6 +598,7 @@ vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTra
   {
     // we cannot reuse the existing transform, create a new one
     vtkNew<vtkOrientedGridTransform> newOutputGridTransform;
+    newOutputGridTransform->CacheInverseGridOn();
     outputGridTransform = newOutputGridTransform.GetPointer();
     outputGridTransformNode->SetAndObserveTransformFromParent(outputGridTransform);
   }
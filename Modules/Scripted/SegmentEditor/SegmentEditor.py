@@ -55,7 +55,9 @@ class SegmentEditorWidget(ScriptedLoadableModuleWidget, VTKObservationMixin):
     #
     import qSlicerSegmentationsModuleWidgetsPythonQt
     self.editor = qSlicerSegmentationsModuleWidgetsPythonQt.qMRMLSegmentEditorWidget()
-    self.editor.setMaximumNumberOfUndoStates(10)
+    # Number of undo states is also limited by the memory budget of the undo history
+    # (maximumUndoMemorySizeInMiB, which defaults to 512 MiB or 1/16 of the physical memory)
+    self.editor.setMaximumNumberOfUndoStates(100)
     # Set parameter node first so that the automatic selections made when the scene is set are saved
     self.selectParameterNode()
     self.editor.setMRMLScene(slicer.mrmlScene)